@@ -18,11 +18,18 @@
 #define SENSOR_IRQ  39
 #endif
 
+// Samples collected per watermark interrupt
+#define FIFO_WATERMARK  32
+
 SensorQMI8658 qmi;
 
 IMUdata acc;
 IMUdata gyr;
 
+IMUdata fifo_acc[FIFO_WATERMARK * 2];
+IMUdata fifo_gyr[FIFO_WATERMARK * 2];
+volatile bool fifo_ready = false;
+
 UBYTE *BlackImage;
 
 void setup() {
@@ -58,6 +65,11 @@ void setup() {
     DEV_Delay_ms(2000);
 	
 }
+void fifo_isr()
+{
+    fifo_ready = true;
+}
+
 void qmi8658a()
 {
     Serial.begin(115200);
@@ -113,7 +125,7 @@ void qmi8658a()
          * ACC_ODR_LOWPOWER_11Hz
          * ACC_ODR_LOWPOWER_3H
         * */
-        SensorQMI8658::ACC_ODR_1000Hz,
+        SensorQMI8658::ACC_ODR_62_5Hz,
         /*
         *  LPF_MODE_0     //2.66% of ODR
         *  LPF_MODE_1     //3.63% of ODR
@@ -148,7 +160,7 @@ void qmi8658a()
          * GYR_ODR_56_05Hz
          * GYR_ODR_28_025H
          * */
-        SensorQMI8658::GYR_ODR_896_8Hz,
+        SensorQMI8658::GYR_ODR_56_05Hz,
         /*
         *  LPF_MODE_0     //2.66% of ODR
         *  LPF_MODE_1     //3.63% of ODR
@@ -161,8 +173,8 @@ void qmi8658a()
     /*
     * If both the accelerometer and gyroscope sensors are turned on at the same time,
     * the output frequency will be based on the gyroscope output frequency.
-    * The example configuration is 896.8HZ output frequency,
-    * so the acceleration output frequency is also limited to 896.8HZ
+    * The example configuration is 56.05HZ output frequency,
+    * so the acceleration output frequency is also limited to 56.05HZ
     * */
     qmi.enableGyroscope();
     qmi.enableAccelerometer();
@@ -172,11 +184,19 @@ void qmi8658a()
 
 
 
-#if IMU_INT > 0
-    // If you want to enable interrupts, then turn on the interrupt enable
+    /*
+    * Samples are collected in the FIFO and read out in one burst when the
+    * watermark is reached, instead of polling the data registers per sample.
+    * */
+    qmi.configFIFO(SensorQMI8658::FIFO_MODE_STREAM,
+                   SensorQMI8658::FIFO_SAMPLES_64,
+                   SensorQMI8658::INTERRUPT_PIN_1,
+                   FIFO_WATERMARK);
     qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_1, true);
     qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_2, false);
-#endif
+
+    pinMode(SENSOR_IRQ, INPUT);
+    attachInterrupt(SENSOR_IRQ, fifo_isr, RISING);
 
     Serial.println("Read data now...");
 
@@ -204,26 +224,48 @@ void qmi8658_data_show()
     Paint_DrawString_EN(0, 150, buff, &Font20, WHITE, BLACK);
 
     EPD_3IN97_Display_Partial(BlackImage, 60, 300, 60 + Font20.Height*9 , 300+ Font20.Width * 7);
-    DEV_Delay_ms(1000);
 }
 
 void loop() {
-    if (qmi.getDataReady()) {
+    static uint32_t last_show = 0;
 
-        if (qmi.getAccelerometer(acc.x, acc.y, acc.z)) {
-            // Print to serial plotter
-            Serial.print("ACCEL.x:"); Serial.print(acc.x); Serial.print(",");
-            Serial.print("ACCEL.y:"); Serial.print(acc.y); Serial.print(",");
-            Serial.print("ACCEL.z:"); Serial.print(acc.z); Serial.println();
-        }
-        if (qmi.getGyroscope(gyr.x, gyr.y, gyr.z)) {
-            // Print to serial plotter
-            Serial.print(" GYRO.x:"); Serial.print(gyr.x); Serial.print(",");
-            Serial.print(" GYRO.y:"); Serial.print(gyr.y); Serial.print(",");
-            Serial.print(" GYRO.z:"); Serial.print(gyr.z); Serial.println();
+    if (!fifo_ready) {
+        delay(10);
+        return;
+    }
+    fifo_ready = false;
 
-        }
+    uint16_t samples_num = qmi.readFromFifo(fifo_acc, FIFO_WATERMARK * 2, fifo_gyr, FIFO_WATERMARK * 2);
+    if (samples_num == 0) {
+        return;
+    }
+    uint16_t count = samples_num;
+    if (count > FIFO_WATERMARK * 2) {
+        count = FIFO_WATERMARK * 2;
+    }
+
+    // Average the batch
+    acc.x = acc.y = acc.z = 0;
+    gyr.x = gyr.y = gyr.z = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        acc.x += fifo_acc[i].x; acc.y += fifo_acc[i].y; acc.z += fifo_acc[i].z;
+        gyr.x += fifo_gyr[i].x; gyr.y += fifo_gyr[i].y; gyr.z += fifo_gyr[i].z;
+    }
+    acc.x /= count; acc.y /= count; acc.z /= count;
+    gyr.x /= count; gyr.y /= count; gyr.z /= count;
+
+    // Print to serial plotter
+    Serial.print("SAMPLES:"); Serial.print(count); Serial.print(",");
+    Serial.print("ACCEL.x:"); Serial.print(acc.x); Serial.print(",");
+    Serial.print("ACCEL.y:"); Serial.print(acc.y); Serial.print(",");
+    Serial.print("ACCEL.z:"); Serial.print(acc.z); Serial.println();
+    Serial.print(" GYRO.x:"); Serial.print(gyr.x); Serial.print(",");
+    Serial.print(" GYRO.y:"); Serial.print(gyr.y); Serial.print(",");
+    Serial.print(" GYRO.z:"); Serial.print(gyr.z); Serial.println();
+
+    // The e-paper is only refreshed once a second
+    if (millis() - last_show >= 1000) {
+        last_show = millis();
         qmi8658_data_show();
     }
-    delay(1000);
-}
\ No newline at end of file
+}
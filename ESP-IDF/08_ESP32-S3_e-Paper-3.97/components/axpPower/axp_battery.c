@@ -0,0 +1,80 @@
+#include "axp_battery.h"
+#include <stdlib.h>
+
+// Resting (open-circuit) voltage of a single LiPo cell against state of charge
+static const struct {
+    int16_t mv;
+    uint8_t percent;
+} discharge_curve[] = {
+    {4180, 100}, {4110, 95}, {4060, 90}, {4020, 85}, {3980, 80},
+    {3950, 75},  {3910, 70}, {3880, 65}, {3850, 60}, {3830, 55},
+    {3810, 50},  {3795, 45}, {3780, 40}, {3770, 35}, {3755, 30},
+    {3740, 25},  {3720, 20}, {3695, 15}, {3670, 10}, {3620, 5},
+    {3450, 0},
+};
+#define CURVE_POINTS (sizeof(discharge_curve) / sizeof(discharge_curve[0]))
+
+void axp_battery_est_init(axp_battery_est_t *est, uint8_t seed_percent)
+{
+    est->ema_mv_x16 = 0;
+    est->percent = (seed_percent <= 100) ? seed_percent : AXP_BAT_PERCENT_UNKNOWN;
+}
+
+uint8_t axp_battery_ocv_to_percent(int ocv_mv)
+{
+    if (ocv_mv >= discharge_curve[0].mv) return 100;
+    for (unsigned i = 1; i < CURVE_POINTS; i++) {
+        if (ocv_mv >= discharge_curve[i].mv) {
+            // Linear interpolation between the two surrounding points
+            int mv_hi = discharge_curve[i - 1].mv, mv_lo = discharge_curve[i].mv;
+            int p_hi = discharge_curve[i - 1].percent, p_lo = discharge_curve[i].percent;
+            return (uint8_t)(p_lo + ((ocv_mv - mv_lo) * (p_hi - p_lo) + (mv_hi - mv_lo) / 2) / (mv_hi - mv_lo));
+        }
+    }
+    return 0;
+}
+
+uint16_t axp_battery_est_mv(const axp_battery_est_t *est)
+{
+    return (uint16_t)((est->ema_mv_x16 + 8) >> 4);
+}
+
+uint8_t axp_battery_est_update(axp_battery_est_t *est, uint16_t vbat_mv, int load_ma, bool charging, bool charge_done)
+{
+    int32_t sample = (int32_t)vbat_mv << 4;
+    int ocv;
+    uint8_t raw;
+
+    if (vbat_mv == 0) return est->percent;  // No battery, keep the last value
+
+    if (est->ema_mv_x16 == 0)
+        est->ema_mv_x16 = sample;
+    else
+        est->ema_mv_x16 += (sample - est->ema_mv_x16) / (1 << AXP_BAT_EMA_SHIFT);
+
+    // The terminal voltage sags by I*R under load and rises by it while charging
+    ocv = axp_battery_est_mv(est);
+    if (charging)
+        ocv -= AXP_BAT_CHARGE_MA * AXP_BAT_INTERNAL_RES_MOHM / 1000;
+    else
+        ocv += load_ma * AXP_BAT_INTERNAL_RES_MOHM / 1000;
+
+    raw = charge_done ? 100 : axp_battery_ocv_to_percent(ocv);
+    // A charging battery is never shown full before the charger says so
+    if (charging && !charge_done && raw > 99) raw = 99;
+
+    if (est->percent == AXP_BAT_PERCENT_UNKNOWN) {
+        est->percent = raw;
+        return est->percent;
+    }
+
+    // Follow the trend in steps of AXP_BAT_HYSTERESIS, only resync against it on large errors
+    int diff = (int)raw - (int)est->percent;
+    bool with_trend = charging ? (diff > 0) : (diff < 0);
+    if ((with_trend && abs(diff) >= AXP_BAT_HYSTERESIS) || abs(diff) >= AXP_BAT_RESYNC)
+        est->percent = raw;
+    else if (charge_done)
+        est->percent = 100;
+
+    return est->percent;
+}
@@ -0,0 +1,42 @@
+#ifndef AXP_BATTERY_H
+#define AXP_BATTERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Battery model used to turn the AXP2101 voltage reading into a percentage
+#define AXP_BAT_INTERNAL_RES_MOHM   150     // Cell + protection + wiring resistance
+#define AXP_BAT_CHARGE_MA           200     // Constant current set in axp_init()
+#define AXP_BAT_EMA_SHIFT           3       // EMA weight of a new sample: 1/8
+#define AXP_BAT_HYSTERESIS          2       // Published value moves in steps of at least 2%
+#define AXP_BAT_RESYNC              10      // Accept a move against the trend beyond this
+
+#define AXP_BAT_PERCENT_UNKNOWN     0xFF
+
+// Estimator state, small enough to be kept in RTC memory
+typedef struct {
+    int32_t ema_mv_x16;     // Filtered voltage in 1/16 mV, 0 before the first sample
+    uint8_t percent;        // Published percentage, AXP_BAT_PERCENT_UNKNOWN until known
+} axp_battery_est_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// seed_percent: last published value, or AXP_BAT_PERCENT_UNKNOWN
+void axp_battery_est_init(axp_battery_est_t *est, uint8_t seed_percent);
+
+// Open-circuit voltage to state of charge, from the discharge curve
+uint8_t axp_battery_ocv_to_percent(int ocv_mv);
+
+// Feed one sample, returns the published percentage
+uint8_t axp_battery_est_update(axp_battery_est_t *est, uint16_t vbat_mv, int load_ma, bool charging, bool charge_done);
+
+// Filtered terminal voltage in mV
+uint16_t axp_battery_est_mv(const axp_battery_est_t *est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,12 +7,37 @@
 #include "driver/gpio.h"
 #include "XPowersLib.h"
 #include <stdint.h>
+#include <stdlib.h>
 #include "es8311_bsp.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "pcf85063_bsp.h"
+#include "axp_battery.h"
 
 const char *TAG = "axp2101";
 
 static XPowersPMU axp2101;
 
+// Telemetry snapshot, written only by the telemetry task. Readers retry while
+// snap_seq is odd or changed underneath them (sequence lock).
+static axp_battery_snapshot_t bat_snap;
+static volatile uint32_t snap_seq = 0;
+static bool telemetry_running = false;
+static volatile uint16_t load_hint_ma = AXP_LOAD_IDLE_MA;
+
+// Estimator state kept across software resets and deep sleep
+#define AXP_BAT_PERSIST_MAGIC   0x42415431
+typedef struct {
+    uint32_t magic;
+    axp_battery_est_t est;
+} axp_battery_persist_t;
+static RTC_NOINIT_ATTR axp_battery_persist_t bat_persist;
+
+// The PCF85063 RAM byte keeps the published percentage across power-off,
+// bit 7 marks it valid
+#define AXP_BAT_RAM_VALID       0x80
+
 static int AXP2101_SLAVE_Read(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len)
 {
     esp_err_t ret = i2c_read_reg(devAddr, regAddr, data, len);
@@ -119,6 +144,8 @@ void axp_init(void)
     axp2101.setLowBatWarnThreshold(10);           // Output is interrupted when the rate is below 10%
     axp2101.setLowBatShutdownThreshold(5);        // Turn off the battery when it drops below 5%
     axp2101.fuelGaugeControl(true, true);         // Enable battery learning and save the data to ROM 
+
+    axp_telemetry_start();
 }
 
 
@@ -168,10 +195,108 @@ void axp2101_getVoltage_Task(void *arg)
   }
 }
 
+// Take one sample and publish it, returns true if anything worth following changed
+static bool axp_telemetry_sample(void)
+{
+    axp_battery_snapshot_t s = bat_snap;
+    uint16_t last_ema = s.vbat_ema_mv;
+    uint8_t last_percent = s.percent;
+    bool last_charging = s.charging, last_vbus = s.vbus_in;
+
+    s.vbus_in = axp2101.isVbusIn();
+    s.charging = axp2101.isCharging();
+    s.charge_done = s.vbus_in && axp2101.getChargerStatus() == XPOWERS_AXP2101_CHG_DONE_STATE;
+    s.vbat_mv = axp2101.getBattVoltage();
+    s.percent = axp_battery_est_update(&bat_persist.est, s.vbat_mv, load_hint_ma, s.charging, s.charge_done);
+    s.vbat_ema_mv = axp_battery_est_mv(&bat_persist.est);
+    s.updated_us = esp_timer_get_time();
+    bat_persist.magic = AXP_BAT_PERSIST_MAGIC;
+
+    snap_seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    bat_snap = s;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    snap_seq++;
+
+    if (s.percent != last_percent && s.percent <= 100) {
+        PCF85063_ram_write(AXP_BAT_RAM_VALID | s.percent);
+    }
+    return s.percent != last_percent || s.charging != last_charging || s.vbus_in != last_vbus ||
+           abs((int)s.vbat_mv - (int)last_ema) > 20;
+}
+
+static void axp_telemetry_task(void *arg)
+{
+    uint32_t interval = AXP_TELEMETRY_MIN_MS;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(interval));
+        if (axp_telemetry_sample()) {
+            interval = AXP_TELEMETRY_MIN_MS;
+        } else if (interval < AXP_TELEMETRY_MAX_MS) {
+            interval = (interval * 2 > AXP_TELEMETRY_MAX_MS) ? AXP_TELEMETRY_MAX_MS : interval * 2;
+        }
+    }
+}
+
+// Start the battery telemetry, the first sample is taken before returning
+void axp_telemetry_start(void)
+{
+    if (telemetry_running) return;
+
+    if (bat_persist.magic != AXP_BAT_PERSIST_MAGIC || bat_persist.est.percent > 100) {
+        // Cold start, seed the hysteresis from the value shown before power-off
+        uint8_t ram = PCF85063_ram_read();
+        axp_battery_est_init(&bat_persist.est, (ram & AXP_BAT_RAM_VALID) ? (ram & 0x7F) : AXP_BAT_PERCENT_UNKNOWN);
+    }
+    bat_snap.percent = bat_persist.est.percent;
+    axp_telemetry_sample();
+
+    if (xTaskCreate(axp_telemetry_task, "axp_telemetry", 3 * 1024, NULL, 2, NULL) == pdPASS) {
+        telemetry_running = true;
+    } else {
+        ESP_LOGE(TAG, "Failed to create the telemetry task");
+    }
+}
+
+// Copy the latest telemetry without blocking the writer
+void axp_get_battery_snapshot(axp_battery_snapshot_t *snap)
+{
+    uint32_t seq;
+    do {
+        seq = snap_seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        *snap = bat_snap;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != snap_seq);
+}
+
+// Expected average draw in mA, used to compensate the voltage sag
+void axp_set_load_hint(uint16_t load_ma)
+{
+    load_hint_ma = load_ma;
+}
+
+uint16_t axp_get_load_hint(void)
+{
+    return load_hint_ma;
+}
+
+// Battery voltage straight from the ADC, bypassing the telemetry filter
+uint16_t axp_read_vbat_mv(void)
+{
+    return axp2101.getBattVoltage();
+}
+
 // Obtain battery power
 int get_battery_power(void)
 {
-    return axp2101.getBatteryPercent();
+    if (!telemetry_running) {
+        return axp2101.getBatteryPercent();
+    }
+    axp_battery_snapshot_t snap;
+    axp_get_battery_snapshot(&snap);
+    return (snap.percent <= 100) ? snap.percent : -1;
 }
 
 // Obtain the power output status
@@ -282,10 +407,18 @@ void axp_pwr_off()
 }
 
 
-// Detect USB access
+// Detect USB access. Read live, the telemetry snapshot can be up to
+// AXP_TELEMETRY_MAX_MS old: STATUS1 and STATUS2 in one transfer, VBUS good
+// and not in battery-only mode, as isVbusIn() tests them.
 bool get_usb_connected()
 {
-    return axp2101.isVbusIn();
+    uint8_t status[2];
+    if (AXP2101_SLAVE_Read(AXP2101_SLAVE_ADDRESS, XPOWERS_AXP2101_STATUS1, status, sizeof(status)) != 0) {
+        axp_battery_snapshot_t snap;
+        axp_get_battery_snapshot(&snap);
+        return snap.vbus_in;
+    }
+    return (status[0] & 0x20) && !(status[1] & 0x08);
 }
 
 
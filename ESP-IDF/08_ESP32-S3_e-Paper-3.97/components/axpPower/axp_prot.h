@@ -2,6 +2,7 @@
 #define AXP_PROT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef enum axp2101_pwr_tab {
     DC1 = 1,
@@ -11,6 +12,25 @@ typedef enum axp2101_pwr_tab {
     ALDO4,
 } axp2101_pwr_tab_t;
 
+// Battery telemetry, refreshed by a background task
+typedef struct {
+    uint16_t vbat_mv;       // Last raw battery voltage
+    uint16_t vbat_ema_mv;   // Filtered battery voltage
+    uint8_t percent;        // Load compensated state of charge, with hysteresis
+    bool charging;
+    bool charge_done;
+    bool vbus_in;
+    int64_t updated_us;     // esp_timer time of the last sample
+} axp_battery_snapshot_t;
+
+// Load hints for axp_set_load_hint(), average draw in mA
+#define AXP_LOAD_IDLE_MA        40
+#define AXP_LOAD_WIFI_MA        120
+
+// Sampling period, doubled while nothing changes
+#define AXP_TELEMETRY_MIN_MS    2000
+#define AXP_TELEMETRY_MAX_MS    60000
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -19,6 +39,11 @@ extern "C" {
 void axp_init(void);
 void axp2101_getVoltage_Task(void *arg);
 int get_battery_power(void);
+void axp_telemetry_start(void);
+void axp_get_battery_snapshot(axp_battery_snapshot_t *snap);
+void axp_set_load_hint(uint16_t load_ma);
+uint16_t axp_get_load_hint(void);
+uint16_t axp_read_vbat_mv(void);
 bool gatpwrstate(uint8_t tab);
 bool enapwrstate(uint8_t tab); 
 bool disapwrstate(uint8_t tab);
@@ -0,0 +1,59 @@
+#include "boot_graph.h"
+
+uint32_t boot_graph_closure(const boot_node_t *nodes, int count, uint32_t mask)
+{
+    uint32_t prev;
+    do {
+        prev = mask;
+        for (int i = 0; i < count; i++) {
+            if (mask & BOOT_BIT(i)) mask |= nodes[i].deps;
+        }
+    } while (mask != prev);
+    return mask;
+}
+
+uint32_t boot_graph_select(const boot_node_t *nodes, int count, uint32_t reason)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < count; i++) {
+        if (nodes[i].reasons & reason) mask |= BOOT_BIT(i);
+    }
+    return boot_graph_closure(nodes, count, mask);
+}
+
+int boot_graph_order(const boot_node_t *nodes, int count, uint32_t mask, uint8_t *order)
+{
+    uint32_t valid = (count >= 32) ? 0xFFFFFFFFUL : (BOOT_BIT(count) - 1);
+    uint32_t done = 0;
+    int n = 0;
+
+    if (count > BOOT_GRAPH_MAX_NODES || (mask & ~valid)) return -1;
+    for (int i = 0; i < count; i++) {
+        if ((mask & BOOT_BIT(i)) && (nodes[i].deps & ~valid)) return -1;
+    }
+
+    // Kahn's algorithm: repeatedly take the nodes whose dependencies are all done.
+    // The table order breaks ties, so the result is stable.
+    while (done != mask) {
+        uint32_t ready = 0;
+        for (int i = 0; i < count; i++) {
+            uint32_t bit = BOOT_BIT(i);
+            if ((mask & bit) && !(done & bit) && (nodes[i].deps & ~done) == 0) {
+                order[n++] = (uint8_t)i;
+                ready |= bit;
+            }
+        }
+        if (ready == 0) return -1;  // Whatever is left waits on itself
+        done |= ready;
+    }
+    return n;
+}
+
+uint32_t boot_graph_select_common(const boot_node_t *nodes, int count, uint32_t reasons)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < count; i++) {
+        if ((nodes[i].reasons & reasons) == reasons) mask |= BOOT_BIT(i);
+    }
+    return boot_graph_closure(nodes, count, mask);
+}
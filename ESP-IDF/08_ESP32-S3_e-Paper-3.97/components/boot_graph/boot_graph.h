@@ -0,0 +1,66 @@
+#ifndef BOOT_GRAPH_H
+#define BOOT_GRAPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One bit per node in an event group, FreeRTOS leaves 24 usable bits
+#define BOOT_GRAPH_MAX_NODES    24
+#define BOOT_GRAPH_TASK_STACK   (4 * 1024)
+#define BOOT_GRAPH_TASK_PRIO    5
+
+#define BOOT_BIT(id)            (1UL << (id))
+
+// A subsystem to initialize. Nodes are referred to by their index in the table.
+typedef struct {
+    const char *name;
+    void (*init)(void);
+    uint32_t deps;      // BOOT_BIT() of every node that must be done first
+    uint32_t reasons;   // Wake reasons that need this node at boot, 0 = only on first use
+} boot_node_t;
+
+/*---------- Graph helpers, no RTOS involved ----------*/
+
+// Nodes needed by a wake reason, including their dependencies
+uint32_t boot_graph_select(const boot_node_t *nodes, int count, uint32_t reason);
+
+// Nodes needed by every one of the given wake reasons, including their dependencies
+uint32_t boot_graph_select_common(const boot_node_t *nodes, int count, uint32_t reasons);
+
+// Add every dependency of the nodes in mask
+uint32_t boot_graph_closure(const boot_node_t *nodes, int count, uint32_t mask);
+
+// Topological order of the nodes in mask (which must be closed) written to order[].
+// Returns the number of nodes, or -1 on a cycle or a dependency outside the table.
+int boot_graph_order(const boot_node_t *nodes, int count, uint32_t mask, uint8_t *order);
+
+/*---------- Scheduler ----------*/
+
+// Register the table, must be called once before the calls below
+esp_err_t boot_graph_init(const boot_node_t *nodes, int count);
+
+// Start the nodes in mask (and their dependencies) in their own tasks, spread over
+// both cores. Each task waits for its dependencies, so independent nodes overlap.
+esp_err_t boot_graph_spawn(uint32_t mask);
+
+// spawn + wait until every node in mask is done
+esp_err_t boot_graph_run(uint32_t mask);
+
+// Run a deferred node on its first use, returns at once if it is already done
+void boot_graph_ensure(int id);
+
+bool boot_graph_is_done(int id);
+
+// Print start/end time and core of every node run so far
+void boot_graph_log_timeline(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
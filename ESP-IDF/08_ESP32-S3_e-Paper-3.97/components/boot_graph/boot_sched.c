@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "boot_graph.h"
+
+static const char *TAG = "boot";
+
+typedef struct {
+    int64_t start_us;
+    int64_t end_us;
+    int8_t core;
+} boot_timing_t;
+
+static const boot_node_t *s_nodes;
+static int s_count;
+static EventGroupHandle_t s_done;       // Bit i is set once node i has finished
+static SemaphoreHandle_t s_lock;        // Protects s_started and s_next_core
+static uint32_t s_started;
+static int s_next_core;
+static boot_timing_t s_timing[BOOT_GRAPH_MAX_NODES];
+
+esp_err_t boot_graph_init(const boot_node_t *nodes, int count)
+{
+    uint8_t order[BOOT_GRAPH_MAX_NODES];
+    uint32_t all = (count >= 32) ? 0xFFFFFFFFUL : (BOOT_BIT(count) - 1);
+
+    if (count <= 0 || count > BOOT_GRAPH_MAX_NODES) return ESP_ERR_INVALID_ARG;
+    // Reject a broken table up front instead of hanging a boot task on it later
+    if (boot_graph_order(nodes, count, all, order) != count) {
+        ESP_LOGE(TAG, "Dependency cycle or unknown dependency in the boot table");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_done = xEventGroupCreate();
+    s_lock = xSemaphoreCreateMutex();
+    if (s_done == NULL || s_lock == NULL) return ESP_ERR_NO_MEM;
+    s_nodes = nodes;
+    s_count = count;
+    return ESP_OK;
+}
+
+static void boot_node_task(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    const boot_node_t *node = &s_nodes[id];
+
+    if (node->deps) {
+        xEventGroupWaitBits(s_done, node->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    s_timing[id].core = (int8_t)xPortGetCoreID();
+    s_timing[id].start_us = esp_timer_get_time();
+    if (node->init) node->init();
+    s_timing[id].end_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "%s done in %d ms", node->name, (int)((s_timing[id].end_us - s_timing[id].start_us) / 1000));
+
+    xEventGroupSetBits(s_done, BOOT_BIT(id));
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_graph_spawn(uint32_t mask)
+{
+    uint8_t order[BOOT_GRAPH_MAX_NODES];
+    int n;
+
+    if (s_nodes == NULL) return ESP_ERR_INVALID_STATE;
+    mask = boot_graph_closure(s_nodes, s_count, mask);
+    n = boot_graph_order(s_nodes, s_count, mask, order);
+    if (n < 0) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < n; i++) {
+        int id = order[i];
+        if (s_started & BOOT_BIT(id)) continue;   // Already running or done
+
+#if CONFIG_FREERTOS_UNICORE
+        BaseType_t core = tskNO_AFFINITY;
+#else
+        BaseType_t core = s_next_core;
+        s_next_core = (s_next_core + 1) % portNUM_PROCESSORS;
+#endif
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "boot_%s", s_nodes[id].name);
+        if (xTaskCreatePinnedToCore(boot_node_task, name, BOOT_GRAPH_TASK_STACK, (void *)(intptr_t)id,
+                                    BOOT_GRAPH_TASK_PRIO, NULL, core) != pdPASS) {
+            xSemaphoreGive(s_lock);
+            ESP_LOGE(TAG, "Failed to create the task for %s", s_nodes[id].name);
+            return ESP_ERR_NO_MEM;
+        }
+        s_started |= BOOT_BIT(id);
+    }
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+esp_err_t boot_graph_run(uint32_t mask)
+{
+    esp_err_t ret = boot_graph_spawn(mask);
+    if (ret != ESP_OK) return ret;
+    mask = boot_graph_closure(s_nodes, s_count, mask);
+    xEventGroupWaitBits(s_done, mask, pdFALSE, pdTRUE, portMAX_DELAY);
+    return ESP_OK;
+}
+
+bool boot_graph_is_done(int id)
+{
+    return s_done != NULL && (xEventGroupGetBits(s_done) & BOOT_BIT(id)) != 0;
+}
+
+void boot_graph_ensure(int id)
+{
+    if (s_nodes == NULL || id < 0 || id >= s_count) return;
+    if (boot_graph_is_done(id)) return;
+    ESP_LOGI(TAG, "%s needed now", s_nodes[id].name);
+    boot_graph_run(BOOT_BIT(id));
+}
+
+void boot_graph_log_timeline(void)
+{
+    uint32_t done = (s_done != NULL) ? (uint32_t)xEventGroupGetBits(s_done) : 0;
+    int64_t end = 0;
+
+    ESP_LOGI(TAG, "%-10s %4s %8s %8s %8s", "node", "core", "start", "end", "ms");
+    for (int i = 0; i < s_count; i++) {
+        if (!(done & BOOT_BIT(i))) continue;
+        ESP_LOGI(TAG, "%-10s %4d %8d %8d %8d", s_nodes[i].name, s_timing[i].core,
+                 (int)(s_timing[i].start_us / 1000), (int)(s_timing[i].end_us / 1000),
+                 (int)((s_timing[i].end_us - s_timing[i].start_us) / 1000));
+        if (s_timing[i].end_us > end) end = s_timing[i].end_us;
+    }
+    ESP_LOGI(TAG, "all done at %d ms since boot", (int)(end / 1000));
+}
@@ -0,0 +1,119 @@
+#include "energy_model.h"
+#include <string.h>
+
+#define EP_SECONDS_PER_DAY  86400.0f
+#define EP_UC_PER_MAH       3600000.0f
+
+void ep_int_begin(ep_integrator_t *it, int64_t t_us, int32_t ref_mv_x16, uint16_t base_ma, uint16_t r_mohm)
+{
+    memset(it, 0, sizeof(*it));
+    it->start_us = t_us;
+    it->last_us = t_us;
+    it->ref_mv_x16 = ref_mv_x16;
+    it->base_ua = (int32_t)base_ma * 1000;
+    it->r_mohm = r_mohm ? r_mohm : 1;
+    it->last_mv = (uint16_t)((ref_mv_x16 + 8) >> 4);
+    it->last_ua = it->base_ua;
+}
+
+void ep_int_preroll(ep_integrator_t *it, int64_t us)
+{
+    if (us <= 0) return;
+    it->start_us -= us;
+    it->charge_uaus += (int64_t)it->base_ua * us;
+    it->energy_nj += (int64_t)it->last_mv * it->base_ua / 1000 * us / 1000;
+}
+
+int32_t ep_int_current_ua(const ep_integrator_t *it, uint16_t mv)
+{
+    // mV / mOhm = A, so the sag in mV times 1e6 / R is in uA
+    return it->base_ua + (int32_t)(((int64_t)it->ref_mv_x16 - ((int32_t)mv << 4)) * 1000000 / (16 * it->r_mohm));
+}
+
+void ep_int_add(ep_integrator_t *it, int64_t t_us, uint16_t mv)
+{
+    int64_t dt = t_us - it->last_us;
+    if (dt <= 0 || mv == 0) return;
+
+    int32_t ua = ep_int_current_ua(it, mv);
+    // Trapezoid between this sample and the last one, power from the mean voltage
+    int64_t mean_ua = ((int64_t)it->last_ua + ua) / 2;
+    int64_t mean_mv = ((int64_t)it->last_mv + mv) / 2;
+    it->charge_uaus += mean_ua * dt;
+    // mV * uA = nW, times us is 1e-15 J
+    it->energy_nj += mean_mv * mean_ua / 1000 * dt / 1000;
+
+    it->last_us = t_us;
+    it->last_ua = ua;
+    it->last_mv = mv;
+    it->samples++;
+}
+
+bool ep_int_charging(const ep_integrator_t *it, uint16_t mv, uint16_t rise_mv)
+{
+    return ((int32_t)mv << 4) > it->ref_mv_x16 + ((int32_t)rise_mv << 4);
+}
+
+void ep_int_result(const ep_integrator_t *it, ep_result_t *res)
+{
+    res->duration_ms = (uint32_t)((it->last_us - it->start_us) / 1000);
+    res->samples = it->samples;
+    // Noise around a base current close to zero can integrate to a small negative total
+    res->charge_uc = it->charge_uaus > 0 ? (float)it->charge_uaus / 1e6f : 0.0f;
+    res->energy_mj = it->energy_nj > 0 ? (float)it->energy_nj / 1e6f : 0.0f;
+}
+
+void ep_stats_add(ep_stats_t *st, const ep_result_t *res)
+{
+    if (st->count < UINT32_MAX) st->count++;
+    // Plain mean over the first EP_STATS_WINDOW operations, then exponential
+    float w = 1.0f / (float)(st->count < EP_STATS_WINDOW ? st->count : EP_STATS_WINDOW);
+    st->charge_uc += (res->charge_uc - st->charge_uc) * w;
+    st->energy_mj += (res->energy_mj - st->energy_mj) * w;
+    st->duration_ms += ((float)res->duration_ms - st->duration_ms) * w;
+    if (res->charge_uc > st->max_charge_uc) st->max_charge_uc = res->charge_uc;
+}
+
+int ep_mode_loads(ep_mode_t mode, int sync_days, ep_load_t *out)
+{
+    float sync = 1.0f / (float)(sync_days > 0 ? sync_days : 1);
+
+    switch (mode) {
+    case EP_MODE_CLOCK:
+        // A wake-up a minute, the ones on :00 and :30 redraw fully, 8:00 also syncs when due
+        out[0] = (ep_load_t){EP_OP_CLOCK_WAKE, 1440.0f - 48.0f};
+        out[1] = (ep_load_t){EP_OP_CLOCK_FULL, 48.0f - sync};
+        out[2] = (ep_load_t){EP_OP_SYNC_WAKE, sync};
+        return 3;
+    case EP_MODE_CALENDAR:
+        out[0] = (ep_load_t){EP_OP_CALENDAR_WAKE, 1.0f - sync};
+        out[1] = (ep_load_t){EP_OP_SYNC_WAKE, sync};
+        return 2;
+    case EP_MODE_WEATHER:
+        // 4:00, 9:00, 14:00 and 20:00
+        out[0] = (ep_load_t){EP_OP_WEATHER_WAKE, 4.0f};
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+float ep_estimate_days(const ep_stats_t stats[EP_OP_COUNT], const ep_load_t *loads, int n,
+                       float charge_mah, float off_ua)
+{
+    float awake_s = 0.0f, charge_uc = 0.0f;
+
+    for (int i = 0; i < n; i++) {
+        if (loads[i].per_day <= 0.0f) continue;
+        if (loads[i].op >= EP_OP_COUNT) return -1.0f;
+        const ep_stats_t *st = &stats[loads[i].op];
+        if (st->count == 0) return -1.0f;
+        charge_uc += loads[i].per_day * st->charge_uc;
+        awake_s += loads[i].per_day * st->duration_ms / 1000.0f;
+    }
+    if (awake_s < EP_SECONDS_PER_DAY) {
+        charge_uc += off_ua * (EP_SECONDS_PER_DAY - awake_s);
+    }
+    if (charge_uc <= 0.0f) return -1.0f;
+    return charge_mah * EP_UC_PER_MAH / charge_uc;
+}
@@ -0,0 +1,113 @@
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Charge and energy of an operation from battery voltage samples, and battery
+ * life from the per-operation means. The AXP2101 measures no battery current,
+ * so it is inferred from the sag below the voltage at the start of the
+ * operation: I = I_base + (V_ref - V) / R_int, where I_base is the draw the
+ * device had at that moment (the telemetry load hint) and R_int the cell
+ * resistance the percentage estimate already uses. Samples are integrated
+ * with the trapezoid rule. No hardware access.
+ */
+
+// Operation types, kept in this order in NVS
+typedef enum {
+    EP_OP_CLOCK_WAKE = 0,   // Clock mode wake-up, partial refresh
+    EP_OP_CLOCK_FULL,       // Clock mode wake-up on the hour or half hour, full refresh
+    EP_OP_CALENDAR_WAKE,    // Calendar mode wake-up at midnight
+    EP_OP_WEATHER_WAKE,     // Weather mode wake-up: WiFi, location, forecast fetch, refresh
+    EP_OP_SYNC_WAKE,        // Clock or calendar wake-up that also synced the RTC over NTP
+    EP_OP_PAGE_TURN,        // Reader page turn, including the background preload
+    EP_OP_AUDIO_MINUTE,     // One minute of MP3 playback, with its clock refresh
+    EP_OP_COUNT
+} ep_op_t;
+
+// Unattended modes of main.cc (saved mode 1, 2 and 3)
+typedef enum {
+    EP_MODE_CLOCK = 0,
+    EP_MODE_CALENDAR,
+    EP_MODE_WEATHER,
+    EP_MODE_COUNT
+} ep_mode_t;
+
+#define EP_STATS_WINDOW     32      // Running means weigh the last ~32 operations
+#define EP_MODE_MAX_LOADS   3
+
+typedef struct {
+    int64_t start_us;
+    int64_t last_us;
+    int32_t last_ua;        // Current of the last sample
+    int32_t base_ua;
+    int32_t ref_mv_x16;     // Reference voltage in 1/16 mV, an average of several readings
+    uint16_t r_mohm;
+    uint16_t last_mv;
+    uint32_t samples;
+    int64_t charge_uaus;    // uA * us
+    int64_t energy_nj;
+} ep_integrator_t;
+
+// Result of one operation
+typedef struct {
+    uint32_t duration_ms;
+    uint32_t samples;
+    float charge_uc;        // uA * s
+    float energy_mj;
+} ep_result_t;
+
+// Per operation type, saved in NVS
+typedef struct {
+    uint32_t count;         // Operations recorded
+    float charge_uc;        // Running means
+    float energy_mj;
+    float duration_ms;
+    float max_charge_uc;
+} ep_stats_t;
+
+// An operation repeated per_day times a day
+typedef struct {
+    uint8_t op;
+    float per_day;
+} ep_load_t;
+
+// ref_mv_x16: battery voltage at the start in 1/16 mV, base_ma: draw at that voltage
+void ep_int_begin(ep_integrator_t *it, int64_t t_us, int32_t ref_mv_x16, uint16_t base_ma, uint16_t r_mohm);
+
+// Time spent at the base current before sampling started (boot of a wake-up)
+void ep_int_preroll(ep_integrator_t *it, int64_t us);
+
+// Add the voltage sampled at t_us. Samples out of order are ignored.
+void ep_int_add(ep_integrator_t *it, int64_t t_us, uint16_t mv);
+
+// Current the model gives for a voltage, uA
+int32_t ep_int_current_ua(const ep_integrator_t *it, uint16_t mv);
+
+// Whether mv is more than rise_mv above the reference: a charger, not the load
+bool ep_int_charging(const ep_integrator_t *it, uint16_t mv, uint16_t rise_mv);
+
+// Totals so far. The charge is never negative.
+void ep_int_result(const ep_integrator_t *it, ep_result_t *res);
+
+void ep_stats_add(ep_stats_t *st, const ep_result_t *res);
+
+// Operations a day in a mode. sync_days: days between NTP syncs.
+// Returns the number of loads written to out[EP_MODE_MAX_LOADS].
+int ep_mode_loads(ep_mode_t mode, int sync_days, ep_load_t *out);
+
+// Days a battery holding charge_mah lasts under the loads, with off_ua drawn
+// while powered off between them. Returns -1 if a load was never measured.
+float ep_estimate_days(const ep_stats_t stats[EP_OP_COUNT], const ep_load_t *loads, int n,
+                       float charge_mah, float off_ua);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+#include "energy_prof.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "axp_prot.h"
+#include "axp_battery.h"
+
+#define EP_NVS_NAMESPACE    "energy"
+#define EP_NVS_KEY          "stats"
+#define EP_VERSION          1
+#define EP_TASK_PRIO        6       // Above the pages, below the I2C executor
+#define EP_TASK_STACK       (3 * 1024)
+#define EP_NONE             EP_OP_COUNT
+// Notification slot that starts the sampling task, slot 2 is the I2C bus's (see i2c_bsp.h).
+// Kept off slot 0, which an xTaskNotifyGive() from anything else would share.
+#define EP_NOTIFY_INDEX     1
+
+static const char *TAG = "energy";
+
+static const char *const op_names[EP_OP_COUNT] = {
+    "clock", "clock_full", "calendar", "weather", "sync", "page_turn", "audio_min",
+};
+
+typedef struct {
+    uint8_t version;
+    ep_stats_t stats[EP_OP_COUNT];
+} ep_saved_t;
+
+static ep_saved_t ep_saved;
+static bool ep_dirty = false;
+
+// The operation being measured and its integrator, shared with the sampling task
+static portMUX_TYPE ep_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile ep_op_t ep_active = EP_NONE;
+static bool ep_invalid;
+static ep_integrator_t ep_int;
+static TaskHandle_t ep_task = NULL;
+
+static void ep_load(void)
+{
+    nvs_handle_t handle;
+    size_t len = sizeof(ep_saved);
+    if (nvs_open(EP_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        esp_err_t err = nvs_get_blob(handle, EP_NVS_KEY, &ep_saved, &len);
+        nvs_close(handle);
+        if (err == ESP_OK && len == sizeof(ep_saved) && ep_saved.version == EP_VERSION) {
+            return;
+        }
+    }
+    memset(&ep_saved, 0, sizeof(ep_saved));
+    ep_saved.version = EP_VERSION;
+}
+
+static void energy_prof_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTakeIndexed(EP_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        TickType_t last_wake = xTaskGetTickCount();
+        TickType_t period = pdMS_TO_TICKS(EP_SAMPLE_MS) ? pdMS_TO_TICKS(EP_SAMPLE_MS) : 1;
+
+        while (ep_active != EP_NONE) {
+            uint16_t mv = axp_read_vbat_mv();
+            int64_t now = esp_timer_get_time();
+            portENTER_CRITICAL(&ep_lock);
+            if (ep_active != EP_NONE) {
+                ep_int_add(&ep_int, now, mv);
+                if (ep_int_charging(&ep_int, mv, EP_CHARGE_RISE_MV)) ep_invalid = true;
+            }
+            portEXIT_CRITICAL(&ep_lock);
+            vTaskDelayUntil(&last_wake, period);
+        }
+    }
+}
+
+void energy_prof_init(void)
+{
+    if (ep_task) return;
+    ep_load();
+    if (xTaskCreate(energy_prof_task, "energy_prof", EP_TASK_STACK, NULL, EP_TASK_PRIO, &ep_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the sampling task");
+        ep_task = NULL;
+    }
+}
+
+bool energy_prof_begin(ep_op_t op, bool from_boot)
+{
+    if (!ep_task || op >= EP_OP_COUNT || ep_active != EP_NONE) return false;
+
+    // On USB the charger holds the battery voltage, it says nothing about the draw
+    axp_battery_snapshot_t snap;
+    axp_get_battery_snapshot(&snap);
+    if (snap.vbus_in) return false;
+
+    uint32_t ref_mv = 0;
+    for (int i = 0; i < EP_REF_SAMPLES; i++) {
+        uint16_t mv = axp_read_vbat_mv();
+        if (mv == 0) return false;      // No battery
+        ref_mv += mv;
+    }
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&ep_lock);
+    if (ep_active != EP_NONE) {
+        portEXIT_CRITICAL(&ep_lock);
+        return false;
+    }
+    ep_int_begin(&ep_int, now, (int32_t)(ref_mv << 4) / EP_REF_SAMPLES, axp_get_load_hint(), AXP_BAT_INTERNAL_RES_MOHM);
+    if (from_boot) {
+        // The bootloader before the timer started is not counted
+        ep_int_preroll(&ep_int, now);
+    }
+    ep_invalid = false;
+    ep_active = op;
+    portEXIT_CRITICAL(&ep_lock);
+
+    xTaskNotifyGiveIndexed(ep_task, EP_NOTIFY_INDEX);
+    return true;
+}
+
+void energy_prof_end(ep_op_t op)
+{
+    if (ep_active != op) return;
+
+    axp_battery_snapshot_t snap;
+    axp_get_battery_snapshot(&snap);
+    uint16_t mv = axp_read_vbat_mv();
+    int64_t now = esp_timer_get_time();
+    ep_result_t res;
+    bool valid;
+
+    portENTER_CRITICAL(&ep_lock);
+    if (ep_active != op) {
+        portEXIT_CRITICAL(&ep_lock);
+        return;
+    }
+    ep_int_add(&ep_int, now, mv);
+    // The last sample too, a charger plugged in since the task's last one
+    if (ep_int_charging(&ep_int, mv, EP_CHARGE_RISE_MV)) ep_invalid = true;
+    ep_int_result(&ep_int, &res);
+    valid = !ep_invalid && !snap.vbus_in && res.samples >= EP_MIN_SAMPLES;
+    if (valid) {
+        ep_stats_add(&ep_saved.stats[op], &res);
+        ep_dirty = true;
+    }
+    ep_active = EP_NONE;
+    portEXIT_CRITICAL(&ep_lock);
+
+    if (valid) {
+        ESP_LOGI(TAG, "%s: %lu ms, %.1f uAh, %.1f mJ, %lu samples", op_names[op], (unsigned long)res.duration_ms,
+                 res.charge_uc / 3600.0f, res.energy_mj, (unsigned long)res.samples);
+    } else {
+        ESP_LOGW(TAG, "%s: dropped (USB power or too short)", op_names[op]);
+    }
+}
+
+void energy_prof_cancel(ep_op_t op)
+{
+    portENTER_CRITICAL(&ep_lock);
+    if (ep_active == op) ep_active = EP_NONE;
+    portEXIT_CRITICAL(&ep_lock);
+}
+
+void energy_prof_flush(void)
+{
+    ep_saved_t copy;
+
+    portENTER_CRITICAL(&ep_lock);
+    if (!ep_dirty) {
+        portEXIT_CRITICAL(&ep_lock);
+        return;
+    }
+    copy = ep_saved;
+    ep_dirty = false;
+    portEXIT_CRITICAL(&ep_lock);
+
+    nvs_handle_t handle;
+    if (nvs_open(EP_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS");
+        return;
+    }
+    nvs_set_blob(handle, EP_NVS_KEY, &copy, sizeof(copy));
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+void energy_prof_get_stats(ep_stats_t stats[EP_OP_COUNT])
+{
+    portENTER_CRITICAL(&ep_lock);
+    memcpy(stats, ep_saved.stats, sizeof(ep_saved.stats));
+    portEXIT_CRITICAL(&ep_lock);
+}
+
+float energy_prof_mode_days(ep_mode_t mode, int sync_days)
+{
+    ep_stats_t stats[EP_OP_COUNT];
+    ep_load_t loads[EP_MODE_MAX_LOADS];
+    int n = ep_mode_loads(mode, sync_days, loads);
+    int percent = get_battery_power();
+
+    energy_prof_get_stats(stats);
+    float charge_mah = (float)CONFIG_ENERGY_BATTERY_MAH * (percent >= 0 ? percent : 100) / 100.0f;
+    return ep_estimate_days(stats, loads, n, charge_mah, (float)CONFIG_ENERGY_OFF_UA);
+}
+
+void energy_prof_log_stats(void)
+{
+    ep_stats_t stats[EP_OP_COUNT];
+    energy_prof_get_stats(stats);
+    for (int i = 0; i < EP_OP_COUNT; i++) {
+        const ep_stats_t *s = &stats[i];
+        if (s->count == 0) continue;
+        ESP_LOGI(TAG, "%-10s x%-5lu %8.1f uAh (max %.1f) %8.1f mJ %7.0f ms", op_names[i], (unsigned long)s->count,
+                 s->charge_uc / 3600.0f, s->max_charge_uc / 3600.0f, s->energy_mj, s->duration_ms);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef ENERGY_PROF_H
+#define ENERGY_PROF_H
+
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "energy_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Charge used by each kind of operation, measured on the battery. Between
+ * energy_prof_begin() and energy_prof_end() a task reads the AXP2101 battery
+ * voltage every EP_SAMPLE_MS and integrates it (energy_model.h). One
+ * operation is measured at a time; a begin while another is running is
+ * refused. Operations on USB power, or during which the voltage rose as if
+ * charging, are dropped. The running means live in NVS namespace "energy",
+ * written by energy_prof_flush(), and give the expected battery life of the
+ * unattended modes.
+ */
+
+#ifndef CONFIG_ENERGY_BATTERY_MAH
+#define CONFIG_ENERGY_BATTERY_MAH   1000
+#endif
+#ifndef CONFIG_ENERGY_OFF_UA
+#define CONFIG_ENERGY_OFF_UA        25
+#endif
+
+#define EP_SAMPLE_MS        10
+#define EP_REF_SAMPLES      4       // Averaged for the reference voltage
+#define EP_MIN_SAMPLES      3       // Fewer and the operation is dropped
+#define EP_CHARGE_RISE_MV   40      // Above the reference by this, a charger was plugged in
+
+// Load the statistics and start the sampling task. Needs NVS.
+void energy_prof_init(void);
+
+// Start measuring op. from_boot: a wake-up, count the time since boot at the
+// base current too. Returns false if nothing is measured.
+bool energy_prof_begin(ep_op_t op, bool from_boot);
+
+// Finish op, if it is the one being measured, and add it to the statistics
+void energy_prof_end(ep_op_t op);
+
+// Drop op, if it is the one being measured
+void energy_prof_cancel(ep_op_t op);
+
+// Write the statistics to NVS if they changed
+void energy_prof_flush(void);
+
+void energy_prof_get_stats(ep_stats_t stats[EP_OP_COUNT]);
+
+// Days the battery lasts in mode from its present charge, -1 until measured
+float energy_prof_mode_days(ep_mode_t mode, int sync_days);
+
+void energy_prof_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,8 +10,21 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "sdkconfig.h"
+#include <sys/lock.h>
+#include "esp_heap_caps.h"
+#include "perf_trace.h"
+#ifdef CONFIG_FONT_EMBED_COMPRESSED
+#include "font_fz.h"
+#endif
 
 static const char *TAG = "FONT";
+
+#ifdef CONFIG_FONT_PROPORTIONAL
+#define FONT_METRICS_EN(size)   (&Font##size##_Metrics)
+#else
+#define FONT_METRICS_EN(size)   NULL
+#endif
+
 // Predefined font instance
 cFONT Font12_UTF8 = {
     .font_name_EN = Font12EN,
@@ -22,7 +35,8 @@ cFONT Font12_UTF8 = {
     .Height = font12_Height,
     .size_EN = font12_size_EN,
     .size_CH = font12_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(12)
 };
 
 cFONT Font16_UTF8 = {
@@ -34,7 +48,8 @@ cFONT Font16_UTF8 = {
     .Height = font16_Height,
     .size_EN = font16_size_EN,
     .size_CH = font16_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(16)
 };
 
 cFONT Font18_UTF8 = {
@@ -46,7 +61,8 @@ cFONT Font18_UTF8 = {
     .Height = font18_Height,
     .size_EN = font18_size_EN,
     .size_CH = font18_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(18)
 };
 
 cFONT Font24_UTF8 = {
@@ -58,7 +74,8 @@ cFONT Font24_UTF8 = {
     .Height = font24_Height,
     .size_EN = font24_size_EN,
     .size_CH = font24_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(24)
 };
 
 cFONT Font28_UTF8 = {
@@ -70,7 +87,8 @@ cFONT Font28_UTF8 = {
     .Height = font28_Height,
     .size_EN = font28_size_EN,
     .size_CH = font28_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(28)
 };
 
 cFONT Font36_UTF8 = {
@@ -82,7 +100,8 @@ cFONT Font36_UTF8 = {
     .Height = font36_Height,
     .size_EN = font36_size_EN,
     .size_CH = font36_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(36)
 };
 
 cFONT Font48_UTF8 = {
@@ -94,7 +113,8 @@ cFONT Font48_UTF8 = {
     .Height = font48_Height,
     .size_EN = font48_size_EN,
     .size_CH = font48_size_CH,
-    .encoding = FONT_ENCODING_UTF8
+    .encoding = FONT_ENCODING_UTF8,
+    .metrics_EN = FONT_METRICS_EN(48)
 };
 
 // Definition in GB2312
@@ -107,7 +127,8 @@ cFONT Font12_GBK = {
     .Height = font12_Height,
     .size_EN = font12_size_EN,
     .size_CH = font12_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(12)
 };
 
 cFONT Font16_GBK = {
@@ -119,7 +140,8 @@ cFONT Font16_GBK = {
     .Height = font16_Height,
     .size_EN = font16_size_EN,
     .size_CH = font16_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(16)
 };
 
 cFONT Font18_GBK = {
@@ -131,7 +153,8 @@ cFONT Font18_GBK = {
     .Height = font18_Height,
     .size_EN = font18_size_EN,
     .size_CH = font18_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(18)
 };
 
 cFONT Font24_GBK = {
@@ -143,7 +166,8 @@ cFONT Font24_GBK = {
     .Height = font24_Height,
     .size_EN = font24_size_EN,
     .size_CH = font24_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(24)
 };
 
 cFONT Font28_GBK = {
@@ -155,7 +179,8 @@ cFONT Font28_GBK = {
     .Height = font28_Height,
     .size_EN = font28_size_EN,
     .size_CH = font28_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(28)
 };
 
 cFONT Font36_GBK = {
@@ -167,7 +192,8 @@ cFONT Font36_GBK = {
     .Height = font36_Height,
     .size_EN = font36_size_EN,
     .size_CH = font36_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(36)
 };
 
 cFONT Font48_GBK = {
@@ -179,7 +205,8 @@ cFONT Font48_GBK = {
     .Height = font48_Height,
     .size_EN = font48_size_EN,
     .size_CH = font48_size_CH,
-    .encoding = FONT_ENCODING_GBK
+    .encoding = FONT_ENCODING_GBK,
+    .metrics_EN = FONT_METRICS_EN(48)
 };
 
 // Pure English definition
@@ -246,6 +273,79 @@ sFONT Font182 = {
     .size = font182_size_EN
 };
 
+#ifdef CONFIG_FONT_EMBED_COMPRESSED
+// Decoded blocks of the compressed containers, shared by all fonts
+typedef struct {
+    const uint8_t *blob;        // Container the block belongs to, NULL if free
+    uint32_t block;
+    uint32_t last_use;
+    size_t capacity;
+    uint8_t *data;
+} fz_cache_slot_t;
+
+static fz_cache_slot_t fz_cache[FONT_FZ_CACHE_BLOCKS];
+static uint32_t fz_cache_clock;
+static _lock_t fz_cache_lock;
+
+static const uint8_t *fz_cache_get(const uint8_t *blob, const font_fz_t *fz, uint32_t block)
+{
+    fz_cache_slot_t *victim = &fz_cache[0];
+    for (int i = 0; i < FONT_FZ_CACHE_BLOCKS; i++) {
+        fz_cache_slot_t *slot = &fz_cache[i];
+        if (slot->blob == blob && slot->block == block) {
+            slot->last_use = ++fz_cache_clock;
+            return slot->data;
+        }
+        if (slot->last_use < victim->last_use) victim = slot;
+    }
+
+    // Miss: decode into the least recently used slot
+    size_t need = (size_t)fz->block_glyphs * fz->glyph_size;
+    if (victim->capacity < need) {
+        free(victim->data);
+        victim->data = heap_caps_malloc(need, MALLOC_CAP_SPIRAM);
+        if (victim->data == NULL) victim->data = malloc(need);
+        victim->capacity = victim->data ? need : 0;
+        victim->blob = NULL;
+        if (victim->data == NULL) return NULL;
+    }
+    if (font_fz_decode_block(fz, block, victim->data) < 0) {
+        ESP_LOGE(TAG, "Corrupt font block %lu", (unsigned long)block);
+        victim->blob = NULL;
+        return NULL;
+    }
+    victim->blob = blob;
+    victim->block = block;
+    victim->last_use = ++fz_cache_clock;
+    return victim->data;
+}
+#endif
+
+// Copy one glyph out of embedded font data, a plain .FON image or a compressed container
+static bool read_embedded_glyph(const uint8_t *data, size_t size, uint32_t offset, unsigned char *buffer, uint16_t len)
+{
+#ifdef CONFIG_FONT_EMBED_COMPRESSED
+    font_fz_t fz;
+    if (font_fz_open(&fz, data, size)) {
+        uint32_t glyph = offset / fz.glyph_size;
+        bool ok = false;
+        if (len != fz.glyph_size || offset % fz.glyph_size || glyph >= fz.glyph_count) return false;
+
+        _lock_acquire(&fz_cache_lock);
+        const uint8_t *block = fz_cache_get(data, &fz, glyph / fz.block_glyphs);
+        if (block) {
+            memcpy(buffer, block + (size_t)(glyph % fz.block_glyphs) * fz.glyph_size, len);
+            ok = true;
+        }
+        _lock_release(&fz_cache_lock);
+        return ok;
+    }
+#endif
+    if ((size_t)offset + len > size) return false;
+    memcpy(buffer, data + offset, len);
+    return true;
+}
+
 // A unified function for obtaining embedded font data
 static bool get_embedded_font_data(cFONT* font, const char* file_type, const uint8_t** data_start, size_t* data_size) 
 {
@@ -462,203 +562,353 @@ static bool get_embedded_font_data(cFONT* font, const char* file_type, const uin
     return false;
 }
 
-// Embedded font support
-int Get_Char_Font_Data(cFONT* font, const char* character, unsigned char* buffer)
+#if defined(CONFIG_FONT_ENABLE_SDCARD) || defined(CONFIG_FONT_ENABLE_TFCARD)
+#define FONT_FILE_FALLBACK  1
+#else
+#define FONT_FILE_FALLBACK  0
+#endif
+
+#if FONT_FILE_FALLBACK
+/*
+ * Font files stay open between calls. The card is mounted with max_files = 5
+ * and the reader and the audio player need theirs, so only a couple are kept,
+ * least recently used closed first. Font_CloseFiles() gives them back when a
+ * page is left, before a recording is created and before the reader's
+ * progress log compacts. The position is tracked so that a read right after
+ * the previous one needs no seek.
+ */
+typedef struct {
+    const char *path;
+    FILE *file;
+    long pos;
+    uint32_t last_use;
+} font_file_t;
+
+static font_file_t font_files[FONT_FILE_HANDLES];
+static uint32_t font_file_clock;
+static _lock_t font_file_lock;
+static uint8_t *font_read_buf;      // FONT_READ_MAX bytes, allocated on first use
+
+static void font_file_close(font_file_t *h)
 {
-    FILE* file = NULL;
-    uint32_t font_offset = 0;
-    int char_len = 1;
-    
-    // Determine the character encoding and length
-    if (font->encoding == FONT_ENCODING_UTF8) {
-        char_len = Get_UTF8_Char_Length((unsigned char)character[0]);
-    } else { // GBK/GB2312
-        char_len = ((unsigned char)character[0] < 0x80) ? 1 : 2;
+    if (h->file) fclose(h->file);
+    h->file = NULL;
+    h->path = NULL;
+}
+
+// Called with font_file_lock held
+static font_file_t *font_file_get(const char *path)
+{
+    font_file_t *victim = &font_files[0];
+    for (int i = 0; i < FONT_FILE_HANDLES; i++) {
+        font_file_t *h = &font_files[i];
+        if (h->file && strcmp(h->path, path) == 0) {
+            h->last_use = ++font_file_clock;
+            return h;
+        }
+        if (!h->file || (victim->file && h->last_use < victim->last_use)) victim = h;
     }
-    
-    // ASCII Character Processing (Half-width)
-    if (char_len == 1 && (unsigned char)character[0] < 0x80) {
-        if ((unsigned char)character[0] < 0x20) {
-            // ESP_LOGW(TAG, "Unsupported ASCII control characters: 0x%02X", (unsigned char)character[0]);
-            return -1;
+
+    font_file_close(victim);
+    victim->file = fopen(path, "rb");
+    if (!victim->file) {
+        ESP_LOGE(TAG, "The font file cannot be opened: %s", path);
+        return NULL;
+    }
+    victim->path = path;
+    victim->pos = 0;
+    victim->last_use = ++font_file_clock;
+    return victim;
+}
+
+// Called with font_file_lock held, a failed read closes the handle so the next call reopens the file
+static bool font_file_read(font_file_t *h, uint32_t offset, uint8_t *buffer, size_t len)
+{
+    if (h->pos != (long)offset && fseek(h->file, (long)offset, SEEK_SET) != 0) {
+        font_file_close(h);
+        return false;
+    }
+    TRACE_BEGIN_ARG(FONT_READ, len);
+    size_t got = fread(buffer, 1, len, h->file);
+    TRACE_END(FONT_READ);
+    h->pos = (long)offset + (long)got;
+    if (got != len) {
+        font_file_close(h);
+        return false;
+    }
+    return true;
+}
+
+// Close the font files, for code that needs every handle of the card
+void Font_CloseFiles(void)
+{
+    _lock_acquire(&font_file_lock);
+    for (int i = 0; i < FONT_FILE_HANDLES; i++)
+        font_file_close(&font_files[i]);
+    _lock_release(&font_file_lock);
+}
+#else
+void Font_CloseFiles(void)
+{
+}
+#endif
+
+// Glyph files of a cFONT
+typedef enum {
+    FONT_SRC_EN = 0,        // ASCII
+    FONT_SRC_CH,            // Chinese characters
+    FONT_SRC_CH_ASICC,      // Full-width forms and symbols
+    FONT_SRC_SYMBOL,        // Symbols of UTF-8 text, from the GBK symbol file of the same size
+} font_src_t;
+
+// One glyph to fetch
+typedef struct {
+    uint32_t offset;
+    uint16_t size;
+    uint16_t index;         // Slot in the caller's arrays
+    uint8_t src;
+} font_req_t;
+
+static bool font_locate_ascii(const cFONT *font, uint32_t ch, font_req_t *req)
+{
+    if (ch < 0x20 || ch >= 0x80) return false;
+    req->src = FONT_SRC_EN;
+    req->offset = (ch - 0x20) * font->size_EN;
+    req->size = font->size_EN;
+    return true;
+}
+
+// GBK fonts, gb is a two-byte GB2312 code
+static bool font_locate_gb(const cFONT *font, uint16_t gb, font_req_t *req)
+{
+    unsigned char byte1 = gb >> 8, byte2 = gb & 0xFF;
+    if (byte2 < 0xA1 || byte2 > 0xFE) return false;
+    if (byte1 >= 0xA1 && byte1 <= 0xA9) {
+        // Full-width ASCII and symbol areas
+        req->src = FONT_SRC_CH_ASICC;
+        req->offset = ((byte1 - 0xA1) * 94 + (byte2 - 0xA1)) * font->size_CH;
+    } else if (byte1 >= 0xB0 && byte1 <= 0xF7) {
+        // Chinese character area
+        req->src = FONT_SRC_CH;
+        req->offset = ((byte1 - 0xB0) * 94 + (byte2 - 0xA1)) * font->size_CH;
+    } else {
+        return false;
+    }
+    req->size = font->size_CH;
+    return true;
+}
+
+static bool font_locate_unicode(const cFONT *font, uint32_t unicode, font_req_t *req)
+{
+    if (unicode < 0x80) return font_locate_ascii(font, unicode, req);
+    if (font->encoding == FONT_ENCODING_GBK) {
+        uint16_t gb = unicode_to_gb2312(unicode);
+        return gb && font_locate_gb(font, gb, req);
+    }
+
+    req->size = font->size_CH;
+    if (unicode >= 0xFF01 && unicode <= 0xFF5E) {
+        // Full-width ASCII characters
+        req->src = FONT_SRC_CH_ASICC;
+        req->offset = (unicode - 0xFF00) * font->size_CH;
+    } else if (unicode >= 0x4E00 && unicode <= 0x9FFF) {
+        // Common Chinese Character Zone
+        req->src = FONT_SRC_CH;
+        req->offset = (unicode - 0x4E00) * font->size_CH;
+    } else {
+        // Other symbols come from the GBK symbol file
+        uint16_t gb = unicode_to_gb2312(unicode);
+        unsigned char byte1 = gb >> 8, byte2 = gb & 0xFF;
+        if (byte1 < 0xA1 || byte2 < 0xA1) return false;
+        req->src = FONT_SRC_SYMBOL;
+        req->offset = ((byte1 - 0xA1) * 94 + (byte2 - 0xA1)) * font->size_CH;
+    }
+    return true;
+}
+
+static bool font_src_embedded(const cFONT *font, uint8_t src, const uint8_t **data, size_t *size)
+{
+    switch (src) {
+    case FONT_SRC_EN:
+        return get_embedded_font_data((cFONT *)font, "EN", data, size);
+    case FONT_SRC_CH:
+        return get_embedded_font_data((cFONT *)font, "CH", data, size);
+    case FONT_SRC_CH_ASICC:
+        return get_embedded_font_data((cFONT *)font, "CH_ASICC", data, size);
+    default: {
+        cFONT gbk = *font;
+        gbk.encoding = FONT_ENCODING_GBK;
+        return get_embedded_font_data(&gbk, "CH_ASICC", data, size);
+    }
+    }
+}
+
+#if FONT_FILE_FALLBACK
+static const char *font_src_path(const cFONT *font, uint8_t src)
+{
+    switch (src) {
+    case FONT_SRC_EN:       return font->font_name_EN;
+    case FONT_SRC_CH:       return font->font_name_CH;
+    case FONT_SRC_CH_ASICC: return font->font_name_CH_ASICC;
+    default:
+        switch (font->size_CH) {
+        case font12_size_CH: return GBK_Font12CH_ASICC;
+        case font16_size_CH: return GBK_Font16CH_ASICC;
+        case font18_size_CH: return GBK_Font18CH_ASICC;
+        case font24_size_CH: return GBK_Font24CH_ASICC;
+        case font28_size_CH: return GBK_Font28CH_ASICC;
+        case font36_size_CH: return GBK_Font36CH_ASICC;
+        case font48_size_CH: return GBK_Font48CH_ASICC;
+        default:             return font->font_name_CH_ASICC;
         }
-        
-        font_offset = ((unsigned char)character[0] - 0x20) * font->size_EN;
-        
-        // Try using embedded data
-        const uint8_t* embedded_data = NULL;
-        size_t embedded_size = 0;
-        
-        if (get_embedded_font_data(font, "EN", &embedded_data, &embedded_size)) {
-            if (font_offset + font->size_EN <= embedded_size) {
-                memcpy(buffer, embedded_data + font_offset, font->size_EN);
-                // ESP_LOGD(TAG, "Read embedded ASCII characters: '%c'(0x%02X), offset=%lu", character[0], (unsigned char)character[0], (unsigned long)font_offset);
-                return font->size_EN;
+    }
+}
+#endif
+
+static int font_req_cmp(const void *a, const void *b)
+{
+    const font_req_t *x = a, *y = b;
+    if (x->src != y->src) return x->src - y->src;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+/*
+ * Fetch a set of located glyphs. Requests are sorted by file and offset,
+ * served from embedded data when the font is built in, else read from the
+ * card through the shared handles: the same glyph is read once and glyphs
+ * closer than FONT_MERGE_GAP are merged into one read of up to FONT_READ_MAX.
+ */
+static int font_fetch(const cFONT *font, font_req_t *reqs, int n, unsigned char *const *out, int *len)
+{
+    int found = 0;
+
+    if (n > 1) qsort(reqs, n, sizeof(reqs[0]), font_req_cmp);
+
+    for (int i = 0; i < n; ) {
+        uint8_t src = reqs[i].src;
+        int end = i;
+        while (end < n && reqs[end].src == src) end++;
+
+        const uint8_t *data = NULL;
+        size_t size = 0;
+        bool embedded = font_src_embedded(font, src, &data, &size);
+        int missing = 0;
+        for (int k = i; k < end; k++) {
+            if (embedded && read_embedded_glyph(data, size, reqs[k].offset, out[reqs[k].index], reqs[k].size)) {
+                len[reqs[k].index] = reqs[k].size;
+                found++;
             } else {
-                // ESP_LOGE(TAG, "The embedded ASCII character offset is out of range");
+                reqs[i + missing++] = reqs[k];     // Still sorted, left for the file
             }
         }
 
-#if defined(CONFIG_FONT_ENABLE_SDCARD) || defined(CONFIG_FONT_ENABLE_TFCARD)
-        file = fopen(font->font_name_EN, "rb");
-        if (!file) {
-            ESP_LOGE(TAG, "The English font file cannot be opened: %s", font->font_name_EN);
-            return -1;
-        }
-        
-        fseek(file, font_offset, SEEK_SET);
-        size_t read_size = fread(buffer, 1, font->size_EN, file);
-        fclose(file);
-        
-        if (read_size != font->size_EN) {
-            // ESP_LOGE(TAG, "Failed to read ASCII character data");
-            return -1;
+#if FONT_FILE_FALLBACK
+        _lock_acquire(&font_file_lock);
+        font_file_t *h = missing ? font_file_get(font_src_path(font, src)) : NULL;
+        if (h && !font_read_buf) {
+            font_read_buf = heap_caps_malloc(FONT_READ_MAX, MALLOC_CAP_SPIRAM);
+            if (!font_read_buf) font_read_buf = malloc(FONT_READ_MAX);
         }
-        // ESP_LOGD(TAG, "Read the ASCII characters of the file: '%c'(0x%02X), offset=%lu", character[0], (unsigned char)character[0], (unsigned long)font_offset);
-        return font->size_EN;
-#else
-        // ESP_LOGE(TAG, "The font embedding failed and file rollback was disabled");
-        return -1;
-#endif
-    }
-    const char* font_file = NULL;
-    const char* file_type = NULL;
-    
-    if (font->encoding == FONT_ENCODING_UTF8) {
-        // UTF-8
-        int char_len_check = 0;
-        uint32_t unicode = UTF8_To_Unicode(character, &char_len_check);
-        
-        if (unicode >= 0xFF01 && unicode <= 0xFF5E) {
-            // Full-width ASCII characters
-            font_offset = (unicode - 0xFF00) * font->size_CH;
-            font_file = font->font_name_CH_ASICC;
-            file_type = "CH_ASICC";
-            // ESP_LOGD(TAG, "UTF-8 full-width ASCII: unicode=0x%04X", (unsigned int)unicode);
-            
-        } else if (unicode >= 0x4E00 && unicode <= 0x9FFF) {
-            // Common Chinese Character Zone
-            font_offset = (unicode - 0x4E00) * font->size_CH;
-            font_file = font->font_name_CH;
-            file_type = "CH";
-            // ESP_LOGD(TAG, "UTF-8 Chinese characters: unicode=0x%04X", (unsigned int)unicode);
-            
-        } else {
-            // ESP_LOGW(TAG, "UTF-8 characters are beyond the supported range: unicode=0x%04X", (unsigned int)unicode);
-            extern uint16_t utf8_char_to_gb2312(const char* utf8_char, int* char_len);
-            int char_len_tmp = 0;
-            uint16_t gb_code = utf8_char_to_gb2312(character, &char_len_tmp);
-            if (gb_code != 0) {
-                unsigned char byte1 = (gb_code >> 8) & 0xFF;
-                unsigned char byte2 = gb_code & 0xFF;
-                uint32_t gb_code_offset = ((byte1 - 0xA1) * 94 + (byte2 - 0xA1));
-                font_offset = gb_code_offset * font->size_CH;
-
-                switch (font->size_CH) {
-                    case font12_size_CH: font_file = GBK_Font12CH_ASICC; break;
-                    case font16_size_CH: font_file = GBK_Font16CH_ASICC; break;
-                    case font18_size_CH: font_file = GBK_Font18CH_ASICC; break;
-                    case font24_size_CH: font_file = GBK_Font24CH_ASICC; break;
-                    case font28_size_CH: font_file = GBK_Font28CH_ASICC; break;
-                    case font36_size_CH: font_file = GBK_Font36CH_ASICC; break;
-                    case font48_size_CH: font_file = GBK_Font48CH_ASICC; break;
-                    default: font_file = font->font_name_CH_ASICC; break;
-                }
-                file_type = "CH_ASICC";
-
-                const uint8_t* embedded_data = NULL;
-                size_t embedded_size = 0;
-                
-                if (font->size_CH == font18_size_CH && 
-                    get_embedded_font_data(&Font18_GBK, file_type, &embedded_data, &embedded_size)) {
-                    if (font_offset + font->size_CH <= embedded_size) {
-                        memcpy(buffer, embedded_data + font_offset, font->size_CH);
-                        // ESP_LOGD(TAG, "Embedded special symbols: UTF-8->GB2312: 0x%04X, offset=%lu", gb_code, (unsigned long)font_offset);
-                        return font->size_CH;
+        for (int k = i; h && font_read_buf && k < i + missing; ) {
+            // A failed read of the previous run closed the handle
+            if (!h->file && !(h = font_file_get(font_src_path(font, src)))) break;
+
+            // Extend the run while the next glyph is close and still fits the buffer
+            uint32_t start = reqs[k].offset, stop = start + reqs[k].size;
+            int last = k + 1;
+            while (last < i + missing && reqs[last].offset <= stop + FONT_MERGE_GAP &&
+                   reqs[last].offset + reqs[last].size - start <= FONT_READ_MAX) {
+                if (reqs[last].offset + reqs[last].size > stop) stop = reqs[last].offset + reqs[last].size;
+                last++;
+            }
+            if (stop - start > FONT_READ_MAX || !font_file_read(h, start, font_read_buf, stop - start)) {
+                // Too big for the buffer, or the run runs past the end of the file: one glyph at a time
+                for (; k < last; k++) {
+                    if (!h->file) h = font_file_get(font_src_path(font, src));
+                    if (h && font_file_read(h, reqs[k].offset, out[reqs[k].index], reqs[k].size)) {
+                        len[reqs[k].index] = reqs[k].size;
+                        found++;
                     }
+                    if (!h) break;
                 }
-                
-#if defined(CONFIG_FONT_ENABLE_SDCARD) || defined(CONFIG_FONT_ENABLE_TFCARD)
-                file = fopen(font_file, "rb");
-                if (!file) {
-                    // ESP_LOGE(TAG, "The symbol font file cannot be opened: %s", font_file);
-                    return -1;
-                }
-                fseek(file, font_offset, SEEK_SET);
-                size_t read_size = fread(buffer, 1, font->size_CH, file);
-                fclose(file);
-                if (read_size != font->size_CH) {
-                    // ESP_LOGE(TAG, "Failed to read the symbol font data");
-                    return -1;
-                }
-                // ESP_LOGD(TAG, "Special symbols for documents: UTF-8->GB2312: 0x%04X, offset=%lu", gb_code, (unsigned long)font_offset);
-                return font->size_CH;
-#endif
+                k = last;
+                continue;
+            }
+            for (; k < last; k++) {
+                memcpy(out[reqs[k].index], font_read_buf + (reqs[k].offset - start), reqs[k].size);
+                len[reqs[k].index] = reqs[k].size;
+                found++;
             }
-            return -1;
-        }
-        
-    } else {
-        // GBK/GB2312
-        unsigned char byte1 = (unsigned char)character[0];
-        unsigned char byte2 = (unsigned char)character[1];
-        
-        if (byte1 >= 0xA1 && byte1 <= 0xA9 && byte2 >= 0xA1 && byte2 <= 0xFE) {
-            // Full-width ASCII and symbol areas
-            uint32_t gb_code = ((byte1 - 0xA1) * 94 + (byte2 - 0xA1));
-            font_offset = gb_code * font->size_CH;
-            font_file = font->font_name_CH_ASICC;
-            file_type = "CH_ASICC";
-            // ESP_LOGD(TAG, "GBK full-width characters: 0x%02X%02X, code=%lu", byte1, byte2, (unsigned long)gb_code);
-            
-        } else if (byte1 >= 0xB0 && byte1 <= 0xF7 && byte2 >= 0xA1 && byte2 <= 0xFE) {
-            // Chinese character area
-            uint32_t gb_code = ((byte1 - 0xB0) * 94 + (byte2 - 0xA1));
-            font_offset = gb_code * font->size_CH;
-            font_file = font->font_name_CH;
-            file_type = "CH";
-            // ESP_LOGD(TAG, "Chinese character area: 0x%02X%02X, code=%lu", byte1, byte2, (unsigned long)gb_code);
-            
-        } else {
-            // ESP_LOGW(TAG, "The GBK characters are beyond the valid range: 0x%02X%02X", byte1, byte2);
-            return -1;
         }
+        _lock_release(&font_file_lock);
+#else
+        (void)missing;
+#endif
+        i = end;
     }
-    
-    // Try embedded data
-    const uint8_t* embedded_data = NULL;
-    size_t embedded_size = 0;
-    
-    if (get_embedded_font_data(font, file_type, &embedded_data, &embedded_size)) {
-        if (font_offset + font->size_CH <= embedded_size) {
-            memcpy(buffer, embedded_data + font_offset, font->size_CH);
-            ESP_LOGD(TAG, "Embedded character reading successful: encoding =%s, offset=%lu, size=%d", (font->encoding == FONT_ENCODING_UTF8) ? "UTF-8" : "GBK", (unsigned long)font_offset, font->size_CH);
-            return font->size_CH;
-        }
+    return found;
+}
+
+/******************************************************************************
+function: Fetch the glyphs of a run of characters at once
+parameter:
+    font       : Font
+    codepoints : Unicode code points, also for GBK fonts
+    n          : Number of code points
+    out        : out[i] receives the glyph of codepoints[i], size_EN bytes for
+                 ASCII, size_CH otherwise; the same buffer may be given twice
+    len        : len[i] is set to the glyph size, or -1 when there is no glyph
+info:
+    Returns the number of glyphs found. Meant for whole lines: repeated
+    characters are read once and the reads are sorted and merged, through
+    file handles kept open between calls.
+******************************************************************************/
+int Font_FetchGlyphs(cFONT* font, const uint32_t* codepoints, int n, unsigned char* const* out, int* len)
+{
+    font_req_t stack_reqs[FONT_BATCH_MAX];
+    font_req_t *reqs = stack_reqs;
+    int count = 0;
+
+    if (!font || !codepoints || !out || !len || n <= 0) return 0;
+    if (n > FONT_BATCH_MAX) {
+        reqs = malloc((size_t)n * sizeof(font_req_t));
+        if (!reqs) return 0;
     }
-    
-#if defined(CONFIG_FONT_ENABLE_SDCARD) || defined(CONFIG_FONT_ENABLE_TFCARD)
-    file = fopen(font_file, "rb");
-    if (!file) {
-        ESP_LOGE(TAG, "The font file cannot be opened: %s", font_file);
-        return -1;
+    for (int i = 0; i < n; i++) {
+        len[i] = -1;
+        if (font_locate_unicode(font, codepoints[i], &reqs[count])) {
+            reqs[count].index = (uint16_t)i;
+            count++;
+        }
     }
-    
-    fseek(file, font_offset, SEEK_SET);
-    size_t read_size = fread(buffer, 1, font->size_CH, file);
-    fclose(file);
-    
-    if (read_size != font->size_CH) {
-        ESP_LOGE(TAG, "Failed to read character data");
-        return -1;
+    TRACE_BEGIN_ARG(FONT_FETCH, count);
+    int found = font_fetch(font, reqs, count, out, len);
+    TRACE_END(FONT_FETCH);
+    if (reqs != stack_reqs) free(reqs);
+    return found;
+}
+
+// Embedded font support
+int Get_Char_Font_Data(cFONT* font, const char* character, unsigned char* buffer)
+{
+    font_req_t req;
+    int len = -1;
+    bool ok;
+
+    // Determine the character encoding and locate its glyph
+    if ((unsigned char)character[0] < 0x80) {
+        ok = font_locate_ascii(font, (unsigned char)character[0], &req);
+    } else if (font->encoding == FONT_ENCODING_UTF8) {
+        int char_len = 0;
+        ok = font_locate_unicode(font, UTF8_To_Unicode(character, &char_len), &req);
+    } else { // GBK/GB2312
+        ok = font_locate_gb(font, (uint16_t)(((unsigned char)character[0] << 8) | (unsigned char)character[1]), &req);
     }
-    
-    // ESP_LOGD(TAG, "File character reading successful: encoding =%s, offset=%lu, size=%d", (font->encoding == FONT_ENCODING_UTF8) ? "UTF-8" : "GBK", (unsigned long)font_offset, font->size_CH);
-    return font->size_CH;
-#else
-    // ESP_LOGE(TAG, "The font embedding failed and file rollback was disabled");
-    return -1;
-#endif
+    if (!ok) return -1;
+
+    req.index = 0;
+    font_fetch(font, &req, 1, &buffer, &len);
+    return len;
 }
 
 // ASCII font data acquisition function
@@ -729,7 +979,6 @@ static bool get_embedded_font_data_ASCII(sFONT* font, const uint8_t** data_start
 // Obtain the font data of a single ASCII character
 int Get_Char_Font_Data_ASCII(sFONT* font, const char* character, unsigned char* buffer)
 {
-    FILE* file = NULL;
     uint32_t font_offset = 0;
     unsigned char ch;
     const uint8_t* embedded_data = NULL;
@@ -748,8 +997,7 @@ int Get_Char_Font_Data_ASCII(sFONT* font, const char* character, unsigned char*
 
     font_offset = (uint32_t)(ch - 0x20) * (uint32_t)font->size;
     if (get_embedded_font_data_ASCII(font, &embedded_data, &embedded_size)) {
-        if ((size_t)font_offset + (size_t)font->size <= embedded_size) {
-            memcpy(buffer, embedded_data + font_offset, font->size);
+        if (read_embedded_glyph(embedded_data, embedded_size, font_offset, buffer, font->size)) {
             // ESP_LOGD(TAG, "Read embedded ASCII characters: '%c'(0x%02X), offset=%u", ch, ch, (unsigned)font_offset);
             return (int)font->size;
         } else {
@@ -759,21 +1007,13 @@ int Get_Char_Font_Data_ASCII(sFONT* font, const char* character, unsigned char*
         // ESP_LOGD(TAG, "The embedded ASCII font was not found. Try file rollback");
     }
 
-#if defined(CONFIG_FONT_ENABLE_SDCARD) || defined(CONFIG_FONT_ENABLE_TFCARD)
-    file = fopen(font->font_name, "rb");
-    if (!file) {
-        ESP_LOGE(TAG, "The English font file cannot be opened: %s", font->font_name);
-        return -1;
-    }
-    if (fseek(file, (long)font_offset, SEEK_SET) != 0) {
-        ESP_LOGE(TAG, "fseek failed: %s offset=%u", font->font_name, (unsigned)font_offset);
-        fclose(file);
-        return -1;
-    }
-    size_t read_size = fread(buffer, 1, font->size, file);
-    fclose(file);
-    if (read_size != (size_t)font->size) {
-        ESP_LOGE(TAG, "Failed to read ASCII character data: read=%u expected=%u", (unsigned)read_size, (unsigned)font->size);
+#if FONT_FILE_FALLBACK
+    _lock_acquire(&font_file_lock);
+    font_file_t *h = font_file_get(font->font_name);
+    bool ok = h && font_file_read(h, font_offset, buffer, font->size);
+    _lock_release(&font_file_lock);
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to read ASCII character data: %s offset=%u", font->font_name, (unsigned)font_offset);
         return -1;
     }
     // ESP_LOGD(TAG, "Read ASCII characters from the file: '%c'(0x%02X), offset=%u", ch, ch, (unsigned)font_offset);
@@ -819,6 +1059,77 @@ uint32_t UTF8_To_Unicode(const char* utf8_char, int* char_len)
     return unicode;
 }
 
+// GBK/GB2312 To Unicode, 0 if the code has no mapping
+uint32_t GBK_To_Unicode(const char* gbk_char)
+{
+    unsigned char byte1 = (unsigned char)gbk_char[0];
+    if (byte1 < 0x80) return byte1;
+    return gb2312_to_unicode((uint16_t)((byte1 << 8) | (unsigned char)gbk_char[1]));
+}
+
+// Pen advance of a character; English glyphs use the proportional metrics when the font has them
+int Font_Advance(const cFONT* font, uint32_t codepoint)
+{
+    const FONT_METRICS *m = font->metrics_EN;
+    if (codepoint >= 0x80) return font->Width_CH;
+    if (!m || !m->advance || codepoint < FONT_METRICS_FIRST ||
+        codepoint >= FONT_METRICS_FIRST + FONT_METRICS_COUNT)
+        return font->Width_EN;
+    return m->advance[codepoint - FONT_METRICS_FIRST];
+}
+
+// Where the glyph cell starts relative to the pen
+int Font_Bearing(const cFONT* font, uint32_t codepoint)
+{
+    const FONT_METRICS *m = font->metrics_EN;
+    if (!m || !m->bearing || codepoint < FONT_METRICS_FIRST ||
+        codepoint >= FONT_METRICS_FIRST + FONT_METRICS_COUNT)
+        return 0;
+    return m->bearing[codepoint - FONT_METRICS_FIRST];
+}
+
+// Pen adjustment between two English characters, 0 if the pair is not kerned
+int Font_Kerning(const cFONT* font, uint32_t left, uint32_t right)
+{
+    const FONT_METRICS *m = font->metrics_EN;
+    if (!m || !m->kern || left >= 0x80 || right >= 0x80) return 0;
+
+    uint16_t key = (uint16_t)((left << 8) | right);
+    int lo = 0, hi = m->kern_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        uint16_t k = (uint16_t)((m->kern[mid].left << 8) | m->kern[mid].right);
+        if (k == key) return m->kern[mid].adjust;
+        if (k < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return 0;
+}
+
+// Width of a string drawn in one line by Paint_DrawString_CN
+int Font_TextWidth(const cFONT* font, const char* str)
+{
+    int width = 0;
+    uint32_t prev = 0;
+
+    while (*str != '\0') {
+        int char_len;
+        uint32_t cp;
+        if (font->encoding == FONT_ENCODING_UTF8) {
+            cp = UTF8_To_Unicode(str, &char_len);
+        } else {
+            char_len = ((unsigned char)*str < 0x80) ? 1 : 2;
+            cp = GBK_To_Unicode(str);
+        }
+        // Paint_DrawString_CN drops a sequence cut short by the end of the string
+        if (strnlen(str, char_len) < (size_t)char_len) break;
+        width += Font_Kerning(font, prev, cp) + Font_Advance(font, cp);
+        prev = cp;
+        str += char_len;
+    }
+    return width;
+}
+
 // The computing center displays the location
 uint16_t reassignCoordinates_EN(uint16_t x,const char *str,sFONT* Font)
 {
@@ -831,28 +1142,7 @@ uint16_t reassignCoordinates_EN(uint16_t x,const char *str,sFONT* Font)
 
 uint16_t reassignCoordinates_CH(uint16_t x, const char *str, cFONT* font)
 {
-    uint16_t x_or;
-    uint16_t len = 0;
-    uint16_t str_len = 0;
-    uint16_t char_len = 0;
-    const char* p = str;
-    while (*p != '\0')
-    {
-        if (font->encoding == FONT_ENCODING_UTF8) {
-            char_len = Get_UTF8_Char_Length((unsigned char)*p);
-        } else {
-            char_len = (*p < 0x80) ? 1 : 2;
-        }
-        len = len + char_len;
-        p += char_len;
-        if(char_len == 1) {
-            str_len = str_len + font->Width_EN;
-        } else {
-            str_len = str_len + font->Width_CH;
-        }
-    }
-    x_or = x - str_len/2;
-    return x_or;
+    return x - Font_TextWidth(font, str) / 2;
 }
 
 
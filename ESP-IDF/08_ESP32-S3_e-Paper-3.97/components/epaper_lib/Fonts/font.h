@@ -12,6 +12,25 @@ typedef enum {
     FONT_ENCODING_GBK = 1
 } FONT_ENCODING_TYPE;
 
+// Proportional metrics of the English glyphs, indexed by character - FONT_METRICS_FIRST
+#define FONT_METRICS_FIRST      0x20
+#define FONT_METRICS_COUNT      95
+
+typedef struct
+{
+    uint8_t left;                  // Character on the left
+    uint8_t right;                 // Character on the right
+    int8_t adjust;                 // Added to the pen before the right character
+}FONT_KERN;
+
+typedef struct
+{
+    const uint8_t *advance;        // Pen advance of each glyph, NULL for Width_EN
+    const int8_t *bearing;         // Start of the glyph cell relative to the pen, NULL for 0
+    const FONT_KERN *kern;         // Kerning pairs sorted by left, then right
+    uint16_t kern_count;
+}FONT_METRICS;
+
 // Font structure definition
 typedef struct
 {
@@ -25,6 +44,7 @@ typedef struct
     uint16_t size_EN;              // The number of English character bytes
     uint16_t size_CH;              // The number of Chinese character bytes
     FONT_ENCODING_TYPE encoding;   // encoding type
+    const FONT_METRICS *metrics_EN; // Proportional English metrics, NULL for fixed width
 }cFONT;
 
 // Font structure definition
@@ -204,6 +224,12 @@ extern const uint8_t font182EN_fon_end[] asm("_binary_font182EN_FON_end");
 #define GBK_Font48CH            "/sdcard/font/GBK/font48CH.FON"
 #define GBK_Font48CH_ASICC      "/sdcard/font/GBK/font48CH_ASICC.FON"
 
+// Glyph fetching from the card
+#define FONT_FILE_HANDLES       3       // Font files kept open, the card allows 5 handles in all
+#define FONT_READ_MAX           4096    // Largest single read when merging glyphs
+#define FONT_MERGE_GAP          512     // Glyphs closer than this are read together
+#define FONT_BATCH_MAX          32      // Code points per Font_FetchGlyphs call without a heap allocation
+
 // Font size definition
 #define font12_Width_EN         8
 #define font12_Width_CH         16
@@ -255,6 +281,15 @@ extern const uint8_t font182EN_fon_end[] asm("_binary_font182EN_FON_end");
 #define font182_Height          182
 #define font182_size_EN         (font182_Width_EN * font182_Height / 8)
 
+// Proportional metrics generated by tools/font_metrics.py
+extern const FONT_METRICS Font12_Metrics;
+extern const FONT_METRICS Font16_Metrics;
+extern const FONT_METRICS Font18_Metrics;
+extern const FONT_METRICS Font24_Metrics;
+extern const FONT_METRICS Font28_Metrics;
+extern const FONT_METRICS Font36_Metrics;
+extern const FONT_METRICS Font48_Metrics;
+
 // Predefined font sample declaration
 extern cFONT Font12_UTF8;
 extern cFONT Font16_UTF8;
@@ -290,11 +325,19 @@ extern "C" {
 // Font reading function declaration
 int Get_Char_Font_Data(cFONT* font, const char* character, unsigned char* buffer);
 int Get_Char_Font_Data_ASCII(sFONT* font, const char* character, unsigned char* buffer);
+int Font_FetchGlyphs(cFONT* font, const uint32_t* codepoints, int n, unsigned char* const* out, int* len);
+void Font_CloseFiles(void);
 int Get_UTF8_Char_Length(unsigned char first_byte);
 uint32_t UTF8_To_Unicode(const char* utf8_char, int* char_len);
 uint32_t GBK_To_Unicode(const char* gbk_char);
 void Debug_Print_String_Font(cFONT* font, const char *str);
 
+// Text layout, CJK glyphs keep their cell width
+int Font_Advance(const cFONT* font, uint32_t codepoint);
+int Font_Bearing(const cFONT* font, uint32_t codepoint);
+int Font_Kerning(const cFONT* font, uint32_t left, uint32_t right);
+int Font_TextWidth(const cFONT* font, const char* str);
+
 // Compatible with older versions of the function
 void Get_Str_Font(cFONT* font, const char *str);
 
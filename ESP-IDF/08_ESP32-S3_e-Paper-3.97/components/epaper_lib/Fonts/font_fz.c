@@ -0,0 +1,85 @@
+#include <string.h>
+#include "font_fz.h"
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool font_fz_open(font_fz_t *fz, const uint8_t *blob, size_t size)
+{
+    if (size < FONT_FZ_HEADER_SIZE || memcmp(blob, FONT_FZ_MAGIC, 4) != 0) return false;
+
+    fz->glyph_size = rd16(blob + 4);
+    fz->row_bytes = rd16(blob + 6);
+    fz->block_glyphs = rd16(blob + 8);
+    fz->glyph_count = rd32(blob + 12);
+    fz->block_count = rd32(blob + 16);
+    if (fz->glyph_size == 0 || fz->row_bytes == 0 || fz->block_glyphs == 0) return false;
+
+    size_t table = (size_t)(fz->block_count + 1) * 4;
+    if (FONT_FZ_HEADER_SIZE + table > size) return false;
+    fz->offsets = blob + FONT_FZ_HEADER_SIZE;
+    fz->data = fz->offsets + table;
+    return rd32(fz->offsets + fz->block_count * 4) <= size - FONT_FZ_HEADER_SIZE - table;
+}
+
+uint16_t font_fz_block_glyphs(const font_fz_t *fz, uint32_t block)
+{
+    uint32_t first = block * fz->block_glyphs;
+    if (first >= fz->glyph_count) return 0;
+    uint32_t left = fz->glyph_count - first;
+    return (left < fz->block_glyphs) ? (uint16_t)left : fz->block_glyphs;
+}
+
+int font_fz_decode_block(const font_fz_t *fz, uint32_t block, uint8_t *out)
+{
+    if (block >= fz->block_count) return -1;
+
+    // font_fz_open() checked the last offset against the blob, the others are checked here
+    uint32_t start = rd32(fz->offsets + block * 4);
+    uint32_t end = rd32(fz->offsets + (block + 1) * 4);
+    if (start > end || end > rd32(fz->offsets + fz->block_count * 4)) return -1;
+
+    const uint8_t *src = fz->data + start;
+    const uint8_t *src_end = fz->data + end;
+    size_t length = (size_t)font_fz_block_glyphs(fz, block) * fz->glyph_size;
+    size_t pos = 0;
+
+    // Zero-group mask coding, see tools/font_pack.py
+    while (pos < length) {
+        if (src >= src_end) return -1;
+        uint8_t mask = *src++;
+        if (mask == 0) {
+            if (src >= src_end) return -1;
+            size_t zeros = ((size_t)*src++ + 1) * 8;
+            if (zeros > length - pos) zeros = length - pos;
+            memset(out + pos, 0, zeros);
+            pos += zeros;
+            continue;
+        }
+        for (int bit = 0x80; bit && pos < length; bit >>= 1) {
+            if (mask & bit) {
+                if (src >= src_end) return -1;
+                out[pos++] = *src++;
+            } else {
+                out[pos++] = 0;
+            }
+        }
+    }
+
+    // Undo the row XOR, top to bottom
+    uint16_t rb = fz->row_bytes;
+    for (size_t g = 0; g < length; g += fz->glyph_size) {
+        uint8_t *glyph = out + g;
+        for (size_t i = rb; i < fz->glyph_size; i++) {
+            glyph[i] ^= glyph[i - rb];
+        }
+    }
+    return (int)length;
+}
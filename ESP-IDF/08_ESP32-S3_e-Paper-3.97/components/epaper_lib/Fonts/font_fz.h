@@ -0,0 +1,40 @@
+#ifndef __FONT_FZ_H_
+#define __FONT_FZ_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Compressed font container written by tools/font_pack.py
+#define FONT_FZ_MAGIC           "FZ1"
+#define FONT_FZ_HEADER_SIZE     20
+#define FONT_FZ_CACHE_BLOCKS    4       // Decoded blocks kept in PSRAM
+
+typedef struct {
+    const uint8_t *offsets;     // block_count + 1 little-endian u32
+    const uint8_t *data;        // Compressed blocks
+    uint16_t glyph_size;
+    uint16_t row_bytes;
+    uint16_t block_glyphs;
+    uint32_t glyph_count;
+    uint32_t block_count;
+} font_fz_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parse the header of an embedded container, false if it is a plain .FON
+bool font_fz_open(font_fz_t *fz, const uint8_t *blob, size_t size);
+
+// Number of glyphs in a block, the last one may be short
+uint16_t font_fz_block_glyphs(const font_fz_t *fz, uint32_t block);
+
+// Decode one block into out (block_glyphs * glyph_size bytes), returns the bytes written or -1
+int font_fz_decode_block(const font_fz_t *fz, uint32_t block, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
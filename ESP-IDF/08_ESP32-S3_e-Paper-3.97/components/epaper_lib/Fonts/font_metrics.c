@@ -0,0 +1,351 @@
+/* Generated by tools/font_metrics.py, do not edit */
+#include "font.h"
+
+static const uint8_t font12_advance[FONT_METRICS_COUNT] = {
+      5,   4,   6,   8,   8,   8,   8,   3,   5,   6,   8,   8,   4,   8,   4,   8,
+      8,   8,   8,   8,   8,   8,   8,   8,   8,   8,   4,   4,   8,   8,   8,   8,
+      8,   8,   8,   8,   8,   8,   8,   8,   8,   4,   8,   8,   8,   8,   8,   8,
+      8,   8,   8,   8,   8,   8,   8,   8,   8,   8,   8,   6,   8,   6,   6,   8,
+      6,   8,   8,   8,   8,   8,   8,   8,   8,   4,   7,   8,   4,   8,   8,   8,
+      8,   8,   6,   8,   8,   8,   8,   8,   8,   8,   8,   5,   4,   5,   8,
+};
+
+static const int8_t font12_bearing[FONT_METRICS_COUNT] = {
+      0,  -2,  -1,   0,   0,   0,   0,  -2,  -3,   1,   0,   0,   0,   0,   0,   0,
+      0,   1,   0,   0,   0,   0,  -1,   0,   0,   0,  -2,  -2,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,  -2,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -2,   0,   0,  -1,   0,
+     -1,   0,   0,   0,   0,   0,   0,   0,   0,  -2,   0,   0,  -2,   0,   0,   0,
+      0,   0,  -1,   0,   0,   0,   0,   0,   0,   0,   0,  -3,  -2,   0,   0,
+};
+
+static const FONT_KERN font12_kern[] = {
+    {'"', 'J', -1}, {'"', 'a', -1}, {'"', 'c', -1}, {'"', 'e', -1}, {'"', 'g', -1}, {'"', 'j', -1},
+    {'"', 'o', -1}, {'"', 's', -1}, {'\'', 'J', -1}, {'\'', 'j', -1}, {',', 'T', -1}, {',', 'V', -1},
+    {',', 'Y', -1}, {',', 'f', -1}, {',', 't', -1}, {'-', 'T', -1}, {'-', 'j', -1}, {'.', 'T', -1},
+    {'.', 'V', -1}, {'.', 'Y', -1}, {'.', 'f', -1}, {'.', 't', -1}, {':', 'T', -1}, {';', 'T', -1},
+    {'B', 'j', -1}, {'C', 'j', -1}, {'D', 'j', -1}, {'F', ',', -1}, {'F', '.', -1}, {'F', 'j', -1},
+    {'J', 'j', -1}, {'L', '"', -1}, {'L', '\'', -1}, {'L', '-', -1}, {'L', 'T', -1}, {'L', 'V', -1},
+    {'L', 'Y', -1}, {'L', 'f', -1}, {'L', 't', -1}, {'O', 'j', -1}, {'P', ',', -1}, {'P', '.', -1},
+    {'P', 'j', -1}, {'S', 'j', -1}, {'T', ',', -1}, {'T', '.', -1}, {'T', ':', -1}, {'T', ';', -1},
+    {'T', 'J', -1}, {'T', 'a', -1}, {'T', 'c', -1}, {'T', 'd', -1}, {'T', 'e', -1}, {'T', 'f', -1},
+    {'T', 'g', -1}, {'T', 'j', -1}, {'T', 'n', -1}, {'T', 'o', -1}, {'T', 'p', -1}, {'T', 'q', -1},
+    {'T', 'r', -1}, {'T', 's', -1}, {'T', 'u', -1}, {'T', 'v', -1}, {'T', 'x', -1}, {'T', 'y', -1},
+    {'T', 'z', -1}, {'U', 'j', -1}, {'V', ',', -1}, {'V', '.', -1}, {'V', 'j', -1}, {'Y', ',', -1},
+    {'Y', '.', -1}, {'Y', 'J', -1}, {'Y', 'j', -1}, {'a', '"', -1}, {'a', 'T', -1}, {'b', '"', -1},
+    {'b', 'T', -1}, {'b', 'j', -1}, {'c', '"', -1}, {'c', 'T', -1}, {'c', 'j', -1}, {'e', '"', -1},
+    {'e', 'T', -1}, {'e', 'j', -1}, {'f', ',', -1}, {'f', '.', -1}, {'f', 'J', -1}, {'f', 'j', -1},
+    {'g', 'T', -1}, {'h', 'T', -1}, {'k', 'T', -1}, {'n', 'T', -1}, {'o', '"', -1}, {'o', 'T', -1},
+    {'o', 'j', -1}, {'p', '"', -1}, {'p', 'T', -1}, {'p', 'j', -1}, {'q', 'T', -1}, {'r', ',', -1},
+    {'r', '.', -1}, {'r', 'J', -1}, {'r', 'T', -1}, {'r', 'Z', -1}, {'r', 'j', -1}, {'s', '"', -1},
+    {'s', 'T', -1}, {'s', 'j', -1}, {'t', 'T', -1}, {'u', 'T', -1}, {'v', ',', -1}, {'v', '.', -1},
+    {'v', 'T', -1}, {'v', 'j', -1}, {'x', 'T', -1}, {'y', ',', -1}, {'y', '.', -1}, {'y', 'T', -1},
+    {'y', 'j', -1}, {'z', 'T', -1},
+};
+
+const FONT_METRICS Font12_Metrics = {
+    .advance = font12_advance,
+    .bearing = font12_bearing,
+    .kern = font12_kern,
+    .kern_count = sizeof(font12_kern) / sizeof(font12_kern[0]),
+};
+
+static const uint8_t font16_advance[FONT_METRICS_COUNT] = {
+      8,   6,  10,  16,  14,  16,  16,   4,  10,   9,  16,  16,   5,  16,   5,  16,
+     16,  16,  16,  16,  16,  16,  16,  16,  16,  16,   5,   5,  15,  16,  15,  14,
+     16,  16,  16,  16,  16,  15,  16,  15,  15,   5,  14,  16,  16,  16,  15,  16,
+     15,  16,  15,  15,  15,  15,  16,  16,  15,  16,  16,  10,  14,  10,  13,  16,
+      9,  15,  15,  15,  15,  15,  15,  16,  14,   5,  11,  14,   4,  16,  14,  16,
+     15,  15,  12,  14,  15,  14,  15,  16,  14,  15,  14,   9,   4,   9,  14,
+};
+
+static const int8_t font16_bearing[FONT_METRICS_COUNT] = {
+      0,  -5,  -3,   0,  -1,   0,   0,  -5,  -6,   0,   0,   0,  -2,   0,  -1,   0,
+      0,   1,   0,   0,   0,   0,   0,   0,   0,   0,  -5,  -5,   0,   0,   0,  -1,
+      0,   0,   0,   0,   0,  -1,   0,   0,   0,  -5,  -1,   0,   0,   0,   0,   0,
+     -1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -5,  -1,   0,  -1,   0,
+     -3,   0,   0,   0,   0,   0,   0,   0,  -1,  -5,  -2,  -1,  -6,   0,  -1,   0,
+      0,   0,  -2,  -1,   0,  -1,   0,   0,  -1,   0,  -1,  -6,  -6,  -1,  -1,
+};
+
+static const FONT_KERN font16_kern[] = {
+    {'"', 'A', -3}, {'"', 'J', -2}, {'"', 'a', -3}, {'"', 'c', -3}, {'"', 'd', -3}, {'"', 'e', -3},
+    {'"', 'g', -3}, {'"', 'j', -2}, {'"', 'o', -3}, {'"', 'q', -3}, {'"', 's', -2}, {'\'', 'A', -3},
+    {'\'', 'J', -2}, {'\'', 'a', -2}, {',', 'T', -3}, {',', 'V', -3}, {',', 'Y', -3}, {',', 'f', -3},
+    {',', 't', -3}, {',', 'v', -3}, {'-', 'T', -3}, {'-', 'X', -3}, {'-', 'Y', -3}, {'-', 'Z', -3},
+    {'.', 'T', -3}, {'.', 'V', -3}, {'.', 'Y', -3}, {'.', 'f', -3}, {'.', 't', -3}, {'.', 'v', -3},
+    {':', 'T', -3}, {';', 'T', -3}, {'A', 'T', -3}, {'A', 'V', -3}, {'A', 'Y', -3}, {'A', 'v', -3},
+    {'F', '-', -3}, {'F', 'A', -3}, {'F', 'a', -3}, {'F', 'c', -3}, {'F', 'd', -3}, {'F', 'e', -3},
+    {'F', 'f', -3}, {'F', 'g', -3}, {'F', 'o', -3}, {'F', 'p', -3}, {'F', 'q', -3}, {'F', 't', -3},
+    {'F', 'v', -3}, {'F', 'y', -3}, {'K', '-', -3}, {'K', 'f', -3}, {'K', 't', -3}, {'K', 'v', -3},
+    {'L', '-', -3}, {'L', 'T', -3}, {'L', 'V', -3}, {'L', 'Y', -3}, {'L', 'f', -3}, {'L', 't', -3},
+    {'L', 'v', -3}, {'T', '-', -3}, {'T', 'A', -3}, {'T', 'a', -3}, {'T', 'c', -3}, {'T', 'd', -3},
+    {'T', 'e', -3}, {'T', 'f', -3}, {'T', 'g', -3}, {'T', 'm', -3}, {'T', 'o', -3}, {'T', 'p', -3},
+    {'T', 'q', -3}, {'T', 't', -3}, {'T', 'v', -3}, {'T', 'w', -3}, {'T', 'y', -3}, {'V', 'A', -3},
+    {'V', 'a', -3}, {'V', 'g', -3}, {'X', '-', -3}, {'Y', '-', -3}, {'Y', 'A', -3}, {'Y', 'a', -3},
+    {'Y', 'c', -3}, {'Y', 'd', -3}, {'Y', 'e', -3}, {'Y', 'g', -3}, {'Y', 'o', -3}, {'Y', 'q', -3},
+    {'Z', '-', -3}, {'a', 'T', -3}, {'a', 'Y', -3}, {'b', 'T', -3}, {'b', 'Y', -3}, {'c', 'T', -3},
+    {'c', 'Y', -3}, {'e', 'T', -3}, {'e', 'Y', -3}, {'f', 'A', -3}, {'g', 'T', -3}, {'h', 'T', -3},
+    {'h', 'Y', -3}, {'k', 'T', -3}, {'k', 'Y', -3}, {'m', 'T', -3}, {'n', 'T', -3}, {'n', 'Y', -3},
+    {'o', 'T', -3}, {'o', 'Y', -3}, {'p', 'T', -3}, {'p', 'Y', -3}, {'q', 'T', -3}, {'r', 'T', -3},
+    {'r', 'Z', -3}, {'s', 'T', -3}, {'s', 'Y', -3}, {'t', 'T', -3}, {'t', 'Y', -3}, {'u', 'T', -3},
+    {'v', 'T', -3}, {'v', 'Z', -3}, {'w', 'T', -3}, {'x', 'T', -3}, {'y', 'T', -3}, {'y', 'Z', -3},
+    {'z', 'T', -3}, {'z', 'Y', -3},
+};
+
+const FONT_METRICS Font16_Metrics = {
+    .advance = font16_advance,
+    .bearing = font16_bearing,
+    .kern = font16_kern,
+    .kern_count = sizeof(font16_kern) / sizeof(font16_kern[0]),
+};
+
+static const uint8_t font18_advance[FONT_METRICS_COUNT] = {
+      8,   6,  10,  16,  14,  16,  16,   4,   9,   9,  16,  16,   5,  16,   5,  16,
+     16,  16,  16,  16,  16,  16,  16,  16,  16,  16,   5,   5,  15,  16,  15,  14,
+     16,  16,  16,  16,  16,  15,  16,  15,  15,   5,  14,  16,  16,  16,  15,  16,
+     15,  16,  16,  15,  15,  15,  16,  16,  16,  16,  16,  10,  14,  10,  13,  16,
+      9,  15,  15,  15,  15,  15,  15,  16,  14,   5,  11,  14,   4,  16,  14,  16,
+     15,  15,  12,  14,  15,  14,  15,  16,  14,  15,  14,   9,   4,   9,  14,
+};
+
+static const int8_t font18_bearing[FONT_METRICS_COUNT] = {
+      0,  -5,  -3,   0,  -1,   0,   0,  -5,  -6,   0,   0,   0,  -2,   0,  -1,   0,
+      0,   1,   0,   0,   0,   0,   0,   0,   0,   0,  -5,  -5,   0,   0,   0,  -1,
+      0,   0,   0,   0,   0,  -1,   0,   0,   0,  -5,  -1,   0,   0,   0,   0,   0,
+     -1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -5,  -1,   0,  -1,   0,
+     -3,   0,   0,   0,   0,   0,   0,   0,  -1,  -5,  -2,  -1,  -6,   0,  -1,   0,
+      0,   0,  -2,  -1,   0,  -1,   0,   0,  -1,   0,  -1,  -6,  -6,  -1,  -1,
+};
+
+static const FONT_KERN font18_kern[] = {
+    {'"', 'A', -3}, {'"', 'a', -3}, {'"', 'c', -3}, {'"', 'd', -3}, {'"', 'e', -3}, {'"', 'g', -3},
+    {'"', 'o', -3}, {'"', 'q', -3}, {'\'', 'A', -3}, {',', 'T', -3}, {',', 'V', -3}, {',', 'Y', -3},
+    {',', 'f', -3}, {',', 't', -3}, {',', 'v', -3}, {'-', 'T', -3}, {'-', 'X', -3}, {'-', 'Y', -3},
+    {'-', 'Z', -3}, {'.', 'T', -3}, {'.', 'V', -3}, {'.', 'Y', -3}, {'.', 'f', -3}, {'.', 't', -3},
+    {'.', 'v', -3}, {':', 'T', -3}, {';', 'T', -3}, {'A', 'T', -3}, {'A', 'V', -3}, {'A', 'Y', -3},
+    {'A', 'v', -3}, {'F', '-', -3}, {'F', 'A', -3}, {'F', 'a', -3}, {'F', 'c', -3}, {'F', 'd', -3},
+    {'F', 'e', -3}, {'F', 'f', -3}, {'F', 'g', -3}, {'F', 'o', -3}, {'F', 'p', -3}, {'F', 'q', -3},
+    {'F', 't', -3}, {'F', 'v', -3}, {'F', 'y', -3}, {'K', '-', -3}, {'K', 'f', -3}, {'K', 't', -3},
+    {'K', 'v', -3}, {'L', '-', -3}, {'L', 'T', -3}, {'L', 'V', -3}, {'L', 'Y', -3}, {'L', 'f', -3},
+    {'L', 't', -3}, {'L', 'v', -3}, {'T', '-', -3}, {'T', 'A', -3}, {'T', 'a', -3}, {'T', 'c', -3},
+    {'T', 'd', -3}, {'T', 'e', -3}, {'T', 'f', -3}, {'T', 'g', -3}, {'T', 'm', -3}, {'T', 'o', -3},
+    {'T', 'p', -3}, {'T', 'q', -3}, {'T', 't', -3}, {'T', 'v', -3}, {'T', 'w', -3}, {'T', 'y', -3},
+    {'V', 'A', -3}, {'V', 'a', -3}, {'V', 'g', -3}, {'X', '-', -3}, {'X', 'f', -3}, {'X', 't', -3},
+    {'X', 'v', -3}, {'Y', '-', -3}, {'Y', 'A', -3}, {'Y', 'a', -3}, {'Y', 'c', -3}, {'Y', 'd', -3},
+    {'Y', 'e', -3}, {'Y', 'g', -3}, {'Y', 'o', -3}, {'Y', 'q', -3}, {'Z', '-', -3}, {'a', 'T', -3},
+    {'a', 'Y', -3}, {'b', 'T', -3}, {'b', 'Y', -3}, {'c', 'T', -3}, {'c', 'Y', -3}, {'e', 'T', -3},
+    {'e', 'Y', -3}, {'f', 'A', -3}, {'g', 'T', -3}, {'h', 'T', -3}, {'h', 'Y', -3}, {'k', 'T', -3},
+    {'k', 'Y', -3}, {'m', 'T', -3}, {'n', 'T', -3}, {'n', 'Y', -3}, {'o', 'T', -3}, {'o', 'Y', -3},
+    {'p', 'T', -3}, {'p', 'Y', -3}, {'q', 'T', -3}, {'r', 'T', -3}, {'r', 'X', -3}, {'r', 'Z', -3},
+    {'s', 'T', -3}, {'s', 'Y', -3}, {'t', 'T', -3}, {'t', 'Y', -3}, {'u', 'T', -3}, {'v', 'T', -3},
+    {'v', 'X', -3}, {'v', 'Z', -3}, {'w', 'T', -3}, {'x', 'T', -3}, {'y', 'T', -3}, {'y', 'X', -3},
+    {'y', 'Z', -3}, {'z', 'T', -3},
+};
+
+const FONT_METRICS Font18_Metrics = {
+    .advance = font18_advance,
+    .bearing = font18_bearing,
+    .kern = font18_kern,
+    .kern_count = sizeof(font18_kern) / sizeof(font18_kern[0]),
+};
+
+static const uint8_t font24_advance[FONT_METRICS_COUNT] = {
+     13,   9,  16,  24,  22,  24,  24,   9,  15,  16,  24,  24,   8,  24,   8,  24,
+     24,  24,  24,  24,  24,  24,  24,  24,  24,  24,   9,   9,  24,  24,  24,  22,
+     24,  24,  24,  24,  24,  23,  24,  23,  23,   8,  23,  24,  24,  24,  23,  24,
+     24,  24,  24,  24,  23,  24,  24,  24,  24,  24,  24,  16,  22,  16,  22,  24,
+     13,  23,  23,  23,  23,  23,  23,  24,  22,   8,  17,  22,   8,  24,  22,  24,
+     23,  23,  18,  22,  24,  22,  23,  24,  23,  24,  22,  14,   8,  14,  23,
+};
+
+static const int8_t font24_bearing[FONT_METRICS_COUNT] = {
+      0,  -7,  -4,   0,   0,   0,   0,  -6,  -9,   1,   0,   0,  -2,   0,  -2,   0,
+      0,   3,   0,   0,   0,   1,  -1,   0,   0,   1,  -7,  -7,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  -1,   0,   0,   0,  -8,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -7,  -1,   0,  -1,   0,
+     -5,   0,   0,   0,   0,   0,   0,   0,  -1,  -8,  -2,  -1,  -8,   0,  -1,   0,
+      0,   0,  -3,  -1,   0,  -1,   0,   0,   0,   0,  -1,  -9,  -8,  -1,  -1,
+};
+
+static const FONT_KERN font24_kern[] = {
+    {'"', 'A', -4}, {'"', 'J', -4}, {'"', 'a', -3}, {'"', 'c', -4}, {'"', 'd', -3}, {'"', 'e', -4},
+    {'"', 'g', -4}, {'"', 'j', -3}, {'"', 'o', -4}, {'"', 'q', -3}, {'\'', 'A', -4}, {'\'', 'J', -4},
+    {',', 'T', -4}, {',', 'V', -4}, {',', 'Y', -4}, {',', 'f', -4}, {',', 't', -4}, {',', 'v', -4},
+    {'-', 'T', -4}, {'-', 'X', -4}, {'-', 'Z', -4}, {'.', 'T', -4}, {'.', 'V', -4}, {'.', 'Y', -4},
+    {'.', 'f', -4}, {'.', 't', -4}, {'.', 'v', -4}, {':', 'T', -4}, {';', 'T', -4}, {'A', 'T', -4},
+    {'A', 'V', -4}, {'A', 'Y', -4}, {'F', 'A', -4}, {'F', 'J', -4}, {'F', 'a', -4}, {'F', 'c', -4},
+    {'F', 'd', -4}, {'F', 'e', -4}, {'F', 'f', -4}, {'F', 'g', -4}, {'F', 'n', -4}, {'F', 'o', -4},
+    {'F', 'p', -4}, {'F', 'q', -4}, {'F', 's', -4}, {'F', 'u', -4}, {'F', 'v', -4}, {'F', 'x', -4},
+    {'F', 'y', -4}, {'F', 'z', -4}, {'K', '-', -4}, {'K', 'f', -4}, {'K', 'v', -4}, {'L', '-', -4},
+    {'L', 'T', -4}, {'L', 'V', -4}, {'L', 'Y', -4}, {'L', 'f', -4}, {'L', 't', -4}, {'L', 'v', -4},
+    {'T', '-', -4}, {'T', 'A', -4}, {'T', 'J', -4}, {'T', 'a', -4}, {'T', 'c', -4}, {'T', 'd', -4},
+    {'T', 'e', -4}, {'T', 'f', -4}, {'T', 'g', -4}, {'T', 'm', -4}, {'T', 'n', -4}, {'T', 'o', -4},
+    {'T', 'p', -4}, {'T', 'q', -4}, {'T', 's', -4}, {'T', 't', -4}, {'T', 'u', -4}, {'T', 'v', -4},
+    {'T', 'w', -4}, {'T', 'x', -4}, {'T', 'y', -4}, {'T', 'z', -4}, {'V', 'A', -4}, {'V', 'g', -4},
+    {'X', '-', -4}, {'Y', 'A', -4}, {'Y', 'J', -4}, {'Y', 'a', -4}, {'Y', 'c', -4}, {'Y', 'd', -4},
+    {'Y', 'e', -4}, {'Y', 'g', -4}, {'Y', 'o', -4}, {'Y', 'q', -4}, {'Y', 's', -4}, {'a', 'T', -4},
+    {'a', 'Y', -4}, {'b', 'T', -4}, {'b', 'Y', -4}, {'c', 'T', -4}, {'c', 'Y', -4}, {'e', 'T', -4},
+    {'e', 'Y', -4}, {'f', 'J', -4}, {'g', 'T', -4}, {'h', 'T', -4}, {'k', 'T', -4}, {'m', 'T', -4},
+    {'n', 'T', -4}, {'o', 'T', -4}, {'o', 'Y', -4}, {'p', 'T', -4}, {'p', 'Y', -4}, {'q', 'T', -4},
+    {'r', 'J', -4}, {'r', 'T', -4}, {'r', 'Z', -4}, {'s', 'T', -4}, {'s', 'Y', -4}, {'t', 'T', -4},
+    {'t', 'Y', -4}, {'u', 'T', -4}, {'v', 'T', -4}, {'w', 'T', -4}, {'x', 'T', -4}, {'y', 'T', -4},
+    {'y', 'Z', -4}, {'z', 'T', -4},
+};
+
+const FONT_METRICS Font24_Metrics = {
+    .advance = font24_advance,
+    .bearing = font24_bearing,
+    .kern = font24_kern,
+    .kern_count = sizeof(font24_kern) / sizeof(font24_kern[0]),
+};
+
+static const uint8_t font28_advance[FONT_METRICS_COUNT] = {
+     13,   9,  16,  24,  22,  24,  24,   9,  15,  16,  24,  24,   8,  24,   8,  24,
+     24,  24,  24,  24,  24,  24,  24,  24,  24,  24,   9,   9,  24,  24,  24,  22,
+     24,  24,  24,  24,  24,  23,  24,  23,  23,   8,  23,  24,  24,  24,  23,  24,
+     24,  24,  24,  24,  23,  24,  24,  24,  24,  24,  24,  16,  22,  16,  21,  24,
+     15,  23,  23,  23,  23,  23,  23,  24,  22,   8,  17,  23,   8,  24,  22,  24,
+     23,  23,  18,  22,  24,  22,  23,  24,  23,  24,  22,  14,   8,  14,  23,
+};
+
+static const int8_t font28_bearing[FONT_METRICS_COUNT] = {
+      0,  -7,  -4,   0,   0,   0,   0,  -6,  -9,   1,   0,   0,  -2,   0,  -2,   0,
+      0,   3,   0,   0,   0,   1,  -1,   0,   0,   1,  -7,  -7,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  -1,   0,   0,   0,  -8,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -7,  -1,   0,  -1,   0,
+     -4,   0,   0,   0,   0,   0,   0,   0,  -1,  -8,  -2,  -1,  -8,   0,  -1,   0,
+      0,   0,  -3,  -1,   0,  -1,   0,   0,   0,   0,  -1,  -9,  -8,  -1,  -1,
+};
+
+static const FONT_KERN font28_kern[] = {
+    {'"', 'A', -4}, {'"', 'J', -4}, {'"', 'a', -3}, {'"', 'c', -3}, {'"', 'e', -3}, {'"', 'g', -3},
+    {'"', 'j', -3}, {'"', 'o', -3}, {'\'', 'A', -4}, {'\'', 'J', -4}, {'\'', 'a', -3}, {'\'', 'c', -3},
+    {'\'', 'e', -3}, {'\'', 'g', -3}, {'\'', 'j', -3}, {'\'', 'o', -3}, {',', 'T', -4}, {',', 'V', -4},
+    {',', 'Y', -4}, {',', 'f', -4}, {',', 't', -4}, {',', 'v', -4}, {'-', 'T', -4}, {'-', 'X', -4},
+    {'.', 'T', -4}, {'.', 'V', -4}, {'.', 'Y', -4}, {'.', 'f', -4}, {'.', 't', -4}, {'.', 'v', -4},
+    {':', 'T', -4}, {';', 'T', -4}, {'A', 'T', -4}, {'A', 'V', -4}, {'A', 'Y', -4}, {'F', 'A', -4},
+    {'F', 'J', -4}, {'F', 'a', -4}, {'F', 'c', -4}, {'F', 'd', -4}, {'F', 'e', -4}, {'F', 'f', -4},
+    {'F', 'g', -4}, {'F', 'n', -4}, {'F', 'o', -4}, {'F', 'p', -4}, {'F', 'q', -4}, {'F', 's', -4},
+    {'F', 'u', -4}, {'F', 'v', -4}, {'F', 'x', -4}, {'F', 'y', -4}, {'F', 'z', -4}, {'K', 'f', -4},
+    {'K', 'v', -4}, {'L', '-', -4}, {'L', 'T', -4}, {'L', 'V', -4}, {'L', 'Y', -4}, {'L', 'f', -4},
+    {'L', 't', -4}, {'L', 'v', -4}, {'T', '-', -4}, {'T', 'A', -4}, {'T', 'J', -4}, {'T', 'a', -4},
+    {'T', 'c', -4}, {'T', 'd', -4}, {'T', 'e', -4}, {'T', 'f', -4}, {'T', 'g', -4}, {'T', 'm', -4},
+    {'T', 'n', -4}, {'T', 'o', -4}, {'T', 'p', -4}, {'T', 'q', -4}, {'T', 's', -4}, {'T', 't', -4},
+    {'T', 'u', -4}, {'T', 'v', -4}, {'T', 'w', -4}, {'T', 'x', -4}, {'T', 'y', -4}, {'T', 'z', -4},
+    {'V', 'A', -4}, {'V', 'g', -4}, {'Y', 'A', -4}, {'Y', 'J', -4}, {'Y', 'a', -4}, {'Y', 'c', -4},
+    {'Y', 'd', -4}, {'Y', 'e', -4}, {'Y', 'g', -4}, {'Y', 'o', -4}, {'Y', 'q', -4}, {'Y', 's', -4},
+    {'a', 'T', -4}, {'a', 'Y', -4}, {'b', 'T', -4}, {'b', 'Y', -4}, {'c', 'T', -4}, {'c', 'Y', -4},
+    {'e', 'T', -4}, {'e', 'Y', -4}, {'f', 'J', -4}, {'g', 'T', -4}, {'h', 'T', -4}, {'k', 'T', -4},
+    {'m', 'T', -4}, {'n', 'T', -4}, {'o', 'T', -4}, {'o', 'Y', -4}, {'p', 'T', -4}, {'p', 'Y', -4},
+    {'q', 'T', -4}, {'r', 'T', -4}, {'r', 'Z', -4}, {'s', 'T', -4}, {'s', 'Y', -4}, {'t', 'T', -4},
+    {'t', 'Y', -4}, {'u', 'T', -4}, {'v', 'T', -4}, {'w', 'T', -4}, {'x', 'T', -4}, {'y', 'T', -4},
+    {'y', 'Z', -4}, {'z', 'T', -4},
+};
+
+const FONT_METRICS Font28_Metrics = {
+    .advance = font28_advance,
+    .bearing = font28_bearing,
+    .kern = font28_kern,
+    .kern_count = sizeof(font28_kern) / sizeof(font28_kern[0]),
+};
+
+static const uint8_t font36_advance[FONT_METRICS_COUNT] = {
+     19,  13,  22,  32,  30,  32,  32,  12,  20,  21,  32,  32,  12,  32,  12,  32,
+     32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  12,  12,  32,  32,  32,  30,
+     32,  32,  32,  32,  32,  32,  32,  32,  32,  12,  31,  32,  32,  32,  32,  32,
+     32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  22,  31,  22,  29,  32,
+     20,  32,  31,  32,  32,  31,  32,  32,  31,  11,  23,  31,  11,  32,  31,  32,
+     31,  32,  25,  29,  32,  31,  31,  32,  32,  32,  31,  20,  11,  19,  31,
+};
+
+static const int8_t font36_bearing[FONT_METRICS_COUNT] = {
+      0,  -9,  -5,   0,   0,   0,   0,  -8, -12,   1,   0,   0,  -2,   0,  -2,   0,
+      0,   3,   1,   0,   0,   1,   0,  -1,   0,   1,  -9,  -9,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0, -10,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -9,   0,   0,  -1,   0,
+     -5,   0,   0,   0,   0,   0,   0,   0,   0, -10,  -3,  -1, -10,   0,   0,   0,
+      0,   0,  -3,  -1,   0,   0,   0,   0,   0,   0,   0, -11, -10,  -1,  -1,
+};
+
+static const FONT_KERN font36_kern[] = {
+    {'"', 'A', -6}, {'"', 'J', -6}, {'"', 'a', -4}, {'"', 'c', -4}, {'"', 'e', -4}, {'"', 'g', -4},
+    {'"', 'j', -4}, {'"', 'o', -4}, {'\'', 'A', -6}, {'\'', 'J', -6}, {'\'', 'a', -4}, {'\'', 'c', -4},
+    {'\'', 'e', -4}, {'\'', 'g', -4}, {'\'', 'j', -4}, {'\'', 'o', -4}, {',', 'T', -6}, {',', 'V', -6},
+    {',', 'Y', -6}, {',', 'f', -6}, {',', 't', -6}, {',', 'v', -5}, {'-', 'T', -6}, {'.', 'T', -6},
+    {'.', 'V', -6}, {'.', 'Y', -6}, {'.', 'f', -6}, {'.', 't', -6}, {'.', 'v', -5}, {':', 'T', -6},
+    {';', 'T', -6}, {'A', 'T', -6}, {'A', 'V', -6}, {'A', 'Y', -6}, {'F', 'A', -6}, {'F', 'J', -5},
+    {'F', 'a', -6}, {'F', 'e', -5}, {'F', 'f', -5}, {'F', 'g', -6}, {'F', 'n', -5}, {'F', 'p', -5},
+    {'F', 'r', -5}, {'F', 's', -5}, {'F', 'u', -5}, {'F', 'v', -5}, {'F', 'x', -6}, {'F', 'z', -6},
+    {'K', 'f', -6}, {'K', 't', -5}, {'K', 'v', -5}, {'L', '-', -6}, {'L', 'T', -6}, {'L', 'V', -6},
+    {'L', 'Y', -6}, {'L', 'f', -6}, {'L', 't', -6}, {'L', 'v', -5}, {'T', '-', -6}, {'T', 'A', -6},
+    {'T', 'J', -6}, {'T', 'a', -6}, {'T', 'c', -6}, {'T', 'd', -6}, {'T', 'e', -6}, {'T', 'f', -6},
+    {'T', 'g', -6}, {'T', 'm', -6}, {'T', 'n', -6}, {'T', 'o', -6}, {'T', 'p', -6}, {'T', 'q', -6},
+    {'T', 'r', -5}, {'T', 's', -5}, {'T', 't', -6}, {'T', 'u', -6}, {'T', 'v', -6}, {'T', 'w', -6},
+    {'T', 'x', -6}, {'T', 'y', -6}, {'T', 'z', -6}, {'V', 'A', -6}, {'X', 'f', -5}, {'X', 'v', -5},
+    {'Y', 'A', -6}, {'Y', 'J', -6}, {'Y', 'a', -6}, {'Y', 'c', -6}, {'Y', 'd', -6}, {'Y', 'e', -6},
+    {'Y', 'g', -6}, {'Y', 'o', -6}, {'Y', 'q', -6}, {'Y', 's', -5}, {'a', 'T', -6}, {'a', 'Y', -6},
+    {'b', 'T', -6}, {'b', 'Y', -6}, {'c', 'T', -6}, {'c', 'Y', -6}, {'e', 'T', -6}, {'e', 'Y', -6},
+    {'f', 'A', -5}, {'f', 'J', -6}, {'g', 'T', -6}, {'h', 'T', -6}, {'k', 'T', -6}, {'m', 'T', -6},
+    {'n', 'T', -6}, {'o', 'T', -6}, {'o', 'Y', -6}, {'p', 'T', -6}, {'p', 'Y', -6}, {'q', 'T', -6},
+    {'r', 'J', -5}, {'r', 'T', -6}, {'r', 'Z', -6}, {'s', 'T', -6}, {'s', 'Y', -5}, {'t', 'T', -6},
+    {'t', 'Y', -5}, {'u', 'T', -6}, {'v', 'T', -6}, {'w', 'T', -6}, {'x', 'T', -6}, {'y', 'T', -6},
+    {'y', 'Z', -5}, {'z', 'T', -6},
+};
+
+const FONT_METRICS Font36_Metrics = {
+    .advance = font36_advance,
+    .bearing = font36_bearing,
+    .kern = font36_kern,
+    .kern_count = sizeof(font36_kern) / sizeof(font36_kern[0]),
+};
+
+static const uint8_t font48_advance[FONT_METRICS_COUNT] = {
+     22,  15,  26,  40,  36,  40,  40,  13,  25,  25,  40,  40,  13,  40,  13,  40,
+     40,  40,  40,  40,  40,  40,  40,  40,  40,  40,  13,  13,  40,  40,  40,  36,
+     40,  40,  40,  40,  40,  38,  39,  39,  39,  13,  37,  40,  38,  40,  39,  40,
+     39,  40,  40,  39,  39,  39,  40,  40,  40,  40,  39,  25,  37,  25,  36,  40,
+     24,  38,  37,  39,  37,  39,  39,  40,  37,  13,  28,  37,  12,  40,  37,  40,
+     37,  37,  29,  35,  38,  37,  39,  40,  38,  39,  37,  22,  12,  22,  37,
+};
+
+static const int8_t font48_bearing[FONT_METRICS_COUNT] = {
+      0, -12,  -7,   0,  -1,   0,   0, -11, -15,   1,   0,   0,  -4,   0,  -3,   0,
+      0,   4,   1,   1,   0,   2,  -1,   0,   1,   1, -13, -13,   0,   0,   0,  -1,
+      0,   0,   0,   0,   0,  -1,  -1,   0,   0, -13,  -1,   0,  -1,   0,   0,   0,
+     -1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -13,  -1,  -1,  -1,   0,
+     -7,   0,  -1,   0,   0,   0,   0,   0,  -1, -13,  -4,  -2, -14,   0,  -1,   0,
+     -1,   0,  -5,  -2,   1,  -1,   0,   0,   0,   0,  -1, -15, -14,  -2,  -2,
+};
+
+static const FONT_KERN font48_kern[] = {
+    {'"', 'A', -8}, {'"', 'J', -7}, {'"', 'a', -6}, {'"', 'c', -6}, {'"', 'e', -6}, {'"', 'g', -7},
+    {'"', 'o', -6}, {'\'', 'A', -8}, {'\'', 'J', -7}, {'\'', 'g', -6}, {',', 'T', -7}, {',', 'V', -8},
+    {',', 'Y', -8}, {',', 'f', -7}, {',', 't', -7}, {',', 'v', -7}, {'-', 'T', -7}, {'-', 'X', -7},
+    {'-', 'Z', -6}, {'.', 'T', -7}, {'.', 'V', -8}, {'.', 'Y', -8}, {'.', 'f', -7}, {'.', 't', -7},
+    {'.', 'v', -7}, {':', 'T', -7}, {';', 'T', -7}, {'A', 'T', -7}, {'A', 'V', -8}, {'A', 'Y', -8},
+    {'F', 'A', -8}, {'F', 'J', -7}, {'F', 'a', -7}, {'F', 'c', -7}, {'F', 'd', -7}, {'F', 'e', -7},
+    {'F', 'f', -7}, {'F', 'g', -8}, {'F', 'n', -7}, {'F', 'o', -7}, {'F', 'p', -7}, {'F', 'q', -7},
+    {'F', 's', -7}, {'F', 't', -7}, {'F', 'u', -7}, {'F', 'v', -7}, {'F', 'x', -7}, {'F', 'y', -7},
+    {'F', 'z', -7}, {'K', '-', -7}, {'K', 'f', -7}, {'K', 't', -7}, {'K', 'v', -7}, {'L', '-', -8},
+    {'L', 'T', -7}, {'L', 'V', -8}, {'L', 'Y', -8}, {'L', 'f', -7}, {'L', 't', -7}, {'L', 'v', -7},
+    {'T', '-', -8}, {'T', 'A', -8}, {'T', 'J', -7}, {'T', 'a', -7}, {'T', 'c', -7}, {'T', 'd', -7},
+    {'T', 'e', -7}, {'T', 'f', -7}, {'T', 'g', -8}, {'T', 'm', -8}, {'T', 'n', -7}, {'T', 'o', -8},
+    {'T', 'p', -7}, {'T', 'q', -7}, {'T', 's', -7}, {'T', 't', -7}, {'T', 'u', -7}, {'T', 'v', -7},
+    {'T', 'w', -8}, {'T', 'x', -7}, {'T', 'y', -7}, {'T', 'z', -7}, {'V', 'A', -8}, {'V', 'g', -7},
+    {'X', '-', -7}, {'Y', 'A', -8}, {'Y', 'J', -7}, {'Y', 'a', -7}, {'Y', 'c', -7}, {'Y', 'd', -7},
+    {'Y', 'e', -7}, {'Y', 'g', -8}, {'Y', 'o', -8}, {'Y', 'q', -7}, {'Y', 's', -7}, {'a', 'T', -7},
+    {'a', 'Y', -8}, {'b', 'T', -7}, {'b', 'Y', -8}, {'c', 'T', -7}, {'c', 'Y', -8}, {'e', 'T', -7},
+    {'e', 'Y', -8}, {'f', 'A', -7}, {'f', 'J', -7}, {'g', 'T', -7}, {'h', 'T', -7}, {'k', 'T', -7},
+    {'m', 'T', -7}, {'n', 'T', -7}, {'o', 'T', -7}, {'o', 'Y', -8}, {'p', 'T', -7}, {'p', 'Y', -8},
+    {'q', 'T', -7}, {'r', 'T', -7}, {'r', 'Z', -7}, {'s', 'T', -7}, {'s', 'Y', -7}, {'t', 'T', -7},
+    {'u', 'T', -7}, {'v', 'T', -7}, {'v', 'Z', -7}, {'w', 'T', -7}, {'x', 'T', -7}, {'y', 'T', -7},
+    {'y', 'Z', -7}, {'z', 'T', -7},
+};
+
+const FONT_METRICS Font48_Metrics = {
+    .advance = font48_advance,
+    .bearing = font48_bearing,
+    .kern = font48_kern,
+    .kern_count = sizeof(font48_kern) / sizeof(font48_kern[0]),
+};
@@ -9,6 +9,8 @@
 extern "C" {
 #endif
 
+uint16_t unicode_to_gb2312(uint32_t unicode);
+uint32_t gb2312_to_unicode(uint16_t gb_code);
 uint16_t utf8_char_to_gb2312(const char* utf8_char, int* char_len);
 int utf8_string_to_gb2312(const char* utf8_str, char* gb2312_str, size_t gb2312_size);
 
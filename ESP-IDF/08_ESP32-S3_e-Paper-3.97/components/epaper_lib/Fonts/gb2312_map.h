@@ -0,0 +1,20 @@
+#ifndef _GB2312_MAP_H
+#define _GB2312_MAP_H
+
+#include <stdint.h>
+
+// Tables generated by tools/gen_gb2312_map.py
+#define GB2312_FIRST_ROW    0xA1
+#define GB2312_FIRST_COL    0xA1
+#define GB2312_ROWS         87      // 0xA1-0xF7
+#define GB2312_COLS         94      // 0xA1-0xFE
+#define GB2312_NO_PAGE      0xFF
+
+// Unicode -> GB2312: page of the high byte, then the low byte within the page
+extern const uint8_t gb2312_fwd_index[256];
+extern const uint16_t gb2312_fwd_pages[][256];
+
+// GB2312 -> Unicode, by row and column
+extern const uint16_t gb2312_rev[GB2312_ROWS][GB2312_COLS];
+
+#endif
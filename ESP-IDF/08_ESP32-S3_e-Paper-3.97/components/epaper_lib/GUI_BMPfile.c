@@ -1,181 +1,311 @@
 #include <stdio.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "esp_log.h"
 #include "esp_err.h"
-#include "esp_vfs_fat.h"
-#include "sdmmc_cmd.h"
-#include "driver/sdmmc_host.h"
 #include "esp_heap_caps.h"
 
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
-#include "sdcard_bsp.h"
+#include "img_pipeline.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "EPD_GUI";
 
-UBYTE GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart)
+#define BMP_MAX_SIDE        4096    // Larger files are rejected before any allocation
+#define BMP_BAND_BYTES      4096    // File bytes read per fread, at least 8 rows
+
+typedef struct {
+    int width, height;          // height > 0
+    bool top_down;
+    int bpp;
+    UDOUBLE stride;             // File bytes per row, padded to 4
+    uint16_t palette[256];      // Palette entry -> working luminance, unlisted entries black
+} BMP_IMAGE;
+
+static esp_err_t bmp_read_header(FILE *f, BMP_IMAGE *img, UDOUBLE *data_offset, bool gamma)
 {
-    BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
-    BMPINFOHEADER bmpInfoHeader;  //Define a bmp info header structure
-    
-    ESP_LOGI(TAG,"path = %s", path);
+    BMPFILEHEADER fh;
+    BMPINFOHEADER ih;
 
-    FILE *f = fopen(path, "rb");
-    if (f == NULL)
-    {
-        ESP_LOGE(TAG,"Cann't open the file!");
-        return 0;
-    }
-    fseek(f, 0, SEEK_SET);
-    uint32_t br = fread(&bmpFileHeader, 1 , sizeof(BMPFILEHEADER), f);
-    if(br != sizeof(BMPFILEHEADER))
-    {
-        ESP_LOGE(TAG,"Failed to read BMP file header");
-        return 0;
-    }
-    br = fread(&bmpInfoHeader, 1,sizeof(BMPINFOHEADER), f);
-    if(br != sizeof(BMPINFOHEADER))
-    {
-        ESP_LOGE(TAG,"BmpInfoHeader error");
-        return 0;
-    }
-    if((bmpInfoHeader.biWidth == 800)&&(bmpInfoHeader.biHeight == 480))
-        Paint_SetRotate(0);
-    else if((bmpInfoHeader.biWidth == 480)&&(bmpInfoHeader.biHeight == 800))
-        Paint_SetRotate(90);
+    if (fread(&fh, 1, sizeof(fh), f) != sizeof(fh) || fh.bType != 0x4D42) {
+        ESP_LOGE(TAG, "Not a BMP file");
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&ih, 0, sizeof(ih));
+    if (fread(&ih.biInfoSize, 1, sizeof(ih.biInfoSize), f) != sizeof(ih.biInfoSize)) {
+        ESP_LOGE(TAG, "Truncated BMP info header");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // BITMAPINFOHEADER and its V4/V5 extensions, not the OS/2 core header
+    if (ih.biInfoSize < sizeof(BMPINFOHEADER) || ih.biInfoSize > 1024) {
+        ESP_LOGE(TAG, "Unsupported BMP info header size %lu", (unsigned long)ih.biInfoSize);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    size_t rest = sizeof(ih) - sizeof(ih.biInfoSize);
+    if (fread((UBYTE *)&ih + sizeof(ih.biInfoSize), 1, rest, f) != rest) {
+        ESP_LOGE(TAG, "Truncated BMP info header");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int32_t width = (int32_t)ih.biWidth, height = (int32_t)ih.biHeight;
+    img->top_down = height < 0;
+    img->width = width;
+    img->height = img->top_down ? -height : height;
+    img->bpp = ih.biBitCount;
+    ESP_LOGI(TAG, "pixel = %d * %d, %d bpp", img->width, img->height, img->bpp);
+
+    if (width <= 0 || height == 0 || img->width > BMP_MAX_SIDE || img->height > BMP_MAX_SIDE || ih.biPlanes != 1) {
+        ESP_LOGE(TAG, "Bad BMP size %ld x %ld", (long)width, (long)height);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (img->bpp != 1 && img->bpp != 4 && img->bpp != 8 && img->bpp != 24 && img->bpp != 32) {
+        ESP_LOGE(TAG, "Unsupported bit depth %d", img->bpp);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    // BI_RGB, or BI_BITFIELDS with the usual BGRX layout for 32 bpp
+    if (ih.biCompression != 0 && !(ih.biCompression == 3 && img->bpp == 32)) {
+        ESP_LOGE(TAG, "Compressed BMP (%lu) is not supported", (unsigned long)ih.biCompression);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    img->stride = ((UDOUBLE)img->width * img->bpp + 31) / 32 * 4;
 
-    ESP_LOGI(TAG,"pixel = %lu * %lu", (unsigned long)bmpInfoHeader.biWidth, (unsigned long)bmpInfoHeader.biHeight);
-
-    // Determine if it is a monochrome bitmap
-    int readbyte = bmpInfoHeader.biBitCount;
-    if(readbyte != 1) {
-        ESP_LOGI(TAG,"the bmp Image is not a monochrome bitmap!");
-    }
-
-    UWORD Image_Width_Byte = (bmpInfoHeader.biWidth % 8 == 0)? (bmpInfoHeader.biWidth / 8): (bmpInfoHeader.biWidth / 8 + 1);
-    UWORD Bmp_Width_Byte = (Image_Width_Byte % 4 == 0) ? Image_Width_Byte: ((Image_Width_Byte / 4 + 1) * 4);
-
-    // Determine black and white based on the palette
-    UWORD i;
-    UWORD Bcolor, Wcolor;
-    UWORD bmprgbquadsize = pow(2, bmpInfoHeader.biBitCount);// 2^1 = 2
-    BMPRGBQUAD bmprgbquad[bmprgbquadsize];        //palette
-    // BMPRGBQUAD bmprgbquad[2];        //palette
-
-    for(i = 0; i < bmprgbquadsize; i++){
-    // for(i = 0; i < 2; i++) {
-        fread(&bmprgbquad[i], sizeof(BMPRGBQUAD), 1, f);
-    }
-    if(bmprgbquad[0].rgbBlue == 0xff && bmprgbquad[0].rgbGreen == 0xff && bmprgbquad[0].rgbRed == 0xff) {
-        Bcolor = BLACK;
-        Wcolor = WHITE;
-    } else {
-        Bcolor = WHITE;
-        Wcolor = BLACK;
-    }
-
-    // Read image data into the cache
-    UWORD x, y;
-    UBYTE Rdata;
-    UBYTE color;
-    fseek(f, bmpFileHeader.bOffset, SEEK_SET);
-    for(y = 0; y < bmpInfoHeader.biHeight; y++) {//Total display column
-        for(x = 0; x < Bmp_Width_Byte; x++) {//Show a line in the line
-            if(fread((char *)&Rdata, 1, readbyte, f) != readbyte) {
-                perror("get bmpdata:\r\n");
-                break;
+    memset(img->palette, 0, sizeof(img->palette));
+    if (img->bpp <= 8) {
+        UDOUBLE colors = ih.biClrUsed ? ih.biClrUsed : (1u << img->bpp);
+        if (colors > (1u << img->bpp))
+            colors = 1u << img->bpp;
+        if (fseek(f, sizeof(BMPFILEHEADER) + ih.biInfoSize, SEEK_SET) != 0)
+            return ESP_ERR_INVALID_SIZE;
+        for (UDOUBLE i = 0; i < colors; i++) {
+            BMPRGBQUAD q;
+            if (fread(&q, 1, sizeof(q), f) != sizeof(q)) {
+                ESP_LOGE(TAG, "Truncated BMP palette");
+                return ESP_ERR_INVALID_SIZE;
             }
-            if(x < Image_Width_Byte) { //bmp
-                for (size_t i = 0; i < 8; i++)
-                {
-                    color = (((Rdata << (i%8)) & 0x80) == 0x80) ?Bcolor:Wcolor;
-                    if(x*8+i >= (unsigned long)bmpInfoHeader.biWidth) break;
-                    Paint_SetPixel(Xstart + x*8 + i , Ystart+bmpInfoHeader.biHeight-1-y, color);
-                }
+            img->palette[i] = img_lum_rgb(q.rgbRed, q.rgbGreen, q.rgbBlue, gamma);
+        }
+    }
+
+    if (fh.bOffset < sizeof(BMPFILEHEADER) + sizeof(BMPINFOHEADER)) {
+        ESP_LOGE(TAG, "Bad BMP data offset %lu", (unsigned long)fh.bOffset);
+        return ESP_ERR_INVALID_ARG;
+    }
+    *data_offset = fh.bOffset;
+    return ESP_OK;
+}
+
+// Converted rows on their way to the image
+typedef struct {
+    const BMP_IMAGE *img;
+    UWORD x, y;                 // Image position
+    UBYTE *band;                // 1-bit rows in file order
+    int out_bytes, band_rows;
+    int first, count;           // File row of band[0], rows held
+} BMP_SINK;
+
+static void bmp_flush(BMP_SINK *s)
+{
+    int n = s->count;
+    if (n == 0)
+        return;
+    int top = s->img->top_down ? s->first : s->img->height - s->first - n;
+    if (!s->img->top_down) {
+        // Bottom-up file, turn the band over before drawing it
+        for (int i = 0; i < n / 2; i++) {
+            UBYTE *a = s->band + (size_t)i * s->out_bytes;
+            UBYTE *b = s->band + (size_t)(n - 1 - i) * s->out_bytes;
+            for (int k = 0; k < s->out_bytes; k++) {
+                UBYTE t = a[k];
+                a[k] = b[k];
+                b[k] = t;
             }
         }
-        // When reading a large amount of data, increase the delay to facilitate the CPU in processing the content of other threads
-        vTaskDelay(pdMS_TO_TICKS(1));
     }
-    fclose(f);
+    PAINT_IMAGE band = { s->band, (UDOUBLE)n * s->out_bytes, (UWORD)s->img->width, (UWORD)n, IMAGE_RAW };
+    Paint_BlitImage(s->x, s->y + top, &band, ROP_COPY);
+    s->first += n;
+    s->count = 0;
+}
+
+// img_row_cb_t for 1-bit output, y is the file row
+static void bmp_emit_ink(void *ctx, int y, const uint8_t *row)
+{
+    BMP_SINK *s = (BMP_SINK *)ctx;
+    (void)y;
+    memcpy(s->band + (size_t)s->count * s->out_bytes, row, s->out_bytes);
+    if (++s->count == s->band_rows)
+        bmp_flush(s);
+}
 
-    return 0;
+// img_row_cb_t for 4 gray levels, drawn straight away
+static void bmp_emit_gray(void *ctx, int y, const uint8_t *row)
+{
+    BMP_SINK *s = (BMP_SINK *)ctx;
+    int dy = s->img->top_down ? y : s->img->height - 1 - y;
+    if (s->y + dy >= Paint.Height)
+        return;
+    for (int x = 0; x < s->img->width && s->x + x < Paint.Width; x++)
+        Paint_SetPixel(s->x + x, s->y + dy, (row[x >> 2] >> (6 - 2 * (x & 3))) & 3);
 }
-/*************************************************************************
 
-*************************************************************************/
-UBYTE GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart)
+/******************************************************************************
+function: Load a BMP file into the image
+parameter:
+    path    : File path
+    Xstart  : X coordinate
+    Ystart  : Y coordinate
+    Options : Dithering, sharpening and gamma, NULL for a plain threshold at 128
+info:
+    1/4/8/24/32-bit uncompressed files, bottom-up or top-down. The file is
+    read a band of rows at a time and streamed through img_pipeline to the
+    image depth, 1 bit (Scale 2) or 4 gray levels (Scale 4). 1-bit output
+    goes through Paint_BlitImage. An 800x480 or 480x800 file also sets the
+    rotation. Returns ESP_OK, or an error with the part already read left drawn.
+******************************************************************************/
+esp_err_t GUI_LoadBmp(const char *path, UWORD Xstart, UWORD Ystart, const BMP_OPTIONS *Options)
 {
-    FILE *fp;                     //Define a file pointer
-    BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
-    BMPINFOHEADER bmpInfoHeader;  //Define a bmp info header structure
-    
-    // Binary file open
-    if((fp = fopen(path, "rb")) == NULL) {
-        ESP_LOGI(TAG,"Cann't open the file!");
-        exit(0);
-    }
- 
-    // Set the file pointer from the beginning
-    fseek(fp, 0, SEEK_SET);
-    fread(&bmpFileHeader, sizeof(BMPFILEHEADER), 1, fp);    //sizeof(BMPFILEHEADER) must be 14
-    fread(&bmpInfoHeader, sizeof(BMPINFOHEADER), 1, fp);    //sizeof(BMPFILEHEADER) must be 50
-    ESP_LOGI(TAG,"pixel = %lu * %lu", (unsigned long)bmpInfoHeader.biWidth, (unsigned long)bmpInfoHeader.biHeight);
-
-    if((bmpInfoHeader.biWidth == 800)&&(bmpInfoHeader.biHeight == 480))
+    static const BMP_OPTIONS defaults = { BMP_DITHER_NONE, 128, 0, false };
+    static const img_dither_t dithers[] = {
+        [BMP_DITHER_NONE] = IMG_DITHER_NONE,
+        [BMP_DITHER_ORDERED] = IMG_DITHER_BAYER8,
+        [BMP_DITHER_FLOYD] = IMG_DITHER_FLOYD,
+        [BMP_DITHER_ATKINSON] = IMG_DITHER_ATKINSON,
+    };
+    const BMP_OPTIONS *opt = Options ? Options : &defaults;
+    BMP_IMAGE img;
+    UDOUBLE data_offset;
+    esp_err_t err;
+
+    ESP_LOGI(TAG, "path = %s", path);
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Cann't open the file!");
+        return ESP_ERR_NOT_FOUND;
+    }
+    err = bmp_read_header(f, &img, &data_offset, opt->Gamma);
+    if (err != ESP_OK) {
+        fclose(f);
+        return err;
+    }
+
+    if ((img.width == 800) && (img.height == 480))
         Paint_SetRotate(0);
-    else if((bmpInfoHeader.biWidth == 480)&&(bmpInfoHeader.biHeight == 800))
+    else if ((img.width == 480) && (img.height == 800))
         Paint_SetRotate(90);
 
-    UWORD Image_Width_Byte = (bmpInfoHeader.biWidth % 4 == 0)? (bmpInfoHeader.biWidth / 4): (bmpInfoHeader.biWidth / 4 + 1);
-    UWORD Bmp_Width_Byte = (bmpInfoHeader.biWidth % 2 == 0)? (bmpInfoHeader.biWidth / 2): (bmpInfoHeader.biWidth / 2 + 1);
-
-    int readbyte = bmpInfoHeader.biBitCount;
-    ESP_LOGI(TAG,"biBitCount = %d",readbyte);
-    if(readbyte != 4){
-        ESP_LOGI(TAG,"Bmp image is not a 4-color bitmap!\n");
-        exit(0);
-    }
-    // Read image data into the cache
-    UWORD x, y;
-    UBYTE Rdata;
-    UBYTE color, temp;
-    fseek(fp, bmpFileHeader.bOffset, SEEK_SET);
-    
-    for(y = 0; y < bmpInfoHeader.biHeight; y++) {//Total display column
-        for(x = 0; x < Bmp_Width_Byte; x++) {//Show a line in the line
-            if(fread((char *)&Rdata, 1, 1, fp) != 1) {
-                perror("get bmpdata:\r\n");
-                break;
-            }
-            if(x < Image_Width_Byte*2) { //bmp
-                for (size_t i = 0; i < 2; i++)
-                {
-                    temp = Rdata >> ((i%2)? 0:4);//0xf 0x8 0x7 0x0 
-
-                    // Choose one of the two color options(All the four-grayscale images of Waveshare are based on the first type)
-                    color = temp>>2;                           //11  10  01  00  
-                    // if(temp==0) {
-                    //     color = 0;
-                    // } else if(temp==7) {
-                    //     color = 1;
-                    // } else if(temp>3) {
-                    //     color = 3;
-                    // } else {
-                    //     color = 2;
-                    // }
-
-                    Paint_SetPixel(Xstart + x*2 +i, Ystart+bmpInfoHeader.biHeight-1-y, color);
-                }
+    bool gray = (Paint.Scale == 4);
+    int w = img.width, h = img.height;
+    int out_bytes = (w + 7) / 8;
+    int band_rows = (int)(BMP_BAND_BYTES / img.stride) & ~7;
+    if (band_rows < 8)
+        band_rows = 8;
+    if (band_rows > h)
+        band_rows = h;
+
+    // Plain 1-bit copy: palette entries straight to ink, no per-pixel work
+    bool direct = (img.bpp == 1 && !gray && opt->Dither == BMP_DITHER_NONE && opt->Sharpen == 0);
+    UBYTE t = opt->Threshold ? opt->Threshold : 128;
+    uint16_t thr = img_lum_rgb(t, t, t, opt->Gamma);
+    UBYTE ink0 = img.palette[0] < thr ? 0xFF : 0x00;
+    UBYTE ink1 = img.palette[1] < thr ? 0xFF : 0x00;
+
+    BMP_SINK sink = { &img, Xstart, Ystart, NULL, out_bytes, band_rows, 0, 0 };
+    img_pipe_t *pipe = NULL;
+    if (!direct) {
+        img_pipe_cfg_t cfg = {
+            .width = w,
+            .out = gray ? IMG_OUT_GRAY2 : IMG_OUT_INK1,
+            .dither = dithers[opt->Dither],
+            .gamma = opt->Gamma,
+            .sharpen = opt->Sharpen,
+            .threshold = t,
+            .emit = gray ? bmp_emit_gray : bmp_emit_ink,
+            .ctx = &sink,
+        };
+        err = img_pipe_create(&cfg, &pipe);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "No pipeline for a %dx%d BMP", w, h);
+            fclose(f);
+            return err;
+        }
+    }
+    static const img_src_fmt_t formats[] = {
+        [1] = IMG_SRC_INDEX1, [4] = IMG_SRC_INDEX4, [8] = IMG_SRC_INDEX8,
+        [24] = IMG_SRC_BGR24, [32] = IMG_SRC_BGRX32,
+    };
+    img_src_fmt_t fmt = formats[img.bpp];
+
+    size_t file_size = (size_t)band_rows * img.stride;
+    size_t total = file_size + (size_t)(band_rows + 1) * out_bytes;
+    UBYTE *mem = (total > 16 * 1024) ? heap_caps_malloc(total, MALLOC_CAP_SPIRAM) : NULL;
+    if (mem == NULL)
+        mem = malloc(total);
+    if (mem == NULL) {
+        ESP_LOGE(TAG, "No memory for a %dx%d BMP", w, h);
+        img_pipe_destroy(pipe);
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    UBYTE *file_rows = mem;
+    UBYTE *direct_row = file_rows + file_size;
+    sink.band = direct_row + out_bytes;
+
+    if (fseek(f, data_offset, SEEK_SET) != 0) {
+        ESP_LOGE(TAG, "Bad BMP data offset");
+        err = ESP_ERR_INVALID_SIZE;
+        goto done;
+    }
+
+    // Rows go through in file order, the sink puts them the right way up
+    for (int i0 = 0; i0 < h; i0 += band_rows) {
+        int n = (h - i0 < band_rows) ? h - i0 : band_rows;
+        size_t got = fread(file_rows, 1, (size_t)n * img.stride, f);
+        if (got < (size_t)n * img.stride) {
+            ESP_LOGE(TAG, "BMP data truncated at row %d", i0 + (int)(got / img.stride));
+            err = ESP_ERR_INVALID_SIZE;
+            n = got / img.stride;
+        }
+
+        for (int i = 0; i < n; i++) {
+            const UBYTE *src = file_rows + (size_t)i * img.stride;
+            if (direct) {
+                for (int k = 0; k < out_bytes; k++)
+                    direct_row[k] = (UBYTE)((~src[k] & ink0) | (src[k] & ink1));
+                bmp_emit_ink(&sink, i0 + i, direct_row);
+            } else {
+                img_pipe_push(pipe, fmt, src, img.palette);
             }
         }
-        // When reading a large amount of data, increase the delay to facilitate the CPU in processing the content of other threads
-        vTaskDelay(pdMS_TO_TICKS(1));
+        if (err != ESP_OK)
+            break;
+        // Large files take a while, let the other tasks run. A yield, not a
+        // delay: pdMS_TO_TICKS(1) is 0 ticks at 100 Hz, one tick is 10 ms a band
+        taskYIELD();
     }
-    fclose(fp);
-    return 0;
+    if (pipe)
+        img_pipe_finish(pipe);
+    if (!gray)
+        bmp_flush(&sink);
+
+done:
+    img_pipe_destroy(pipe);
+    free(mem);
+    fclose(f);
+    return err;
+}
+
+esp_err_t GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_LoadBmp(path, Xstart, Ystart, NULL);
+}
+
+// Kept for existing callers, the depth now follows Paint.Scale
+esp_err_t GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_LoadBmp(path, Xstart, Ystart, NULL);
 }
@@ -2,10 +2,12 @@
 #define __GUI_BMPFILE_H
 
 #include "esp_log.h"
+#include "esp_err.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
 
 
 #define UBYTE   uint8_t
@@ -49,12 +51,28 @@ typedef struct RGB_QUAD
 } __attribute__ ((packed)) BMPRGBQUAD;
 /**************************************** end ***********************************************/
 
+/*Conversion of GUI_LoadBmp */
+typedef enum {
+    BMP_DITHER_NONE = 0,    // Threshold (1 bit) or nearest gray level
+    BMP_DITHER_ORDERED,     // 8x8 Bayer matrix
+    BMP_DITHER_FLOYD,       // Floyd-Steinberg error diffusion, serpentine
+    BMP_DITHER_ATKINSON,    // Atkinson error diffusion, more contrast, for line art
+} BMP_DITHER;
+
+typedef struct {
+    BMP_DITHER Dither;
+    UBYTE Threshold;        // 1-bit cut-off for all but ORDERED, 0 means 128
+    UBYTE Sharpen;          // Unsharp amount in 1/4 steps, 0 = off
+    bool Gamma;             // Dither in linear light, for photos
+} BMP_OPTIONS;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-UBYTE GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart);
-UBYTE GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart);
+esp_err_t GUI_LoadBmp(const char *path, UWORD Xstart, UWORD Ystart, const BMP_OPTIONS *Options);
+esp_err_t GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart);
+esp_err_t GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart);
 
 
 #ifdef __cplusplus
@@ -2,9 +2,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include "GUI_Paint.h"
 #include "DEV_Config.h"
 #include "font.h"
+#include "mem_arena.h"
 #include "esp_log.h"
 #include <math.h>
 
@@ -431,6 +434,374 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
     }
 }
 
+/******************************************************************************
+function: Bitmap blitter helpers
+info:
+    Rotation and mirroring together are one of 8 flips/transposes between
+    the logical (Xpoint, Ypoint) plane and the frame memory. For 0/180 every
+    source row lands on one memory row, so it is shifted and merged a byte at
+    a time; for 90/270 every source column lands on one memory row, so the
+    source is transposed in 8x8 bit blocks first. A reversed direction is a
+    bit reversal of the row.
+    Sources are consumed a band of rows at a time, so packed images can be
+    decoded into a small buffer and merged without a full-size copy.
+******************************************************************************/
+#define BLIT_MAX_BAND       256     // Rows per band
+#define BLIT_MAX_WIDTH      1024    // Widest source handled without Paint_SetPixel
+#define BLIT_BAND_BYTES     1024    // Decode buffer for packed images
+
+static const UBYTE bit_reverse[256] = {
+#define R2(n) n, n + 2*64, n + 1*64, n + 3*64
+#define R4(n) R2(n), R2(n + 2*16), R2(n + 1*16), R2(n + 3*16)
+#define R6(n) R4(n), R4(n + 2*4 ), R4(n + 1*4 ), R4(n + 3*4 )
+    R6(0), R6(2), R6(1), R6(3)
+#undef R6
+#undef R4
+#undef R2
+};
+
+// What a set (1) or clear (0) source bit does to the frame
+typedef enum {
+    BLIT_FILL = 0,      // Set -> Fore, clear -> Back
+    BLIT_FILL_SET,      // Set -> Fore, clear -> unchanged
+    BLIT_FILL_CLEAR,    // Set -> unchanged, clear -> Back
+    BLIT_TOGGLE,        // Set -> inverted, clear -> unchanged
+} BLIT_OP;
+
+typedef struct {
+    int x0, y0, w, h;           // Logical rectangle
+    int row_bytes;
+    bool fast;                  // false: go through Paint_SetPixel
+    bool swap, xneg, yneg;      // Logical -> memory transform
+    BLIT_OP op;
+    UWORD color_fore, color_back;
+    UBYTE fore, back;           // 0x00/0xFF patterns of the colors
+} BLIT;
+
+static void blit_setup(BLIT *b, int x0, int y0, int w, int h, BLIT_OP op,
+                       UWORD Color_Foreground, UWORD Color_Background)
+{
+    b->x0 = x0;
+    b->y0 = y0;
+    b->w = w;
+    b->h = h;
+    b->row_bytes = (w + 7) / 8;
+    b->op = op;
+    b->color_fore = Color_Foreground;
+    b->color_back = Color_Background;
+    b->fore = (Color_Foreground == BLACK) ? 0x00 : 0xFF;
+    b->back = (Color_Background == BLACK) ? 0x00 : 0xFF;
+    b->fast = (Paint.Scale == 2 && w <= BLIT_MAX_WIDTH);
+
+    switch (Paint.Rotate) {
+    case ROTATE_0:   b->swap = false; b->xneg = false; b->yneg = false; break;
+    case ROTATE_90:  b->swap = true;  b->xneg = true;  b->yneg = false; break;
+    case ROTATE_180: b->swap = false; b->xneg = true;  b->yneg = true;  break;
+    case ROTATE_270: b->swap = true;  b->xneg = false; b->yneg = true;  break;
+    default:
+        b->fast = false;
+        break;
+    }
+    if (Paint.Mirror & MIRROR_HORIZONTAL)
+        b->xneg = !b->xneg;
+    if (Paint.Mirror & MIRROR_VERTICAL)
+        b->yneg = !b->yneg;
+
+    if (!b->fast && op == BLIT_TOGGLE)
+        ESP_LOGW(TAG, "XOR is only supported on a 1-bit image");
+}
+
+// 8 rows of 8 pixels (MSB first) -> 8 columns of 8 pixels (MSB = row 0)
+static void blit_transpose8(const UBYTE in[8], UBYTE out[8])
+{
+    uint64_t x = 0, t;
+    for (int i = 0; i < 8; i++)
+        x = (x << 8) | in[i];
+
+    t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAULL; x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x ^= t ^ (t << 28);
+
+    for (int i = 7; i >= 0; i--) {
+        out[i] = (UBYTE)x;
+        x >>= 8;
+    }
+}
+
+// Reverse the first Bits pixels of a row, result starts at bit 0 of Dst
+static void blit_reverse_row(const UBYTE *Src, UBYTE *Dst, int Bits)
+{
+    int bytes = (Bits + 7) / 8;
+    int pad = bytes * 8 - Bits;
+
+    for (int i = 0; i < bytes; i++)
+        Dst[i] = bit_reverse[Src[bytes - 1 - i]];
+    if (pad) {
+        for (int i = 0; i < bytes - 1; i++)
+            Dst[i] = (UBYTE)((Dst[i] << pad) | (Dst[i + 1] >> (8 - pad)));
+        Dst[bytes - 1] = (UBYTE)(Dst[bytes - 1] << pad);
+    }
+}
+
+/*
+ * Merge Bits pixels of Src into memory row Y, pixel k going to X = Xmin + k,
+ * clipped to [0, WidthMemory).
+ */
+static void blit_row(const BLIT *b, int Y, int Xmin, const UBYTE *Src, int Bits)
+{
+    int xa = Xmin < 0 ? 0 : Xmin;
+    int xb = Xmin + Bits > Paint.WidthMemory ? Paint.WidthMemory : Xmin + Bits;
+    if (Y < 0 || Y >= Paint.HeightMemory || xa >= xb)
+        return;
+
+    int src_bytes = (Bits + 7) / 8;
+    int first = xa / 8, last = (xb - 1) / 8;
+    UBYTE *dst = Paint.Image + (UDOUBLE)Y * Paint.WidthByte;
+
+    for (int i = first; i <= last; i++) {
+        // Source pixels that fall on byte i, the window may start before Src
+        int off = i * 8 - Xmin + 8;
+        int idx = off / 8 - 1, sh = off % 8;
+        unsigned hi = (idx >= 0) ? Src[idx] : 0;
+        unsigned lo = (idx + 1 < src_bytes) ? Src[idx + 1] : 0;
+        UBYTE s = (UBYTE)((((hi << 8) | lo) << sh) >> 8);
+
+        UBYTE m = 0xFF, v;
+        if (i == first)
+            m &= 0xFF >> (xa % 8);
+        if (i == last)
+            m &= (UBYTE)(0xFF << (7 - (xb - 1) % 8));
+
+        switch (b->op) {
+        case BLIT_FILL:       v = (s & b->fore) | (~s & b->back); break;
+        case BLIT_FILL_SET:   v = b->fore; m &= s;  break;
+        case BLIT_FILL_CLEAR: v = b->back; m &= ~s; break;
+        default:              v = ~dst[i]; m &= s;  break;
+        }
+        dst[i] = (dst[i] & ~m) | (v & m);
+    }
+}
+
+// Rows r0 .. r0 + Rows - 1 of the source, r0 a multiple of 8
+static void blit_band(const BLIT *b, int r0, int Rows, const UBYTE *Src)
+{
+    int wm = Paint.WidthMemory, hm = Paint.HeightMemory;
+    UBYTE rev[BLIT_MAX_WIDTH / 8];
+
+    if (!b->fast) {
+        for (int i = 0; i < Rows && b->y0 + r0 + i < Paint.Height; i++) {
+            const UBYTE *ptr = Src + i * b->row_bytes;
+            for (int col = 0; col < b->w && b->x0 + col < Paint.Width; col++) {
+                bool set = ptr[col / 8] & (0x80 >> (col % 8));
+                if (set && (b->op == BLIT_FILL || b->op == BLIT_FILL_SET))
+                    Paint_SetPixel(b->x0 + col, b->y0 + r0 + i, b->color_fore);
+                else if (!set && (b->op == BLIT_FILL || b->op == BLIT_FILL_CLEAR))
+                    Paint_SetPixel(b->x0 + col, b->y0 + r0 + i, b->color_back);
+            }
+        }
+        return;
+    }
+
+    if (!b->swap) {
+        // Source row r -> memory row, columns run along X
+        int xmin = b->xneg ? wm - b->x0 - b->w : b->x0;
+        for (int i = 0; i < Rows; i++) {
+            int r = r0 + i;
+            int y = b->yneg ? hm - 1 - b->y0 - r : b->y0 + r;
+            if (y < 0 || y >= hm)
+                continue;
+            const UBYTE *src = Src + i * b->row_bytes;
+            if (b->xneg) {
+                blit_reverse_row(src, rev, b->w);
+                src = rev;
+            }
+            blit_row(b, y, xmin, src, b->w);
+        }
+        return;
+    }
+
+    // Source column c -> memory row, rows run along X; one 8-column strip at a time
+    int col_bytes = (Rows + 7) / 8;
+    int xmin = b->xneg ? wm - b->y0 - r0 - Rows : b->y0 + r0;
+    UBYTE strip[8][BLIT_MAX_BAND / 8];
+    UBYTE in[8], out[8];
+
+    for (int j = 0; j < b->row_bytes; j++) {
+        int c0 = j * 8;
+        int ya = b->yneg ? hm - 1 - b->x0 - c0 - 7 : b->x0 + c0;
+        if (ya + 7 < 0 || ya >= hm)
+            continue;
+
+        for (int rb = 0; rb < col_bytes; rb++) {
+            for (int i = 0; i < 8; i++) {
+                int r = rb * 8 + i;
+                in[i] = (r < Rows) ? Src[r * b->row_bytes + j] : 0;
+            }
+            blit_transpose8(in, out);
+            for (int k = 0; k < 8; k++)
+                strip[k][rb] = out[k];
+        }
+
+        for (int k = 0; k < 8 && c0 + k < b->w; k++) {
+            int y = b->yneg ? hm - 1 - b->x0 - c0 - k : b->x0 + c0 + k;
+            const UBYTE *src = strip[k];
+            if (b->xneg) {
+                blit_reverse_row(src, rev, Rows);
+                src = rev;
+            }
+            blit_row(b, y, xmin, src, Rows);
+        }
+    }
+}
+
+static void blit_raw(const BLIT *b, const UBYTE *Src)
+{
+    for (int r0 = 0; r0 < b->h; r0 += BLIT_MAX_BAND) {
+        int rows = (b->h - r0 < BLIT_MAX_BAND) ? b->h - r0 : BLIT_MAX_BAND;
+        blit_band(b, r0, rows, Src + (UDOUBLE)r0 * b->row_bytes);
+    }
+}
+
+// PackBits reader, runs may cross rows and bands
+typedef struct {
+    const UBYTE *p, *end;
+    int literal, repeat;
+    UBYTE value;
+} PACKBITS;
+
+static void packbits_read(PACKBITS *s, UBYTE *Dst, int Len)
+{
+    while (Len > 0) {
+        if (s->literal > 0) {
+            int n = Len < s->literal ? Len : s->literal;
+            if (n > s->end - s->p)
+                n = s->end - s->p;
+            if (n == 0) {
+                s->literal = 0;
+                continue;
+            }
+            memcpy(Dst, s->p, n);
+            s->p += n;
+            s->literal -= n;
+            Dst += n;
+            Len -= n;
+        } else if (s->repeat > 0) {
+            int n = Len < s->repeat ? Len : s->repeat;
+            memset(Dst, s->value, n);
+            s->repeat -= n;
+            Dst += n;
+            Len -= n;
+        } else if (s->p < s->end) {
+            UBYTE c = *s->p++;
+            if (c < 128) {
+                s->literal = c + 1;
+            } else if (c > 128 && s->p < s->end) {
+                s->repeat = 257 - c;
+                s->value = *s->p++;
+            }
+        } else {
+            // Truncated stream, the rest stays blank
+            memset(Dst, 0, Len);
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+function: Draw a 1bpp glyph
+parameter:
+    Xstart           ：X coordinate
+    Ystart           ：Y coordinate
+    Glyph            ：Row-major bitmap, MSB first, (Width + 7) / 8 bytes per row
+    Width            ：Glyph width
+    Height           ：Glyph height
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color, TRANSPARENT keeps the frame
+info:
+    Gives the same result as calling Paint_SetPixel for every pixel, but
+    works on whole bytes of the frame. Pixels outside the image are clipped.
+******************************************************************************/
+void Paint_DrawGlyph(UWORD Xstart, UWORD Ystart, const UBYTE *Glyph, UWORD Width, UWORD Height,
+                     UWORD Color_Foreground, UWORD Color_Background)
+{
+    BLIT b;
+
+    if (!Glyph || Width == 0 || Height == 0 || Xstart >= Paint.Width || Ystart >= Paint.Height)
+        return;
+
+    blit_setup(&b, Xstart, Ystart, Width, Height,
+               (Color_Background == TRANSPARENT) ? BLIT_FILL_SET : BLIT_FILL,
+               Color_Foreground, Color_Background);
+    blit_raw(&b, Glyph);
+}
+
+/******************************************************************************
+function: Draw an image
+parameter:
+    Xstart : X coordinate
+    Ystart : Y coordinate
+    Image  : Image descriptor, raw or packed (see tools/img_pack.py)
+    Rop    : How the image ink is combined with the frame
+info:
+    Image bits are ink (1 = black), rows padded to whole bytes, the same
+    layout as Paint_ReadBmp. Packed images are decoded a band at a time
+    straight into the frame. Pixels outside the image are clipped.
+******************************************************************************/
+void Paint_BlitImage(UWORD Xstart, UWORD Ystart, const PAINT_IMAGE *Image, PAINT_ROP Rop)
+{
+    BLIT b;
+    BLIT_OP op;
+    UWORD fore = BLACK, back = WHITE;
+
+    if (!Image || !Image->Data || Image->Width == 0 || Image->Height == 0 ||
+        Xstart >= Paint.Width || Ystart >= Paint.Height)
+        return;
+
+    switch (Rop) {
+    case ROP_COPY:   op = BLIT_FILL; break;
+    case ROP_OR:     op = BLIT_FILL_SET; break;
+    case ROP_AND:    op = BLIT_FILL_CLEAR; break;
+    case ROP_XOR:    op = BLIT_TOGGLE; break;
+    case ROP_INVERT: op = BLIT_FILL; fore = WHITE; back = BLACK; break;
+    default:
+        ESP_LOGE(TAG, "Paint_BlitImage: unknown rop %d", Rop);
+        return;
+    }
+    blit_setup(&b, Xstart, Ystart, Image->Width, Image->Height, op, fore, back);
+
+    if (Image->Format == IMAGE_RAW) {
+        blit_raw(&b, Image->Data);
+        return;
+    }
+    if (Image->Format != IMAGE_PACKBITS || b.row_bytes > BLIT_BAND_BYTES / 8) {
+        ESP_LOGE(TAG, "Paint_BlitImage: unsupported image %dx%d format %d",
+                 Image->Width, Image->Height, Image->Format);
+        return;
+    }
+
+    // Rows are XORed with the row above before packing
+    UBYTE band[BLIT_BAND_BYTES];
+    UBYTE prev[BLIT_BAND_BYTES / 8] = {0};
+    PACKBITS s = { Image->Data, Image->Data + Image->Size, 0, 0, 0 };
+    int band_rows = (BLIT_BAND_BYTES / b.row_bytes) & ~7;
+    if (band_rows > BLIT_MAX_BAND)
+        band_rows = BLIT_MAX_BAND;
+
+    for (int r0 = 0; r0 < b.h; r0 += band_rows) {
+        int rows = (b.h - r0 < band_rows) ? b.h - r0 : band_rows;
+        packbits_read(&s, band, rows * b.row_bytes);
+        const UBYTE *above = prev;
+        for (int i = 0; i < rows; i++) {
+            UBYTE *row = band + i * b.row_bytes;
+            for (int k = 0; k < b.row_bytes; k++)
+                row[k] ^= above[k];
+            above = row;
+        }
+        memcpy(prev, above, b.row_bytes);
+        blit_band(&b, r0, rows, band);
+    }
+}
+
 /******************************************************************************
 function: Show English characters
 parameter:
@@ -444,8 +815,6 @@ parameter:
 void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char,
                     sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
 {
-    UWORD Page, Column;
-
     if (Xstart > Paint.Width || Ystart > Paint.Height) {
         ESP_LOGI(TAG,"Paint_DrawChar Input exceeds the normal display range");
         return;
@@ -458,7 +827,7 @@ void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char,
     }
 
     size_t buf_len = (size_t)Font->size;
-    unsigned char *font_buffer = (unsigned char*)malloc(buf_len);
+    unsigned char *font_buffer = (unsigned char*)mem_alloc(buf_len);
     if (!font_buffer) {
         ESP_LOGE(TAG, "font_buffer malloc failed, size=%u", (unsigned)buf_len);
         return;
@@ -468,26 +837,14 @@ void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char,
     int got = Get_Char_Font_Data_ASCII(Font, ch_str, font_buffer);
     if (got <= 0) {
         ESP_LOGW(TAG, "Failed to read ASCII font data: '%c' (0x%02X)", Acsii_Char, (unsigned char)Acsii_Char);
-        free(font_buffer);
+        mem_free(font_buffer);
         return;
     }
 
-    const unsigned char *ptr = font_buffer;
-    for (Page = 0; Page < Font->Height; Page++) {
-        for (Column = 0; Column < Font->Width; Column++) {
-            if (*ptr & (0x80 >> (Column % 8))) {
-                Paint_SetPixel(Xstart + Column, Ystart + Page, Color_Foreground);
-            } else {
-                Paint_SetPixel(Xstart + Column, Ystart + Page, Color_Background);
-            }
-            if (Column % 8 == 7)
-                ptr++;
-        }
-        if (Font->Width % 8 != 0)
-            ptr++;
-    }
+    Paint_DrawGlyph(Xstart, Ystart, font_buffer, Font->Width, Font->Height,
+                    Color_Foreground, Color_Background);
 
-    free(font_buffer);
+    mem_free(font_buffer);
 }
 
 /******************************************************************************
@@ -529,26 +886,82 @@ void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString,
 }
 
 
-/******************************************************************************
-function: Display the string
-parameter:
-    Xstart  ：X coordinate
-    Ystart  ：Y coordinate
-    pString ：The first address of the Chinese string and English
-              string to be displayed
-    Font    ：A structure pointer that displays a character size
-    Color_Foreground : Select the foreground color
-    Color_Background : Select the background color
-******************************************************************************/
-void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background)
+#define PAINT_GLYPH_BATCH_BYTES 8192    // Glyph buffer of Paint_DrawString_CN
+
+/*
+ * A proportional English glyph. Its cell overlaps the neighbouring glyphs, so
+ * the paper (set bits) of [Xpaper, Xpen + Advance) is filled first and only
+ * the ink (clear bits) of the cell is drawn on top. Glyph is modified.
+ */
+static void paint_glyph_prop(int Xpaper, int Xpen, int Ypoint, int Advance, int Bearing,
+                             UBYTE *Glyph, const UBYTE *Paper, const cFONT *Font,
+                             UWORD Color_Foreground, UWORD Color_Background)
+{
+    int w = Font->Width_EN, h = Font->Height;
+    int row_bytes = (w + 7) / 8;
+    int x = Xpen + Bearing;
+
+    if (Color_Background != TRANSPARENT) {
+        for (int xp = Xpaper; xp < Xpen + Advance; xp += w) {
+            int span = Xpen + Advance - xp;
+            Paint_DrawGlyph(xp, Ypoint, Paper, span < w ? span : w, h,
+                            Color_Foreground, Color_Foreground);
+        }
+        for (int i = 0; i < row_bytes * h; i++)
+            Glyph[i] = ~Glyph[i];
+    }
+
+    // A cell starting left of the frame is shifted so the ink is not lost
+    if (x < 0) {
+        int s = -x;
+        for (int r = 0; r < h; r++) {
+            UBYTE *row = Glyph + r * row_bytes;
+            for (int k = 0; k < row_bytes; k++) {
+                int idx = k + s / 8;
+                unsigned hi = idx < row_bytes ? row[idx] : 0;
+                unsigned lo = idx + 1 < row_bytes ? row[idx + 1] : 0;
+                row[k] = (UBYTE)((((hi << 8) | lo) << (s % 8)) >> 8);
+            }
+        }
+        x = 0;
+    }
+
+    if (Color_Background != TRANSPARENT)
+        Paint_DrawGlyph(x, Ypoint, Glyph, w, h, Color_Background, TRANSPARENT);
+    else
+        Paint_DrawGlyph(x, Ypoint, Glyph, w, h, Color_Foreground, TRANSPARENT);
+}
+
+// Spaces in pString, or gaps between its characters when !SpacesOnly
+static int paint_string_gaps(const char *pString, const cFONT *font, bool SpacesOnly)
+{
+    int chars = 0, spaces = 0;
+    for (const char *p = pString; *p; ) {
+        int char_len = 1;
+        if (font->encoding == FONT_ENCODING_UTF8) UTF8_To_Unicode(p, &char_len);
+        else if ((unsigned char)*p >= 0x80) char_len = 2;
+        if (strnlen(p, char_len) < (size_t)char_len) break;
+        if (*p == ' ') spaces++;
+        chars++;
+        p += char_len;
+    }
+    return SpacesOnly ? spaces : chars - 1;
+}
+
+static void paint_string_cn(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, int Extra, bool SpacesOnly,
+                            UWORD Color_Foreground, UWORD Color_Background)
 {
     const char *p_text;
     int x, y;
-    int char_len;
-    char current_char[6];
     size_t buf_len;
     unsigned char *font_buffer = NULL;
-    int read_size;
+    uint32_t codepoints[FONT_BATCH_MAX];
+    unsigned char *glyphs[FONT_BATCH_MAX];
+    int glyph_len[FONT_BATCH_MAX];
+    uint8_t char_lens[FONT_BATCH_MAX];
+    unsigned char *paper;
+    uint32_t prev = 0;
+    int gaps = 0, gap_index = 0, gap = 0;
 
     if (!pString || !font) {
         ESP_LOGE(TAG, "Paint_DrawString_CN: The parameter is empty.");
@@ -558,72 +971,138 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT
     p_text = pString;
     x = Xstart;
     y = Ystart;
+    if (Extra != 0) gaps = paint_string_gaps(pString, font, SpacesOnly);
+    if (gaps <= 0) Extra = 0;
 
+    // Glyphs are fetched a batch at a time, as many as fit PAINT_GLYPH_BATCH_BYTES
     buf_len = (font->size_CH > font->size_EN) ? font->size_CH : font->size_EN;
     if (buf_len == 0) buf_len = 256; // 保底
-    font_buffer = (unsigned char*)malloc(buf_len);
+    int batch = PAINT_GLYPH_BATCH_BYTES / buf_len;
+    if (batch < 1) batch = 1;
+    if (batch > FONT_BATCH_MAX) batch = FONT_BATCH_MAX;
+    // One more glyph of paper for the proportional glyphs
+    font_buffer = (unsigned char*)mem_alloc(buf_len * (batch + 1));
     if (!font_buffer) {
-        ESP_LOGE(TAG, "Paint_DrawString_CN: font_buffer malloc failed size=%zu", buf_len);
+        ESP_LOGE(TAG, "Paint_DrawString_CN: font_buffer malloc failed size=%zu", buf_len * (batch + 1));
         return;
     }
+    for (int i = 0; i < batch; i++)
+        glyphs[i] = font_buffer + buf_len * i;
+    paper = font_buffer + buf_len * batch;
+    memset(paper, 0xFF, buf_len);
 
     // ESP_LOGD(TAG, "开始绘制中文字符串: %s", pString);
 
     while (*p_text != '\0') {
-        if (font->encoding == FONT_ENCODING_UTF8) {
-            char_len = Get_UTF8_Char_Length((unsigned char)*p_text);
-            if (char_len <= 0) char_len = 1;
-        } else { 
-            char_len = ((unsigned char)*p_text < 0x80) ? 1 : 2;
-        }
-
-        if (char_len >= (int)sizeof(current_char)) char_len = (int)sizeof(current_char) - 1;
-        memset(current_char, 0, sizeof(current_char));
-        memcpy(current_char, p_text, char_len);
-        current_char[char_len] = '\0';
-
-        read_size = Get_Char_Font_Data((void*)font, current_char, font_buffer);
-        if (read_size <= 0) {
-            ESP_LOGW(TAG, "The character pattern cannot be read: %s", current_char);
+        // Decode the next batch of characters
+        const char *p_batch = p_text;
+        int n = 0;
+        while (n < batch && *p_text != '\0') {
+            int char_len;
+            if (font->encoding == FONT_ENCODING_UTF8) {
+                codepoints[n] = UTF8_To_Unicode(p_text, &char_len);
+            } else {
+                char_len = ((unsigned char)*p_text < 0x80) ? 1 : 2;
+                codepoints[n] = GBK_To_Unicode(p_text);
+            }
+            // A sequence cut short by the end of the string is dropped
+            if (strnlen(p_text, char_len) < (size_t)char_len) {
+                p_text += strlen(p_text);
+                break;
+            }
+            char_lens[n++] = (uint8_t)char_len;
             p_text += char_len;
-            continue;
         }
+        Font_FetchGlyphs(font, codepoints, n, glyphs, glyph_len);
 
-        int char_width = (char_len == 1) ? font->Width_EN : font->Width_CH;
-        int char_height = font->Height;
+        const char *p_char = p_batch;
+        for (int i = 0; i < n; p_char += char_lens[i], i++) {
+            if (glyph_len[i] <= 0) {
+                ESP_LOGW(TAG, "The character pattern cannot be read: %.*s", char_lens[i], p_char);
+                continue;
+            }
 
-        if (x + char_width > Paint.Width) {
-            x = Xstart;
-            y += char_height;
-        }
+            uint32_t cp = codepoints[i];
+            int kern = Font_Kerning(font, prev, cp);
+            int advance = Font_Advance(font, cp);
+            int char_height = font->Height;
 
-        if (y + char_height > Paint.Height) {
-            ESP_LOGW(TAG, "Paint_DrawString_CN: Stop drawing when it exceeds the display area");
-            break;
-        }
+            if (x + kern + advance > Paint.Width) {
+                x = Xstart;
+                y += char_height;
+                kern = 0;
+            }
 
-        const unsigned char *ptr = font_buffer;
-        int row, col;
-        for (row = 0; row < char_height; row++) {
-            for (col = 0; col < char_width; col++) {
-                if (*ptr & (0x80 >> (col % 8))) {
-                    Paint_SetPixel(x + col, y + row, Color_Foreground);
-                } else {
-                    Paint_SetPixel(x + col, y + row, Color_Background);
-                }
-                if (col % 8 == 7) ptr++;
+            if (y + char_height > Paint.Height) {
+                ESP_LOGW(TAG, "Paint_DrawString_CN: Stop drawing when it exceeds the display area");
+                goto done;
             }
-            if (char_width % 8 != 0) ptr++;
-        }
 
-        p_text += char_len;
-        x += char_width;
+            if (cp < 0x80 && font->metrics_EN) {
+                paint_glyph_prop(x - gap, x + kern, y, advance, Font_Bearing(font, cp), glyphs[i], paper,
+                                 font, Color_Foreground, Color_Background);
+            } else {
+                Paint_DrawGlyph(x, y, glyphs[i], (cp < 0x80) ? font->Width_EN : font->Width_CH,
+                                char_height, Color_Foreground, Color_Background);
+            }
+            x += kern + advance;
+            prev = cp;
+
+            // The k-th gap gets its share of Extra, rounding spread along the line
+            gap = 0;
+            if (Extra && gap_index < gaps && (!SpacesOnly || cp == ' ')) {
+                gap = Extra * (gap_index + 1) / gaps - Extra * gap_index / gaps;
+                gap_index++;
+                x += gap;
+            }
+        }
     }
 
-    free(font_buffer);
+done:
+    mem_free(font_buffer);
     // ESP_LOGD(TAG, "中文字符串绘制完成");
 }
 
+/******************************************************************************
+function: Display the string
+parameter:
+    Xstart  ：X coordinate
+    Ystart  ：Y coordinate
+    pString ：The first address of the Chinese string and English
+              string to be displayed
+    Font    ：A structure pointer that displays a character size
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    The glyphs of a line are fetched together with Font_FetchGlyphs.
+    English characters are placed by the font's proportional metrics when
+    it has them, see Font_Advance; Font_TextWidth gives the same widths.
+******************************************************************************/
+void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    paint_string_cn(Xstart, Ystart, pString, font, 0, false, Color_Foreground, Color_Background);
+}
+
+/******************************************************************************
+function: Display a justified line
+parameter:
+    Xstart  ：X coordinate
+    Ystart  ：Y coordinate
+    pString ：The line, as for Paint_DrawString_CN
+    Font    ：A structure pointer that displays a character size
+    Extra   ：Pixels added to the line's width, negative to narrow it
+    SpacesOnly : Spread Extra over the spaces, else between all characters
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    Used with the line breaker (components/text_layout), which gives Extra.
+******************************************************************************/
+void Paint_DrawStringSpaced_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, int Extra, bool SpacesOnly,
+                               UWORD Color_Foreground, UWORD Color_Background)
+{
+    paint_string_cn(Xstart, Ystart, pString, font, Extra, SpacesOnly, Color_Foreground, Color_Background);
+}
+
 /******************************************************************************
 function:	Display nummber
 parameter:
@@ -753,15 +1232,7 @@ info:
 ******************************************************************************/
 void Paint_DrawBitMap(const unsigned char* image_buffer)
 {
-    UWORD x, y;
-    UDOUBLE Addr = 0;
-
-    for (y = 0; y < Paint.HeightByte; y++) {
-        for (x = 0; x < Paint.WidthByte; x++) {//8 pixel =  1 byte
-            Addr = x + y * Paint.WidthByte;
-            Paint.Image[Addr] = (unsigned char)image_buffer[Addr];
-        }
-    }
+    memcpy(Paint.Image, image_buffer, (UDOUBLE)Paint.WidthByte * Paint.HeightByte);
 }
 
 
@@ -779,9 +1250,7 @@ info:
 ******************************************************************************/
 void Paint_ReadBmp(const unsigned char* image_buffer, UWORD Xstart, UWORD Ystart, UWORD Width, UWORD Height)
 {
-    UWORD x, y;
-    UBYTE Color;
-    const unsigned char *ptr = image_buffer;
+    BLIT b;
 
     Width = (Width%8 ==0)?Width:(Width/8+1)*8;
 
@@ -789,14 +1258,11 @@ void Paint_ReadBmp(const unsigned char* image_buffer, UWORD Xstart, UWORD Ystart
         ESP_LOGI(TAG,"Paint_DrawChar Input exceeds the normal display range");
         return;
     }
-    for (y = 0; y < Height; y++) {
-        for (x = 0; x < Width; x++) {//8 pixel =  1 byte
-            Color = !(*ptr & (0x80 >> (x % 8)));
-            Paint_SetPixel(Xstart + x, Ystart + y, Color);
-            if (x % 8 == 7)
-                ptr++;
-        }
-    }
+    if (Width == 0 || Height == 0)
+        return;
+
+    blit_setup(&b, Xstart, Ystart, Width, Height, BLIT_FILL, BLACK, WHITE);
+    blit_raw(&b, image_buffer);
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef __GUI_PAINT_H
 #define __GUI_PAINT_H
 
+#include <stdbool.h>
 #include "DEV_Config.h"
 #include "../Fonts/font.h"
 #include "../Fonts/fonts.h"
@@ -48,6 +49,7 @@ typedef enum {
 #define WHITE          0xFF
 #define BLACK          0x00
 #define RED            BLACK
+#define TRANSPARENT    0xFFFF   // Background only: leave the frame as it is
 
 #define IMAGE_BACKGROUND    WHITE
 #define FONT_FOREGROUND     BLACK
@@ -99,6 +101,33 @@ typedef enum {
     DRAW_FILL_FULL,
 } DRAW_FILL;
 
+/**
+ * Raster operation of Paint_BlitImage, in terms of ink (black)
+**/
+typedef enum {
+    ROP_COPY = 0,       // Frame = image
+    ROP_OR,             // Add the image ink, background stays
+    ROP_AND,            // Keep frame ink only under image ink
+    ROP_XOR,            // Invert the frame under image ink
+    ROP_INVERT,         // Frame = inverted image
+} PAINT_ROP;
+
+/**
+ * Image storage format
+**/
+typedef enum {
+    IMAGE_RAW = 0,      // Rows padded to whole bytes, 1 = black, MSB first
+    IMAGE_PACKBITS,     // Same rows, each XORed with the one above, PackBits coded
+} IMAGE_FORMAT;
+
+typedef struct {
+    const UBYTE *Data;
+    UDOUBLE Size;       // Bytes of Data
+    UWORD Width;
+    UWORD Height;
+    UBYTE Format;       // IMAGE_FORMAT
+} PAINT_IMAGE;
+
 /**
  * Custom structure of a time attribute
 **/
@@ -134,10 +163,12 @@ void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWO
 void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
 
 //Display string
+void Paint_DrawGlyph(UWORD Xstart, UWORD Ystart, const UBYTE *Glyph, UWORD Width, UWORD Height, UWORD Color_Foreground, UWORD Color_Background);
 // 修改所有的 sFONT 为 cFONT
 void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawStringSpaced_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* Font, int Extra, bool SpacesOnly, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawNumDecimals(UWORD Xpoint, UWORD Ypoint, double Nummber, sFONT* Font, UWORD Digit, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
@@ -145,6 +176,7 @@ void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
 //pic
 void Paint_DrawBitMap(const unsigned char* image_buffer);
 void Paint_ReadBmp(const unsigned char* image_buffer, UWORD Xstart, UWORD Ystart, UWORD Width, UWORD Height);
+void Paint_BlitImage(UWORD Xstart, UWORD Ystart, const PAINT_IMAGE *Image, PAINT_ROP Rop);
 
 #ifdef __cplusplus
 }
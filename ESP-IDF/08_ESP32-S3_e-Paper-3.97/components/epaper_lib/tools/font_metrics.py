@@ -0,0 +1,351 @@
+#!/usr/bin/env python3
+"""
+Generate Fonts/font_metrics.c, the proportional metrics of the English fonts.
+
+The English .FON files are fixed cells of (Width_EN x Height), one per ASCII
+character from 0x20, stored row by row, MSB first, with set bits for paper and
+clear bits for ink. The metrics let a fixed cell be drawn at a proportional
+position:
+
+    advance[c - 0x20]   pixels the pen moves for c
+    bearing[c - 0x20]   where the cell starts relative to the pen
+    kern[]              (left, right, adjust) pairs sorted by left then right,
+                        adjust is added to the pen before drawing right
+
+The ink of every glyph lies in [pen, pen + advance), which lets the renderer
+fill the paper of one glyph without touching its neighbours.
+
+Sources, one per size:
+    12=Fonts/Font12/font12EN.FON    metrics from the ink of an existing cell font
+    24=myfont.bdf                   a BDF font, also written as a .FON cell font
+                                    into --fon-dir (fontNNEN.FON)
+
+Digits get the same advance so numbers keep their width. Kerning pairs of
+letters and the punctuation in KERN_CHARS come from the glyph outlines: two
+glyphs are moved closer when the gap between them, with the ink of the left one
+spread a few rows up and down, is wider than the gap of the font's own "nn".
+--kern FILE adds or overrides pairs, one "AV -2" per line ('#' starts a comment).
+
+Usage: font_metrics.py [-o OUT.c] [--fon-dir DIR] [--kern FILE] SIZE=FILE...
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from font_pack import GEOMETRY  # noqa: E402
+
+FIRST, LAST = 0x20, 0x7E
+COUNT = LAST - FIRST + 1
+MAX_KERN = 128              # pairs kept per size, largest adjustments first
+DIGITS = "0123456789"
+KERN_CHARS = set("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz.,:;-'\"")
+
+
+class Cell:
+    """A glyph as rows of ink bits, bit i = column i."""
+
+    def __init__(self, rows, width):
+        self.rows = rows
+        self.width = width
+
+    def extent(self):
+        ink = 0
+        for r in self.rows:
+            ink |= r
+        if not ink:
+            return None
+        return (ink & -ink).bit_length() - 1, ink.bit_length()
+
+
+def read_fon(path, width, height):
+    rb = (width + 7) // 8
+    size = rb * height
+    raw = open(path, "rb").read()
+    cells = {}
+    for c in range(FIRST, LAST + 1):
+        g = raw[(c - FIRST) * size:(c - FIRST + 1) * size]
+        if len(g) < size:
+            break
+        rows = []
+        for y in range(height):
+            bits = int.from_bytes(g[y * rb:(y + 1) * rb], "big") >> (rb * 8 - width)
+            ink = 0
+            for x in range(width):
+                if not bits & (1 << (width - 1 - x)):
+                    ink |= 1 << x
+            rows.append(ink)
+        cells[c] = Cell(rows, width)
+    return raw, cells
+
+
+def write_fon(path, cells, width, height):
+    rb = (width + 7) // 8
+    out = bytearray()
+    for c in range(FIRST, LAST + 2):
+        cell = cells.get(c)
+        for y in range(height):
+            ink = cell.rows[y] if cell else 0
+            bits = 0
+            for x in range(rb * 8):
+                if x >= width or not ink & (1 << x):
+                    bits |= 0x80 >> (x % 8) << (8 * (rb - 1 - x // 8))
+            out += bits.to_bytes(rb, "big")
+    with open(path, "wb") as f:
+        f.write(out)
+
+
+def read_bdf(path, width, height):
+    """BDF glyphs as cells with the ink at column 0, plus advance and bearing."""
+    ascent = descent = None
+    glyphs = {}
+    cur = None
+    bitmap = None
+    for line in open(path, encoding="latin-1"):
+        key, _, rest = line.strip().partition(" ")
+        if key == "FONT_ASCENT":
+            ascent = int(rest)
+        elif key == "FONT_DESCENT":
+            descent = int(rest)
+        elif key == "STARTCHAR":
+            cur = {"enc": -1, "dw": 0, "bbx": (0, 0, 0, 0)}
+        elif key == "ENCODING" and cur is not None:
+            cur["enc"] = int(rest.split()[0])
+        elif key == "DWIDTH" and cur is not None:
+            cur["dw"] = int(rest.split()[0])
+        elif key == "BBX" and cur is not None:
+            cur["bbx"] = tuple(int(v) for v in rest.split())
+        elif key == "BITMAP" and cur is not None:
+            bitmap = []
+        elif key == "ENDCHAR" and cur is not None:
+            if FIRST <= cur["enc"] <= LAST:
+                cur["bitmap"] = bitmap or []
+                glyphs[cur["enc"]] = cur
+            cur = bitmap = None
+        elif bitmap is not None:
+            bitmap.append(int(key, 16) if key else 0)
+    if ascent is None or descent is None:
+        sys.exit("font_metrics: %s has no FONT_ASCENT/FONT_DESCENT" % path)
+
+    # Baseline so that ascent + descent is centred in the cell
+    baseline = (height - ascent - descent) // 2 + ascent
+    cells, advance, bearing = {}, {}, {}
+    for c, g in glyphs.items():
+        w, h, xoff, yoff = g["bbx"]
+        nbits = (w + 7) // 8 * 8
+        rows = [0] * height
+        top = baseline - yoff - h
+        clipped = w > width
+        for i, bits in enumerate(g["bitmap"][:h]):
+            y = top + i
+            if not 0 <= y < height:
+                clipped |= bits != 0
+                continue
+            for x in range(min(w, width)):
+                if bits & (1 << (nbits - 1 - x)):
+                    rows[y] |= 1 << x
+        if clipped:
+            print("font_metrics: %s: glyph 0x%02X clipped to the %dx%d cell" % (path, c, width, height),
+                  file=sys.stderr)
+        cells[c] = Cell(rows, width)
+        lsb = max(xoff, 0)
+        bearing[c] = lsb
+        advance[c] = max(g["dw"], lsb + min(w, width))
+    return cells, advance, bearing
+
+
+def fon_metrics(cells, width):
+    """Advance and bearing from the ink of a cell font."""
+    side = max(1, round(width / 12))
+    advance, bearing = {}, {}
+    for c, cell in cells.items():
+        ext = cell.extent()
+        if ext is None:
+            continue
+        left, right = ext
+        adv = side + (right - left) + side
+        if adv >= width:
+            advance[c], bearing[c] = width, 0
+        else:
+            advance[c], bearing[c] = adv, side - left
+    n = advance.get(ord("n"), width)
+    advance[0x20], bearing[0x20] = max(2, round(n * 0.6)), 0
+    return advance, bearing
+
+
+def tabular_digits(cells, advance, bearing):
+    """Give every digit the widest digit advance, ink centred."""
+    digits = [ord(d) for d in DIGITS if ord(d) in advance]
+    if not digits:
+        return
+    wide = max(advance[d] for d in digits)
+    for d in digits:
+        ext = cells[d].extent()
+        if ext is None:
+            continue
+        left, right = ext
+        bearing[d] = (wide - (right - left)) // 2 - left
+        advance[d] = wide
+
+
+def profile(cell, bearing, right):
+    """Per row, the pen-relative column of the rightmost (or leftmost) ink, None if empty."""
+    out = []
+    for r in cell.rows:
+        if not r:
+            out.append(None)
+        elif right:
+            out.append(bearing + r.bit_length() - 1)
+        else:
+            out.append(bearing + (r & -r).bit_length() - 1)
+    return out
+
+
+def dilate(right, window):
+    """Rightmost ink of the rows within window of each row."""
+    n = len(right)
+    out = []
+    for y in range(n):
+        near = [v for v in right[max(0, y - window):y + window + 1] if v is not None]
+        out.append(max(near) if near else None)
+    return out
+
+
+def gap(a_right, a_adv, b_left):
+    """Smallest run of paper between a and b set side by side."""
+    best = None
+    for ra, lb in zip(a_right, b_left):
+        if ra is None or lb is None:
+            continue
+        g = a_adv + lb - ra - 1
+        if best is None or g < best:
+            best = g
+    return best
+
+
+def auto_kern(cells, advance, bearing, height):
+    chars = [c for c in cells if chr(c) in KERN_CHARS and cells[c].extent()]
+    window = max(1, height // 8)
+    right = {c: dilate(profile(cells[c], bearing[c], True), window) for c in chars}
+    left = {c: profile(cells[c], bearing[c], False) for c in chars}
+    n = ord("n")
+    if n not in right:
+        return {}
+    normal = gap(right[n], advance[n], left[n])
+    pairs = {}
+    for a in chars:
+        for b in chars:
+            g = gap(right[a], advance[a], left[b])
+            if g is None or g - normal < 2:
+                continue
+            adjust = -min(g - normal, max(1, advance[b] // 5))
+            pairs[(a, b)] = adjust
+    return pairs
+
+
+def read_kern_file(path):
+    pairs = {}
+    for line in open(path, encoding="utf-8"):
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        pair, adjust = line.split()
+        if len(pair) != 2 or not all(FIRST < ord(ch) <= LAST for ch in pair):
+            sys.exit("font_metrics: bad kerning pair %r in %s" % (pair, path))
+        pairs[(ord(pair[0]), ord(pair[1]))] = int(adjust)
+    return pairs
+
+
+def check(cells, advance, bearing, width, name):
+    """Ink must stay in [pen, pen + advance) and the tables must fit their types."""
+    for c, cell in cells.items():
+        ext = cell.extent()
+        if c not in advance or ext is None:
+            continue
+        left, right = ext
+        if bearing[c] + left < 0 or bearing[c] + right > advance[c]:
+            sys.exit("font_metrics: %s: ink of 0x%02X outside its advance" % (name, c))
+        if not 0 < advance[c] <= 255 or not -128 <= bearing[c] <= 127:
+            sys.exit("font_metrics: %s: metrics of 0x%02X out of range" % (name, c))
+
+
+def emit(sizes, out):
+    w = out.write
+    w("/* Generated by tools/font_metrics.py, do not edit */\n")
+    w('#include "font.h"\n')
+    for size, (width, advance, bearing, kern) in sorted(sizes.items()):
+        adv = [advance.get(c, width) for c in range(FIRST, LAST + 1)]
+        bear = [bearing.get(c, 0) for c in range(FIRST, LAST + 1)]
+        w("\nstatic const uint8_t font%d_advance[FONT_METRICS_COUNT] = {\n" % size)
+        for i in range(0, COUNT, 16):
+            w("    " + " ".join("%3d," % v for v in adv[i:i + 16]) + "\n")
+        w("};\n\nstatic const int8_t font%d_bearing[FONT_METRICS_COUNT] = {\n" % size)
+        for i in range(0, COUNT, 16):
+            w("    " + " ".join("%3d," % v for v in bear[i:i + 16]) + "\n")
+        w("};\n")
+        if kern:
+            w("\nstatic const FONT_KERN font%d_kern[] = {\n" % size)
+            items = sorted(kern.items())
+            for i in range(0, len(items), 6):
+                w("    " + " ".join("{'%s', '%s', %d}," % (esc(a), esc(b), v)
+                                    for (a, b), v in items[i:i + 6]) + "\n")
+            w("};\n")
+        w("\nconst FONT_METRICS Font%d_Metrics = {\n" % size)
+        w("    .advance = font%d_advance,\n" % size)
+        w("    .bearing = font%d_bearing,\n" % size)
+        if kern:
+            w("    .kern = font%d_kern,\n" % size)
+            w("    .kern_count = sizeof(font%d_kern) / sizeof(font%d_kern[0]),\n" % (size, size))
+        w("};\n")
+
+
+def esc(c):
+    ch = chr(c)
+    return "\\" + ch if ch in "\\'" else ch
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Generate proportional metrics for the English fonts")
+    ap.add_argument("sources", nargs="+", metavar="SIZE=FILE")
+    ap.add_argument("-o", "--output", default="-")
+    ap.add_argument("--fon-dir", help="where cell fonts converted from BDF are written")
+    ap.add_argument("--kern", help="kerning pairs added to every size")
+    args = ap.parse_args()
+
+    extra = read_kern_file(args.kern) if args.kern else {}
+    sizes = {}
+    for spec in args.sources:
+        size, _, path = spec.partition("=")
+        if not size.isdigit() or int(size) not in GEOMETRY or not path:
+            ap.error("bad source %r, expected SIZE=FILE with SIZE one of %s"
+                     % (spec, ", ".join(str(s) for s in sorted(GEOMETRY))))
+        size = int(size)
+        width, _, height = GEOMETRY[size]
+        if path.lower().endswith(".bdf"):
+            cells, advance, bearing = read_bdf(path, width, height)
+            if not args.fon_dir:
+                ap.error("--fon-dir is required for BDF sources")
+            write_fon(os.path.join(args.fon_dir, "font%dEN.FON" % size), cells, width, height)
+        else:
+            _, cells = read_fon(path, width, height)
+            advance, bearing = fon_metrics(cells, width)
+        tabular_digits(cells, advance, bearing)
+        check(cells, advance, bearing, width, path)
+
+        kern = auto_kern(cells, advance, bearing, height)
+        kern = dict(sorted(kern.items(), key=lambda kv: kv[1])[:MAX_KERN])
+        kern.update(extra)
+        kern = {k: v for k, v in kern.items() if v}
+        sizes[size] = (width, advance, bearing, kern)
+
+    if args.output == "-":
+        emit(sizes, sys.stdout)
+    else:
+        with open(args.output, "w") as f:
+            emit(sizes, f)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+Pack a .FON bitmap font into the compressed .FON container read by font_fz.c.
+
+A .FON file is an array of fixed-size glyphs, each stored row by row, MSB first,
+(width + 7) / 8 bytes per row. The container groups the glyphs into blocks, and
+each block is compressed on its own so any glyph can be reached by decoding one
+block:
+
+    header   "FZ1\\0", glyph_size:u16, row_bytes:u16, block_glyphs:u16, reserved:u16,
+             glyph_count:u32, block_count:u32                              (20 bytes)
+    offsets  block_count + 1 x u32, start of each block relative to the data area
+    data     compressed blocks
+
+Each glyph row is XORed with the row above it (the first row with zero), which
+turns the vertical strokes of CJK glyphs into zero bytes. The block is then cut
+into 8-byte groups, each coded as a mask byte (bit 7 = first byte) followed by
+its non-zero bytes. A zero mask is followed by n, standing for n + 1 all-zero
+groups. Decoding is a byte loop with no tables, a few microseconds per glyph.
+
+Usage:
+    font_pack.py IN.FON OUT --width W --height H [--block 64]
+    font_pack.py --stats DIR...        compression ratio of every known .FON file
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"FZ1\0"
+HEADER = struct.Struct("<4sHHHHII")
+DEFAULT_BLOCK = 64
+
+# Glyph geometry from font.h: size -> (EN width, CH width, height)
+GEOMETRY = {
+    12: (8, 16, 21),
+    16: (16, 24, 28),
+    18: (16, 24, 31),
+    24: (24, 32, 41),
+    28: (24, 40, 48),
+    36: (32, 48, 62),
+    48: (40, 64, 83),
+    80: (80, 0, 106),
+    182: (120, 0, 182),
+}
+
+
+def geometry_for(name):
+    """Width and height of the glyphs in a .FON file, from its name."""
+    m = re.search(r"font(\d+)(EN|CH)", os.path.basename(name))
+    if not m or int(m.group(1)) not in GEOMETRY:
+        return None
+    en_w, ch_w, h = GEOMETRY[int(m.group(1))]
+    return (en_w if m.group(2) == "EN" else ch_w), h
+
+
+def xor_rows(block, row_bytes, glyph_size):
+    out = bytearray(block)
+    for g in range(0, len(block), glyph_size):
+        # Walk backwards so every row is XORed with the original row above it
+        for r in range(glyph_size - row_bytes, 0, -row_bytes):
+            for b in range(row_bytes):
+                out[g + r + b] ^= block[g + r - row_bytes + b]
+    return out
+
+
+def zero_mask(data):
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        group = data[i:i + 8]
+        if not any(group):
+            run = 0
+            while i < n and run < 256 and not any(data[i:i + 8]):
+                run += 1
+                i += 8
+            out += bytes([0, run - 1])
+            continue
+        mask = 0
+        nonzero = bytearray()
+        for j, b in enumerate(group):
+            if b:
+                mask |= 0x80 >> j
+                nonzero.append(b)
+        out.append(mask)
+        out += nonzero
+        i += 8
+    return out
+
+
+def pack(raw, width, height, block_glyphs=DEFAULT_BLOCK):
+    row_bytes = (width + 7) // 8
+    glyph_size = row_bytes * height
+    glyph_count = len(raw) // glyph_size
+    block_count = (glyph_count + block_glyphs - 1) // block_glyphs
+
+    offsets = []
+    data = bytearray()
+    for blk in range(block_count):
+        start = blk * block_glyphs * glyph_size
+        end = min(start + block_glyphs * glyph_size, glyph_count * glyph_size)
+        offsets.append(len(data))
+        data += zero_mask(xor_rows(raw[start:end], row_bytes, glyph_size))
+    offsets.append(len(data))
+
+    header = HEADER.pack(MAGIC, glyph_size, row_bytes, block_glyphs, 0, glyph_count, block_count)
+    return header + struct.pack("<%dI" % len(offsets), *offsets) + data
+
+
+def unpack(blob):
+    """Reference decoder, used to check every packed file."""
+    magic, glyph_size, row_bytes, block_glyphs, _, glyph_count, block_count = HEADER.unpack_from(blob)
+    assert magic == MAGIC
+    table = HEADER.size
+    offsets = struct.unpack_from("<%dI" % (block_count + 1), blob, table)
+    base = table + 4 * (block_count + 1)
+    out = bytearray()
+    for blk in range(block_count):
+        src = blob[base + offsets[blk]:base + offsets[blk + 1]]
+        length = min(block_glyphs, glyph_count - blk * block_glyphs) * glyph_size
+        dec = bytearray()
+        i = 0
+        while len(dec) < length:
+            mask = src[i]
+            i += 1
+            if mask == 0:
+                dec += bytes(8 * (src[i] + 1))
+                i += 1
+                continue
+            for j in range(8):
+                if mask & (0x80 >> j):
+                    dec.append(src[i])
+                    i += 1
+                else:
+                    dec.append(0)
+        del dec[length:]
+        for g in range(0, len(dec), glyph_size):
+            for r in range(row_bytes, glyph_size, row_bytes):
+                for b in range(row_bytes):
+                    dec[g + r + b] ^= dec[g + r - row_bytes + b]
+        out += dec
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Compress a .FON font into a block-indexed container")
+    ap.add_argument("input", nargs="?")
+    ap.add_argument("output", nargs="?")
+    ap.add_argument("--width", type=int)
+    ap.add_argument("--height", type=int)
+    ap.add_argument("--block", type=int, default=DEFAULT_BLOCK)
+    ap.add_argument("--verify", action="store_true", help="decode the result and compare")
+    ap.add_argument("--stats", nargs="+", metavar="DIR")
+    args = ap.parse_args()
+
+    if args.stats:
+        total_in = total_out = 0
+        for d in args.stats:
+            for name in sorted(os.listdir(d)):
+                geo = geometry_for(name)
+                if not name.endswith(".FON") or geo is None:
+                    continue
+                raw = open(os.path.join(d, name), "rb").read()
+                packed = pack(raw, geo[0], geo[1], args.block)
+                total_in += len(raw)
+                total_out += len(packed)
+                print("%-28s %9d -> %9d  %5.1f%%" % (name, len(raw), len(packed), 100.0 * len(packed) / len(raw)))
+        if total_in:
+            print("%-28s %9d -> %9d  %5.1f%%" % ("total", total_in, total_out, 100.0 * total_out / total_in))
+        return 0
+
+    if not args.input or not args.output:
+        ap.error("input and output are required")
+    width, height = args.width, args.height
+    if width is None or height is None:
+        geo = geometry_for(args.input)
+        if geo is None:
+            ap.error("cannot tell the glyph size from the file name, pass --width and --height")
+        width, height = geo
+
+    raw = open(args.input, "rb").read()
+    packed = pack(raw, width, height, args.block)
+    if args.verify:
+        glyph_size = ((width + 7) // 8) * height
+        if unpack(packed) != raw[:len(raw) // glyph_size * glyph_size]:
+            sys.exit("font_pack: round trip failed for %s" % args.input)
+    with open(args.output, "wb") as f:
+        f.write(packed)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""
+Generate Fonts/gb2312_map.c, the Unicode <-> GB2312 tables used by fonts.c.
+
+The GB2312 area of the GBK fonts (rows A1-A9 and B0-F7, columns A1-FE) is
+decoded with Python's GBK codec, which also covers the few GBK additions in
+those rows (small Roman numerals, vertical punctuation) that have glyphs in
+the font files.
+
+    gb2312_fwd_index[hi]      page of the code points 0xhi00-0xhiFF, or 0xFF
+    gb2312_fwd_pages[p][lo]   GB2312 code, 0 if none
+    gb2312_rev[row][col]      Unicode code point of 0xA1A1 + (row << 8) + col, 0 if none
+
+Usage:
+    gen_gb2312_map.py [OUT.c]
+    gen_gb2312_map.py --pairs OUT.h     every code and its code point as a flat list, in
+                                        code order, for the host test to scan linearly
+"""
+
+import os
+import sys
+
+ROWS = list(range(0xA1, 0xAA)) + list(range(0xB0, 0xF8))
+FIRST_ROW, LAST_ROW = 0xA1, 0xF7
+FIRST_COL, LAST_COL = 0xA1, 0xFE
+
+# Code points that other converters produce for the same GB2312 characters
+ALIASES = {
+    0x30FB: 0xA1A4,     # KATAKANA MIDDLE DOT for the middle dot
+    0x2015: 0xA1AA,     # HORIZONTAL BAR for the em dash
+}
+
+
+def build():
+    fwd = {}
+    rev = {}
+    for b1 in ROWS:
+        for b2 in range(FIRST_COL, LAST_COL + 1):
+            try:
+                ch = bytes([b1, b2]).decode("gbk")
+            except UnicodeDecodeError:
+                continue
+            cp = ord(ch)
+            gb = (b1 << 8) | b2
+            rev[gb] = cp
+            fwd.setdefault(cp, gb)
+    for cp, gb in ALIASES.items():
+        fwd.setdefault(cp, gb)
+    return fwd, rev
+
+
+def emit(fwd, rev, out):
+    pages = sorted({cp >> 8 for cp in fwd})
+    index = [0xFF] * 256
+    for i, hi in enumerate(pages):
+        index[hi] = i
+
+    w = out.write
+    w("/* Generated by tools/gen_gb2312_map.py, do not edit */\n")
+    w('#include "gb2312_map.h"\n\n')
+    w("const uint8_t gb2312_fwd_index[256] = {\n")
+    for i in range(0, 256, 16):
+        w("    " + " ".join("0x%02X," % v for v in index[i:i + 16]) + "\n")
+    w("};\n\n")
+    w("const uint16_t gb2312_fwd_pages[][256] = {\n")
+    for hi in pages:
+        w("    { // U+%02X00\n" % hi)
+        row = [fwd.get((hi << 8) | lo, 0) for lo in range(256)]
+        for i in range(0, 256, 16):
+            w("        " + " ".join("0x%04X," % v for v in row[i:i + 16]) + "\n")
+        w("    },\n")
+    w("};\n\n")
+    w("const uint16_t gb2312_rev[GB2312_ROWS][GB2312_COLS] = {\n")
+    for b1 in range(FIRST_ROW, LAST_ROW + 1):
+        row = [rev.get((b1 << 8) | b2, 0) for b2 in range(FIRST_COL, LAST_COL + 1)]
+        w("    { // 0x%02XA1\n" % b1)
+        for i in range(0, len(row), 16):
+            w("        " + " ".join("0x%04X," % v for v in row[i:i + 16]) + "\n")
+        w("    },\n")
+    w("};\n")
+    return len(pages)
+
+
+def emit_pairs(rev, out):
+    w = out.write
+    w("/* Generated by tools/gen_gb2312_map.py --pairs, do not edit */\n")
+    w("// GB2312 code and Unicode code point, in code order\n")
+    w("static const uint16_t gb2312_pairs[][2] = {\n")
+    for gb in sorted(rev):
+        w("    {0x%04X, 0x%04X},\n" % (gb, rev[gb]))
+    w("};\n\n")
+    w("// Code points mapped to a code whose own code point is another one\n")
+    w("static const uint16_t gb2312_aliases[][2] = {\n")
+    for cp, gb in sorted(ALIASES.items()):
+        w("    {0x%04X, 0x%04X},\n" % (gb, cp))
+    w("};\n")
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == "--pairs":
+        _, rev = build()
+        with open(sys.argv[2], "w", newline="\n") as f:
+            emit_pairs(rev, f)
+        return 0
+    here = os.path.dirname(os.path.abspath(__file__))
+    path = sys.argv[1] if len(sys.argv) > 1 else os.path.normpath(os.path.join(here, "..", "Fonts", "gb2312_map.c"))
+    fwd, rev = build()
+    with open(path, "w", newline="\n") as f:
+        n = emit(fwd, rev, f)
+    print("%s: %d forward entries in %d pages, %d reverse entries" % (path, len(fwd), n, len(rev)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
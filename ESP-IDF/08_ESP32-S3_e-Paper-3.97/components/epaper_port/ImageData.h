@@ -32,6 +32,9 @@
 #ifndef _IMAGEDATA_H_
 #define _IMAGEDATA_H_
 
+#include "sdkconfig.h"
+#include "GUI_Paint.h"
+
 extern const unsigned char gImage_image[];
 
 
@@ -78,6 +81,36 @@ extern const unsigned char gImage_wendu[];
 // 32*32
 extern const unsigned char gImage_GPS[];
 
+// Packed copies for Paint_BlitImage, ImageData_packed.c is generated
+// from this file by tools/img_pack.py
+extern const PAINT_IMAGE Image_audio;
+extern const PAINT_IMAGE Image_folder;
+extern const PAINT_IMAGE Image_picture;
+extern const PAINT_IMAGE Image_rests;
+extern const PAINT_IMAGE Image_text;
+extern const PAINT_IMAGE Image_WIFI;
+extern const PAINT_IMAGE Image_BAT;
+extern const PAINT_IMAGE Image_alarm;
+extern const PAINT_IMAGE Image_audio_file;
+extern const PAINT_IMAGE Image_calendar;
+extern const PAINT_IMAGE Image_clock;
+extern const PAINT_IMAGE Image_file;
+extern const PAINT_IMAGE Image_network;
+extern const PAINT_IMAGE Image_read;
+extern const PAINT_IMAGE Image_weather;
+extern const PAINT_IMAGE Image_Alarm_clock_time_point;
+extern const PAINT_IMAGE Image_temperature;
+extern const PAINT_IMAGE Image_humidity;
+extern const PAINT_IMAGE Image_point_in_time;
+extern const PAINT_IMAGE Image_BAT_1;
+extern const PAINT_IMAGE Image_fx;
+extern const PAINT_IMAGE Image_quality;
+extern const PAINT_IMAGE Image_shidu;
+extern const PAINT_IMAGE Image_sunrise;
+extern const PAINT_IMAGE Image_sunset;
+extern const PAINT_IMAGE Image_wendu;
+extern const PAINT_IMAGE Image_GPS;
+
 
 #elif defined(CONFIG_IMG_SOURCE_TFCARD)
 // Icon position
@@ -0,0 +1,512 @@
+/* Generated by tools/img_pack.py from ImageData.c, do not edit */
+#include "ImageData.h"
+
+#if defined(CONFIG_IMG_SOURCE_EMBEDDED)
+
+// 32x32, 128 -> 102 bytes
+static const unsigned char gImage_audio_pk[102] = {
+    0XF9,0X00,0X02,0X0F,0XFF,0XF8,0XFE,0X00,0X04,0X04,0X00,0X03,0XFF,0XF2,0XFE,0X00,
+    0X00,0X09,0XFE,0X00,0X14,0X04,0X80,0X00,0X00,0X02,0X40,0X00,0X00,0X0D,0X20,0X00,
+    0X00,0X10,0X90,0X00,0X00,0X24,0X40,0X00,0X00,0X48,0XFE,0X00,0X00,0X10,0XF3,0X00,
+    0X00,0X03,0XFE,0X00,0X04,0X1C,0X80,0X00,0X00,0X02,0XFE,0X00,0X04,0X25,0X80,0X00,
+    0X00,0X08,0XFA,0X00,0X00,0X08,0XFE,0X00,0X01,0X27,0X80,0XFE,0X00,0X07,0X20,0X00,
+    0X00,0X18,0XC0,0X00,0X00,0X07,0XFB,0X00,0X03,0X03,0XFF,0XFF,0XC0,0XFD,0X00,0X03,
+    0X0F,0XFF,0XFF,0XF0,0XFD,0X00,
+};
+const PAINT_IMAGE Image_audio = { gImage_audio_pk, 102, 32, 32, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 58 bytes
+static const unsigned char gImage_folder_pk[58] = {
+    0XF5,0X00,0X01,0X1F,0XFC,0XFB,0X00,0X01,0X07,0XF2,0XFE,0X00,0X00,0X09,0XFE,0X00,
+    0X04,0X04,0XFF,0XF8,0X00,0X02,0XFE,0X00,0X02,0X01,0XFF,0XE0,0XF1,0X00,0X03,0X07,
+    0XFF,0XFF,0XE0,0XFD,0X00,0X03,0X07,0XFF,0XFF,0XE0,0XD9,0X00,0X03,0X07,0XFF,0XFF,
+    0XE0,0XFD,0X00,0X03,0X1F,0XFF,0XFF,0XF8,0XF9,0X00,
+};
+const PAINT_IMAGE Image_folder = { gImage_folder_pk, 58, 32, 32, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 106 bytes
+static const unsigned char gImage_picture_pk[106] = {
+    0XF9,0X00,0X02,0X0F,0XFF,0XF8,0XFE,0X00,0X04,0X04,0X00,0X03,0XFF,0XF2,0XFE,0X00,
+    0X00,0X09,0XFE,0X00,0X11,0X04,0X80,0X00,0X1E,0X02,0X40,0X00,0X21,0X01,0X20,0X00,
+    0X4C,0X80,0X90,0X00,0X12,0X00,0X40,0XFC,0X00,0X0D,0X12,0X06,0X00,0X00,0X4C,0X88,
+    0X00,0X00,0X21,0X10,0X00,0X00,0X1E,0X20,0XFE,0X00,0X03,0X48,0X00,0X00,0X70,0XFE,
+    0X00,0X0D,0X0C,0X90,0X00,0X00,0X03,0X20,0X00,0X00,0X1C,0X40,0X00,0X00,0X03,0X80,
+    0XFB,0X00,0X01,0X1F,0XF8,0XFB,0X00,0X01,0X7F,0XFE,0XF8,0X00,0X03,0X03,0XFF,0XFF,
+    0XC0,0XFD,0X00,0X03,0X0F,0XFF,0XFF,0XF0,0XFD,0X00,
+};
+const PAINT_IMAGE Image_picture = { gImage_picture_pk, 106, 32, 32, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 100 bytes
+static const unsigned char gImage_rests_pk[100] = {
+    0XF9,0X00,0X02,0X0F,0XFF,0XF8,0XFE,0X00,0X04,0X04,0X00,0X03,0XFF,0XF2,0XFE,0X00,
+    0X00,0X09,0XFE,0X00,0X18,0X04,0X80,0X00,0X00,0X02,0X40,0X00,0X00,0X01,0X20,0X00,
+    0X03,0XC0,0X90,0X00,0X04,0X20,0X40,0X00,0X09,0X90,0X00,0X00,0X02,0X40,0XFB,0X00,
+    0X05,0X0C,0X40,0X00,0X00,0X01,0X90,0XFE,0X00,0X00,0X20,0XFE,0X00,0X00,0X40,0XF7,
+    0X00,0X05,0X01,0X80,0X00,0X00,0X01,0X80,0XFE,0X00,0X00,0X40,0XFE,0X00,0X04,0X40,
+    0X00,0X00,0X01,0X80,0XF4,0X00,0X03,0X03,0XFF,0XFF,0XC0,0XFD,0X00,0X03,0X0F,0XFF,
+    0XFF,0XF0,0XFD,0X00,
+};
+const PAINT_IMAGE Image_rests = { gImage_rests_pk, 100, 32, 32, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 71 bytes
+static const unsigned char gImage_text_pk[71] = {
+    0XF9,0X00,0X02,0X0F,0XFF,0XF8,0XFE,0X00,0X04,0X04,0X00,0X03,0XFF,0XF2,0XFE,0X00,
+    0X00,0X09,0XFE,0X00,0X09,0X04,0X80,0X00,0X00,0X02,0X40,0X00,0X00,0X01,0X20,0XFE,
+    0X00,0X00,0X90,0XFE,0X00,0X03,0X40,0X00,0X1F,0XF8,0XFB,0X00,0X01,0X1E,0X78,0XDB,
+    0X00,0X00,0X01,0XFD,0X00,0X00,0X80,0XF4,0X00,0X03,0X03,0XFF,0XFF,0XC0,0XFD,0X00,
+    0X03,0X0F,0XFF,0XFF,0XF0,0XFD,0X00,
+};
+const PAINT_IMAGE Image_text = { gImage_text_pk, 71, 32, 32, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 96 bytes
+static const unsigned char gImage_WIFI_pk[96] = {
+    0XF0,0X00,0X51,0X01,0XC0,0X00,0X00,0X3E,0X3E,0X00,0X01,0XC0,0X01,0XC0,0X06,0X00,
+    0X00,0X30,0X08,0X1F,0XF8,0X08,0X10,0XE0,0X07,0X04,0X21,0X01,0XC0,0XC2,0X06,0X1E,
+    0X3C,0X20,0X08,0X60,0X03,0X10,0X31,0X80,0X00,0X8E,0X02,0X0F,0XF0,0X60,0X04,0X30,
+    0X0C,0X00,0X04,0X40,0X83,0X00,0X03,0X8F,0X78,0XE0,0X00,0X10,0X04,0X00,0X00,0X20,
+    0X02,0X00,0X00,0X07,0XE0,0X00,0X00,0X08,0X1A,0X00,0X00,0X30,0X04,0X00,0X00,0X01,
+    0X80,0X00,0X00,0X02,0X40,0XFB,0X00,0X00,0X02,0XFE,0X00,0X01,0X01,0XC0,0XF0,0X00,
+};
+const PAINT_IMAGE Image_WIFI = { gImage_WIFI_pk, 96, 32, 32, IMAGE_PACKBITS };
+
+// 32x16, 64 -> 37 bytes
+static const unsigned char gImage_BAT_pk[37] = {
+    0XFE,0XFF,0X00,0XFC,0XFD,0X00,0X03,0X3F,0XFF,0XFF,0XF0,0XFD,0X00,0X02,0X0F,0XFF,
+    0XFC,0XFD,0X00,0X00,0X03,0XEA,0X00,0X03,0X03,0X0F,0XFF,0XFC,0XFC,0X00,0X03,0X3F,
+    0XFF,0XFF,0XF0,0XFD,0X00,
+};
+const PAINT_IMAGE Image_BAT = { gImage_BAT_pk, 37, 32, 16, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 681 bytes
+static const unsigned char gImage_alarm_pk[681] = {
+    0XB7,0X00,0X00,0X0F,0XFB,0X00,0X00,0X70,0XFD,0X00,0X00,0X10,0XFB,0X00,0X00,0X88,
+    0XFD,0X00,0X00,0X20,0XFB,0X00,0X00,0X06,0XFD,0X00,0X00,0XC0,0XFB,0X00,0X00,0X81,
+    0XFE,0X00,0X01,0X01,0X03,0XFB,0X00,0X05,0X40,0X80,0X00,0X00,0X06,0X04,0XFB,0X00,
+    0X05,0X20,0X60,0X00,0X00,0X08,0X18,0XFB,0X00,0XFF,0X10,0XFF,0X00,0X5E,0X10,0X20,
+    0X00,0X00,0X07,0XE0,0X00,0X00,0X0C,0X0C,0X00,0X00,0X60,0X40,0X00,0X01,0XF8,0X1F,
+    0XC0,0X00,0X02,0X02,0X00,0X00,0X81,0X80,0X00,0X0E,0X00,0X00,0X38,0X00,0X01,0X81,
+    0X00,0X03,0X02,0X00,0X00,0X70,0X00,0X00,0X07,0X00,0X00,0X40,0X80,0X00,0X0C,0X00,
+    0X01,0X80,0X01,0X00,0X00,0XC0,0X00,0X20,0X40,0X00,0X10,0X00,0X06,0X00,0XFE,0XFF,
+    0X00,0X30,0X00,0X18,0X00,0X00,0X20,0X00,0X18,0X0F,0X00,0X00,0XE0,0X08,0X00,0X04,
+    0X40,0X03,0XC0,0X00,0X60,0X30,0X00,0X00,0X1C,0X06,0X00,0X03,0X80,0XFE,0X00,0X05,
+    0X80,0XC0,0X00,0X00,0X03,0X01,0XFC,0X00,0X01,0X01,0X03,0XFD,0X00,0XFF,0X80,0XFD,
+    0X00,0X01,0X02,0X04,0XFD,0X00,0X01,0X60,0X40,0XFD,0X00,0X01,0X04,0X18,0XFD,0X00,
+    0X01,0X18,0X20,0XFD,0X00,0X01,0X08,0X20,0XFD,0X00,0X01,0X04,0X10,0XFD,0X00,0X01,
+    0X10,0X40,0XFD,0X00,0X01,0X02,0X08,0XFD,0X00,0X01,0X20,0X80,0XFD,0X00,0X01,0X01,
+    0X04,0XFD,0X00,0X00,0X41,0XFB,0X00,0X00,0X82,0XFD,0X00,0X07,0X82,0X00,0X00,0X03,
+    0X80,0X00,0X00,0X41,0XFD,0X00,0X00,0X04,0XFE,0X00,0X03,0X40,0X00,0X00,0X20,0XFE,
+    0X00,0X04,0X01,0X08,0X00,0X00,0X04,0XFE,0X00,0X04,0X10,0X80,0X00,0X00,0X02,0XF5,
+    0X00,0X00,0X10,0XFB,0X00,0X04,0X08,0X40,0X00,0X00,0X04,0XFA,0X00,0X00,0X04,0XFD,
+    0X00,0X00,0X20,0XFA,0X00,0X04,0X20,0X00,0X00,0X08,0X40,0XFB,0X00,0X00,0X02,0XF5,
+    0X00,0X00,0X10,0XFE,0X00,0X00,0X80,0XFB,0X00,0X00,0X01,0XFE,0X00,0X00,0X10,0XED,
+    0X00,0X03,0X88,0X00,0X00,0X01,0XF6,0X00,0X00,0X20,0XED,0X00,0X03,0X04,0X00,0X00,
+    0X02,0XF9,0X00,0X00,0X40,0XCF,0X00,0X00,0X40,0XF9,0X00,0X00,0X02,0XEA,0X00,0X03,
+    0X20,0X00,0X00,0X04,0XF9,0X00,0X03,0X20,0X00,0X00,0X04,0XFE,0X00,0X01,0X04,0X20,
+    0XF6,0X00,0X00,0X10,0XFB,0X00,0X00,0X40,0XFE,0X00,0X01,0X02,0X08,0XFE,0X00,0X00,
+    0X02,0XFB,0X00,0X01,0X01,0X04,0XF6,0X00,0X00,0X82,0XF6,0X00,0X00,0X41,0XF6,0X00,
+    0X01,0X20,0X80,0XFC,0X00,0X00,0X02,0XFD,0X00,0X07,0X10,0X40,0X00,0X00,0X40,0X00,
+    0X00,0X20,0XFD,0X00,0X01,0X08,0X20,0XF7,0X00,0X04,0X04,0X10,0X00,0X00,0X04,0XFA,
+    0X00,0X07,0X02,0X08,0X00,0X00,0X80,0X00,0X00,0X11,0XFD,0X00,0X01,0X01,0X04,0XF6,
+    0X00,0X03,0X82,0X00,0X00,0X08,0XFE,0X00,0X00,0X80,0XFD,0X00,0X02,0X41,0X00,0X01,
+    0XFE,0X00,0X00,0X08,0XFC,0X00,0X01,0X20,0X80,0XFC,0X00,0X00,0X40,0XFD,0X00,0X06,
+    0X10,0X00,0X02,0X10,0X00,0X00,0X04,0XFC,0X00,0X02,0X08,0X00,0X04,0XFD,0X00,0X00,
+    0X20,0XFD,0X00,0X07,0X07,0X80,0X00,0X20,0X00,0X00,0X02,0X10,0XFB,0X00,0X00,0X08,
+    0XF5,0X00,0X04,0X40,0X00,0X00,0X01,0X08,0XFB,0X00,0X01,0X10,0X80,0XFE,0X00,0X00,
+    0X04,0XFB,0X00,0X00,0X20,0XFD,0X00,0X00,0X82,0XFB,0X00,0X00,0X41,0XFD,0X00,0X00,
+    0X41,0XFB,0X00,0X00,0X82,0XFD,0X00,0X01,0X20,0X80,0XFD,0X00,0X01,0X01,0X04,0XFD,
+    0X00,0X01,0X10,0X40,0XFD,0X00,0X01,0X02,0X08,0XFD,0X00,0X01,0X08,0X20,0XFD,0X00,
+    0X01,0X04,0X10,0XFD,0X00,0X01,0X04,0X18,0XFD,0X00,0X01,0X18,0X20,0XFD,0X00,0X01,
+    0X02,0X06,0XFD,0X00,0X01,0X20,0X40,0XFD,0X00,0XFF,0X01,0XFD,0X00,0X01,0XC0,0X80,
+    0XFC,0X00,0X05,0X80,0XC0,0X00,0X00,0X03,0X01,0XFB,0X00,0X05,0X60,0X38,0X00,0X00,
+    0X0C,0X06,0XFB,0X00,0X05,0X10,0X07,0X00,0X00,0XF0,0X18,0XFB,0X00,0X05,0X0C,0X00,
+    0XFF,0X7F,0X00,0X60,0XFB,0X00,0X05,0X03,0X00,0X00,0X80,0X01,0X80,0XFA,0X00,0X03,
+    0XE0,0X00,0X00,0X0E,0XF9,0X00,0X03,0X1C,0X00,0X00,0X70,0XF9,0X00,0X03,0X03,0XF8,
+    0X1F,0X80,0XF8,0X00,0X01,0X07,0XE0,0XCC,0X00,
+};
+const PAINT_IMAGE Image_alarm = { gImage_alarm_pk, 681, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 293 bytes
+static const unsigned char gImage_audio_file_pk[293] = {
+    0XB8,0X00,0X00,0X03,0XFB,0XFF,0XE9,0X00,0X00,0X80,0XF6,0X00,0X00,0X40,0XFC,0X00,
+    0X00,0X3F,0XFD,0XFF,0X01,0XF8,0X20,0XF7,0X00,0X01,0X04,0X10,0XF7,0X00,0X01,0X02,
+    0X08,0XF7,0X00,0X01,0X01,0X04,0XF6,0X00,0X00,0X80,0XF6,0X00,0X00,0X42,0XF6,0X00,
+    0X00,0X01,0XF6,0X00,0X01,0X20,0X80,0XF7,0X00,0X01,0X10,0X40,0XF7,0X00,0X01,0X08,
+    0X20,0XF7,0X00,0X01,0X04,0X10,0XF7,0X00,0X00,0X02,0XF6,0X00,0X01,0X01,0X08,0XF6,
+    0X00,0X00,0X04,0XF6,0X00,0X00,0X82,0XF6,0X00,0X00,0X41,0XF8,0X00,0X03,0X03,0X80,
+    0X20,0X80,0XF9,0X00,0X02,0X0C,0X40,0X10,0XF8,0X00,0X03,0X30,0X00,0X08,0X40,0XF9,
+    0X00,0X02,0XC0,0X40,0X04,0XF9,0X00,0X02,0X03,0X00,0X80,0XF8,0X00,0X01,0X0C,0X03,
+    0XF7,0X00,0X01,0X30,0X0C,0XF6,0X00,0X00,0X30,0XF6,0X00,0X00,0XC0,0XF7,0X00,0X00,
+    0X03,0X81,0X00,0XD0,0X00,0X01,0X03,0XF8,0XF7,0X00,0X01,0X1C,0X06,0XF7,0X00,0X02,
+    0X20,0X01,0X80,0XF8,0X00,0X02,0XC0,0X00,0X40,0XF9,0X00,0XFF,0X01,0X00,0XC0,0XF8,
+    0X00,0X02,0X02,0X06,0X38,0XF7,0X00,0X01,0X18,0X06,0XF8,0X00,0X02,0X04,0X20,0X01,
+    0XEC,0X00,0X03,0X08,0X40,0X00,0X80,0XEA,0X00,0X00,0X40,0XF8,0X00,0X00,0X80,0XE8,
+    0X00,0X00,0X40,0XF8,0X00,0X00,0X80,0XF7,0X00,0X00,0X08,0XF5,0X00,0X02,0X40,0X00,
+    0X84,0XED,0X00,0X03,0X04,0X20,0X01,0X08,0XF9,0X00,0X02,0X02,0X18,0X06,0XF7,0X00,
+    0X02,0X07,0X18,0X10,0XF9,0X00,0X03,0X01,0X00,0XE0,0X20,0XF8,0X00,0X02,0X80,0X00,
+    0XC0,0XF8,0X00,0X01,0X60,0X01,0XF7,0X00,0X01,0X18,0X0E,0XF7,0X00,0X01,0X07,0XF0,
+    0X8D,0X00,0X00,0X3F,0XFB,0XFF,0X00,0XFC,0XDD,0X00,0X03,0X40,0X00,0X00,0X03,0XF9,
+    0XFF,0X00,0X80,0XC4,0X00,
+};
+const PAINT_IMAGE Image_audio_file = { gImage_audio_file_pk, 293, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 204 bytes
+static const unsigned char gImage_calendar_pk[204] = {
+    0XB8,0X00,0XF7,0XFF,0X01,0X00,0X01,0XF7,0X00,0X01,0X80,0X02,0XF7,0X00,0X00,0X40,
+    0XF4,0X00,0X00,0X3F,0XF9,0XFF,0X00,0XFC,0X81,0X00,0XCB,0X00,0X00,0X3F,0XF9,0XFF,
+    0X00,0XFC,0XDB,0X00,0X00,0X3F,0XF9,0XFF,0X00,0XFC,0X81,0X00,0XFA,0X00,0X07,0X01,
+    0XFF,0X80,0X1F,0XF8,0X01,0XFF,0X80,0XFD,0X00,0X07,0X02,0X00,0X40,0X20,0X04,0X02,
+    0X00,0X40,0XF1,0X00,0X07,0X02,0X00,0X40,0X20,0X04,0X02,0X00,0X40,0XFD,0X00,0X07,
+    0X01,0XFF,0X80,0X1F,0XF8,0X01,0XFF,0X80,0X91,0X00,0X07,0X01,0XFF,0X80,0X1F,0XF8,
+    0X01,0XFF,0X80,0XFD,0X00,0X07,0X02,0X00,0X40,0X20,0X04,0X02,0X00,0X40,0XF1,0X00,
+    0X07,0X02,0X00,0X40,0X20,0X04,0X02,0X00,0X40,0XFD,0X00,0X07,0X01,0XFF,0X80,0X1F,
+    0XF8,0X01,0XFF,0X80,0X91,0X00,0X07,0X01,0XFF,0X80,0X1F,0XF8,0X01,0XFF,0X80,0XFD,
+    0X00,0X07,0X02,0X00,0X40,0X20,0X04,0X02,0X00,0X40,0XF1,0X00,0X07,0X02,0X00,0X40,
+    0X20,0X04,0X02,0X00,0X40,0XFD,0X00,0X07,0X01,0XFF,0X80,0X1F,0XF8,0X01,0XFF,0X80,
+    0X81,0X00,0XFA,0X00,0X00,0X3F,0XF9,0XFF,0X00,0XFC,0XF4,0X00,0X00,0X02,0XF7,0X00,
+    0X01,0X40,0X01,0XF7,0X00,0X01,0X80,0X00,0XF7,0XFF,0XC4,0X00,
+};
+const PAINT_IMAGE Image_calendar = { gImage_calendar_pk, 204, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 608 bytes
+static const unsigned char gImage_clock_pk[608] = {
+    0XB4,0X00,0X01,0X3F,0XFE,0XF8,0X00,0X03,0X07,0XC0,0X01,0XE0,0XF9,0X00,0X03,0X38,
+    0X00,0X00,0X1E,0XFA,0X00,0X05,0X01,0XC0,0X00,0X00,0X01,0X80,0XFB,0X00,0X05,0X06,
+    0X00,0X0F,0XE0,0X00,0X60,0XFB,0X00,0X05,0X18,0X03,0XF0,0X1F,0X80,0X18,0XFB,0X00,
+    0X05,0X20,0X1C,0X00,0X00,0X70,0X06,0XFB,0X00,0X05,0XC0,0XE0,0X00,0X00,0X0E,0X01,
+    0XFC,0X00,0XFF,0X01,0XFE,0X00,0X02,0X01,0X80,0X80,0XFD,0X00,0XFF,0X06,0XFD,0X00,
+    0XFF,0X60,0XFD,0X00,0X01,0X08,0X18,0XFD,0X00,0X01,0X18,0X10,0XFD,0X00,0X01,0X10,
+    0X20,0XFD,0X00,0X01,0X04,0X08,0XFD,0X00,0X01,0X20,0X40,0XFD,0X00,0X01,0X02,0X04,
+    0XFD,0X00,0X01,0X41,0X80,0XFD,0X00,0X01,0X01,0X82,0XFD,0X00,0X00,0X82,0XFB,0X00,
+    0X00,0X41,0XFE,0X00,0X01,0X01,0X04,0XFB,0X00,0X01,0X20,0X80,0XFE,0X00,0X07,0X08,
+    0X00,0X00,0X01,0X80,0X00,0X00,0X10,0XFE,0X00,0X0C,0X02,0X10,0X00,0X00,0X02,0X40,
+    0X00,0X00,0X08,0X40,0X00,0X00,0X04,0XF9,0X00,0X04,0X20,0X00,0X00,0X08,0X20,0XFB,
+    0X00,0X00,0X04,0XFD,0X00,0X00,0X40,0XFB,0X00,0X05,0X02,0X10,0X00,0X00,0X10,0X80,
+    0XFB,0X00,0X01,0X01,0X08,0XF3,0X00,0X00,0X21,0XF9,0X00,0X00,0X84,0XF3,0X00,0X00,
+    0X42,0XF9,0X00,0X00,0X42,0XF6,0X00,0X03,0X20,0X00,0X00,0X84,0XED,0X00,0X00,0X01,
+    0XF6,0X00,0X03,0X10,0X00,0X00,0X08,0XF7,0X00,0X00,0X01,0XF7,0X00,0X00,0X80,0XF7,
+    0X00,0X03,0X08,0X00,0X00,0X10,0XEB,0X00,0X00,0X02,0XEB,0X00,0X00,0X40,0XEB,0X00,
+    0X03,0X04,0X00,0X00,0X20,0XE5,0X00,0X00,0X20,0XF6,0X00,0X00,0X10,0XF6,0X00,0X00,
+    0X08,0XF7,0X00,0X01,0X02,0X04,0XF7,0X00,0X01,0X01,0X02,0XFE,0X00,0X03,0X04,0X00,
+    0X00,0X20,0XFD,0X00,0X00,0X81,0XF6,0X00,0X01,0X40,0X80,0XFD,0X00,0X00,0X02,0XFC,
+    0X00,0X01,0X20,0X40,0XF7,0X00,0X01,0X10,0X20,0XFE,0X00,0X00,0X40,0XFB,0X00,0X01,
+    0X08,0X10,0XF7,0X00,0X07,0X04,0X08,0X00,0X00,0X08,0X00,0X00,0X10,0XFD,0X00,0X01,
+    0X02,0X04,0XFD,0X00,0X00,0X01,0XFC,0X00,0X01,0X01,0X02,0XFE,0X00,0X00,0X80,0XFA,
+    0X00,0X06,0X81,0X00,0X00,0X10,0X00,0X00,0X08,0XFC,0X00,0X01,0X40,0X80,0XFD,0X00,
+    0X00,0X80,0XFC,0X00,0X01,0X20,0X40,0XF7,0X00,0X06,0X10,0X20,0X00,0X21,0X00,0X00,
+    0X04,0XFC,0X00,0X00,0X08,0XFC,0X00,0X00,0X42,0XFC,0X00,0X03,0X04,0X00,0X00,0X42,
+    0XF9,0X00,0X01,0X03,0X20,0XFD,0X00,0X00,0X21,0XFB,0X00,0X02,0XC0,0X00,0X84,0XF3,
+    0X00,0X01,0X10,0X80,0XFB,0X00,0X05,0X01,0X08,0X00,0X00,0X08,0X40,0XFB,0X00,0X00,
+    0X02,0XFD,0X00,0X00,0X20,0XFB,0X00,0X04,0X04,0X10,0X00,0X00,0X04,0XF9,0X00,0X04,
+    0X20,0X00,0X00,0X02,0X10,0XFB,0X00,0X01,0X08,0X40,0XFE,0X00,0X00,0X08,0XFB,0X00,
+    0X00,0X10,0XFE,0X00,0X01,0X01,0X04,0XFB,0X00,0X01,0X20,0X80,0XFE,0X00,0X00,0X82,
+    0XFB,0X00,0X00,0X41,0XFD,0X00,0X01,0X41,0X80,0XFD,0X00,0X01,0X01,0X82,0XFD,0X00,
+    0X01,0X20,0X40,0XFD,0X00,0X01,0X02,0X04,0XFD,0X00,0X01,0X10,0X20,0XFD,0X00,0X01,
+    0X04,0X08,0XFD,0X00,0X01,0X08,0X18,0XFD,0X00,0X01,0X18,0X10,0XFD,0X00,0XFF,0X06,
+    0XFD,0X00,0XFF,0X60,0XFD,0X00,0XFF,0X01,0X00,0X80,0XFE,0X00,0XFF,0X80,0XFC,0X00,
+    0X05,0X80,0X70,0X00,0X00,0X07,0X03,0XFB,0X00,0X05,0X60,0X0E,0X00,0X00,0X38,0X04,
+    0XFB,0X00,0X05,0X18,0X01,0XF8,0X0F,0XC0,0X18,0XFB,0X00,0X05,0X06,0X00,0X07,0XF0,
+    0X00,0X60,0XFB,0X00,0X05,0X01,0X80,0X00,0X00,0X03,0X80,0XFA,0X00,0X03,0X78,0X00,
+    0X00,0X1C,0XF9,0X00,0X03,0X07,0X80,0X03,0XE0,0XF8,0X00,0X01,0X7F,0XFC,0XC0,0X00,
+};
+const PAINT_IMAGE Image_clock = { gImage_clock_pk, 608, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 179 bytes
+static const unsigned char gImage_file_pk[179] = {
+    0X88,0X00,0X03,0X1F,0XFF,0XFF,0XFE,0XF9,0X00,0X03,0X20,0X00,0X00,0X01,0XF9,0X00,
+    0X00,0X40,0XFE,0X00,0X00,0X80,0XF6,0X00,0X00,0X40,0XFA,0X00,0X04,0X87,0XFF,0XFF,
+    0XF8,0X20,0XFA,0X00,0X04,0X08,0X00,0X00,0X04,0X10,0XF7,0X00,0X01,0X02,0X08,0XF7,
+    0X00,0X00,0X01,0XF5,0X00,0X00,0X84,0XF6,0X00,0X00,0X02,0XF6,0X00,0X00,0X41,0XF6,
+    0X00,0X01,0X20,0X80,0XF7,0X00,0X01,0X10,0X7F,0XFE,0XFF,0X00,0XF0,0XFB,0X00,0X00,
+    0X08,0XFD,0X00,0X00,0X0C,0XFB,0X00,0X00,0X04,0XFD,0X00,0X00,0X02,0XFB,0X00,0X00,
+    0X02,0XFD,0X00,0X00,0X01,0XFB,0X00,0X00,0X01,0XFD,0XFF,0X00,0XE0,0XF6,0X00,0X00,
+    0X10,0X81,0X00,0XD7,0X00,0X00,0X0F,0XF9,0XFF,0X00,0XF0,0XDB,0X00,0X00,0X0F,0XF9,
+    0XFF,0X00,0XF0,0X81,0X00,0X81,0X00,0X81,0X00,0XE7,0X00,0X00,0X08,0XF9,0X00,0X03,
+    0X10,0X00,0X00,0X07,0XF9,0XFF,0X03,0XE1,0X00,0X00,0X80,0XF6,0X00,0X00,0X40,0XF9,
+    0X00,0X03,0X02,0X00,0X00,0X30,0XF9,0X00,0X03,0X04,0X00,0X00,0X0F,0XF9,0XFF,0X00,
+    0XF8,0X94,0X00,
+};
+const PAINT_IMAGE Image_file = { gImage_file_pk, 179, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 700 bytes
+static const unsigned char gImage_network_pk[700] = {
+    0XB4,0X00,0X01,0X3F,0XFE,0XF8,0X00,0X03,0X07,0XC0,0X01,0XE0,0XF9,0X00,0X03,0X38,
+    0X00,0X00,0X1E,0XFA,0X00,0X05,0X01,0XC0,0X00,0X00,0X01,0X80,0XFB,0X00,0X05,0X06,
+    0X00,0X01,0XC0,0X00,0X60,0XFB,0X00,0X05,0X18,0X02,0X06,0X20,0X00,0X18,0XFB,0X00,
+    0X05,0X20,0X1E,0X08,0X10,0X30,0X06,0XFB,0X00,0X05,0XC0,0XE4,0X10,0X08,0X2E,0X01,
+    0XFC,0X00,0XFF,0X01,0X05,0X00,0X20,0X04,0X01,0X80,0X80,0XFD,0X00,0XFF,0X06,0X05,
+    0X08,0X40,0X02,0X10,0X60,0X60,0XFD,0X00,0X01,0X08,0X18,0XFD,0X00,0X01,0X18,0X10,
+    0XFD,0X00,0X07,0X10,0X20,0X10,0X80,0X01,0X08,0X04,0X08,0XFD,0X00,0X01,0X20,0X40,
+    0XFD,0X00,0X01,0X02,0X04,0XFD,0X00,0X07,0X41,0X80,0X01,0X00,0X00,0X84,0X01,0X82,
+    0XFD,0X00,0X02,0X80,0X00,0X20,0XFD,0X00,0X00,0X01,0XFE,0X00,0XFF,0X01,0X07,0X80,
+    0X02,0X00,0X00,0X40,0X01,0X80,0X80,0XFD,0X00,0X00,0X40,0XFE,0X00,0XFF,0X02,0XFD,
+    0X00,0X03,0X02,0X10,0X20,0X40,0XFE,0X00,0X13,0X04,0X08,0X40,0X00,0X00,0X04,0X08,
+    0X18,0X04,0X00,0X00,0X20,0X18,0X10,0X20,0X00,0X00,0X08,0X26,0X06,0XFD,0X00,0X01,
+    0X60,0X64,0XFD,0X00,0X0E,0X41,0X01,0X80,0X00,0X00,0X01,0X80,0X82,0X10,0X00,0X00,
+    0X10,0X80,0X80,0X08,0XFE,0X00,0X02,0X03,0X01,0X08,0XFD,0X00,0X05,0X60,0X0E,0X00,
+    0X00,0X20,0X04,0XFD,0X00,0X09,0X21,0X00,0X18,0X01,0XF8,0X0F,0XC0,0X18,0X00,0X84,
+    0XFD,0X00,0X05,0X06,0X00,0X07,0XF0,0X00,0X60,0XFD,0X00,0X00,0X42,0XF9,0X00,0X00,
+    0X42,0XFC,0X00,0X0F,0X18,0X00,0X00,0X18,0X00,0X00,0X20,0X00,0X00,0X84,0X00,0X00,
+    0X07,0X80,0X03,0XE0,0XF8,0X00,0X01,0X7F,0XFC,0XFE,0X00,0X00,0X01,0XF6,0X00,0X03,
+    0X10,0X00,0X00,0X08,0XF7,0X00,0X00,0X01,0XFA,0X00,0X03,0X40,0X00,0X00,0X80,0XFE,
+    0X00,0X00,0X02,0XFB,0X00,0X06,0X08,0X00,0X00,0X10,0X00,0X00,0X20,0XF3,0X00,0X00,
+    0X04,0XFD,0X00,0X00,0X02,0XEB,0X00,0X00,0X40,0XEB,0X00,0X03,0X04,0X00,0X00,0X20,
+    0XF6,0X00,0X09,0X3F,0XFF,0XFC,0X3F,0XFF,0XFF,0XFC,0X3F,0XFF,0XFC,0XDB,0X00,0X09,
+    0X3F,0XFF,0XFC,0X3F,0XFF,0XFF,0XFC,0X3F,0XFF,0XFC,0XF6,0X00,0X03,0X04,0X00,0X00,
+    0X20,0XEB,0X00,0X00,0X02,0XEB,0X00,0X00,0X40,0XFD,0X00,0X00,0X20,0XF3,0X00,0X06,
+    0X04,0X00,0X00,0X08,0X00,0X00,0X10,0XFB,0X00,0X00,0X40,0XFE,0X00,0X03,0X01,0X00,
+    0X00,0X02,0XFA,0X00,0X00,0X80,0XF7,0X00,0X03,0X10,0X00,0X00,0X08,0XF6,0X00,0X00,
+    0X80,0XFE,0X00,0X01,0X3F,0XFE,0XF8,0X00,0X0F,0X07,0XC0,0X01,0XE0,0X00,0X00,0X21,
+    0X00,0X00,0X04,0X00,0X00,0X18,0X00,0X00,0X18,0XFC,0X00,0X00,0X42,0XF9,0X00,0X00,
+    0X42,0XFD,0X00,0X05,0X06,0X00,0X0F,0XE0,0X00,0X60,0XFD,0X00,0X09,0X21,0X00,0X18,
+    0X03,0XF0,0X1F,0X80,0X18,0X00,0X84,0XFD,0X00,0X05,0X20,0X04,0X00,0X00,0X70,0X06,
+    0XFD,0X00,0X02,0X10,0X80,0XC0,0XFE,0X00,0X0E,0X10,0X01,0X01,0X08,0X00,0X00,0X08,
+    0X41,0X01,0X80,0X00,0X00,0X01,0X80,0X82,0XFD,0X00,0X01,0X26,0X06,0XFD,0X00,0X13,
+    0X60,0X64,0X10,0X00,0X00,0X04,0X08,0X18,0X04,0X00,0X00,0X20,0X18,0X10,0X20,0X00,
+    0X00,0X02,0X10,0X20,0XFE,0X00,0X03,0X02,0X04,0X08,0X40,0XFD,0X00,0XFF,0X40,0XFE,
+    0X00,0X00,0X02,0XFD,0X00,0XFF,0X01,0X07,0X80,0X02,0X00,0X00,0X40,0X01,0X80,0X80,
+    0XFE,0X00,0X00,0X80,0XFD,0X00,0X02,0X04,0X00,0X01,0XFD,0X00,0X07,0X41,0X80,0X21,
+    0X00,0X00,0X80,0X01,0X82,0XFD,0X00,0X01,0X20,0X40,0XFD,0X00,0X01,0X02,0X04,0XFD,
+    0X00,0X07,0X10,0X20,0X10,0X80,0X01,0X08,0X04,0X08,0XFD,0X00,0X01,0X08,0X18,0XFD,
+    0X00,0X01,0X18,0X10,0XFD,0X00,0XFF,0X06,0X05,0X08,0X40,0X02,0X10,0X60,0X60,0XFD,
+    0X00,0XFF,0X01,0X05,0X80,0X20,0X04,0X00,0X80,0X80,0XFC,0X00,0X05,0X80,0X74,0X10,
+    0X08,0X27,0X03,0XFB,0X00,0X05,0X60,0X0C,0X08,0X10,0X78,0X04,0XFB,0X00,0X05,0X18,
+    0X00,0X04,0X60,0X40,0X18,0XFB,0X00,0X05,0X06,0X00,0X03,0X80,0X00,0X60,0XFB,0X00,
+    0X05,0X01,0X80,0X00,0X00,0X03,0X80,0XFA,0X00,0X03,0X78,0X00,0X00,0X1C,0XF9,0X00,
+    0X03,0X07,0X80,0X03,0XE0,0XF8,0X00,0X01,0X7F,0XFC,0XC0,0X00,
+};
+const PAINT_IMAGE Image_network = { gImage_network_pk, 700, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 192 bytes
+static const unsigned char gImage_read_pk[192] = {
+    0X81,0X00,0XF0,0X00,0XFE,0XFF,0X03,0XF0,0X00,0X00,0X1F,0XFE,0XFF,0XFC,0X00,0X03,
+    0X0E,0X00,0X00,0XE0,0XF9,0X00,0X02,0X01,0X80,0X03,0XF7,0X00,0X01,0X60,0X04,0XFB,
+    0X00,0X09,0X0F,0XFF,0XFF,0XE0,0X10,0X08,0X07,0XFF,0XFF,0XF0,0XFC,0X00,0X03,0X1C,
+    0X08,0X10,0X38,0XF9,0X00,0X03,0X03,0X04,0X20,0X40,0XF8,0X00,0X02,0X82,0X41,0X80,
+    0XF8,0X00,0X01,0X41,0X02,0XF7,0X00,0X01,0X20,0X84,0XF6,0X00,0X00,0X08,0XF7,0X00,
+    0X00,0X10,0XF6,0X00,0X01,0X08,0X10,0XDF,0X00,0X01,0X04,0X20,0X81,0X00,0X81,0X00,
+    0X81,0X00,0X83,0X00,0X00,0X0F,0XFE,0XFF,0XFF,0X00,0XFE,0XFF,0X00,0XF0,0XFB,0X00,
+    0X01,0XC0,0X07,0XF7,0X00,0X01,0X30,0X08,0XFB,0X00,0X00,0X80,0XFE,0X00,0X01,0X08,
+    0X10,0XFE,0X00,0X0C,0X01,0X00,0X00,0X7F,0XFF,0XFF,0XFC,0X04,0X20,0X1F,0XFF,0XFF,
+    0XFE,0XFC,0X00,0X03,0X03,0X80,0X01,0XE0,0XF8,0X00,0X01,0X40,0X02,0XF7,0X00,0X01,
+    0X20,0X04,0XF7,0X00,0X01,0X10,0X08,0XF7,0X00,0X01,0X08,0X10,0XDE,0X00,0X00,0X20,
+    0XF7,0X00,0X00,0X04,0XEA,0X00,0X01,0X02,0X40,0XF7,0X00,0X01,0X01,0X80,0X90,0X00,
+};
+const PAINT_IMAGE Image_read = { gImage_read_pk, 192, 96, 96, IMAGE_PACKBITS };
+
+// 96x96, 1152 -> 637 bytes
+static const unsigned char gImage_weather_pk[637] = {
+    0XB2,0X00,0X01,0X03,0XE0,0XF7,0X00,0X01,0X04,0X10,0XEB,0X00,0X00,0X08,0XF6,0X00,
+    0X00,0X08,0XEC,0X00,0X03,0XF8,0X00,0X00,0X10,0XFA,0X00,0X04,0X01,0X04,0X00,0X06,
+    0X20,0XF7,0X00,0X01,0X01,0XC0,0XFA,0X00,0X00,0X02,0XF6,0X00,0X00,0X02,0XFC,0X00,
+    0X00,0XF8,0XF7,0X00,0X01,0X01,0X04,0XFB,0X00,0X00,0X04,0XF7,0X00,0X01,0X01,0X88,
+    0XFE,0X00,0X00,0X02,0XFA,0X00,0X04,0X70,0X00,0XFF,0X80,0X02,0XF9,0X00,0X02,0X07,
+    0X00,0X60,0XF8,0X00,0X04,0X08,0X00,0X18,0X00,0X04,0XFA,0X00,0X04,0X30,0X00,0X04,
+    0X01,0X88,0XFA,0X00,0X04,0X40,0X7C,0X02,0X00,0X70,0XFA,0X00,0X02,0X81,0X83,0X81,
+    0XF9,0X00,0X04,0X01,0X06,0X00,0X60,0X80,0XFA,0X00,0X03,0X02,0X08,0X00,0X10,0XF8,
+    0X00,0X03,0X10,0X00,0X08,0X40,0XF9,0X00,0X02,0X20,0X00,0X04,0XFB,0X00,0X02,0X03,
+    0XFF,0XC4,0XFE,0X00,0X00,0X20,0XFC,0X00,0X05,0X3C,0X00,0X38,0X00,0X00,0X02,0XFB,
+    0X00,0X03,0XC0,0X00,0X00,0X40,0XFA,0X00,0X00,0X03,0XFE,0X00,0X00,0X40,0XFA,0X00,
+    0X10,0X0C,0X03,0XFF,0X00,0X30,0X00,0X00,0X10,0X0F,0X80,0X00,0X00,0X30,0X1C,0X00,
+    0XF0,0X08,0XFE,0X00,0X08,0X10,0X40,0X00,0X00,0X40,0X60,0X00,0X0C,0X04,0XFA,0X00,
+    0X04,0X81,0X80,0X00,0X03,0X02,0XFE,0X00,0X04,0X20,0X00,0X00,0X01,0X02,0XFE,0X00,
+    0X08,0XC1,0X80,0X00,0X10,0X20,0X00,0X00,0X02,0X0C,0XFE,0X00,0X02,0X20,0X00,0X02,
+    0XFD,0X00,0X01,0X04,0X10,0XFE,0X00,0X01,0X10,0X40,0XFE,0X00,0X03,0X40,0X00,0X08,
+    0X20,0XFE,0X00,0X08,0X08,0X20,0X04,0X00,0X18,0X80,0X00,0X00,0X40,0XFE,0X00,0X08,
+    0X04,0X10,0X00,0X20,0X07,0X00,0X00,0X10,0X80,0XFE,0X00,0X03,0X02,0X00,0X08,0X40,
+    0XFE,0X00,0X00,0X20,0XFD,0X00,0X02,0X01,0X08,0X10,0XFD,0X00,0X00,0X01,0XFC,0X00,
+    0X02,0X80,0X60,0X80,0XFE,0X00,0X07,0X42,0X00,0X00,0XFF,0X80,0X00,0X05,0X81,0XFB,
+    0X00,0X05,0X03,0X00,0X70,0X00,0X42,0X02,0XFD,0X00,0X08,0X84,0X00,0X0C,0X00,0X08,
+    0X00,0X00,0X03,0X80,0XFC,0X00,0X06,0X10,0X00,0X04,0X00,0X20,0X00,0X78,0XFE,0X00,
+    0X04,0X08,0X00,0X20,0X7E,0X02,0XFE,0X00,0X0D,0X07,0X00,0X00,0X01,0X00,0X00,0X41,
+    0X81,0X80,0X00,0X10,0X00,0X00,0X80,0XFD,0X00,0X02,0X82,0X00,0X60,0XFD,0X00,0X0C,
+    0X60,0X00,0X00,0X10,0X00,0X04,0X00,0X1E,0X00,0X00,0X7F,0XE0,0X10,0XFE,0X00,0X00,
+    0X01,0XFD,0X00,0X03,0X0F,0X80,0X1C,0X08,0XFD,0X00,0X00,0X08,0XFC,0X00,0X01,0X02,
+    0X04,0XFD,0X00,0X00,0X10,0XFC,0X00,0X01,0X01,0X80,0XF6,0X00,0X04,0X42,0X00,0X02,
+    0X00,0X02,0XFA,0X00,0X00,0X21,0XEA,0X00,0X04,0X10,0X80,0X02,0X00,0X02,0XFA,0X00,
+    0X00,0X08,0XEA,0X00,0X01,0X04,0X40,0XFE,0X00,0X00,0X10,0XF7,0X00,0X01,0X01,0X08,
+    0XED,0X00,0X03,0X01,0X10,0X00,0X84,0XEE,0X00,0X04,0X20,0X00,0X08,0X00,0X40,0XF8,
+    0X00,0X02,0X80,0X00,0X3C,0XFA,0X00,0X00,0X20,0XF4,0X00,0X00,0X04,0XF6,0X00,0X00,
+    0X42,0XED,0X00,0X03,0X04,0X00,0X00,0X21,0XF6,0X00,0X01,0X10,0X80,0XFA,0X00,0X04,
+    0X08,0X40,0X00,0X00,0X40,0XF7,0X00,0X01,0X08,0X20,0XFA,0X00,0X04,0X10,0X80,0X00,
+    0X04,0X10,0XFA,0X00,0X04,0X20,0X00,0X00,0X02,0X08,0XFA,0X00,0X04,0X41,0X00,0X00,
+    0X01,0X06,0XFA,0X00,0X00,0X82,0XFE,0X00,0X01,0X81,0X80,0XFC,0X00,0X01,0X01,0X04,
+    0XFE,0X00,0X01,0X40,0X60,0XFC,0X00,0X01,0X06,0X08,0XFE,0X00,0X01,0X20,0X1E,0XFC,
+    0X00,0X00,0X18,0XFD,0X00,0X02,0X18,0X01,0XF8,0XFE,0X00,0X02,0X03,0XE0,0X30,0XFE,
+    0X00,0X02,0X06,0X00,0X07,0XFE,0XFF,0X02,0XFC,0X00,0XC0,0XFE,0X00,0X01,0X01,0X80,
+    0XFC,0X00,0X00,0X01,0XFC,0X00,0X00,0X78,0XFC,0X00,0X00,0X0E,0XFC,0X00,0X01,0X07,
+    0XC0,0XFD,0X00,0X00,0XF0,0XFB,0X00,0X00,0X3F,0XFD,0XFF,0XC2,0X00,
+};
+const PAINT_IMAGE Image_weather = { gImage_weather_pk, 637, 96, 96, IMAGE_PACKBITS };
+
+// 8x26, 26 -> 21 bytes
+static const unsigned char gImage_Alarm_clock_time_point_pk[21] = {
+    0X02,0X3C,0X42,0X81,0XFE,0X00,0X02,0X81,0X42,0X3C,0XF8,0X00,0X07,0X3C,0X42,0X01,
+    0X80,0X00,0X00,0X81,0X42,
+};
+const PAINT_IMAGE Image_Alarm_clock_time_point = { gImage_Alarm_clock_time_point_pk, 21, 8, 26, IMAGE_PACKBITS };
+
+// 48x48, 288 -> 171 bytes
+static const unsigned char gImage_temperature_pk[171] = {
+    0XF3,0X00,0X00,0X01,0XFC,0X00,0X01,0X0E,0XF0,0XFD,0X00,0X01,0X10,0X08,0XFD,0X00,
+    0X01,0X20,0X04,0XFD,0X00,0X01,0X43,0XE2,0XFD,0X00,0X00,0X0C,0XFB,0X00,0X00,0X10,
+    0XFC,0X00,0X00,0X01,0XFD,0X00,0X00,0X80,0XE4,0X00,0X00,0X01,0XFB,0X00,0X00,0XC0,
+    0XFD,0X00,0X00,0X02,0XCD,0X00,0X09,0X01,0X10,0X00,0X80,0X00,0X00,0X02,0X00,0X08,
+    0X40,0XFE,0X00,0X01,0X20,0X04,0XFE,0X00,0X03,0X04,0X44,0X22,0X20,0XFE,0X00,0X01,
+    0X88,0X10,0XFD,0X00,0X01,0X10,0X09,0XFD,0X00,0X01,0X03,0XC0,0XFE,0X00,0X03,0X08,
+    0X20,0X00,0X10,0XFE,0X00,0X07,0X20,0X04,0X10,0X00,0X00,0X08,0X00,0X04,0XFD,0X00,
+    0X01,0X03,0XC0,0XFD,0X00,0X01,0X90,0X08,0XFD,0X00,0X01,0X08,0X11,0XFE,0X00,0X03,
+    0X04,0X46,0XE2,0X20,0XFE,0X00,0X07,0X21,0X04,0X40,0X00,0X00,0X02,0X10,0X18,0XFE,
+    0X00,0X03,0X01,0X0F,0XE0,0X80,0XFE,0X00,0X01,0XC0,0X01,0XFD,0X00,0X01,0X20,0X06,
+    0XFD,0X00,0X01,0X1F,0X78,0XFC,0X00,0X00,0X80,0XF9,0X00,
+};
+const PAINT_IMAGE Image_temperature = { gImage_temperature_pk, 171, 48, 48, IMAGE_PACKBITS };
+
+// 48x48, 288 -> 221 bytes
+static const unsigned char gImage_humidity_pk[221] = {
+    0XE7,0X00,0X00,0X10,0XFC,0X00,0X00,0X2C,0XFC,0X00,0X00,0X42,0XFC,0X00,0X00,0X81,
+    0XFD,0X00,0X02,0X01,0X08,0X80,0XFE,0X00,0X02,0X02,0X14,0X40,0XFE,0X00,0X02,0X04,
+    0X22,0X20,0XFE,0X00,0X03,0X08,0X40,0X10,0X40,0XFE,0X00,0X26,0X81,0X08,0XA0,0X00,
+    0X00,0X11,0X00,0X89,0X10,0X00,0X00,0X22,0X00,0X72,0X08,0X00,0X00,0X04,0X00,0X04,
+    0X04,0X00,0X00,0X40,0X00,0X08,0X62,0X00,0X00,0X88,0X00,0X00,0X80,0X00,0X00,0X10,
+    0X00,0X11,0X11,0XFD,0X00,0X04,0X22,0X08,0X00,0X01,0X20,0XFE,0X00,0X00,0X80,0XFE,
+    0X00,0X03,0X44,0X04,0X00,0X02,0XFD,0X00,0X05,0X40,0X00,0X40,0X00,0X08,0X02,0XF1,
+    0X00,0X00,0X82,0XFE,0X00,0X15,0X10,0X00,0X01,0X80,0X20,0X04,0X0C,0X00,0X84,0X00,
+    0X20,0X00,0X20,0X00,0X04,0X70,0X00,0X04,0X20,0X00,0X00,0X08,0XFD,0X00,0XFF,0X0A,
+    0XFF,0X00,0X2C,0X02,0X00,0X45,0X94,0X40,0X00,0X40,0X00,0X02,0X68,0X00,0X00,0X31,
+    0X83,0X21,0XF0,0X80,0X02,0X08,0X7C,0X90,0X01,0X00,0X00,0X14,0X00,0X88,0X02,0X00,
+    0X01,0X0A,0X00,0X07,0XBC,0X00,0X00,0X85,0XEF,0X38,0X40,0X00,0X00,0X43,0X10,0XC0,
+    0XFE,0X00,0X01,0X20,0XFF,0XFD,0X00,0X02,0X18,0X00,0X08,0XFE,0X00,0X02,0X06,0X00,
+    0X30,0XFE,0X00,0X02,0X01,0XE7,0XC0,0XFD,0X00,0X00,0X18,0XEC,0X00,
+};
+const PAINT_IMAGE Image_humidity = { gImage_humidity_pk, 221, 48, 48, IMAGE_PACKBITS };
+
+// 42x132, 792 -> 336 bytes
+static const unsigned char gImage_point_in_time_pk[336] = {
+    0XFF,0X00,0X01,0XFF,0XC0,0XFE,0X00,0X02,0X07,0X00,0X38,0XFE,0X00,0X02,0X18,0X00,
+    0X06,0XFE,0X00,0X0B,0X60,0X00,0X01,0X80,0X00,0X00,0X80,0X00,0X00,0X40,0X00,0X01,
+    0XFE,0X00,0X02,0X20,0X00,0X02,0XFE,0X00,0X02,0X10,0X00,0X0C,0XFE,0X00,0X00,0X08,
+    0XFC,0X00,0X02,0X04,0X00,0X10,0XFE,0X00,0X00,0X02,0XFA,0X00,0X00,0X20,0XFE,0X00,
+    0X00,0X01,0XFA,0X00,0X00,0X40,0XFD,0X00,0X00,0X80,0XF5,0X00,0X00,0X80,0XFD,0X00,
+    0X00,0X40,0XCB,0X00,0X00,0X80,0XFD,0X00,0X00,0X40,0XF5,0X00,0X00,0X40,0XFD,0X00,
+    0X00,0X80,0XFB,0X00,0X00,0X20,0XFE,0X00,0X00,0X01,0XFA,0X00,0X00,0X10,0XFE,0X00,
+    0X02,0X02,0X00,0X08,0XFE,0X00,0X02,0X04,0X00,0X04,0XFE,0X00,0X02,0X08,0X00,0X02,
+    0XFC,0X00,0X00,0X01,0XFE,0X00,0X11,0X30,0X00,0X00,0X80,0X00,0X00,0X40,0X00,0X00,
+    0X60,0X00,0X01,0X80,0X00,0X00,0X18,0X00,0X06,0XFE,0X00,0X02,0X07,0X00,0X38,0XFD,
+    0X00,0X01,0XFF,0XC0,0X81,0X00,0X81,0X00,0XE3,0X00,0X01,0XFF,0XC0,0XFE,0X00,0X02,
+    0X07,0X00,0X38,0XFE,0X00,0X02,0X18,0X00,0X06,0XFE,0X00,0X0B,0X60,0X00,0X01,0X80,
+    0X00,0X00,0X80,0X00,0X00,0X40,0X00,0X01,0XFE,0X00,0X02,0X20,0X00,0X06,0XFE,0X00,
+    0X00,0X10,0XFC,0X00,0X02,0X08,0X00,0X08,0XFE,0X00,0X02,0X04,0X00,0X10,0XFE,0X00,
+    0X00,0X02,0XFA,0X00,0X00,0X20,0XFE,0X00,0X00,0X01,0XFA,0X00,0X00,0X40,0XFD,0X00,
+    0X00,0X80,0XF5,0X00,0X00,0X80,0XFD,0X00,0X00,0X40,0XCC,0X00,0X01,0X40,0X80,0XFD,
+    0X00,0X00,0X40,0XFC,0X00,0X00,0X40,0XFB,0X00,0X00,0X40,0XFD,0X00,0X00,0X80,0XFB,
+    0X00,0X00,0X20,0XFE,0X00,0X00,0X01,0XFA,0X00,0X00,0X10,0XFE,0X00,0X02,0X02,0X00,
+    0X08,0XFE,0X00,0X02,0X04,0X00,0X04,0XFE,0X00,0X02,0X08,0X00,0X02,0XFE,0X00,0X02,
+    0X10,0X00,0X01,0XFE,0X00,0X11,0X20,0X00,0X00,0X80,0X00,0X00,0X40,0X00,0X00,0X60,
+    0X00,0X01,0X80,0X00,0X00,0X18,0X00,0X06,0XFE,0X00,0X04,0X07,0X00,0X38,0X00,0X00,
+};
+const PAINT_IMAGE Image_point_in_time = { gImage_point_in_time_pk, 336, 42, 132, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 47 bytes
+static const unsigned char gImage_BAT_1_pk[47] = {
+    0XE1,0X00,0X03,0X7F,0XFF,0XFF,0XF8,0XFD,0X00,0X03,0X1F,0XFF,0XFF,0XE0,0XFD,0X00,
+    0X02,0X07,0XFF,0XF8,0XFD,0X00,0X00,0X06,0XEA,0X00,0X03,0X06,0X07,0XFF,0XF8,0XFC,
+    0X00,0X03,0X1F,0XFF,0XFF,0XE0,0XFD,0X00,0X03,0X7F,0XFF,0XFF,0XF8,0XE5,0X00,
+};
+const PAINT_IMAGE Image_BAT_1 = { gImage_BAT_1_pk, 47, 32, 32, IMAGE_PACKBITS };
+
+// 36x36, 180 -> 109 bytes
+static const unsigned char gImage_fx_pk[109] = {
+    0XEB,0X00,0X00,0XF8,0XFE,0X00,0X00,0X01,0XFD,0X00,0X01,0X02,0X38,0XFD,0X00,0X00,
+    0XC0,0XF8,0X00,0X00,0X80,0XFD,0X00,0X04,0X7F,0XFE,0X00,0X00,0X03,0XFE,0X00,0X05,
+    0X07,0XC0,0XFF,0XFE,0X00,0X08,0XFD,0X00,0X01,0X03,0XC0,0XF9,0X00,0X00,0X10,0XFD,
+    0X00,0X00,0X12,0XFD,0X00,0X00,0X01,0XFE,0XFF,0X01,0X00,0X0C,0XFD,0X00,0X00,0X03,
+    0XFE,0XFF,0XF0,0X00,0X05,0X0F,0XFF,0XC0,0X00,0X00,0X10,0XFD,0X00,0X05,0X27,0XFF,
+    0XC0,0X00,0X00,0X08,0XFD,0X00,0X00,0X08,0XFD,0X00,0X00,0X04,0XFD,0X00,0X01,0X23,
+    0XC0,0XFE,0X00,0X01,0X18,0X40,0XFE,0X00,0X01,0X07,0X80,0XF0,0X00,
+};
+const PAINT_IMAGE Image_fx = { gImage_fx_pk, 109, 36, 36, IMAGE_PACKBITS };
+
+// 36x36, 180 -> 151 bytes
+static const unsigned char gImage_quality_pk[151] = {
+    0XF6,0X00,0X01,0X07,0XC0,0XFE,0X00,0X01,0X18,0X30,0XFE,0X00,0X01,0X23,0X88,0XFE,
+    0X00,0X01,0X44,0X64,0XFE,0X00,0X01,0X08,0X12,0XFE,0X00,0X06,0X90,0X08,0X00,0X00,
+    0X01,0X20,0X01,0XFD,0X00,0X04,0X04,0X00,0X00,0X02,0X40,0XF8,0X00,0X07,0X80,0X04,
+    0XE0,0X00,0X04,0X00,0X08,0X10,0XFE,0X00,0X06,0X13,0XC8,0X00,0X01,0X00,0X04,0X20,
+    0XFD,0X00,0X00,0X04,0XFE,0X00,0X01,0X20,0X10,0XFE,0X00,0X05,0X20,0X00,0X00,0X08,
+    0X00,0X18,0XFE,0X00,0X10,0X7E,0X00,0X02,0X00,0X00,0X41,0XC0,0X08,0X00,0X00,0X38,
+    0X30,0X00,0X00,0X02,0X07,0X80,0XFD,0X00,0X00,0X68,0XFD,0X00,0X00,0X20,0XFE,0X00,
+    0X0B,0X3F,0XC0,0X06,0X00,0X00,0XC0,0X18,0X00,0X00,0X0C,0X1F,0XE0,0XF9,0X00,0X00,
+    0X1C,0XFD,0X00,0X01,0X83,0XF8,0XFE,0X00,0X06,0X70,0X07,0XF0,0X00,0X00,0X0F,0XC0,
+    0XFD,0X00,0X01,0X3F,0XF0,0XFB,0X00,
+};
+const PAINT_IMAGE Image_quality = { gImage_quality_pk, 151, 36, 36, IMAGE_PACKBITS };
+
+// 36x36, 180 -> 141 bytes
+static const unsigned char gImage_shidu_pk[141] = {
+    0XEC,0X00,0X01,0X07,0X80,0XFE,0X00,0X01,0X08,0X40,0XFE,0X00,0X01,0X11,0X20,0XFE,
+    0X00,0X01,0X22,0X90,0XFE,0X00,0X01,0X44,0X48,0XFE,0X00,0X0B,0X08,0X20,0XE0,0X00,
+    0X00,0X90,0X19,0X10,0X00,0X01,0X20,0X02,0XFD,0X00,0X15,0X04,0XC8,0X00,0X02,0X40,
+    0X01,0X24,0X00,0X00,0X80,0X08,0X00,0X00,0X04,0X00,0X02,0X12,0X00,0X01,0X00,0X14,
+    0X08,0XFB,0X00,0X03,0X08,0X00,0X00,0X01,0XF9,0X00,0X0F,0X23,0X04,0X00,0X02,0XC0,
+    0X00,0X80,0X00,0X02,0X00,0X20,0X65,0X00,0X08,0X20,0X06,0XFD,0X00,0X1E,0X01,0XE8,
+    0X00,0X00,0X90,0X12,0X32,0X00,0X05,0X09,0XC9,0XC4,0X00,0X00,0XE6,0X06,0X08,0X00,
+    0X02,0X58,0X45,0XF0,0X00,0X00,0X37,0X98,0X00,0X00,0X01,0X8F,0XE4,0XFE,0X00,0X01,
+    0X40,0X08,0XFE,0X00,0X01,0X3C,0XF0,0XFE,0X00,0X00,0X03,0XF4,0X00,
+};
+const PAINT_IMAGE Image_shidu = { gImage_shidu_pk, 141, 36, 36, IMAGE_PACKBITS };
+
+// 36x36, 180 -> 139 bytes
+static const unsigned char gImage_sunrise_pk[139] = {
+    0XF5,0X00,0X00,0X60,0XEE,0X00,0X19,0X60,0X00,0X00,0X01,0X80,0X00,0X18,0X00,0X00,
+    0X40,0X00,0X20,0X00,0X01,0X00,0X40,0X08,0X00,0X00,0XC3,0XBC,0X30,0X00,0X00,0X0C,
+    0X02,0XFE,0X00,0X06,0X01,0XF9,0X80,0X00,0X00,0X12,0X04,0XFE,0X00,0X06,0X24,0X02,
+    0X40,0X00,0X00,0X08,0X01,0XFA,0X00,0X06,0X3C,0X00,0X00,0X23,0XC0,0X00,0X50,0XFE,
+    0X00,0X07,0X3C,0X60,0X00,0X23,0XC0,0X00,0X07,0XC0,0XFE,0X00,0X01,0X38,0X21,0XFE,
+    0X00,0X05,0X47,0XE2,0X40,0X00,0X00,0X08,0XFD,0X00,0X02,0X4F,0X84,0X80,0XFE,0X00,
+    0X00,0X67,0XFE,0X00,0X07,0X3C,0X10,0X10,0X00,0X00,0X03,0XC0,0X28,0XFE,0X00,0X01,
+    0X08,0X20,0XFE,0X00,0X0A,0X48,0X18,0X00,0X0F,0XFF,0X90,0X00,0X00,0X10,0X00,0X60,
+    0XFE,0X00,0X05,0X0F,0X80,0X00,0X00,0X1F,0XF0,0XF4,0X00,
+};
+const PAINT_IMAGE Image_sunrise = { gImage_sunrise_pk, 139, 36, 36, IMAGE_PACKBITS };
+
+// 36x36, 180 -> 153 bytes
+static const unsigned char gImage_sunset_pk[153] = {
+    0XF6,0X00,0X01,0X07,0XF8,0XFE,0X00,0X01,0X18,0X06,0XFE,0X00,0X01,0X21,0XF9,0XFE,
+    0X00,0X0B,0X06,0X04,0X80,0X00,0X00,0X48,0X02,0X40,0X00,0X00,0X10,0X01,0XFE,0X00,
+    0X0A,0XA0,0X00,0X20,0X00,0X00,0X02,0X00,0X80,0X00,0X00,0X04,0XFD,0X00,0X00,0X09,
+    0XF8,0X00,0X01,0X12,0X80,0XFE,0X00,0X06,0X20,0X00,0XA0,0X00,0X00,0X05,0X40,0XFE,
+    0X00,0X01,0X80,0X21,0XFE,0X00,0X02,0X08,0X06,0X40,0XFE,0X00,0X05,0X98,0X80,0X00,
+    0X00,0X90,0X81,0XFD,0X00,0X06,0X06,0X60,0X00,0X01,0X21,0X00,0X10,0XFE,0X00,0X06,
+    0X64,0X80,0X00,0X02,0X42,0X01,0X08,0XFE,0X00,0X1F,0X90,0X24,0X00,0X04,0X84,0X0A,
+    0X50,0X00,0X00,0X09,0X00,0X02,0X00,0X09,0X00,0X04,0X88,0X00,0X00,0X12,0X00,0X05,
+    0X00,0X12,0X00,0X02,0X80,0X80,0X03,0XE3,0XFE,0X7C,0XFC,0X00,0X00,0X40,0XFD,0X00,
+    0X01,0X40,0X1F,0XFE,0XFF,0X00,0X80,0XF7,0X00,
+};
+const PAINT_IMAGE Image_sunset = { gImage_sunset_pk, 153, 36, 36, IMAGE_PACKBITS };
+
+// 36x36, 180 -> 107 bytes
+static const unsigned char gImage_wendu_pk[107] = {
+    0XF5,0X00,0X00,0XF8,0XFE,0X00,0X01,0X03,0X04,0XFE,0X00,0X01,0X04,0XE2,0XFE,0X00,
+    0X01,0X01,0X18,0XF9,0X00,0X01,0X08,0X01,0XE9,0X00,0X00,0X60,0XDF,0X00,0X00,0X04,
+    0XFE,0X00,0X0B,0X12,0X00,0X80,0X00,0X00,0X24,0X02,0X40,0X00,0X00,0X01,0X99,0XFE,
+    0X00,0X01,0X0A,0X04,0XFE,0X00,0X01,0X40,0XE0,0XFD,0X00,0X06,0X10,0X20,0X00,0X00,
+    0X40,0X80,0X20,0XFE,0X00,0X00,0X70,0XFE,0X00,0X01,0X02,0X05,0XFE,0X00,0X01,0X29,
+    0XD8,0XFE,0X00,0X0B,0X04,0X22,0X40,0X00,0X00,0X13,0X8C,0X80,0X00,0X00,0X08,0X71,
+    0XFE,0X00,0XFF,0X06,0XFE,0X00,0X01,0X01,0XF8,0XFA,0X00,
+};
+const PAINT_IMAGE Image_wendu = { gImage_wendu_pk, 107, 36, 36, IMAGE_PACKBITS };
+
+// 32x32, 128 -> 121 bytes
+static const unsigned char gImage_GPS_pk[121] = {
+    0XFD,0XFF,0XFC,0X00,0X24,0X0F,0XF0,0X00,0X00,0X30,0X0C,0X00,0X00,0X47,0XE2,0X00,
+    0X00,0X98,0X11,0X00,0X01,0X20,0X0C,0X00,0X00,0X03,0XC0,0X80,0X00,0X44,0X32,0X00,
+    0X02,0X09,0X80,0X00,0X00,0X02,0X40,0X40,0X00,0X80,0XFE,0X00,0X49,0X80,0X00,0X00,
+    0X02,0X02,0XC0,0X00,0X00,0X09,0X10,0X40,0X00,0X46,0X22,0X00,0X01,0X21,0XC4,0X80,
+    0X00,0X80,0X08,0X00,0X00,0X10,0X01,0X00,0X00,0X48,0X12,0X00,0X00,0X24,0X24,0X00,
+    0X06,0X13,0X48,0XF0,0X18,0X08,0X90,0X88,0X26,0X04,0X20,0X44,0X08,0X03,0XC0,0X30,
+    0X08,0X00,0X00,0X10,0X07,0X00,0X00,0X60,0X30,0XFF,0X7F,0X8C,0X0C,0X00,0X80,0X30,
+    0X03,0XE0,0X0F,0XC0,0X00,0X1F,0XF0,0XFC,0X00,
+};
+const PAINT_IMAGE Image_GPS = { gImage_GPS_pk, 121, 32, 32, IMAGE_PACKBITS };
+
+#endif
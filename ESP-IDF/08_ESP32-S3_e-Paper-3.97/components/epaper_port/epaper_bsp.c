@@ -8,6 +8,7 @@
 
 #include "epaper_bsp.h"
 #include "epaper_port.h"
+#include "mem_arena.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
 #include "Debug.h"
@@ -21,7 +22,7 @@ int EPD_display_BMP(const char *path)
     EPD_Init();
     UBYTE *BlackImage;
     UDOUBLE Imagesize = ((EPD_WIDTH % 8 == 0)? (EPD_WIDTH / 8 ): (EPD_WIDTH / 8 + 1)) * EPD_HEIGHT;
-    if((BlackImage = (UBYTE *)heap_caps_malloc(Imagesize,MALLOC_CAP_SPIRAM)) == NULL) 
+    if((BlackImage = (UBYTE *)mem_alloc(Imagesize)) == NULL) 
     {
         ESP_LOGE(TAG,"Failed to apply for black memory...");
         return ESP_FAIL;
@@ -61,7 +62,7 @@ int EPD_display_BMP(const char *path)
     EPD_Display(BlackImage);
 
     EPD_Sleep();
-    heap_caps_free(BlackImage);
+    mem_free(BlackImage);
     BlackImage = NULL;
     //updatePathIndex();
     return err;
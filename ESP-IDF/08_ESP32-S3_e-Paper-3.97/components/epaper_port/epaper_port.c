@@ -6,6 +6,8 @@
 #include "axp_prot.h"
 
 #include "epaper_port.h"
+#include "mem_arena.h"
+#include "perf_trace.h"
 
 
 static spi_device_handle_t spi;
@@ -102,12 +104,14 @@ parameter:
 ******************************************************************************/
 static void EPD_Reset(void)
 {
+    TRACE_BEGIN(EPD_RESET);
     epaper_rst_1;
     vTaskDelay(pdMS_TO_TICKS(50));
     epaper_rst_0;
     vTaskDelay(pdMS_TO_TICKS(2));
     epaper_rst_1;
     vTaskDelay(pdMS_TO_TICKS(50));
+    TRACE_END(EPD_RESET);
 }
 
 /******************************************************************************
@@ -139,6 +143,7 @@ static void EPD_SendDataBuffer(const UBYTE* buffer, UDOUBLE length)
     esp_err_t ret;
     const size_t chunk_size = 4096;
     
+    TRACE_BEGIN_ARG(EPD_SPI, length);
     for (size_t i = 0; i < length; i += chunk_size) {
         size_t current_chunk = (i + chunk_size > length) ? (length - i) : chunk_size;
         
@@ -151,9 +156,11 @@ static void EPD_SendDataBuffer(const UBYTE* buffer, UDOUBLE length)
         ret = spi_device_polling_transmit(spi, &t);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "SPI transmission failed: %s", esp_err_to_name(ret));
+            TRACE_END(EPD_SPI);
             return;
         }
     }
+    TRACE_END(EPD_SPI);
     
     ESP_LOGD(TAG, "All %lu bytes transmitted successfully", (unsigned long)length);
 }
@@ -165,6 +172,7 @@ parameter:
 static void EPD_ReadBusy(void)
 {
     // ESP_LOGI(TAG,"e-Paper busy");
+    TRACE_BEGIN(EPD_BUSY);
     vTaskDelay(pdMS_TO_TICKS(100));
     while(1)
     {
@@ -172,6 +180,7 @@ static void EPD_ReadBusy(void)
         // getstat();
         vTaskDelay(pdMS_TO_TICKS(20));
     }
+    TRACE_END(EPD_BUSY);
     // ESP_LOGI(TAG,"e-Paper busy release");
 }
 
@@ -408,7 +417,7 @@ void EPD_Clear(void)
     Height = EPD_HEIGHT;
     UDOUBLE buffer_size = Width * Height;
     
-    UBYTE* buffer = (UBYTE*)malloc(buffer_size);
+    UBYTE* buffer = (UBYTE*)mem_alloc(buffer_size);
     if (!buffer) {
         ESP_LOGE(TAG, "Failed to allocate buffer for clear operation");
         return;
@@ -421,7 +430,7 @@ void EPD_Clear(void)
     EPD_SendCommand(0x26);
     EPD_SendDataBuffer(buffer, buffer_size);
     
-    free(buffer);
+    mem_free(buffer);
     EPD_TurnOnDisplay();
 }
 
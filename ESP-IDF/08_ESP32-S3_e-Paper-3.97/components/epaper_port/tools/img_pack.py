@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Generate ImageData_packed.c, PackBits-compressed copies of the icons in
+ImageData.c for Paint_BlitImage().
+
+The icons keep the layout Paint_ReadBmp() expects (1 = black, MSB first,
+rows padded to whole bytes). The size comes from the converter header in the
+comment after each array, "0X00,0X01,W_lo,W_hi,H_lo,H_hi". Each icon becomes
+
+    static const unsigned char gImage_<name>_pk[]    PackBits stream
+    const PAINT_IMAGE Image_<name>                   descriptor
+
+Every row is XORed with the row above it, which turns the vertical edges
+of the line art into zeros, and the result is PackBits coded: a control byte
+n in 0..127 is followed by n + 1 literal bytes, n in -127..-1 by one byte
+repeated 1 - n times; -128 is skipped. Runs may cross row boundaries.
+
+Usage: img_pack.py [--stats] [--verify] ImageData.c [OUT.c]
+"""
+
+import argparse
+import re
+import sys
+
+SKIP = {"gImage_image"}     # Full-screen frame, sent to EPD_Display as it is
+
+ARRAY_RE = re.compile(
+    r"const unsigned char (gImage_\w+)\[(\d+)\] = \{\s*/\*([^*]*)\*/(.*?)\};", re.S)
+
+
+def parse(text):
+    images = []
+    for m in ARRAY_RE.finditer(text):
+        name = m.group(1)
+        if name in SKIP:
+            continue
+        head = [int(v, 16) for v in re.findall(r"0X([0-9A-Fa-f]{2})", m.group(3))]
+        data = bytes(int(v, 16) for v in re.findall(r"0X([0-9A-Fa-f]{2})", m.group(4)))
+        width, height = head[2] | head[3] << 8, head[4] | head[5] << 8
+        if len(data) != int(m.group(2)) or len(data) != (width + 7) // 8 * height:
+            sys.exit("%s: %d bytes does not match %dx%d" % (name, len(data), width, height))
+        images.append((name, width, height, data))
+    return images
+
+
+def delta(data, row_bytes):
+    out = bytearray(data)
+    for i in range(len(data) - 1, row_bytes - 1, -1):
+        out[i] ^= data[i - row_bytes]
+    return bytes(out)
+
+
+def undelta(data, row_bytes):
+    out = bytearray(data)
+    for i in range(row_bytes, len(out)):
+        out[i] ^= out[i - row_bytes]
+    return bytes(out)
+
+
+def encode(data, width):
+    return packbits(delta(data, (width + 7) // 8))
+
+
+def decode(packed, width, size):
+    return undelta(unpackbits(packed, size), (width + 7) // 8)
+
+
+def packbits(data):
+    out = bytearray()
+    i, n = 0, len(data)
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 2:
+            out += bytes([(257 - run) & 0xFF, data[i]])
+            i += run
+            continue
+        # Literal until the next run of 3, where a repeat packet starts to pay off
+        j = i
+        while j < n and j - i < 128:
+            if j + 2 < n and data[j] == data[j + 1] == data[j + 2]:
+                break
+            j += 1
+        out.append(j - i - 1)
+        out += data[i:j]
+        i = j
+    return bytes(out)
+
+
+def unpackbits(data, size):
+    out = bytearray()
+    i = 0
+    while i < len(data) and len(out) < size:
+        n = data[i]
+        i += 1
+        if n < 128:
+            out += data[i:i + n + 1]
+            i += n + 1
+        elif n > 128:
+            out += bytes([data[i]]) * (257 - n)
+            i += 1
+    return bytes(out)
+
+
+def emit(images, out):
+    w = out.write
+    w("/* Generated by tools/img_pack.py from ImageData.c, do not edit */\n")
+    w('#include "ImageData.h"\n\n')
+    w("#if defined(CONFIG_IMG_SOURCE_EMBEDDED)\n")
+    for name, width, height, data in images:
+        packed = encode(data, width)
+        short = name[len("gImage_"):]
+        w("\n// %dx%d, %d -> %d bytes\n" % (width, height, len(data), len(packed)))
+        w("static const unsigned char %s_pk[%d] = {\n" % (name, len(packed)))
+        for i in range(0, len(packed), 16):
+            w("    " + ",".join("0X%02X" % b for b in packed[i:i + 16]) + ",\n")
+        w("};\n")
+        w("const PAINT_IMAGE Image_%s = { %s_pk, %d, %d, %d, IMAGE_PACKBITS };\n"
+          % (short, name, len(packed), width, height))
+    w("\n#endif\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("src")
+    ap.add_argument("out", nargs="?")
+    ap.add_argument("--stats", action="store_true", help="print per-icon sizes")
+    ap.add_argument("--verify", action="store_true", help="decode every icon and compare")
+    args = ap.parse_args()
+
+    with open(args.src, encoding="utf-8") as f:
+        images = parse(f.read())
+
+    raw_total = packed_total = 0
+    for name, width, height, data in images:
+        packed = encode(data, width)
+        if args.verify and decode(packed, width, len(data)) != data:
+            sys.exit("%s: round trip failed" % name)
+        raw_total += len(data)
+        packed_total += len(packed)
+        if args.stats:
+            print("%-32s %3dx%-3d %5d -> %5d" % (name, width, height, len(data), len(packed)))
+    if args.stats or args.verify:
+        print("%d icons, %d -> %d bytes" % (len(images), raw_total, packed_total))
+
+    if args.out:
+        with open(args.out, "w", encoding="utf-8", newline="\n") as f:
+            emit(images, f)
+
+
+if __name__ == "__main__":
+    main()
@@ -8,9 +8,9 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdlib.h>
 
 static const char *TAG = "ES8311";
-extern i2c_master_dev_handle_t es8311_dev_handle;
 
 esp_codec_dev_handle_t play_dev_handle = NULL;
 esp_codec_dev_handle_t record_dev_handle = NULL;
@@ -18,18 +18,76 @@ esp_codec_dev_handle_t record_dev_handle = NULL;
 i2s_chan_handle_t tx_handle = NULL;
 i2s_chan_handle_t rx_handle = NULL;
 
+// Codec register access through i2c_bsp rather than a device of its own on
+// the raw bus handle, so that ES8311 transactions go through the bus queue
+// at I2C_BSP_PRIO_CODEC ahead of the RTC and the sensors
+typedef struct {
+    audio_codec_ctrl_if_t base;
+    bool is_open;
+    uint8_t addr;           // 7-bit address
+} es8311_bsp_ctrl_t;
+
+static int es8311_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
+{
+    ((es8311_bsp_ctrl_t *)ctrl)->is_open = true;
+    return ESP_CODEC_DEV_OK;
+}
+
+static bool es8311_ctrl_is_open(const audio_codec_ctrl_if_t *ctrl)
+{
+    return ((const es8311_bsp_ctrl_t *)ctrl)->is_open;
+}
+
+static int es8311_ctrl_read_reg(const audio_codec_ctrl_if_t *ctrl, int reg, int reg_len, void *data, int data_len)
+{
+    const es8311_bsp_ctrl_t *c = (const es8311_bsp_ctrl_t *)ctrl;
+    if (!c->is_open) return ESP_CODEC_DEV_WRONG_STATE;
+    // ES8311 registers have an 8-bit address
+    if (reg_len != 1 || data == NULL || data_len <= 0) return ESP_CODEC_DEV_NOT_SUPPORT;
+    if (i2c_read_reg(c->addr, (uint8_t)reg, data, data_len) != ESP_OK) {
+        ESP_LOGE(TAG, "Fail to read reg 0x%02x", reg);
+        return ESP_CODEC_DEV_READ_FAIL;
+    }
+    return ESP_CODEC_DEV_OK;
+}
+
+static int es8311_ctrl_write_reg(const audio_codec_ctrl_if_t *ctrl, int reg, int reg_len, void *data, int data_len)
+{
+    const es8311_bsp_ctrl_t *c = (const es8311_bsp_ctrl_t *)ctrl;
+    if (!c->is_open) return ESP_CODEC_DEV_WRONG_STATE;
+    if (reg_len != 1 || data == NULL || data_len <= 0) return ESP_CODEC_DEV_NOT_SUPPORT;
+    if (i2c_write_reg(c->addr, (uint8_t)reg, data, data_len) != ESP_OK) {
+        ESP_LOGE(TAG, "Fail to write reg 0x%02x", reg);
+        return ESP_CODEC_DEV_WRITE_FAIL;
+    }
+    return ESP_CODEC_DEV_OK;
+}
+
+static int es8311_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
+{
+    ((es8311_bsp_ctrl_t *)ctrl)->is_open = false;
+    return ESP_CODEC_DEV_OK;
+}
+
+// Same ownership as audio_codec_new_i2c_ctrl(): freed by audio_codec_delete_ctrl_if()
+static const audio_codec_ctrl_if_t *es8311_new_bsp_ctrl(uint8_t addr)
+{
+    es8311_bsp_ctrl_t *ctrl = calloc(1, sizeof(es8311_bsp_ctrl_t));
+    if (ctrl == NULL) return NULL;
+    ctrl->base.open = es8311_ctrl_open;
+    ctrl->base.is_open = es8311_ctrl_is_open;
+    ctrl->base.read_reg = es8311_ctrl_read_reg;
+    ctrl->base.write_reg = es8311_ctrl_write_reg;
+    ctrl->base.close = es8311_ctrl_close;
+    ctrl->addr = addr;
+    ctrl->is_open = true;
+    return &ctrl->base;
+}
+
 esp_err_t es8311_codec_init(void)
 {
-    audio_codec_i2c_cfg_t i2c_cfg = {
-        .port = I2C_NUM,
-        .addr = ES8311_CODEC_DEFAULT_ADDR,
-        .bus_handle = (void *)i2c_bus_handle,
-    };
-    
-    ESP_LOGI(TAG, "es i2c_cfg bus_handle=%p addr=0x%02x", i2c_cfg.bus_handle, i2c_cfg.addr);
-    
-    // Create an I2C control interface
-    const audio_codec_ctrl_if_t *i2c_ctrl_if = audio_codec_new_i2c_ctrl(&i2c_cfg);
+    // Create an I2C control interface on the shared bus scheduler
+    const audio_codec_ctrl_if_t *i2c_ctrl_if = es8311_new_bsp_ctrl(ES8311_I2C_ADDR);
     ESP_RETURN_ON_FALSE(i2c_ctrl_if, ESP_FAIL, TAG, "create i2c ctrl interface failed");
     
     // Create GPIO interfaces (for PA control, etc.)
@@ -0,0 +1,154 @@
+#include "dns_responder.h"
+#include <cstring>
+
+#define DNS_HEADER_SIZE     12
+#define DNS_FLAG_QR         0x80
+#define DNS_FLAG_AA         0x04
+#define DNS_FLAG_RD         0x01
+#define DNS_FLAG_RA         0x80
+
+#define DNS_RCODE_FORMERR   1
+#define DNS_RCODE_NOTIMP    4
+
+#define DNS_TYPE_A          1
+#define DNS_TYPE_ANY        255
+#define DNS_CLASS_IN        1
+#define DNS_CLASS_ANY       255
+
+bool DnsResponder::ParseQuestion(const uint8_t* packet, size_t len, DnsQuestion* question) {
+    size_t pos = DNS_HEADER_SIZE;
+    size_t out = 0;
+    while (true) {
+        if (pos >= len) {
+            return false;
+        }
+        uint8_t label = packet[pos++];
+        if (label == 0) {
+            break;
+        }
+        // Compression pointers (0xC0) and the reserved label types have no place in a question.
+        // 253 dotted characters are the 255 bytes RFC 1035 allows on the wire.
+        if (label > 63 || pos + label > len || out + (out > 0) + label > 253) {
+            return false;
+        }
+        if (out > 0) {
+            question->name[out++] = '.';
+        }
+        memcpy(&question->name[out], &packet[pos], label);
+        out += label;
+        pos += label;
+    }
+    question->name[out] = '\0';
+    if (pos + 4 > len) {
+        return false;
+    }
+    question->type = packet[pos] << 8 | packet[pos + 1];
+    question->qclass = packet[pos + 2] << 8 | packet[pos + 3];
+    question->end = pos + 4;
+    return true;
+}
+
+bool DnsResponder::Allow(uint32_t client, int64_t now_ms) {
+    Bucket* bucket = nullptr;
+    Bucket* oldest = &buckets_[0];
+    for (auto& b : buckets_) {
+        if (b.last_ms != 0 && b.client == client) {
+            bucket = &b;
+            break;
+        }
+        if (b.last_ms < oldest->last_ms) {
+            oldest = &b;
+        }
+    }
+    if (now_ms <= 0) {
+        now_ms = 1;     // 0 marks a free slot
+    }
+    if (bucket == nullptr) {
+        // A new client, or one quiet for longer than the others: start full
+        bucket = oldest;
+        bucket->client = client;
+        bucket->tokens = kBurst * 1000;
+    } else {
+        int64_t elapsed = now_ms - bucket->last_ms;
+        if (elapsed > 0) {
+            int64_t tokens = bucket->tokens + (elapsed < 60000 ? elapsed : 60000) * kRefillPerSecond;
+            bucket->tokens = tokens > kBurst * 1000 ? kBurst * 1000 : (int32_t)tokens;
+        }
+    }
+    bucket->last_ms = now_ms;
+    if (bucket->tokens < 1000) {
+        return false;
+    }
+    bucket->tokens -= 1000;
+    return true;
+}
+
+size_t DnsResponder::Error(const uint8_t* query, uint8_t* reply, size_t reply_size, uint8_t rcode) {
+    if (reply_size < DNS_HEADER_SIZE) {
+        stats_.dropped++;
+        return 0;
+    }
+    // The header alone, with no sections: the question may be what was wrong
+    memcpy(reply, query, 2);
+    reply[2] = DNS_FLAG_QR | (query[2] & 0x78) | (query[2] & DNS_FLAG_RD);
+    reply[3] = DNS_FLAG_RA | rcode;
+    memset(&reply[4], 0, DNS_HEADER_SIZE - 4);
+    stats_.errors++;
+    return DNS_HEADER_SIZE;
+}
+
+size_t DnsResponder::Respond(const uint8_t* query, size_t len, uint8_t* reply, size_t reply_size,
+                             uint32_t client, int64_t now_ms) {
+    if (len < DNS_HEADER_SIZE || (query[2] & DNS_FLAG_QR)) {
+        // Too short to say who asked what, or a response: answering could start a loop
+        stats_.dropped++;
+        return 0;
+    }
+    if (!Allow(client, now_ms)) {
+        stats_.limited++;
+        return 0;
+    }
+    if ((query[2] >> 3 & 0x0F) != 0) {
+        return Error(query, reply, reply_size, DNS_RCODE_NOTIMP);
+    }
+    DnsQuestion question;
+    if ((query[4] << 8 | query[5]) != 1 || !ParseQuestion(query, len, &question)) {
+        return Error(query, reply, reply_size, DNS_RCODE_FORMERR);
+    }
+
+    bool answer = (question.type == DNS_TYPE_A || question.type == DNS_TYPE_ANY) &&
+                  (question.qclass == DNS_CLASS_IN || question.qclass == DNS_CLASS_ANY);
+    size_t size = question.end + (answer ? 16 : 0);
+    if (size > reply_size) {
+        stats_.dropped++;
+        return 0;
+    }
+
+    // Header and question as asked; answers, authority and EDNS records are not copied
+    memcpy(reply, query, question.end);
+    reply[2] = DNS_FLAG_QR | DNS_FLAG_AA | (query[2] & DNS_FLAG_RD);
+    reply[3] = DNS_FLAG_RA;
+    memset(&reply[6], 0, 6);
+    if (!answer) {
+        stats_.empty++;
+        return size;
+    }
+
+    reply[7] = 1;
+    uint8_t* rr = &reply[question.end];
+    rr[0] = 0xC0;                               // Name: pointer to the question
+    rr[1] = DNS_HEADER_SIZE;
+    rr[2] = 0;
+    rr[3] = DNS_TYPE_A;
+    rr[4] = 0;
+    rr[5] = DNS_CLASS_IN;
+    rr[6] = kTtl >> 24;
+    rr[7] = kTtl >> 16;
+    rr[8] = kTtl >> 8;
+    rr[9] = kTtl;
+    rr[10] = 0;
+    rr[11] = 4;
+    memcpy(&rr[12], &portal_ip_, 4);            // Already in network byte order
+    stats_.answered++;
+    return size;
+}
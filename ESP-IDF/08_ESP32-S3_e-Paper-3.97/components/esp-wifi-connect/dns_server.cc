@@ -2,20 +2,32 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <lwip/sockets.h>
 #include <lwip/netdb.h>
 
 #define TAG "DnsServer"
 
+// How often the task looks at running_ while no queries come in
+#define DNS_SELECT_TIMEOUT_MS 200
+
 DnsServer::DnsServer() {
 }
 
 DnsServer::~DnsServer() {
+    Stop();
+    if (stopped_ != nullptr) {
+        vSemaphoreDelete(stopped_);
+    }
 }
 
 void DnsServer::Start(esp_ip4_addr_t gateway) {
+    if (running_) {
+        return;
+    }
     ESP_LOGI(TAG, "Starting DNS server");
     gateway_ = gateway;
+    responder_ = DnsResponder(gateway.addr);
 
     fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if (fd_ < 0) {
@@ -32,44 +44,79 @@ void DnsServer::Start(esp_ip4_addr_t gateway) {
     if (bind(fd_, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
         ESP_LOGE(TAG, "failed to bind port %d", port_);
         close(fd_);
+        fd_ = -1;
         return;
     }
 
-    xTaskCreate([](void* arg) {
+    if (stopped_ == nullptr) {
+        stopped_ = xSemaphoreCreateBinary();
+    }
+    xSemaphoreTake(stopped_, 0);
+    running_ = true;
+    if (xTaskCreate([](void* arg) {
         DnsServer* dns_server = static_cast<DnsServer*>(arg);
         dns_server->Run();
-    }, "DnsServerTask", 4096, this, 5, NULL);
+        xSemaphoreGive(dns_server->stopped_);
+        vTaskDelete(NULL);
+    }, "DnsServerTask", 4096, this, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task");
+        running_ = false;
+        close(fd_);
+        fd_ = -1;
+    }
 }
 
 void DnsServer::Stop() {
+    if (!running_) {
+        return;
+    }
     ESP_LOGI(TAG, "Stopping DNS server");
+    running_ = false;
+    // The task notices within one select() timeout
+    if (xSemaphoreTake(stopped_, pdMS_TO_TICKS(DNS_SELECT_TIMEOUT_MS * 5)) != pdTRUE) {
+        ESP_LOGW(TAG, "Task did not exit in time");
+    }
+    close(fd_);
+    fd_ = -1;
+
+    auto& stats = responder_.stats();
+    ESP_LOGI(TAG, "Answered %lu, empty %lu, errors %lu, dropped %lu, rate limited %lu",
+             (unsigned long)stats.answered, (unsigned long)stats.empty, (unsigned long)stats.errors,
+             (unsigned long)stats.dropped, (unsigned long)stats.limited);
 }
 
 void DnsServer::Run() {
-    char buffer[512];
-    while (1) {
+    uint8_t query[DnsResponder::kMaxPacket];
+    uint8_t reply[DnsResponder::kMaxPacket];
+    while (running_) {
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(fd_, &read_fds);
+        struct timeval timeout = { 0, DNS_SELECT_TIMEOUT_MS * 1000 };
+        int ready = select(fd_ + 1, &read_fds, NULL, NULL, &timeout);
+        if (ready < 0) {
+            ESP_LOGE(TAG, "select failed, errno=%d", errno);
+            vTaskDelay(pdMS_TO_TICKS(DNS_SELECT_TIMEOUT_MS));
+            continue;
+        }
+        if (ready == 0) {
+            continue;
+        }
+
         struct sockaddr_in client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
-        int len = recvfrom(fd_, buffer, sizeof(buffer), 0, (struct sockaddr *)&client_addr, &client_addr_len);
+        int len = recvfrom(fd_, query, sizeof(query), MSG_DONTWAIT, (struct sockaddr *)&client_addr, &client_addr_len);
         if (len < 0) {
-            ESP_LOGE(TAG, "recvfrom failed, errno=%d", errno);
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "recvfrom failed, errno=%d", errno);
+            }
             continue;
         }
 
-        // Simple DNS response: point all queries to 192.168.4.1
-        buffer[2] |= 0x80;  // Set response flag
-        buffer[3] |= 0x80;  // Set Recursion Available
-        buffer[7] = 1;      // Set answer count to 1
-
-        // Add answer section
-        memcpy(&buffer[len], "\xc0\x0c", 2);  // Name pointer
-        len += 2;
-        memcpy(&buffer[len], "\x00\x01\x00\x01\x00\x00\x00\x1c\x00\x04", 10);  // Type, class, TTL, data length
-        len += 10;
-        memcpy(&buffer[len], &gateway_.addr, 4);  // 192.168.4.1
-        len += 4;
-        ESP_LOGI(TAG, "Sending DNS response to %s", inet_ntoa(gateway_.addr));
-
-        sendto(fd_, buffer, len, 0, (struct sockaddr *)&client_addr, client_addr_len);
+        size_t reply_len = responder_.Respond(query, len, reply, sizeof(reply), client_addr.sin_addr.s_addr,
+                                              esp_timer_get_time() / 1000);
+        if (reply_len > 0) {
+            sendto(fd_, reply, reply_len, 0, (struct sockaddr *)&client_addr, client_addr_len);
+        }
     }
 }
@@ -0,0 +1,74 @@
+#ifndef _DNS_RESPONDER_H_
+#define _DNS_RESPONDER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// The single question of a DNS query
+struct DnsQuestion {
+    char name[256];             // Dotted, without the trailing dot; "" for the root
+    uint16_t type;
+    uint16_t qclass;
+    size_t end;                 // Offset just past the question in the packet
+};
+
+/*
+ * Answers for the captive portal DNS server. Every name resolves to the
+ * portal address:
+ *   A, ANY             one A record with the portal address
+ *   AAAA, HTTPS, ...   NOERROR without answers, so clients fall back to IPv4
+ *                      right away instead of waiting for a timeout
+ *   not a query        dropped
+ *   malformed          FORMERR if the header is readable, dropped otherwise
+ *   other opcodes      NOTIMP
+ * EDNS options are ignored and no OPT record is sent back, which tells the
+ * client to stay within 512 bytes. Requests are rate limited per client with
+ * a token bucket. No ESP-IDF dependency so it can be checked on the host.
+ */
+class DnsResponder {
+public:
+    static constexpr size_t kMaxPacket = 512;
+    static constexpr uint32_t kTtl = 10;            // Seconds, short so nothing sticks after provisioning
+    static constexpr int kMaxClients = 8;
+    static constexpr int kBurst = 16;               // Requests a client may send at once
+    static constexpr int kRefillPerSecond = 8;
+
+    struct Stats {
+        uint32_t answered;
+        uint32_t empty;
+        uint32_t errors;
+        uint32_t dropped;
+        uint32_t limited;
+    };
+
+    // portal_ip in network byte order, as in esp_ip4_addr_t
+    explicit DnsResponder(uint32_t portal_ip = 0) : portal_ip_(portal_ip) {}
+    void SetPortalIp(uint32_t portal_ip) { portal_ip_ = portal_ip; }
+
+    // Build the reply to query from client (any unique key, e.g. its address)
+    // at now_ms. Returns the reply length, 0 if nothing is to be sent.
+    size_t Respond(const uint8_t* query, size_t len, uint8_t* reply, size_t reply_size,
+                   uint32_t client, int64_t now_ms);
+
+    // Take a token from the client's bucket
+    bool Allow(uint32_t client, int64_t now_ms);
+
+    static bool ParseQuestion(const uint8_t* packet, size_t len, DnsQuestion* question);
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Bucket {
+        uint32_t client;
+        int32_t tokens;                 // In 1/1000 of a request
+        int64_t last_ms;                // 0 when the slot is free
+    };
+
+    uint32_t portal_ip_;
+    Bucket buckets_[kMaxClients] = {};
+    Stats stats_ = {};
+
+    size_t Error(const uint8_t* query, uint8_t* reply, size_t reply_size, uint8_t rcode);
+};
+
+#endif // _DNS_RESPONDER_H_
@@ -1,8 +1,13 @@
 #ifndef _DNS_SERVER_H_
 #define _DNS_SERVER_H_
 
+#include <atomic>
 #include <string>
 #include <esp_netif_ip_addr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "dns_responder.h"
 
 class DnsServer {
 public:
@@ -10,12 +15,16 @@ public:
     ~DnsServer();
 
     void Start(esp_ip4_addr_t gateway);
+    // Returns once the task has exited and the socket is closed
     void Stop();
 
 private:
     int port_ = 53;
     int fd_ = -1;
     esp_ip4_addr_t gateway_;
+    DnsResponder responder_;
+    std::atomic<bool> running_{false};
+    SemaphoreHandle_t stopped_ = nullptr;
     void Run();
 };
 
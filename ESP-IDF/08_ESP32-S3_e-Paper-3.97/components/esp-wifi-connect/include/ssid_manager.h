@@ -3,6 +3,9 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+
+#include "wifi_fast_connect.h"
 
 struct SsidItem {
     std::string ssid;
@@ -22,14 +25,33 @@ public:
     void Clear();
     const std::vector<SsidItem>& GetSsidList() const { return ssid_list_; }
 
+    // Channel, BSSID and DHCP lease of the last connection, for WifiFastConnect
+    bool LoadConnectCache(WifiConnectCache& cache);
+    void SaveConnectCache(const WifiConnectCache& cache);
+    void ClearConnectCache();
+
+    // Last resolved IPv4 addresses of the hosts the application talks to
+    bool GetHostAddress(const std::string& host, uint32_t& ip, int64_t& resolved);
+    void SetHostAddress(const std::string& host, uint32_t ip, int64_t resolved);
+    void RemoveHostAddress(const std::string& host);
+
 private:
     SsidManager();
     ~SsidManager();
 
     void LoadFromNvs();
     void SaveToNvs();
+    void SaveHostsToNvs();
+
+    struct HostEntry {
+        char host[48];
+        uint32_t ip;
+        int64_t resolved;
+    };
 
     std::vector<SsidItem> ssid_list_;
+    std::vector<HostEntry> hosts_;
+    bool hosts_loaded_ = false;
 };
 
 #endif // SSID_MANAGER_H
@@ -12,6 +12,7 @@
 #include <esp_wifi_types_generic.h>
 
 #include "dns_server.h"
+#include "wifi_scan_cache.h"
 
 class WifiConfigurationAp {
 public:
@@ -23,6 +24,8 @@ public:
     void StartSmartConfig();
     bool ConnectToWifi(const std::string &ssid, const std::string &password);
     void Save(const std::string &ssid, const std::string &password);
+    // Time on each channel and pause between background scans, before Start()
+    void SetScanTiming(uint32_t dwell_ms, uint32_t interval_s);
 
     std::string GetSsid();
     std::string GetWebServerUrl();
@@ -47,9 +50,21 @@ private:
     esp_event_handler_instance_t instance_any_id_;
     esp_event_handler_instance_t instance_got_ip_;
     esp_timer_handle_t scan_timer_ = nullptr;
+    esp_timer_handle_t long_poll_timer_ = nullptr;
     bool is_connecting_ = false;
     esp_netif_t* ap_netif_ = nullptr;
-    std::vector<wifi_ap_record_t> ap_records_;
+    uint32_t scan_dwell_ms_ = 120;
+    uint32_t scan_interval_s_ = 10;
+
+    // /scan requests with the current ETag wait here for the next change
+    struct PendingScan {
+        httpd_req_t* req;
+        int64_t deadline;       // esp_timer time
+    };
+    static constexpr size_t kMaxPendingScans = 4;
+    static constexpr int64_t kLongPollUs = 25 * 1000000;
+    WifiScanCache scan_cache_;
+    std::vector<PendingScan> pending_scans_;
 
     // 高级配置项
     std::string ota_url_;
@@ -58,6 +73,10 @@ private:
 
     void StartAccessPoint();
     void StartWebServer();
+    void StartScan();
+    // Answer the waiting /scan requests, all of them or only the expired ones
+    void AnswerPendingScans(bool all);
+    static esp_err_t SendScan(httpd_req_t* req, const std::string& json, const std::string& etag, bool not_modified);
 
     // Event handlers
     static void WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
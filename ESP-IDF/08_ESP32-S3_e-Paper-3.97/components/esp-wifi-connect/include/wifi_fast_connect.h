@@ -0,0 +1,67 @@
+#ifndef _WIFI_FAST_CONNECT_H_
+#define _WIFI_FAST_CONNECT_H_
+
+#include <cstdint>
+
+// What the last successful connection left behind, kept in NVS by SsidManager.
+// Addresses are in network byte order, as in esp_ip4_addr_t.
+struct WifiConnectCache {
+    uint8_t version;
+    uint8_t channel;
+    uint8_t authmode;           // wifi_auth_mode_t
+    uint8_t pmf_required;
+    uint8_t bssid[6];
+    char ssid[33];
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gateway;
+    uint32_t dns;
+    int64_t lease_start;        // Wall clock when the lease was obtained, 0 if none
+    uint32_t lease_time;        // Seconds
+};
+
+#define WIFI_CONNECT_CACHE_VERSION 1
+
+// Failure of one connection attempt
+enum class WifiFailure {
+    kNoAp,                      // Nothing answered on the cached channel / BSSID
+    kAuth,                      // Wrong password or handshake timeout
+    kTimeout,                   // No IP in time
+    kOther,
+};
+
+/*
+ * Order of attempts on wake-up:
+ *   kStaticIp  cached channel and BSSID, the cached address set without DHCP
+ *   kDhcp      cached channel and BSSID, normal DHCP
+ *   kScan      full scan of all channels, the WifiStation behaviour before the cache
+ * A fast attempt is retried once unless the AP is gone, then it is a full scan.
+ * No ESP-IDF dependency so it can be checked on the host.
+ */
+class WifiFastConnect {
+public:
+    enum class Step { kStaticIp, kDhcp, kScan, kDone };
+
+    static constexpr int kMaxFastAttempts = 2;
+    static constexpr int kTimeoutMs = 3000;          // To associate
+    static constexpr int kDhcpTimeoutMs = 5000;      // From association to an address
+
+    // Choose the first step. now is -1 when the wall clock is unknown.
+    Step Begin(const WifiConnectCache* cache, bool ssid_saved, int64_t now);
+    Step OnFailure(WifiFailure failure);
+    void OnConnected() { step_ = Step::kDone; }
+
+    Step step() const { return step_; }
+    bool fast() const { return step_ == Step::kStaticIp || step_ == Step::kDhcp; }
+    int attempts() const { return attempts_; }
+
+    // The lease is reused only in its first half, before a DHCP client would renew it
+    static bool LeaseUsable(const WifiConnectCache& cache, int64_t now);
+    static const char* StepName(Step step);
+
+private:
+    Step step_ = Step::kScan;
+    int attempts_ = 0;
+};
+
+#endif // _WIFI_FAST_CONNECT_H_
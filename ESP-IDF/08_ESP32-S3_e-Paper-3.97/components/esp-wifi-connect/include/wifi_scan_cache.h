@@ -0,0 +1,55 @@
+#ifndef _WIFI_SCAN_CACHE_H_
+#define _WIFI_SCAN_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One access point from a scan, the fields of wifi_ap_record_t the portal uses
+struct WifiScanEntry {
+    std::string ssid;
+    int8_t rssi;
+    uint8_t authmode;           // wifi_auth_mode_t
+    uint8_t channel;
+};
+
+/*
+ * The list served at /scan. Each scan is reduced to one entry per SSID (the
+ * strongest BSSID), hidden networks are dropped and the rest sorted by RSSI,
+ * strongest first. A new snapshot is published only when a network appears,
+ * goes or moves by kRssiHysteresis dB, so a page long-polling on the ETag is
+ * not woken by every scan's noise.
+ * No ESP-IDF dependency so it can be checked on the host.
+ */
+class WifiScanCache {
+public:
+    static constexpr int kRssiHysteresis = 6;
+    static constexpr size_t kMaxEntries = 20;
+
+    // Returns true when a new snapshot was published
+    bool Update(std::vector<WifiScanEntry> records);
+
+    // False until the first scan is in
+    bool ready() const { return version_ > 0; }
+    uint32_t version() const { return version_; }
+    size_t size() const { return published_.size(); }
+    const std::string& json() const { return json_; }
+    const std::string& etag() const { return etag_; }   // Quoted, as sent in the header
+
+    // If-None-Match holds the current tag: a list of tags, weak ones (W/"...") included, or "*"
+    bool Matches(const char* if_none_match) const { return EtagMatches(etag_, if_none_match); }
+
+    static void Deduplicate(std::vector<WifiScanEntry>& records);
+    static std::string ToJson(const std::vector<WifiScanEntry>& records);
+    static bool EtagMatches(const std::string& etag, const char* if_none_match);
+
+private:
+    std::vector<WifiScanEntry> published_;
+    std::string json_ = "[]";
+    std::string etag_;
+    uint32_t version_ = 0;
+
+    bool Differs(const std::vector<WifiScanEntry>& records) const;
+};
+
+#endif // _WIFI_SCAN_CACHE_H_
@@ -4,11 +4,15 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <atomic>
 
 #include <esp_event.h>
 #include <esp_timer.h>
+#include <esp_netif.h>
 #include <esp_wifi_types_generic.h>
 
+#include "wifi_fast_connect.h"
+
 struct WifiApRecord {
     std::string ssid;
     std::string password;
@@ -25,11 +29,20 @@ public:
     void Stop();
     bool IsConnected();
     bool WaitForConnected(int timeout_ms = 10000);
+    bool WaitForAssociated(int timeout_ms = 10000);
     int8_t GetRssi();
     std::string GetSsid() const { return ssid_; }
     std::string GetIpAddress() const { return ip_address_; }
     uint8_t GetChannel();
     void SetPowerSaveMode(bool enabled);
+    // Seconds on the wall clock that survives power-off (the RTC), call before Start().
+    // Without it cached DHCP leases are not reused.
+    void SetWallClock(int64_t seconds);
+
+    // Dotted address of host, from the NVS cache when fresh, empty if it can't be resolved
+    std::string ResolveHost(const std::string& host);
+    // The cached address did not work
+    void ForgetHost(const std::string& host);
 
     void OnConnect(std::function<void(const std::string& ssid)> on_connect);
     void OnConnected(std::function<void(const std::string& ssid)> on_connected);
@@ -45,6 +58,7 @@ private:
     esp_timer_handle_t timer_handle_ = nullptr;
     esp_event_handler_instance_t instance_any_id_ = nullptr;
     esp_event_handler_instance_t instance_got_ip_ = nullptr;
+    esp_netif_t* netif_ = nullptr;
     std::string ssid_;
     std::string password_;
     std::string ip_address_;
@@ -56,8 +70,24 @@ private:
     std::function<void()> on_scan_begin_;
     std::vector<WifiApRecord> connect_queue_;
 
+    WifiFastConnect fast_;
+    WifiConnectCache cache_ = {};
+    bool have_cache_ = false;
+    bool static_ip_ = false;
+    std::atomic<bool> fast_timeout_{false};
+    int64_t start_us_ = 0;
+    int64_t wall_clock_ = -1;
+    int64_t wall_clock_us_ = 0;
+
     void HandleScanResult();
     void StartConnect();
+    void PrepareFastConnect();
+    void StartFastConnect();
+    void FastConnectFailed(WifiFailure failure);
+    void SetStaticIp(bool enable);
+    void SaveConnectCache(const esp_netif_ip_info_t& ip_info);
+    uint32_t GetLeaseTime();
+    int64_t WallClock();
     static void WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
     static void IpEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
 };
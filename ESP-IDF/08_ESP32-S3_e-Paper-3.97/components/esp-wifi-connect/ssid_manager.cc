@@ -1,12 +1,16 @@
 #include "ssid_manager.h"
 
 #include <algorithm>
+#include <cstring>
 #include <esp_log.h>
 #include <nvs_flash.h>
 
 #define TAG "SsidManager"
 #define NVS_NAMESPACE "wifi"
 #define MAX_WIFI_SSID_COUNT 10
+#define MAX_HOST_COUNT 4
+#define CONNECT_CACHE_KEY "fast_conn"
+#define HOST_CACHE_KEY "host_ips"
 
 SsidManager::SsidManager() {
     LoadFromNvs();
@@ -18,6 +22,7 @@ SsidManager::~SsidManager() {
 void SsidManager::Clear() {
     ssid_list_.clear();
     SaveToNvs();
+    ClearConnectCache();
 }
 
 void SsidManager::LoadFromNvs() {
@@ -108,6 +113,10 @@ void SsidManager::RemoveSsid(int index) {
         ESP_LOGW(TAG, "Invalid index %d", index);
         return;
     }
+    WifiConnectCache cache;
+    if (LoadConnectCache(cache) && ssid_list_[index].ssid == cache.ssid) {
+        ClearConnectCache();
+    }
     ssid_list_.erase(ssid_list_.begin() + index);
     SaveToNvs();
 }
@@ -123,3 +132,113 @@ void SsidManager::SetDefaultSsid(int index) {
     ssid_list_.insert(ssid_list_.begin(), item);
     SaveToNvs();
 }
+
+bool SsidManager::LoadConnectCache(WifiConnectCache& cache) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+    size_t length = sizeof(cache);
+    auto ret = nvs_get_blob(nvs_handle, CONNECT_CACHE_KEY, &cache, &length);
+    nvs_close(nvs_handle);
+    // The SSID is compared as a string, a blob without its terminator is not ours
+    return ret == ESP_OK && length == sizeof(cache) && cache.version == WIFI_CONNECT_CACHE_VERSION &&
+           cache.ssid[0] != '\0' && memchr(cache.ssid, '\0', sizeof(cache.ssid)) != nullptr;
+}
+
+void SsidManager::SaveConnectCache(const WifiConnectCache& cache) {
+    // Written on every connection, skip it when nothing changed to spare the flash
+    WifiConnectCache old;
+    if (LoadConnectCache(old) && memcmp(&old, &cache, sizeof(cache)) == 0) {
+        return;
+    }
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    nvs_set_blob(nvs_handle, CONNECT_CACHE_KEY, &cache, sizeof(cache));
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+}
+
+void SsidManager::ClearConnectCache() {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_erase_key(nvs_handle, CONNECT_CACHE_KEY) == ESP_OK) {
+        nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+}
+
+bool SsidManager::GetHostAddress(const std::string& host, uint32_t& ip, int64_t& resolved) {
+    if (!hosts_loaded_) {
+        hosts_loaded_ = true;
+        nvs_handle_t nvs_handle;
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+            HostEntry entries[MAX_HOST_COUNT];
+            size_t length = sizeof(entries);
+            if (nvs_get_blob(nvs_handle, HOST_CACHE_KEY, entries, &length) == ESP_OK) {
+                hosts_.assign(entries, entries + length / sizeof(HostEntry));
+            }
+            nvs_close(nvs_handle);
+        }
+    }
+    for (auto& entry : hosts_) {
+        if (host == entry.host) {
+            ip = entry.ip;
+            resolved = entry.resolved;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SsidManager::SetHostAddress(const std::string& host, uint32_t ip, int64_t resolved) {
+    if (host.size() >= sizeof(HostEntry::host)) {
+        return;
+    }
+    uint32_t old_ip;
+    int64_t old_resolved;
+    GetHostAddress(host, old_ip, old_resolved);
+    hosts_.erase(std::remove_if(hosts_.begin(), hosts_.end(), [&host](const HostEntry& entry) {
+        return host == entry.host;
+    }), hosts_.end());
+    // Most recent first, the oldest falls off
+    HostEntry entry = {};
+    strcpy(entry.host, host.c_str());
+    entry.ip = ip;
+    entry.resolved = resolved;
+    hosts_.insert(hosts_.begin(), entry);
+    if (hosts_.size() > MAX_HOST_COUNT) {
+        hosts_.pop_back();
+    }
+    SaveHostsToNvs();
+}
+
+void SsidManager::RemoveHostAddress(const std::string& host) {
+    uint32_t ip;
+    int64_t resolved;
+    if (!GetHostAddress(host, ip, resolved)) {
+        return;
+    }
+    hosts_.erase(std::remove_if(hosts_.begin(), hosts_.end(), [&host](const HostEntry& entry) {
+        return host == entry.host;
+    }), hosts_.end());
+    SaveHostsToNvs();
+}
+
+void SsidManager::SaveHostsToNvs() {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    if (hosts_.empty()) {
+        nvs_erase_key(nvs_handle, HOST_CACHE_KEY);
+    } else {
+        nvs_set_blob(nvs_handle, HOST_CACHE_KEY, hosts_.data(), hosts_.size() * sizeof(HostEntry));
+    }
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+}
@@ -41,6 +41,10 @@ WifiConfigurationAp::~WifiConfigurationAp()
         esp_timer_stop(scan_timer_);
         esp_timer_delete(scan_timer_);
     }
+    if (long_poll_timer_) {
+        esp_timer_stop(long_poll_timer_);
+        esp_timer_delete(long_poll_timer_);
+    }
     if (event_group_) {
         vEventGroupDelete(event_group_);
     }
@@ -80,14 +84,15 @@ void WifiConfigurationAp::Start()
     StartAccessPoint();
     StartWebServer();
     
-    // Start scan immediately
-    esp_wifi_scan_start(nullptr, false);
     // Setup periodic WiFi scan timer
     esp_timer_create_args_t timer_args = {
         .callback = [](void* arg) {
             auto* self = static_cast<WifiConfigurationAp*>(arg);
             if (!self->is_connecting_) {
-                esp_wifi_scan_start(nullptr, false);
+                self->StartScan();
+            } else {
+                // The radio is busy with a connection attempt, look again later
+                esp_timer_start_once(self->scan_timer_, self->scan_interval_s_ * 1000000ULL);
             }
         },
         .arg = this,
@@ -96,6 +101,81 @@ void WifiConfigurationAp::Start()
         .skip_unhandled_events = true
     };
     ESP_ERROR_CHECK(esp_timer_create(&timer_args, &scan_timer_));
+
+    // Expire long polls that saw no change
+    esp_timer_create_args_t long_poll_args = {
+        .callback = [](void* arg) {
+            static_cast<WifiConfigurationAp*>(arg)->AnswerPendingScans(false);
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "wifi_scan_poll",
+        .skip_unhandled_events = true
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&long_poll_args, &long_poll_timer_));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(long_poll_timer_, 1000000));
+
+    // Start scan immediately
+    StartScan();
+}
+
+void WifiConfigurationAp::SetScanTiming(uint32_t dwell_ms, uint32_t interval_s)
+{
+    scan_dwell_ms_ = dwell_ms;
+    scan_interval_s_ = interval_s > 0 ? interval_s : 1;
+}
+
+void WifiConfigurationAp::StartScan()
+{
+    wifi_scan_config_t scan_config = {};
+    scan_config.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+    scan_config.scan_time.active.min = scan_dwell_ms_ / 2;
+    scan_config.scan_time.active.max = scan_dwell_ms_;
+    if (esp_wifi_scan_start(&scan_config, false) != ESP_OK) {
+        esp_timer_start_once(scan_timer_, scan_interval_s_ * 1000000ULL);
+    }
+}
+
+esp_err_t WifiConfigurationAp::SendScan(httpd_req_t* req, const std::string& json, const std::string& etag, bool not_modified)
+{
+    httpd_resp_set_hdr(req, "Connection", "close");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (!etag.empty()) {
+        httpd_resp_set_hdr(req, "ETag", etag.c_str());
+    }
+    if (not_modified) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, nullptr, 0);
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json.data(), json.size());
+}
+
+void WifiConfigurationAp::AnswerPendingScans(bool all)
+{
+    std::vector<PendingScan> due;
+    std::string json, etag;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t now = esp_timer_get_time();
+        for (auto it = pending_scans_.begin(); it != pending_scans_.end();) {
+            if (all || now >= it->deadline) {
+                due.push_back(*it);
+                it = pending_scans_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        json = scan_cache_.json();
+        etag = scan_cache_.etag();
+    }
+    for (auto& pending : due) {
+        // Waiters hold the current tag, so an unchanged list is a 304; with no scan yet it is "[]"
+        char if_none_match[64] = "";
+        httpd_req_get_hdr_value_str(pending.req, "If-None-Match", if_none_match, sizeof(if_none_match));
+        SendScan(pending.req, json, etag, WifiScanCache::EtagMatches(etag, if_none_match));
+        httpd_req_async_handler_complete(pending.req);
+    }
 }
 
 std::string WifiConfigurationAp::GetSsid()
@@ -286,32 +366,38 @@ void WifiConfigurationAp::StartWebServer()
     };
     ESP_ERROR_CHECK(httpd_register_uri_handler(server_, &saved_delete));
 
-    // Register the /scan URI
+    // Register the /scan URI. A request with the current ETag in If-None-Match
+    // is held until the list changes or kLongPollUs has passed.
     httpd_uri_t scan = {
         .uri = "/scan",
         .method = HTTP_GET,
         .handler = [](httpd_req_t *req) -> esp_err_t {
             auto *this_ = static_cast<WifiConfigurationAp *>(req->user_ctx);
-            std::lock_guard<std::mutex> lock(this_->mutex_);
 
-            // Send the scan results as JSON
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_set_hdr(req, "Connection", "close");
-            httpd_resp_sendstr_chunk(req, "[");
-            for (int i = 0; i < this_->ap_records_.size(); i++) {
-                ESP_LOGI(TAG, "SSID: %s, RSSI: %d, Authmode: %d",
-                    (char *)this_->ap_records_[i].ssid, this_->ap_records_[i].rssi, this_->ap_records_[i].authmode);
-                char buf[128];
-                snprintf(buf, sizeof(buf), "{\"ssid\":\"%s\",\"rssi\":%d,\"authmode\":%d}",
-                    (char *)this_->ap_records_[i].ssid, this_->ap_records_[i].rssi, this_->ap_records_[i].authmode);
-                httpd_resp_sendstr_chunk(req, buf);
-                if (i < this_->ap_records_.size() - 1) {
-                    httpd_resp_sendstr_chunk(req, ",");
+            // The page reports how long its first list took to show
+            char query[32];
+            char ttfl[8];
+            if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+                httpd_query_key_value(query, "ttfl", ttfl, sizeof(ttfl)) == ESP_OK) {
+                ESP_LOGI(TAG, "Portal showed the first list %s ms after loading", ttfl);
+            }
+
+            char if_none_match[64] = "";
+            httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match));
+
+            std::unique_lock<std::mutex> lock(this_->mutex_);
+            bool changed = this_->scan_cache_.ready() && !this_->scan_cache_.Matches(if_none_match);
+            if (!changed && this_->pending_scans_.size() < kMaxPendingScans) {
+                httpd_req_t *async_req;
+                if (httpd_req_async_handler_begin(req, &async_req) == ESP_OK) {
+                    this_->pending_scans_.push_back({async_req, esp_timer_get_time() + kLongPollUs});
+                    return ESP_OK;
                 }
             }
-            httpd_resp_sendstr_chunk(req, "]");
-            httpd_resp_sendstr_chunk(req, NULL);
-            return ESP_OK;
+            std::string json = this_->scan_cache_.json();
+            std::string etag = this_->scan_cache_.etag();
+            lock.unlock();
+            return SendScan(req, json, etag, !changed && !etag.empty());
         },
         .user_ctx = this
     };
@@ -695,15 +781,30 @@ void WifiConfigurationAp::WifiEventHandler(void* arg, esp_event_base_t event_bas
     } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
         xEventGroupSetBits(self->event_group_, WIFI_FAIL_BIT);
     } else if (event_id == WIFI_EVENT_SCAN_DONE) {
-        std::lock_guard<std::mutex> lock(self->mutex_);
         uint16_t ap_num = 0;
         esp_wifi_scan_get_ap_num(&ap_num);
+        std::vector<wifi_ap_record_t> records(ap_num);
+        esp_wifi_scan_get_ap_records(&ap_num, records.data());
 
-        self->ap_records_.resize(ap_num);
-        esp_wifi_scan_get_ap_records(&ap_num, self->ap_records_.data());
+        std::vector<WifiScanEntry> entries;
+        entries.reserve(ap_num);
+        for (int i = 0; i < ap_num; i++) {
+            entries.push_back({(const char *)records[i].ssid, records[i].rssi, (uint8_t)records[i].authmode, records[i].primary});
+        }
+        bool changed;
+        size_t networks;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex_);
+            changed = self->scan_cache_.Update(std::move(entries));
+            networks = self->scan_cache_.size();
+        }
+        if (changed) {
+            ESP_LOGI(TAG, "Scan list updated: %d networks from %d records", (int)networks, ap_num);
+            self->AnswerPendingScans(true);
+        }
 
-        // 扫描完成，等待10秒后再次扫描
-        esp_timer_start_once(self->scan_timer_, 10 * 1000000);
+        // 扫描完成，等待一段时间后再次扫描
+        esp_timer_start_once(self->scan_timer_, self->scan_interval_s_ * 1000000ULL);
     }
 }
 
@@ -785,6 +886,14 @@ void WifiConfigurationAp::Stop() {
         esp_timer_delete(scan_timer_);
         scan_timer_ = nullptr;
     }
+    if (long_poll_timer_) {
+        esp_timer_stop(long_poll_timer_);
+        esp_timer_delete(long_poll_timer_);
+        long_poll_timer_ = nullptr;
+    }
+
+    // Release the held /scan requests before their sockets go away
+    AnswerPendingScans(true);
 
     // 停止Web服务器
     if (server_) {
@@ -0,0 +1,52 @@
+#include "wifi_fast_connect.h"
+
+WifiFastConnect::Step WifiFastConnect::Begin(const WifiConnectCache* cache, bool ssid_saved, int64_t now) {
+    attempts_ = 1;
+    if (cache == nullptr || !ssid_saved || cache->version != WIFI_CONNECT_CACHE_VERSION ||
+        cache->channel == 0 || cache->channel > 14) {
+        step_ = Step::kScan;
+    } else if (LeaseUsable(*cache, now)) {
+        step_ = Step::kStaticIp;
+    } else {
+        step_ = Step::kDhcp;
+    }
+    return step_;
+}
+
+WifiFastConnect::Step WifiFastConnect::OnFailure(WifiFailure failure) {
+    if (!fast()) {
+        return step_;
+    }
+    if (failure == WifiFailure::kNoAp || attempts_ >= kMaxFastAttempts) {
+        step_ = Step::kScan;
+        attempts_ = 0;
+        return step_;
+    }
+    // A timeout with the static address may mean the address is no longer ours
+    if (failure == WifiFailure::kTimeout && step_ == Step::kStaticIp) {
+        step_ = Step::kDhcp;
+    }
+    attempts_++;
+    return step_;
+}
+
+bool WifiFastConnect::LeaseUsable(const WifiConnectCache& cache, int64_t now) {
+    if (now < 0 || cache.lease_start <= 0 || cache.lease_time == 0 || cache.ip == 0 || cache.gateway == 0) {
+        return false;
+    }
+    // A clock that went back, e.g. the RTC was set, says nothing about the lease
+    if (now < cache.lease_start) {
+        return false;
+    }
+    return now - cache.lease_start < cache.lease_time / 2;
+}
+
+const char* WifiFastConnect::StepName(Step step) {
+    switch (step) {
+        case Step::kStaticIp: return "static ip";
+        case Step::kDhcp: return "known channel";
+        case Step::kScan: return "full scan";
+        case Step::kDone: return "done";
+    }
+    return "?";
+}
@@ -0,0 +1,154 @@
+#include "wifi_scan_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void WifiScanCache::Deduplicate(std::vector<WifiScanEntry>& records) {
+    records.erase(std::remove_if(records.begin(), records.end(),
+                                 [](const WifiScanEntry& e) { return e.ssid.empty(); }),
+                  records.end());
+    // Strongest first, then the first of each SSID is the one to keep
+    std::stable_sort(records.begin(), records.end(), [](const WifiScanEntry& a, const WifiScanEntry& b) {
+        return a.rssi != b.rssi ? a.rssi > b.rssi : a.ssid < b.ssid;
+    });
+    std::vector<WifiScanEntry> unique;
+    unique.reserve(records.size());
+    for (auto& e : records) {
+        if (std::none_of(unique.begin(), unique.end(), [&](const WifiScanEntry& u) { return u.ssid == e.ssid; })) {
+            unique.push_back(std::move(e));
+        }
+    }
+    if (unique.size() > kMaxEntries) {
+        unique.resize(kMaxEntries);
+    }
+    records = std::move(unique);
+}
+
+// Length of the UTF-8 sequence at s, 0 if it is not valid UTF-8 (RFC 3629: no
+// overlong forms, surrogates or code points above U+10FFFF)
+static size_t Utf8Length(const unsigned char* s, size_t left) {
+    size_t len = s[0] < 0x80 ? 1 : s[0] < 0xC2 ? 0 : s[0] < 0xE0 ? 2 : s[0] < 0xF0 ? 3 : s[0] < 0xF5 ? 4 : 0;
+    if (len == 0 || len > left) {
+        return 0;
+    }
+    for (size_t i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    if ((s[0] == 0xE0 && s[1] < 0xA0) || (s[0] == 0xED && s[1] > 0x9F) ||
+        (s[0] == 0xF0 && s[1] < 0x90) || (s[0] == 0xF4 && s[1] > 0x8F)) {
+        return 0;
+    }
+    return len;
+}
+
+static void AppendJsonString(std::string& out, const std::string& s) {
+    out += '"';
+    auto* p = reinterpret_cast<const unsigned char*>(s.data());
+    size_t i = 0;
+    while (i < s.size()) {
+        unsigned char c = p[i];
+        size_t len = Utf8Length(p + i, s.size() - i);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c >= 0x20 && len > 0) {
+            out.append(s, i, len);
+            i += len;
+            continue;
+        } else {
+            // Control characters must be escaped. Bytes of other encodings (GBK SSIDs) are
+            // sent as Latin-1 rather than left for the browser to turn into U+FFFD.
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        i++;
+    }
+    out += '"';
+}
+
+std::string WifiScanCache::ToJson(const std::vector<WifiScanEntry>& records) {
+    std::string json = "[";
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"ssid\":";
+        AppendJsonString(json, records[i].ssid);
+        char buf[48];
+        snprintf(buf, sizeof(buf), ",\"rssi\":%d,\"authmode\":%d}", records[i].rssi, records[i].authmode);
+        json += buf;
+    }
+    json += ']';
+    return json;
+}
+
+bool WifiScanCache::Differs(const std::vector<WifiScanEntry>& records) const {
+    if (records.size() != published_.size()) {
+        return true;
+    }
+    for (auto& e : records) {
+        auto it = std::find_if(published_.begin(), published_.end(),
+                               [&](const WifiScanEntry& p) { return p.ssid == e.ssid; });
+        if (it == published_.end() || it->authmode != e.authmode || std::abs(it->rssi - e.rssi) >= kRssiHysteresis) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// If-None-Match compares weakly (RFC 9110 13.1.2), so W/ is ignored on either side
+bool WifiScanCache::EtagMatches(const std::string& etag, const char* if_none_match) {
+    if (etag.empty()) {
+        return false;
+    }
+    const char* p = if_none_match;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        if (*p == '*') {
+            return true;
+        }
+        if (p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
+        if (*p != '"') {
+            // Not a tag, skip to the next one
+            p += strcspn(p, ",");
+            continue;
+        }
+        const char* end = strchr(p + 1, '"');
+        if (end == nullptr) {
+            return false;
+        }
+        if ((size_t)(end + 1 - p) == etag.size() && memcmp(p, etag.data(), etag.size()) == 0) {
+            return true;
+        }
+        p = end + 1;
+    }
+    return false;
+}
+
+bool WifiScanCache::Update(std::vector<WifiScanEntry> records) {
+    Deduplicate(records);
+    if (ready() && !Differs(records)) {
+        return false;
+    }
+    published_ = std::move(records);
+    json_ = ToJson(published_);
+
+    // FNV-1a of the body: the same list gets the same tag, even after a restart
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : json_) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    char buf[12];
+    snprintf(buf, sizeof(buf), "\"%08lx\"", (unsigned long)hash);
+    etag_ = buf;
+    version_++;
+    return true;
+}
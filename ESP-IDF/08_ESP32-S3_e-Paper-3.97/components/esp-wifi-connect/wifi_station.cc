@@ -9,12 +9,18 @@
 #include <nvs.h>
 #include "nvs_flash.h"
 #include <esp_netif.h>
+#include <esp_netif_net_stack.h>
 #include <esp_system.h>
+#include <lwip/dhcp.h>
+#include <lwip/netdb.h>
 #include "ssid_manager.h"
 
 #define TAG "wifi"
 #define WIFI_EVENT_CONNECTED BIT0
+#define WIFI_EVENT_ASSOCIATED BIT1
 #define MAX_RECONNECT_COUNT 5
+// Cached host addresses are looked up again after a day
+#define HOST_CACHE_SECONDS (24 * 3600)
 
 WifiStation& WifiStation::GetInstance() {
     static WifiStation instance;
@@ -68,6 +74,8 @@ void WifiStation::Stop() {
         instance_got_ip_ = nullptr;
     }
 
+    SetStaticIp(false);
+
     // Reset the WiFi stack
     ESP_ERROR_CHECK(esp_wifi_stop());
     ESP_ERROR_CHECK(esp_wifi_deinit());
@@ -101,22 +109,25 @@ void WifiStation::Start() {
                                                         &instance_got_ip_));
 
     // Create the default event loop
-    esp_netif_create_default_wifi_sta();
+    netif_ = esp_netif_create_default_wifi_sta();
 
     // Initialize the WiFi stack in station mode
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     cfg.nvs_enable = false;
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    if (max_tx_power_ != 0) {
-        ESP_ERROR_CHECK(esp_wifi_set_max_tx_power(max_tx_power_));
-    }
 
-    // Setup the timer to scan WiFi
+    // Setup the timer to scan WiFi, during a fast connect it is the attempt's timeout.
+    // Created before the start so the STA_START handler can use it.
     esp_timer_create_args_t timer_args = {
         .callback = [](void* arg) {
+            auto* this_ = static_cast<WifiStation*>(arg);
+            if (this_->fast_.fast()) {
+                // Handled with the disconnect event it causes
+                this_->fast_timeout_ = true;
+                esp_wifi_disconnect();
+                return;
+            }
             esp_wifi_scan_start(nullptr, false);
         },
         .arg = this,
@@ -125,6 +136,206 @@ void WifiStation::Start() {
         .skip_unhandled_events = true
     };
     ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer_handle_));
+
+    PrepareFastConnect();
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    if (max_tx_power_ != 0) {
+        ESP_ERROR_CHECK(esp_wifi_set_max_tx_power(max_tx_power_));
+    }
+}
+
+void WifiStation::SetWallClock(int64_t seconds) {
+    wall_clock_ = seconds;
+    wall_clock_us_ = esp_timer_get_time();
+}
+
+int64_t WifiStation::WallClock() {
+    if (wall_clock_ < 0) {
+        return -1;
+    }
+    return wall_clock_ + (esp_timer_get_time() - wall_clock_us_) / 1000000;
+}
+
+void WifiStation::PrepareFastConnect() {
+    auto& ssid_manager = SsidManager::GetInstance();
+    have_cache_ = ssid_manager.LoadConnectCache(cache_);
+    bool saved = false;
+    if (have_cache_) {
+        for (auto& item : ssid_manager.GetSsidList()) {
+            if (item.ssid == cache_.ssid) {
+                saved = true;
+                break;
+            }
+        }
+    }
+    auto step = fast_.Begin(have_cache_ ? &cache_ : nullptr, saved, WallClock());
+    SetStaticIp(step == WifiFastConnect::Step::kStaticIp);
+    fast_timeout_ = false;
+    start_us_ = esp_timer_get_time();
+    ESP_LOGI(TAG, "Connect via %s", WifiFastConnect::StepName(step));
+}
+
+void WifiStation::SetStaticIp(bool enable) {
+    if (enable == static_ip_ || netif_ == nullptr) {
+        return;
+    }
+    if (!enable) {
+        esp_netif_dhcpc_start(netif_);
+        static_ip_ = false;
+        return;
+    }
+
+    esp_netif_dhcpc_stop(netif_);
+    esp_netif_ip_info_t ip_info = {};
+    ip_info.ip.addr = cache_.ip;
+    ip_info.netmask.addr = cache_.netmask;
+    ip_info.gw.addr = cache_.gateway;
+    if (esp_netif_set_ip_info(netif_, &ip_info) != ESP_OK) {
+        esp_netif_dhcpc_start(netif_);
+        return;
+    }
+    if (cache_.dns != 0) {
+        esp_netif_dns_info_t dns = {};
+        dns.ip.type = ESP_IPADDR_TYPE_V4;
+        dns.ip.u_addr.ip4.addr = cache_.dns;
+        esp_netif_set_dns_info(netif_, ESP_NETIF_DNS_MAIN, &dns);
+    }
+    static_ip_ = true;
+}
+
+// Connect straight to the cached BSSID on its channel, no scan
+void WifiStation::StartFastConnect() {
+    for (auto& item : SsidManager::GetInstance().GetSsidList()) {
+        if (item.ssid == cache_.ssid) {
+            ssid_ = item.ssid;
+            password_ = item.password;
+            break;
+        }
+    }
+
+    if (on_connect_) {
+        on_connect_(ssid_);
+    }
+
+    wifi_config_t wifi_config;
+    bzero(&wifi_config, sizeof(wifi_config));
+    strcpy((char *)wifi_config.sta.ssid, ssid_.c_str());
+    strcpy((char *)wifi_config.sta.password, password_.c_str());
+    wifi_config.sta.channel = cache_.channel;
+    memcpy(wifi_config.sta.bssid, cache_.bssid, 6);
+    wifi_config.sta.bssid_set = true;
+    wifi_config.sta.pmf_cfg.capable = true;
+    wifi_config.sta.pmf_cfg.required = cache_.pmf_required;
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+
+    esp_timer_stop(timer_handle_);
+    esp_timer_start_once(timer_handle_, WifiFastConnect::kTimeoutMs * 1000);
+    esp_wifi_connect();
+}
+
+void WifiStation::FastConnectFailed(WifiFailure failure) {
+    esp_timer_stop(timer_handle_);
+    auto step = fast_.OnFailure(failure);
+    ESP_LOGW(TAG, "Fast connect failed (%d), next: %s", (int)failure, WifiFastConnect::StepName(step));
+    SetStaticIp(step == WifiFastConnect::Step::kStaticIp);
+    if (fast_.fast()) {
+        StartFastConnect();
+        return;
+    }
+
+    // The cache is stale, don't try it again on the next wake
+    SsidManager::GetInstance().ClearConnectCache();
+    have_cache_ = false;
+    esp_wifi_scan_start(nullptr, false);
+    if (on_scan_begin_) {
+        on_scan_begin_();
+    }
+}
+
+uint32_t WifiStation::GetLeaseTime() {
+    auto* lwip_netif = static_cast<struct netif*>(esp_netif_get_netif_impl(netif_));
+    if (lwip_netif == nullptr) {
+        return 0;
+    }
+    struct dhcp* dhcp = netif_dhcp_data(lwip_netif);
+    return dhcp != nullptr ? dhcp->offered_t0_lease : 0;
+}
+
+void WifiStation::SaveConnectCache(const esp_netif_ip_info_t& ip_info) {
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+
+    WifiConnectCache cache = {};
+    cache.version = WIFI_CONNECT_CACHE_VERSION;
+    cache.channel = ap_info.primary;
+    cache.authmode = ap_info.authmode;
+    // WPA3-SAE only networks refuse stations without PMF
+    cache.pmf_required = ap_info.authmode == WIFI_AUTH_WPA3_PSK;
+    memcpy(cache.bssid, ap_info.bssid, 6);
+    strncpy(cache.ssid, ssid_.c_str(), sizeof(cache.ssid) - 1);
+
+    if (static_ip_ && have_cache_) {
+        // The cached address, its lease still runs from when DHCP gave it.
+        // DHCP stays off for the session, the device powers off when left alone.
+        cache.ip = cache_.ip;
+        cache.netmask = cache_.netmask;
+        cache.gateway = cache_.gateway;
+        cache.dns = cache_.dns;
+        cache.lease_start = cache_.lease_start;
+        cache.lease_time = cache_.lease_time;
+    } else {
+        cache.ip = ip_info.ip.addr;
+        cache.netmask = ip_info.netmask.addr;
+        cache.gateway = ip_info.gw.addr;
+        esp_netif_dns_info_t dns;
+        if (esp_netif_get_dns_info(netif_, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK && dns.ip.type == ESP_IPADDR_TYPE_V4) {
+            cache.dns = dns.ip.u_addr.ip4.addr;
+        }
+        int64_t now = WallClock();
+        cache.lease_time = GetLeaseTime();
+        cache.lease_start = (now > 0 && cache.lease_time > 0) ? now : 0;
+    }
+
+    SsidManager::GetInstance().SaveConnectCache(cache);
+    cache_ = cache;
+    have_cache_ = true;
+}
+
+std::string WifiStation::ResolveHost(const std::string& host) {
+    auto& ssid_manager = SsidManager::GetInstance();
+    uint32_t ip;
+    int64_t resolved;
+    int64_t now = WallClock();
+    char address[16];
+    if (ssid_manager.GetHostAddress(host, ip, resolved) &&
+        (now < 0 || (now >= resolved && now - resolved < HOST_CACHE_SECONDS))) {
+        esp_ip4_addr_t addr = { .addr = ip };
+        esp_ip4addr_ntoa(&addr, address, sizeof(address));
+        return address;
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr) {
+        ESP_LOGW(TAG, "Failed to resolve %s", host.c_str());
+        return "";
+    }
+    ip = reinterpret_cast<struct sockaddr_in*>(res->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(res);
+
+    ssid_manager.SetHostAddress(host, ip, now > 0 ? now : 0);
+    esp_ip4_addr_t addr = { .addr = ip };
+    esp_ip4addr_ntoa(&addr, address, sizeof(address));
+    return address;
+}
+
+void WifiStation::ForgetHost(const std::string& host) {
+    SsidManager::GetInstance().RemoveHostAddress(host);
 }
 
 bool WifiStation::WaitForConnected(int timeout_ms) {
@@ -132,6 +343,11 @@ bool WifiStation::WaitForConnected(int timeout_ms) {
     return (bits & WIFI_EVENT_CONNECTED) != 0;
 }
 
+bool WifiStation::WaitForAssociated(int timeout_ms) {
+    auto bits = xEventGroupWaitBits(event_group_, WIFI_EVENT_ASSOCIATED | WIFI_EVENT_CONNECTED, pdFALSE, pdFALSE, timeout_ms / portTICK_PERIOD_MS);
+    return (bits & (WIFI_EVENT_ASSOCIATED | WIFI_EVENT_CONNECTED)) != 0;
+}
+
 void WifiStation::HandleScanResult() {
     uint16_t ap_num = 0;
     esp_wifi_scan_get_ap_num(&ap_num);
@@ -227,6 +443,10 @@ void WifiStation::SetPowerSaveMode(bool enabled) {
 void WifiStation::WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     auto* this_ = static_cast<WifiStation*>(arg);
     if (event_id == WIFI_EVENT_STA_START) {
+        if (this_->fast_.fast()) {
+            this_->StartFastConnect();
+            return;
+        }
         esp_wifi_scan_start(nullptr, false);
         if (this_->on_scan_begin_) {
             this_->on_scan_begin_();
@@ -234,7 +454,21 @@ void WifiStation::WifiEventHandler(void* arg, esp_event_base_t event_base, int32
     } else if (event_id == WIFI_EVENT_SCAN_DONE) {
         this_->HandleScanResult();
     } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        xEventGroupClearBits(this_->event_group_, WIFI_EVENT_CONNECTED);
+        auto bits = xEventGroupClearBits(this_->event_group_, WIFI_EVENT_CONNECTED | WIFI_EVENT_ASSOCIATED);
+        if (this_->fast_.fast()) {
+            auto* event = static_cast<wifi_event_sta_disconnected_t*>(event_data);
+            WifiFailure failure = WifiFailure::kOther;
+            if (this_->fast_timeout_.exchange(false)) {
+                failure = (bits & WIFI_EVENT_ASSOCIATED) ? WifiFailure::kTimeout : WifiFailure::kOther;
+            } else if (event->reason == WIFI_REASON_NO_AP_FOUND) {
+                failure = WifiFailure::kNoAp;
+            } else if (event->reason == WIFI_REASON_AUTH_FAIL || event->reason == WIFI_REASON_ASSOC_FAIL ||
+                       event->reason == WIFI_REASON_HANDSHAKE_TIMEOUT || event->reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT) {
+                failure = WifiFailure::kAuth;
+            }
+            this_->FastConnectFailed(failure);
+            return;
+        }
         if (this_->reconnect_count_ < MAX_RECONNECT_COUNT) {
             esp_wifi_connect();
             this_->reconnect_count_++;
@@ -250,6 +484,11 @@ void WifiStation::WifiEventHandler(void* arg, esp_event_base_t event_base, int32
         ESP_LOGI(TAG, "No more AP to connect, wait for next scan");
         esp_timer_start_once(this_->timer_handle_, 10 * 1000);
     } else if (event_id == WIFI_EVENT_STA_CONNECTED) {
+        xEventGroupSetBits(this_->event_group_, WIFI_EVENT_ASSOCIATED);
+        if (this_->fast_.step() == WifiFastConnect::Step::kDhcp) {
+            esp_timer_stop(this_->timer_handle_);
+            esp_timer_start_once(this_->timer_handle_, WifiFastConnect::kDhcpTimeoutMs * 1000);
+        }
     }
 }
 
@@ -261,11 +500,26 @@ void WifiStation::IpEventHandler(void* arg, esp_event_base_t event_base, int32_t
     esp_ip4addr_ntoa(&event->ip_info.ip, ip_address, sizeof(ip_address));
     this_->ip_address_ = ip_address;
     ESP_LOGI(TAG, "Got IP: %s", this_->ip_address_.c_str());
-    
+
+    auto path = this_->fast_.step();
+    if (this_->fast_.fast()) {
+        esp_timer_stop(this_->timer_handle_);
+        this_->fast_.OnConnected();
+    }
+    if (this_->start_us_ != 0) {
+        // Time from Start(), compare the paths on the device
+        ESP_LOGI(TAG, "Connected in %d ms (%s)", (int)((esp_timer_get_time() - this_->start_us_) / 1000),
+            WifiFastConnect::StepName(path));
+        this_->start_us_ = 0;
+    }
+
     xEventGroupSetBits(this_->event_group_, WIFI_EVENT_CONNECTED);
     if (this_->on_connected_) {
         this_->on_connected_(this_->ssid_);
     }
     this_->connect_queue_.clear();
     this_->reconnect_count_ = 0;
+
+    // After the waiters are released, the NVS write takes a while
+    this_->SaveConnectCache(event->ip_info);
 }
@@ -1,10 +1,20 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "i2c_bsp.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
+#include "perf_trace.h"
 #include <string.h>
 
+#if I2C_BSP_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error "I2C_BSP_NOTIFY_INDEX needs a larger CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES"
+#endif
+
 static const char *TAG = "I2C_BSP";
 
 // I2C Master Bus Handle
@@ -16,6 +26,36 @@ i2c_master_dev_handle_t shtc3_dev_handle = NULL;
 i2c_master_dev_handle_t axp2101_dev_handle = NULL;
 i2c_master_dev_handle_t qmi8658_dev_handle = NULL;
 
+// One entry of the device handle cache
+typedef struct {
+    i2c_master_dev_handle_t handle;
+    i2c_dev_stats_t stats;
+} i2c_bsp_dev_t;
+
+// A queued transaction. The buffers belong to the caller, which blocks until done.
+typedef struct {
+    i2c_bsp_dev_t *dev;
+    bool has_reg;
+    uint8_t reg;
+    const uint8_t *wbuf;
+    size_t wlen;
+    uint8_t *rbuf;
+    size_t rlen;
+    int64_t queued_us;
+    TaskHandle_t waiter;
+    esp_err_t *ret;
+} i2c_bsp_job_t;
+
+static i2c_bsp_dev_t dev_cache[I2C_BSP_MAX_DEVICES];
+static int dev_count = 0;
+static SemaphoreHandle_t dev_lock = NULL;
+
+static QueueHandle_t job_queue[I2C_BSP_PRIO_NUM];
+static SemaphoreHandle_t job_sem = NULL;
+static TaskHandle_t executor_handle = NULL;
+
+static void i2c_bsp_executor(void *arg);
+
 void i2c_master_init(void)
 {
     // Configure the I2C Master bus
@@ -27,9 +67,62 @@ void i2c_master_init(void)
         .glitch_ignore_cnt = 7,
         .flags.enable_internal_pullup = true,
     };
-    
+
     ESP_ERROR_CHECK(i2c_new_master_bus(&bus_config, &i2c_bus_handle));
     ESP_LOGI(TAG, "I2C master bus initialized on port %d", I2C_MASTER_NUM);
+
+    // Every transaction issued through this file goes through a single executor task
+    dev_lock = xSemaphoreCreateMutex();
+    job_sem = xSemaphoreCreateCounting(I2C_BSP_PRIO_NUM * I2C_BSP_QUEUE_LEN, 0);
+    for (int i = 0; i < I2C_BSP_PRIO_NUM; i++) {
+        job_queue[i] = xQueueCreate(I2C_BSP_QUEUE_LEN, sizeof(i2c_bsp_job_t));
+    }
+    assert(dev_lock != NULL && job_sem != NULL);
+    if (xTaskCreate(i2c_bsp_executor, "i2c_bsp", I2C_BSP_TASK_STACK, NULL, I2C_BSP_TASK_PRIO, &executor_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the I2C executor, transactions run in the caller");
+        executor_handle = NULL;
+    }
+}
+
+// Look up a device in the cache, creating its handle on first use
+static i2c_bsp_dev_t *i2c_bsp_get_dev(uint8_t dev_addr, uint32_t scl_speed_hz)
+{
+    i2c_bsp_dev_t *dev = NULL;
+
+    if (!i2c_bus_handle) {
+        ESP_LOGE(TAG, "I2C bus not initialized");
+        return NULL;
+    }
+
+    xSemaphoreTake(dev_lock, portMAX_DELAY);
+    for (int i = 0; i < dev_count; i++) {
+        if (dev_cache[i].stats.addr == dev_addr && dev_cache[i].stats.scl_speed_hz == scl_speed_hz) {
+            dev = &dev_cache[i];
+            break;
+        }
+    }
+    if (!dev && dev_count < I2C_BSP_MAX_DEVICES) {
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = dev_addr,
+            .scl_speed_hz = scl_speed_hz,
+        };
+        i2c_master_dev_handle_t handle = NULL;
+        esp_err_t ret = i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &handle);
+        if (ret == ESP_OK) {
+            dev = &dev_cache[dev_count++];
+            memset(dev, 0, sizeof(*dev));
+            dev->handle = handle;
+            dev->stats.addr = dev_addr;
+            dev->stats.scl_speed_hz = scl_speed_hz;
+        } else {
+            ESP_LOGE(TAG, "Failed to add device 0x%02x: %s", dev_addr, esp_err_to_name(ret));
+        }
+    } else if (!dev) {
+        ESP_LOGE(TAG, "Device cache full, cannot add 0x%02x", dev_addr);
+    }
+    xSemaphoreGive(dev_lock);
+    return dev;
 }
 
 // Add the device to the bus
@@ -39,164 +132,214 @@ esp_err_t i2c_bus_add_device(uint8_t dev_addr, uint32_t scl_speed_hz, i2c_master
         ESP_LOGE(TAG, "I2C bus not initialized");
         return ESP_ERR_INVALID_STATE;
     }
-    
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = dev_addr,
-        .scl_speed_hz = scl_speed_hz,
-    };
-    
-    return i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, dev_handle);
+
+    i2c_bsp_dev_t *dev = i2c_bsp_get_dev(dev_addr, scl_speed_hz);
+    if (!dev) return ESP_FAIL;
+    *dev_handle = dev->handle;
+    return ESP_OK;
 }
 
 // Initialize all I2C devices
 esp_err_t i2c_devices_init(void)
 {
     esp_err_t ret;
-    
+
     // RTC (PCF85063)
     ret = i2c_bus_add_device(PCF85063Addr, I2C_MASTER_FREQ_HZ, &rtc_dev_handle);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to add RTC device: %s", esp_err_to_name(ret));
     }
-    
+
     // Temperature and humidity sensor (SHTC3)
     ret = i2c_bus_add_device(SHTC3Addr, I2C_MASTER_FREQ_HZ, &shtc3_dev_handle);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to add SHTC3 device: %s", esp_err_to_name(ret));
     }
-    
+
     // Power Management (AXP2101)
     ret = i2c_bus_add_device(AXP2101Addr, I2C_MASTER_FREQ_HZ, &axp2101_dev_handle);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to add AXP2101 device: %s", esp_err_to_name(ret));
     }
-    
+
     // Six-axis sensor (QMI8658)
     ret = i2c_bus_add_device(QMI8658_SLAVE_ADDR_L, I2C_MASTER_FREQ_HZ, &qmi8658_dev_handle);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to add QMI8658 device: %s", esp_err_to_name(ret));
     }
-    
+
     ESP_LOGI(TAG, "All I2C devices initialized");
     return ESP_OK;
 }
 
-// Obtain the corresponding handle based on the device address
-static i2c_master_dev_handle_t get_dev_handle(uint8_t dev_addr)
+// Priority of a device on the shared bus: audio codec > RTC > sensors
+static i2c_bsp_prio_t i2c_bsp_prio_of(uint8_t dev_addr)
 {
-    if (dev_addr == PCF85063Addr && rtc_dev_handle) return rtc_dev_handle;
-    if (dev_addr == SHTC3Addr && shtc3_dev_handle) return shtc3_dev_handle;
-    if (dev_addr == AXP2101Addr && axp2101_dev_handle) return axp2101_dev_handle;
-    if (dev_addr == QMI8658_SLAVE_ADDR_L && qmi8658_dev_handle) return qmi8658_dev_handle;
-    return NULL;
+    if (dev_addr == ES8311_I2C_ADDR) return I2C_BSP_PRIO_CODEC;
+    if (dev_addr == PCF85063Addr) return I2C_BSP_PRIO_RTC;
+    return I2C_BSP_PRIO_SENSOR;
+}
+
+// Perform one transaction on the bus and account for it
+static esp_err_t i2c_bsp_run_job(const i2c_bsp_job_t *job)
+{
+    uint8_t tx_stack[I2C_BSP_TX_BUF_LEN];
+    const uint8_t *tx = job->wbuf;
+    uint8_t *tx_heap = NULL;
+    size_t tx_len = job->wlen;
+    esp_err_t ret;
+
+    // A register write is sent as [reg, data...] in a single transfer
+    if (job->has_reg) {
+        tx_len = job->wlen + 1;
+        uint8_t *buf = tx_stack;
+        if (tx_len > sizeof(tx_stack)) {
+            tx_heap = malloc(tx_len);
+            if (!tx_heap) return ESP_ERR_NO_MEM;
+            buf = tx_heap;
+        }
+        buf[0] = job->reg;
+        if (job->wlen) memcpy(&buf[1], job->wbuf, job->wlen);
+        tx = buf;
+    }
+
+    int64_t start = esp_timer_get_time();
+    TRACE_COUNTER(I2C_WAIT_US, start - job->queued_us);
+    TRACE_BEGIN_ARG(I2C_XFER, job->dev->stats.addr);
+    if (tx_len && job->rlen) {
+        ret = i2c_master_transmit_receive(job->dev->handle, tx, tx_len, job->rbuf, job->rlen, I2C_BSP_TIMEOUT_MS);
+    } else if (job->rlen) {
+        ret = i2c_master_receive(job->dev->handle, job->rbuf, job->rlen, I2C_BSP_TIMEOUT_MS);
+    } else {
+        ret = i2c_master_transmit(job->dev->handle, tx, tx_len, I2C_BSP_TIMEOUT_MS);
+    }
+    TRACE_END(I2C_XFER);
+    int64_t end = esp_timer_get_time();
+    free(tx_heap);
+
+    i2c_dev_stats_t *st = &job->dev->stats;
+    uint32_t busy = (uint32_t)(end - start);
+    uint32_t wait = (uint32_t)(start - job->queued_us);
+    xSemaphoreTake(dev_lock, portMAX_DELAY);
+    st->transactions++;
+    st->bytes += tx_len + job->rlen;
+    st->busy_us += busy;
+    if (busy > st->max_us) st->max_us = busy;
+    if (wait > st->max_wait_us) st->max_wait_us = wait;
+    if (ret != ESP_OK) st->errors++;
+    xSemaphoreGive(dev_lock);
+
+    return ret;
+}
+
+// The only task that touches the bus. Queues are drained strictly by priority.
+static void i2c_bsp_executor(void *arg)
+{
+    i2c_bsp_job_t job;
+
+    while (1) {
+        xSemaphoreTake(job_sem, portMAX_DELAY);
+        for (int prio = 0; prio < I2C_BSP_PRIO_NUM; prio++) {
+            if (xQueueReceive(job_queue[prio], &job, 0) == pdTRUE) {
+                *job.ret = i2c_bsp_run_job(&job);
+                xTaskNotifyGiveIndexed(job.waiter, I2C_BSP_NOTIFY_INDEX);
+                break;
+            }
+        }
+    }
+}
+
+// Queue a transaction and block until the executor has finished it
+static esp_err_t i2c_bsp_submit(uint8_t dev_addr, bool has_reg, uint8_t reg,
+                                const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+    esp_err_t ret = ESP_FAIL;
+    i2c_bsp_job_t job = {
+        .dev = i2c_bsp_get_dev(dev_addr, I2C_MASTER_FREQ_HZ),
+        .has_reg = has_reg,
+        .reg = reg,
+        .wbuf = wbuf,
+        .wlen = wlen,
+        .rbuf = rbuf,
+        .rlen = rlen,
+        .queued_us = esp_timer_get_time(),
+        .waiter = xTaskGetCurrentTaskHandle(),
+        .ret = &ret,
+    };
+
+    if (!job.dev) return ESP_ERR_INVALID_STATE;
+
+    // Without an executor, or when called from it, run in place
+    if (executor_handle == NULL || job.waiter == executor_handle) {
+        return i2c_bsp_run_job(&job);
+    }
+
+    if (xQueueSend(job_queue[i2c_bsp_prio_of(dev_addr)], &job, portMAX_DELAY) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(job_sem);
+    ulTaskNotifyTakeIndexed(I2C_BSP_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    return ret;
 }
 
 // Write to the register (with register address）
 esp_err_t i2c_write_reg(uint8_t dev_addr, uint8_t reg, uint8_t *data, size_t len)
 {
-    i2c_master_dev_handle_t dev_handle = get_dev_handle(dev_addr);
-    
-    // If there is no pre-created handle, create a temporary one
-    if (!dev_handle) {
-        esp_err_t ret = i2c_bus_add_device(dev_addr, I2C_MASTER_FREQ_HZ, &dev_handle);
-        if (ret != ESP_OK) return ret;
-    }
-    
-    uint8_t buf[len + 1];
-    buf[0] = reg;
-    memcpy(&buf[1], data, len);
-    
-    esp_err_t ret = i2c_master_transmit(dev_handle, buf, len + 1, pdMS_TO_TICKS(1000));
-    
-    // If the handle is created temporarily, it needs to be deleted
-    if (get_dev_handle(dev_addr) == NULL) {
-        i2c_master_bus_rm_device(dev_handle);
-    }
-    
-    return ret;
+    return i2c_bsp_submit(dev_addr, true, reg, data, len, NULL, 0);
 }
 
 // Read the register (write the register address first and then read the data)
 esp_err_t i2c_read_reg(uint8_t dev_addr, uint8_t reg, uint8_t *data, size_t len)
 {
-    i2c_master_dev_handle_t dev_handle = get_dev_handle(dev_addr);
-    
-    // If there is no pre-created handle, create a temporary one
-    if (!dev_handle) {
-        esp_err_t ret = i2c_bus_add_device(dev_addr, I2C_MASTER_FREQ_HZ, &dev_handle);
-        if (ret != ESP_OK) return ret;
-    }
-    
-    esp_err_t ret = i2c_master_transmit_receive(dev_handle, &reg, 1, data, len, pdMS_TO_TICKS(1000));
-    
-    // If the handle is created temporarily, it needs to be deleted
-    if (get_dev_handle(dev_addr) == NULL) {
-        i2c_master_bus_rm_device(dev_handle);
-    }
-    
-    return ret;
+    return i2c_bsp_submit(dev_addr, true, reg, NULL, 0, data, len);
 }
 
 // Only write data (without register addresses)
 esp_err_t i2c_write_bytes(uint8_t dev_addr, uint8_t *data, size_t len)
 {
-    i2c_master_dev_handle_t dev_handle = get_dev_handle(dev_addr);
-    
-    // If there is no pre-created handle, create a temporary one
-    if (!dev_handle) {
-        esp_err_t ret = i2c_bus_add_device(dev_addr, I2C_MASTER_FREQ_HZ, &dev_handle);
-        if (ret != ESP_OK) return ret;
-    }
-    
-    esp_err_t ret = i2c_master_transmit(dev_handle, data, len, pdMS_TO_TICKS(1000));
-    
-    // If the handle is created temporarily, it needs to be deleted
-    if (get_dev_handle(dev_addr) == NULL) {
-        i2c_master_bus_rm_device(dev_handle);
-    }
-    
-    return ret;
+    return i2c_bsp_submit(dev_addr, false, 0, data, len, NULL, 0);
 }
 
 // Read-only data (without register address)
 esp_err_t i2c_read_bytes(uint8_t dev_addr, uint8_t *data, size_t len)
 {
-    i2c_master_dev_handle_t dev_handle = get_dev_handle(dev_addr);
-    
-    // If there is no pre-created handle, create a temporary one
-    if (!dev_handle) {
-        esp_err_t ret = i2c_bus_add_device(dev_addr, I2C_MASTER_FREQ_HZ, &dev_handle);
-        if (ret != ESP_OK) return ret;
-    }
-    
-    esp_err_t ret = i2c_master_receive(dev_handle, data, len, pdMS_TO_TICKS(1000));
-    
-    // If the handle is created temporarily, it needs to be deleted
-    if (get_dev_handle(dev_addr) == NULL) {
-        i2c_master_bus_rm_device(dev_handle);
-    }
-    
-    return ret;
+    return i2c_bsp_submit(dev_addr, false, 0, NULL, 0, data, len);
+}
+
+// Write then read with a repeated start
+esp_err_t i2c_write_read(uint8_t dev_addr, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+    return i2c_bsp_submit(dev_addr, false, 0, wbuf, wlen, rbuf, rlen);
 }
 
 // Functions compatible with old code
 esp_err_t i2c_master_write_read_device_compat(uint8_t addr, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
 {
-    i2c_master_dev_handle_t dev_handle = get_dev_handle(addr);
-    
-    // If there is no pre-created handle, create a temporary one
-    if (!dev_handle) {
-        esp_err_t ret = i2c_bus_add_device(addr, I2C_MASTER_FREQ_HZ, &dev_handle);
-        if (ret != ESP_OK) return ret;
-    }
-    
-    esp_err_t ret = i2c_master_transmit_receive(dev_handle, wbuf, wlen, rbuf, rlen, pdMS_TO_TICKS(1000));
-    
-    // If the handle is created temporarily, it needs to be deleted
-    if (get_dev_handle(addr) == NULL) {
-        i2c_master_bus_rm_device(dev_handle);
-    }
-    
-    return ret;
-}
\ No newline at end of file
+    return i2c_write_read(addr, wbuf, wlen, rbuf, rlen);
+}
+
+int i2c_bsp_get_stats(i2c_dev_stats_t *stats, int max)
+{
+    int n = 0;
+
+    if (!dev_lock) return 0;
+    xSemaphoreTake(dev_lock, portMAX_DELAY);
+    for (; n < dev_count && n < max; n++) {
+        stats[n] = dev_cache[n].stats;
+    }
+    xSemaphoreGive(dev_lock);
+    return n;
+}
+
+void i2c_bsp_log_stats(void)
+{
+    i2c_dev_stats_t stats[I2C_BSP_MAX_DEVICES];
+    int n = i2c_bsp_get_stats(stats, I2C_BSP_MAX_DEVICES);
+
+    for (int i = 0; i < n; i++) {
+        ESP_LOGI(TAG, "0x%02x: %lu xfers, %lu errors, %lu bytes, busy %llu us (max %lu us, max wait %lu us)",
+                 stats[i].addr, (unsigned long)stats[i].transactions, (unsigned long)stats[i].errors,
+                 (unsigned long)stats[i].bytes, (unsigned long long)stats[i].busy_us,
+                 (unsigned long)stats[i].max_us, (unsigned long)stats[i].max_wait_us);
+    }
+}
@@ -28,6 +28,40 @@ extern i2c_master_dev_handle_t qmi8658_dev_handle;
 #define I2C_MASTER_NUM   0
 #define I2C_MASTER_FREQ_HZ 400000
 
+// Bus scheduler
+#define I2C_BSP_MAX_DEVICES     8       // Size of the device handle cache
+#define I2C_BSP_QUEUE_LEN       8       // Pending transactions per priority
+#define I2C_BSP_TX_BUF_LEN      32      // Register writes up to this size need no heap
+#define I2C_BSP_TIMEOUT_MS      1000
+#define I2C_BSP_TASK_PRIO       10
+#define I2C_BSP_TASK_STACK      (3 * 1024)
+
+// Task notification slot on which a caller waits for its transaction. Kept off
+// slot 0 so that a task woken through xTaskNotifyGive() for its own reasons
+// is neither woken early by a finished transaction nor loses that wake-up.
+// Needs CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES of 3 (slot 1 is the
+// energy profiler's).
+#define I2C_BSP_NOTIFY_INDEX    2
+
+// Transaction priority, derived from the device address
+typedef enum {
+    I2C_BSP_PRIO_CODEC = 0,     // ES8311, audio must not underrun
+    I2C_BSP_PRIO_RTC,           // PCF85063
+    I2C_BSP_PRIO_SENSOR,        // QMI8658, SHTC3, AXP2101 and anything else
+    I2C_BSP_PRIO_NUM,
+} i2c_bsp_prio_t;
+
+// Per-device bus statistics
+typedef struct {
+    uint8_t  addr;
+    uint32_t scl_speed_hz;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t bytes;             // Payload bytes, register address included
+    uint64_t busy_us;           // Total time spent on the bus
+    uint32_t max_us;            // Longest single transaction
+    uint32_t max_wait_us;       // Longest time spent queued behind other work
+} i2c_dev_stats_t;
 
 
 // Initialize the I2C Master bus
@@ -37,6 +71,7 @@ void i2c_master_init(void);
 esp_err_t i2c_devices_init(void);
 
 // Add a device to the bus (return device handle)
+// The handle is owned by the cache, the caller must not remove it
 esp_err_t i2c_bus_add_device(uint8_t dev_addr, uint32_t scl_speed_hz, i2c_master_dev_handle_t *dev_handle);
 
 // Write to the register (with register address
@@ -51,6 +86,15 @@ esp_err_t i2c_write_bytes(uint8_t dev_addr, uint8_t *data, size_t len);
 // Read-only data (without register address)
 esp_err_t i2c_read_bytes(uint8_t dev_addr, uint8_t *data, size_t len);
 
+// Write then read with a repeated start, as one transaction
+esp_err_t i2c_write_read(uint8_t dev_addr, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
+
+// Copy the statistics of every cached device, returns the number of entries
+int i2c_bsp_get_stats(i2c_dev_stats_t *stats, int max);
+
+// Print the statistics of every cached device
+void i2c_bsp_log_stats(void);
+
 // Macro definitions compatible with old code
 #define i2c_master_write_read_dev(addr, wbuf, wlen, rbuf, rlen) \
     i2c_master_write_read_device_compat(addr, wbuf, wlen, rbuf, rlen)
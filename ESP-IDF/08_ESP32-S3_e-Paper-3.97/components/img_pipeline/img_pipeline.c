@@ -0,0 +1,314 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#include "img_pipeline.h"
+
+static const char *TAG = "img_pipe";
+
+// sRGB-encoded 0..255 -> linear light 0..IMG_LUM_MAX, from the sRGB transfer curve
+static const uint16_t srgb_to_lin[256] = {
+       0,    1,    2,    4,    5,    6,    7,    9,   10,   11,   12,   14,   15,   16,   18,   20,
+      21,   23,   25,   27,   29,   31,   33,   35,   37,   40,   42,   45,   48,   50,   53,   56,
+      59,   62,   66,   69,   72,   76,   79,   83,   87,   91,   95,   99,  103,  107,  112,  116,
+     121,  126,  131,  136,  141,  146,  151,  156,  162,  168,  173,  179,  185,  191,  197,  204,
+     210,  216,  223,  230,  237,  244,  251,  258,  265,  273,  280,  288,  296,  304,  312,  320,
+     329,  337,  346,  354,  363,  372,  381,  390,  400,  409,  419,  428,  438,  448,  458,  469,
+     479,  490,  500,  511,  522,  533,  544,  555,  567,  578,  590,  602,  614,  626,  639,  651,
+     664,  676,  689,  702,  715,  728,  742,  755,  769,  783,  797,  811,  825,  840,  854,  869,
+     884,  899,  914,  929,  945,  960,  976,  992, 1008, 1024, 1041, 1057, 1074, 1091, 1108, 1125,
+    1142, 1159, 1177, 1195, 1213, 1231, 1249, 1267, 1286, 1304, 1323, 1342, 1361, 1381, 1400, 1420,
+    1440, 1459, 1480, 1500, 1520, 1541, 1562, 1582, 1603, 1625, 1646, 1668, 1689, 1711, 1733, 1755,
+    1778, 1800, 1823, 1846, 1869, 1892, 1916, 1939, 1963, 1987, 2011, 2035, 2059, 2084, 2109, 2133,
+    2159, 2184, 2209, 2235, 2260, 2286, 2312, 2339, 2365, 2392, 2419, 2446, 2473, 2500, 2527, 2555,
+    2583, 2611, 2639, 2668, 2696, 2725, 2754, 2783, 2812, 2841, 2871, 2901, 2931, 2961, 2991, 3022,
+    3052, 3083, 3114, 3146, 3177, 3209, 3240, 3272, 3304, 3337, 3369, 3402, 3435, 3468, 3501, 3535,
+    3568, 3602, 3636, 3670, 3705, 3739, 3774, 3809, 3844, 3879, 3915, 3950, 3986, 4022, 4059, 4095,
+};
+
+// 8x8 Bayer matrix, 0..63
+static const uint8_t bayer8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+#define ERR_PAD     2       // Error rows are indexed x + ERR_PAD so x - 1 .. x + 2 stay in range
+
+struct img_pipe {
+    img_pipe_cfg_t cfg;
+    int levels;             // 2 or 4
+    int thr;                // 1-bit cut-off on the working scale
+    int value[4];           // Working luminance of each output level
+    int pushed, emitted;
+    uint16_t *ring[3];      // Sharpening window, indexed by push count % 3
+    uint16_t *lum;          // Conversion buffer for img_pipe_push, sharpened row
+    int16_t *err[3];        // Diffusion error for this row and the next two
+    uint8_t *level;         // Quantized row, 0 = black
+    uint8_t *out;           // Packed row handed to emit
+};
+
+static inline uint16_t expand8(uint8_t v)
+{
+    return (uint16_t)((v << 4) | (v >> 4));
+}
+
+uint16_t img_lum_rgb(uint8_t r, uint8_t g, uint8_t b, bool gamma)
+{
+    if (gamma)  // Rec.709 weights on linear light
+        return (uint16_t)((srgb_to_lin[r] * 871 + srgb_to_lin[g] * 2929 + srgb_to_lin[b] * 296 + 2048) >> 12);
+    // Rec.601 luma on the encoded values
+    return expand8((uint8_t)((r * 1225 + g * 2404 + b * 467 + 2048) >> 12));
+}
+
+void img_lum_row(img_src_fmt_t fmt, const uint8_t *src, int width, const uint16_t *palette,
+                 bool gamma, uint16_t *lum)
+{
+    switch (fmt) {
+    case IMG_SRC_INDEX1:
+        for (int x = 0; x < width; x++)
+            lum[x] = palette[(src[x >> 3] >> (7 - (x & 7))) & 1];
+        break;
+    case IMG_SRC_INDEX4:
+        for (int x = 0; x < width; x++)
+            lum[x] = palette[(src[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];
+        break;
+    case IMG_SRC_INDEX8:
+        for (int x = 0; x < width; x++)
+            lum[x] = palette[src[x]];
+        break;
+    case IMG_SRC_GRAY8:
+        for (int x = 0; x < width; x++)
+            lum[x] = gamma ? srgb_to_lin[src[x]] : expand8(src[x]);
+        break;
+    case IMG_SRC_RGB24:
+        for (int x = 0; x < width; x++, src += 3)
+            lum[x] = img_lum_rgb(src[0], src[1], src[2], gamma);
+        break;
+    case IMG_SRC_BGR24:
+        for (int x = 0; x < width; x++, src += 3)
+            lum[x] = img_lum_rgb(src[2], src[1], src[0], gamma);
+        break;
+    case IMG_SRC_BGRX32:
+        for (int x = 0; x < width; x++, src += 4)
+            lum[x] = img_lum_rgb(src[2], src[1], src[0], gamma);
+        break;
+    }
+}
+
+int img_out_row_bytes(img_out_fmt_t out, int width)
+{
+    return (out == IMG_OUT_GRAY2) ? (width + 3) / 4 : (width + 7) / 8;
+}
+
+esp_err_t img_pipe_create(const img_pipe_cfg_t *cfg, img_pipe_t **pipe)
+{
+    if (cfg == NULL || pipe == NULL || cfg->emit == NULL || cfg->width <= 0 || cfg->width > IMG_MAX_WIDTH)
+        return ESP_ERR_INVALID_ARG;
+
+    int w = cfg->width;
+    int err_len = w + 2 * ERR_PAD;
+    size_t size = sizeof(struct img_pipe)
+                + (cfg->sharpen ? 4 : 1) * (size_t)w * sizeof(uint16_t)
+                + 3 * (size_t)err_len * sizeof(int16_t)
+                + (size_t)w + img_out_row_bytes(cfg->out, w);
+    // A wide pipeline is tens of KB, keep it out of internal RAM when PSRAM is there
+    struct img_pipe *p = (size > 16 * 1024) ? heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM) : NULL;
+    if (p == NULL)
+        p = calloc(1, size);
+    if (p == NULL) {
+        ESP_LOGE(TAG, "No memory for a %d wide pipeline", w);
+        return ESP_ERR_NO_MEM;
+    }
+
+    p->cfg = *cfg;
+    p->levels = (cfg->out == IMG_OUT_GRAY2) ? 4 : 2;
+    // The cut-off is given on the encoded scale, a gray of that value sits on it
+    uint8_t t = cfg->threshold ? cfg->threshold : 128;
+    p->thr = img_lum_rgb(t, t, t, cfg->gamma);
+    for (int q = 0; q < p->levels; q++)
+        p->value[q] = q * IMG_LUM_MAX / (p->levels - 1);
+
+    // 16-bit arrays first, then the byte rows
+    uint16_t *u = (uint16_t *)(p + 1);
+    p->lum = u;
+    u += w;
+    if (cfg->sharpen) {
+        for (int i = 0; i < 3; i++, u += w)
+            p->ring[i] = u;
+    }
+    int16_t *e = (int16_t *)u;
+    for (int i = 0; i < 3; i++, e += err_len)
+        p->err[i] = e + ERR_PAD;
+    p->level = (uint8_t *)e;
+    p->out = p->level + w;
+
+    *pipe = p;
+    return ESP_OK;
+}
+
+void img_pipe_destroy(img_pipe_t *pipe)
+{
+    free(pipe);
+}
+
+/*
+ * Unsharp mask with a 4-neighbour blur: v = c + k * (c - blur), k = sharpen / 4.
+ * Edges repeat the border pixel.
+ */
+static void sharpen_row(const img_pipe_t *p, const uint16_t *up, const uint16_t *c,
+                        const uint16_t *down, uint16_t *dst)
+{
+    int w = p->cfg.width, k = p->cfg.sharpen;
+    for (int x = 0; x < w; x++) {
+        int l = c[x > 0 ? x - 1 : 0];
+        int r = c[x < w - 1 ? x + 1 : w - 1];
+        int lap = 4 * c[x] - up[x] - down[x] - l - r;
+        int v = c[x] + lap * k / 16;
+        dst[x] = (uint16_t)(v < 0 ? 0 : (v > IMG_LUM_MAX ? IMG_LUM_MAX : v));
+    }
+}
+
+// Nearest level for the diffusion quantizers, with the 1-bit cut-off
+static inline int quant(const img_pipe_t *p, int v)
+{
+    if (p->levels == 2)
+        return v >= p->thr;
+    // Midpoints between 0, 1365, 2730 and 4095, no division in the inner loop
+    return (v >= 683) + (v >= 2048) + (v >= 3413);
+}
+
+static void dither_row(img_pipe_t *p, const uint16_t *lum)
+{
+    int w = p->cfg.width, y = p->emitted;
+    int top = p->levels - 1;
+    uint8_t *lv = p->level;
+
+    switch (p->cfg.dither) {
+    case IMG_DITHER_BAYER8: {
+        const uint8_t *b = bayer8[y & 7];
+        for (int x = 0; x < w; x++)
+            lv[x] = (uint8_t)((lum[x] * top + b[x & 7] * 64 + 32) >> 12);
+        break;
+    }
+    case IMG_DITHER_FLOYD: {
+        int16_t *e0 = p->err[0], *e1 = p->err[1];
+        // Serpentine: odd rows run right to left with the kernel mirrored
+        int dir = (y & 1) ? -1 : 1;
+        int x = (dir > 0) ? 0 : w - 1;
+        for (int i = 0; i < w; i++, x += dir) {
+            int v = lum[x] + e0[x];
+            int q = quant(p, v);
+            lv[x] = (uint8_t)q;
+            int e = v - p->value[q];
+            int e7 = e * 7 / 16, e3 = e * 3 / 16, e5 = e * 5 / 16;
+            e0[x + dir] += e7;
+            e1[x - dir] += e3;
+            e1[x]       += e5;
+            e1[x + dir] += e - e7 - e3 - e5;
+        }
+        break;
+    }
+    case IMG_DITHER_ATKINSON: {
+        int16_t *e0 = p->err[0], *e1 = p->err[1], *e2 = p->err[2];
+        for (int x = 0; x < w; x++) {
+            int v = lum[x] + e0[x];
+            int q = quant(p, v);
+            lv[x] = (uint8_t)q;
+            int e = (v - p->value[q]) / 8;
+            e0[x + 1] += e;
+            e0[x + 2] += e;
+            e1[x - 1] += e;
+            e1[x]     += e;
+            e1[x + 1] += e;
+            e2[x]     += e;
+        }
+        break;
+    }
+    default:
+        for (int x = 0; x < w; x++)
+            lv[x] = (uint8_t)quant(p, lum[x]);
+        break;
+    }
+
+    if (p->cfg.dither == IMG_DITHER_FLOYD || p->cfg.dither == IMG_DITHER_ATKINSON) {
+        // Rotate the error rows, the padding goes along so it is cleared too
+        int16_t *done = p->err[0];
+        p->err[0] = p->err[1];
+        p->err[1] = p->err[2];
+        p->err[2] = done;
+        memset(done - ERR_PAD, 0, (w + 2 * ERR_PAD) * sizeof(int16_t));
+    }
+}
+
+static void emit_row(img_pipe_t *p, const uint16_t *lum)
+{
+    int w = p->cfg.width;
+    int bytes = img_out_row_bytes(p->cfg.out, w);
+    const uint8_t *lv = p->level;
+    uint8_t *out = p->out;
+
+    dither_row(p, lum);
+
+    memset(out, 0, bytes);
+    if (p->cfg.out == IMG_OUT_GRAY2) {
+        for (int x = 0; x < w; x++)
+            out[x >> 2] |= lv[x] << (6 - 2 * (x & 3));
+    } else {
+        for (int x = 0; x < w; x++)
+            if (lv[x] == 0)
+                out[x >> 3] |= 0x80 >> (x & 7);
+    }
+    p->cfg.emit(p->cfg.ctx, p->emitted++, out);
+}
+
+void img_pipe_push_lum(img_pipe_t *pipe, const uint16_t *lum)
+{
+    img_pipe_t *p = pipe;
+    int w = p->cfg.width;
+
+    if (!p->cfg.sharpen) {
+        p->pushed++;
+        emit_row(p, lum);
+        return;
+    }
+
+    // Row n arrives, row n - 1 now has both neighbours
+    int n = p->pushed++;
+    if (p->ring[n % 3] != lum)
+        memcpy(p->ring[n % 3], lum, w * sizeof(uint16_t));
+    if (n == 0)
+        return;
+    const uint16_t *c = p->ring[(n - 1) % 3];
+    const uint16_t *up = (n >= 2) ? p->ring[(n - 2) % 3] : c;
+    sharpen_row(p, up, c, p->ring[n % 3], p->lum);
+    emit_row(p, p->lum);
+}
+
+void img_pipe_push(img_pipe_t *pipe, img_src_fmt_t fmt, const uint8_t *src, const uint16_t *palette)
+{
+    img_pipe_t *p = pipe;
+    uint16_t *dst = p->cfg.sharpen ? p->ring[p->pushed % 3] : p->lum;
+    img_lum_row(fmt, src, p->cfg.width, palette, p->cfg.gamma, dst);
+    img_pipe_push_lum(p, dst);
+}
+
+void img_pipe_finish(img_pipe_t *pipe)
+{
+    img_pipe_t *p = pipe;
+    int n = p->pushed;
+
+    if (!p->cfg.sharpen || n == 0 || p->emitted == n)
+        return;
+    const uint16_t *c = p->ring[(n - 1) % 3];
+    const uint16_t *up = (n >= 2) ? p->ring[(n - 2) % 3] : c;
+    sharpen_row(p, up, c, c, p->lum);
+    emit_row(p, p->lum);
+}
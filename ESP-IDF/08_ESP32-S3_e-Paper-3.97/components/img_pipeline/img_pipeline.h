@@ -0,0 +1,87 @@
+#ifndef IMG_PIPELINE_H
+#define IMG_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Row-streaming conversion of 8/24/32-bit images to the panel formats.
+ * Rows go in one at a time and come out through a callback; everything is
+ * integer, the state is a few rows of 16-bit values whatever the height.
+ *
+ *   source row -> 12-bit luminance -> [sharpen] -> dither -> packed row
+ */
+
+#define IMG_LUM_MAX         4095    // Working luminance range 0..IMG_LUM_MAX
+#define IMG_MAX_WIDTH       2048
+
+typedef enum {
+    IMG_SRC_INDEX1 = 0,     // Palette index, 8 pixels per byte, MSB first
+    IMG_SRC_INDEX4,         // Palette index, 2 pixels per byte, high nibble first
+    IMG_SRC_INDEX8,         // Palette index per byte
+    IMG_SRC_GRAY8,          // sRGB-encoded gray per byte
+    IMG_SRC_RGB24,
+    IMG_SRC_BGR24,          // BMP order
+    IMG_SRC_BGRX32,         // BMP order, 4th byte ignored
+} img_src_fmt_t;
+
+typedef enum {
+    IMG_OUT_INK1 = 0,       // 1 bit, 1 = black, MSB first (IMAGE_RAW rows)
+    IMG_OUT_GRAY2,          // 2 bits, 3 = white, 4 pixels per byte MSB first (Paint Scale 4)
+} img_out_fmt_t;
+
+typedef enum {
+    IMG_DITHER_NONE = 0,    // Threshold / nearest level
+    IMG_DITHER_BAYER8,      // 8x8 ordered
+    IMG_DITHER_FLOYD,       // Floyd-Steinberg, serpentine
+    IMG_DITHER_ATKINSON,    // Atkinson, 3/4 of the error spread, keeps contrast
+} img_dither_t;
+
+// Called for every finished row, y counts from 0 in push order
+typedef void (*img_row_cb_t)(void *ctx, int y, const uint8_t *row);
+
+typedef struct {
+    int width;
+    img_out_fmt_t out;
+    img_dither_t dither;
+    bool gamma;             // Work in linear light (sRGB decoded), else on encoded values
+    uint8_t sharpen;        // Unsharp amount in 1/4 steps, 0 = off, 4 = 1.0
+    uint8_t threshold;      // IMG_OUT_INK1 cut-off on the 0..255 scale for NONE/FLOYD/ATKINSON, 0 = 128
+    img_row_cb_t emit;
+    void *ctx;
+} img_pipe_cfg_t;
+
+typedef struct img_pipe img_pipe_t;
+
+// Luminance of one color on the working scale, for building palettes
+uint16_t img_lum_rgb(uint8_t r, uint8_t g, uint8_t b, bool gamma);
+
+// One source row to working luminance, palette (IMG_LUM_MAX scale) only for INDEX formats
+void img_lum_row(img_src_fmt_t fmt, const uint8_t *src, int width, const uint16_t *palette,
+                 bool gamma, uint16_t *lum);
+
+// Bytes of one packed output row
+int img_out_row_bytes(img_out_fmt_t out, int width);
+
+esp_err_t img_pipe_create(const img_pipe_cfg_t *cfg, img_pipe_t **pipe);
+void img_pipe_destroy(img_pipe_t *pipe);
+
+// Push one source row. With sharpening the row comes out one push later.
+void img_pipe_push(img_pipe_t *pipe, img_src_fmt_t fmt, const uint8_t *src, const uint16_t *palette);
+
+// Push a row already converted with img_lum_row
+void img_pipe_push_lum(img_pipe_t *pipe, const uint16_t *lum);
+
+// Emit the rows still held back, call once after the last push
+void img_pipe_finish(img_pipe_t *pipe);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,594 @@
+#include "kv_log.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "kv_log";
+
+#define KV_FILE_MAGIC       0x474C564B      // "KVLG"
+#define KV_REC_MAGIC        0x524B          // "KR"
+#define KV_VERSION          1
+#define KV_PATH_MAX         128
+#define KV_IO_BUF           4096            // stdio buffer of the log, newlib's is 128 bytes
+#define KV_MIN_SLOTS        32
+
+#define KV_SLOT_FREE        0               // Slot offsets, records start at KV_LOG_HEADER_SIZE
+#define KV_SLOT_DELETED     1
+
+enum {
+    KV_PUT = 1,
+    KV_DEL = 2,
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t generation;
+    uint32_t size;
+    uint8_t pad[12];
+    uint32_t crc;               // Of the bytes before it
+} kv_file_hdr_t;
+
+typedef struct {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t len;               // Of the value, padded to 4 bytes in the file
+    uint16_t reserved2;
+    uint32_t generation;        // Of the file, so nothing of an older one is replayed
+    uint32_t seq;               // 1 for the first record of the file, then one more each
+    uint64_t book;
+    uint32_t tag;
+    uint32_t crc;               // Of the bytes before it and the value
+} kv_rec_hdr_t;
+
+_Static_assert(sizeof(kv_file_hdr_t) == KV_LOG_HEADER_SIZE, "file header size");
+_Static_assert(sizeof(kv_rec_hdr_t) == KV_LOG_HEADER_SIZE, "record header size");
+
+typedef struct {
+    uint64_t book;
+    uint32_t tag;
+    uint32_t off;               // Of the record, or KV_SLOT_FREE / KV_SLOT_DELETED
+    uint32_t len;
+} kv_slot_t;
+
+struct kv_log {
+    FILE *fp;
+    char path[KV_PATH_MAX];
+    char tmp[KV_PATH_MAX + 4];
+    uint32_t want;              // Size asked for, taken at the next compaction
+    uint32_t size;
+    uint32_t generation;
+    uint32_t tail;              // Where the next record goes
+    uint32_t seq;               // Of the last record
+    uint32_t live;
+    kv_slot_t *slots;           // Open addressing, a power of two
+    uint32_t nslots;
+    uint32_t nkeys;
+    uint32_t ndeleted;
+    uint32_t records;
+    uint32_t compactions;
+    bool torn;
+    uint8_t *iobuf;
+    uint8_t rec[KV_LOG_HEADER_SIZE + KV_LOG_VALUE_MAX];
+    uint8_t val[KV_LOG_VALUE_MAX];
+};
+
+static const uint8_t zeros[512];
+
+static inline uint32_t rec_size(uint32_t len)
+{
+    return KV_LOG_HEADER_SIZE + ((len + 3) & ~3u);
+}
+
+static uint32_t crc32(const void *data, size_t len)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)data, len);
+}
+
+uint64_t kv_log_book_id(const char *filepath, size_t file_size)
+{
+    const char *name = strrchr(filepath, '/');
+    name = name ? name + 1 : filepath;
+
+    // FNV-1a of the name, then of the size
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char *p = name; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
+    }
+    for (int i = 0; i < 8; i++) {
+        h = (h ^ (uint8_t)((uint64_t)file_size >> (i * 8))) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/*---------- Index ----------*/
+
+static uint32_t slot_hash(uint64_t book, uint32_t tag)
+{
+    uint64_t h = book ^ ((uint64_t)tag * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static kv_slot_t *slot_find(const kv_log_t *kv, uint64_t book, uint32_t tag)
+{
+    if (!kv->slots) return NULL;
+    uint32_t mask = kv->nslots - 1;
+    for (uint32_t i = slot_hash(book, tag) & mask;; i = (i + 1) & mask) {
+        kv_slot_t *s = &kv->slots[i];
+        if (s->off == KV_SLOT_FREE) return NULL;
+        if (s->off != KV_SLOT_DELETED && s->book == book && s->tag == tag) return s;
+    }
+}
+
+// Room for one more key, at most 3/4 of the slots taken
+static esp_err_t slot_reserve(kv_log_t *kv)
+{
+    if ((kv->nkeys + kv->ndeleted + 1) * 4 <= kv->nslots * 3) return ESP_OK;
+
+    uint32_t n = KV_MIN_SLOTS;
+    while ((kv->nkeys + 1) * 2 > n) n *= 2;
+    kv_slot_t *slots = heap_caps_calloc(n, sizeof(kv_slot_t), MALLOC_CAP_SPIRAM);
+    if (!slots) return ESP_ERR_NO_MEM;
+
+    for (uint32_t i = 0; i < kv->nslots; i++) {
+        const kv_slot_t *s = &kv->slots[i];
+        if (s->off < KV_LOG_HEADER_SIZE) continue;
+        uint32_t j = slot_hash(s->book, s->tag) & (n - 1);
+        while (slots[j].off != KV_SLOT_FREE) j = (j + 1) & (n - 1);
+        slots[j] = *s;
+    }
+    heap_caps_free(kv->slots);
+    kv->slots = slots;
+    kv->nslots = n;
+    kv->ndeleted = 0;
+    return ESP_OK;
+}
+
+static void index_put(kv_log_t *kv, uint64_t book, uint32_t tag, uint32_t off, uint32_t len)
+{
+    kv_slot_t *s = slot_find(kv, book, tag);
+    if (s) {
+        kv->live -= rec_size(s->len);
+    } else {
+        uint32_t mask = kv->nslots - 1;
+        uint32_t i = slot_hash(book, tag) & mask;
+        while (kv->slots[i].off >= KV_LOG_HEADER_SIZE) i = (i + 1) & mask;
+        s = &kv->slots[i];
+        if (s->off == KV_SLOT_DELETED) kv->ndeleted--;
+        s->book = book;
+        s->tag = tag;
+        kv->nkeys++;
+    }
+    s->off = off;
+    s->len = len;
+    kv->live += rec_size(len);
+}
+
+static void index_del(kv_log_t *kv, uint64_t book, uint32_t tag)
+{
+    kv_slot_t *s = slot_find(kv, book, tag);
+    if (!s) return;
+    kv->live -= rec_size(s->len);
+    s->off = KV_SLOT_DELETED;
+    kv->nkeys--;
+    kv->ndeleted++;
+}
+
+static void index_clear(kv_log_t *kv)
+{
+    if (kv->slots) memset(kv->slots, 0, kv->nslots * sizeof(kv_slot_t));
+    kv->nkeys = 0;
+    kv->ndeleted = 0;
+    kv->live = 0;
+}
+
+/*---------- File ----------*/
+
+static esp_err_t sync_file(FILE *fp)
+{
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0) return ESP_FAIL;
+    return ESP_OK;
+}
+
+static esp_err_t write_record(kv_log_t *kv, FILE *fp, uint32_t off, uint32_t seq, uint8_t type, uint64_t book,
+                              uint32_t tag, const void *data, uint32_t len)
+{
+    kv_rec_hdr_t h = {
+        .magic = KV_REC_MAGIC,
+        .type = type,
+        .len = (uint16_t)len,
+        .generation = kv->generation,
+        .seq = seq,
+        .book = book,
+        .tag = tag,
+    };
+    uint32_t size = rec_size(len);
+    memcpy(kv->rec, &h, sizeof(h));
+    if (len) memcpy(kv->rec + sizeof(h), data, len);
+    memset(kv->rec + sizeof(h) + len, 0, size - sizeof(h) - len);
+    h.crc = esp_rom_crc32_le(crc32(kv->rec, offsetof(kv_rec_hdr_t, crc)), kv->rec + sizeof(h), len);
+    memcpy(kv->rec + offsetof(kv_rec_hdr_t, crc), &h.crc, sizeof(h.crc));
+
+    if (fseek(fp, off, SEEK_SET) != 0 || fwrite(kv->rec, 1, size, fp) != size) return ESP_FAIL;
+    return ESP_OK;
+}
+
+static esp_err_t write_file_header(FILE *fp, uint32_t generation, uint32_t size)
+{
+    kv_file_hdr_t h = {
+        .magic = KV_FILE_MAGIC,
+        .version = KV_VERSION,
+        .generation = generation,
+        .size = size,
+    };
+    h.crc = crc32(&h, offsetof(kv_file_hdr_t, crc));
+    if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, fp) != 1) return ESP_FAIL;
+    return ESP_OK;
+}
+
+// Zeros from the file position to end, so the file never grows afterwards
+static esp_err_t fill_zeros(FILE *fp, uint32_t from, uint32_t end)
+{
+    if (fseek(fp, from, SEEK_SET) != 0) return ESP_FAIL;
+    while (from < end) {
+        uint32_t n = end - from < sizeof(zeros) ? end - from : sizeof(zeros);
+        if (fwrite(zeros, 1, n, fp) != n) return ESP_FAIL;
+        from += n;
+    }
+    return ESP_OK;
+}
+
+static FILE *open_stream(const char *path, const char *mode, uint8_t *buf)
+{
+    FILE *fp = fopen(path, mode);
+    if (fp && buf) setvbuf(fp, (char *)buf, _IOFBF, KV_IO_BUF);
+    return fp;
+}
+
+static esp_err_t create(kv_log_t *kv)
+{
+    kv->fp = open_stream(kv->path, "w+b", kv->iobuf);
+    if (!kv->fp) {
+        ESP_LOGE(TAG, "%s: cannot create", kv->path);
+        return ESP_FAIL;
+    }
+    kv->size = kv->want;
+    kv->generation = 1;
+    // The header last: cut short before it, the file is taken for a new one again
+    if (fill_zeros(kv->fp, 0, kv->size) != ESP_OK || write_file_header(kv->fp, kv->generation, kv->size) != ESP_OK ||
+        sync_file(kv->fp) != ESP_OK) {
+        ESP_LOGE(TAG, "%s: cannot write %lu bytes", kv->path, (unsigned long)kv->size);
+        fclose(kv->fp);
+        kv->fp = NULL;
+        remove(kv->path);
+        return ESP_FAIL;
+    }
+    kv->tail = KV_LOG_HEADER_SIZE;
+    kv->seq = 0;
+    ESP_LOGI(TAG, "%s: created, %lu KB", kv->path, (unsigned long)(kv->size / 1024));
+    return ESP_OK;
+}
+
+// Index the records up to the first one that does not check
+static esp_err_t replay(kv_log_t *kv)
+{
+    uint32_t off = KV_LOG_HEADER_SIZE;
+    uint32_t seq = 0;
+    kv->torn = false;
+    if (fseek(kv->fp, off, SEEK_SET) != 0) return ESP_FAIL;
+
+    while (off + KV_LOG_HEADER_SIZE <= kv->size) {
+        kv_rec_hdr_t h;
+        if (fread(&h, sizeof(h), 1, kv->fp) != 1) break;
+        if (h.magic != KV_REC_MAGIC || h.generation != kv->generation || h.seq != seq + 1 ||
+            h.len > KV_LOG_VALUE_MAX || (h.type != KV_PUT && h.type != KV_DEL) || off + rec_size(h.len) > kv->size) {
+            kv->torn = memcmp(&h, zeros, sizeof(h)) != 0;
+            break;
+        }
+        uint32_t pad = rec_size(h.len) - KV_LOG_HEADER_SIZE;
+        if (pad && fread(kv->val, 1, pad, kv->fp) != pad) break;
+        uint32_t crc = esp_rom_crc32_le(crc32(&h, offsetof(kv_rec_hdr_t, crc)), kv->val, h.len);
+        if (crc != h.crc) {
+            kv->torn = true;
+            break;
+        }
+        if (slot_reserve(kv) != ESP_OK) return ESP_ERR_NO_MEM;
+        if (h.type == KV_PUT) {
+            index_put(kv, h.book, h.tag, off, h.len);
+        } else {
+            index_del(kv, h.book, h.tag);
+        }
+        off += rec_size(h.len);
+        seq = h.seq;
+        kv->records++;
+    }
+    kv->tail = off;
+    kv->seq = seq;
+    if (kv->torn) {
+        ESP_LOGW(TAG, "%s: record at %lu did not check, the log ends before it", kv->path, (unsigned long)off);
+    }
+    return ESP_OK;
+}
+
+// Pick up after a power cut during compaction, then open or create the log and index it
+static esp_err_t load(kv_log_t *kv)
+{
+    struct stat st;
+    bool have_log = stat(kv->path, &st) == 0;
+    bool have_tmp = stat(kv->tmp, &st) == 0;
+    if (!have_log && have_tmp) {
+        // The log is only removed once its copy has been synced
+        ESP_LOGW(TAG, "%s: compaction was interrupted, taking the new file", kv->path);
+        if (rename(kv->tmp, kv->path) != 0) {
+            ESP_LOGE(TAG, "%s: cannot rename %s", kv->path, kv->tmp);
+            return ESP_FAIL;
+        }
+        have_log = true;
+    } else if (have_tmp) {
+        ESP_LOGW(TAG, "%s: compaction was interrupted, keeping the log", kv->path);
+        remove(kv->tmp);
+    }
+
+    index_clear(kv);
+    if (have_log) {
+        kv->fp = open_stream(kv->path, "r+b", kv->iobuf);
+        kv_file_hdr_t h;
+        if (!kv->fp) {
+            ESP_LOGE(TAG, "%s: cannot open", kv->path);
+            return ESP_FAIL;
+        }
+        if (fread(&h, sizeof(h), 1, kv->fp) != 1 || h.magic != KV_FILE_MAGIC || h.version != KV_VERSION ||
+            h.crc != crc32(&h, offsetof(kv_file_hdr_t, crc)) || h.size < 2 * KV_LOG_HEADER_SIZE) {
+            // Cut while creating it, nothing was stored yet
+            ESP_LOGW(TAG, "%s: no valid header, starting a new log", kv->path);
+            fclose(kv->fp);
+            kv->fp = NULL;
+            have_log = false;
+        } else {
+            kv->generation = h.generation;
+            kv->size = h.size;
+        }
+    }
+    if (!have_log) return create(kv);
+
+    esp_err_t err = replay(kv);
+    if (err != ESP_OK) {
+        fclose(kv->fp);
+        kv->fp = NULL;
+    }
+    return err;
+}
+
+/*---------- API ----------*/
+
+esp_err_t kv_log_open(const char *path, size_t size, kv_log_t **out)
+{
+    *out = NULL;
+    if (strlen(path) >= KV_PATH_MAX) return ESP_ERR_INVALID_ARG;
+    kv_log_t *kv = heap_caps_calloc(1, sizeof(kv_log_t), MALLOC_CAP_SPIRAM);
+    uint8_t *iobuf = heap_caps_malloc(KV_IO_BUF, MALLOC_CAP_SPIRAM);
+    if (!kv || !iobuf) {
+        heap_caps_free(kv);
+        heap_caps_free(iobuf);
+        return ESP_ERR_NO_MEM;
+    }
+    strcpy(kv->path, path);
+    snprintf(kv->tmp, sizeof(kv->tmp), "%s.tmp", path);
+    kv->iobuf = iobuf;
+    size = (size + 4095) & ~(size_t)4095;
+    kv->want = size < 8192 ? 8192 : (uint32_t)size;
+
+    esp_err_t err = load(kv);
+    if (err != ESP_OK) {
+        kv_log_close(kv);
+        return err;
+    }
+
+    uint32_t dead = kv->tail - KV_LOG_HEADER_SIZE - kv->live;
+    ESP_LOGI(TAG, "%s: %lu keys, %lu of %lu KB used, %lu KB superseded, generation %lu", kv->path,
+             (unsigned long)kv->nkeys, (unsigned long)(kv->tail / 1024), (unsigned long)(kv->size / 1024),
+             (unsigned long)(dead / 1024), (unsigned long)kv->generation);
+    if (dead > kv->size / 2 || (kv->want != kv->size && kv->want >= kv->live + KV_LOG_HEADER_SIZE)) {
+        kv_log_compact(kv);
+    }
+    *out = kv;
+    return ESP_OK;
+}
+
+void kv_log_close(kv_log_t *kv)
+{
+    if (!kv) return;
+    if (kv->fp) fclose(kv->fp);
+    heap_caps_free(kv->slots);
+    heap_caps_free(kv->iobuf);
+    heap_caps_free(kv);
+}
+
+static esp_err_t append(kv_log_t *kv, uint8_t type, uint64_t book, uint32_t tag, const void *data, uint32_t len)
+{
+    if (!kv->fp) return ESP_ERR_INVALID_STATE;
+    uint32_t need = rec_size(len);
+    if (kv->tail + need > kv->size) {
+        esp_err_t err = kv_log_compact(kv);
+        if (err != ESP_OK) return err;
+        if (kv->tail + need > kv->size) {
+            ESP_LOGE(TAG, "%s: full, %lu bytes live", kv->path, (unsigned long)kv->live);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (type == KV_PUT && slot_reserve(kv) != ESP_OK) return ESP_ERR_NO_MEM;
+
+    if (write_record(kv, kv->fp, kv->tail, kv->seq + 1, type, book, tag, data, len) != ESP_OK ||
+        sync_file(kv->fp) != ESP_OK) {
+        // Whatever reached the card fails its CRC and is written over by the next record
+        ESP_LOGE(TAG, "%s: write at %lu failed", kv->path, (unsigned long)kv->tail);
+        return ESP_FAIL;
+    }
+    if (type == KV_PUT) {
+        index_put(kv, book, tag, kv->tail, len);
+    } else {
+        index_del(kv, book, tag);
+    }
+    kv->tail += need;
+    kv->seq++;
+    kv->records++;
+    return ESP_OK;
+}
+
+esp_err_t kv_log_put(kv_log_t *kv, uint64_t book, uint32_t tag, const void *data, size_t len)
+{
+    if (len > KV_LOG_VALUE_MAX) return ESP_ERR_INVALID_SIZE;
+    return append(kv, KV_PUT, book, tag, data, (uint32_t)len);
+}
+
+esp_err_t kv_log_del(kv_log_t *kv, uint64_t book, uint32_t tag)
+{
+    if (!slot_find(kv, book, tag)) return ESP_OK;
+    return append(kv, KV_DEL, book, tag, NULL, 0);
+}
+
+esp_err_t kv_log_get(kv_log_t *kv, uint64_t book, uint32_t tag, void *buf, size_t max, size_t *len)
+{
+    const kv_slot_t *s = slot_find(kv, book, tag);
+    if (!s) return ESP_ERR_NOT_FOUND;
+    if (!kv->fp) return ESP_ERR_INVALID_STATE;
+    size_t n = s->len < max ? s->len : max;
+    if (fseek(kv->fp, s->off + KV_LOG_HEADER_SIZE, SEEK_SET) != 0 || fread(buf, 1, n, kv->fp) != n) {
+        ESP_LOGE(TAG, "%s: read at %lu failed", kv->path, (unsigned long)s->off);
+        return ESP_FAIL;
+    }
+    if (len) *len = s->len;
+    return ESP_OK;
+}
+
+int kv_log_tags(kv_log_t *kv, uint64_t book, uint32_t *tags, int max)
+{
+    int count = 0, n = 0;
+    for (uint32_t i = 0; i < kv->nslots; i++) {
+        const kv_slot_t *s = &kv->slots[i];
+        if (s->off < KV_LOG_HEADER_SIZE || s->book != book) continue;
+        count++;
+        // Keep the max smallest, in order
+        int j;
+        if (n < max) {
+            j = n++;
+        } else if (max > 0 && s->tag < tags[max - 1]) {
+            j = max - 1;
+        } else {
+            continue;
+        }
+        while (j > 0 && tags[j - 1] > s->tag) {
+            tags[j] = tags[j - 1];
+            j--;
+        }
+        tags[j] = s->tag;
+    }
+    return count;
+}
+
+typedef struct {
+    uint32_t off;
+    uint32_t slot;
+} kv_order_t;
+
+static int by_offset(const void *a, const void *b)
+{
+    uint32_t x = ((const kv_order_t *)a)->off, y = ((const kv_order_t *)b)->off;
+    return x < y ? -1 : x > y;
+}
+
+esp_err_t kv_log_compact(kv_log_t *kv)
+{
+    if (!kv->fp) return ESP_ERR_INVALID_STATE;
+    uint32_t size = kv->want >= kv->live + KV_LOG_HEADER_SIZE ? kv->want : kv->size;
+
+    // The live records in the order they were written
+    kv_order_t *order = heap_caps_malloc((kv->nkeys + 1) * sizeof(kv_order_t), MALLOC_CAP_SPIRAM);
+    uint8_t *iobuf = heap_caps_malloc(KV_IO_BUF, MALLOC_CAP_SPIRAM);
+    if (!order || !iobuf) {
+        heap_caps_free(order);
+        heap_caps_free(iobuf);
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < kv->nslots; i++) {
+        if (kv->slots[i].off >= KV_LOG_HEADER_SIZE) order[n++] = (kv_order_t){kv->slots[i].off, i};
+    }
+    qsort(order, n, sizeof(kv_order_t), by_offset);
+
+    uint32_t generation = kv->generation;
+    esp_err_t err = ESP_FAIL;
+    FILE *out = open_stream(kv->tmp, "w+b", iobuf);
+    if (out) {
+        kv->generation = generation + 1;        // Stamped on the copied records by write_record()
+        err = write_file_header(out, kv->generation, size);
+        uint32_t off = KV_LOG_HEADER_SIZE;
+        for (uint32_t i = 0; i < n && err == ESP_OK; i++) {
+            const kv_slot_t *s = &kv->slots[order[i].slot];
+            if (fseek(kv->fp, s->off + KV_LOG_HEADER_SIZE, SEEK_SET) != 0 ||
+                fread(kv->val, 1, s->len, kv->fp) != s->len) {
+                err = ESP_FAIL;
+                break;
+            }
+            err = write_record(kv, out, off, i + 1, KV_PUT, s->book, s->tag, kv->val, s->len);
+            off += rec_size(s->len);
+        }
+        if (err == ESP_OK) err = fill_zeros(out, off, size);
+        if (err == ESP_OK) err = sync_file(out);
+        if (fclose(out) != 0 && err == ESP_OK) err = ESP_FAIL;
+        kv->generation = generation;
+    }
+    heap_caps_free(order);
+    heap_caps_free(iobuf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%s: cannot write %s, not compacted", kv->path, kv->tmp);
+        remove(kv->tmp);
+        return err;
+    }
+
+    // The copy is complete from here: load() takes it should the next two steps be cut short
+    fclose(kv->fp);
+    kv->fp = NULL;
+    if (remove(kv->path) != 0) {
+        ESP_LOGE(TAG, "%s: cannot remove, keeping it", kv->path);
+    } else if (rename(kv->tmp, kv->path) != 0) {
+        ESP_LOGE(TAG, "%s: cannot rename %s", kv->path, kv->tmp);
+    }
+    uint32_t was = kv->tail;
+    err = load(kv);
+    if (err == ESP_OK && kv->generation == generation + 1) {
+        kv->compactions++;
+        ESP_LOGI(TAG, "%s: compacted %lu to %lu bytes, generation %lu", kv->path, (unsigned long)was,
+                 (unsigned long)kv->tail, (unsigned long)kv->generation);
+    }
+    return err;
+}
+
+bool kv_log_full(const kv_log_t *kv, size_t len)
+{
+    return kv->fp && kv->tail + rec_size((uint32_t)len) > kv->size;
+}
+
+void kv_log_get_stats(const kv_log_t *kv, kv_log_stats_t *stats)
+{
+    *stats = (kv_log_stats_t){
+        .generation = kv->generation,
+        .size = kv->size,
+        .used = kv->tail,
+        .live = kv->live,
+        .records = kv->records,
+        .keys = kv->nkeys,
+        .compactions = kv->compactions,
+        .torn = kv->torn,
+    };
+}
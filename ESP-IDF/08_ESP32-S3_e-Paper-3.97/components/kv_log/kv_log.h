@@ -0,0 +1,86 @@
+#ifndef KV_LOG_H
+#define KV_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Small values (reading progress, bookmarks) kept as an append-only log in
+ * one file on the card, preallocated so that appending never grows it: each
+ * update goes to the next free bytes instead of rewriting the same sectors,
+ * and the FAT and directory entry stay as they are. Every record carries the
+ * log's generation, a sequence number and a CRC32; on open the records are
+ * replayed into an index in PSRAM up to the first one that does not check,
+ * which is where a power cut stopped a write. Updates that returned ESP_OK
+ * have been synced and survive.
+ *
+ * When the log is full, or mostly superseded records at open, the live
+ * values are copied to <path>.tmp, synced, and the file replaces the log by
+ * rename. An open after a cut during that keeps whichever file is complete.
+ *
+ * Keys are a book (kv_log_book_id()) and a tag within it. Not thread-safe,
+ * a log has one owner.
+ */
+
+#ifndef CONFIG_KV_LOG_SIZE_KB
+#define CONFIG_KV_LOG_SIZE_KB   256
+#endif
+
+#define KV_LOG_VALUE_MAX    512
+#define KV_LOG_HEADER_SIZE  32          // Of the file, and of each record
+
+typedef struct kv_log kv_log_t;
+
+typedef struct {
+    uint32_t generation;        // Compactions since the log was created
+    uint32_t size;              // Of the file
+    uint32_t used;              // Up to the end of the last record
+    uint32_t live;              // Bytes of the records still current
+    uint32_t records;           // Read and written since open, compactions included
+    uint32_t keys;
+    uint32_t compactions;       // Since open
+    uint32_t torn;              // 1 if open stopped at a record that did not check
+} kv_log_stats_t;
+
+// Open the log at path, creating it with size bytes (rounded up to 4 KB) if
+// there is none. The directory must exist.
+esp_err_t kv_log_open(const char *path, size_t size, kv_log_t **out);
+
+// NULL is ignored
+void kv_log_close(kv_log_t *kv);
+
+// Identity of a book: its file name without the directory, and its size
+uint64_t kv_log_book_id(const char *filepath, size_t file_size);
+
+// ESP_ERR_INVALID_SIZE above KV_LOG_VALUE_MAX, ESP_ERR_NO_MEM if the live
+// values do not leave room even after compaction
+esp_err_t kv_log_put(kv_log_t *kv, uint64_t book, uint32_t tag, const void *data, size_t len);
+
+// ESP_OK if the key was not there either
+esp_err_t kv_log_del(kv_log_t *kv, uint64_t book, uint32_t tag);
+
+// Copies at most max bytes, *len gets the size of the value. ESP_ERR_NOT_FOUND if none.
+esp_err_t kv_log_get(kv_log_t *kv, uint64_t book, uint32_t tag, void *buf, size_t max, size_t *len);
+
+// The tags of book in ascending order. Returns how many there are, which may be more than max.
+int kv_log_tags(kv_log_t *kv, uint64_t book, uint32_t *tags, int max);
+
+esp_err_t kv_log_compact(kv_log_t *kv);
+
+// Whether a put of len bytes compacts the log first, which needs a second
+// file handle for <path>.tmp
+bool kv_log_full(const kv_log_t *kv, size_t len);
+
+void kv_log_get_stats(const kv_log_t *kv, kv_log_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
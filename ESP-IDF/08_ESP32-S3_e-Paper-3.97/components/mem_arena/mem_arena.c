@@ -0,0 +1,370 @@
+#include "mem_arena.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "mem_arena";
+
+#define MEM_HEAP_MAGIC      0x4D48
+
+typedef struct {
+    const char *name;
+    uint32_t block_size;
+    uint32_t min_size;          // Smaller requests would waste most of a block
+    uint16_t blocks;            // At most 32
+    uint8_t *base;
+    uint32_t used;              // Bit per block
+    uint8_t scope[32];          // Scope of each block in use
+    uint16_t in_use;
+    uint16_t high_water;
+    uint32_t allocs;
+    uint32_t overflows;
+} mem_pool_t;
+
+// In front of every heap allocation, listed so a scope can find its own
+typedef struct __attribute__((aligned(16))) mem_heap_hdr {
+    struct mem_heap_hdr *prev;
+    struct mem_heap_hdr *next;
+    uint32_t size;
+    uint16_t magic;
+    uint8_t scope;
+} mem_heap_hdr_t;
+
+typedef struct {
+    const char *name;
+    TaskHandle_t task;
+} mem_scope_t;
+
+// Smallest blocks first, mem_alloc() takes the first that fits
+static mem_pool_t pools[MEM_POOL_COUNT] = {
+    [MEM_POOL_GLYPH] = { "glyph", MEM_GLYPH_SIZE, 1, MEM_GLYPH_BLOCKS },
+    [MEM_POOL_LINE]  = { "line", MEM_LINE_SIZE, MEM_GLYPH_SIZE * 4 + 1, MEM_LINE_BLOCKS },
+    [MEM_POOL_MONO]  = { "mono", MEM_MONO_SIZE, 32 * 1024 + 1, CONFIG_MEM_ARENA_MONO_FRAMES },
+    [MEM_POOL_GRAY]  = { "gray", MEM_GRAY_SIZE, MEM_MONO_SIZE + 1, CONFIG_MEM_ARENA_GRAY_FRAMES },
+};
+
+static portMUX_TYPE init_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool init_claimed = false;
+static SemaphoreHandle_t volatile mem_lock = NULL;    // Set once the pools are reserved
+static mem_heap_hdr_t *heap_list = NULL;
+static uint32_t heap_blocks = 0;
+static uint32_t heap_bytes = 0;
+static uint32_t heap_high_water = 0;
+static uint32_t scope_freed = 0;
+static mem_scope_t scopes[MEM_SCOPE_MAX + 1];   // 1 .. scope_depth
+static int scope_depth = 0;
+
+esp_err_t mem_arena_init(void)
+{
+    // Boot graph nodes run in parallel, so two tasks may get here at once
+    taskENTER_CRITICAL(&init_mux);
+    bool mine = !init_claimed;
+    init_claimed = true;
+    taskEXIT_CRITICAL(&init_mux);
+    if (!mine) {
+        while (mem_lock == NULL) {
+            vTaskDelay(1);
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        mem_pool_t *pool = &pools[i];
+        if (pool->blocks > 32) {
+            pool->blocks = 32;
+        }
+        if (pool->blocks == 0) {
+            continue;
+        }
+        pool->base = heap_caps_malloc((size_t)pool->block_size * pool->blocks, MALLOC_CAP_SPIRAM);
+        if (pool->base == NULL) {
+            // Everything it would have held goes to the heap instead
+            ESP_LOGW(TAG, "No PSRAM for the %s pool (%u x %u bytes)", pool->name,
+                     (unsigned)pool->blocks, (unsigned)pool->block_size);
+            pool->blocks = 0;
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+    assert(lock != NULL);
+    mem_lock = lock;
+    return ret;
+}
+
+// Scope of an allocation by the calling task
+static uint8_t mem_current_scope(void)
+{
+    if (scope_depth > 0 && scopes[scope_depth].task == xTaskGetCurrentTaskHandle()) {
+        return (uint8_t)scope_depth;
+    }
+    return 0;
+}
+
+static void *mem_pool_take(mem_pool_t *pool, uint8_t scope)
+{
+    for (int i = 0; i < pool->blocks; i++) {
+        if (!(pool->used & (1u << i))) {
+            pool->used |= 1u << i;
+            pool->scope[i] = scope;
+            pool->allocs++;
+            if (++pool->in_use > pool->high_water) {
+                pool->high_water = pool->in_use;
+            }
+            return pool->base + (size_t)i * pool->block_size;
+        }
+    }
+    return NULL;
+}
+
+static void *mem_heap_take(size_t size, uint8_t scope)
+{
+    size_t total = sizeof(mem_heap_hdr_t) + size;
+    mem_heap_hdr_t *hdr = heap_caps_malloc(total, MALLOC_CAP_SPIRAM);
+    if (hdr == NULL) {
+        hdr = malloc(total);
+    }
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->prev = NULL;
+    hdr->next = heap_list;
+    hdr->size = (uint32_t)size;
+    hdr->magic = MEM_HEAP_MAGIC;
+    hdr->scope = scope;
+    if (heap_list) {
+        heap_list->prev = hdr;
+    }
+    heap_list = hdr;
+    heap_blocks++;
+    heap_bytes += size;
+    if (heap_bytes > heap_high_water) {
+        heap_high_water = heap_bytes;
+    }
+    return hdr + 1;
+}
+
+static void mem_heap_release(mem_heap_hdr_t *hdr)
+{
+    if (hdr->prev) {
+        hdr->prev->next = hdr->next;
+    } else {
+        heap_list = hdr->next;
+    }
+    if (hdr->next) {
+        hdr->next->prev = hdr->prev;
+    }
+    heap_blocks--;
+    heap_bytes -= hdr->size;
+    hdr->magic = 0;
+    heap_caps_free(hdr);
+}
+
+void *mem_alloc(size_t size)
+{
+    if (size == 0) {
+        return NULL;
+    }
+    if (mem_lock == NULL) {
+        mem_arena_init();
+    }
+    xSemaphoreTake(mem_lock, portMAX_DELAY);
+    uint8_t scope = mem_current_scope();
+    void *ptr = NULL;
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        mem_pool_t *pool = &pools[i];
+        if (size <= pool->block_size && size >= pool->min_size) {
+            ptr = mem_pool_take(pool, scope);
+            if (ptr == NULL) {
+                pool->overflows++;
+            }
+            break;
+        }
+    }
+    if (ptr == NULL) {
+        ptr = mem_heap_take(size, scope);
+    }
+    xSemaphoreGive(mem_lock);
+    if (ptr == NULL) {
+        ESP_LOGE(TAG, "Out of memory for %u bytes", (unsigned)size);
+    }
+    return ptr;
+}
+
+void *mem_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = mem_alloc(n * size);
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+// The pool block ptr points into, NULL if it is not from a pool
+static mem_pool_t *mem_pool_of(const void *ptr, int *index)
+{
+    const uint8_t *p = ptr;
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        mem_pool_t *pool = &pools[i];
+        if (pool->blocks > 0 && p >= pool->base && p < pool->base + (size_t)pool->block_size * pool->blocks) {
+            *index = (int)((p - pool->base) / pool->block_size);
+            return pool;
+        }
+    }
+    return NULL;
+}
+
+void mem_free(void *ptr)
+{
+    if (ptr == NULL || mem_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(mem_lock, portMAX_DELAY);
+    int index;
+    mem_pool_t *pool = mem_pool_of(ptr, &index);
+    if (pool) {
+        uint8_t *block = pool->base + (size_t)index * pool->block_size;
+        if (block != ptr || !(pool->used & (1u << index))) {
+            ESP_LOGE(TAG, "Bad free of %p in the %s pool", ptr, pool->name);
+        } else {
+            pool->used &= ~(1u << index);
+            pool->in_use--;
+        }
+    } else {
+        // Only a listed header is read: a block its scope already freed, or one
+        // that never came from here, may not be readable at all
+        mem_heap_hdr_t *hdr = heap_list;
+        while (hdr != NULL && (void *)(hdr + 1) != ptr) {
+            hdr = hdr->next;
+        }
+        if (hdr == NULL || hdr->magic != MEM_HEAP_MAGIC) {
+            // Not ours, or freed twice: leaking it is safer than guessing
+            ESP_LOGE(TAG, "Bad free of %p", ptr);
+        } else {
+            mem_heap_release(hdr);
+        }
+    }
+    xSemaphoreGive(mem_lock);
+}
+
+int mem_scope_enter(const char *name)
+{
+    if (mem_lock == NULL) {
+        mem_arena_init();
+    }
+    xSemaphoreTake(mem_lock, portMAX_DELAY);
+    int scope = 0;
+    if (scope_depth < MEM_SCOPE_MAX) {
+        scope = ++scope_depth;
+        scopes[scope].name = name;
+        scopes[scope].task = xTaskGetCurrentTaskHandle();
+    }
+    xSemaphoreGive(mem_lock);
+    if (scope == 0) {
+        ESP_LOGW(TAG, "Scopes nested too deep, %s runs in its parent's", name);
+    }
+    return scope;
+}
+
+void mem_scope_leave(int scope)
+{
+    if (scope <= 0 || mem_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(mem_lock, portMAX_DELAY);
+    if (scope > scope_depth) {
+        xSemaphoreGive(mem_lock);
+        ESP_LOGE(TAG, "Scope %d left twice", scope);
+        return;
+    }
+    // Inner scopes that were not left go with it
+    int blocks = 0;
+    uint32_t bytes = 0;
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        mem_pool_t *pool = &pools[i];
+        for (int b = 0; b < pool->blocks; b++) {
+            if ((pool->used & (1u << b)) && pool->scope[b] >= scope) {
+                pool->used &= ~(1u << b);
+                pool->in_use--;
+                blocks++;
+                bytes += pool->block_size;
+            }
+        }
+    }
+    mem_heap_hdr_t *hdr = heap_list;
+    while (hdr) {
+        mem_heap_hdr_t *next = hdr->next;
+        if (hdr->scope >= scope) {
+            blocks++;
+            bytes += hdr->size;
+            mem_heap_release(hdr);
+        }
+        hdr = next;
+    }
+    const char *name = scopes[scope].name;
+    scope_depth = scope - 1;
+    scope_freed += blocks;
+    xSemaphoreGive(mem_lock);
+
+    if (blocks > 0) {
+        ESP_LOGW(TAG, "%s left %d blocks (%u bytes) behind, freed", name, blocks, (unsigned)bytes);
+    }
+}
+
+void mem_arena_get_stats(mem_arena_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (mem_lock != NULL) {
+        xSemaphoreTake(mem_lock, portMAX_DELAY);
+    }
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        const mem_pool_t *pool = &pools[i];
+        mem_pool_stats_t *s = &stats->pools[i];
+        s->name = pool->name;
+        s->block_size = pool->block_size;
+        s->blocks = pool->blocks;
+        s->in_use = pool->in_use;
+        s->high_water = pool->high_water;
+        s->allocs = pool->allocs;
+        s->overflows = pool->overflows;
+    }
+    stats->heap_blocks = heap_blocks;
+    stats->heap_bytes = heap_bytes;
+    stats->heap_high_water = heap_high_water;
+    stats->scope_freed = scope_freed;
+    if (mem_lock != NULL) {
+        xSemaphoreGive(mem_lock);
+    }
+
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_SPIRAM);
+    stats->psram_free = info.total_free_bytes;
+    stats->psram_largest = info.largest_free_block;
+    stats->fragmentation = info.total_free_bytes ?
+        (uint8_t)(100 - (uint64_t)info.largest_free_block * 100 / info.total_free_bytes) : 0;
+}
+
+void mem_arena_log_stats(void)
+{
+    mem_arena_stats_t stats;
+    mem_arena_get_stats(&stats);
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        const mem_pool_stats_t *s = &stats.pools[i];
+        ESP_LOGI(TAG, "%-5s %6u B x %2u: %2u in use, peak %2u, %lu allocs, %lu overflows", s->name,
+                 (unsigned)s->block_size, s->blocks, s->in_use, s->high_water,
+                 (unsigned long)s->allocs, (unsigned long)s->overflows);
+    }
+    ESP_LOGI(TAG, "heap: %lu blocks, %lu B, peak %lu B; scopes freed %lu blocks",
+             (unsigned long)stats.heap_blocks, (unsigned long)stats.heap_bytes,
+             (unsigned long)stats.heap_high_water, (unsigned long)stats.scope_freed);
+    ESP_LOGI(TAG, "PSRAM: %u KB free, largest %u KB, fragmentation %u%%",
+             (unsigned)(stats.psram_free / 1024), (unsigned)(stats.psram_largest / 1024), stats.fragmentation);
+}
@@ -0,0 +1,89 @@
+#ifndef MEM_ARENA_H
+#define MEM_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-size PSRAM pools for the buffers the pages allocate over and over:
+ * frames, line buffers (a glyph batch, a layout block, a JSON body) and
+ * single glyphs. Each pool is one block reserved at start-up, so allocating
+ * and freeing frames never splits the heap, whatever the order. Requests
+ * that fit no pool, or find their pool full, go to the PSRAM heap and are
+ * counted as overflows.
+ *
+ * A page runs inside a scope: what the entering task allocates there and
+ * has not freed by mem_scope_leave() is freed then, and reported. Other
+ * tasks (alarm, audio) are not affected by a page's scope.
+ */
+
+#ifndef CONFIG_MEM_ARENA_MONO_FRAMES
+#define CONFIG_MEM_ARENA_MONO_FRAMES    10
+#endif
+#ifndef CONFIG_MEM_ARENA_GRAY_FRAMES
+#define CONFIG_MEM_ARENA_GRAY_FRAMES    1
+#endif
+
+#define MEM_MONO_SIZE       48000       // EPD_SIZE_MONO
+#define MEM_GRAY_SIZE       96000       // EPD_SIZE_4GRAY
+#define MEM_LINE_SIZE       (16 * 1024)
+#define MEM_LINE_BLOCKS     6
+#define MEM_GLYPH_SIZE      512
+#define MEM_GLYPH_BLOCKS    32
+#define MEM_SCOPE_MAX       8
+
+typedef enum {
+    MEM_POOL_GLYPH = 0,
+    MEM_POOL_LINE,
+    MEM_POOL_MONO,
+    MEM_POOL_GRAY,
+    MEM_POOL_COUNT
+} mem_pool_id_t;
+
+typedef struct {
+    const char *name;
+    uint32_t block_size;
+    uint16_t blocks;
+    uint16_t in_use;
+    uint16_t high_water;
+    uint32_t allocs;            // Served from the pool since start-up
+    uint32_t overflows;         // Would have fit, but the pool was full
+} mem_pool_stats_t;
+
+typedef struct {
+    mem_pool_stats_t pools[MEM_POOL_COUNT];
+    uint32_t heap_blocks;       // Overflow allocations held now
+    uint32_t heap_bytes;
+    uint32_t heap_high_water;   // Bytes
+    uint32_t scope_freed;       // Blocks a scope had to free for its page
+    size_t psram_free;
+    size_t psram_largest;       // Largest free PSRAM block
+    uint8_t fragmentation;      // % of free PSRAM outside the largest block
+} mem_arena_stats_t;
+
+// Reserves the pools. Called by the first mem_alloc() if not before.
+esp_err_t mem_arena_init(void);
+
+// From the smallest pool the size fits without wasting most of the block, else the PSRAM heap
+void *mem_alloc(size_t size);
+void *mem_calloc(size_t n, size_t size);
+// NULL is ignored, as with free()
+void mem_free(void *ptr);
+
+// Returns the scope to hand to mem_scope_leave(), 0 if scopes are nested too deep
+int mem_scope_enter(const char *name);
+void mem_scope_leave(int scope);
+
+void mem_arena_get_stats(mem_arena_stats_t *stats);
+void mem_arena_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
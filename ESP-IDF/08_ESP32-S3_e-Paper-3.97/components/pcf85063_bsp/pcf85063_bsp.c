@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "pcf85063_bsp.h"
 #include "i2c_bsp.h"
@@ -10,10 +11,14 @@
 #include <nvs.h>
 #include <nvs_flash.h>
 #include "driver/gpio.h"  // 添加GPIO头文件
+#include "freertos/semphr.h"
 
 
 static const char *TAG = "PCF85063";
 
+// Given by the INT pin ISR (or by software) to wake a task waiting for the RTC
+static SemaphoreHandle_t rtc_int_sem = NULL;
+
 // Write to the mode status
 void save_mode_enable_to_nvs(char mode) {
     nvs_handle_t nvs_handle;
@@ -142,19 +147,42 @@ void PCF85063_SetTime_HMS(int hour,int minute,int second)
 	PCF85063_Write_Byte(SECONDS_REG,DecToBcd(second)&0x7F);
 }
 
-Time_data PCF85063_GetTime()
+/******************************************************************************
+function:	Decode the 7 time registers (SECONDS_REG..YEARS_REG) into Time_data
+parameter:
+            raw: register image in address order (seconds first)
+Info:       The OS flag (seconds bit 7) and unused bits are masked off
+******************************************************************************/
+Time_data PCF85063_DecodeTime(const uint8_t raw[PCF85063_TIME_REG_NUM])
 {
 	Time_data time;
-	time.years = BcdToDec(PCF85063_Read_Byte(YEARS_REG));
-	time.months = BcdToDec(PCF85063_Read_Byte(MONTHS_REG)&0x1F);
-	time.days = BcdToDec(PCF85063_Read_Byte(DAYS_REG)&0x3F);
-	time.hours = BcdToDec(PCF85063_Read_Byte(HOURS_REG)&0x3F);
-	time.minutes = BcdToDec(PCF85063_Read_Byte(MINUTES_REG)&0x7F);
-	time.seconds = BcdToDec(PCF85063_Read_Byte(SECONDS_REG)&0x7F);
-    time.week = PCF85063_Read_Byte(WEEKDAYS_REG) & 0x07;
+	time.seconds = BcdToDec(raw[0] & 0x7F);
+	time.minutes = BcdToDec(raw[1] & 0x7F);
+	time.hours = BcdToDec(raw[2] & 0x3F);
+	time.days = BcdToDec(raw[3] & 0x3F);
+	time.week = raw[4] & 0x07;
+	time.months = BcdToDec(raw[5] & 0x1F);
+	time.years = BcdToDec(raw[6]);
 	return time;
 }
 
+/******************************************************************************
+function:	Read the current time
+Info:       All 7 time registers are fetched in one burst. The PCF85063 freezes
+            its time counters for the duration of the transfer, so the result
+            cannot be torn across a second/minute rollover.
+******************************************************************************/
+Time_data PCF85063_GetTime()
+{
+	uint8_t raw[PCF85063_TIME_REG_NUM] = {0};
+	esp_err_t ret = i2c_read_reg(PCF85063Addr, SECONDS_REG, raw, sizeof(raw));
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "The I2C failed to burst read the time registers: %d", ret);
+		memset(raw, 0, sizeof(raw));
+	}
+	return PCF85063_DecodeTime(raw);
+}
+
 void PCF85063_alarm_Time_Enabled(Time_data time)
 {
     if(time.seconds>59)
@@ -220,6 +248,81 @@ void PCF85063_alarm_Time_Disable()
     PCF85063_Write_Byte(CONTROL_2_REG   ,PCF85063_Read_Byte(CONTROL_2_REG)&0x7F);	// Alarm OFF
 }
 
+/******************************************************************************
+function:	Program a daily alarm at hour:minute:00
+Info:       Day and weekday matching are disabled, so the alarm fires every day
+            at the given time. All 5 alarm registers are written in one burst.
+******************************************************************************/
+void PCF85063_alarm_Set_HM(uint8_t hour, uint8_t minute)
+{
+    uint8_t buf[5];
+    buf[0] = DecToBcd(0) & 0x7F;             // SECOND_ALARM_REG, enabled
+    buf[1] = DecToBcd(minute % 60) & 0x7F;   // MINUTES_ALARM_REG, enabled
+    buf[2] = DecToBcd(hour % 24) & 0x3F;     // HOUR_ARARM_REG, enabled
+    buf[3] = 0x80;                           // DAY_ALARM_REG, disabled
+    buf[4] = 0x80;                           // WEEKDAY_ALARM_REG, disabled
+    esp_err_t ret = i2c_write_reg(PCF85063Addr, SECOND_ALARM_REG, buf, sizeof(buf));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "The I2C failed to write the alarm registers: %d", ret);
+        return;
+    }
+    // Clear a stale flag and turn the alarm interrupt on
+    PCF85063_Write_Byte(CONTROL_2_REG, (PCF85063_Read_Byte(CONTROL_2_REG) & 0xBF) | 0x80);
+}
+
+static void IRAM_ATTR rtc_int_isr_handler(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(rtc_int_sem, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/******************************************************************************
+function:	Route the INT pin (active low) to a GPIO ISR
+Info:       After this, PCF85063_int_wait() blocks until the RTC asserts INT
+******************************************************************************/
+void PCF85063_int_isr_init(void)
+{
+    if (rtc_int_sem != NULL) {
+        return;
+    }
+    rtc_int_sem = xSemaphoreCreateBinary();
+    assert(rtc_int_sem != NULL);
+
+    gpio_set_intr_type(RTC_INT_PIN, GPIO_INTR_NEGEDGE);
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install the GPIO ISR service: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_isr_handler_add(RTC_INT_PIN, rtc_int_isr_handler, NULL));
+}
+
+/******************************************************************************
+function:	Wait for the RTC interrupt (or a software notify)
+parameter:
+            timeout: the maximum number of ticks to wait
+Info:       Returns 1 if woken, 0 on timeout
+******************************************************************************/
+int PCF85063_int_wait(TickType_t timeout)
+{
+    if (rtc_int_sem == NULL) {
+        vTaskDelay(timeout);
+        return 0;
+    }
+    return xSemaphoreTake(rtc_int_sem, timeout) == pdTRUE;
+}
+
+// Wake a task blocked in PCF85063_int_wait(), e.g. after the alarm table changed
+void PCF85063_int_notify(void)
+{
+    if (rtc_int_sem != NULL) {
+        xSemaphoreGive(rtc_int_sem);
+    }
+}
+
 int PCF85063_get_alarm_flag()
 {
 	if(((PCF85063_Read_Byte(CONTROL_2_REG))&(0x40)) == 0x40)
@@ -252,11 +355,92 @@ void rtcRunAlarm(Time_data time, Time_data alarmTime)
     PCF85063_alarm_Time_Enabled(alarmTime);
 }
 
+/******************************************************************************
+function:	Read/write the general purpose RAM byte
+Info:       The RTC runs from the backup cell, so this byte survives the AXP2101
+            cutting the main supply, unlike the ESP32 RTC memory
+******************************************************************************/
+uint8_t PCF85063_ram_read(void)
+{
+	return PCF85063_Read_Byte(RAM_BYTE_REG);
+}
+
+void PCF85063_ram_write(uint8_t value)
+{
+	PCF85063_Write_Byte(RAM_BYTE_REG, value);
+}
+
+/******************************************************************************
+function:	Read/write the OFFSET register in normal mode (MODE = 0)
+parameter:
+            offset: -64..63, each step is 4.34 ppm, positive values make the
+                    clock run faster
+Info:       The correction is applied once every two hours
+******************************************************************************/
+int8_t PCF85063_offset_read(void)
+{
+	uint8_t reg = PCF85063_Read_Byte(OFFSET_REG) & 0x7F;
+	return (int8_t)(reg & 0x40 ? reg | 0x80 : reg);
+}
+
+void PCF85063_offset_write(int8_t offset)
+{
+	if (offset < -64)
+		offset = -64;
+	if (offset > 63)
+		offset = 63;
+	PCF85063_Write_Byte(OFFSET_REG, (uint8_t)offset & 0x7F);
+}
+
+/******************************************************************************
+function:	Stop or restart the clock (STOP bit of Control_1)
+Info:       Stopping clears the divider chain. After the restart the first
+            second ends 0.507813 - 0.507935 s later, which lets the time be set
+            in step with another clock
+******************************************************************************/
+void PCF85063_stop(int stop)
+{
+	uint8_t ctrl1 = PCF85063_Read_Byte(CONTROL_1_REG);
+	if (stop)
+		ctrl1 |= 0x20;
+	else
+		ctrl1 &= ~0x20;
+	PCF85063_Write_Byte(CONTROL_1_REG, ctrl1);
+}
+
+/******************************************************************************
+function:	Set the current time
+Info:       All 7 time registers are written in one burst, so a concurrent
+            PCF85063_GetTime() sees either the old or the new time, never a mix
+******************************************************************************/
 void PCF85063_SetTime(Time_data time)
 {
-    PCF85063_SetTime_HMS(time.hours, time.minutes, time.seconds);
-	PCF85063_SetTime_YMD(time.years, time.months, time.days);
-    PCF85063_Write_Byte(WEEKDAYS_REG, time.week & 0x07);
+	uint8_t raw[PCF85063_TIME_REG_NUM];
+
+	if (time.hours > 23)
+		time.hours = 23;
+	if (time.minutes > 59)
+		time.minutes = 59;
+	if (time.seconds > 59)
+		time.seconds = 59;
+	if (time.years > 99)
+		time.years = 99;
+	if (time.months > 12)
+		time.months = 12;
+	if (time.days > 31)
+		time.days = 31;
+	raw[0] = DecToBcd(time.seconds) & 0x7F;
+	raw[1] = DecToBcd(time.minutes) & 0x7F;
+	raw[2] = DecToBcd(time.hours) & 0x3F;
+	raw[3] = DecToBcd(time.days) & 0x3F;
+	raw[4] = time.week & 0x07;
+	raw[5] = DecToBcd(time.months) & 0x1F;
+	raw[6] = DecToBcd(time.years);
+
+	esp_err_t ret = i2c_write_reg(PCF85063Addr, SECONDS_REG, raw, sizeof(raw));
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "The I2C failed to burst write the time registers: %d", ret);
+	}
 }
 
 
@@ -1,6 +1,9 @@
 #ifndef PCF85063_BSP_H
 #define PCF85063_BSP_H
 
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
 
 #define		CONTROL_1_REG         0x00  
 #define 	CONTROL_2_REG         0x01 
@@ -21,6 +24,9 @@
 #define 	TIMER_VALUE_REG       0x10
 #define 	TIMER_MODE_REG        0x11
 
+// SECONDS_REG..YEARS_REG, read back in a single burst
+#define     PCF85063_TIME_REG_NUM 7
+
 #define     RTC_INT_PIN           (gpio_num_t)45
 #define     RTC_INT               gpio_get_level(RTC_INT_PIN)
 
@@ -49,14 +55,24 @@ int BcdToDec(int val);
 void PCF85063_init();
 void PCF85063_SetTime_YMD(int Years,int Months,int Days);
 void PCF85063_SetTime_HMS(int hour,int minute,int second);
+Time_data PCF85063_DecodeTime(const uint8_t raw[PCF85063_TIME_REG_NUM]);
 Time_data PCF85063_GetTime();
 void PCF85063_alarm_Time_Enabled(Time_data time);
 void PCF85063_alarm_Time_Disable();
+void PCF85063_alarm_Set_HM(uint8_t hour, uint8_t minute);
+void PCF85063_int_isr_init(void);
+int PCF85063_int_wait(TickType_t timeout);
+void PCF85063_int_notify(void);
 int PCF85063_get_alarm_flag();
 void PCF85063_clear_alarm_flag();
 void PCF85063_test();
 void rtcRunAlarm(Time_data time, Time_data alarmTime);
 void PCF85063_SetTime(Time_data time);
+uint8_t PCF85063_ram_read(void);
+void PCF85063_ram_write(uint8_t value);
+int8_t PCF85063_offset_read(void);
+void PCF85063_offset_write(int8_t offset);
+void PCF85063_stop(int stop);
 
 void save_mode_enable_to_nvs(char mode);
 char load_mode_enable_from_nvs();
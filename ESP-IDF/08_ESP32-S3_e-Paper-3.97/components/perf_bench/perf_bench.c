@@ -0,0 +1,562 @@
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "GUI_Paint.h"
+#include "GUI_BMPfile.h"
+#include "ImageData.h"
+#include "epaper_port.h"
+#include "img_pipeline.h"
+#include "text_layout.h"
+#include "gb2312_map.h"
+#include "perf_bench.h"
+
+#ifndef CONFIG_IDF_TARGET
+#define CONFIG_IDF_TARGET   "unknown"
+#endif
+
+#define PB_IMG_W            480     // Portrait, as the pages draw
+#define PB_IMG_H            800
+#define PB_CALIB_BYTES      (256 * 1024)
+
+static const char *TAG = "perf_bench";
+
+typedef struct {
+    UBYTE *mono;                // EPD_SIZE_MONO
+    UBYTE *gray;                // EPD_SIZE_4GRAY
+    uint8_t *rgb;               // PB_IMG_W x PB_IMG_H RGB24, the 4-gray and BMP source
+    char *text;                 // PB_LAYOUT_BYTES of UTF-8
+    uint32_t check;             // Set by the workload from its output
+} pb_ctx_t;
+
+typedef struct {
+    const char *name;
+    int runs;
+    void (*run)(pb_ctx_t *ctx);
+} pb_bench_t;
+
+/*---------- Inputs ----------*/
+
+// Common hanzi and CJK punctuation, all in the GB2312 fonts
+static const char pb_hanzi[] =
+    "的一是在不了有和人这中大为上个国我以要他时来用们生到作地于出就分对成会可主发年动"
+    "同工也能下过子说产种面而方后多定行学法所民得经十三之进着等部度家电力里如水化高自"
+    "二理起小物现实加量都两体制机当使点从业本去把性好应开它合还因由其些然前外天政四日"
+    "那社义事平形相全表间样与关各重新线内数正心反你明看原又么利比或但质气第向道命此变"
+    "条只没结解问意建月公无系军很情者最立代想已通并提直题党程展五果料象员革位入常文总"
+    "次品式活设及管特件长求老头基资边流路级少图山统接知较将组见计别她手角期根论运农指"
+    "，。、；：？！“”";
+
+static const char *const pb_words[] = {
+    "the", "river", "ran", "past", "old", "mill", "and", "under", "bridge", "where",
+    "nobody", "had", "walked", "since", "winter", "of", "long", "rain", "she", "kept",
+    "letters", "in", "a", "box", "cedar", "read", "them", "again", "whenever", "lamp",
+    "was", "low", "house", "quiet", "enough", "to", "hear", "clock", "hall", "extraordinarily",
+};
+
+// The same sequence on every run and target
+static uint32_t pb_rand(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Byte offset of the i-th character of pb_hanzi, all three bytes long
+static const char *hanzi_at(uint32_t i)
+{
+    return pb_hanzi + (i % ((sizeof(pb_hanzi) - 1) / 3)) * 3;
+}
+
+// Paragraphs of English and of hanzi, as a reader's book mixes them
+static void make_text(char *out, size_t size)
+{
+    uint32_t seed = 1;
+    size_t n = 0;
+    while (n + 512 < size) {
+        if (pb_rand(&seed) % 4 == 0) {
+            int chars = 40 + pb_rand(&seed) % 200;
+            for (int i = 0; i < chars; i++) {
+                memcpy(out + n, hanzi_at(pb_rand(&seed)), 3);
+                n += 3;
+            }
+        } else {
+            int words = 20 + pb_rand(&seed) % 100;
+            for (int i = 0; i < words; i++) {
+                const char *w = pb_words[pb_rand(&seed) % (sizeof(pb_words) / sizeof(pb_words[0]))];
+                size_t len = strlen(w);
+                memcpy(out + n, w, len);
+                n += len;
+                out[n++] = (i + 1 == words) ? '.' : ' ';
+            }
+        }
+        out[n++] = '\n';
+    }
+    memset(out + n, ' ', size - n - 1);
+    out[size - 1] = '\n';
+}
+
+// A photo-like test card: gradients, a hard-edged disc and fine stripes
+static void make_rgb(uint8_t *rgb)
+{
+    for (int y = 0; y < PB_IMG_H; y++) {
+        uint8_t *p = rgb + (size_t)y * PB_IMG_W * 3;
+        for (int x = 0; x < PB_IMG_W; x++, p += 3) {
+            int dx = x - PB_IMG_W / 2, dy = y - PB_IMG_H / 3;
+            bool disc = dx * dx + dy * dy < 150 * 150;
+            p[0] = disc ? 230 : (uint8_t)(x * 255 / PB_IMG_W);
+            p[1] = disc ? 40 : (uint8_t)(y * 255 / PB_IMG_H);
+            p[2] = (y > PB_IMG_H * 3 / 4) ? (((x / 3) & 1) ? 255 : 0) : (uint8_t)((x + y) & 0xFF);
+        }
+    }
+}
+
+// 24-bit bottom-up BMP of the test card, for GUI_LoadBmp
+static esp_err_t write_bmp(const char *path, const uint8_t *rgb)
+{
+    int row = PB_IMG_W * 3;         // Already a multiple of 4
+    BMPFILEHEADER fh = {
+        .bType = 0x4D42,
+        .bSize = sizeof(BMPFILEHEADER) + sizeof(BMPINFOHEADER) + row * PB_IMG_H,
+        .bOffset = sizeof(BMPFILEHEADER) + sizeof(BMPINFOHEADER),
+    };
+    BMPINFOHEADER ih = {
+        .biInfoSize = sizeof(BMPINFOHEADER),
+        .biWidth = PB_IMG_W,
+        .biHeight = PB_IMG_H,
+        .biPlanes = 1,
+        .biBitCount = 24,
+        .bimpImageSize = row * PB_IMG_H,
+    };
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return ESP_ERR_NOT_FOUND;
+    uint8_t *line = malloc(row);
+    bool ok = line && fwrite(&fh, sizeof(fh), 1, fp) == 1 && fwrite(&ih, sizeof(ih), 1, fp) == 1;
+    for (int y = PB_IMG_H - 1; ok && y >= 0; y--) {
+        const uint8_t *src = rgb + (size_t)y * row;
+        for (int x = 0; x < PB_IMG_W; x++) {
+            line[x * 3] = src[x * 3 + 2];
+            line[x * 3 + 1] = src[x * 3 + 1];
+            line[x * 3 + 2] = src[x * 3];
+        }
+        ok = fwrite(line, row, 1, fp) == 1;
+    }
+    free(line);
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) remove(path);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static void select_mono(pb_ctx_t *ctx)
+{
+    Paint_NewImage(ctx->mono, EPD_WIDTH, EPD_HEIGHT, 270, WHITE);
+    Paint_SetScale(2);
+    Paint_SelectImage(ctx->mono);
+}
+
+/*---------- Workloads ----------*/
+
+// CPU only, on a source no workload writes: the yardstick the other times are
+// compared by, so that a machine faster or busier as a whole cancels out
+static void bench_calibration(pb_ctx_t *ctx)
+{
+    ctx->check = crc32(ctx->rgb, PB_CALIB_BYTES);
+}
+
+static void bench_clear(pb_ctx_t *ctx)
+{
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    Paint_Clear(BLACK);
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+static void bench_shapes(pb_ctx_t *ctx)
+{
+    uint32_t seed = 7;
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    for (int i = 0; i < 1000; i++) {
+        // Kept 4 pixels from the edges, the widest pen is 3
+        UWORD x0 = 4 + pb_rand(&seed) % (PB_IMG_W - 8), y0 = 4 + pb_rand(&seed) % (PB_IMG_H - 8);
+        UWORD x1 = 4 + pb_rand(&seed) % (PB_IMG_W - 8), y1 = 4 + pb_rand(&seed) % (PB_IMG_H - 8);
+        Paint_DrawLine(x0, y0, x1, y1, BLACK, (DOT_PIXEL)(1 + i % 3),
+                       (i % 5 == 0) ? LINE_STYLE_DOTTED : LINE_STYLE_SOLID);
+    }
+    for (int i = 0; i < 1000; i++) {
+        UWORD x0 = pb_rand(&seed) % (PB_IMG_W - 60), y0 = pb_rand(&seed) % (PB_IMG_H - 60);
+        UWORD w = 4 + pb_rand(&seed) % 56, h = 4 + pb_rand(&seed) % 56;
+        Paint_DrawRectangle(x0, y0, x0 + w, y0 + h, (i & 1) ? BLACK : WHITE, DOT_PIXEL_1X1,
+                            (i % 3 == 0) ? DRAW_FILL_FULL : DRAW_FILL_EMPTY);
+    }
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+static const PAINT_IMAGE *const home_icons[8] = {
+    &Image_file, &Image_clock, &Image_calendar, &Image_alarm,
+    &Image_weather, &Image_network, &Image_audio_file, &Image_read,
+};
+static const unsigned char *const home_icons_raw[8] = {
+    gImage_file, gImage_clock, gImage_calendar, gImage_alarm,
+    gImage_weather, gImage_network, gImage_audio_file, gImage_read,
+};
+static const UWORD icon_x[2] = {77, 307};
+static const UWORD icon_y[4] = {78, 264, 450, 636};
+
+// esp_home() of main.cc with the built-in icons
+static void bench_home(pb_ctx_t *ctx)
+{
+    static const char *const labels[8] = {"文件", "时钟", "日历", "闹钟", "天气", "网络", "音频", "阅读"};
+
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    Paint_DrawString_EN(20, 11, "09:30", &Font16, WHITE, BLACK);
+    Paint_BlitImage(326, 8, &Image_WIFI, ROP_COPY);
+    Paint_BlitImage(370, 17, &Image_BAT, ROP_COPY);
+    Paint_DrawString_EN(411, 11, "80%", &Font16, WHITE, BLACK);
+    Paint_DrawRectangle(375, 22, 395, 30, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawRectangle(375, 22, 391, 30, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawLine(2, 54, EPD_HEIGHT - 2, 54, BLACK, DOT_PIXEL_2X2, LINE_STYLE_SOLID);
+    for (int i = 0; i < 8; i++) {
+        UWORD x = icon_x[i % 2], y = icon_y[i / 2];
+        Paint_BlitImage(x, y, home_icons[i], ROP_COPY);
+        UWORD tx = reassignCoordinates_CH(x + 48, labels[i], &Font16_UTF8);
+        Paint_DrawString_CN(tx, y + 100, labels[i], &Font16_UTF8, WHITE, BLACK);
+    }
+    Paint_DrawRectangle(icon_x[0] - 20, icon_y[0] - 20, icon_x[0] + 140, icon_y[0] + 140, BLACK,
+                        DOT_PIXEL_3X3, DRAW_FILL_EMPTY);
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+// The icons of esp_home() alone, unpacked from ImageData_packed.c
+static void bench_icons(pb_ctx_t *ctx)
+{
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    Paint_BlitImage(326, 8, &Image_WIFI, ROP_COPY);
+    Paint_BlitImage(370, 17, &Image_BAT, ROP_COPY);
+    for (int i = 0; i < 8; i++) Paint_BlitImage(icon_x[i % 2], icon_y[i / 2], home_icons[i], ROP_COPY);
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+// The same icons from the raw arrays of ImageData.c, as before the packing
+static void bench_icons_raw(pb_ctx_t *ctx)
+{
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    Paint_ReadBmp(gImage_WIFI, 326, 8, Image_WIFI.Width, Image_WIFI.Height);
+    Paint_ReadBmp(gImage_BAT, 370, 17, Image_BAT.Width, Image_BAT.Height);
+    for (int i = 0; i < 8; i++) {
+        Paint_ReadBmp(home_icons_raw[i], icon_x[i % 2], icon_y[i / 2], home_icons[i]->Width,
+                      home_icons[i]->Height);
+    }
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+#define PB_GLYPHS           2000
+#define PB_GLYPH_W          font24_Width_CH
+#define PB_GLYPH_H          font24_Height
+#define PB_GLYPH_BYTES      ((PB_GLYPH_W + 7) / 8 * PB_GLYPH_H)
+
+// Noise the size of a 24 px hanzi
+static UBYTE pb_glyphs[16][PB_GLYPH_BYTES];
+
+static void make_glyphs(void)
+{
+    uint32_t seed = 3;
+    for (int g = 0; g < 16; g++) {
+        for (int i = 0; i < PB_GLYPH_BYTES; i++) pb_glyphs[g][i] = (UBYTE)pb_rand(&seed);
+    }
+}
+
+// Paint_DrawGlyph alone, no font reads: glyphs row by row over the page,
+// every fourth on a transparent background
+static void bench_glyphs(pb_ctx_t *ctx)
+{
+    int cols = PB_IMG_W / PB_GLYPH_W, rows = PB_IMG_H / PB_GLYPH_H;
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    for (int i = 0; i < PB_GLYPHS; i++) {
+        int cell = i % (cols * rows);
+        // Odd x so that the glyphs straddle bytes of the frame
+        UWORD x = 1 + (cell % cols) * PB_GLYPH_W, y = (cell / cols) * PB_GLYPH_H;
+        Paint_DrawGlyph(x > PB_IMG_W - PB_GLYPH_W ? PB_IMG_W - PB_GLYPH_W : x, y, pb_glyphs[i % 16],
+                        PB_GLYPH_W, PB_GLYPH_H, BLACK, (i % 4 == 3) ? TRANSPARENT : WHITE);
+    }
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+#define PB_HANZI_COUNT      ((sizeof(pb_hanzi) - 1) / 3)
+
+// pb_hanzi in GB2312, two bytes each
+static char pb_hanzi_gbk[PB_HANZI_COUNT * 2];
+
+static void make_gbk(void)
+{
+    for (size_t i = 0; i < PB_HANZI_COUNT; i++) {
+        int len;
+        uint32_t cp = UTF8_To_Unicode(hanzi_at(i), &len);
+        uint8_t page = gb2312_fwd_index[cp >> 8];
+        uint16_t gb = page == GB2312_NO_PAGE ? 0 : gb2312_fwd_pages[page][cp & 0xFF];
+        pb_hanzi_gbk[i * 2] = (char)(gb >> 8);
+        pb_hanzi_gbk[i * 2 + 1] = (char)(gb & 0xFF);
+    }
+}
+
+// A reader page of hanzi: as many full lines as the screen holds
+static void draw_cn_page(pb_ctx_t *ctx, cFONT *font)
+{
+    char line[64 * 3 + 1];
+    bool gbk = font->encoding == FONT_ENCODING_GBK;
+    int per_line = (PB_IMG_W - 20) / font->Width_CH;
+    int lines = (PB_IMG_H - 60) / (font->Height + 4);
+    if (per_line > 64) per_line = 64;
+
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    uint32_t k = 0;
+    for (int l = 0; l < lines; l++) {
+        char *p = line;
+        for (int i = 0; i < per_line; i++, k++) {
+            uint32_t c = (k * 7) % PB_HANZI_COUNT;
+            if (gbk) {
+                memcpy(p, pb_hanzi_gbk + c * 2, 2);
+                p += 2;
+            } else {
+                memcpy(p, hanzi_at(c), 3);
+                p += 3;
+            }
+        }
+        *p = '\0';
+        Paint_DrawString_CN(10, 50 + l * (font->Height + 4), line, font, WHITE, BLACK);
+    }
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+// The two sizes of the reader with Chinese fonts on the card for both
+// encodings: 24 (32 px cells) in UTF-8, 28 (40 px cells) in GBK
+static void bench_cn24(pb_ctx_t *ctx)
+{
+    draw_cn_page(ctx, &Font24_UTF8);
+}
+
+static void bench_cn28(pb_ctx_t *ctx)
+{
+    draw_cn_page(ctx, &Font28_GBK);
+}
+
+static void gray_row(void *arg, int y, const uint8_t *row)
+{
+    pb_ctx_t *ctx = arg;
+    memcpy(ctx->gray + (size_t)y * (PB_IMG_W / 4), row, PB_IMG_W / 4);
+}
+
+static void bench_gray4(pb_ctx_t *ctx)
+{
+    img_pipe_cfg_t cfg = {
+        .width = PB_IMG_W,
+        .out = IMG_OUT_GRAY2,
+        .dither = IMG_DITHER_FLOYD,
+        .gamma = true,
+        .emit = gray_row,
+        .ctx = ctx,
+    };
+    img_pipe_t *pipe;
+    if (img_pipe_create(&cfg, &pipe) != ESP_OK) return;
+    for (int y = 0; y < PB_IMG_H; y++) img_pipe_push(pipe, IMG_SRC_RGB24, ctx->rgb + (size_t)y * PB_IMG_W * 3, NULL);
+    img_pipe_finish(pipe);
+    img_pipe_destroy(pipe);
+    ctx->check = crc32(ctx->gray, EPD_SIZE_4GRAY);
+}
+
+static void bench_bmp(pb_ctx_t *ctx)
+{
+    static const BMP_OPTIONS opt = { BMP_DITHER_FLOYD, 0, 0, true };
+    select_mono(ctx);
+    Paint_Clear(WHITE);
+    GUI_LoadBmp(PB_BMP_PATH, 0, 0, &opt);
+    ctx->check = crc32(ctx->mono, EPD_SIZE_MONO);
+}
+
+static int layout_advance(void *arg, uint32_t prev, uint32_t cp)
+{
+    const cFONT *font = arg;
+    return Font_Kerning(font, prev, cp) + Font_Advance(font, cp);
+}
+
+// The reader's configuration, over the whole text at once
+static void bench_layout(pb_ctx_t *ctx)
+{
+    cFONT *font = &Font18_UTF8;
+    tl_config_t cfg = {
+        .width = PB_IMG_W - 20,
+        .indent = 2 * font->Width_CH,
+        .em = font->Width_CH,
+        .max_bytes = 256,
+        .justify = true,
+        .hyphenate = true,
+        .advance = layout_advance,
+        .ctx = font,
+    };
+    tl_line_t line;
+    size_t pos = 0;
+    bool para = true;
+    uint32_t check = 0;
+    while (tl_break_line(&cfg, ctx->text, PB_LAYOUT_BYTES, pos, true, para, &line)) {
+        check = check * 31 + line.next;
+        para = (line.flags & TL_LINE_PARA_END) != 0;
+        pos = line.next;
+    }
+    ctx->check = check;
+}
+
+static const pb_bench_t benches[] = {
+    {PB_CALIBRATION,   20, bench_calibration},
+    {"clear",          50, bench_clear},
+    {"shapes_1000",    20, bench_shapes},
+    {"glyphs_2000",    20, bench_glyphs},
+    {"home_8_icons",   20, bench_home},
+    {"home_icons",     50, bench_icons},
+    {"home_icons_raw", 50, bench_icons_raw},
+    {"cn_page_24",     10, bench_cn24},
+    {"cn_page_28_gbk", 10, bench_cn28},
+    {"gray4_convert",  10, bench_gray4},
+    {"bmp_decode",     10, bench_bmp},
+    {"layout_1mb",      3, bench_layout},
+};
+
+/*---------- Driver ----------*/
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void time_bench(const pb_bench_t *b, int runs, pb_ctx_t *ctx, pb_result_t *r)
+{
+    static double ms[PB_MAX_RUNS];
+    if (runs > PB_MAX_RUNS) runs = PB_MAX_RUNS;
+
+    b->run(ctx);    // Warm-up: file handles, glyph reads, caches
+    double sum = 0;
+    for (int i = 0; i < runs; i++) {
+        int64_t t0 = esp_timer_get_time();
+        b->run(ctx);
+        ms[i] = (esp_timer_get_time() - t0) / 1000.0;
+        sum += ms[i];
+    }
+    qsort(ms, runs, sizeof(ms[0]), cmp_double);
+
+    r->name = b->name;
+    r->runs = runs;
+    r->min_ms = ms[0];
+    r->median_ms = (runs & 1) ? ms[runs / 2] : (ms[runs / 2 - 1] + ms[runs / 2]) / 2;
+    r->p99_ms = ms[(99 * runs + 99) / 100 - 1];
+    r->mean_ms = sum / runs;
+    r->check = ctx->check;
+}
+
+static bool need_card(const pb_bench_t *b)
+{
+    return b->run == bench_bmp || b->run == bench_home || b->run == bench_cn24 || b->run == bench_cn28;
+}
+
+int perf_bench_run(const char *filter, int runs, pb_result_t *results, int max)
+{
+    pb_ctx_t ctx = {
+        .mono = heap_caps_malloc(EPD_SIZE_MONO, MALLOC_CAP_SPIRAM),
+        .gray = heap_caps_malloc(EPD_SIZE_4GRAY, MALLOC_CAP_SPIRAM),
+        .rgb = heap_caps_malloc(PB_IMG_W * PB_IMG_H * 3, MALLOC_CAP_SPIRAM),
+        .text = heap_caps_malloc(PB_LAYOUT_BYTES, MALLOC_CAP_SPIRAM),
+    };
+    int n = 0;
+    if (!ctx.mono || !ctx.gray || !ctx.rgb || !ctx.text) {
+        ESP_LOGE(TAG, "Not enough memory for the benchmarks");
+        goto out;
+    }
+    make_rgb(ctx.rgb);
+    make_text(ctx.text, PB_LAYOUT_BYTES);
+    make_gbk();
+    make_glyphs();
+
+    // stat() of a FAT mount point fails, its directory opens
+    DIR *dir = opendir("/sdcard");
+    bool card = dir != NULL;
+    if (dir) closedir(dir);
+    struct stat st;
+    if (card && stat(PB_BMP_PATH, &st) != 0) {
+        mkdir("/sdcard/bench", 0775);
+        if (write_bmp(PB_BMP_PATH, ctx.rgb) != ESP_OK) ESP_LOGW(TAG, "Cannot write %s", PB_BMP_PATH);
+    }
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]) && n < max; i++) {
+        const pb_bench_t *b = &benches[i];
+        // The calibration runs whatever the filter, the others are measured against it
+        if (filter && !strstr(b->name, filter) && b->run != bench_calibration) continue;
+        if (!card && need_card(b)) {
+            ESP_LOGW(TAG, "%s skipped, no card", b->name);
+            continue;
+        }
+        time_bench(b, runs > 0 ? runs : b->runs, &ctx, &results[n]);
+        ESP_LOGI(TAG, "%-16s median %8.3f ms", b->name, results[n].median_ms);
+        n++;
+    }
+
+out:
+    heap_caps_free(ctx.mono);
+    heap_caps_free(ctx.gray);
+    heap_caps_free(ctx.rgb);
+    heap_caps_free(ctx.text);
+    return n;
+}
+
+void perf_bench_log(const pb_result_t *results, int n)
+{
+    ESP_LOGI(TAG, "%-16s %5s %9s %9s %9s %9s  %s", "bench", "runs", "min", "median", "p99", "mean", "check");
+    for (int i = 0; i < n; i++) {
+        const pb_result_t *r = &results[i];
+        ESP_LOGI(TAG, "%-16s %5d %9.3f %9.3f %9.3f %9.3f  %08lx", r->name, r->runs, r->min_ms, r->median_ms,
+                 r->p99_ms, r->mean_ms, (unsigned long)r->check);
+    }
+}
+
+esp_err_t perf_bench_write_json(FILE *fp, const pb_result_t *results, int n)
+{
+    fprintf(fp, "{\n  \"target\": \"%s\",\n  \"benches\": [\n", CONFIG_IDF_TARGET);
+    for (int i = 0; i < n; i++) {
+        const pb_result_t *r = &results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"runs\": %d, \"min_ms\": %.4f, \"median_ms\": %.4f, "
+                    "\"p99_ms\": %.4f, \"mean_ms\": %.4f, \"check\": \"%08lx\"}%s\n",
+                r->name, r->runs, r->min_ms, r->median_ms, r->p99_ms, r->mean_ms, (unsigned long)r->check,
+                i + 1 < n ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return ferror(fp) ? ESP_FAIL : ESP_OK;
+}
+
+void perf_bench_boot(void)
+{
+    static pb_result_t results[PB_MAX_BENCH];
+    int n = perf_bench_run(NULL, 0, results, PB_MAX_BENCH);
+    perf_bench_log(results, n);
+
+    FILE *fp = fopen(PB_RESULT_PATH, "w");
+    esp_err_t err = fp ? perf_bench_write_json(fp, results, n) : ESP_ERR_NOT_FOUND;
+    if (fp && fclose(fp) != 0) err = ESP_FAIL;
+    if (err != ESP_OK) ESP_LOGE(TAG, "Cannot write %s", PB_RESULT_PATH);
+    else ESP_LOGI(TAG, "%d results in %s", n, PB_RESULT_PATH);
+}
@@ -0,0 +1,60 @@
+#ifndef PERF_BENCH_H
+#define PERF_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed drawing, font and layout workloads, timed over a number of runs
+ * after one untimed warm-up. Everything draws into frames of its own, never
+ * the panel, so the same code runs on the board (CONFIG_PERF_BENCH_AT_BOOT)
+ * and on the host (host/sim/bench_main.c). Fonts and the BMP come from
+ * /sdcard as in the firmware.
+ *
+ * The results go to JSON, which tools/bench_compare.py checks against a
+ * baseline. A check value of what a workload produced (the CRC of the frame,
+ * a hash of the line breaks) is reported with the times: when it changes,
+ * the output changed, not only the speed. The first workload,
+ * PB_CALIBRATION, only computes a CRC; the comparison takes the other times
+ * as multiples of it, so that results of a faster or busier machine can
+ * still be set against a baseline.
+ */
+
+#define PB_MAX_BENCH        16
+#define PB_MAX_RUNS         200
+#define PB_BMP_PATH         "/sdcard/bench/bench.bmp"   // Written by the suite when missing
+#define PB_RESULT_PATH      "/sdcard/bench/result.json"
+#define PB_LAYOUT_BYTES     (1024 * 1024)
+#define PB_CALIBRATION      "calibration"           // Runs with any filter
+
+typedef struct {
+    const char *name;
+    int runs;
+    double min_ms;
+    double median_ms;
+    double p99_ms;              // Nearest rank, the maximum below 100 runs
+    double mean_ms;
+    uint32_t check;             // Of the output of the last run
+} pb_result_t;
+
+// Run the calibration and the workloads whose name contains filter (NULL:
+// all). runs 0 keeps each one's own count. Returns the number of results,
+// workloads that cannot run (no card, no memory) are left out with a warning.
+int perf_bench_run(const char *filter, int runs, pb_result_t *results, int max);
+
+void perf_bench_log(const pb_result_t *results, int n);
+esp_err_t perf_bench_write_json(FILE *fp, const pb_result_t *results, int n);
+
+// Run everything, log the table and write PB_RESULT_PATH. Needs the card.
+void perf_bench_boot(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
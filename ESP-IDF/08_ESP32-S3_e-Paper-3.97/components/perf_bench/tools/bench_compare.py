@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Checks perf_bench results (host: epaper_bench --out, board:
+/sdcard/bench/result.json) against a baseline from the same target.
+
+The check values are what gates: they do not depend on timing, so one that
+differs from the baseline, or varies between the result files, means the
+workload drew something else and fails. A rendering change comes with a new
+baseline (--update).
+
+Times are compared as multiples of the "calibration" workload of the same
+run, a CRC loop that touches no card and no frame, so a machine that is
+faster or busier as a whole moves every benchmark alike and it cancels out.
+What is left still varies with the machine and its load, so by default the
+deltas are only reported. With --gate-timing a benchmark fails when its
+median or p99 is slower than the baseline by more than the relative
+tolerance AND by more than --abs-ms. That is meant for a baseline captured
+on the same machine just before, e.g. with and without a change:
+
+    bench_compare.py before.json local.json --update
+    bench_compare.py after.json local.json --gate-timing
+
+Several result files of the same target may be given, each benchmark is
+then taken at the median of the files: on a shared host a single run can be
+slowed down as a whole.
+
+Tolerances come from the command line, or from a "tolerance" object in the
+baseline, either top-level or per benchmark:
+
+    "tolerance": {"median": 0.10, "p99": 0.40, "abs_ms": 0.05}
+
+--update writes the results over the baseline, keeping its tolerances.
+Exits 1 on a changed check value, a missing benchmark, or with
+--gate-timing a slower one.
+
+Usage: bench_compare.py RESULT [RESULT...] BASELINE [--median 0.10]
+                        [--p99 0.40] [--abs-ms 0.05] [--gate-timing] [--update]
+"""
+
+import argparse
+import json
+import statistics
+import sys
+
+DEFAULTS = {"median": 0.10, "p99": 0.40, "abs_ms": 0.05}
+CALIBRATION = "calibration"
+TIMES = ("min_ms", "median_ms", "p99_ms", "mean_ms")
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        return json.load(f)
+
+
+def merge(docs):
+    """One result document from several runs, field by field at the median."""
+    targets = {d.get("target") for d in docs}
+    if len(targets) > 1:
+        raise SystemExit("results of different targets: %s" % ", ".join(sorted(map(str, targets))))
+    runs = {}
+    order = []
+    for d in docs:
+        for b in d["benches"]:
+            if b["name"] not in runs:
+                order.append(b["name"])
+            runs.setdefault(b["name"], []).append(b)
+    benches = []
+    for name in order:
+        entries = runs[name]
+        merged = dict(entries[-1])
+        for field in TIMES:
+            merged[field] = round(statistics.median(e[field] for e in entries), 4)
+        checks = {e.get("check") for e in entries}
+        if len(checks) > 1:
+            merged["check"] = "varies"
+        benches.append(merged)
+    return {"target": docs[0].get("target"), "benches": benches}
+
+
+def tolerance(base_doc, bench, args):
+    tol = dict(DEFAULTS)
+    tol.update(base_doc.get("tolerance", {}))
+    tol.update(bench.get("tolerance", {}))
+    for key in DEFAULTS:
+        v = getattr(args, key)
+        if v is not None:
+            tol[key] = v
+    return tol
+
+
+def calibration_scale(current, baseline):
+    """Factor that takes the current times to the speed of the baseline's machine, None without calibration."""
+    cur, base = current.get(CALIBRATION), baseline.get(CALIBRATION)
+    if not cur or not base or cur["median_ms"] <= 0:
+        return None
+    return base["median_ms"] / cur["median_ms"]
+
+
+def compare(cur, base, tol):
+    """Timing regressions and notes for one benchmark, cur already scaled."""
+    slower, notes = [], []
+    for field, key in (("median_ms", "median"), ("p99_ms", "p99")):
+        c, b = cur[field], base[field]
+        if c > b * (1 + tol[key]) and c - b > tol["abs_ms"]:
+            slower.append("%s %.3f ms, baseline %.3f (+%.0f%%, limit %.0f%%)"
+                          % (key, c, b, (c / b - 1) * 100 if b else 0, tol[key] * 100))
+    c, b = cur["median_ms"], base["median_ms"]
+    if c < b * (1 - tol["median"]) and b - c > tol["abs_ms"]:
+        notes.append("median %.3f ms, baseline %.3f (%.0f%%), consider --update" % (c, b, (c / b - 1) * 100))
+    return slower, notes
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("result", nargs="+")
+    ap.add_argument("baseline")
+    ap.add_argument("--median", type=float, help="relative median tolerance (default %.2f)" % DEFAULTS["median"])
+    ap.add_argument("--p99", type=float, help="relative p99 tolerance (default %.2f)" % DEFAULTS["p99"])
+    ap.add_argument("--abs-ms", dest="abs_ms", type=float,
+                    help="differences below this are ignored (default %.2f)" % DEFAULTS["abs_ms"])
+    ap.add_argument("--gate-timing", dest="gate_timing", action="store_true",
+                    help="fail on slower times too, against a baseline captured on this machine")
+    ap.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    args = ap.parse_args()
+
+    result = merge([load(p) for p in args.result])
+    try:
+        base_doc = load(args.baseline)
+    except FileNotFoundError:
+        base_doc = None
+
+    if args.update:
+        doc = {"target": result["target"]}
+        if base_doc and "tolerance" in base_doc:
+            doc["tolerance"] = base_doc["tolerance"]
+        old = {b["name"]: b for b in base_doc["benches"]} if base_doc else {}
+        doc["benches"] = []
+        for b in result["benches"]:
+            entry = dict(b)
+            if "tolerance" in old.get(b["name"], {}):
+                entry["tolerance"] = old[b["name"]]["tolerance"]
+            doc["benches"].append(entry)
+        with open(args.baseline, "w", encoding="utf-8") as f:
+            json.dump(doc, f, indent=2)
+            f.write("\n")
+        print("%s: %d benchmarks written" % (args.baseline, len(doc["benches"])))
+        return 0
+    if base_doc is None:
+        print("no baseline %s, create it with --update" % args.baseline, file=sys.stderr)
+        return 1
+
+    if result.get("target") != base_doc.get("target"):
+        print("warning: results of %s against a baseline of %s"
+              % (result.get("target"), base_doc.get("target")), file=sys.stderr)
+
+    current = {b["name"]: b for b in result["benches"]}
+    baseline = {b["name"]: b for b in base_doc["benches"]}
+    scale = calibration_scale(current, baseline)
+    if scale is None:
+        print("note no %s in both, times compared as they are" % CALIBRATION)
+        scale = 1.0
+    else:
+        print("note times scaled by %.3f: %s %.3f ms, baseline %.3f"
+              % (scale, CALIBRATION, current[CALIBRATION]["median_ms"], baseline[CALIBRATION]["median_ms"]))
+    failed = False
+    for base in base_doc["benches"]:
+        name = base["name"]
+        cur = current.pop(name, None)
+        if cur is None:
+            print("FAIL %-16s missing from the results" % name)
+            failed = True
+            continue
+        problems = []
+        if cur.get("check") != base.get("check"):
+            problems.append("output changed, check %s, baseline %s" % (cur.get("check"), base.get("check")))
+        slower, notes = [], []
+        if name != CALIBRATION:
+            scaled = dict(cur)
+            for field in TIMES:
+                scaled[field] = cur[field] * scale
+            slower, notes = compare(scaled, base, tolerance(base_doc, base, args))
+        if args.gate_timing:
+            problems += slower
+            slower = []
+        for p in problems:
+            print("FAIL %-16s %s" % (name, p))
+        for p in slower:
+            print("slow %-16s %s" % (name, p))
+        for n in notes:
+            print("note %-16s %s" % (name, n))
+        if not problems and not slower and not notes:
+            median = cur["median_ms"] * (scale if name != CALIBRATION else 1.0)
+            print("ok   %-16s median %.3f ms, baseline %.3f (%+.0f%%)"
+                  % (name, median, base["median_ms"], (median / base["median_ms"] - 1) * 100 if base["median_ms"] else 0))
+        failed |= bool(problems)
+    for name in current:
+        print("note %-16s not in the baseline" % name)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,166 @@
+#include "perf_trace.h"
+
+#ifdef CONFIG_PERF_TRACE_ENABLE
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_private/esp_clk.h"
+
+static const char *TAG = "perf_trace";
+
+#define TRACE_MAX_TASKS     32
+#define TRACE_SYNC_TICKS    pdMS_TO_TICKS(1000)     // Well inside a cycle counter wrap (27 s at 160 MHz)
+
+static const char *const point_names[TRACE_POINT_COUNT] = {
+    "sync",
+#define TRACE_POINT_NAME(id, name) name,
+    TRACE_POINTS(TRACE_POINT_NAME)
+#undef TRACE_POINT_NAME
+};
+
+typedef struct {
+    TaskHandle_t handle;
+    char name[configMAX_TASK_NAME_LEN];
+} trace_task_t;
+
+static trace_ring_t rings[portNUM_PROCESSORS];
+static TickType_t last_sync[portNUM_PROCESSORS];
+static uint32_t sync_head[portNUM_PROCESSORS];      // Ring head after the last sync
+static bool synced[portNUM_PROCESSORS];
+static volatile bool recording = false;
+
+static trace_task_t tasks[TRACE_MAX_TASKS];
+static volatile int task_count = 0;
+static portMUX_TYPE task_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t trace_start(void)
+{
+    size_t capacity = CONFIG_PERF_TRACE_BUFFER_KB * 1024 / sizeof(trace_event_t);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (rings[core].events == NULL) {
+            trace_event_t *mem = heap_caps_malloc(capacity * sizeof(trace_event_t), MALLOC_CAP_SPIRAM);
+            if (mem == NULL) {
+                ESP_LOGE(TAG, "No PSRAM for the trace ring of core %d", core);
+                return ESP_ERR_NO_MEM;
+            }
+            trace_ring_init(&rings[core], mem, capacity);
+        }
+        synced[core] = false;
+    }
+    recording = true;
+    ESP_LOGI(TAG, "Recording, %u events per core", (unsigned)(rings[0].mask + 1));
+    return ESP_OK;
+}
+
+// Index of the calling task in the table, registered on its first event
+static uint8_t trace_task_index(void)
+{
+    if (xPortInIsrContext()) {
+        return TRACE_TASK_ISR;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    int count = task_count;
+    for (int i = 0; i < count; i++) {
+        if (tasks[i].handle == self) {
+            return (uint8_t)i;
+        }
+    }
+    // Tasks created per job (the reader's preloaders) come back under the same name
+    const char *name = pcTaskGetName(NULL);
+    uint8_t index = TRACE_TASK_OTHER;
+    taskENTER_CRITICAL(&task_lock);
+    for (int i = 0; i < task_count; i++) {
+        if (strcmp(tasks[i].name, name) == 0) {
+            tasks[i].handle = self;
+            index = (uint8_t)i;
+            break;
+        }
+    }
+    if (index == TRACE_TASK_OTHER && task_count < TRACE_MAX_TASKS) {
+        index = (uint8_t)task_count;
+        snprintf(tasks[index].name, sizeof(tasks[index].name), "%s", name);
+        tasks[index].handle = self;
+        task_count++;
+    }
+    taskEXIT_CRITICAL(&task_lock);
+    return index;
+}
+
+void trace_event(uint16_t id, uint8_t type, int32_t value)
+{
+    if (!recording) {
+        return;
+    }
+    trace_event_t ev = { .id = id, .type = type, .task = trace_task_index(), .value = value };
+
+    // Masking interrupts keeps the task on this core and the ring to itself
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (!recording) {
+        // A dump began while this task was preempted
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+        return;
+    }
+    int core = esp_cpu_get_core_id();
+    trace_ring_t *ring = &rings[core];
+    TickType_t now = xPortInIsrContext() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+    // Twice per ring as well, so a ring that wrapped still holds a sync to place its events from
+    if (!synced[core] || now - last_sync[core] >= TRACE_SYNC_TICKS || ring->head - sync_head[core] > ring->mask / 2) {
+        // Ties this core's cycle counter to the microsecond clock
+        trace_event_t sync = { .cycles = esp_cpu_get_cycle_count(), .id = TRACE_SYNC_POINT, .type = TRACE_EV_SYNC,
+                               .task = ev.task, .value = (int32_t)(uint32_t)esp_timer_get_time() };
+        trace_ring_push(ring, &sync);
+        last_sync[core] = now;
+        sync_head[core] = ring->head;
+        synced[core] = true;
+    }
+    ev.cycles = esp_cpu_get_cycle_count();
+    trace_ring_push(ring, &ev);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+esp_err_t trace_dump(const char *path)
+{
+    if (rings[0].events == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // An event being written on the other core finishes with interrupts masked
+    recording = false;
+    vTaskDelay(1);
+
+    esp_err_t ret = ESP_OK;
+    int64_t start = esp_timer_get_time();
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Cannot create %s", path);
+        ret = ESP_FAIL;
+    } else {
+        const char *task_names[TRACE_MAX_TASKS];
+        int count = task_count;
+        for (int i = 0; i < count; i++) {
+            task_names[i] = tasks[i].name;
+        }
+        if (trace_dump_write(f, esp_clk_cpu_freq(), point_names, TRACE_POINT_COUNT,
+                             task_names, count, rings, portNUM_PROCESSORS) != 0) {
+            ESP_LOGE(TAG, "Writing %s failed", path);
+            ret = ESP_FAIL;
+        }
+        fclose(f);
+    }
+    if (ret == ESP_OK) {
+        uint32_t events = 0;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            events += trace_ring_count(&rings[core]);
+        }
+        ESP_LOGI(TAG, "%s: %lu events in %lld ms", path, (unsigned long)events, (long long)((esp_timer_get_time() - start) / 1000));
+    }
+    recording = true;
+    return ret;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef PERF_TRACE_H
+#define PERF_TRACE_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "trace_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Begin/end spans, counters and instants, recorded with the CPU cycle
+ * counter into one PSRAM ring per core, the oldest overwritten. A dump
+ * (trace_dump()) is turned into Chrome/Perfetto JSON by
+ * tools/trace2json.py. Spans nest per task, so a span must end in the task
+ * that began it.
+ *
+ * Without CONFIG_PERF_TRACE_ENABLE every macro is empty and nothing is linked.
+ */
+
+#ifndef CONFIG_PERF_TRACE_BUFFER_KB
+#define CONFIG_PERF_TRACE_BUFFER_KB     256
+#endif
+
+#define TRACE_DUMP_PATH     "/sdcard/trace.bin"
+
+// Trace points: enum name, name in the trace
+#define TRACE_POINTS(X) \
+    X(EPD_RESET,        "epd.reset")        \
+    X(EPD_SPI,          "epd.spi")          \
+    X(EPD_BUSY,         "epd.busy")         \
+    X(FONT_FETCH,       "font.fetch")       \
+    X(FONT_READ,        "font.read")        \
+    X(SD_READ,          "sd.read")          \
+    X(SD_WRITE,         "sd.write")         \
+    X(I2C_XFER,         "i2c.xfer")         \
+    X(I2C_WAIT_US,      "i2c.wait_us")      \
+    X(AUDIO_WRITE,      "audio.write")      \
+    X(FICTION_TURN,     "fiction.turn")     \
+    X(FICTION_LAYOUT,   "fiction.layout")   \
+    X(FICTION_READ,     "fiction.read")     \
+    X(FICTION_PAINT,    "fiction.paint")    \
+    X(FICTION_PRELOAD,  "fiction.preload")  \
+    X(PAGE,             "page")
+
+typedef enum {
+    TRACE_SYNC_POINT = 0,
+#define TRACE_POINT_ENUM(id, name) TRACE_##id,
+    TRACE_POINTS(TRACE_POINT_ENUM)
+#undef TRACE_POINT_ENUM
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+#ifdef CONFIG_PERF_TRACE_ENABLE
+
+// Allocates the rings and starts recording
+esp_err_t trace_start(void);
+void trace_event(uint16_t id, uint8_t type, int32_t value);
+// Writes what the rings hold to path, recording pauses meanwhile
+esp_err_t trace_dump(const char *path);
+
+#define TRACE_BEGIN(id)             trace_event(TRACE_##id, TRACE_EV_BEGIN, 0)
+#define TRACE_BEGIN_ARG(id, arg)    trace_event(TRACE_##id, TRACE_EV_BEGIN, (int32_t)(arg))
+#define TRACE_END(id)               trace_event(TRACE_##id, TRACE_EV_END, 0)
+#define TRACE_COUNTER(id, value)    trace_event(TRACE_##id, TRACE_EV_COUNTER, (int32_t)(value))
+#define TRACE_INSTANT(id, arg)      trace_event(TRACE_##id, TRACE_EV_INSTANT, (int32_t)(arg))
+#define TRACE_DUMP()                trace_dump(TRACE_DUMP_PATH)
+
+#else
+
+static inline esp_err_t trace_start(void) { return ESP_OK; }
+#define TRACE_BEGIN(id)             ((void)0)
+#define TRACE_BEGIN_ARG(id, arg)    ((void)0)
+#define TRACE_END(id)               ((void)0)
+#define TRACE_COUNTER(id, value)    ((void)0)
+#define TRACE_INSTANT(id, arg)      ((void)0)
+#define TRACE_DUMP()                ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Turns a perf_trace dump (/sdcard/trace.bin) into Chrome trace JSON, for
+chrome://tracing or https://ui.perfetto.dev.
+
+Each core's events carry that core's cycle counter. Sync events, written at
+least once a second and twice per ring, pair it with the microsecond clock, so each event is
+placed from the last sync before it on its core. Events older than the first
+sync left in a ring cannot be placed and are dropped, as are span ends
+whose begin was overwritten.
+
+Threads are FreeRTOS tasks; counters appear as tracks of their own. With
+--summary the count, total, mean and longest duration of every span are
+printed as well.
+
+Usage: trace2json.py trace.bin [-o trace.json] [--summary]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x31435254
+HEADER = struct.Struct("<IHHIHHHH")
+EVENT = struct.Struct("<IHBBi")
+TASK_ISR = 0xFF
+TASK_OTHER = 0xFE
+
+
+def read_names(data, pos, count):
+    names = []
+    for _ in range(count):
+        n = data[pos]
+        names.append(data[pos + 1:pos + 1 + n].decode("utf-8", "replace"))
+        pos += 1 + n
+    return names, pos
+
+
+def parse(data):
+    """Returns (cpu_hz, point names, task names, [[(cycles, id, type, task, value)] per core])"""
+    if len(data) < HEADER.size:
+        raise ValueError("too short for a trace dump")
+    magic, version, event_size, cpu_hz, points, tasks, cores, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != 1 or event_size != EVENT.size:
+        raise ValueError("not a version 1 trace dump")
+    pos = HEADER.size
+    point_names, pos = read_names(data, pos, points)
+    task_names, pos = read_names(data, pos, tasks)
+    rings = []
+    for _ in range(cores):
+        count, _written = struct.unpack_from("<II", data, pos)
+        pos += 8
+        if pos + count * EVENT.size > len(data):
+            raise ValueError("dump is truncated")
+        rings.append([EVENT.unpack_from(data, pos + i * EVENT.size) for i in range(count)])
+        pos += count * EVENT.size
+    return cpu_hz, point_names, task_names, rings
+
+
+def signed32(v):
+    v &= 0xFFFFFFFF
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def place(cpu_hz, rings):
+    """Events as (us, core, id, type, task, value) in time order, and how many could not be placed"""
+    mhz = cpu_hz / 1e6
+    placed, dropped = [], 0
+    ref = None                          # (first sync value seen, its 64-bit microseconds)
+    for core, events in enumerate(rings):
+        sync = None                     # (cycles, us)
+        for cycles, pid, typ, task, value in events:
+            if typ == ord("S"):
+                raw = value & 0xFFFFFFFF
+                if sync is None:
+                    if ref is None:
+                        ref = (raw, raw)
+                    us = ref[1] + signed32(raw - ref[0])
+                else:
+                    us = sync_raw_us + signed32(raw - sync_raw)
+                sync, sync_raw, sync_raw_us = (cycles, us), raw, us
+                continue
+            if sync is None:
+                dropped += 1
+                continue
+            us = sync[1] + ((cycles - sync[0]) & 0xFFFFFFFF) / mhz
+            placed.append((us, core, pid, typ, task, value))
+    placed.sort(key=lambda e: e[0])
+    return placed, dropped
+
+
+def convert(data):
+    """Returns (chrome trace dict, span stats {name: [durations us]}, dropped events)"""
+    cpu_hz, point_names, task_names, rings = parse(data)
+    placed, dropped = place(cpu_hz, rings)
+    t0 = placed[0][0] if placed else 0.0
+
+    def name_of(pid):
+        return point_names[pid] if pid < len(point_names) else "point%d" % pid
+
+    out, open_spans, stats = [], {}, {}
+    used_tasks = set()
+    for us, core, pid, typ, task, value in placed:
+        ts = round(us - t0, 3)
+        name = name_of(pid)
+        ph = chr(typ)
+        if ph == "C":
+            out.append({"name": name, "ph": "C", "ts": ts, "pid": 1, "args": {name: value}})
+            continue
+        used_tasks.add(task)
+        ev = {"name": name, "ph": ph, "ts": ts, "pid": 1, "tid": task}
+        if ph == "B":
+            open_spans.setdefault((task, pid), []).append(us)
+            ev["args"] = {"core": core} if value == 0 else {"core": core, "arg": value}
+        elif ph == "E":
+            begun = open_spans.get((task, pid))
+            if not begun:
+                dropped += 1
+                continue
+            stats.setdefault(name, []).append(us - begun.pop())
+        elif ph == "i":
+            ev["s"] = "t"
+            ev["args"] = {"core": core, "arg": value}
+        out.append(ev)
+
+    meta = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "ESP32-S3"}}]
+    for task in sorted(used_tasks):
+        if task == TASK_ISR:
+            name = "ISR"
+        elif task == TASK_OTHER:
+            name = "other tasks"
+        else:
+            name = task_names[task] if task < len(task_names) else "task%d" % task
+        meta.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": task, "args": {"name": name}})
+    trace = {"traceEvents": meta + out, "displayTimeUnit": "ms",
+             "otherData": {"cpu_hz": cpu_hz, "dropped": dropped}}
+    return trace, stats, dropped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="perf_trace dump to Chrome trace JSON")
+    parser.add_argument("dump")
+    parser.add_argument("-o", "--output", help="default: the dump name with .json")
+    parser.add_argument("--summary", action="store_true", help="print span durations")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+    try:
+        trace, stats, dropped = convert(data)
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.dump, e))
+    output = args.output or args.dump.rsplit(".", 1)[0] + ".json"
+    with open(output, "w") as f:
+        json.dump(trace, f, separators=(",", ":"))
+    print("%s: %d events, %d dropped" % (output, len(trace["traceEvents"]), dropped))
+
+    if args.summary:
+        print("%-18s %7s %10s %9s %9s" % ("span", "count", "total ms", "mean ms", "max ms"))
+        for name, d in sorted(stats.items(), key=lambda kv: -sum(kv[1])):
+            print("%-18s %7d %10.1f %9.2f %9.2f" % (name, len(d), sum(d) / 1000, sum(d) / len(d) / 1000, max(d) / 1000))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#include "trace_ring.h"
+#include <string.h>
+
+void trace_ring_init(trace_ring_t *ring, trace_event_t *mem, uint32_t capacity)
+{
+    uint32_t size = 1;
+    while (size * 2 <= capacity && size * 2 != 0) {
+        size *= 2;
+    }
+    ring->events = mem;
+    ring->mask = capacity ? size - 1 : 0;
+    ring->head = 0;
+    ring->full = false;
+}
+
+uint32_t trace_ring_count(const trace_ring_t *ring)
+{
+    if (ring->events == NULL) {
+        return 0;
+    }
+    return ring->full ? ring->mask + 1 : ring->head & ring->mask;
+}
+
+uint32_t trace_ring_read(const trace_ring_t *ring, trace_event_t *out, uint32_t max)
+{
+    uint32_t count = trace_ring_count(ring);
+    uint32_t first = ring->head - count;
+    if (count > max) {
+        first += count - max;
+        count = max;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = ring->events[(first + i) & ring->mask];
+    }
+    return count;
+}
+
+static int write_names(FILE *f, const char *const *names, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const char *name = names[i] ? names[i] : "";
+        size_t len = strlen(name);
+        uint8_t n = len > 255 ? 255 : (uint8_t)len;
+        if (fwrite(&n, 1, 1, f) != 1 || fwrite(name, 1, n, f) != n) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int trace_dump_write(FILE *f, uint32_t cpu_hz,
+                     const char *const *points, int point_count,
+                     const char *const *tasks, int task_count,
+                     const trace_ring_t *rings, int ring_count)
+{
+    trace_dump_header_t header = {
+        .magic = TRACE_DUMP_MAGIC,
+        .version = TRACE_DUMP_VERSION,
+        .event_size = sizeof(trace_event_t),
+        .cpu_hz = cpu_hz,
+        .points = (uint16_t)point_count,
+        .tasks = (uint16_t)task_count,
+        .cores = (uint16_t)ring_count,
+    };
+    if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+        write_names(f, points, point_count) != 0 || write_names(f, tasks, task_count) != 0) {
+        return -1;
+    }
+    for (int c = 0; c < ring_count; c++) {
+        const trace_ring_t *ring = &rings[c];
+        uint32_t count = trace_ring_count(ring);
+        if (fwrite(&count, 4, 1, f) != 1 || fwrite(&ring->head, 4, 1, f) != 1) {
+            return -1;
+        }
+        if (count == 0) {
+            continue;
+        }
+        // Straight from the ring, in at most two pieces
+        uint32_t first = (ring->head - count) & ring->mask;
+        uint32_t run = count < ring->mask + 1 - first ? count : ring->mask + 1 - first;
+        if (fwrite(&ring->events[first], sizeof(trace_event_t), run, f) != run ||
+            fwrite(&ring->events[0], sizeof(trace_event_t), count - run, f) != count - run) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Event ring and dump file of the trace recorder. One ring per core, each
+ * written only by its own core, the oldest events overwritten.
+ * No ESP-IDF dependency so it can be checked on the host.
+ *
+ * Dump, little endian:
+ *   trace_dump_header_t
+ *   point names, then task names: a length byte and the name each
+ *   per core: uint32 events, uint32 events written (mod 2^32), the events oldest first
+ */
+
+#define TRACE_DUMP_MAGIC    0x31435254      // "TRC1"
+#define TRACE_DUMP_VERSION  1
+
+#define TRACE_EV_BEGIN      'B'
+#define TRACE_EV_END        'E'
+#define TRACE_EV_COUNTER    'C'
+#define TRACE_EV_INSTANT    'i'
+#define TRACE_EV_SYNC       'S'             // value: microsecond clock, low 32 bits
+
+#define TRACE_TASK_ISR      0xFF
+#define TRACE_TASK_OTHER    0xFE            // The task table was full
+
+typedef struct __attribute__((packed)) {
+    uint32_t cycles;        // CPU cycle counter of the core that wrote it
+    uint16_t id;            // Trace point
+    uint8_t type;           // TRACE_EV_*
+    uint8_t task;           // Index in the task table
+    int32_t value;          // Counter value or span argument
+} trace_event_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t event_size;
+    uint32_t cpu_hz;
+    uint16_t points;
+    uint16_t tasks;
+    uint16_t cores;
+    uint16_t reserved;
+} trace_dump_header_t;
+
+typedef struct {
+    trace_event_t *events;
+    uint32_t mask;          // Capacity - 1
+    uint32_t head;          // Events written since the ring was set up, mod 2^32
+    bool full;              // Every slot written, so head alone does not tell
+} trace_ring_t;
+
+// Capacity is rounded down to a power of two
+void trace_ring_init(trace_ring_t *ring, trace_event_t *mem, uint32_t capacity);
+
+static inline void trace_ring_push(trace_ring_t *ring, const trace_event_t *ev)
+{
+    ring->events[ring->head & ring->mask] = *ev;
+    ring->head++;
+    if ((ring->head & ring->mask) == 0) {
+        ring->full = true;
+    }
+}
+
+// Events held, at most the capacity
+uint32_t trace_ring_count(const trace_ring_t *ring);
+
+// Copy up to max events, oldest first. Returns the number copied.
+uint32_t trace_ring_read(const trace_ring_t *ring, trace_event_t *out, uint32_t max);
+
+// Returns 0, or -1 if a write failed
+int trace_dump_write(FILE *f, uint32_t cpu_hz,
+                     const char *const *points, int point_count,
+                     const char *const *tasks, int task_count,
+                     const trace_ring_t *rings, int ring_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,7 +5,10 @@
 #include "esp_timer.h"
 #include "esp_rom_sys.h"
 #include <stdio.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 
 static const char *TAG = "QMI8658";
@@ -55,11 +58,25 @@ unsigned char QMI8658_read_reg(unsigned char reg, unsigned char *buf, unsigned s
 
 
 
-// ISR callback function (reserved)
+// FIFO streaming state
+static SemaphoreHandle_t fifo_sem = NULL;
+static TaskHandle_t fifo_task_handle = NULL;
+static volatile bool fifo_running = false;
+static unsigned char fifo_ctrl = QMI8658Fifo_Bypass;
+static qmi8658_fifo_cb_t fifo_cb[QMI8658_FIFO_MAX_CONSUMERS];
+static void *fifo_cb_arg[QMI8658_FIFO_MAX_CONSUMERS];
+
+// ISR callback function, wakes the FIFO task on the watermark interrupt
 void IRAM_ATTR DOF_INT1_isr_handler(void* arg) {
+	BaseType_t woken = pdFALSE;
+	if (fifo_sem) xSemaphoreGiveFromISR(fifo_sem, &woken);
+	if (woken) portYIELD_FROM_ISR();
 }
 
 void IRAM_ATTR DOF_INT2_isr_handler(void* arg) {
+	BaseType_t woken = pdFALSE;
+	if (fifo_sem) xSemaphoreGiveFromISR(fifo_sem, &woken);
+	if (woken) portYIELD_FROM_ISR();
 }
 
 void qmi8658_gpio_int_init(void)
@@ -480,22 +497,35 @@ void QMI8658_read_ae(float quat[4], float velocity[3])
 	velocity[2] = (float)(raw_v_xyz[2] * 1.0f) / ae_v_lsb_div;
 }
 
-void QMI8658_doCtrl9Command(enum QMI8658_Ctrl9Command cmd)
+/*!
+ * \brief Send a CTRL9 command and wait for the handshake (CmdDone in StatusInt, then NOP ack).
+ * \returns 1 on success, 0 on timeout.
+ */
+static unsigned char QMI8658_doCtrl9Command(enum QMI8658_Ctrl9Command cmd)
 {
-	uint8_t val;
+	unsigned char val = 0;
+	int retry;
 
 	QMI8658_write_reg(QMI8658Register_Ctrl9, cmd);
-	qmi8658_gpio_int_init();
-	
-	while (1)
+	for (retry = 0; retry < 100; retry++)
 	{
-		val = QMI8658_readStatus1();
-		printf("3 :%d \r\n",val);
-		printf("1 :%d \r\n",gpio_get_level(DOF_INT1));
-		if (val & 0x04)
+		if (QMI8658_read_reg(QMI8658Register_StatusInt, &val, 1) && (val & 0x80))
 			break;
-		vTaskDelay(pdMS_TO_TICKS(10));
+		vTaskDelay(pdMS_TO_TICKS(1));
 	}
+	if (retry >= 100)
+	{
+		ESP_LOGE(TAG, "ctrl9 cmd 0x%02x timeout", cmd);
+		return 0;
+	}
+	QMI8658_write_reg(QMI8658Register_Ctrl9, QMI8658_Ctrl9_Cmd_NOP);
+	for (retry = 0; retry < 100; retry++)
+	{
+		if (QMI8658_read_reg(QMI8658Register_StatusInt, &val, 1) && !(val & 0x80))
+			return 1;
+		vTaskDelay(pdMS_TO_TICKS(1));
+	}
+	return 0;
 }
 
 void QMI8658_enableWakeOnMotion(void)
@@ -518,7 +548,9 @@ void QMI8658_enableWakeOnMotion(void)
 
 	
 
-	QMI8658_doCtrl9Command(QMI8658_Ctrl9_Cmd_WoM_Setting);
+	qmi8658_gpio_int_init();
+	if (!QMI8658_doCtrl9Command(QMI8658_Ctrl9_Cmd_WoM_Setting))
+		return;
 	QMI8658_enableSensors(QMI8658_CTRL7_ACC_ENABLE);
 
 }
@@ -636,3 +668,220 @@ unsigned char QMI8658_init(void)
 	}
 	// return QMI8658_chip_id;
 }
+
+
+/*!
+ * \brief Decode a FIFO dump holding interleaved accelerometer/gyroscope frames.
+ * \param buf        raw FIFO bytes, each frame is 6 bytes acc + 6 bytes gyro (LSB first)
+ * \param acc_shift  log2 of the accelerometer LSB/g
+ * \param gyro_shift log2 of the gyroscope LSB/dps
+ * \returns number of samples written to out.
+ *
+ * Pure function without I2C access, the conversion is done in fixed point.
+ */
+int QMI8658_fifo_decode(const uint8_t *buf, int bytes, int acc_shift, int gyro_shift, qmi8658_sample_t *out, int max)
+{
+	int count = bytes / 12;
+	if (count > max)
+		count = max;
+
+	for (int i = 0; i < count; i++)
+	{
+		const uint8_t *p = buf + i * 12;
+		int16_t raw[6];
+		for (int k = 0; k < 6; k++)
+			raw[k] = (int16_t)((uint16_t)(p[2 * k + 1] << 8) | p[2 * k]);
+
+		for (int k = 0; k < 3; k++)
+			out[i].acc_mg[k] = (int16_t)(((int32_t)raw[k] * 1000) >> acc_shift);
+		// Same axis order as QMI8658_read_xyz
+		out[i].gyro_mdps[1] = ((int32_t)raw[3] * 1000) >> gyro_shift;
+		out[i].gyro_mdps[0] = ((int32_t)raw[4] * 1000) >> gyro_shift;
+		out[i].gyro_mdps[2] = ((int32_t)raw[5] * 1000) >> gyro_shift;
+	}
+	return count;
+}
+
+/*!
+ * \brief Configure the FIFO and route its watermark interrupt.
+ * \param watermark number of samples that raises the interrupt
+ * \param pin       INT1 or INT2
+ */
+unsigned char QMI8658_config_fifo(enum QMI8658_FifoMode mode, enum QMI8658_FifoSize size, unsigned char watermark, enum QMI8658_Interrupt pin)
+{
+	unsigned char ctrl1 = 0;
+	unsigned char ctrl7 = 0;
+
+	// The FIFO may only be reconfigured with the sensors disabled
+	QMI8658_read_reg(QMI8658Register_Ctrl7, &ctrl7, 1);
+	QMI8658_enableSensors(QMI8658_CTRL7_DISABLE_ALL);
+
+	if (!QMI8658_doCtrl9Command(QMI8658_Ctrl9_Cmd_Rst_Fifo))
+	{
+		QMI8658_enableSensors(ctrl7);
+		return 0;
+	}
+
+	// CTRL1 bit2 selects INT1 for the FIFO interrupt, bit3/bit4 enable INT1/INT2
+	QMI8658_read_reg(QMI8658Register_Ctrl1, &ctrl1, 1);
+	if (mode == QMI8658Fifo_Bypass)
+		ctrl1 &= ~((1 << 2) | (1 << 3) | (1 << 4));
+	else if (pin == QMI8658_Int1)
+		ctrl1 |= (1 << 2) | (1 << 3);
+	else
+		ctrl1 = (ctrl1 & ~(1 << 2)) | (1 << 4);
+	QMI8658_write_reg(QMI8658Register_Ctrl1, ctrl1);
+
+	fifo_ctrl = (unsigned char)size | (unsigned char)mode;
+	QMI8658_write_reg(QMI8658_REG_FIFO_CTRL, fifo_ctrl);
+	QMI8658_write_reg(QMI8658_REG_FIFO_WTM_TH, watermark);
+
+	QMI8658_enableSensors(ctrl7);
+	return 1;
+}
+
+/*!
+ * \brief Read everything currently held in the FIFO.
+ * \returns number of decoded samples, 0 if empty, -1 on error.
+ *
+ * The sample count is read first, then the whole content comes out of
+ * FIFO_DATA in a single burst transaction.
+ */
+int QMI8658_read_fifo(qmi8658_sample_t *out, int max)
+{
+	static uint8_t fifo_buf[QMI8658_FIFO_MAX_SAMPLES * 12];
+	unsigned char status[2];
+	int bytes;
+
+	if ((fifo_ctrl & 0x03) == QMI8658Fifo_Bypass)
+		return -1;
+
+	// FIFO_COUNT and FIFO_STATUS, sample count in words
+	if (!QMI8658_read_reg(QMI8658_REG_FIFO_COUNT, status, 2))
+		return -1;
+	if (status[1] & QMI8658_FIFO_STATUS_OVERFLOW)
+		ESP_LOGW(TAG, "FIFO overflow, samples dropped");
+	bytes = 2 * (((status[1] & 0x03) << 8) | status[0]);
+	bytes -= bytes % 12;
+	if (bytes > (int)sizeof(fifo_buf))
+		bytes = sizeof(fifo_buf);
+	if (bytes > max * 12)
+		bytes = max * 12;
+	if (bytes <= 0)
+		return 0;
+
+	if (!QMI8658_doCtrl9Command(QMI8658_Ctrl9_Cmd_Req_Fifo))
+		return -1;
+	unsigned char ok = QMI8658_read_reg(QMI8658_REG_FIFO_DATA, fifo_buf, bytes);
+	// Leave FIFO read mode so the sensor starts filling again
+	QMI8658_write_reg(QMI8658_REG_FIFO_CTRL, fifo_ctrl);
+	if (!ok)
+		return -1;
+
+	return QMI8658_fifo_decode(fifo_buf, bytes, __builtin_ctz(acc_lsb_div), __builtin_ctz(gyro_lsb_div), out, max);
+}
+
+int QMI8658_fifo_register_consumer(qmi8658_fifo_cb_t cb, void *arg)
+{
+	for (int i = 0; i < QMI8658_FIFO_MAX_CONSUMERS; i++)
+	{
+		if (fifo_cb[i] == NULL || fifo_cb[i] == cb)
+		{
+			fifo_cb_arg[i] = arg;
+			fifo_cb[i] = cb;
+			return i;
+		}
+	}
+	return -1;
+}
+
+void QMI8658_fifo_unregister_consumer(qmi8658_fifo_cb_t cb)
+{
+	for (int i = 0; i < QMI8658_FIFO_MAX_CONSUMERS; i++)
+	{
+		if (fifo_cb[i] == cb)
+			fifo_cb[i] = NULL;
+	}
+}
+
+static void QMI8658_fifo_task(void *arg)
+{
+	static qmi8658_sample_t samples[QMI8658_FIFO_MAX_SAMPLES];
+
+	while (fifo_running)
+	{
+		// Woken by the watermark interrupt, the timeout only covers a missed edge
+		xSemaphoreTake(fifo_sem, pdMS_TO_TICKS(1000));
+		if (!fifo_running)
+			break;
+
+		int count = QMI8658_read_fifo(samples, QMI8658_FIFO_MAX_SAMPLES);
+		if (count <= 0)
+			continue;
+		for (int i = 0; i < QMI8658_FIFO_MAX_CONSUMERS; i++)
+		{
+			qmi8658_fifo_cb_t cb = fifo_cb[i];
+			if (cb)
+				cb(samples, count, fifo_cb_arg[i]);
+		}
+	}
+	fifo_task_handle = NULL;
+	vTaskDelete(NULL);
+}
+
+/*!
+ * \brief Put the FIFO in Stream mode and deliver batches to the registered consumers.
+ * \param size      FIFO depth, 16..128 samples
+ * \param watermark samples per batch
+ * \param pin       interrupt line used for the watermark
+ */
+unsigned char QMI8658_fifo_start(enum QMI8658_FifoSize size, unsigned char watermark, enum QMI8658_Interrupt pin)
+{
+	gpio_num_t gpio = (pin == QMI8658_Int1) ? DOF_INT1 : DOF_INT2;
+
+	if (fifo_running)
+		return 1;
+	if (fifo_sem == NULL)
+	{
+		fifo_sem = xSemaphoreCreateBinary();
+		if (fifo_sem == NULL)
+			return 0;
+	}
+	if (!QMI8658_config_fifo(QMI8658Fifo_Stream, size, watermark, pin))
+		return 0;
+
+	// The watermark interrupt stays high while the FIFO is at or above the watermark
+	qmi8658_gpio_int_init();
+	gpio_set_intr_type(gpio, GPIO_INTR_POSEDGE);
+	esp_err_t ret = gpio_install_isr_service(0);
+	if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+	{
+		ESP_LOGE(TAG, "Failed to install the GPIO ISR service: %s", esp_err_to_name(ret));
+		return 0;
+	}
+	gpio_isr_handler_add(gpio, (pin == QMI8658_Int1) ? DOF_INT1_isr_handler : DOF_INT2_isr_handler, (void *)gpio);
+
+	fifo_running = true;
+	if (xTaskCreate(QMI8658_fifo_task, "qmi8658_fifo", 4 * 1024, NULL, 4, &fifo_task_handle) != pdPASS)
+	{
+		fifo_running = false;
+		gpio_isr_handler_remove(gpio);
+		return 0;
+	}
+	ESP_LOGI(TAG, "FIFO stream started, watermark %d samples", watermark);
+	return 1;
+}
+
+void QMI8658_fifo_stop(void)
+{
+	if (!fifo_running)
+		return;
+	fifo_running = false;
+	xSemaphoreGive(fifo_sem);
+	while (fifo_task_handle != NULL)
+		vTaskDelay(pdMS_TO_TICKS(10));
+
+	gpio_isr_handler_remove(DOF_INT1);
+	gpio_isr_handler_remove(DOF_INT2);
+	QMI8658_config_fifo(QMI8658Fifo_Bypass, QMI8658FifoSize_16, 0, QMI8658_Int1);
+}
@@ -36,6 +36,22 @@
 #define DOF_INT1  GPIO_NUM_39  
 #define DOF_INT2  GPIO_NUM_40  
 
+// FIFO registers of the QMI8658A (the legacy FIFO entries in enum QMI8658Register do not match this part)
+#define QMI8658_REG_FIFO_WTM_TH   0x13
+#define QMI8658_REG_FIFO_CTRL     0x14
+#define QMI8658_REG_FIFO_COUNT    0x15
+#define QMI8658_REG_FIFO_STATUS   0x16
+#define QMI8658_REG_FIFO_DATA     0x17
+
+#define QMI8658_FIFO_CTRL_RD_MODE    (0x80)
+#define QMI8658_FIFO_STATUS_FULL     (0x80)
+#define QMI8658_FIFO_STATUS_WTM      (0x40)
+#define QMI8658_FIFO_STATUS_OVERFLOW (0x20)
+#define QMI8658_FIFO_STATUS_NOT_EMPTY (0x10)
+
+#define QMI8658_FIFO_MAX_SAMPLES  128
+#define QMI8658_FIFO_MAX_CONSUMERS 4
+
 enum QMI8658Register
 {
     /*! \brief FIS device identifier register. */
@@ -228,6 +244,8 @@ enum QMI8658_Ctrl9Command
     QMI8658_Ctrl9_Cmd_NOP = 0X00,
     QMI8658_Ctrl9_Cmd_GyroBias = 0X01,
     QMI8658_Ctrl9_Cmd_Rqst_Sdi_Mod = 0X03,
+    QMI8658_Ctrl9_Cmd_Rst_Fifo = 0x04,
+    QMI8658_Ctrl9_Cmd_Req_Fifo = 0x05,
     QMI8658_Ctrl9_Cmd_WoM_Setting = 0x08,
     QMI8658_Ctrl9_Cmd_AccelHostDeltaOffset = 0x09,
     QMI8658_Ctrl9_Cmd_GyroHostDeltaOffset = 0x0A,
@@ -469,6 +487,35 @@ enum QMI8658_InterruptState
     QMI8658State_low = (0 << 7)   /*!< Interrupt low. */
 };
 
+enum QMI8658_FifoMode
+{
+    QMI8658Fifo_Bypass = 0x00, /*!< \brief FIFO disabled. */
+    QMI8658Fifo_Fifo = 0x01,   /*!< \brief Stop filling when full. */
+    QMI8658Fifo_Stream = 0x02  /*!< \brief Overwrite the oldest sample when full. */
+};
+
+enum QMI8658_FifoSize
+{
+    QMI8658FifoSize_16 = 0x00 << 2,  /*!< \brief 16 samples. */
+    QMI8658FifoSize_32 = 0x01 << 2,  /*!< \brief 32 samples. */
+    QMI8658FifoSize_64 = 0x02 << 2,  /*!< \brief 64 samples. */
+    QMI8658FifoSize_128 = 0x03 << 2  /*!< \brief 128 samples. */
+};
+
+/*!
+ * \brief One accelerometer + gyroscope sample in fixed point.
+ */
+typedef struct
+{
+    int16_t acc_mg[3];    /*!< \brief Acceleration in mg. */
+    int32_t gyro_mdps[3]; /*!< \brief Angular rate in milli-degrees per second. */
+} qmi8658_sample_t;
+
+/*!
+ * \brief Called from the FIFO task with every batch read out of the FIFO.
+ */
+typedef void (*qmi8658_fifo_cb_t)(const qmi8658_sample_t *samples, int count, void *arg);
+
 enum QMI8658_WakeOnMotionThreshold
 {
     QMI8658WomThreshold_high = 128, /*!< High threshold - large motion needed to wake. */
@@ -483,6 +530,8 @@ extern unsigned char QMI8658_write_reg(unsigned char reg, unsigned char value);
 extern unsigned char QMI8658_read_reg(unsigned char reg, unsigned char *buf, unsigned short len);
 extern unsigned char QMI8658_init(void);
 extern void QMI8658_Config_apply(struct QMI8658Config const *config);
+extern void QMI8658_config_acc(enum QMI8658_AccRange range, enum QMI8658_AccOdr odr, enum QMI8658_LpfConfig lpfEnable, enum QMI8658_StConfig stEnable);
+extern void QMI8658_config_gyro(enum QMI8658_GyrRange range, enum QMI8658_GyrOdr odr, enum QMI8658_LpfConfig lpfEnable, enum QMI8658_StConfig stEnable);
 extern void QMI8658_enableSensors(unsigned char enableFlags);
 extern void QMI8658_read_acc_xyz(float acc_xyz[3]);
 extern void QMI8658_read_gyro_xyz(float gyro_xyz[3]);
@@ -495,6 +544,14 @@ extern float QMI8658_readTemp(void);
 extern void QMI8658_enableWakeOnMotion(void);
 extern void QMI8658_disableWakeOnMotion(void);
 
+extern int QMI8658_fifo_decode(const uint8_t *buf, int bytes, int acc_shift, int gyro_shift, qmi8658_sample_t *out, int max);
+extern unsigned char QMI8658_config_fifo(enum QMI8658_FifoMode mode, enum QMI8658_FifoSize size, unsigned char watermark, enum QMI8658_Interrupt pin);
+extern int QMI8658_read_fifo(qmi8658_sample_t *out, int max);
+extern int QMI8658_fifo_register_consumer(qmi8658_fifo_cb_t cb, void *arg);
+extern void QMI8658_fifo_unregister_consumer(qmi8658_fifo_cb_t cb);
+extern unsigned char QMI8658_fifo_start(enum QMI8658_FifoSize size, unsigned char watermark, enum QMI8658_Interrupt pin);
+extern void QMI8658_fifo_stop(void);
+
 #ifdef __cplusplus
 }
 #endif
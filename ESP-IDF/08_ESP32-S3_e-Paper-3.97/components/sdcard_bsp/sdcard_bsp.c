@@ -6,6 +6,7 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "ff.h"        // FatFs API
+#include "perf_trace.h"
 #include <dirent.h>
 
 
@@ -159,8 +160,10 @@ esp_err_t s_example_write_file(const char *path, char *data)
         ESP_LOGE(TAG, "Write Wrong path: %s", path);
         return ESP_ERR_NOT_FOUND;
     }
+    TRACE_BEGIN(SD_WRITE);
     fprintf(f, "%s", data);
     fclose(f);
+    TRACE_END(SD_WRITE);
     return ESP_OK;
 }
 
@@ -180,7 +183,9 @@ esp_err_t s_example_read_file(const char *path, uint8_t *pxbuf, uint32_t *outLen
     fseek(f, 0, SEEK_END);
     uint32_t unlen = ftell(f);
     fseek(f, 0, SEEK_SET);
+    TRACE_BEGIN_ARG(SD_READ, unlen);
     uint32_t poutLen = fread((void *)pxbuf, 1, unlen, f);
+    TRACE_END(SD_READ);
     *outLen = poutLen;
     fclose(f);
     return ESP_OK;
@@ -204,8 +209,10 @@ uint32_t s_example_read_from_offset(const char *path, char *buffer, uint32_t len
         ESP_LOGE(TAG, "Failed to open file: %s", path);
         return 0;
     }
+    TRACE_BEGIN_ARG(SD_READ, len);
     fseek(f, offset, SEEK_SET);
     uint32_t bytesRead = fread((void *)buffer, 1, len, f);
+    TRACE_END(SD_READ);
     fclose(f);
     return bytesRead;
 }
@@ -238,7 +245,9 @@ uint32_t s_example_wriet_from_offset(const char *path, char *buffer, uint32_t le
             ESP_LOGE(TAG, "Failed to open file: %s", path);
             return 0;
         }
+        TRACE_BEGIN_ARG(SD_WRITE, len);
         uint32_t bytesRead = fwrite((void *)buffer, 1, len, f);
+        TRACE_END(SD_WRITE);
         fclose(f);
         return bytesRead;
     }
@@ -303,7 +312,9 @@ bool sd_read_file_to_buffer(const char* path, uint8_t* buf, size_t buf_size)
     fseek(fp, 0, SEEK_SET);
 
     size_t to_read = (fsize > 0 && (size_t)fsize < buf_size) ? (size_t)fsize : buf_size;
+    TRACE_BEGIN_ARG(SD_READ, to_read);
     size_t r = fread(buf, 1, to_read, fp);
+    TRACE_END(SD_READ);
     if (r < buf_size) {
         memset(buf + r, 0xFF, buf_size - r);
     }
@@ -321,7 +332,9 @@ bool sd_write_buffer_to_file(const char* path, const uint8_t* buf, size_t buf_si
         ESP_LOGW("sdio", "The file cannot be opened for writing: %s", path);
         return false;
     }
+    TRACE_BEGIN_ARG(SD_WRITE, buf_size);
     size_t w = fwrite(buf, 1, buf_size, fp);
+    TRACE_END(SD_WRITE);
     fclose(fp);
     ESP_LOGI("sdio", "Write to SD %s <- %u bytes", path, (unsigned)w);
     return w == buf_size;
@@ -0,0 +1,475 @@
+#include "text_layout.h"
+#include <string.h>
+
+// Line breaking classes, the subset of UAX #14 the reader needs
+enum {
+    CL_AL = 0,  // Letters, symbols
+    CL_NU,      // Digits
+    CL_ID,      // Ideographs, kana, full-width letters
+    CL_SP,      // Space, tab
+    CL_BK,      // Line feed, carriage return
+    CL_GL,      // No-break space, word joiner
+    CL_ZW,      // Zero width space
+    CL_CM,      // Combining marks and other invisible characters
+    CL_OP,      // Opening brackets and quotes, never end a line
+    CL_CL,      // Closing punctuation, never start a line
+    CL_CP,      // ) ]
+    CL_EX,      // ! ?
+    CL_IS,      // , . : ;
+    CL_SY,      // /
+    CL_NS,      // Small kana, prolonged sound mark, iteration marks
+    CL_QU,      // Ambiguous quotes
+    CL_HY,      // Hyphen-minus
+    CL_BA,      // Break after: dashes, soft hyphen, ideographic space
+    CL_B2,      // Em dash, break around but not inside a pair
+    CL_IN,      // Ellipsis
+    CL_PR,      // Prefixes: currency, +
+    CL_PO,      // Postfixes: %, degree
+};
+
+#define CP_SHY      0x00AD
+
+static const uint8_t ascii_class[0x60] = {
+    //  sp     !      "      #      $      %      &      '      (      )      *      +      ,      -      .      /
+    CL_SP, CL_EX, CL_QU, CL_AL, CL_PR, CL_PO, CL_AL, CL_QU, CL_OP, CL_CP, CL_AL, CL_PR, CL_IS, CL_HY, CL_IS, CL_SY,
+    //  0-9                                                                  :      ;      <      =      >      ?
+    CL_NU, CL_NU, CL_NU, CL_NU, CL_NU, CL_NU, CL_NU, CL_NU, CL_NU, CL_NU, CL_IS, CL_IS, CL_AL, CL_AL, CL_AL, CL_EX,
+    //  @      A-O
+    CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL,
+    //  P-Z                                                                         [      \      ]      ^      _
+    CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_OP, CL_PR, CL_CP, CL_AL, CL_AL,
+    //  `      a-o
+    CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL,
+    //  p-z                                                                         {      |      }      ~      del
+    CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_AL, CL_OP, CL_BA, CL_CL, CL_AL, CL_CM,
+};
+
+// Full-width forms U+FF01-FF5E that are punctuation, the rest are ID
+static uint8_t fullwidth_class(uint32_t cp)
+{
+    switch (cp) {
+    case 0xFF01: case 0xFF1F:                               return CL_EX;   // ！？
+    case 0xFF08: case 0xFF3B: case 0xFF5B:                  return CL_OP;   // （［｛
+    case 0xFF09: case 0xFF3D: case 0xFF5D:                  return CL_CL;   // ）］｝
+    case 0xFF0C: case 0xFF0E:                               return CL_CL;   // ，．
+    case 0xFF1A: case 0xFF1B:                               return CL_NS;   // ：；
+    case 0xFF04:                                            return CL_PR;   // ＄
+    case 0xFF05:                                            return CL_PO;   // ％
+    default:                                                return CL_ID;
+    }
+}
+
+static uint8_t tl_class(uint32_t cp)
+{
+    if (cp < 0x80) {
+        if (cp == '\n' || cp == '\r') return CL_BK;
+        if (cp == '\t') return CL_SP;
+        if (cp < 0x20) return CL_CM;
+        return ascii_class[cp - 0x20];
+    }
+    if (cp >= 0x4E00 && cp <= 0x9FFF) return CL_ID;         // The common case first
+
+    if (cp >= 0x3000 && cp <= 0x30FF) {
+        switch (cp) {
+        case 0x3000:                                        return CL_BA;
+        case 0x3001: case 0x3002:                           return CL_CL;   // 、。
+        case 0x3005: case 0x303B:                           return CL_NS;   // 々〻
+        case 0x301D:                                        return CL_OP;   // 〝
+        case 0x301E: case 0x301F:                           return CL_CL;   // 〞〟
+        case 0x3041: case 0x3043: case 0x3045: case 0x3047: case 0x3049:
+        case 0x3063: case 0x3083: case 0x3085: case 0x3087: case 0x308E:
+        case 0x3095: case 0x3096:
+        case 0x30A1: case 0x30A3: case 0x30A5: case 0x30A7: case 0x30A9:
+        case 0x30C3: case 0x30E3: case 0x30E5: case 0x30E7: case 0x30EE:
+        case 0x30F5: case 0x30F6:
+        case 0x309D: case 0x309E: case 0x30FB: case 0x30FC: case 0x30FD: case 0x30FE:
+                                                            return CL_NS;   // Small kana, ・ー and iteration marks
+        default: break;
+        }
+        // 〈〉《》「」『』【】 and 〔〕〖〗〘〙〚〛 alternate open / close
+        if ((cp >= 0x3008 && cp <= 0x3011) || (cp >= 0x3014 && cp <= 0x301B))
+            return (cp & 1) ? CL_CL : CL_OP;
+        return CL_ID;
+    }
+    if (cp >= 0xFF01 && cp <= 0xFF5E) return fullwidth_class(cp);
+
+    switch (cp) {
+    case 0x00A0: case 0x202F: case 0x2060: case 0xFEFF:    return CL_GL;
+    case 0x200B:                                            return CL_ZW;
+    case 0x200C: case 0x200D:                               return CL_CM;
+    case CP_SHY: case 0x2010: case 0x2013:                  return CL_BA;
+    case 0x2014:                                            return CL_B2;
+    case 0x2025: case 0x2026:                               return CL_IN;
+    case 0x2018: case 0x201C: case 0x00A1: case 0x00BF:     return CL_OP;   // ‘“¡¿
+    case 0x201D:                                            return CL_CL;   // ”
+    case 0x2019:                                            return CL_QU;   // ’ is also the apostrophe
+    case 0x00AB: case 0x00BB: case 0x2039: case 0x203A:     return CL_QU;
+    case 0x00B7:                                            return CL_NS;   // ·
+    case 0x00A3: case 0x00A5: case 0x20AC: case 0xFFE1: case 0xFFE5:
+                                                            return CL_PR;
+    case 0x00A2: case 0x00B0: case 0x2030: case 0x2032: case 0x2033: case 0x2103: case 0xFFE0:
+                                                            return CL_PO;
+    default: break;
+    }
+    if (cp >= 0x0300 && cp <= 0x036F) return CL_CM;
+    if ((cp >= 0x2E80 && cp <= 0x2FFF) || (cp >= 0x3100 && cp <= 0x4DBF) ||
+        (cp >= 0xA000 && cp <= 0xA4CF) || (cp >= 0xAC00 && cp <= 0xD7AF) ||
+        (cp >= 0xF900 && cp <= 0xFAFF) || (cp >= 0xFE30 && cp <= 0xFE4F) ||
+        (cp >= 0xFF5F && cp <= 0xFFEF) || cp >= 0x20000)
+        return CL_ID;
+    return CL_AL;
+}
+
+static inline bool tl_invisible(uint8_t cls, uint32_t cp)
+{
+    return cls == CL_CM || cls == CL_ZW || cp == CP_SHY || cp == 0x2060 || cp == 0xFEFF;
+}
+
+static inline bool tl_alnum(uint8_t c) { return c == CL_AL || c == CL_NU; }
+
+// Break between a and b, sp when spaces separate them
+static bool tl_pair_break(uint8_t a, uint8_t b, bool sp)
+{
+    if (b == CL_SP || b == CL_ZW || b == CL_CM) return false;
+    if (a == CL_ZW) return true;
+    if (b == CL_CL || b == CL_CP || b == CL_EX || b == CL_IS || b == CL_SY) return false;
+    if (a == CL_OP) return false;
+    if ((a == CL_CL || a == CL_CP) && b == CL_NS) return false;
+    if (a == CL_B2 && b == CL_B2) return false;
+    if (sp) return true;
+
+    if (a == CL_GL || b == CL_GL) return false;
+    if (b == CL_BA || b == CL_HY || b == CL_NS || b == CL_IN) return false;
+    if (a == CL_QU || b == CL_QU) return false;
+    if (tl_alnum(a) && tl_alnum(b)) return false;
+    if (a == CL_IS && tl_alnum(b)) return false;
+    if (a == CL_PR && (tl_alnum(b) || b == CL_OP || b == CL_ID)) return false;
+    if ((tl_alnum(a) || a == CL_CL || a == CL_CP || a == CL_ID) && b == CL_PO) return false;
+    if (tl_alnum(a) && (b == CL_PR || b == CL_OP)) return false;
+    if (a == CL_CP && tl_alnum(b)) return false;
+    return true;
+}
+
+uint32_t tl_decode_utf8(const char *s, size_t avail, int *len)
+{
+    const uint8_t *u = (const uint8_t *)s;
+    int n;
+    uint32_t cp;
+
+    if (u[0] < 0x80) { *len = 1; return u[0]; }
+    if ((u[0] & 0xE0) == 0xC0)      { n = 2; cp = u[0] & 0x1F; }
+    else if ((u[0] & 0xF0) == 0xE0) { n = 3; cp = u[0] & 0x0F; }
+    else if ((u[0] & 0xF8) == 0xF0) { n = 4; cp = u[0] & 0x07; }
+    else { *len = 1; return 0xFFFD; }
+
+    for (int i = 1; i < n; i++) {
+        if ((size_t)i >= avail) { *len = 0; return 0; }
+        if ((u[i] & 0xC0) != 0x80) { *len = i; return 0xFFFD; }
+        cp = (cp << 6) | (u[i] & 0x3F);
+    }
+    *len = n;
+    return cp < 0x80 ? 0xFFFD : cp;
+}
+
+/* ---------------------------------------------------------------------------
+ * Hyphenation
+ *
+ * No dictionary: split long words between two consonants that sit between
+ * vowels (VC-CV, "win-dow", "let-ter"), never inside a digraph, keeping at
+ * least three letters on each side. Good enough for a reader, and it only
+ * runs when the line would otherwise be left loose.
+ * ------------------------------------------------------------------------- */
+
+#define TL_HYPH_MIN_WORD    6
+#define TL_HYPH_MIN_PART    3
+
+static inline bool tl_letter(uint32_t cp) { return (cp | 0x20) >= 'a' && (cp | 0x20) <= 'z'; }
+
+static inline bool tl_vowel(uint32_t cp)
+{
+    switch (cp | 0x20) {
+    case 'a': case 'e': case 'i': case 'o': case 'u': case 'y': return true;
+    default: return false;
+    }
+}
+
+static bool tl_digraph(uint32_t a, uint32_t b)
+{
+    static const char pairs[][2] = {
+        {'c','h'}, {'c','k'}, {'g','h'}, {'n','g'}, {'p','h'},
+        {'q','u'}, {'s','h'}, {'t','h'}, {'w','h'}, {'w','r'},
+    };
+    a |= 0x20; b |= 0x20;
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+        if ((uint32_t)pairs[i][0] == a && (uint32_t)pairs[i][1] == b) return true;
+    return false;
+}
+
+/* ---------------------------------------------------------------------------
+ * Breaker
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t off[TL_MAX_CHARS + 1];     // Byte offset of each character, off[n] is the end
+    uint32_t cp[TL_MAX_CHARS];
+    int16_t x[TL_MAX_CHARS];            // Pen position after the character
+    uint8_t cls[TL_MAX_CHARS];          // Class, combining marks take their base's
+    uint8_t brk[TL_MAX_CHARS + 1];      // A line may end before character i
+} tl_scan_t;
+
+static inline uint32_t tl_decode(const tl_config_t *cfg, const char *s, size_t avail, int *len)
+{
+    return cfg->decode ? cfg->decode(s, avail, len) : tl_decode_utf8(s, avail, len);
+}
+
+// Last character of [0, end) that is not a space, -1 if none
+static int tl_trim(const tl_scan_t *sc, int end)
+{
+    while (end > 0 && sc->cls[end - 1] == CL_SP) end--;
+    return end - 1;
+}
+
+// Spaces between the first and the last visible character
+static int tl_inner_spaces(const tl_scan_t *sc, int last)
+{
+    int n = 0;
+    for (int i = 0; i < last; i++)
+        if (sc->cls[i] == CL_SP) n++;
+    return n;
+}
+
+// A line must not start with character i
+static bool tl_kinsoku(const tl_scan_t *sc, int i)
+{
+    switch (sc->cls[i]) {
+    case CL_CL: case CL_CP: case CL_EX: case CL_IS: case CL_SY: case CL_NS: case CL_IN: case CL_SP:
+        return true;
+    default:
+        return sc->cls[i - 1] == CL_OP;
+    }
+}
+
+// Width of the line ending before character k with a hyphen drawn
+static int tl_hyphen_width(const tl_config_t *cfg, const tl_scan_t *sc, int k)
+{
+    int i = k - 1;
+    while (i >= 0 && tl_invisible(tl_class(sc->cp[i]), sc->cp[i])) i--;
+    return (i >= 0 ? sc->x[i] : 0) + cfg->advance(cfg->ctx, i >= 0 ? sc->cp[i] : 0, '-');
+}
+
+static int tl_find_hyphen(const tl_config_t *cfg, const tl_scan_t *sc, int n, int from, int over, int avail, int *width)
+{
+    if (!cfg->hyphenate) return -1;
+
+    int ws = from, we = over;
+    while (ws < over && !tl_letter(sc->cp[ws])) ws++;
+    for (int i = ws; i < over; i++)
+        if (!tl_letter(sc->cp[i])) return -1;
+    while (we < n && tl_letter(sc->cp[we])) we++;
+    if (we - ws < TL_HYPH_MIN_WORD) return -1;
+
+    bool upper = true;
+    for (int i = ws; i < we; i++)
+        if (sc->cp[i] >= 'a') { upper = false; break; }
+    if (upper) return -1;   // Acronyms
+
+    int kmax = we - TL_HYPH_MIN_PART < over ? we - TL_HYPH_MIN_PART : over;
+    for (int k = kmax; k >= ws + TL_HYPH_MIN_PART; k--) {
+        uint32_t c0 = sc->cp[k - 2], c1 = sc->cp[k - 1], c2 = sc->cp[k], c3 = sc->cp[k + 1];
+        if (!tl_vowel(c0) || tl_vowel(c1) || tl_vowel(c2) || !tl_vowel(c3)) continue;
+        if (tl_digraph(c1, c2)) continue;
+        int w = tl_hyphen_width(cfg, sc, k);
+        if (w <= avail) { *width = w; return k; }
+    }
+    return -1;
+}
+
+bool tl_break_line(const tl_config_t *cfg, const char *text, size_t len, size_t pos,
+                   bool eof, bool para_start, tl_line_t *line)
+{
+    static tl_scan_t sc;    // 3 KB, too big for the reader's stack
+    const int max_bytes = cfg->max_bytes > 0 ? cfg->max_bytes : TL_MAX_CHARS * 4;
+    uint32_t cp;
+    int clen;
+
+    memset(line, 0, sizeof(*line));
+
+    // Leading blanks, a paragraph's own indentation is replaced by cfg->indent
+    for (;;) {
+        if (pos >= len) return false;
+        cp = tl_decode(cfg, text + pos, len - pos, &clen);
+        if (clen == 0) {
+            if (!eof) return false;
+            clen = 1;
+            cp = 0xFFFD;
+        }
+        if (!(cp == ' ' || cp == '\t' || (para_start && (cp == 0x3000 || cp == 0x00A0)))) break;
+        pos += clen;
+    }
+    line->start = line->end = line->next = pos;
+    if (para_start) line->flags |= TL_LINE_PARA_START;
+
+    const int indent = (para_start && tl_class(cp) != CL_BK) ? cfg->indent : 0;
+    const int avail = cfg->width - indent;
+    line->indent = indent;
+
+    // Scan until the line overflows and the next break after it is known
+    int n = 0, over = -1, next_brk = -1;
+    bool hard = false;          // Line feed or end of text at n
+    size_t p = pos, hard_next = pos;
+    uint32_t prev = 0;
+    int x = 0, last_vis = -1;
+
+    sc.off[0] = pos;
+    while (n < TL_MAX_CHARS) {
+        if (p >= len) {
+            if (!eof) return false;
+            hard = true; hard_next = p;
+            break;
+        }
+        cp = tl_decode(cfg, text + p, len - p, &clen);
+        if (clen == 0) {
+            if (!eof) return false;
+            clen = 1;
+            cp = 0xFFFD;
+        }
+        uint8_t cls = tl_class(cp);
+        if (cls == CL_BK) {
+            hard = true;
+            hard_next = p + clen;
+            if (cp == '\r') {
+                if (hard_next >= len && !eof) return false;
+                if (hard_next < len && text[hard_next] == '\n') hard_next++;
+            }
+            break;
+        }
+        if (n > 0 && p + clen - pos + 1 > (size_t)max_bytes) break;   // Keep a byte for the hyphen
+
+        if (cls == CL_CM) cls = n > 0 ? sc.cls[n - 1] : CL_AL;
+        sc.cp[n] = cp;
+        sc.cls[n] = cls;
+        sc.brk[n] = 0;
+        if (n > 0 && last_vis >= 0 && tl_class(cp) != CL_CM)
+            sc.brk[n] = tl_pair_break(sc.cls[last_vis], cls, last_vis < n - 1);
+
+        if (over >= 0 && sc.brk[n]) { next_brk = n; break; }
+
+        if (!tl_invisible(tl_class(cp), cp))
+            x += cfg->advance(cfg->ctx, prev, cp == '\t' ? ' ' : cp);
+        sc.x[n] = x > INT16_MAX ? INT16_MAX : x;
+        if (over < 0 && x > avail && cls != CL_SP) over = n;   // Spaces may hang in the margin
+        if (cls != CL_SP) last_vis = n;
+        if (!tl_invisible(tl_class(cp), cp)) prev = cp == '\t' ? ' ' : cp;
+
+        p += clen;
+        n++;
+        sc.off[n] = p;
+    }
+    const bool fits = hard && over < 0;
+    if (next_brk < 0) sc.brk[n] = 0;
+    if (over < 0) over = n;                     // Out of characters or bytes, break as if it overflowed
+    if (next_brk < 0 && hard) next_brk = n;
+
+    const int space_w = cfg->advance(cfg->ctx, 0, ' ');
+    int end = -1, width = 0;
+    bool hyphen = false, para_end = false;
+
+    if (fits) {
+        // Everything up to the line feed fits
+        end = n;
+        para_end = hard;
+    } else {
+        // Narrow the spaces a little rather than push a word down
+        if (cfg->justify && next_brk > over && sc.cp[next_brk - 1] != CP_SHY) {
+            int last = tl_trim(&sc, next_brk);
+            int spaces = tl_inner_spaces(&sc, last);
+            int need = sc.x[last] - avail;
+            if (spaces > 0 && need <= spaces * space_w / 4) {
+                end = next_brk;
+                para_end = hard && next_brk == n;
+            }
+        }
+        // Last break that fits, a soft hyphen only if its hyphen fits too
+        int b = over;
+        while (b > 0 && (!sc.brk[b] || (sc.cp[b - 1] == CP_SHY && tl_hyphen_width(cfg, &sc, b) > avail))) b--;
+        if (b > 0 && sc.cp[b - 1] == CP_SHY) {
+            end = b;
+            hyphen = true;
+            width = tl_hyphen_width(cfg, &sc, b);
+        }
+        if (end < 0) {
+            int last = b > 0 ? tl_trim(&sc, b) : -1;
+            int slack = last >= 0 ? avail - sc.x[last] : avail;
+            if (b <= 0 || slack > avail / 8) {
+                int w, k = tl_find_hyphen(cfg, &sc, n, b > 0 ? b : 0, over, avail, &w);
+                if (k > 0) {
+                    end = k;
+                    hyphen = true;
+                    width = w;
+                }
+            }
+        }
+        if (end < 0 && b > 0) end = b;
+        if (end < 0) {
+            // No break allowed: cut the word, but not before closing punctuation
+            // (the spaces in front of it would be dropped) or after an opening one
+            end = over > 0 ? over : 1;
+            while (end > 1 && end < n && tl_kinsoku(&sc, end)) end--;
+            if (end == 1 && over > 1 && tl_kinsoku(&sc, 1)) end = over;    // Nothing but punctuation, fill the line
+        }
+    }
+
+    int last = tl_trim(&sc, end);
+    if (!hyphen) width = last >= 0 ? sc.x[last] : 0;
+    line->end = last >= 0 ? sc.off[last + 1] : pos;
+    line->next = (para_end && end == n) ? hard_next : sc.off[end];
+    line->width = width;
+    if (para_end) line->flags |= TL_LINE_PARA_END;
+    if (hyphen) line->flags |= TL_LINE_HYPHEN;
+
+    // Spread the slack, never on the last line of a paragraph
+    int slack = avail - width;
+    int spaces = last >= 0 ? tl_inner_spaces(&sc, last) : 0;
+    if (slack < 0 && spaces > 0) {
+        line->stretch = TL_STRETCH_SPACES;
+        line->extra = slack;
+    } else if (cfg->justify && !para_end && slack > 0 && last > 0) {
+        int chars = 0;
+        for (int i = 0; i <= last; i++)
+            if (!tl_invisible(tl_class(sc.cp[i]), sc.cp[i])) chars++;
+        if (hyphen) chars++;
+        if (spaces > 0) {
+            if (slack <= spaces * cfg->em) {
+                line->stretch = TL_STRETCH_SPACES;
+                line->extra = slack;
+            }
+        } else if (chars > 1 && slack <= (chars - 1) * cfg->em / 4) {
+            line->stretch = TL_STRETCH_CHARS;
+            line->extra = slack;
+        }
+    }
+    return true;
+}
+
+size_t tl_copy_line(const tl_config_t *cfg, const char *text, const tl_line_t *line, char *out, size_t out_size)
+{
+    size_t o = 0;
+    if (out_size == 0) return 0;
+
+    for (uint32_t p = line->start; p < line->end;) {
+        int clen;
+        uint32_t cp = tl_decode(cfg, text + p, line->end - p, &clen);
+        if (clen == 0) clen = line->end - p;
+        if (cp == '\t') {
+            if (o + 1 < out_size) out[o++] = ' ';
+        } else if (!tl_invisible(tl_class(cp), cp)) {
+            if (o + clen >= out_size) break;
+            memcpy(out + o, text + p, clen);
+            o += clen;
+        }
+        p += clen;
+    }
+    if ((line->flags & TL_LINE_HYPHEN) && o + 1 < out_size) out[o++] = '-';
+    out[o] = '\0';
+    return o;
+}
@@ -0,0 +1,89 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Line breaking for the reader, a simplified UAX #14 with CJK kinsoku:
+ * no closing punctuation, small kana or iteration marks at the start of a
+ * line, no opening brackets at the end, Latin words kept whole unless they
+ * can be hyphenated. No file I/O, widths come from a callback.
+ *
+ * Lines are filled greedily. When a line overflows, the breaker looks ahead
+ * to the next break: if the rest of that word fits by narrowing the spaces a
+ * little it is kept on the line, otherwise the word is hyphenated when the
+ * line would be left loose, otherwise it goes to the next line. The slack of
+ * the line is then spread over the spaces (Latin) or between all characters
+ * (CJK), see tl_line_t.
+ */
+
+#define TL_MAX_CHARS        256     // Characters looked at for one line
+
+// Code point and byte length of the character at s, avail bytes readable.
+// Return 0 with *len = 0 when the sequence is cut off by the end of the buffer.
+typedef uint32_t (*tl_decode_fn)(const char *s, size_t avail, int *len);
+
+// Pen advance of cp drawn after prev (0 at the start of a line), kerning included
+typedef int (*tl_advance_fn)(void *ctx, uint32_t prev, uint32_t cp);
+
+typedef struct {
+    int width;                  // Line width in pixels
+    int indent;                 // First line of a paragraph, pixels
+    int em;                     // Width of a CJK character, limits the justification
+    int max_bytes;              // Longest line in bytes (hyphen included), 0 for TL_MAX_CHARS * 4
+    bool justify;
+    bool hyphenate;             // Split long English words, soft hyphens are always used
+    tl_decode_fn decode;        // NULL for UTF-8
+    tl_advance_fn advance;
+    void *ctx;
+} tl_config_t;
+
+typedef enum {
+    TL_STRETCH_NONE = 0,        // Ragged, extra is 0
+    TL_STRETCH_SPACES,          // extra goes to the spaces between words
+    TL_STRETCH_CHARS,           // extra goes between every two characters
+} tl_stretch_t;
+
+#define TL_LINE_PARA_START  0x01    // First line of a paragraph
+#define TL_LINE_PARA_END    0x02    // Ends at a line break or the end of the text
+#define TL_LINE_HYPHEN      0x04    // Ends inside a word, draw a hyphen after it
+
+typedef struct {
+    uint32_t start, end;        // Bytes to draw, soft hyphens (U+00AD) are not drawn
+    uint32_t next;              // Where the next line starts
+    int16_t width;              // Natural width, hyphen included
+    int16_t indent;             // Pixels before the first character
+    int16_t extra;              // Pixels to spread, may be negative (spaces narrowed)
+    uint8_t stretch;            // tl_stretch_t
+    uint8_t flags;              // TL_LINE_*
+} tl_line_t;
+
+/*
+ * Lay out the line starting at text[pos]. para_start tells whether pos is
+ * the start of a paragraph, afterwards it is (line->flags & TL_LINE_PARA_END).
+ * eof says text[len] is the end of the text, else a line that would need
+ * bytes past len is not produced.
+ * Returns true with a line, false at the end of the text or when more text is needed.
+ * Uses a static scan buffer, call from one task at a time.
+ */
+bool tl_break_line(const tl_config_t *cfg, const char *text, size_t len, size_t pos,
+                   bool eof, bool para_start, tl_line_t *line);
+
+// Copy the bytes to draw into out: soft hyphens and other invisible characters
+// dropped, tabs as spaces, a '-' for TL_LINE_HYPHEN. Returns the length.
+size_t tl_copy_line(const tl_config_t *cfg, const char *text, const tl_line_t *line, char *out, size_t out_size);
+
+// UTF-8 decoder used when cfg->decode is NULL
+uint32_t tl_decode_utf8(const char *s, size_t avail, int *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
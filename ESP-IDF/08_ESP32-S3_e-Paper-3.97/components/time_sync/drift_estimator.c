@@ -0,0 +1,110 @@
+#include "drift_estimator.h"
+#include <math.h>
+#include <string.h>
+
+void ds_init(ds_state_t *s, int max_days)
+{
+    memset(s, 0, sizeof(*s));
+    if (max_days < 1) max_days = 1;
+    if (max_days > 255) max_days = 255;
+    s->max_days = max_days;
+    s->interval_days = 1;
+}
+
+float ds_residual_ppm(const ds_state_t *s)
+{
+    return s->ppm + s->trim * DS_TRIM_PPM;
+}
+
+// Error of one sample in ppm, the measurement error spread over its interval
+static float ds_sample_sigma(uint32_t interval)
+{
+    return DS_MEASURE_MS * 1000.0f / interval;
+}
+
+static void ds_estimate(ds_state_t *s)
+{
+    double sw = 0, swx = 0, svar = 0;
+    for (int i = 0; i < s->count; i++) {
+        double w = (double)s->samples[i].interval * s->samples[i].interval;
+        sw += w;
+        swx += w * s->samples[i].ppm;
+    }
+    double mean = swx / sw;
+    for (int i = 0; i < s->count; i++) {
+        double w = (double)s->samples[i].interval * s->samples[i].interval;
+        double d = s->samples[i].ppm - mean;
+        svar += w * d * d;
+    }
+    // Scatter is not divided down by the count: temperature does not average
+    // out over the next interval the way measurement noise does
+    double measure = DS_MEASURE_MS * 1000.0 / sqrt(sw);
+    s->ppm = (float)mean;
+    s->sigma = (float)sqrt(measure * measure + svar / sw);
+}
+
+static void ds_plan(ds_state_t *s)
+{
+    if (s->count < 2) {
+        // One sample can be a fluke, measure once more before trimming
+        s->interval_days = 1;
+        return;
+    }
+
+    long trim = lroundf(-s->ppm / DS_TRIM_PPM);
+    if (trim < DS_TRIM_MIN) trim = DS_TRIM_MIN;
+    if (trim > DS_TRIM_MAX) trim = DS_TRIM_MAX;
+    s->trim = (int8_t)trim;
+
+    // Days until |residual| + sigma has built up the error budget, growing at
+    // most twice per sync so a wrong estimate is caught early
+    float rate = fabsf(ds_residual_ppm(s)) + s->sigma;
+    float days = DS_ERROR_BUDGET_MS / (rate * 86.4f);    // ppm * 86400 s = 86.4 ms a day
+    int limit = s->interval_days * 2;
+    if (limit > s->max_days) limit = s->max_days;
+    s->interval_days = days >= limit ? limit : (days >= 1.0f ? (uint8_t)days : 1);
+}
+
+ds_result_t ds_add(ds_state_t *s, int64_t time, uint32_t interval, float offset_ms)
+{
+    if (interval < DS_MIN_INTERVAL) {
+        return DS_INVALID;
+    }
+    float measured = offset_ms * 1000.0f / interval;
+    if (!(fabsf(measured) <= DS_MAX_PPM)) {
+        s->interval_days = 1;
+        return DS_INVALID;
+    }
+    float ppm = measured - s->trim * DS_TRIM_PPM;
+
+    ds_result_t result = DS_ACCEPTED;
+    if (s->count >= 2) {
+        float sample = ds_sample_sigma(interval);
+        float limit = 4.0f * sqrtf(s->sigma * s->sigma + sample * sample);
+        if (limit < 3.0f) limit = 3.0f;
+        if (fabsf(ppm - s->ppm) > limit) {
+            if (++s->outliers < 2) {
+                s->interval_days = 1;
+                return DS_OUTLIER;
+            }
+            // Twice in a row is a change (new battery, another room), not noise
+            s->count = 0;
+            s->interval_days = 1;
+            result = DS_RESTARTED;
+        }
+    }
+    s->outliers = 0;
+
+    if (s->count == DS_MAX_SAMPLES) {
+        memmove(&s->samples[0], &s->samples[1], sizeof(s->samples[0]) * (DS_MAX_SAMPLES - 1));
+        s->count--;
+    }
+    s->samples[s->count].time = time;
+    s->samples[s->count].interval = interval;
+    s->samples[s->count].ppm = ppm;
+    s->count++;
+
+    ds_estimate(s);
+    ds_plan(s);
+    return result;
+}
@@ -0,0 +1,67 @@
+#ifndef DRIFT_ESTIMATOR_H
+#define DRIFT_ESTIMATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Rate of the RTC crystal from the offsets found at successive NTP syncs.
+ * Each sample is the offset the RTC built up since it was last set, divided
+ * by that interval; the trim that was programmed meanwhile is taken out, so
+ * all samples describe the bare crystal. The estimate is their mean weighted
+ * by interval squared (the error of a sample shrinks with its length), the
+ * uncertainty adds the scatter between samples (temperature, ageing).
+ * From it follow the OFFSET register value and how long the RTC can run
+ * before the error reaches DS_ERROR_BUDGET_MS. No hardware access.
+ */
+
+#define DS_MAX_SAMPLES      8
+#define DS_TRIM_PPM         4.34f       // OFFSET register LSB with MODE = 0, + runs faster
+#define DS_TRIM_MIN         (-64)
+#define DS_TRIM_MAX         63
+#define DS_MAX_PPM          300.0f      // Beyond this the RTC was set by hand or NTP was wrong
+#define DS_MIN_INTERVAL     3600        // Seconds, shorter samples say nothing
+#define DS_MEASURE_MS       30.0f       // Error of one offset measurement, NTP included
+#define DS_ERROR_BUDGET_MS  1000.0f     // Error allowed to build up before the next sync
+
+typedef struct {
+    int64_t time;           // UTC of the sync
+    uint32_t interval;      // Seconds since the RTC was set
+    float ppm;              // Crystal rate without trim, + is fast
+} ds_sample_t;
+
+typedef struct {
+    ds_sample_t samples[DS_MAX_SAMPLES];    // Oldest first
+    uint8_t count;
+    uint8_t outliers;       // Samples rejected in a row
+    uint8_t max_days;
+    uint8_t interval_days;  // Until the next sync
+    int8_t trim;            // OFFSET register value to run with
+    float ppm;              // Estimated crystal rate
+    float sigma;            // Its uncertainty
+} ds_state_t;
+
+typedef enum {
+    DS_ACCEPTED = 0,
+    DS_OUTLIER,             // Far off the estimate, dropped
+    DS_RESTARTED,           // Second outlier in a row, the history was replaced by it
+    DS_INVALID,             // Too short or too large to be drift
+} ds_result_t;
+
+void ds_init(ds_state_t *s, int max_days);
+
+// offset_ms: RTC minus true time after interval seconds with s->trim programmed.
+// Updates the estimate, s->trim and s->interval_days.
+ds_result_t ds_add(ds_state_t *s, int64_t time, uint32_t interval, float offset_ms);
+
+// Rate the RTC runs at with the current trim, + is fast
+float ds_residual_ppm(const ds_state_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+#include "time_sync.h"
+#include "drift_estimator.h"
+#include <string.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+#ifndef CONFIG_TIME_SYNC_SERVER
+#define CONFIG_TIME_SYNC_SERVER     "ntp1.aliyun.com"
+#endif
+#ifndef CONFIG_TIME_SYNC_MAX_DAYS
+#define CONFIG_TIME_SYNC_MAX_DAYS   7
+#endif
+
+#define TS_NVS_NAMESPACE    "time_sync"
+#define TS_NVS_KEY          "state"
+#define TS_VERSION          1
+// The first tick after the STOP bit is released, see PCF85063_stop()
+#define TS_STOP_RELEASE_US  507874
+
+static const char *TAG = "time_sync";
+
+// Everything a sync needs from the previous one
+typedef struct {
+    uint8_t version;
+    ds_state_t ds;
+    int64_t set_utc;        // When the RTC was last set here, 0 if it was not
+    int32_t set_tz;         // RTC reading minus UTC then, seconds
+    float set_phase_ms;     // RTC minus system time measured right after the set
+    int32_t next_day;       // RTC day of the next sync
+} ts_saved_t;
+
+// Given by the SNTP client when it has set the system time
+static SemaphoreHandle_t ts_synced = NULL;
+
+int64_t time_sync_rtc_seconds(const Time_data *t)
+{
+    // Days since 1970-01-01 of a proleptic Gregorian date
+    int y = t->years + 2000 - (t->months <= 2);
+    int m = t->months <= 2 ? t->months + 9 : t->months - 3;
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * m + 2) / 5 + t->days - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+    return days * 86400 + t->hours * 3600 + t->minutes * 60 + t->seconds;
+}
+
+static void ts_load(ts_saved_t *st)
+{
+    nvs_handle_t handle;
+    size_t len = sizeof(*st);
+    if (nvs_open(TS_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        esp_err_t err = nvs_get_blob(handle, TS_NVS_KEY, st, &len);
+        nvs_close(handle);
+        if (err == ESP_OK && len == sizeof(*st) && st->version == TS_VERSION) {
+            st->ds.max_days = CONFIG_TIME_SYNC_MAX_DAYS;
+            return;
+        }
+    }
+    memset(st, 0, sizeof(*st));
+    st->version = TS_VERSION;
+    ds_init(&st->ds, CONFIG_TIME_SYNC_MAX_DAYS);
+}
+
+static void ts_save(const ts_saved_t *st)
+{
+    nvs_handle_t handle;
+    if (nvs_open(TS_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS");
+        return;
+    }
+    nvs_set_blob(handle, TS_NVS_KEY, st, sizeof(*st));
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+static int64_t ts_now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void ts_to_timedata(const struct tm *src, Time_data *dst)
+{
+    dst->years   = src->tm_year + 1900 - 2000;
+    dst->months  = src->tm_mon + 1;
+    dst->days    = src->tm_mday;
+    dst->hours   = src->tm_hour;
+    dst->minutes = src->tm_min;
+    dst->seconds = src->tm_sec;
+    dst->week    = src->tm_wday;
+}
+
+bool time_sync_due(const Time_data *rtc)
+{
+    ts_saved_t st;
+    ts_load(&st);
+    int64_t today = time_sync_rtc_seconds(rtc) / 86400;
+    // Further away than ever planned: the RTC was set back
+    return today >= st.next_day || st.next_day - today > st.ds.max_days;
+}
+
+int time_sync_interval_days(void)
+{
+    ts_saved_t st;
+    ts_load(&st);
+    return st.ds.interval_days ? st.ds.interval_days : 1;
+}
+
+static void ts_on_sync(struct timeval *tv)
+{
+    xSemaphoreGive(ts_synced);
+}
+
+// Wait for the RTC seconds to roll over. The registers then hold a whole second
+// and *edge_us is the system time (UTC) of that moment, within about a millisecond.
+static bool ts_wait_rtc_tick(Time_data *rtc, int64_t *edge_us)
+{
+    Time_data first = PCF85063_GetTime();
+    int64_t before = ts_now_us();
+    int64_t deadline = esp_timer_get_time() + 1200000;
+    while (esp_timer_get_time() < deadline) {
+        Time_data t = PCF85063_GetTime();
+        int64_t after = ts_now_us();
+        if (t.seconds != first.seconds) {
+            *rtc = t;
+            *edge_us = (before + after) / 2;
+            return true;
+        }
+        before = after;
+        esp_rom_delay_us(500);
+    }
+    return false;
+}
+
+// How far the RTC went since it was set here, into the estimator
+static void ts_measure(ts_saved_t *st)
+{
+    static const char *result_name[] = { "accepted", "outlier", "restarted", "invalid" };
+    Time_data rtc;
+    int64_t edge_us;
+    if (!ts_wait_rtc_tick(&rtc, &edge_us)) {
+        ESP_LOGW(TAG, "The RTC is not ticking");
+        return;
+    }
+    int64_t rtc_us = (time_sync_rtc_seconds(&rtc) - st->set_tz) * 1000000;
+    int64_t elapsed = edge_us / 1000000 - st->set_utc;
+    if (elapsed <= 0) {
+        return;
+    }
+    float offset_ms = (rtc_us - edge_us) / 1000.0f - st->set_phase_ms;
+    ds_result_t result = ds_add(&st->ds, edge_us / 1000000, (uint32_t)elapsed, offset_ms);
+    ESP_LOGI(TAG, "RTC %+.0f ms after %.2f days (%s): crystal %+.2f ppm +/- %.2f, trim %d, next sync in %d days",
+             offset_ms, elapsed / 86400.0f, result_name[result], st->ds.ppm, st->ds.sigma,
+             st->ds.trim, st->ds.interval_days);
+}
+
+// Set the RTC to the system time in step with it: stopped, loaded with a
+// second to come and released so that its first tick lands on the next one
+static void ts_set_rtc(ts_saved_t *st)
+{
+    int64_t now = ts_now_us();
+    time_t target = now / 1000000;
+    int64_t release = (int64_t)target * 1000000 + (1000000 - TS_STOP_RELEASE_US);
+    if (release - now < 20000) {
+        target++;
+        release += 1000000;
+    }
+
+    struct tm tm_local;
+    Time_data t;
+    localtime_r(&target, &tm_local);
+    ts_to_timedata(&tm_local, &t);
+
+    PCF85063_stop(1);
+    PCF85063_SetTime(t);
+    int64_t wait = release - ts_now_us();
+    if (wait > 20000) {
+        vTaskDelay(pdMS_TO_TICKS((wait - 15000) / 1000));
+    }
+    while (ts_now_us() < release) {
+    }
+    PCF85063_stop(0);
+
+    st->set_utc = target;
+    st->set_tz = (int32_t)(time_sync_rtc_seconds(&t) - target);
+
+    // The tick is not exactly where the datasheet puts it, remember where it is
+    Time_data rtc;
+    int64_t edge_us;
+    if (ts_wait_rtc_tick(&rtc, &edge_us)) {
+        int64_t rtc_us = (time_sync_rtc_seconds(&rtc) - st->set_tz) * 1000000;
+        st->set_phase_ms = (rtc_us - edge_us) / 1000.0f;
+        ESP_LOGI(TAG, "RTC set to %04d-%02d-%02d %02d:%02d:%02d, %+.1f ms", t.years + 2000, t.months, t.days,
+                 t.hours, t.minutes, t.seconds, st->set_phase_ms);
+    } else {
+        // Without the phase the next offset would be off by up to a second
+        st->set_utc = 0;
+    }
+}
+
+int time_sync_now(int timeout_ms, struct tm *t)
+{
+    if (ts_synced == NULL) {
+        ts_synced = xSemaphoreCreateBinary();
+    }
+    xSemaphoreTake(ts_synced, 0);
+
+    esp_sntp_stop();
+    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, CONFIG_TIME_SYNC_SERVER);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    sntp_set_time_sync_notification_cb(ts_on_sync);
+    esp_sntp_init();
+    bool synced = xSemaphoreTake(ts_synced, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+    esp_sntp_stop();
+    if (!synced) {
+        ESP_LOGW(TAG, "No answer from %s", CONFIG_TIME_SYNC_SERVER);
+        return -1;
+    }
+
+    ts_saved_t st;
+    ts_load(&st);
+    if (st.set_utc > 0) {
+        ts_measure(&st);
+    }
+    if (PCF85063_offset_read() != st.ds.trim) {
+        ESP_LOGI(TAG, "OFFSET register set to %d (%+.2f ppm)", st.ds.trim, st.ds.trim * DS_TRIM_PPM);
+        PCF85063_offset_write(st.ds.trim);
+    }
+    ts_set_rtc(&st);
+
+    time_t now = time(NULL);
+    localtime_r(&now, t);
+    st.next_day = (int32_t)((now + st.set_tz) / 86400) + st.ds.interval_days;
+    ts_save(&st);
+    return 0;
+}
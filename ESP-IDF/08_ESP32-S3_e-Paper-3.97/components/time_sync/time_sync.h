@@ -0,0 +1,39 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "pcf85063_bsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * NTP time for the PCF85063. Each sync measures how far the RTC drifted
+ * since the previous one (to about a millisecond, from the RTC's own second
+ * tick), feeds that to the drift estimator, trims the crystal through the
+ * OFFSET register and sets the RTC in step with the system time. The state
+ * lives in NVS namespace "time_sync". A well trimmed RTC is synced less often,
+ * once a day at first and up to CONFIG_TIME_SYNC_MAX_DAYS apart.
+ */
+
+// Seconds of an RTC reading, counted as if it were UTC (the RTC keeps local time)
+int64_t time_sync_rtc_seconds(const Time_data *t);
+
+// Whether the RTC should be synced at this wake-up
+bool time_sync_due(const Time_data *rtc);
+
+// Days the RTC now runs between syncs, 1 until it has been trimmed
+int time_sync_interval_days(void);
+
+// Sync with NTP and discipline the RTC. Needs the network and TZ set.
+// Returns 0 with the local time in *t, -1 if no answer came within timeout_ms.
+int time_sync_now(int timeout_ms, struct tm *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
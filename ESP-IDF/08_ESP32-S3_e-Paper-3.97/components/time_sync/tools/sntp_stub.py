@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+A minimal SNTP server with a simulated clock, for checking time_sync without
+waiting weeks for a real crystal to drift.
+
+The clock served is the host clock plus --offset seconds, running --ppm
+faster (or slower, negative) since the server started. Set
+CONFIG_TIME_SYNC_SERVER to this host's address and restart the server
+between syncs with a different --offset to fake a step; a steady --ppm
+looks to the device as if its RTC ran -ppm off, which the estimator should
+pick up and trim out after two syncs.
+
+Only mode 3 (client) requests are answered, as stratum 2 with a reference
+of "STUB". Timestamps are NTP era 0 (seconds since 1900).
+
+Usage: sntp_stub.py [--port 123] [--offset SECONDS] [--ppm PPM]
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+NTP_EPOCH = 2208988800      # 1970-01-01 in NTP seconds
+
+
+class Clock:
+    def __init__(self, offset, ppm):
+        self.start = time.time()
+        self.offset = offset
+        self.ppm = ppm
+
+    def now(self):
+        t = time.time()
+        return t + self.offset + (t - self.start) * self.ppm * 1e-6
+
+
+def to_ntp(t):
+    t += NTP_EPOCH
+    sec = int(t)
+    return sec, int((t - sec) * (1 << 32)) & 0xFFFFFFFF
+
+
+def reply(request, clock, received):
+    if len(request) < 48 or request[0] & 0x07 != 3:
+        return None
+    version = request[0] >> 3 & 0x07
+    origin = request[40:48]             # Client transmit time, echoed back
+    ref_s, ref_f = to_ntp(clock.now() - 16)
+    rx_s, rx_f = to_ntp(received)
+    tx_s, tx_f = to_ntp(clock.now())
+    return struct.pack("!BBbbII4sII8sIIII",
+                       (0 << 6) | (version << 3) | 4,   # No leap warning, server
+                       2, request[2], -20,              # Stratum, poll, precision
+                       0, 0, b"STUB",                   # Root delay, dispersion, ref id
+                       ref_s, ref_f, origin, rx_s, rx_f, tx_s, tx_f)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--port", type=int, default=123)
+    ap.add_argument("--offset", type=float, default=0.0, help="seconds added to the host clock")
+    ap.add_argument("--ppm", type=float, default=0.0, help="rate of the served clock, + is fast")
+    args = ap.parse_args()
+
+    clock = Clock(args.offset, args.ppm)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", args.port))
+    print(f"SNTP stub on port {args.port}, offset {args.offset:+.3f} s, {args.ppm:+.2f} ppm")
+    while True:
+        request, addr = sock.recvfrom(512)
+        received = clock.now()
+        packet = reply(request, clock, received)
+        if packet is None:
+            continue
+        sock.sendto(packet, addr)
+        print(f"{addr[0]}: {time.strftime('%Y-%m-%d %H:%M:%S', time.gmtime(received))}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,71 @@
+#ifndef HOST_CJSON_H
+#define HOST_CJSON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The subset of cJSON the pages use, with the same structure and semantics
+ * (object keys match case-insensitively, cJSON_Print* output is freed with
+ * free()). ESP-IDF's copy is not available outside the IDF build.
+ */
+
+#define cJSON_Invalid   (0)
+#define cJSON_False     (1 << 0)
+#define cJSON_True      (1 << 1)
+#define cJSON_NULL      (1 << 2)
+#define cJSON_Number    (1 << 3)
+#define cJSON_String    (1 << 4)
+#define cJSON_Array     (1 << 5)
+#define cJSON_Object    (1 << 6)
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    int valueint;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+typedef int cJSON_bool;
+
+cJSON *cJSON_Parse(const char *value);
+void cJSON_Delete(cJSON *item);
+char *cJSON_Print(const cJSON *item);
+char *cJSON_PrintUnformatted(const cJSON *item);
+void cJSON_free(void *object);
+
+int cJSON_GetArraySize(const cJSON *array);
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index);
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
+
+cJSON_bool cJSON_IsString(const cJSON *item);
+cJSON_bool cJSON_IsNumber(const cJSON *item);
+cJSON_bool cJSON_IsArray(const cJSON *item);
+cJSON_bool cJSON_IsObject(const cJSON *item);
+cJSON_bool cJSON_IsBool(const cJSON *item);
+cJSON_bool cJSON_IsTrue(const cJSON *item);
+cJSON_bool cJSON_IsNull(const cJSON *item);
+
+cJSON *cJSON_CreateObject(void);
+cJSON *cJSON_CreateArray(void);
+cJSON *cJSON_CreateString(const char *string);
+cJSON *cJSON_CreateNumber(double num);
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item);
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string);
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number);
+
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
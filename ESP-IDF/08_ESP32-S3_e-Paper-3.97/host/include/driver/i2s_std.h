@@ -0,0 +1,130 @@
+#ifndef HOST_DRIVER_I2S_STD_H
+#define HOST_DRIVER_I2S_STD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * I2S channels that take samples at the configured rate and throw them away,
+ * and a microphone that records silence. Struct fields are in the order of
+ * ESP-IDF's, designated initializers depend on it.
+ */
+
+typedef struct host_i2s_chan *i2s_chan_handle_t;
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 } i2s_port_t;
+
+typedef enum {
+    I2S_DATA_BIT_WIDTH_8BIT = 8,
+    I2S_DATA_BIT_WIDTH_16BIT = 16,
+    I2S_DATA_BIT_WIDTH_24BIT = 24,
+    I2S_DATA_BIT_WIDTH_32BIT = 32,
+} i2s_data_bit_width_t;
+
+typedef enum {
+    I2S_SLOT_BIT_WIDTH_AUTO = 0,
+    I2S_SLOT_BIT_WIDTH_8BIT = 8,
+    I2S_SLOT_BIT_WIDTH_16BIT = 16,
+    I2S_SLOT_BIT_WIDTH_24BIT = 24,
+    I2S_SLOT_BIT_WIDTH_32BIT = 32,
+} i2s_slot_bit_width_t;
+
+typedef enum {
+    I2S_SLOT_MODE_MONO = 1,
+    I2S_SLOT_MODE_STEREO = 2,
+} i2s_slot_mode_t;
+
+typedef enum {
+    I2S_STD_SLOT_LEFT = 1,
+    I2S_STD_SLOT_RIGHT = 2,
+    I2S_STD_SLOT_BOTH = 3,
+} i2s_std_slot_mask_t;
+
+typedef enum {
+    I2S_CLK_SRC_DEFAULT = 0,
+} i2s_clock_src_t;
+
+typedef enum {
+    I2S_MCLK_MULTIPLE_256 = 256,
+    I2S_MCLK_MULTIPLE_384 = 384,
+} i2s_mclk_multiple_t;
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    i2s_clock_src_t clk_src;
+    i2s_mclk_multiple_t mclk_multiple;
+} i2s_std_clk_config_t;
+
+typedef struct {
+    i2s_data_bit_width_t data_bit_width;
+    i2s_slot_bit_width_t slot_bit_width;
+    i2s_slot_mode_t slot_mode;
+    i2s_std_slot_mask_t slot_mask;
+    uint32_t ws_width;
+    bool ws_pol;
+    bool bit_shift;
+    bool left_align;
+    bool big_endian;
+    bool bit_order_lsb;
+} i2s_std_slot_config_t;
+
+typedef struct {
+    gpio_num_t mclk;
+    gpio_num_t bclk;
+    gpio_num_t ws;
+    gpio_num_t dout;
+    gpio_num_t din;
+    struct {
+        uint32_t mclk_inv: 1;
+        uint32_t bclk_inv: 1;
+        uint32_t ws_inv: 1;
+    } invert_flags;
+} i2s_std_gpio_config_t;
+
+typedef struct {
+    i2s_std_clk_config_t clk_cfg;
+    i2s_std_slot_config_t slot_cfg;
+    i2s_std_gpio_config_t gpio_cfg;
+} i2s_std_config_t;
+
+#define I2S_STD_CLK_DEFAULT_CONFIG(rate) { \
+    .sample_rate_hz = (rate),              \
+    .clk_src = I2S_CLK_SRC_DEFAULT,        \
+    .mclk_multiple = I2S_MCLK_MULTIPLE_256, \
+}
+
+#define I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bits_per_sample, mono_or_stereo) { \
+    .data_bit_width = (bits_per_sample),                                       \
+    .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO,                                 \
+    .slot_mode = (mono_or_stereo),                                             \
+    .slot_mask = I2S_STD_SLOT_BOTH,                                            \
+    .ws_width = (uint32_t)(bits_per_sample),                                   \
+    .ws_pol = false,                                                           \
+    .bit_shift = true,                                                         \
+    .left_align = true,                                                        \
+    .big_endian = false,                                                       \
+    .bit_order_lsb = false,                                                    \
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_reconfig_std_clock(i2s_chan_handle_t handle, const i2s_std_clk_config_t *clk_cfg);
+esp_err_t i2s_channel_reconfig_std_slot(i2s_chan_handle_t handle, const i2s_std_slot_config_t *slot_cfg);
+// Blocks for as long as the samples take to play
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written,
+                            uint32_t timeout_ms);
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read,
+                           uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
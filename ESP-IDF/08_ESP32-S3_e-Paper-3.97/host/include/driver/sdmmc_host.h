@@ -0,0 +1,41 @@
+#ifndef HOST_DRIVER_SDMMC_HOST_H
+#define HOST_DRIVER_SDMMC_HOST_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SDMMC_FREQ_DEFAULT      20000
+#define SDMMC_FREQ_HIGHSPEED    40000
+
+typedef struct {
+    uint32_t max_freq_khz;
+} sdmmc_host_t;
+
+typedef struct {
+    int width;
+    int clk, cmd, d0, d1, d2, d3;
+} sdmmc_slot_config_t;
+
+#define SDMMC_HOST_DEFAULT()        {.max_freq_khz = SDMMC_FREQ_DEFAULT}
+#define SDMMC_SLOT_CONFIG_DEFAULT() {.width = 1}
+
+typedef struct {
+    int capacity;       // In sectors
+    int sector_size;
+} sdmmc_csd_t;
+
+typedef struct {
+    sdmmc_csd_t csd;
+} sdmmc_card_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef HOST_DRIVER_SPI_MASTER_H
+#define HOST_DRIVER_SPI_MASTER_H
+
+// Nothing of the SPI driver is used by the code built for the host
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HOST_ESP_CODEC_DEV_H
+#define HOST_ESP_CODEC_DEV_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A codec that keeps its settings and plays nothing
+
+typedef struct host_codec_dev *esp_codec_dev_handle_t;
+
+int esp_codec_dev_set_out_vol(esp_codec_dev_handle_t codec, int volume);
+int esp_codec_dev_set_out_mute(esp_codec_dev_handle_t codec, bool mute);
+int esp_codec_dev_set_in_gain(esp_codec_dev_handle_t codec, float db_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
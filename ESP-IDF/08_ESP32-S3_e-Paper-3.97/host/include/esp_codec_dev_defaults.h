@@ -0,0 +1,6 @@
+#ifndef HOST_ESP_CODEC_DEV_DEFAULTS_H
+#define HOST_ESP_CODEC_DEV_DEFAULTS_H
+
+#include "esp_codec_dev.h"
+
+#endif
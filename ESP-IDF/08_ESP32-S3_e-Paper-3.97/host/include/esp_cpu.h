@@ -0,0 +1,19 @@
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Every task runs on core 0, as xPortGetCoreID() says
+int esp_cpu_get_core_id(void);
+// The monotonic clock at esp_clk_cpu_freq(), wrapping as the CCOUNT register does
+uint32_t esp_cpu_get_cycle_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef HOST_ESP_NETIF_H
+#define HOST_ESP_NETIF_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+    esp_ip4_addr_t ip;
+    esp_ip4_addr_t netmask;
+    esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct host_netif esp_netif_t;
+
+#define IPSTR "%d.%d.%d.%d"
+#define esp_ip4_addr1_16(ipaddr) ((uint16_t)(((ipaddr)->addr) & 0xff))
+#define esp_ip4_addr2_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 8) & 0xff))
+#define esp_ip4_addr3_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 16) & 0xff))
+#define esp_ip4_addr4_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 24) & 0xff))
+#define IP2STR(ipaddr) esp_ip4_addr1_16(ipaddr), esp_ip4_addr2_16(ipaddr), \
+                       esp_ip4_addr3_16(ipaddr), esp_ip4_addr4_16(ipaddr)
+
+// A station interface with an address while the fake WiFi is up
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key);
+esp_err_t esp_netif_get_ip_info(esp_netif_t *netif, esp_netif_ip_info_t *ip_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_CLK_H
+#define HOST_ESP_CLK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The default CPU clock of the board, 160 MHz
+int esp_clk_cpu_freq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
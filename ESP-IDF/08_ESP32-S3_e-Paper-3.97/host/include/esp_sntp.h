@@ -0,0 +1,36 @@
+#ifndef HOST_ESP_SNTP_H
+#define HOST_ESP_SNTP_H
+
+#include <stdbool.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The server answers at once with the host clock while the fake WiFi is up
+
+typedef enum {
+    SNTP_OPMODE_POLL,
+    SNTP_OPMODE_LISTENONLY
+} esp_sntp_operatingmode_t;
+
+typedef enum {
+    SNTP_SYNC_MODE_IMMED,
+    SNTP_SYNC_MODE_SMOOTH
+} sntp_sync_mode_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode);
+void esp_sntp_setservername(int idx, const char *server);
+void sntp_set_sync_mode(sntp_sync_mode_t mode);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb);
+void esp_sntp_init(void);
+void esp_sntp_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
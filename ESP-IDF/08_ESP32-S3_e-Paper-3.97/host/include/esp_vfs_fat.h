@@ -0,0 +1,26 @@
+#ifndef HOST_ESP_VFS_FAT_H
+#define HOST_ESP_VFS_FAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "driver/sdmmc_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool format_if_mount_failed;
+    int max_files;
+    size_t allocation_unit_size;
+} esp_vfs_fat_sdmmc_mount_config_t;
+
+// "Mounts" the SD card directory given on the command line at base_path
+esp_err_t esp_vfs_fat_sdmmc_mount(const char *base_path, const sdmmc_host_t *host, const void *slot_config,
+                                  const esp_vfs_fat_sdmmc_mount_config_t *mount_config, sdmmc_card_t **out_card);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
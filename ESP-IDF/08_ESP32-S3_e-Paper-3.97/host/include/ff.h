@@ -0,0 +1,42 @@
+#ifndef HOST_FF_H
+#define HOST_FF_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t DWORD;
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM
+} FRESULT;
+
+typedef struct {
+    uint16_t csize;     // Sectors per cluster
+    uint16_t ssize;
+    DWORD n_fatent;     // Clusters + 2
+} FATFS;
+
+// From statvfs() of the SD card directory
+FRESULT f_getfree(const char *path, DWORD *nclst, FATFS **fatfs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+/*
+ * FreeRTOS on the host: tasks are pthreads, ticks run at CONFIG_FREERTOS_HZ
+ * of the monotonic clock as on the board (so pdMS_TO_TICKS() rounds the
+ * same way), critical sections take one process-wide recursive lock.
+ * Priorities and core affinity are accepted and ignored.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+#define configTICK_RATE_HZ          CONFIG_FREERTOS_HZ
+#define configMAX_TASK_NAME_LEN     16
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY               ((TickType_t)0xffffffffUL)
+#define portNUM_PROCESSORS          2
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+#define pdTICKS_TO_MS(t)            ((uint32_t)(((uint64_t)(t) * 1000U) / configTICK_RATE_HZ))
+
+#define pdFALSE                     0
+#define pdTRUE                      1
+#define pdFAIL                      0
+#define pdPASS                      1
+#define errQUEUE_EMPTY              0
+#define errQUEUE_FULL               0
+#define tskNO_AFFINITY              INT_MAX
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    {0}
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+
+#define portENTER_CRITICAL(mux)         ((void)(mux), host_critical_enter())
+#define portEXIT_CRITICAL(mux)          ((void)(mux), host_critical_exit())
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux)         portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)          portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(...)         ((void)0)
+// There are no interrupts: masking them keeps other tasks out instead
+#define portSET_INTERRUPT_MASK_FROM_ISR()       (host_critical_enter(), 0u)
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(s)    ((void)(s), host_critical_exit())
+#define xPortInIsrContext()             pdFALSE
+
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+// As ESP-IDF's idf_additions.h, which FreeRTOS.h ends with
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+void vQueueDelete(QueueHandle_t q);
+#define xQueueSendToBack(q, item, timeout)          xQueueSend((q), (item), (timeout))
+#define xQueueSendFromISR(q, item, woken)           ((void)(woken), xQueueSend((q), (item), 0))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
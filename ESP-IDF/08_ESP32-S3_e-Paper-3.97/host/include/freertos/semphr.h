@@ -0,0 +1,32 @@
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mutexes and binary/counting semaphores are all counting semaphores here;
+// a mutex starts at 1 and a binary semaphore at 0, both capped at 1
+typedef struct host_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t host_sem_create(UBaseType_t max, UBaseType_t initial, bool recursive);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateMutex()                 host_sem_create(1, 1, false)
+#define xSemaphoreCreateRecursiveMutex()        host_sem_create(1, 1, true)
+#define xSemaphoreCreateBinary()                host_sem_create(1, 0, false)
+#define xSemaphoreCreateCounting(max, init)     host_sem_create((max), (init), false)
+#define xSemaphoreTakeRecursive(sem, timeout)   xSemaphoreTake((sem), (timeout))
+#define xSemaphoreGiveRecursive(sem)            xSemaphoreGive(sem)
+#define xSemaphoreGiveFromISR(sem, woken)       ((void)(woken), xSemaphoreGive(sem))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
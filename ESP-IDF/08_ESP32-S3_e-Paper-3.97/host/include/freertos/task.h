@@ -0,0 +1,41 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include <sched.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core);
+#define xTaskCreate(fn, name, stack, arg, prio, handle) \
+    xTaskCreatePinnedToCore((fn), (name), (stack), (arg), (prio), (handle), tskNO_AFFINITY)
+
+// Only a task deleting itself (NULL) is supported
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+#define taskYIELD()                     ((void)sched_yield())
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t period);
+#define xTaskDelayUntil(prev, period)   (vTaskDelayUntil((prev), (period)), pdTRUE)
+TickType_t xTaskGetTickCount(void);
+#define xTaskGetTickCountFromISR()      xTaskGetTickCount()
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t timeout);
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index);
+#define ulTaskNotifyTake(clear, timeout)        ulTaskNotifyTakeIndexed(0, (clear), (timeout))
+#define xTaskNotifyGive(task)                   xTaskNotifyGiveIndexed((task), 0)
+#define vTaskNotifyGiveFromISR(task, woken)     ((void)(woken), (void)xTaskNotifyGive(task))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef HOST_NVS_FLASH_H
+#define HOST_NVS_FLASH_H
+
+#include "esp_err.h"
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_flash_deinit(void);
+
+// Host only: the file the store lives in, read at once and written on commit
+esp_err_t host_nvs_load(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
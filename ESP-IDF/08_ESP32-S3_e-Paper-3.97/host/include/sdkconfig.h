@@ -0,0 +1,19 @@
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+/*
+ * Configuration of the host build. Fonts and bitmaps come from the SD card
+ * directory so that their reads show up in the I/O counts, icons are built
+ * in as on the board. Everything else keeps the defaults of the headers.
+ */
+
+#define CONFIG_IDF_TARGET               "linux"
+#define CONFIG_IDF_TARGET_LINUX         1
+#define CONFIG_FREERTOS_HZ              100     // As the board's sdkconfig
+#define CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES 3
+#define CONFIG_FONT_ENABLE_SDCARD       1
+#define CONFIG_FONT_ENABLE_TFCARD       1
+#define CONFIG_IMG_SOURCE_EMBEDDED      1
+#define CONFIG_TIME_SYNC_SERVER         "pool.ntp.org"
+
+#endif
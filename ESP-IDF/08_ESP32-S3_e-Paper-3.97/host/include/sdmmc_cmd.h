@@ -0,0 +1,18 @@
+#ifndef HOST_SDMMC_CMD_H
+#define HOST_SDMMC_CMD_H
+
+#include <stdio.h>
+#include "driver/sdmmc_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card);
+esp_err_t sdmmc_get_status(sdmmc_card_t *card);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOST_SYS_LOCK_H
+#define HOST_SYS_LOCK_H
+
+// newlib's static locks, recursive like in ESP-IDF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *_lock_t;
+
+void _lock_acquire(_lock_t *lock);
+void _lock_acquire_recursive(_lock_t *lock);
+void _lock_release(_lock_t *lock);
+void _lock_release_recursive(_lock_t *lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
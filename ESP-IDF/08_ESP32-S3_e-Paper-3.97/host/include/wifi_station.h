@@ -0,0 +1,18 @@
+#ifndef _WIFI_STATION_H_
+#define _WIFI_STATION_H_
+
+#include <string>
+
+// The part of the station the pages use; the fake never has a cached address
+class WifiStation {
+public:
+    static WifiStation& GetInstance();
+    bool IsConnected();
+    std::string ResolveHost(const std::string& host);
+    void ForgetHost(const std::string& host);
+
+private:
+    WifiStation() = default;
+};
+
+#endif // _WIFI_STATION_H_
@@ -0,0 +1,69 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "sdcard_bsp.h"
+#include "perf_bench.h"
+#include "sim.h"
+
+/*
+ * The benchmark suite of components/perf_bench on the host. The fonts and
+ * the BMP are read from --sd as the board reads them from the card, so the
+ * times include the same file traffic (tools/make_sdcard.py lays it out).
+ */
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --sd DIR [options]\n"
+            "  --sd DIR         directory mounted at /sdcard (tools/make_sdcard.py)\n"
+            "  --out FILE       write the results as JSON (tools/bench_compare.py)\n"
+            "  --only NAME      run the benchmarks whose name contains NAME\n"
+            "  --runs N         timed runs of each, instead of its own count\n"
+            "  -v               log at INFO, -vv at DEBUG\n",
+            argv0);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option opts[] = {
+        {"sd", required_argument, NULL, 'd'},
+        {"out", required_argument, NULL, 'o'},
+        {"only", required_argument, NULL, 'n'},
+        {"runs", required_argument, NULL, 'r'},
+        {NULL, 0, NULL, 0},
+    };
+    const char *out = NULL, *only = NULL;
+    int runs = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "v", opts, NULL)) != -1) {
+        switch (opt) {
+        case 'd': sim_config.sd_dir = optarg; break;
+        case 'o': out = optarg; break;
+        case 'n': only = optarg; break;
+        case 'r': runs = atoi(optarg); break;
+        case 'v': sim_config.log_level = sim_config.log_level < ESP_LOG_INFO ? ESP_LOG_INFO : ESP_LOG_DEBUG; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (!sim_config.sd_dir || optind != argc || runs < 0) usage(argv[0]);
+
+    _sdcard_init();
+    pb_result_t results[PB_MAX_BENCH];
+    int n = perf_bench_run(only, runs, results, PB_MAX_BENCH);
+
+    printf("%-16s %5s %9s %9s %9s %9s  %s\n", "bench", "runs", "min", "median", "p99", "mean", "check");
+    for (int i = 0; i < n; i++) {
+        const pb_result_t *r = &results[i];
+        printf("%-16s %5d %9.3f %9.3f %9.3f %9.3f  %08lx\n", r->name, r->runs, r->min_ms, r->median_ms, r->p99_ms,
+               r->mean_ms, (unsigned long)r->check);
+    }
+    if (out) {
+        FILE *fp = fopen(out, "w");
+        if (!fp || perf_bench_write_json(fp, results, n) != ESP_OK) sim_fatal("cannot write %s", out);
+        fclose(fp);
+    }
+    return n > 0 ? 0 : 1;
+}
@@ -0,0 +1,501 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "cJSON.h"
+
+/*
+ * A small cJSON: a recursive descent parser and printer over the same node
+ * structure, for the responses and settings the pages handle.
+ */
+
+#define CJSON_MAX_DEPTH     64
+
+typedef struct {
+    const char *p;
+    int depth;
+} parser_t;
+
+static cJSON *new_item(int type)
+{
+    cJSON *item = calloc(1, sizeof(cJSON));
+    if (item) item->type = type;
+    return item;
+}
+
+void cJSON_Delete(cJSON *item)
+{
+    while (item) {
+        cJSON *next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void *object)
+{
+    free(object);
+}
+
+/*---------- Parsing ----------*/
+
+static void skip_ws(parser_t *ps)
+{
+    while (*ps->p && isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+static int hex4(const char *s, unsigned *out)
+{
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned)(c - 'A' + 10);
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+static char *utf8_put(char *o, unsigned cp)
+{
+    if (cp < 0x80) {
+        *o++ = (char)cp;
+    } else if (cp < 0x800) {
+        *o++ = (char)(0xC0 | (cp >> 6));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *o++ = (char)(0xE0 | (cp >> 12));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *o++ = (char)(0xF0 | (cp >> 18));
+        *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return o;
+}
+
+// ps->p at the opening quote. The result is never longer than the source
+static char *parse_string_raw(parser_t *ps)
+{
+    const char *s = ps->p + 1;
+    const char *end = s;
+    while (*end && *end != '"') end += (*end == '\\' && end[1]) ? 2 : 1;
+    if (*end != '"') return NULL;
+
+    char *out = malloc((size_t)(end - s) + 1), *o = out;
+    if (!out) return NULL;
+    while (s < end) {
+        if (*s != '\\') {
+            *o++ = *s++;
+            continue;
+        }
+        s++;
+        switch (*s++) {
+        case 'b': *o++ = '\b'; break;
+        case 'f': *o++ = '\f'; break;
+        case 'n': *o++ = '\n'; break;
+        case 'r': *o++ = '\r'; break;
+        case 't': *o++ = '\t'; break;
+        case 'u': {
+            unsigned cp, lo;
+            if (end - s < 4 || !hex4(s, &cp)) goto fail;
+            s += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && end - s >= 6 && s[0] == '\\' && s[1] == 'u' && hex4(s + 2, &lo) &&
+                lo >= 0xDC00 && lo < 0xE000) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                s += 6;
+            }
+            o = utf8_put(o, cp);
+            break;
+        }
+        default: *o++ = s[-1]; break;     // \" \\ \/
+        }
+    }
+    *o = '\0';
+    ps->p = end + 1;
+    return out;
+fail:
+    free(out);
+    return NULL;
+}
+
+static cJSON *parse_value(parser_t *ps);
+
+static cJSON *parse_container(parser_t *ps, int type, char close)
+{
+    cJSON *item = new_item(type), *last = NULL;
+    if (!item || ++ps->depth > CJSON_MAX_DEPTH) goto fail;
+    ps->p++;
+    skip_ws(ps);
+    if (*ps->p == close) {
+        ps->p++;
+        ps->depth--;
+        return item;
+    }
+    for (;;) {
+        char *key = NULL;
+        skip_ws(ps);
+        if (type == cJSON_Object) {
+            if (*ps->p != '"' || !(key = parse_string_raw(ps))) goto fail;
+            skip_ws(ps);
+            if (*ps->p != ':') {
+                free(key);
+                goto fail;
+            }
+            ps->p++;
+        }
+        cJSON *child = parse_value(ps);
+        if (!child) {
+            free(key);
+            goto fail;
+        }
+        child->string = key;
+        if (last) {
+            last->next = child;
+            child->prev = last;
+        } else {
+            item->child = child;
+        }
+        last = child;
+        skip_ws(ps);
+        if (*ps->p == ',') {
+            ps->p++;
+        } else if (*ps->p == close) {
+            ps->p++;
+            ps->depth--;
+            return item;
+        } else {
+            goto fail;
+        }
+    }
+fail:
+    cJSON_Delete(item);
+    return NULL;
+}
+
+static cJSON *parse_value(parser_t *ps)
+{
+    skip_ws(ps);
+    const char *p = ps->p;
+    if (*p == '{') return parse_container(ps, cJSON_Object, '}');
+    if (*p == '[') return parse_container(ps, cJSON_Array, ']');
+    if (*p == '"') {
+        char *s = parse_string_raw(ps);
+        cJSON *item = s ? new_item(cJSON_String) : NULL;
+        if (item) item->valuestring = s;
+        else free(s);
+        return item;
+    }
+    if (strncmp(p, "null", 4) == 0) {
+        ps->p += 4;
+        return new_item(cJSON_NULL);
+    }
+    if (strncmp(p, "true", 4) == 0) {
+        ps->p += 4;
+        cJSON *item = new_item(cJSON_True);
+        if (item) item->valueint = 1;
+        return item;
+    }
+    if (strncmp(p, "false", 5) == 0) {
+        ps->p += 5;
+        return new_item(cJSON_False);
+    }
+    if (*p == '-' || isdigit((unsigned char)*p)) {
+        char *end;
+        double v = strtod(p, &end);
+        if (end == p) return NULL;
+        ps->p = end;
+        return cJSON_CreateNumber(v);
+    }
+    return NULL;
+}
+
+cJSON *cJSON_Parse(const char *value)
+{
+    if (!value) return NULL;
+    parser_t ps = {value, 0};
+    cJSON *item = parse_value(&ps);
+    skip_ws(&ps);
+    if (item && *ps.p) {
+        // Trailing garbage is accepted by cJSON_Parse, as upstream
+    }
+    return item;
+}
+
+/*---------- Printing ----------*/
+
+typedef struct {
+    char *buf;
+    size_t len, cap;
+    int ok;
+} out_t;
+
+static void put(out_t *o, const char *s, size_t n)
+{
+    if (!o->ok) return;
+    if (o->len + n + 1 > o->cap) {
+        size_t cap = o->cap ? o->cap : 64;
+        while (cap < o->len + n + 1) cap *= 2;
+        char *b = realloc(o->buf, cap);
+        if (!b) {
+            o->ok = 0;
+            return;
+        }
+        o->buf = b;
+        o->cap = cap;
+    }
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+    o->buf[o->len] = '\0';
+}
+
+static void put_str(out_t *o, const char *s)
+{
+    put(o, "\"", 1);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        char esc[8];
+        switch (c) {
+        case '"':  put(o, "\\\"", 2); break;
+        case '\\': put(o, "\\\\", 2); break;
+        case '\n': put(o, "\\n", 2); break;
+        case '\r': put(o, "\\r", 2); break;
+        case '\t': put(o, "\\t", 2); break;
+        default:
+            if (c < 0x20) {
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                put(o, esc, 6);
+            } else {
+                put(o, s, 1);
+            }
+        }
+    }
+    put(o, "\"", 1);
+}
+
+static void indent(out_t *o, int depth)
+{
+    for (int i = 0; i < depth; i++) put(o, "\t", 1);
+}
+
+static void print_value(out_t *o, const cJSON *item, int fmt, int depth)
+{
+    char num[32];
+    switch (item->type & 0xFF) {
+    case cJSON_NULL:    put(o, "null", 4); break;
+    case cJSON_False:   put(o, "false", 5); break;
+    case cJSON_True:    put(o, "true", 4); break;
+    case cJSON_String:  put_str(o, item->valuestring ? item->valuestring : ""); break;
+    case cJSON_Number: {
+        double d = item->valuedouble;
+        int n;
+        if (!isfinite(d)) {
+            n = snprintf(num, sizeof(num), "null");
+        } else if (d == (double)item->valueint) {
+            n = snprintf(num, sizeof(num), "%d", item->valueint);
+        } else {
+            n = snprintf(num, sizeof(num), "%.15g", d);
+            if (strtod(num, NULL) != d) n = snprintf(num, sizeof(num), "%.17g", d);
+        }
+        put(o, num, (size_t)n);
+        break;
+    }
+    case cJSON_Array:
+    case cJSON_Object: {
+        int obj = (item->type & 0xFF) == cJSON_Object;
+        put(o, obj ? "{" : "[", 1);
+        if (fmt && obj) put(o, "\n", 1);
+        for (const cJSON *c = item->child; c; c = c->next) {
+            if (fmt && obj) indent(o, depth + 1);
+            if (obj) {
+                put_str(o, c->string ? c->string : "");
+                put(o, fmt ? ":\t" : ":", fmt ? 2 : 1);
+            }
+            print_value(o, c, fmt, depth + 1);
+            if (c->next) put(o, fmt && !obj ? ", " : ",", fmt && !obj ? 2 : 1);
+            if (fmt && obj) put(o, "\n", 1);
+        }
+        if (fmt && obj) indent(o, depth);
+        put(o, obj ? "}" : "]", 1);
+        break;
+    }
+    default:
+        o->ok = 0;
+    }
+}
+
+static char *print(const cJSON *item, int fmt)
+{
+    if (!item) return NULL;
+    out_t o = {NULL, 0, 0, 1};
+    print_value(&o, item, fmt, 0);
+    if (!o.ok) {
+        free(o.buf);
+        return NULL;
+    }
+    return o.buf;
+}
+
+char *cJSON_Print(const cJSON *item)
+{
+    return print(item, 1);
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item)
+{
+    return print(item, 0);
+}
+
+/*---------- Access ----------*/
+
+int cJSON_GetArraySize(const cJSON *array)
+{
+    int n = 0;
+    for (const cJSON *c = array ? array->child : NULL; c; c = c->next) n++;
+    return n;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    if (index < 0) return NULL;
+    cJSON *c = array ? array->child : NULL;
+    while (c && index--) c = c->next;
+    return c;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    if (!object || !string) return NULL;
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && strcasecmp(c->string, string) == 0) return c;
+    }
+    return NULL;
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+{
+    if (!object || !string) return NULL;
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && strcmp(c->string, string) == 0) return c;
+    }
+    return NULL;
+}
+
+#define TYPE_IS(item, t)    ((item) != NULL && ((item)->type & 0xFF) == (t))
+
+cJSON_bool cJSON_IsString(const cJSON *item)
+{
+    return TYPE_IS(item, cJSON_String);
+}
+
+cJSON_bool cJSON_IsNumber(const cJSON *item)
+{
+    return TYPE_IS(item, cJSON_Number);
+}
+
+cJSON_bool cJSON_IsArray(const cJSON *item)
+{
+    return TYPE_IS(item, cJSON_Array);
+}
+
+cJSON_bool cJSON_IsObject(const cJSON *item)
+{
+    return TYPE_IS(item, cJSON_Object);
+}
+
+cJSON_bool cJSON_IsBool(const cJSON *item)
+{
+    return item != NULL && (item->type & (cJSON_True | cJSON_False)) != 0;
+}
+
+cJSON_bool cJSON_IsTrue(const cJSON *item)
+{
+    return TYPE_IS(item, cJSON_True);
+}
+
+cJSON_bool cJSON_IsNull(const cJSON *item)
+{
+    return TYPE_IS(item, cJSON_NULL);
+}
+
+/*---------- Building ----------*/
+
+cJSON *cJSON_CreateObject(void)
+{
+    return new_item(cJSON_Object);
+}
+
+cJSON *cJSON_CreateArray(void)
+{
+    return new_item(cJSON_Array);
+}
+
+cJSON *cJSON_CreateString(const char *string)
+{
+    cJSON *item = new_item(cJSON_String);
+    if (item && !(item->valuestring = strdup(string ? string : ""))) {
+        free(item);
+        return NULL;
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateNumber(double num)
+{
+    cJSON *item = new_item(cJSON_Number);
+    if (!item) return NULL;
+    item->valuedouble = num;
+    // Saturated like upstream
+    item->valueint = num >= 2147483647.0 ? 2147483647 : num <= -2147483648.0 ? (-2147483647 - 1) : (int)num;
+    return item;
+}
+
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    if (!array || !item || array == item) return 0;
+    if (!array->child) {
+        array->child = item;
+    } else {
+        cJSON *last = array->child;
+        while (last->next) last = last->next;
+        last->next = item;
+        item->prev = last;
+    }
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    if (!object || !string || !item) return 0;
+    char *key = strdup(string);
+    if (!key) return 0;
+    free(item->string);
+    item->string = key;
+    return cJSON_AddItemToArray(object, item);
+}
+
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string)
+{
+    cJSON *item = cJSON_CreateString(string);
+    if (cJSON_AddItemToObject(object, name, item)) return item;
+    cJSON_Delete(item);
+    return NULL;
+}
+
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number)
+{
+    cJSON *item = cJSON_CreateNumber(number);
+    if (cJSON_AddItemToObject(object, name, item)) return item;
+    cJSON_Delete(item);
+    return NULL;
+}
@@ -0,0 +1,439 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "sys/lock.h"
+#include "sim.h"
+
+/*
+ * FreeRTOS primitives on pthreads. Every object is a mutex and a condition
+ * variable on the monotonic clock; a tick is a millisecond.
+ */
+
+struct host_task {
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+};
+
+struct host_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t count;
+    UBaseType_t max;
+    bool recursive;
+    pthread_t owner;
+    UBaseType_t depth;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct host_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static pthread_mutex_t static_lock_init = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct host_task *current_task;
+
+static void cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ms = pdTICKS_TO_MS(ticks);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// Waits on cond until pred holds or the timeout passes, lock held. Returns pred.
+#define WAIT_UNTIL(cond, lock, timeout, pred) ({                            \
+        bool ok_ = (pred);                                                  \
+        if (!ok_ && (timeout) != 0) {                                       \
+            struct timespec ts_ = deadline(timeout);                        \
+            while (!(ok_ = (pred))) {                                       \
+                int rc_ = (timeout) == portMAX_DELAY                        \
+                    ? pthread_cond_wait((cond), (lock))                     \
+                    : pthread_cond_timedwait((cond), (lock), &ts_);         \
+                if (rc_ == ETIMEDOUT) { ok_ = (pred); break; }              \
+            }                                                               \
+        }                                                                   \
+        ok_;                                                                \
+    })
+
+void host_critical_enter(void)
+{
+    pthread_mutex_lock(&critical_lock);
+}
+
+void host_critical_exit(void)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+/*---------- Tasks ----------*/
+
+static struct host_task *task_new(const char *name, TaskFunction_t fn, void *arg)
+{
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (!t) abort();
+    strncpy(t->name, name ? name : "", sizeof(t->name) - 1);
+    t->fn = fn;
+    t->arg = arg;
+    pthread_mutex_init(&t->lock, NULL);
+    cond_init(&t->cond);
+    return t;
+}
+
+static void *task_entry(void *p)
+{
+    current_task = p;
+    current_task->fn(current_task->arg);
+    // A FreeRTOS task must not return, treat it as deleting itself
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)stack;
+    (void)prio;
+    (void)core;
+    struct host_task *t = task_new(name, fn, arg);
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, task_entry, t);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    if (handle) *handle = t;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != xTaskGetCurrentTaskHandle()) {
+        sim_fatal("vTaskDelete of another task is not supported on the host");
+    }
+    pthread_exit(NULL);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_now_us() * configTICK_RATE_HZ / 1000000);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_sleep_us((int64_t)pdTICKS_TO_MS(ticks) * 1000);
+}
+
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t period)
+{
+    TickType_t next = *prev_wake + period;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(next - now) > 0) vTaskDelay(next - now);
+    *prev_wake = next;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!current_task) current_task = task_new("main", NULL, NULL);
+    return current_task;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task ? task : xTaskGetCurrentTaskHandle())->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    (void)task;
+    return 4096;
+}
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t timeout)
+{
+    struct host_task *t = xTaskGetCurrentTaskHandle();
+    assert(index < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+    pthread_mutex_lock(&t->lock);
+    uint32_t value = 0;
+    if (WAIT_UNTIL(&t->cond, &t->lock, timeout, t->notify[index] > 0)) {
+        value = t->notify[index];
+        t->notify[index] = clear ? 0 : t->notify[index] - 1;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index)
+{
+    assert(index < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+    pthread_mutex_lock(&task->lock);
+    task->notify[index]++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+/*---------- Semaphores ----------*/
+
+SemaphoreHandle_t host_sem_create(UBaseType_t max, UBaseType_t initial, bool recursive)
+{
+    struct host_sem *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    pthread_mutex_init(&s->lock, NULL);
+    cond_init(&s->cond);
+    s->max = max;
+    s->count = initial;
+    s->recursive = recursive;
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t timeout)
+{
+    pthread_mutex_lock(&s->lock);
+    if (s->recursive && s->depth > 0 && pthread_equal(s->owner, pthread_self())) {
+        s->depth++;
+        pthread_mutex_unlock(&s->lock);
+        return pdTRUE;
+    }
+    bool ok = WAIT_UNTIL(&s->cond, &s->lock, timeout, s->count > 0);
+    if (ok) {
+        s->count--;
+        if (s->recursive) {
+            s->owner = pthread_self();
+            s->depth = 1;
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&s->lock);
+    if (s->recursive && s->depth > 1) {
+        s->depth--;
+        ret = pdTRUE;
+    } else if (s->count < s->max) {
+        s->depth = 0;
+        s->count++;
+        pthread_cond_signal(&s->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    if (!s) return;
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+/*---------- Queues ----------*/
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->items = calloc(length ? length : 1, item_size ? item_size : 1);
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    cond_init(&q->cond);
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout)
+{
+    pthread_mutex_lock(&q->lock);
+    bool ok = WAIT_UNTIL(&q->cond, &q->lock, timeout, q->count < q->length);
+    if (ok) {
+        UBaseType_t tail = (q->head + q->count) % q->length;
+        memcpy(q->items + (size_t)tail * q->item_size, item, q->item_size);
+        q->count++;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdPASS : errQUEUE_FULL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout)
+{
+    pthread_mutex_lock(&q->lock);
+    bool ok = WAIT_UNTIL(&q->cond, &q->lock, timeout, q->count > 0);
+    if (ok) {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdPASS : errQUEUE_EMPTY;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q) return;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q->items);
+    free(q);
+}
+
+/*---------- Event groups ----------*/
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    struct host_event_group *g = calloc(1, sizeof(*g));
+    if (!g) return NULL;
+    pthread_mutex_init(&g->lock, NULL);
+    cond_init(&g->cond);
+    return g;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits)
+{
+    pthread_mutex_lock(&g->lock);
+    g->bits |= bits;
+    EventBits_t now = g->bits;
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits)
+{
+    pthread_mutex_lock(&g->lock);
+    EventBits_t before = g->bits;
+    g->bits &= ~bits;
+    pthread_mutex_unlock(&g->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t g)
+{
+    pthread_mutex_lock(&g->lock);
+    EventBits_t now = g->bits;
+    pthread_mutex_unlock(&g->lock);
+    return now;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear,
+                                BaseType_t all, TickType_t timeout)
+{
+    pthread_mutex_lock(&g->lock);
+    bool ok = WAIT_UNTIL(&g->cond, &g->lock, timeout,
+                         all ? (g->bits & bits) == bits : (g->bits & bits) != 0);
+    EventBits_t now = g->bits;
+    if (ok && clear) g->bits &= ~bits;
+    pthread_mutex_unlock(&g->lock);
+    return now;
+}
+
+void vEventGroupDelete(EventGroupHandle_t g)
+{
+    if (!g) return;
+    pthread_cond_destroy(&g->cond);
+    pthread_mutex_destroy(&g->lock);
+    free(g);
+}
+
+/*---------- newlib locks ----------*/
+
+static pthread_mutex_t *static_lock(_lock_t *lock)
+{
+    if (__atomic_load_n(lock, __ATOMIC_ACQUIRE) == NULL) {
+        pthread_mutex_lock(&static_lock_init);
+        if (*lock == NULL) {
+            pthread_mutex_t *m = malloc(sizeof(*m));
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+            pthread_mutex_init(m, &attr);
+            pthread_mutexattr_destroy(&attr);
+            __atomic_store_n(lock, m, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&static_lock_init);
+    }
+    return *lock;
+}
+
+void _lock_acquire(_lock_t *lock)
+{
+    pthread_mutex_lock(static_lock(lock));
+}
+
+void _lock_acquire_recursive(_lock_t *lock)
+{
+    pthread_mutex_lock(static_lock(lock));
+}
+
+void _lock_release(_lock_t *lock)
+{
+    pthread_mutex_unlock(static_lock(lock));
+}
+
+void _lock_release_recursive(_lock_t *lock)
+{
+    pthread_mutex_unlock(static_lock(lock));
+}
@@ -0,0 +1,276 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "sdcard_bsp.h"
+#include "kv_log.h"
+#include "sim.h"
+
+/*
+ * Power cuts against components/kv_log. Random updates of a few books,
+ * shaped like the reader's progress and bookmarks, go to a log on --sd;
+ * before a share of them the card is set to lose power after a random
+ * number of bytes, so that records, compactions and the rename between
+ * them are torn at every point. After each cut the log is opened again,
+ * as on the next boot, and has to hold exactly what was acknowledged,
+ * with the interrupted update either fully there or not at all. Puts that
+ * kv_log_full() said would compact, and only those, have to.
+ */
+
+#define KT_DIR          "/sdcard/kvtest"
+#define KT_PATH         KT_DIR "/progress.kv"
+#define KT_BOOKS        4
+#define KT_TAGS         12              // 0 is the progress, then bookmarks
+#define KT_VALUE_MAX    300
+
+typedef struct {
+    bool present;
+    uint16_t len;
+    uint8_t data[KT_VALUE_MAX];
+} kt_value_t;
+
+typedef struct {
+    kt_value_t v[KT_BOOKS][KT_TAGS];
+} kt_model_t;
+
+typedef enum {
+    KT_PUT,
+    KT_DEL,
+    KT_COMPACT,
+} kt_kind_t;
+
+typedef struct {
+    kt_kind_t kind;
+    int book;
+    int tag;
+    kt_value_t value;
+} kt_op_t;
+
+static uint64_t books[KT_BOOKS];
+static uint64_t rng;
+
+static uint32_t next_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng >> 16);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --sd DIR [options]\n"
+            "  --sd DIR         directory mounted at /sdcard, the log goes to kvtest/\n"
+            "  --ops N          updates to make (default 5000)\n"
+            "  --seed N         of the updates and the cuts (default 1)\n"
+            "  --size KB        of the log, small to compact often (default 16)\n"
+            "  --cuts N         a cut before one update in N (default 3)\n"
+            "  -v               log at INFO, -vv at DEBUG\n",
+            argv0);
+    exit(1);
+}
+
+static kt_op_t random_op(void)
+{
+    kt_op_t op = {.book = (int)(next_rand() % KT_BOOKS)};
+    uint32_t r = next_rand() % 100;
+    if (r < 60) {
+        // A page turn
+        op.kind = KT_PUT;
+        op.tag = 0;
+        op.value.len = 8;
+    } else if (r < 85) {
+        op.kind = KT_PUT;
+        op.tag = 1 + (int)(next_rand() % (KT_TAGS - 1));
+        op.value.len = (uint16_t)(12 + next_rand() % (KT_VALUE_MAX - 12));
+    } else if (r < 95) {
+        op.kind = KT_DEL;
+        op.tag = 1 + (int)(next_rand() % (KT_TAGS - 1));
+    } else {
+        op.kind = KT_COMPACT;
+    }
+    op.value.present = op.kind == KT_PUT;
+    for (int i = 0; i < op.value.len; i++) op.value.data[i] = (uint8_t)next_rand();
+    return op;
+}
+
+static esp_err_t apply_log(kv_log_t *kv, const kt_op_t *op)
+{
+    switch (op->kind) {
+    case KT_PUT: return kv_log_put(kv, books[op->book], op->tag, op->value.data, op->value.len);
+    case KT_DEL: return kv_log_del(kv, books[op->book], op->tag);
+    default:     return kv_log_compact(kv);
+    }
+}
+
+static void apply_model(kt_model_t *m, const kt_op_t *op)
+{
+    if (op->kind != KT_COMPACT) m->v[op->book][op->tag] = op->value;
+}
+
+// Whether the log holds exactly what the model does
+static bool matches(kv_log_t *kv, const kt_model_t *m, char *why, size_t len)
+{
+    uint8_t buf[KV_LOG_VALUE_MAX];
+    for (int b = 0; b < KT_BOOKS; b++) {
+        uint32_t tags[KT_TAGS + 1];
+        int n = kv_log_tags(kv, books[b], tags, KT_TAGS + 1);
+        int expect = 0;
+        for (int t = 0; t < KT_TAGS; t++) expect += m->v[b][t].present;
+        if (n != expect) {
+            snprintf(why, len, "book %d has %d keys, expected %d", b, n, expect);
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            const kt_value_t *v = tags[i] < KT_TAGS ? &m->v[b][tags[i]] : NULL;
+            size_t got = 0;
+            if (!v || !v->present) {
+                snprintf(why, len, "book %d has tag %lu, expected none", b, (unsigned long)tags[i]);
+                return false;
+            }
+            if (kv_log_get(kv, books[b], tags[i], buf, sizeof(buf), &got) != ESP_OK || got != v->len ||
+                memcmp(buf, v->data, got) != 0) {
+                snprintf(why, len, "book %d tag %lu differs", b, (unsigned long)tags[i]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static kv_log_t *reopen(kv_log_t *kv, uint32_t size)
+{
+    kv_log_close(kv);
+    esp_err_t err = kv_log_open(KT_PATH, size, &kv);
+    if (err != ESP_OK) sim_fatal("cannot open %s: %s", KT_PATH, esp_err_to_name(err));
+    return kv;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option opts[] = {
+        {"sd", required_argument, NULL, 'd'},
+        {"ops", required_argument, NULL, 'o'},
+        {"seed", required_argument, NULL, 's'},
+        {"size", required_argument, NULL, 'k'},
+        {"cuts", required_argument, NULL, 'c'},
+        {NULL, 0, NULL, 0},
+    };
+    int ops = 5000, size_kb = 16, cut_one_in = 3;
+    unsigned long seed = 1;
+
+    sim_config.log_level = ESP_LOG_NONE;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "v", opts, NULL)) != -1) {
+        switch (opt) {
+        case 'd': sim_config.sd_dir = optarg; break;
+        case 'o': ops = atoi(optarg); break;
+        case 's': seed = strtoul(optarg, NULL, 0); break;
+        case 'k': size_kb = atoi(optarg); break;
+        case 'c': cut_one_in = atoi(optarg); break;
+        case 'v': sim_config.log_level = sim_config.log_level < ESP_LOG_INFO ? ESP_LOG_INFO : ESP_LOG_DEBUG; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (!sim_config.sd_dir || optind != argc || ops <= 0 || size_kb <= 0 || cut_one_in <= 0) usage(argv[0]);
+
+    _sdcard_init();
+    mkdir(KT_DIR, 0755);
+    remove(KT_PATH);
+    remove(KT_PATH ".tmp");
+    rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (int b = 0; b < KT_BOOKS; b++) {
+        char name[32];
+        snprintf(name, sizeof(name), "/sdcard/book%d.txt", b);
+        books[b] = kv_log_book_id(name, 100000 + b);
+    }
+
+    static kt_model_t model;
+    uint32_t size = (uint32_t)size_kb * 1024;
+    kv_log_t *kv = reopen(NULL, size);
+    int cuts = 0, landed = 0, lost = 0, full = 0, compactions = 0, torn = 0;
+    char why[128];
+
+    for (int i = 0; i < ops; i++) {
+        kt_op_t op = random_op();
+        bool cut = next_rand() % cut_one_in == 0;
+        if (cut) {
+            // Anywhere in the record, or in the copy, the remove and the rename of a compaction
+            uint32_t range = op.kind == KT_COMPACT ? size + 8 : KV_LOG_HEADER_SIZE + op.value.len + 4;
+            sim_power_cut_after(next_rand() % range, (int)(next_rand() % 64));
+        }
+        kv_log_stats_t before;
+        kv_log_get_stats(kv, &before);
+        bool will_compact = op.kind == KT_PUT && kv_log_full(kv, op.value.len);
+        esp_err_t err = apply_log(kv, &op);
+        bool off = sim_power_is_cut();
+        sim_power_restore();
+
+        if (!off) {
+            if (op.kind == KT_PUT) {
+                kv_log_stats_t st;
+                kv_log_get_stats(kv, &st);
+                if ((st.compactions != before.compactions) != will_compact)
+                    sim_fatal("update %d: kv_log_full() said %d, compactions went %lu to %lu", i, will_compact,
+                              (unsigned long)before.compactions, (unsigned long)st.compactions);
+            }
+            if (err == ESP_ERR_NO_MEM) {
+                full++;
+                continue;
+            }
+            if (err != ESP_OK) sim_fatal("update %d failed without a cut: %s", i, esp_err_to_name(err));
+            apply_model(&model, &op);
+            if (i % 64 == 0) {
+                kv_log_stats_t st;
+                kv_log_get_stats(kv, &st);
+                compactions += st.compactions;
+                kv = reopen(kv, size);
+                if (!matches(kv, &model, why, sizeof(why))) sim_fatal("update %d, reopened: %s", i, why);
+            }
+            continue;
+        }
+
+        // Power is back: boot
+        cuts++;
+        kv_log_stats_t st;
+        kv_log_get_stats(kv, &st);
+        compactions += st.compactions;
+        kv = reopen(kv, size);
+        kv_log_get_stats(kv, &st);
+        torn += st.torn;
+
+        kt_model_t *after = malloc(sizeof(kt_model_t));
+        *after = model;
+        apply_model(after, &op);
+        bool was_before = matches(kv, &model, why, sizeof(why));
+        if (err == ESP_OK || !was_before) {
+            // Acknowledged updates are kept, and an interrupted one is all there if anything is
+            if (!matches(kv, after, why, sizeof(why))) {
+                sim_fatal("update %d cut (%s): neither the state before nor after it, %s", i,
+                          esp_err_to_name(err), why);
+            }
+            model = *after;
+            landed++;
+        } else {
+            lost++;
+        }
+        free(after);
+    }
+
+    kv_log_stats_t st;
+    kv_log_get_stats(kv, &st);
+    compactions += st.compactions;
+    kv = reopen(kv, size);
+    if (!matches(kv, &model, why, sizeof(why))) sim_fatal("at the end: %s", why);
+    kv_log_get_stats(kv, &st);
+    kv_log_close(kv);
+
+    printf("%d updates, %d power cuts: %d updates kept, %d lost, %d torn records dropped\n", ops, cuts, landed,
+           lost, torn);
+    printf("%d compactions, %d updates refused as full, log at generation %lu with %lu keys\n", compactions, full,
+           (unsigned long)st.generation, (unsigned long)st.keys);
+    return 0;
+}
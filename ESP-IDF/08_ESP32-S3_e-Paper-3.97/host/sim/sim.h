@@ -0,0 +1,112 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Host simulator of the board: the pages run unchanged against the fakes in
+ * this directory, driven by a key script (sim_script.c). The run ends when
+ * the script does, or when the firmware powers off or restarts.
+ */
+
+#define SIM_PATH_MAX    512
+
+typedef struct {
+    const char *sd_dir;         // Host directory mounted at /sdcard
+    const char *spiffs_dir;     // Host directory mounted at /spiffs
+    const char *nvs_path;       // File holding NVS, NULL: in memory only
+    const char *frames_dir;     // Every frame written here as PBM/PGM, NULL: none
+    const char *report_path;    // JSON report, NULL: none
+    int log_level;              // esp_log_level_t
+} sim_config_t;
+
+extern sim_config_t sim_config;
+
+/*---------- Clock and lifetime (sim_core.c) ----------*/
+
+// Monotonic microseconds since start
+int64_t sim_now_us(void);
+void sim_sleep_us(int64_t us);
+void sim_fatal(const char *fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+// Write the report and leave with status 0
+void sim_finish(const char *reason) __attribute__((noreturn));
+
+/*---------- Storage (sim_vfs.c) ----------*/
+
+// Host path of a firmware path under /sdcard or /spiffs, otherwise path itself
+const char *sim_map_path(const char *path, char *buf, size_t len);
+
+typedef struct {
+    uint32_t opens;
+    uint32_t reads;
+    uint64_t read_bytes;
+    uint32_t writes;
+    uint64_t write_bytes;
+    uint32_t seeks;
+    uint32_t dir_ops;           // opendir, stat, mkdir, unlink, rename
+} sim_io_stats_t;
+
+void sim_io_get(sim_io_stats_t *out);
+
+// The card loses power once budget more bytes have reached it, mkdir, unlink,
+// remove, rename and opening for writing counting one each. The write that
+// crosses it stores its first bytes and up to garbage bytes of noise, then
+// every change to the card fails with EIO until sim_power_restore().
+void sim_power_cut_after(int64_t budget, int garbage);
+void sim_power_restore(void);
+bool sim_power_is_cut(void);
+
+/*---------- Display (sim_epd.c) ----------*/
+
+typedef struct {
+    uint32_t full;
+    uint32_t partial;
+    uint32_t gray;
+} sim_frame_stats_t;
+
+void sim_frames_get(sim_frame_stats_t *out);
+// Frames shown so far, all modes
+uint32_t sim_frame_count(void);
+// Write what the panel shows now
+bool sim_epd_snapshot(const char *path);
+
+/*---------- Measurements (sim_report.c) ----------*/
+
+// A key was handed to the firmware, and the firmware asks for the next one
+void sim_report_key(int code);
+void sim_report_wait(void);
+void sim_report_frame(const char *mode, uint32_t crc);
+// Start a new section of the report
+void sim_report_mark(const char *label);
+void sim_report_write(const char *reason);
+
+/*---------- Fakes driven by the script (sim_fakes.c, sim_net.cc) ----------*/
+
+// RTC: local time the run starts at, and time added by idle periods
+void sim_rtc_set(time_t t);
+void sim_rtc_advance_us(int64_t us);
+time_t sim_rtc_now(void);
+
+void sim_battery_set(int percent, bool usb);
+void sim_env_set(float temp, float humi);
+void sim_wifi_set(bool up);
+bool sim_wifi_up(void);
+// Requests whose URL contains pattern get the file's contents
+bool sim_http_add(const char *pattern, const char *file);
+
+/*---------- Key script (sim_script.c) ----------*/
+
+bool sim_script_load(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,275 @@
+#include <malloc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_rom_crc.h"
+#include "esp_cpu.h"
+#include "esp_private/esp_clk.h"
+#include "freertos/FreeRTOS.h"
+#include "sim.h"
+
+#define SIM_PSRAM_BYTES     (8 * 1024 * 1024)   // What the board has
+#define SIM_CPU_HZ          160000000
+#define SIM_LOG_TAGS        16
+
+sim_config_t sim_config = {
+    .log_level = ESP_LOG_WARN,
+};
+
+static int64_t start_ns = -1;
+static pthread_mutex_t finish_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t heap_used;
+
+static struct {
+    char tag[24];
+    esp_log_level_t level;
+} log_tags[SIM_LOG_TAGS];
+static int log_tag_count;
+
+static int64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+__attribute__((constructor)) static void sim_clock_start(void)
+{
+    start_ns = mono_ns();
+}
+
+int64_t sim_now_us(void)
+{
+    return (mono_ns() - start_ns) / 1000;
+}
+
+void sim_sleep_us(int64_t us)
+{
+    if (us <= 0) return;
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+void sim_fatal(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "sim: ");
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+    fflush(NULL);
+    _exit(2);
+}
+
+void sim_finish(const char *reason)
+{
+    // The first caller reports, any other task arriving meanwhile just stops
+    if (pthread_mutex_trylock(&finish_lock) != 0) {
+        for (;;) pause();
+    }
+    sim_report_write(reason);
+    fflush(NULL);
+    // Tasks are still running, leave without calling destructors under them
+    _exit(0);
+}
+
+/*---------- esp_err / esp_log ----------*/
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                        return "ESP_OK";
+    case ESP_FAIL:                      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_NVS_TYPE_MISMATCH:     return "ESP_ERR_NVS_TYPE_MISMATCH";
+    case ESP_ERR_NVS_READ_ONLY:         return "ESP_ERR_NVS_READ_ONLY";
+    case ESP_ERR_HTTP_CONNECT:          return "ESP_ERR_HTTP_CONNECT";
+    default:                            return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    pthread_mutex_lock(&log_lock);
+    if (strcmp(tag, "*") == 0) {
+        sim_config.log_level = level;
+    } else {
+        int i;
+        for (i = 0; i < log_tag_count; i++) {
+            if (strcmp(log_tags[i].tag, tag) == 0) break;
+        }
+        if (i < SIM_LOG_TAGS) {
+            snprintf(log_tags[i].tag, sizeof(log_tags[i].tag), "%s", tag);
+            log_tags[i].level = level;
+            if (i == log_tag_count) log_tag_count++;
+        }
+    }
+    pthread_mutex_unlock(&log_lock);
+}
+
+void host_log(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+    static const char letters[] = "NEWIDV";
+    esp_log_level_t limit = (esp_log_level_t)sim_config.log_level;
+
+    pthread_mutex_lock(&log_lock);
+    for (int i = 0; i < log_tag_count; i++) {
+        // A tag can only be quietened below the global level, as on the device
+        if (strcmp(log_tags[i].tag, tag) == 0 && log_tags[i].level < limit) limit = log_tags[i].level;
+    }
+    if (level <= limit) {
+        va_list ap;
+        va_start(ap, fmt);
+        fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(sim_now_us() / 1000), tag);
+        vfprintf(stderr, fmt, ap);
+        size_t n = strlen(fmt);
+        if (n == 0 || fmt[n - 1] != '\n') fputc('\n', stderr);
+        va_end(ap);
+    }
+    pthread_mutex_unlock(&log_lock);
+}
+
+/*---------- Heap ----------*/
+
+static void *heap_track(void *p)
+{
+    if (p) __atomic_add_fetch(&heap_used, malloc_usable_size(p), __ATOMIC_RELAXED);
+    return p;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return heap_track(malloc(size));
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return heap_track(calloc(n, size));
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    (void)caps;
+    if (ptr) __atomic_sub_fetch(&heap_used, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    return heap_track(realloc(ptr, size));
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return heap_track(aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment));
+}
+
+void heap_caps_free(void *ptr)
+{
+    if (!ptr) return;
+    __atomic_sub_fetch(&heap_used, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    (void)caps;
+    return SIM_PSRAM_BYTES;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    size_t used = __atomic_load_n(&heap_used, __ATOMIC_RELAXED);
+    return used < SIM_PSRAM_BYTES ? SIM_PSRAM_BYTES - used : 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    memset(info, 0, sizeof(*info));
+    info->total_free_bytes = heap_caps_get_free_size(caps);
+    info->total_allocated_bytes = SIM_PSRAM_BYTES - info->total_free_bytes;
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = info->total_free_bytes;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return (uint32_t)heap_caps_get_free_size(0);
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return esp_get_free_heap_size();
+}
+
+/*---------- Timer / system ----------*/
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_now_us();
+}
+
+int esp_cpu_get_core_id(void)
+{
+    return xPortGetCoreID();
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)(sim_now_us() * (SIM_CPU_HZ / 1000000));
+}
+
+int esp_clk_cpu_freq(void)
+{
+    return SIM_CPU_HZ;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    sim_sleep_us(us);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return ~crc;
+}
+
+void esp_restart(void)
+{
+    sim_finish("restart");
+}
@@ -0,0 +1,240 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "epaper_port.h"
+#include "sim.h"
+
+/*
+ * The panel: the controller's black/white RAM (1 = white, rows of 100 bytes
+ * along the 800 pixel side) and what a refresh last showed. Each refresh is
+ * reported with its CRC and, with --frames, written as a portrait PBM (PGM
+ * for 4-gray) the way the device is held.
+ */
+
+#define ROW_BYTES       (EPD_WIDTH / 8)
+#define GRAY_ROW_BYTES  (EPD_WIDTH / 4)
+
+static const char *TAG = "sim_epd";
+static pthread_mutex_t epd_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t panel_ram[EPD_SIZE_MONO];
+static uint8_t gray_ram[EPD_SIZE_4GRAY];
+static bool showing_gray;
+static bool asleep = true;
+static sim_frame_stats_t frames;
+
+static uint32_t crc32(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+// Portrait pixel (x, y) of the panel, 0 black .. 3 white
+static int pixel(int x, int y)
+{
+    int mx = y, my = EPD_HEIGHT - 1 - x;
+    if (showing_gray) {
+        uint8_t b = gray_ram[my * GRAY_ROW_BYTES + mx / 4];
+        return (b >> (6 - 2 * (mx % 4))) & 3;
+    }
+    return (panel_ram[my * ROW_BYTES + mx / 8] & (0x80 >> (mx % 8))) ? 3 : 0;
+}
+
+static bool write_image(const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        ESP_LOGE(TAG, "Cannot write %s", path);
+        return false;
+    }
+    if (showing_gray) {
+        fprintf(fp, "P5\n%d %d\n255\n", EPD_HEIGHT, EPD_WIDTH);
+        for (int y = 0; y < EPD_WIDTH; y++) {
+            for (int x = 0; x < EPD_HEIGHT; x++) fputc(pixel(x, y) * 85, fp);
+        }
+    } else {
+        // PBM: 1 is black
+        fprintf(fp, "P4\n%d %d\n", EPD_HEIGHT, EPD_WIDTH);
+        for (int y = 0; y < EPD_WIDTH; y++) {
+            for (int x = 0; x < EPD_HEIGHT; x += 8) {
+                uint8_t b = 0;
+                for (int i = 0; i < 8; i++) {
+                    if (pixel(x + i, y) == 0) b |= 0x80 >> i;
+                }
+                fputc(b, fp);
+            }
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+// Called with epd_lock held, after the RAM was updated
+static void refreshed(const char *mode, uint32_t *counter)
+{
+    if (asleep) {
+        ESP_LOGW(TAG, "%s refresh while the panel sleeps, the device shows nothing", mode);
+        return;
+    }
+    (*counter)++;
+    uint32_t crc = showing_gray ? crc32(gray_ram, sizeof(gray_ram)) : crc32(panel_ram, sizeof(panel_ram));
+    uint32_t n = frames.full + frames.partial + frames.gray;
+    if (sim_config.frames_dir) {
+        char path[SIM_PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%05lu_%s.%s", sim_config.frames_dir, (unsigned long)n, mode,
+                 showing_gray ? "pgm" : "pbm");
+        write_image(path);
+    }
+    sim_report_frame(mode, crc);
+}
+
+static void show_mono(const UBYTE *image, const char *mode, uint32_t *counter)
+{
+    pthread_mutex_lock(&epd_lock);
+    memcpy(panel_ram, image, sizeof(panel_ram));
+    showing_gray = false;
+    refreshed(mode, counter);
+    pthread_mutex_unlock(&epd_lock);
+}
+
+static void fill(uint8_t value)
+{
+    pthread_mutex_lock(&epd_lock);
+    memset(panel_ram, value, sizeof(panel_ram));
+    showing_gray = false;
+    refreshed("full", &frames.full);
+    pthread_mutex_unlock(&epd_lock);
+}
+
+void epaper_port_init(void)
+{
+}
+
+static void wake(void)
+{
+    pthread_mutex_lock(&epd_lock);
+    asleep = false;
+    pthread_mutex_unlock(&epd_lock);
+}
+
+void EPD_Init(void)
+{
+    wake();
+}
+
+void EPD_Init_Fast(void)
+{
+    wake();
+}
+
+void EPD_Init_Partial(void)
+{
+    wake();
+}
+
+void EPD_Init_4GRAY(void)
+{
+    wake();
+}
+
+void EPD_Sleep(void)
+{
+    pthread_mutex_lock(&epd_lock);
+    asleep = true;
+    pthread_mutex_unlock(&epd_lock);
+}
+
+void EPD_Clear(void)
+{
+    fill(0xFF);
+}
+
+void EPD_Clear_Black(void)
+{
+    fill(0x00);
+}
+
+void EPD_Display(const UBYTE *Image)
+{
+    show_mono(Image, "full", &frames.full);
+}
+
+void EPD_Display_Base(const UBYTE *Image)
+{
+    show_mono(Image, "full", &frames.full);
+}
+
+void EPD_Display_Fast(const UBYTE *Image)
+{
+    show_mono(Image, "full", &frames.full);
+}
+
+void EPD_Display_Fast_Base(const UBYTE *Image)
+{
+    show_mono(Image, "full", &frames.full);
+}
+
+void EPD_Display_OneShot(const UBYTE *Image)
+{
+    show_mono(Image, "full", &frames.full);
+}
+
+void EPD_Display_Partial(const UBYTE *Image, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
+{
+    // The byte window of epaper_port.c
+    if ((Xstart % 8 + Xend % 8 == 8 && Xstart % 8 > Xend % 8) || Xstart % 8 + Xend % 8 == 0 ||
+        (Xend - Xstart) % 8 == 0) {
+        Xstart = Xstart / 8;
+        Xend = Xend / 8;
+    } else {
+        Xstart = Xstart / 8;
+        Xend = Xend % 8 == 0 ? Xend / 8 : Xend / 8 + 1;
+    }
+    if (Xend > ROW_BYTES) Xend = ROW_BYTES;
+    if (Yend > EPD_HEIGHT) Yend = EPD_HEIGHT;
+    if (Xend <= Xstart || Yend <= Ystart) return;
+    UWORD width = Xend - Xstart;
+
+    pthread_mutex_lock(&epd_lock);
+    for (UWORD y = Ystart; y < Yend; y++) {
+        memcpy(&panel_ram[y * ROW_BYTES + Xstart], &Image[(y - Ystart) * width], width);
+    }
+    showing_gray = false;
+    refreshed("partial", &frames.partial);
+    pthread_mutex_unlock(&epd_lock);
+}
+
+void EPD_Display_4Gray(const UBYTE *Image)
+{
+    pthread_mutex_lock(&epd_lock);
+    memcpy(gray_ram, Image, sizeof(gray_ram));
+    showing_gray = true;
+    refreshed("gray", &frames.gray);
+    pthread_mutex_unlock(&epd_lock);
+}
+
+void sim_frames_get(sim_frame_stats_t *out)
+{
+    pthread_mutex_lock(&epd_lock);
+    *out = frames;
+    pthread_mutex_unlock(&epd_lock);
+}
+
+uint32_t sim_frame_count(void)
+{
+    sim_frame_stats_t f;
+    sim_frames_get(&f);
+    return f.full + f.partial + f.gray;
+}
+
+bool sim_epd_snapshot(const char *path)
+{
+    pthread_mutex_lock(&epd_lock);
+    bool ok = write_image(path);
+    pthread_mutex_unlock(&epd_lock);
+    return ok;
+}
@@ -0,0 +1,822 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "driver/gpio.h"
+#include "pcf85063_bsp.h"
+#include "axp_prot.h"
+#include "shtc3_bsp.h"
+#include "es8311_bsp.h"
+#include "audio_player.h"
+#include "sim.h"
+
+/*
+ * The board's peripherals as far as the pages see them. The RTC keeps
+ * wall-clock time encoded as UTC (it has no idea of zones either) that runs
+ * with the host clock plus whatever idle periods of the script skipped. The
+ * battery, sensor and audio path return what the script set.
+ */
+
+static const char *TAG = "sim_fakes";
+static pthread_mutex_t fake_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*---------- PCF85063 ----------*/
+
+static time_t rtc_base;             // RTC time at rtc_set_us
+static int64_t rtc_set_us;
+static int64_t rtc_skipped_us;
+static bool rtc_base_valid;
+static bool rtc_stopped;
+static uint8_t rtc_ram;
+static int8_t rtc_offset;
+
+static bool alarm_on;
+static bool alarm_flag;
+static time_t alarm_at;
+static SemaphoreHandle_t rtc_int_sem;
+
+static time_t rtc_now_locked(void)
+{
+    if (!rtc_base_valid) {
+        // Start at the host's local time
+        time_t now = time(NULL);
+        struct tm tm;
+        localtime_r(&now, &tm);
+        rtc_base = now + tm.tm_gmtoff;
+        rtc_set_us = sim_now_us();
+        rtc_base_valid = true;
+    }
+    if (rtc_stopped) return rtc_base;
+    return rtc_base + (time_t)((sim_now_us() - rtc_set_us + rtc_skipped_us) / 1000000);
+}
+
+static void rtc_set_locked(time_t t)
+{
+    rtc_base = t;
+    rtc_set_us = sim_now_us();
+    rtc_skipped_us = 0;
+    rtc_base_valid = true;
+}
+
+// Raise the alarm flag once its time has come
+static void rtc_check_alarm_locked(void)
+{
+    if (alarm_on && !alarm_flag && rtc_now_locked() >= alarm_at) {
+        alarm_flag = true;
+        if (rtc_int_sem) xSemaphoreGive(rtc_int_sem);
+    }
+}
+
+void sim_rtc_set(time_t t)
+{
+    pthread_mutex_lock(&fake_lock);
+    rtc_set_locked(t);
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void sim_rtc_advance_us(int64_t us)
+{
+    pthread_mutex_lock(&fake_lock);
+    rtc_now_locked();
+    rtc_skipped_us += us;
+    rtc_check_alarm_locked();
+    pthread_mutex_unlock(&fake_lock);
+}
+
+time_t sim_rtc_now(void)
+{
+    pthread_mutex_lock(&fake_lock);
+    time_t t = rtc_now_locked();
+    pthread_mutex_unlock(&fake_lock);
+    return t;
+}
+
+static Time_data to_time_data(time_t t)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    Time_data d = {
+        .years = (uint16_t)(tm.tm_year % 100),
+        .months = (uint16_t)(tm.tm_mon + 1),
+        .days = (uint16_t)tm.tm_mday,
+        .hours = (uint16_t)tm.tm_hour,
+        .minutes = (uint16_t)tm.tm_min,
+        .seconds = (uint16_t)tm.tm_sec,
+        .week = (uint16_t)tm.tm_wday,
+    };
+    return d;
+}
+
+static time_t from_fields(int years, int months, int days, int hours, int minutes, int seconds)
+{
+    struct tm tm = {
+        .tm_year = 100 + years,
+        .tm_mon = months - 1,
+        .tm_mday = days,
+        .tm_hour = hours,
+        .tm_min = minutes,
+        .tm_sec = seconds,
+    };
+    return timegm(&tm);
+}
+
+int DecToBcd(int val)
+{
+    return ((val / 10) * 16 + (val % 10));
+}
+
+int BcdToDec(int val)
+{
+    return ((val / 16) * 10 + (val % 16));
+}
+
+void PCF85063_init()
+{
+}
+
+Time_data PCF85063_DecodeTime(const uint8_t raw[PCF85063_TIME_REG_NUM])
+{
+    Time_data time;
+    time.seconds = BcdToDec(raw[0] & 0x7F);
+    time.minutes = BcdToDec(raw[1] & 0x7F);
+    time.hours = BcdToDec(raw[2] & 0x3F);
+    time.days = BcdToDec(raw[3] & 0x3F);
+    time.week = raw[4] & 0x07;
+    time.months = BcdToDec(raw[5] & 0x1F);
+    time.years = BcdToDec(raw[6]);
+    return time;
+}
+
+Time_data PCF85063_GetTime()
+{
+    pthread_mutex_lock(&fake_lock);
+    rtc_check_alarm_locked();
+    Time_data d = to_time_data(rtc_now_locked());
+    pthread_mutex_unlock(&fake_lock);
+    return d;
+}
+
+void PCF85063_SetTime(Time_data time)
+{
+    pthread_mutex_lock(&fake_lock);
+    rtc_set_locked(from_fields(time.years > 99 ? 99 : time.years, time.months, time.days, time.hours > 23 ? 23 : time.hours,
+                               time.minutes > 59 ? 59 : time.minutes, time.seconds > 59 ? 59 : time.seconds));
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void PCF85063_SetTime_YMD(int Years, int Months, int Days)
+{
+    pthread_mutex_lock(&fake_lock);
+    Time_data d = to_time_data(rtc_now_locked());
+    rtc_set_locked(from_fields(Years, Months, Days, d.hours, d.minutes, d.seconds));
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void PCF85063_SetTime_HMS(int hour, int minute, int second)
+{
+    pthread_mutex_lock(&fake_lock);
+    Time_data d = to_time_data(rtc_now_locked());
+    rtc_set_locked(from_fields(d.years, d.months, d.days, hour > 23 ? 23 : hour, minute > 59 ? 59 : minute,
+                               second > 59 ? 59 : second));
+    pthread_mutex_unlock(&fake_lock);
+}
+
+// The next time at or after now matching h:m:s, and the day of month if day > 0
+static time_t next_alarm(time_t now, int day, int hours, int minutes, int seconds)
+{
+    time_t t = now - now % 86400 + hours * 3600 + minutes * 60 + seconds;
+    for (int i = 0; i < 62; i++, t += 86400) {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        if (t >= now && (day <= 0 || tm.tm_mday == day)) return t;
+    }
+    return t;
+}
+
+void PCF85063_alarm_Time_Enabled(Time_data time)
+{
+    // The carries of the driver, the chip compares the registers it is given
+    if (time.seconds > 59) {
+        time.seconds -= 60;
+        time.minutes++;
+    }
+    if (time.minutes > 59) {
+        time.minutes -= 60;
+        time.hours++;
+    }
+    if (time.hours > 23) {
+        time.hours -= 24;
+        time.days++;
+    }
+    pthread_mutex_lock(&fake_lock);
+    time_t now = rtc_now_locked();
+    Time_data d = to_time_data(now);
+    int last = d.months == 2 ? (d.years % 4 == 0 ? 29 : 28) : (d.months == 4 || d.months == 6 || d.months == 9 || d.months == 11) ? 30 : 31;
+    if (time.days > last) time.days -= last;
+    alarm_at = next_alarm(now, time.days, time.hours, time.minutes, time.seconds);
+    alarm_on = true;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void PCF85063_alarm_Set_HM(uint8_t hour, uint8_t minute)
+{
+    pthread_mutex_lock(&fake_lock);
+    alarm_at = next_alarm(rtc_now_locked(), 0, hour % 24, minute % 60, 0);
+    alarm_on = true;
+    alarm_flag = false;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void PCF85063_alarm_Time_Disable()
+{
+    pthread_mutex_lock(&fake_lock);
+    alarm_on = false;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void PCF85063_int_isr_init(void)
+{
+    if (!rtc_int_sem) rtc_int_sem = xSemaphoreCreateBinary();
+}
+
+int PCF85063_int_wait(TickType_t timeout)
+{
+    if (rtc_int_sem == NULL) {
+        vTaskDelay(timeout);
+        return 0;
+    }
+    return xSemaphoreTake(rtc_int_sem, timeout) == pdTRUE;
+}
+
+void PCF85063_int_notify(void)
+{
+    if (rtc_int_sem != NULL) xSemaphoreGive(rtc_int_sem);
+}
+
+int PCF85063_get_alarm_flag()
+{
+    pthread_mutex_lock(&fake_lock);
+    rtc_check_alarm_locked();
+    int flag = alarm_flag;
+    pthread_mutex_unlock(&fake_lock);
+    return flag;
+}
+
+void PCF85063_clear_alarm_flag()
+{
+    pthread_mutex_lock(&fake_lock);
+    alarm_flag = false;
+    // A daily alarm matches again tomorrow
+    if (alarm_on && rtc_now_locked() >= alarm_at) alarm_at += 86400;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void PCF85063_test()
+{
+}
+
+void rtcRunAlarm(Time_data time, Time_data alarmTime)
+{
+    PCF85063_SetTime_HMS(time.hours, time.minutes, time.seconds);
+    PCF85063_SetTime_YMD(time.years, time.months, time.days);
+    PCF85063_alarm_Time_Enabled(alarmTime);
+}
+
+uint8_t PCF85063_ram_read(void)
+{
+    return rtc_ram;
+}
+
+void PCF85063_ram_write(uint8_t value)
+{
+    rtc_ram = value;
+}
+
+int8_t PCF85063_offset_read(void)
+{
+    return rtc_offset;
+}
+
+void PCF85063_offset_write(int8_t offset)
+{
+    rtc_offset = offset < -64 ? -64 : offset > 63 ? 63 : offset;
+}
+
+void PCF85063_stop(int stop)
+{
+    pthread_mutex_lock(&fake_lock);
+    time_t now = rtc_now_locked();
+    rtc_stopped = false;
+    rtc_set_locked(now);
+    rtc_stopped = stop != 0;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void save_mode_enable_to_nvs(char mode)
+{
+    nvs_handle_t nvs_handle;
+    ESP_ERROR_CHECK(nvs_open("mode_state", NVS_READWRITE, &nvs_handle));
+    ESP_ERROR_CHECK(nvs_set_u8(nvs_handle, "mode", mode));
+    ESP_ERROR_CHECK(nvs_commit(nvs_handle));
+    nvs_close(nvs_handle);
+}
+
+char load_mode_enable_from_nvs()
+{
+    nvs_handle_t nvs_handle;
+    uint8_t mode = 0;
+    if (nvs_open("mode_state", NVS_READONLY, &nvs_handle) == ESP_OK) {
+        nvs_get_u8(nvs_handle, "mode", &mode);
+        nvs_close(nvs_handle);
+    }
+    return mode;
+}
+
+/*---------- AXP2101 ----------*/
+
+static int battery_percent = 80;
+static bool battery_usb;
+static uint16_t load_hint_ma = AXP_LOAD_IDLE_MA;
+
+void sim_battery_set(int percent, bool usb)
+{
+    pthread_mutex_lock(&fake_lock);
+    battery_percent = percent < 0 ? 0 : percent > 100 ? 100 : percent;
+    battery_usb = usb;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+// A flat discharge curve between 3.4 and 4.15 V is close enough for the pages
+static uint16_t battery_mv_locked(void)
+{
+    return (uint16_t)(3400 + battery_percent * 750 / 100 - load_hint_ma / 4);
+}
+
+void axp_init(void)
+{
+}
+
+void axp2101_getVoltage_Task(void *arg)
+{
+    (void)arg;
+    vTaskDelete(NULL);
+}
+
+void axp_telemetry_start(void)
+{
+}
+
+int get_battery_power(void)
+{
+    pthread_mutex_lock(&fake_lock);
+    int percent = battery_percent;
+    pthread_mutex_unlock(&fake_lock);
+    return percent;
+}
+
+void axp_get_battery_snapshot(axp_battery_snapshot_t *snap)
+{
+    pthread_mutex_lock(&fake_lock);
+    snap->vbat_mv = battery_mv_locked();
+    snap->vbat_ema_mv = snap->vbat_mv;
+    snap->percent = (uint8_t)battery_percent;
+    snap->charging = battery_usb && battery_percent < 100;
+    snap->charge_done = battery_usb && battery_percent == 100;
+    snap->vbus_in = battery_usb;
+    snap->updated_us = sim_now_us();
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void axp_set_load_hint(uint16_t load_ma)
+{
+    pthread_mutex_lock(&fake_lock);
+    load_hint_ma = load_ma;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+uint16_t axp_get_load_hint(void)
+{
+    pthread_mutex_lock(&fake_lock);
+    uint16_t ma = load_hint_ma;
+    pthread_mutex_unlock(&fake_lock);
+    return ma;
+}
+
+uint16_t axp_read_vbat_mv(void)
+{
+    pthread_mutex_lock(&fake_lock);
+    uint16_t mv = battery_mv_locked();
+    pthread_mutex_unlock(&fake_lock);
+    return mv;
+}
+
+bool gatpwrstate(uint8_t tab)
+{
+    (void)tab;
+    return true;
+}
+
+bool enapwrstate(uint8_t tab)
+{
+    (void)tab;
+    return true;
+}
+
+bool disapwrstate(uint8_t tab)
+{
+    (void)tab;
+    return true;
+}
+
+uint16_t getpwrVoltage(uint8_t tab)
+{
+    (void)tab;
+    return 3300;
+}
+
+uint16_t setpwrVoltage(uint8_t tab, uint16_t millivolt)
+{
+    (void)tab;
+    return millivolt;
+}
+
+uint16_t getstat()
+{
+    return 0;
+}
+
+void axp_pwr_off()
+{
+    sim_finish("power off");
+}
+
+bool get_usb_connected()
+{
+    pthread_mutex_lock(&fake_lock);
+    bool usb = battery_usb;
+    pthread_mutex_unlock(&fake_lock);
+    return usb;
+}
+
+/*---------- SHTC3 ----------*/
+
+static float env_temp = 23.5f;
+static float env_humi = 45.0f;
+
+void sim_env_set(float temp, float humi)
+{
+    pthread_mutex_lock(&fake_lock);
+    env_temp = temp;
+    env_humi = humi;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+void SHTC3_Init(uint8_t address)
+{
+    (void)address;
+}
+
+void i2c_shtc3_init(void)
+{
+}
+
+void i2c_shtc3_task(void *arg)
+{
+    (void)arg;
+    vTaskDelete(NULL);
+}
+
+etError SHTC3_GetId(uint16_t *id)
+{
+    *id = 0x0807;
+    return NO_ERROR;
+}
+
+etError SHTC3_GetTempAndHumi(float *temp, float *humi)
+{
+    pthread_mutex_lock(&fake_lock);
+    *temp = env_temp;
+    *humi = env_humi;
+    pthread_mutex_unlock(&fake_lock);
+    return NO_ERROR;
+}
+
+etError SHTC3_GetTempAndHumiPolling(float *temp, float *humi)
+{
+    return SHTC3_GetTempAndHumi(temp, humi);
+}
+
+etError SHTC3_Sleep(void)
+{
+    return NO_ERROR;
+}
+
+etError SHTC3_Wakeup(void)
+{
+    return NO_ERROR;
+}
+
+etError SHTC3_SoftReset(void)
+{
+    return NO_ERROR;
+}
+
+int SHTC3_GetEnvTemperatureHumidity(float *temperature, float *humidity)
+{
+    return SHTC3_GetTempAndHumi(temperature, humidity) == NO_ERROR ? 0 : -1;
+}
+
+/*---------- GPIO ----------*/
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    (void)gpio;
+    (void)level;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    (void)gpio;
+    return 1;
+}
+
+/*---------- I2S, codec, ES8311 ----------*/
+
+struct host_i2s_chan {
+    bool enabled;
+    uint32_t rate;
+    uint32_t frame_bytes;
+};
+
+struct host_codec_dev {
+    int volume;
+    bool mute;
+    float gain;
+};
+
+static struct host_i2s_chan tx_chan = {false, EXAMPLE_SAMPLE_RATE, 2};
+static struct host_i2s_chan rx_chan = {false, EXAMPLE_SAMPLE_RATE, 2};
+static struct host_codec_dev play_dev = {EXAMPLE_VOICE_VOLUME, false, 0};
+static struct host_codec_dev record_dev = {0, false, EXAMPLE_MIC_GAIN};
+
+i2s_chan_handle_t tx_handle = NULL;
+i2s_chan_handle_t rx_handle = NULL;
+esp_codec_dev_handle_t play_dev_handle = NULL;
+esp_codec_dev_handle_t record_dev_handle = NULL;
+
+esp_err_t i2s_driver_init(void)
+{
+    tx_handle = &tx_chan;
+    rx_handle = &rx_chan;
+    tx_chan.enabled = rx_chan.enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t es8311_codec_init(void)
+{
+    play_dev_handle = &play_dev;
+    record_dev_handle = &record_dev;
+    return ESP_OK;
+}
+
+void es8311_audio_shutdown_cleanup(void)
+{
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle)
+{
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (handle->enabled) return ESP_ERR_INVALID_STATE;
+    handle->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle)
+{
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (!handle->enabled) return ESP_ERR_INVALID_STATE;
+    handle->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_reconfig_std_clock(i2s_chan_handle_t handle, const i2s_std_clk_config_t *clk_cfg)
+{
+    if (!handle || handle->enabled) return handle ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_ARG;
+    handle->rate = clk_cfg->sample_rate_hz;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_reconfig_std_slot(i2s_chan_handle_t handle, const i2s_std_slot_config_t *slot_cfg)
+{
+    if (!handle || handle->enabled) return handle ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_ARG;
+    // Mono still clocks out both slots
+    uint32_t slot_bits = slot_cfg->slot_bit_width ? (uint32_t)slot_cfg->slot_bit_width
+                                                   : (uint32_t)slot_cfg->data_bit_width;
+    handle->frame_bytes = slot_bits / 8 * (slot_cfg->slot_mode == I2S_SLOT_MODE_STEREO ? 2 : 1);
+    return ESP_OK;
+}
+
+// Takes as long as the samples play
+static esp_err_t i2s_transfer(i2s_chan_handle_t handle, size_t size, size_t *done)
+{
+    if (!handle || !handle->enabled) return handle ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_ARG;
+    uint64_t bytes_per_s = (uint64_t)handle->rate * (handle->frame_bytes ? handle->frame_bytes : 2);
+    sim_sleep_us((int64_t)(size * 1000000ULL / (bytes_per_s ? bytes_per_s : 1)));
+    if (done) *done = size;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written,
+                            uint32_t timeout_ms)
+{
+    (void)src;
+    (void)timeout_ms;
+    return i2s_transfer(handle, size, bytes_written);
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read,
+                           uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    memset(dest, 0, size);
+    return i2s_transfer(handle, size, bytes_read);
+}
+
+int esp_codec_dev_set_out_vol(esp_codec_dev_handle_t codec, int volume)
+{
+    if (!codec) return -1;
+    codec->volume = volume;
+    return 0;
+}
+
+int esp_codec_dev_set_out_mute(esp_codec_dev_handle_t codec, bool mute)
+{
+    if (!codec) return -1;
+    codec->mute = mute;
+    return 0;
+}
+
+int esp_codec_dev_set_in_gain(esp_codec_dev_handle_t codec, float db_value)
+{
+    if (!codec) return -1;
+    codec->gain = db_value;
+    return 0;
+}
+
+/*---------- Audio player ----------*/
+
+/*
+ * Streams the file through the page's write callback at the rate of 16 kHz
+ * 16 bit mono, without decoding it: SD reads and pacing match a small MP3 or
+ * WAV closely enough for the pages, not the sound.
+ */
+
+#define PLAYER_CHUNK    4096
+
+static audio_player_config_t player_cfg;
+static audio_player_cb_t player_cb;
+static void *player_cb_ctx;
+static TaskHandle_t player_task;
+static SemaphoreHandle_t player_wake;
+static volatile audio_player_state_t player_state = AUDIO_PLAYER_STATE_SHUTDOWN;
+static FILE *player_fp;
+static bool player_stop;
+
+static void player_event(audio_player_callback_event_t event)
+{
+    if (player_cb) {
+        audio_player_cb_ctx_t ctx = {.audio_event = event, .user_ctx = player_cb_ctx};
+        player_cb(&ctx);
+    }
+}
+
+static void player_set_state(audio_player_state_t state, audio_player_callback_event_t event)
+{
+    player_state = state;
+    player_event(event);
+}
+
+static void audio_player_task(void *arg)
+{
+    static uint8_t chunk[PLAYER_CHUNK];
+    (void)arg;
+    for (;;) {
+        xSemaphoreTake(player_wake, portMAX_DELAY);
+        if (player_state == AUDIO_PLAYER_STATE_SHUTDOWN) break;
+
+        pthread_mutex_lock(&fake_lock);
+        FILE *fp = player_fp;
+        pthread_mutex_unlock(&fake_lock);
+        if (!fp) continue;
+
+        if (player_cfg.clk_set_fn) player_cfg.clk_set_fn(16000, 16, I2S_SLOT_MODE_MONO);
+        if (player_cfg.mute_fn) player_cfg.mute_fn(AUDIO_PLAYER_UNMUTE);
+        player_set_state(AUDIO_PLAYER_STATE_PLAYING, AUDIO_PLAYER_CALLBACK_EVENT_PLAYING);
+
+        size_t n;
+        while (!player_stop && (n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+            while (player_state == AUDIO_PLAYER_STATE_PAUSE && !player_stop) {
+                xSemaphoreTake(player_wake, pdMS_TO_TICKS(100));
+            }
+            size_t written = 0;
+            if (player_cfg.write_fn) player_cfg.write_fn(chunk, n, &written, portMAX_DELAY);
+        }
+
+        if (player_cfg.mute_fn) player_cfg.mute_fn(AUDIO_PLAYER_MUTE);
+        pthread_mutex_lock(&fake_lock);
+        if (player_fp == fp) player_fp = NULL;
+        player_stop = false;
+        pthread_mutex_unlock(&fake_lock);
+        fclose(fp);
+        if (player_state != AUDIO_PLAYER_STATE_SHUTDOWN) {
+            player_set_state(AUDIO_PLAYER_STATE_IDLE, AUDIO_PLAYER_CALLBACK_EVENT_IDLE);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_player_new(audio_player_config_t config)
+{
+    if (player_task) return ESP_OK;
+    player_cfg = config;
+    player_wake = xSemaphoreCreateBinary();
+    player_state = AUDIO_PLAYER_STATE_IDLE;
+    if (xTaskCreatePinnedToCore(audio_player_task, "audio_player", 4096, NULL, config.priority, &player_task,
+                                config.coreID) != pdPASS) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_player_delete()
+{
+    if (!player_task) return ESP_ERR_INVALID_STATE;
+    audio_player_stop();
+    player_state = AUDIO_PLAYER_STATE_SHUTDOWN;
+    player_event(AUDIO_PLAYER_CALLBACK_EVENT_SHUTDOWN);
+    xSemaphoreGive(player_wake);
+    player_task = NULL;
+    return ESP_OK;
+}
+
+audio_player_state_t audio_player_get_state()
+{
+    return player_state;
+}
+
+esp_err_t audio_player_callback_register(audio_player_cb_t call_back, void *user_ctx)
+{
+    player_cb = call_back;
+    player_cb_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t audio_player_play(FILE *fp)
+{
+    if (!player_task || !fp) return ESP_ERR_INVALID_STATE;
+    audio_player_stop();
+    pthread_mutex_lock(&fake_lock);
+    player_fp = fp;
+    pthread_mutex_unlock(&fake_lock);
+    xSemaphoreGive(player_wake);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_pause(void)
+{
+    if (player_state != AUDIO_PLAYER_STATE_PLAYING) return ESP_ERR_INVALID_STATE;
+    player_set_state(AUDIO_PLAYER_STATE_PAUSE, AUDIO_PLAYER_CALLBACK_EVENT_PAUSE);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_resume(void)
+{
+    if (player_state != AUDIO_PLAYER_STATE_PAUSE) return ESP_ERR_INVALID_STATE;
+    player_set_state(AUDIO_PLAYER_STATE_PLAYING, AUDIO_PLAYER_CALLBACK_EVENT_PLAYING);
+    xSemaphoreGive(player_wake);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_stop(void)
+{
+    pthread_mutex_lock(&fake_lock);
+    bool busy = player_fp != NULL;
+    if (busy) player_stop = true;
+    pthread_mutex_unlock(&fake_lock);
+    // Wait for the task to let go of the file
+    for (int i = 0; busy && i < 100; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        pthread_mutex_lock(&fake_lock);
+        busy = player_fp != NULL;
+        pthread_mutex_unlock(&fake_lock);
+    }
+    if (busy) ESP_LOGW(TAG, "The player did not stop");
+    return ESP_OK;
+}
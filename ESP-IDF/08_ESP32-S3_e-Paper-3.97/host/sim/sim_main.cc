@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "button_bsp.h"
+#include "shtc3_bsp.h"
+#include "pcf85063_bsp.h"
+#include "sdcard_bsp.h"
+#include "epaper_port.h"
+#include "mem_arena.h"
+#include "energy_prof.h"
+#include "axp_prot.h"
+#include "page_network.h"
+#include "file_browser.h"
+#include "page_weather.h"
+#include "page_clock.h"
+#include "page_alarm.h"
+#include "page_audio.h"
+#include "page_fiction.h"
+#include "boot_nodes.h"
+#include "sim.h"
+
+/*
+ * app_main of the simulator: brings the board up through the same boot
+ * graph as main.cc, then enters one page the way the home page does and
+ * runs it until the key script ends.
+ */
+
+// What main.cc defines for the pages
+SemaphoreHandle_t alarm_mutex = NULL;
+SemaphoreHandle_t nvs_mutex = NULL;
+SemaphoreHandle_t qmi8658_mutex = NULL;
+bool wifi_enable;
+uint8_t *Image_Mono;
+
+static const char *TAG = "sim";
+
+typedef struct {
+    const char *name;
+    void (*show)(void);
+} sim_page_t;
+
+static void fiction_page(void)
+{
+    page_fiction_file();
+}
+
+// The entries of the home page, in its order
+static const sim_page_t pages[] = {
+    {"files",    file_browser_task},
+    {"clock",    page_clock_show},
+    {"calendar", page_calendar_show},
+    {"alarm",    page_alarm_menu},
+    {"weather",  page_weather_city_select},
+    {"audio",    page_audio_main},
+    {"fiction",  fiction_page},
+};
+
+static void noop_init(void)
+{
+}
+
+static void boot_epd_init(void)
+{
+    epaper_port_init();
+    EPD_Init();
+    mem_arena_init();
+    if ((Image_Mono = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL) {
+        ESP_LOGE(TAG, "Failed to apply for black memory...");
+    }
+}
+
+static void boot_spiffs_init(void)
+{
+    spiffs_init();
+}
+
+// main.cc's table, with the I2C bus and the IMU left out
+static const boot_node_t boot_nodes[BOOT_NODE_NUM] = {
+    {"i2c",    noop_init,        0,                                        WAKE_ANY},
+    {"rtc",    PCF85063_init,    BOOT_BIT(BOOT_I2C),                       WAKE_ANY},
+    {"axp",    axp_init,         BOOT_BIT(BOOT_I2C),                       WAKE_ANY},
+    {"epd",    boot_epd_init,    BOOT_BIT(BOOT_AXP),                       WAKE_ANY},
+    {"shtc3",  i2c_shtc3_init,   BOOT_BIT(BOOT_I2C),                       WAKE_ANY},
+    {"button", button_Init,      0,                                        WAKE_HOME},
+    {"imu",    noop_init,        BOOT_BIT(BOOT_I2C),                       WAKE_HOME},
+    {"sd",     _sdcard_init,     0,                                        WAKE_HOME},
+    {"spiffs", boot_spiffs_init, BOOT_BIT(BOOT_SD),                        0},
+    {"audio",  page_audio_int,   BOOT_BIT(BOOT_I2C) | BOOT_BIT(BOOT_AXP),  0},
+};
+
+static const sim_page_t *page;
+
+static void page_task(void *arg)
+{
+    (void)arg;
+    ESP_ERROR_CHECK(boot_graph_init(boot_nodes, BOOT_NODE_NUM));
+    boot_graph_run(boot_graph_select(boot_nodes, BOOT_NODE_NUM, WAKE_HOME));
+
+    Paint_NewImage(Image_Mono, EPD_WIDTH, EPD_HEIGHT, 270, WHITE);
+    Paint_SetScale(2);
+    Paint_SelectImage(Image_Mono);
+    Paint_Clear(WHITE);
+    wifi_enable = load_wifi_enable_from_nvs();
+
+    // As user_Task() does on the way in and out of a page
+    boot_graph_run(BOOT_DEFERRED);
+    int scope = mem_scope_enter(page->name);
+    page->show();
+    mem_scope_leave(scope);
+    energy_prof_flush();
+    sim_finish("page returned");
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --page NAME --script FILE [options]\n"
+            "  --page NAME      files, clock, calendar, alarm, weather, audio or fiction\n"
+            "  --script FILE    key script, - for stdin (see sim/sim_script.c)\n"
+            "  --sd DIR         directory mounted at /sdcard (tools/make_sdcard.py)\n"
+            "  --spiffs DIR     directory mounted at /spiffs (default: main/page_weather)\n"
+            "  --nvs FILE       NVS contents, kept between runs (default: in memory)\n"
+            "  --frames DIR     write every refresh there as PBM/PGM\n"
+            "  --report FILE    write the measurements as JSON\n"
+            "  -v               log at INFO, -vv at DEBUG\n",
+            argv0);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option opts[] = {
+        {"page", required_argument, NULL, 'p'},
+        {"script", required_argument, NULL, 's'},
+        {"sd", required_argument, NULL, 'd'},
+        {"spiffs", required_argument, NULL, 'f'},
+        {"nvs", required_argument, NULL, 'n'},
+        {"frames", required_argument, NULL, 'o'},
+        {"report", required_argument, NULL, 'r'},
+        {NULL, 0, NULL, 0},
+    };
+    const char *page_name = NULL, *script = NULL;
+    sim_config.spiffs_dir = SIM_DEFAULT_SPIFFS_DIR;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "v", opts, NULL)) != -1) {
+        switch (opt) {
+        case 'p': page_name = optarg; break;
+        case 's': script = optarg; break;
+        case 'd': sim_config.sd_dir = optarg; break;
+        case 'f': sim_config.spiffs_dir = optarg; break;
+        case 'n': sim_config.nvs_path = optarg; break;
+        case 'o': sim_config.frames_dir = optarg; break;
+        case 'r': sim_config.report_path = optarg; break;
+        case 'v': sim_config.log_level = sim_config.log_level < ESP_LOG_INFO ? ESP_LOG_INFO : ESP_LOG_DEBUG; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (!page_name || !script || optind != argc) usage(argv[0]);
+    for (const sim_page_t &p : pages) {
+        if (strcmp(p.name, page_name) == 0) page = &p;
+    }
+    if (!page) usage(argv[0]);
+    if (!sim_script_load(script)) sim_fatal("cannot read %s", script);
+
+    if (sim_config.nvs_path) host_nvs_load(sim_config.nvs_path);
+    ESP_ERROR_CHECK(nvs_flash_init());
+    alarm_mutex = xSemaphoreCreateMutex();
+    nvs_mutex = xSemaphoreCreateMutex();
+    qmi8658_mutex = xSemaphoreCreateMutex();
+    energy_prof_init();
+
+    // The pages run in user_Task() with 12 KB on the device, the host needs more
+    xTaskCreate(page_task, "user_Task", 256 * 1024, NULL, 3, NULL);
+    for (;;) vTaskDelay(portMAX_DELAY);
+}
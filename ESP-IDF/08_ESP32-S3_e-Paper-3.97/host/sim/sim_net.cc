@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_sntp.h"
+#include "esp_http_client.h"
+#include "nvs.h"
+#include "page_network.h"
+#include "wifi_station.h"
+#include "sim.h"
+
+/*
+ * The network as the pages see it: a station that is up or down as the key
+ * script says, HTTP answered from files and an SNTP server that is the host
+ * clock. Nothing leaves the host.
+ */
+
+static const char *TAG = "sim_net";
+
+static std::atomic<bool> wifi_up{false};
+
+typedef struct {
+    std::string pattern;
+    std::string body;
+} http_fixture_t;
+
+static std::mutex fixture_lock;
+static std::vector<http_fixture_t> fixtures;
+
+// The certificate main/CMakeLists.txt embeds, never looked at here
+extern "C" {
+extern const char sim_api_root_cert[] asm("_binary_api_root_cert_pem_start") = "";
+extern const char sim_api_root_cert_end[] asm("_binary_api_root_cert_pem_end") = "";
+}
+
+extern "C" void sim_wifi_set(bool up)
+{
+    wifi_up = up;
+}
+
+extern "C" bool sim_wifi_up(void)
+{
+    return wifi_up;
+}
+
+extern "C" bool sim_http_add(const char *pattern, const char *file)
+{
+    FILE *fp = fopen(file, "rb");
+    if (!fp) return false;
+    std::string body;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) body.append(buf, n);
+    fclose(fp);
+
+    std::lock_guard<std::mutex> lock(fixture_lock);
+    fixtures.push_back({pattern, body});
+    return true;
+}
+
+/*---------- page_network ----------*/
+
+extern "C" bool wifi_is_connected(void)
+{
+    return wifi_up;
+}
+
+esp_err_t safe_wifi_stop()
+{
+    return ESP_OK;
+}
+
+esp_err_t safe_wifi_deinit()
+{
+    return ESP_OK;
+}
+
+void save_wifi_enable_to_nvs(bool enable)
+{
+    nvs_handle_t nvs_handle;
+    ESP_ERROR_CHECK(nvs_open("wifi_state", NVS_READWRITE, &nvs_handle));
+    ESP_ERROR_CHECK(nvs_set_u8(nvs_handle, "enable", enable ? 1 : 0));
+    ESP_ERROR_CHECK(nvs_commit(nvs_handle));
+    nvs_close(nvs_handle);
+}
+
+// The script's "wifi on" counts as enabled whatever NVS says
+bool load_wifi_enable_from_nvs()
+{
+    nvs_handle_t nvs_handle;
+    uint8_t enable = 0;
+    if (nvs_open("wifi_state", NVS_READONLY, &nvs_handle) == ESP_OK) {
+        nvs_get_u8(nvs_handle, "enable", &enable);
+        nvs_close(nvs_handle);
+    }
+    return enable != 0 || wifi_up;
+}
+
+void page_network_show(void)
+{
+}
+
+void page_network_config(void)
+{
+    ESP_LOGW(TAG, "provisioning is not simulated");
+}
+
+void page_network_init(void)
+{
+}
+
+void page_network_init_main(void)
+{
+}
+
+void page_handle_network_key_event()
+{
+}
+
+// The station associates at once, or not at all
+int page_network_init_mode(void)
+{
+    return wifi_up ? 1 : 0;
+}
+
+/*---------- WifiStation ----------*/
+
+WifiStation& WifiStation::GetInstance()
+{
+    static WifiStation instance;
+    return instance;
+}
+
+bool WifiStation::IsConnected()
+{
+    return wifi_up;
+}
+
+std::string WifiStation::ResolveHost(const std::string& host)
+{
+    return "";
+}
+
+void WifiStation::ForgetHost(const std::string& host)
+{
+}
+
+/*---------- esp_netif ----------*/
+
+struct host_netif {
+    int unused;
+};
+
+static host_netif sta_netif;
+
+extern "C" esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key)
+{
+    return strcmp(if_key, "WIFI_STA_DEF") == 0 ? &sta_netif : NULL;
+}
+
+extern "C" esp_err_t esp_netif_get_ip_info(esp_netif_t *netif, esp_netif_ip_info_t *ip_info)
+{
+    if (!netif || !ip_info) return ESP_ERR_INVALID_ARG;
+    memset(ip_info, 0, sizeof(*ip_info));
+    if (wifi_up) {
+        ip_info->ip.addr = 192u | 168u << 8 | 1u << 16 | 2u << 24;
+        ip_info->netmask.addr = 0x00FFFFFFu;
+        ip_info->gw.addr = 192u | 168u << 8 | 1u << 16 | 1u << 24;
+    }
+    return ESP_OK;
+}
+
+/*---------- SNTP ----------*/
+
+static sntp_sync_time_cb_t sntp_cb;
+
+extern "C" void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode)
+{
+}
+
+extern "C" void esp_sntp_setservername(int idx, const char *server)
+{
+}
+
+extern "C" void sntp_set_sync_mode(sntp_sync_mode_t mode)
+{
+}
+
+extern "C" void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb)
+{
+    sntp_cb = cb;
+}
+
+// The system clock is the host's already, there is nothing to set
+extern "C" void esp_sntp_init(void)
+{
+    if (!wifi_up || !sntp_cb) return;
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    sntp_cb(&tv);
+}
+
+extern "C" void esp_sntp_stop(void)
+{
+}
+
+/*---------- esp_http_client ----------*/
+
+struct host_http_client {
+    std::string url;
+    http_event_handle_cb handler;
+    void *user_data;
+    const std::string *body;    // Set once connected
+    size_t pos;
+};
+
+extern "C" esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    if (!config || !config->url) return NULL;
+    host_http_client *client = new host_http_client();
+    client->url = config->url;
+    client->handler = config->event_handler;
+    client->user_data = config->user_data;
+    return client;
+}
+
+extern "C" esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    return client ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    if (!client || !url) return ESP_ERR_INVALID_ARG;
+    client->url = url;
+    return ESP_OK;
+}
+
+static void http_event(esp_http_client_handle_t client, esp_http_client_event_id_t id, const void *data, int len)
+{
+    if (!client->handler) return;
+    esp_http_client_event_t evt = {};
+    evt.event_id = id;
+    evt.client = client;
+    evt.data = const_cast<void *>(data);
+    evt.data_len = len;
+    evt.user_data = client->user_data;
+    client->handler(&evt);
+}
+
+extern "C" esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    if (!client) return ESP_ERR_INVALID_ARG;
+    delete client->body;
+    client->body = NULL;
+    client->pos = 0;
+    if (wifi_up) {
+        // A copy, the script may add fixtures while the request runs
+        std::lock_guard<std::mutex> lock(fixture_lock);
+        for (const http_fixture_t &f : fixtures) {
+            if (client->url.find(f.pattern) != std::string::npos) {
+                client->body = new std::string(f.body);
+                break;
+            }
+        }
+    }
+    if (!client->body) {
+        ESP_LOGW(TAG, "no answer for %s", client->url.c_str());
+        http_event(client, HTTP_EVENT_ERROR, NULL, 0);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "GET %s: %d bytes", client->url.c_str(), (int)client->body->size());
+    http_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+    return ESP_OK;
+}
+
+extern "C" int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    if (!client || !client->body) return -1;
+    return (int64_t)client->body->size();
+}
+
+extern "C" int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    if (!client || !client->body || len <= 0) return client && client->body ? 0 : -1;
+    size_t n = client->body->size() - client->pos;
+    if (n > (size_t)len) n = (size_t)len;
+    memcpy(buffer, client->body->data() + client->pos, n);
+    client->pos += n;
+    return (int)n;
+}
+
+extern "C" int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client && client->body ? 200 : 0;
+}
+
+extern "C" int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return esp_http_client_fetch_headers(client);
+}
+
+extern "C" esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    if (!client) return ESP_ERR_INVALID_ARG;
+    if (client->body) http_event(client, HTTP_EVENT_DISCONNECTED, NULL, 0);
+    delete client->body;
+    client->body = NULL;
+    return ESP_OK;
+}
+
+// The body goes to the handler in chunks of the default buffer size
+extern "C" esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) return err;
+    const std::string &body = *client->body;
+    for (size_t off = 0; off < body.size(); off += 512) {
+        size_t n = body.size() - off < 512 ? body.size() - off : 512;
+        http_event(client, HTTP_EVENT_ON_DATA, body.data() + off, (int)n);
+    }
+    http_event(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    return esp_http_client_close(client);
+}
+
+extern "C" esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (!client) return ESP_ERR_INVALID_ARG;
+    delete client->body;
+    delete client;
+    return ESP_OK;
+}
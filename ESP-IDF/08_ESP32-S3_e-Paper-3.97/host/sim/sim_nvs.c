@@ -0,0 +1,344 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "sim.h"
+
+/*
+ * NVS in memory, saved to a text file on commit: one entry per line,
+ * "namespace key type hex-bytes". Entries are found by name and type like on
+ * flash, and a set replaces the entry whatever its old type was.
+ */
+
+#define NVS_MAX_ENTRIES     128
+#define NVS_MAX_HANDLES     32
+#define NVS_NAME_LEN        NVS_KEY_NAME_MAX_SIZE
+
+typedef enum {
+    T_I8, T_U8, T_I16, T_U16, T_I32, T_U32, T_I64, T_U64, T_STR, T_BLOB, T_COUNT
+} nvs_type_t;
+
+static const char *const type_names[T_COUNT] = {
+    "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "str", "blob",
+};
+
+typedef struct {
+    char ns[NVS_NAME_LEN];
+    char key[NVS_NAME_LEN];
+    nvs_type_t type;
+    size_t len;
+    uint8_t *data;
+} nvs_entry_t;
+
+typedef struct {
+    bool used;
+    char ns[NVS_NAME_LEN];
+    nvs_open_mode_t mode;
+} nvs_open_t;
+
+static const char *TAG = "sim_nvs";
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static nvs_entry_t entries[NVS_MAX_ENTRIES];
+static int entry_count;
+static nvs_open_t handles[NVS_MAX_HANDLES];
+static bool initialised;
+static const char *store_path;
+
+static nvs_entry_t *find(const char *ns, const char *key)
+{
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].ns, ns) == 0 && strcmp(entries[i].key, key) == 0) return &entries[i];
+    }
+    return NULL;
+}
+
+static bool ns_exists(const char *ns)
+{
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].ns, ns) == 0) return true;
+    }
+    return false;
+}
+
+static void drop(nvs_entry_t *e)
+{
+    free(e->data);
+    *e = entries[--entry_count];
+}
+
+static esp_err_t put(const char *ns, const char *key, nvs_type_t type, const void *data, size_t len)
+{
+    nvs_entry_t *e = find(ns, key);
+    if (!e) {
+        if (entry_count == NVS_MAX_ENTRIES) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        e = &entries[entry_count++];
+        memset(e, 0, sizeof(*e));
+        snprintf(e->ns, sizeof(e->ns), "%s", ns);
+        snprintf(e->key, sizeof(e->key), "%s", key);
+    }
+    uint8_t *copy = malloc(len ? len : 1);
+    memcpy(copy, data, len);
+    free(e->data);
+    e->data = copy;
+    e->len = len;
+    e->type = type;
+    return ESP_OK;
+}
+
+static void save(void)
+{
+    if (!store_path) return;
+    char tmp[SIM_PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", store_path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        ESP_LOGE(TAG, "Cannot write %s", tmp);
+        return;
+    }
+    for (int i = 0; i < entry_count; i++) {
+        const nvs_entry_t *e = &entries[i];
+        fprintf(fp, "%s %s %s ", e->ns, e->key, type_names[e->type]);
+        for (size_t j = 0; j < e->len; j++) fprintf(fp, "%02x", e->data[j]);
+        fputc('\n', fp);
+    }
+    fclose(fp);
+    rename(tmp, store_path);
+}
+
+esp_err_t host_nvs_load(const char *path)
+{
+    store_path = path;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return ESP_ERR_NOT_FOUND;     // A new store
+
+    char line[8192];
+    int lineno = 0;
+    pthread_mutex_lock(&nvs_lock);
+    while (fgets(line, sizeof(line), fp)) {
+        char ns[NVS_NAME_LEN], key[NVS_NAME_LEN], type[8], hex[sizeof(line)];
+        lineno++;
+        hex[0] = '\0';
+        if (sscanf(line, "%15s %15s %7s %8191s", ns, key, type, hex) < 3) {
+            ESP_LOGW(TAG, "%s:%d: not an entry", path, lineno);
+            continue;
+        }
+        int t;
+        for (t = 0; t < T_COUNT && strcmp(type, type_names[t]) != 0; t++) {
+        }
+        size_t len = strlen(hex) / 2;
+        uint8_t *data = malloc(len ? len : 1);
+        for (size_t i = 0; i < len; i++) {
+            unsigned v;
+            sscanf(hex + 2 * i, "%2x", &v);
+            data[i] = (uint8_t)v;
+        }
+        if (t == T_COUNT) {
+            ESP_LOGW(TAG, "%s:%d: unknown type %s", path, lineno, type);
+        } else {
+            put(ns, key, (nvs_type_t)t, data, len);
+        }
+        free(data);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    fclose(fp);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    initialised = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_deinit(void)
+{
+    initialised = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    while (entry_count) drop(&entries[0]);
+    save();
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+/*---------- Handles ----------*/
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+    if (!initialised) return ESP_ERR_NVS_NOT_INITIALIZED;
+    if (strlen(name) >= NVS_NAME_LEN) return ESP_ERR_NVS_KEY_TOO_LONG;
+
+    esp_err_t err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    pthread_mutex_lock(&nvs_lock);
+    if (mode == NVS_READONLY && !ns_exists(name)) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else {
+        for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+            if (!handles[i].used) {
+                handles[i].used = true;
+                handles[i].mode = mode;
+                snprintf(handles[i].ns, sizeof(handles[i].ns), "%s", name);
+                *out = (nvs_handle_t)(i + 1);
+                err = ESP_OK;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    if (err == ESP_ERR_NVS_NOT_ENOUGH_SPACE) ESP_LOGE(TAG, "Out of handles, one is never closed?");
+    return err;
+}
+
+static nvs_open_t *handle_of(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > NVS_MAX_HANDLES || !handles[handle - 1].used) return NULL;
+    return &handles[handle - 1];
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_open_t *h = handle_of(handle);
+    if (h) h->used = false;
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t err = handle_of(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+    if (err == ESP_OK) save();
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_open_t *h = handle_of(handle);
+    if (!h) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (h->mode == NVS_READONLY) {
+        err = ESP_ERR_NVS_READ_ONLY;
+    } else {
+        nvs_entry_t *e = find(h->ns, key);
+        if (e) {
+            drop(e);
+        } else {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_open_t *h = handle_of(handle);
+    if (!h) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (h->mode == NVS_READONLY) {
+        err = ESP_ERR_NVS_READ_ONLY;
+    } else {
+        for (int i = entry_count - 1; i >= 0; i--) {
+            if (strcmp(entries[i].ns, h->ns) == 0) drop(&entries[i]);
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+/*---------- Values ----------*/
+
+static esp_err_t set(nvs_handle_t handle, const char *key, nvs_type_t type, const void *data, size_t len)
+{
+    if (strlen(key) >= NVS_NAME_LEN) return ESP_ERR_NVS_KEY_TOO_LONG;
+    esp_err_t err;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_open_t *h = handle_of(handle);
+    if (!h) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (h->mode == NVS_READONLY) {
+        err = ESP_ERR_NVS_READ_ONLY;
+    } else {
+        err = put(h->ns, key, type, data, len);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+// Fixed size values: *len is the size wanted. Variable ones: out may be NULL
+static esp_err_t get(nvs_handle_t handle, const char *key, nvs_type_t type, void *out, size_t *len, bool fixed)
+{
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_open_t *h = handle_of(handle);
+    nvs_entry_t *e = h ? find(h->ns, key) : NULL;
+    if (!h) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (!e || e->type != type) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (fixed) {
+        memcpy(out, e->data, *len);
+    } else if (!out) {
+        *len = e->len;
+    } else if (*len < e->len) {
+        *len = e->len;
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out, e->data, e->len);
+        *len = e->len;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+#define NVS_INT(suffix, ctype, tag)                                                     \
+    esp_err_t nvs_set_##suffix(nvs_handle_t handle, const char *key, ctype value)       \
+    {                                                                                   \
+        return set(handle, key, tag, &value, sizeof(value));                            \
+    }                                                                                   \
+    esp_err_t nvs_get_##suffix(nvs_handle_t handle, const char *key, ctype *out)        \
+    {                                                                                   \
+        size_t len = sizeof(*out);                                                      \
+        return get(handle, key, tag, out, &len, true);                                  \
+    }
+
+NVS_INT(i8, int8_t, T_I8)
+NVS_INT(u8, uint8_t, T_U8)
+NVS_INT(i16, int16_t, T_I16)
+NVS_INT(u16, uint16_t, T_U16)
+NVS_INT(i32, int32_t, T_I32)
+NVS_INT(u32, uint32_t, T_U32)
+NVS_INT(i64, int64_t, T_I64)
+NVS_INT(u64, uint64_t, T_U64)
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    return set(handle, key, T_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set(handle, key, T_BLOB, value, length);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out, size_t *length)
+{
+    return get(handle, key, T_STR, out, length, false);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length)
+{
+    return get(handle, key, T_BLOB, out, length, false);
+}
@@ -0,0 +1,267 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "sim.h"
+
+/*
+ * Per key measurements. A key runs from the moment it is handed to the
+ * firmware until the firmware asks for the next one; what was read, written
+ * and shown meanwhile is charged to it. Keys are grouped in sections started
+ * by "mark" in the script, and each section gets its distribution.
+ */
+
+#define SIM_MAX_SECTIONS    64
+#define SIM_LABEL_LEN       48
+
+typedef struct {
+    int code;
+    int64_t first_frame_us;     // -1: the key showed nothing
+    int64_t total_us;
+    uint32_t frames;
+    sim_io_stats_t io;
+} key_rec_t;
+
+typedef struct {
+    char label[SIM_LABEL_LEN];
+    key_rec_t *keys;
+    size_t count, cap;
+} section_t;
+
+typedef struct {
+    char mode[8];
+    uint32_t crc;
+    int64_t at_us;
+} frame_rec_t;
+
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+static section_t sections[SIM_MAX_SECTIONS] = {{.label = "start"}};
+static int section_count = 1;
+static frame_rec_t *frame_log;
+static size_t frame_count, frame_cap;
+
+static bool key_open;
+static key_rec_t key_now;
+static int64_t key_start_us;
+static sim_io_stats_t key_start_io;
+static uint32_t key_start_frames;
+
+static void *grow(void *p, size_t *cap, size_t need, size_t elem)
+{
+    if (need <= *cap) return p;
+    *cap = *cap ? *cap * 2 : 64;
+    p = realloc(p, *cap * elem);
+    if (!p) sim_fatal("out of memory");
+    return p;
+}
+
+void sim_report_key(int code)
+{
+    pthread_mutex_lock(&report_lock);
+    key_open = true;
+    memset(&key_now, 0, sizeof(key_now));
+    key_now.code = code;
+    key_now.first_frame_us = -1;
+    key_start_us = sim_now_us();
+    sim_io_get(&key_start_io);
+    key_start_frames = sim_frame_count();
+    pthread_mutex_unlock(&report_lock);
+}
+
+void sim_report_wait(void)
+{
+    sim_io_stats_t io;
+    uint32_t frames = sim_frame_count();
+    sim_io_get(&io);
+
+    pthread_mutex_lock(&report_lock);
+    if (key_open) {
+        key_open = false;
+        key_now.total_us = sim_now_us() - key_start_us;
+        key_now.frames = frames - key_start_frames;
+        key_now.io.opens = io.opens - key_start_io.opens;
+        key_now.io.reads = io.reads - key_start_io.reads;
+        key_now.io.read_bytes = io.read_bytes - key_start_io.read_bytes;
+        key_now.io.writes = io.writes - key_start_io.writes;
+        key_now.io.write_bytes = io.write_bytes - key_start_io.write_bytes;
+        key_now.io.seeks = io.seeks - key_start_io.seeks;
+        key_now.io.dir_ops = io.dir_ops - key_start_io.dir_ops;
+
+        section_t *s = &sections[section_count - 1];
+        s->keys = grow(s->keys, &s->cap, s->count + 1, sizeof(key_rec_t));
+        s->keys[s->count++] = key_now;
+    }
+    pthread_mutex_unlock(&report_lock);
+}
+
+void sim_report_frame(const char *mode, uint32_t crc)
+{
+    pthread_mutex_lock(&report_lock);
+    int64_t now = sim_now_us();
+    if (key_open && key_now.first_frame_us < 0) key_now.first_frame_us = now - key_start_us;
+    frame_log = grow(frame_log, &frame_cap, frame_count + 1, sizeof(frame_rec_t));
+    frame_rec_t *f = &frame_log[frame_count++];
+    snprintf(f->mode, sizeof(f->mode), "%s", mode);
+    f->crc = crc;
+    f->at_us = now;
+    pthread_mutex_unlock(&report_lock);
+}
+
+void sim_report_mark(const char *label)
+{
+    pthread_mutex_lock(&report_lock);
+    if (section_count == SIM_MAX_SECTIONS) {
+        ESP_LOGW("sim_report", "Too many sections, \"%s\" goes into the last one", label);
+    } else {
+        section_t *s = &sections[section_count++];
+        snprintf(s->label, sizeof(s->label), "%s", label);
+    }
+    pthread_mutex_unlock(&report_lock);
+}
+
+/*---------- Output ----------*/
+
+typedef struct {
+    double mean, p50, p95, max;
+} dist_t;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentiles
+static dist_t distribution(double *v, size_t n)
+{
+    dist_t d = {0, 0, 0, 0};
+    if (n == 0) return d;
+    qsort(v, n, sizeof(*v), cmp_double);
+    for (size_t i = 0; i < n; i++) d.mean += v[i];
+    d.mean /= (double)n;
+    d.p50 = v[(n * 50 + 99) / 100 - 1];
+    d.p95 = v[(n * 95 + 99) / 100 - 1];
+    d.max = v[n - 1];
+    return d;
+}
+
+typedef enum {
+    F_TOTAL_MS, F_FIRST_FRAME_MS, F_OPENS, F_READS, F_READ_KB, F_SEEKS, F_WRITES, F_COUNT
+} field_t;
+
+static const char *const field_names[F_COUNT] = {
+    "total_ms", "first_frame_ms", "opens", "reads", "read_kb", "seeks", "writes",
+};
+
+static double field(const key_rec_t *k, field_t f)
+{
+    switch (f) {
+    case F_TOTAL_MS:        return k->total_us / 1000.0;
+    case F_FIRST_FRAME_MS:  return k->first_frame_us / 1000.0;
+    case F_OPENS:           return k->io.opens;
+    case F_READS:           return k->io.reads;
+    case F_READ_KB:         return k->io.read_bytes / 1024.0;
+    case F_SEEKS:           return k->io.seeks;
+    case F_WRITES:          return k->io.writes;
+    default:                return 0;
+    }
+}
+
+static dist_t section_field(const section_t *s, field_t f, size_t *n_out)
+{
+    double *v = malloc((s->count ? s->count : 1) * sizeof(double));
+    size_t n = 0;
+    for (size_t i = 0; i < s->count; i++) {
+        // Keys that drew nothing have no first frame
+        if (f == F_FIRST_FRAME_MS && s->keys[i].first_frame_us < 0) continue;
+        v[n++] = field(&s->keys[i], f);
+    }
+    dist_t d = distribution(v, n);
+    free(v);
+    if (n_out) *n_out = n;
+    return d;
+}
+
+static void write_json(FILE *fp, const char *reason)
+{
+    sim_io_stats_t io;
+    sim_frame_stats_t fr;
+    sim_io_get(&io);
+    sim_frames_get(&fr);
+
+    fprintf(fp, "{\n  \"end\": \"%s\",\n  \"elapsed_ms\": %.1f,\n", reason, sim_now_us() / 1000.0);
+    fprintf(fp, "  \"io\": {\"opens\": %lu, \"reads\": %lu, \"read_bytes\": %llu, \"writes\": %lu, "
+            "\"write_bytes\": %llu, \"seeks\": %lu, \"dir_ops\": %lu},\n",
+            (unsigned long)io.opens, (unsigned long)io.reads, (unsigned long long)io.read_bytes,
+            (unsigned long)io.writes, (unsigned long long)io.write_bytes, (unsigned long)io.seeks,
+            (unsigned long)io.dir_ops);
+    fprintf(fp, "  \"frames\": {\"full\": %lu, \"partial\": %lu, \"gray\": %lu},\n", (unsigned long)fr.full,
+            (unsigned long)fr.partial, (unsigned long)fr.gray);
+
+    fprintf(fp, "  \"sections\": [");
+    for (int i = 0; i < section_count; i++) {
+        const section_t *s = &sections[i];
+        fprintf(fp, "%s\n    {\"label\": \"%s\", \"keys\": %zu", i ? "," : "", s->label, s->count);
+        for (int f = 0; f < F_COUNT; f++) {
+            dist_t d = section_field(s, (field_t)f, NULL);
+            fprintf(fp, ", \"%s\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"max\": %.3f}", field_names[f],
+                    d.mean, d.p50, d.p95, d.max);
+        }
+        fprintf(fp, ",\n     \"per_key\": [");
+        for (size_t k = 0; k < s->count; k++) {
+            const key_rec_t *r = &s->keys[k];
+            fprintf(fp, "%s\n       {\"key\": %d, \"total_ms\": %.3f, \"first_frame_ms\": %.3f, \"frames\": %lu, "
+                    "\"opens\": %lu, \"reads\": %lu, \"read_bytes\": %llu, \"seeks\": %lu, \"writes\": %lu}",
+                    k ? "," : "", r->code, r->total_us / 1000.0, r->first_frame_us / 1000.0,
+                    (unsigned long)r->frames, (unsigned long)r->io.opens, (unsigned long)r->io.reads,
+                    (unsigned long long)r->io.read_bytes, (unsigned long)r->io.seeks, (unsigned long)r->io.writes);
+        }
+        fprintf(fp, "]}");
+    }
+    fprintf(fp, "\n  ],\n  \"frame_log\": [");
+    for (size_t i = 0; i < frame_count; i++) {
+        fprintf(fp, "%s\n    {\"mode\": \"%s\", \"crc\": \"%08lx\", \"at_ms\": %.1f}", i ? "," : "",
+                frame_log[i].mode, (unsigned long)frame_log[i].crc, frame_log[i].at_us / 1000.0);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+void sim_report_write(const char *reason)
+{
+    sim_io_stats_t io;
+    sim_frame_stats_t fr;
+    sim_io_get(&io);
+    sim_frames_get(&fr);
+
+    pthread_mutex_lock(&report_lock);
+    printf("end: %s after %.1f s\n", reason, sim_now_us() / 1e6);
+    printf("frames: %lu full, %lu partial, %lu gray\n", (unsigned long)fr.full, (unsigned long)fr.partial,
+           (unsigned long)fr.gray);
+    printf("io: %lu opens, %lu reads (%.1f KB), %lu writes (%.1f KB), %lu seeks, %lu dir ops\n",
+           (unsigned long)io.opens, (unsigned long)io.reads, io.read_bytes / 1024.0, (unsigned long)io.writes,
+           io.write_bytes / 1024.0, (unsigned long)io.seeks, (unsigned long)io.dir_ops);
+
+    for (int i = 0; i < section_count; i++) {
+        const section_t *s = &sections[i];
+        if (s->count == 0) continue;
+        printf("\n[%s] %zu keys          mean      p50      p95      max\n", s->label, s->count);
+        for (int f = 0; f < F_COUNT; f++) {
+            size_t n;
+            dist_t d = section_field(s, (field_t)f, &n);
+            if (n == 0) continue;
+            printf("  %-16s %8.2f %8.2f %8.2f %8.2f\n", field_names[f], d.mean, d.p50, d.p95, d.max);
+        }
+    }
+
+    if (sim_config.report_path) {
+        FILE *fp = fopen(sim_config.report_path, "w");
+        if (fp) {
+            write_json(fp, reason);
+            fclose(fp);
+        } else {
+            ESP_LOGE("sim_report", "Cannot write %s", sim_config.report_path);
+        }
+    }
+    pthread_mutex_unlock(&report_lock);
+}
@@ -0,0 +1,258 @@
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "button_bsp.h"
+#include "sim.h"
+
+/*
+ * The key script, one command per line ('#' starts a comment):
+ *
+ *   key <name|code> [xN]     hand a key to the firmware, N times
+ *   idle <ms>                no key for that long: key waits time out and the
+ *                            RTC moves on, without the host waiting
+ *   sleep <ms>               no key for that long, in real time
+ *   time YYYY-MM-DD HH:MM:SS set the RTC
+ *   battery <percent> [usb]
+ *   env <celsius> <rh>
+ *   wifi on|off
+ *   http <url part> <file>   requests whose URL contains the part get the file
+ *   mark <label>             start a new section of the report
+ *   snapshot <file>          write what the panel shows
+ *   end                      stop here
+ *
+ * Key names are up, fn, down and boot for a click, with "2" appended for a
+ * double click and "long" for a long press (uplong, fn2, ...).
+ */
+
+typedef enum {
+    CMD_KEY, CMD_IDLE, CMD_SLEEP, CMD_TIME, CMD_BATTERY, CMD_ENV, CMD_WIFI, CMD_HTTP, CMD_MARK, CMD_SNAPSHOT, CMD_END
+} cmd_op_t;
+
+typedef struct {
+    cmd_op_t op;
+    int line;
+    long a, b;
+    float f1, f2;
+    char *s1, *s2;
+} cmd_t;
+
+static const struct {
+    const char *name;
+    int code;
+} key_names[] = {
+    {"up", 0}, {"up2", 1}, {"uplong", 5},
+    {"fn", 7}, {"fn2", 8}, {"fnlong", 12},
+    {"down", 14}, {"down2", 15}, {"downlong", 19},
+    {"boot", 21}, {"boot2", 22}, {"bootlong", 23},
+};
+
+static const char *TAG = "sim_script";
+static cmd_t *cmds;
+static size_t cmd_count, cmd_cap;
+static size_t pc;
+static long repeat_left;            // Keys of the current command still to hand out
+static int64_t idle_left_us;
+static int64_t sleep_until_us = -1;
+static const char *script_path;
+
+EventGroupHandle_t key_groups;
+
+static int key_code(const char *s)
+{
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (*s && !*end) return v >= 0 && v < 24 ? (int)v : -1;
+    for (size_t i = 0; i < sizeof(key_names) / sizeof(key_names[0]); i++) {
+        if (strcasecmp(s, key_names[i].name) == 0) return key_names[i].code;
+    }
+    return -1;
+}
+
+static void bad_line(int line, const char *what)
+{
+    sim_fatal("%s:%d: %s", script_path, line, what);
+}
+
+static void parse(char *text, int line)
+{
+    char *hash = strchr(text, '#');
+    if (hash) *hash = '\0';
+    char *argv[4] = {0};
+    int argc = 0;
+    for (char *tok = strtok(text, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+        if (argc == 4) bad_line(line, "too many arguments");
+        argv[argc++] = tok;
+    }
+    if (argc == 0) return;
+
+    cmd_t c = {.line = line};
+    const char *op = argv[0];
+    if (strcmp(op, "key") == 0 && (argc == 2 || argc == 3)) {
+        c.op = CMD_KEY;
+        c.a = key_code(argv[1]);
+        c.b = 1;
+        if (c.a < 0) bad_line(line, "unknown key");
+        if (argc == 3 && (argv[2][0] != 'x' || (c.b = strtol(argv[2] + 1, NULL, 10)) <= 0)) {
+            bad_line(line, "expected xN");
+        }
+    } else if ((strcmp(op, "idle") == 0 || strcmp(op, "sleep") == 0) && argc == 2) {
+        c.op = op[0] == 'i' ? CMD_IDLE : CMD_SLEEP;
+        c.a = strtol(argv[1], NULL, 10);
+    } else if (strcmp(op, "time") == 0 && argc == 3) {
+        struct tm tm = {0};
+        char both[64];
+        snprintf(both, sizeof(both), "%s %s", argv[1], argv[2]);
+        if (!strptime(both, "%Y-%m-%d %H:%M:%S", &tm)) bad_line(line, "expected YYYY-MM-DD HH:MM:SS");
+        c.op = CMD_TIME;
+        c.a = (long)timegm(&tm);
+    } else if (strcmp(op, "battery") == 0 && (argc == 2 || argc == 3)) {
+        c.op = CMD_BATTERY;
+        c.a = strtol(argv[1], NULL, 10);
+        c.b = argc == 3 && strcmp(argv[2], "usb") == 0;
+    } else if (strcmp(op, "env") == 0 && argc == 3) {
+        c.op = CMD_ENV;
+        c.f1 = strtof(argv[1], NULL);
+        c.f2 = strtof(argv[2], NULL);
+    } else if (strcmp(op, "wifi") == 0 && argc == 2) {
+        c.op = CMD_WIFI;
+        c.a = strcmp(argv[1], "on") == 0;
+    } else if (strcmp(op, "http") == 0 && argc == 3) {
+        c.op = CMD_HTTP;
+        c.s1 = strdup(argv[1]);
+        c.s2 = strdup(argv[2]);
+    } else if (strcmp(op, "mark") == 0 && argc == 2) {
+        c.op = CMD_MARK;
+        c.s1 = strdup(argv[1]);
+    } else if (strcmp(op, "snapshot") == 0 && argc == 2) {
+        c.op = CMD_SNAPSHOT;
+        c.s1 = strdup(argv[1]);
+    } else if (strcmp(op, "end") == 0 && argc == 1) {
+        c.op = CMD_END;
+    } else {
+        bad_line(line, "unknown command or wrong arguments");
+    }
+
+    if (cmd_count == cmd_cap) {
+        cmd_cap = cmd_cap ? cmd_cap * 2 : 64;
+        cmds = realloc(cmds, cmd_cap * sizeof(cmd_t));
+    }
+    cmds[cmd_count++] = c;
+}
+
+bool sim_script_load(const char *path)
+{
+    FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!fp) return false;
+    script_path = path;
+    char line[512];
+    for (int n = 1; fgets(line, sizeof(line), fp); n++) parse(line, n);
+    if (fp != stdin) fclose(fp);
+    return true;
+}
+
+// Commands that take no time. Returns false at the end of the script
+static bool run_settings(void)
+{
+    while (pc < cmd_count) {
+        const cmd_t *c = &cmds[pc];
+        switch (c->op) {
+        case CMD_TIME:      sim_rtc_set((time_t)c->a); break;
+        case CMD_BATTERY:   sim_battery_set((int)c->a, c->b != 0); break;
+        case CMD_ENV:       sim_env_set(c->f1, c->f2); break;
+        case CMD_WIFI:      sim_wifi_set(c->a != 0); break;
+        case CMD_MARK:      sim_report_mark(c->s1); break;
+        case CMD_HTTP:
+            if (!sim_http_add(c->s1, c->s2)) bad_line(c->line, "cannot read the response file");
+            break;
+        case CMD_SNAPSHOT:
+            if (!sim_epd_snapshot(c->s1)) bad_line(c->line, "cannot write the snapshot");
+            break;
+        case CMD_END:       return false;
+        default:            return true;
+        }
+        pc++;
+    }
+    return false;
+}
+
+void button_Init(void)
+{
+    if (!key_groups) key_groups = xEventGroupCreate();
+}
+
+int wait_key_event_and_return_code(TickType_t timeout)
+{
+    // Whatever the firmware did since the last key is charged to it
+    sim_report_wait();
+
+    for (;;) {
+        // Events set by the firmware itself come first
+        if (key_groups) {
+            EventBits_t bits = xEventGroupWaitBits(key_groups, set_bit_all, pdTRUE, pdFALSE, 0);
+            for (int i = 0; i < 24; i++) {
+                if (get_bit_button(bits, i)) return i;
+            }
+        }
+
+        if (idle_left_us > 0) {
+            int64_t step = timeout == portMAX_DELAY ? idle_left_us : (int64_t)pdTICKS_TO_MS(timeout) * 1000;
+            if (step < 1000) step = 1000;
+            if (step > idle_left_us) step = idle_left_us;
+            idle_left_us -= step;
+            sim_rtc_advance_us(step);
+            if (timeout != portMAX_DELAY) {
+                // Let the other tasks see the time go by
+                vTaskDelay(0);
+                return -1;
+            }
+            continue;
+        }
+
+        if (sleep_until_us >= 0) {
+            int64_t left = sleep_until_us - sim_now_us();
+            if (left <= 0) {
+                sleep_until_us = -1;
+                continue;
+            }
+            int64_t step = timeout == portMAX_DELAY ? left : (int64_t)pdTICKS_TO_MS(timeout) * 1000;
+            if (step > left) step = left;
+            sim_sleep_us(step);
+            if (timeout != portMAX_DELAY) return -1;
+            continue;
+        }
+
+        if (repeat_left > 0) {
+            repeat_left--;
+            if (repeat_left == 0) pc++;
+            int code = (int)cmds[pc - (repeat_left == 0)].a;
+            ESP_LOGD(TAG, "key %d", code);
+            sim_report_key(code);
+            return code;
+        }
+
+        if (!run_settings()) sim_finish("end of script");
+        const cmd_t *c = &cmds[pc];
+        switch (c->op) {
+        case CMD_KEY:
+            repeat_left = c->b;
+            break;
+        case CMD_IDLE:
+            idle_left_us = (int64_t)c->a * 1000;
+            pc++;
+            break;
+        case CMD_SLEEP:
+            sleep_until_us = sim_now_us() + (int64_t)c->a * 1000;
+            pc++;
+            break;
+        default:
+            sim_fatal("script command %d out of place", (int)c->op);
+        }
+    }
+}
@@ -0,0 +1,584 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_vfs_fat.h"
+#include "esp_spiffs.h"
+#include "sdmmc_cmd.h"
+#include "ff.h"
+#include "sim.h"
+
+/*
+ * /sdcard and /spiffs on host directories. The libc calls the firmware makes
+ * are redirected here with ld --wrap. Files under a mount are stdio streams
+ * over a cookie with the 128 byte buffer of ESP-IDF's newlib, so every cookie
+ * call is one VFS call on the device; those are what the I/O counts count.
+ * Like FAT, names match case-insensitively and a mount has a limited number
+ * of open files.
+ *
+ * sim_power_cut_after() makes the card lose power part way through the
+ * writes to come, for testing what the firmware finds on the next boot.
+ * fsync() of a card file only checks for that: fflush() has already handed
+ * the bytes to the host, which is all a cut is simulated against.
+ */
+
+#define SIM_STDIO_BUF       128
+#define SIM_SD_MAX_FILES    5           // mount_config.max_files of _sdcard_init()
+#define SIM_DIR_SLOTS       16
+
+typedef struct {
+    const char *prefix;
+    const char **dir;
+    int max_files;
+    int open_files;
+    bool mounted;
+} sim_mount_t;
+
+typedef struct sim_cookie {
+    int fd;
+    sim_mount_t *mount;
+    FILE *fp;
+    struct sim_cookie *next;    // Open streams, for fileno()
+} sim_cookie_t;
+
+static sim_mount_t mounts[] = {
+    {"/sdcard", &sim_config.sd_dir, SIM_SD_MAX_FILES, 0, false},
+    {"/spiffs", &sim_config.spiffs_dir, SIM_SD_MAX_FILES, 0, false},
+};
+
+static pthread_mutex_t vfs_lock = PTHREAD_MUTEX_INITIALIZER;
+static sim_io_stats_t io;
+static sdmmc_card_t sim_card;
+static sim_cookie_t *streams = NULL;
+
+// Armed by sim_power_cut_after(), only /sdcard loses power
+static struct {
+    bool armed;
+    bool off;
+    int64_t budget;             // Bytes, and 1 for each directory change, until the cut
+    int garbage;
+    uint32_t noise;
+} power;
+
+static struct {
+    DIR *dir;
+    char path[SIM_PATH_MAX];
+} dir_slots[SIM_DIR_SLOTS];
+
+FILE *__real_fopen(const char *path, const char *mode);
+DIR *__real_opendir(const char *path);
+struct dirent *__real_readdir(DIR *dir);
+int __real_closedir(DIR *dir);
+int __real_stat(const char *path, struct stat *st);
+int __real_mkdir(const char *path, mode_t mode);
+int __real_unlink(const char *path);
+int __real_remove(const char *path);
+int __real_rename(const char *from, const char *to);
+int __real_access(const char *path, int mode);
+int __real_fileno(FILE *fp);
+int __real_fsync(int fd);
+
+#define IO_COUNT(field, n)  __atomic_add_fetch(&io.field, (n), __ATOMIC_RELAXED)
+
+static sim_mount_t *mount_of(const char *path, const char **rest)
+{
+    for (size_t i = 0; i < sizeof(mounts) / sizeof(mounts[0]); i++) {
+        size_t n = strlen(mounts[i].prefix);
+        if (strncmp(path, mounts[i].prefix, n) == 0 && (path[n] == '/' || path[n] == '\0')) {
+            *rest = path + n;
+            return &mounts[i];
+        }
+    }
+    return NULL;
+}
+
+// Replace each missing component of path by a case-insensitive match, if any
+static void resolve_case(char *path)
+{
+    struct stat st;
+    if (lstat(path, &st) == 0) return;
+
+    char *slash = strchr(path + 1, '/');
+    while (slash) {
+        *slash = '\0';
+        bool ok = lstat(path, &st) == 0;
+        if (!ok) {
+            char *name = strrchr(path, '/');
+            *name = '\0';
+            DIR *d = __real_opendir(name == path ? "/" : path);
+            *name = '/';
+            struct dirent *e;
+            while (d && (e = __real_readdir(d)) != NULL) {
+                if (strcasecmp(e->d_name, name + 1) == 0 && strlen(e->d_name) == strlen(name + 1)) {
+                    memcpy(name + 1, e->d_name, strlen(e->d_name));
+                    ok = true;
+                    break;
+                }
+            }
+            if (d) __real_closedir(d);
+        }
+        *slash = '/';
+        if (!ok) return;
+        slash = strchr(slash + 1, '/');
+    }
+
+    // Last component
+    char *name = strrchr(path, '/');
+    *name = '\0';
+    DIR *d = __real_opendir(path[0] ? path : "/");
+    *name = '/';
+    struct dirent *e;
+    while (d && (e = __real_readdir(d)) != NULL) {
+        if (strcasecmp(e->d_name, name + 1) == 0 && strlen(e->d_name) == strlen(name + 1)) {
+            memcpy(name + 1, e->d_name, strlen(e->d_name));
+            break;
+        }
+    }
+    if (d) __real_closedir(d);
+}
+
+const char *sim_map_path(const char *path, char *buf, size_t len)
+{
+    const char *rest;
+    sim_mount_t *m = path ? mount_of(path, &rest) : NULL;
+    if (!m || !*m->dir) return path;
+    if ((size_t)snprintf(buf, len, "%s%s", *m->dir, rest) >= len) return path;
+    resolve_case(buf);
+    return buf;
+}
+
+/*---------- Power cuts ----------*/
+
+void sim_power_cut_after(int64_t budget, int garbage)
+{
+    pthread_mutex_lock(&vfs_lock);
+    power.armed = true;
+    power.off = false;
+    power.budget = budget < 0 ? 0 : budget;
+    power.garbage = garbage;
+    power.noise = (uint32_t)budget * 2654435761u + 1;
+    pthread_mutex_unlock(&vfs_lock);
+}
+
+void sim_power_restore(void)
+{
+    pthread_mutex_lock(&vfs_lock);
+    power.armed = false;
+    power.off = false;
+    pthread_mutex_unlock(&vfs_lock);
+}
+
+bool sim_power_is_cut(void)
+{
+    pthread_mutex_lock(&vfs_lock);
+    bool off = power.off;
+    pthread_mutex_unlock(&vfs_lock);
+    return off;
+}
+
+// Whether a change of n bytes or directory entries under m may start, and how many of its bytes get there
+static bool power_take(sim_mount_t *m, size_t n, size_t *done)
+{
+    *done = n;
+    if (m != &mounts[0]) return true;
+    pthread_mutex_lock(&vfs_lock);
+    bool ok = !power.off;
+    if (ok && power.armed) {
+        if ((int64_t)n < power.budget) {
+            power.budget -= n;
+        } else {
+            *done = (size_t)power.budget;
+            power.off = true;
+            ok = *done > 0;
+        }
+    }
+    pthread_mutex_unlock(&vfs_lock);
+    if (!ok) errno = EIO;
+    return ok;
+}
+
+static bool power_dir_op(const char *path)
+{
+    const char *rest;
+    sim_mount_t *m = path ? mount_of(path, &rest) : NULL;
+    size_t done;
+    return !m || (power_take(m, 1, &done) && done == 1);
+}
+
+void sim_io_get(sim_io_stats_t *out)
+{
+    pthread_mutex_lock(&vfs_lock);
+    *out = io;
+    pthread_mutex_unlock(&vfs_lock);
+}
+
+/*---------- Streams ----------*/
+
+static ssize_t cookie_read(void *c, char *buf, size_t size)
+{
+    sim_cookie_t *ck = c;
+    ssize_t n = read(ck->fd, buf, size);
+    IO_COUNT(reads, 1);
+    if (n > 0) IO_COUNT(read_bytes, (uint64_t)n);
+    return n;
+}
+
+static ssize_t cookie_write(void *c, const char *buf, size_t size)
+{
+    sim_cookie_t *ck = c;
+    size_t done;
+    if (!power_take(ck->mount, size, &done)) return -1;
+    ssize_t n = write(ck->fd, buf, done);
+    IO_COUNT(writes, 1);
+    if (n > 0) IO_COUNT(write_bytes, (uint64_t)n);
+    if (done == size) return n;
+
+    // Cut part way: what follows in the sector the card was writing is noise
+    pthread_mutex_lock(&vfs_lock);
+    size_t noise = size - done < (size_t)power.garbage ? size - done : (size_t)power.garbage;
+    for (size_t i = 0; i < noise; i++) {
+        power.noise = power.noise * 1103515245u + 12345u;
+        uint8_t b = (uint8_t)(power.noise >> 16);
+        if (write(ck->fd, &b, 1) != 1) break;
+    }
+    pthread_mutex_unlock(&vfs_lock);
+    errno = EIO;
+    return -1;
+}
+
+static int cookie_seek(void *c, off64_t *pos, int whence)
+{
+    sim_cookie_t *ck = c;
+    off_t r = lseek(ck->fd, *pos, whence);
+    IO_COUNT(seeks, 1);
+    if (r < 0) return -1;
+    *pos = r;
+    return 0;
+}
+
+static int cookie_close(void *c)
+{
+    sim_cookie_t *ck = c;
+    int r = close(ck->fd);
+    pthread_mutex_lock(&vfs_lock);
+    ck->mount->open_files--;
+    for (sim_cookie_t **p = &streams; *p; p = &(*p)->next) {
+        if (*p == ck) {
+            *p = ck->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&vfs_lock);
+    free(ck);
+    return r;
+}
+
+static int open_flags(const char *mode)
+{
+    bool plus = strchr(mode, '+') != NULL;
+    switch (mode[0]) {
+    case 'r': return plus ? O_RDWR : O_RDONLY;
+    case 'w': return (plus ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+    case 'a': return (plus ? O_RDWR : O_WRONLY) | O_CREAT | O_APPEND;
+    default:  return -1;
+    }
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode)
+{
+    const char *rest;
+    sim_mount_t *m = path ? mount_of(path, &rest) : NULL;
+    if (!m) return __real_fopen(path, mode);
+
+    int flags = open_flags(mode);
+    if (!m->mounted || flags < 0) {
+        errno = m->mounted ? EINVAL : ENODEV;
+        return NULL;
+    }
+    size_t done;
+    if ((flags & (O_WRONLY | O_RDWR)) && !(power_take(m, 1, &done) && done == 1)) return NULL;
+
+    pthread_mutex_lock(&vfs_lock);
+    io.opens++;
+    if (m->open_files >= m->max_files) {
+        pthread_mutex_unlock(&vfs_lock);
+        ESP_LOGW("sim_vfs", "%s: %d files open on %s already, the open fails on the device too", path,
+                 m->open_files, m->prefix);
+        errno = ENFILE;
+        return NULL;
+    }
+    m->open_files++;
+    pthread_mutex_unlock(&vfs_lock);
+
+    char buf[SIM_PATH_MAX];
+    sim_cookie_t *ck = malloc(sizeof(*ck));
+    int fd = ck ? open(sim_map_path(path, buf, sizeof(buf)), flags, 0644) : -1;
+    if (fd < 0) {
+        int err = ck ? errno : ENOMEM;
+        pthread_mutex_lock(&vfs_lock);
+        m->open_files--;
+        pthread_mutex_unlock(&vfs_lock);
+        free(ck);
+        errno = err;
+        return NULL;
+    }
+    ck->fd = fd;
+    ck->mount = m;
+    ck->fp = NULL;
+    ck->next = NULL;
+
+    cookie_io_functions_t fns = {cookie_read, cookie_write, cookie_seek, cookie_close};
+    FILE *fp = fopencookie(ck, mode, fns);
+    if (!fp) {
+        cookie_close(ck);
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, SIM_STDIO_BUF);
+    pthread_mutex_lock(&vfs_lock);
+    ck->fp = fp;
+    ck->next = streams;
+    streams = ck;
+    pthread_mutex_unlock(&vfs_lock);
+    return fp;
+}
+
+// A cookie stream has no descriptor of its own, give the host file's
+int __wrap_fileno(FILE *fp)
+{
+    pthread_mutex_lock(&vfs_lock);
+    sim_cookie_t *ck = streams;
+    while (ck && ck->fp != fp) ck = ck->next;
+    int fd = ck ? ck->fd : -1;
+    pthread_mutex_unlock(&vfs_lock);
+    return ck ? fd : __real_fileno(fp);
+}
+
+int __wrap_fsync(int fd)
+{
+    pthread_mutex_lock(&vfs_lock);
+    sim_cookie_t *ck = streams;
+    while (ck && ck->fd != fd) ck = ck->next;
+    bool card = ck && ck->mount == &mounts[0];
+    bool off = power.off;
+    pthread_mutex_unlock(&vfs_lock);
+    if (!ck) return __real_fsync(fd);
+    if (card && off) {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+/*---------- Directories and paths ----------*/
+
+#define MAPPED(path, buf)   sim_map_path((path), (buf), sizeof(buf))
+
+static bool on_mount(const char *path)
+{
+    const char *rest;
+    sim_mount_t *m = path ? mount_of(path, &rest) : NULL;
+    if (m) IO_COUNT(dir_ops, 1);
+    return m != NULL;
+}
+
+DIR *__wrap_opendir(const char *path)
+{
+    if (!on_mount(path)) return __real_opendir(path);
+    char buf[SIM_PATH_MAX];
+    const char *host = MAPPED(path, buf);
+    DIR *d = __real_opendir(host);
+    if (d) {
+        pthread_mutex_lock(&vfs_lock);
+        for (int i = 0; i < SIM_DIR_SLOTS; i++) {
+            if (!dir_slots[i].dir) {
+                dir_slots[i].dir = d;
+                snprintf(dir_slots[i].path, sizeof(dir_slots[i].path), "%s", host);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&vfs_lock);
+    }
+    return d;
+}
+
+struct dirent *__wrap_readdir(DIR *dir)
+{
+    int slot = -1;
+    pthread_mutex_lock(&vfs_lock);
+    for (int i = 0; i < SIM_DIR_SLOTS; i++) {
+        if (dir_slots[i].dir == dir) slot = i;
+    }
+    pthread_mutex_unlock(&vfs_lock);
+    if (slot < 0) return __real_readdir(dir);
+
+    struct dirent *e;
+    // FAT lists neither "." nor "..", and has no links: report what they point to
+    while ((e = __real_readdir(dir)) != NULL) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        if (e->d_type == DT_LNK || e->d_type == DT_UNKNOWN) {
+            char full[SIM_PATH_MAX * 2];
+            struct stat st;
+            snprintf(full, sizeof(full), "%s/%s", dir_slots[slot].path, e->d_name);
+            if (__real_stat(full, &st) == 0) e->d_type = S_ISDIR(st.st_mode) ? DT_DIR : DT_REG;
+        }
+        return e;
+    }
+    return NULL;
+}
+
+int __wrap_closedir(DIR *dir)
+{
+    pthread_mutex_lock(&vfs_lock);
+    for (int i = 0; i < SIM_DIR_SLOTS; i++) {
+        if (dir_slots[i].dir == dir) dir_slots[i].dir = NULL;
+    }
+    pthread_mutex_unlock(&vfs_lock);
+    return __real_closedir(dir);
+}
+
+int __wrap_stat(const char *path, struct stat *st)
+{
+    char buf[SIM_PATH_MAX];
+    if (!on_mount(path)) return __real_stat(path, st);
+    return __real_stat(MAPPED(path, buf), st);
+}
+
+int __wrap_mkdir(const char *path, mode_t mode)
+{
+    char buf[SIM_PATH_MAX];
+    if (!on_mount(path)) return __real_mkdir(path, mode);
+    if (!power_dir_op(path)) return -1;
+    return __real_mkdir(MAPPED(path, buf), mode);
+}
+
+int __wrap_unlink(const char *path)
+{
+    char buf[SIM_PATH_MAX];
+    if (!on_mount(path)) return __real_unlink(path);
+    if (!power_dir_op(path)) return -1;
+    return __real_unlink(MAPPED(path, buf));
+}
+
+int __wrap_remove(const char *path)
+{
+    char buf[SIM_PATH_MAX];
+    if (!on_mount(path)) return __real_remove(path);
+    if (!power_dir_op(path)) return -1;
+    return __real_remove(MAPPED(path, buf));
+}
+
+int __wrap_rename(const char *from, const char *to)
+{
+    char buf_from[SIM_PATH_MAX], buf_to[SIM_PATH_MAX];
+    if (!on_mount(from)) return __real_rename(from, to);
+    if (!power_dir_op(from)) return -1;
+    return __real_rename(MAPPED(from, buf_from), MAPPED(to, buf_to));
+}
+
+int __wrap_access(const char *path, int mode)
+{
+    char buf[SIM_PATH_MAX];
+    if (!on_mount(path)) return __real_access(path, mode);
+    return __real_access(MAPPED(path, buf), mode);
+}
+
+/*---------- Mounting ----------*/
+
+static esp_err_t mount(const char *base_path)
+{
+    const char *rest;
+    sim_mount_t *m = mount_of(base_path, &rest);
+    if (!m || *rest) return ESP_ERR_INVALID_ARG;
+    if (!*m->dir) return ESP_ERR_NOT_FOUND;     // No card in the slot
+    struct stat st;
+    if (__real_stat(*m->dir, &st) != 0 || !S_ISDIR(st.st_mode)) return ESP_FAIL;
+    m->mounted = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_sdmmc_mount(const char *base_path, const sdmmc_host_t *host, const void *slot_config,
+                                  const esp_vfs_fat_sdmmc_mount_config_t *mount_config, sdmmc_card_t **out_card)
+{
+    (void)host;
+    (void)slot_config;
+    esp_err_t err = mount(base_path);
+    if (err != ESP_OK) return err;
+    mounts[0].max_files = mount_config->max_files;
+
+    struct statvfs vfs;
+    if (statvfs(*mounts[0].dir, &vfs) == 0) {
+        sim_card.csd.capacity = (int)((uint64_t)vfs.f_blocks * vfs.f_frsize / 512);
+    }
+    sim_card.csd.sector_size = 512;
+    if (out_card) *out_card = &sim_card;
+    return ESP_OK;
+}
+
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card)
+{
+    fprintf(stream, "Name: host directory %s\nSize: %lluMB\n", sim_config.sd_dir,
+            (unsigned long long)card->csd.capacity * 512 / (1024 * 1024));
+}
+
+esp_err_t sdmmc_get_status(sdmmc_card_t *card)
+{
+    (void)card;
+    return mounts[0].mounted ? ESP_OK : ESP_FAIL;
+}
+
+FRESULT f_getfree(const char *path, DWORD *nclst, FATFS **fatfs)
+{
+    static FATFS fs;
+    struct statvfs vfs;
+    (void)path;
+    if (!mounts[0].mounted || statvfs(*mounts[0].dir, &vfs) != 0) return FR_NOT_READY;
+    // 32 KB clusters of 512 byte sectors, as formatted by _sdcard_init()
+    uint64_t cluster = 32 * 1024;
+    fs.csize = (uint16_t)(cluster / 512);
+    fs.ssize = 512;
+    fs.n_fatent = (DWORD)((uint64_t)vfs.f_blocks * vfs.f_frsize / cluster + 2);
+    *nclst = (DWORD)((uint64_t)vfs.f_bavail * vfs.f_frsize / cluster);
+    *fatfs = &fs;
+    return FR_OK;
+}
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf)
+{
+    esp_err_t err = mount(conf->base_path);
+    if (err == ESP_OK) mounts[1].max_files = (int)conf->max_files;
+    return err;
+}
+
+esp_err_t esp_vfs_spiffs_unregister(const char *partition_label)
+{
+    (void)partition_label;
+    mounts[1].mounted = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_spiffs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes)
+{
+    (void)partition_label;
+    if (!mounts[1].mounted) return ESP_ERR_INVALID_STATE;
+    // The storage partition of partitions.csv
+    *total_bytes = 1024 * 1024;
+    *used_bytes = 0;
+    DIR *d = __real_opendir(sim_config.spiffs_dir);
+    struct dirent *e;
+    while (d && (e = __real_readdir(d)) != NULL) {
+        char full[SIM_PATH_MAX * 2];
+        struct stat st;
+        snprintf(full, sizeof(full), "%s/%s", sim_config.spiffs_dir, e->d_name);
+        if (__real_stat(full, &st) == 0 && S_ISREG(st.st_mode)) *used_bytes += (size_t)st.st_size;
+    }
+    if (d) __real_closedir(d);
+    return ESP_OK;
+}
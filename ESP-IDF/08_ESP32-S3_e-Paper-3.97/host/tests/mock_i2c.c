@@ -0,0 +1,190 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "driver/i2c_master.h"
+#include "mock_i2c.h"
+
+struct i2c_master_bus_t {
+    int port;
+};
+
+struct i2c_master_dev_t {
+    uint16_t addr;
+    uint32_t scl_speed_hz;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static struct i2c_master_bus_t bus;
+static mock_i2c_xfer_t xfers[MOCK_I2C_LOG_LEN];
+static int xfer_count;
+static int devices_added;
+static bool held;
+static int busy;
+static uint16_t fail_addr;
+static esp_err_t fail_err;
+static uint16_t device_addr;
+static mock_i2c_device_t device_fn;
+
+void mock_i2c_reset(void)
+{
+    pthread_mutex_lock(&lock);
+    xfer_count = 0;
+    held = false;
+    fail_addr = 0;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+void mock_i2c_hold(void)
+{
+    pthread_mutex_lock(&lock);
+    held = true;
+    pthread_mutex_unlock(&lock);
+}
+
+void mock_i2c_release(void)
+{
+    pthread_mutex_lock(&lock);
+    held = false;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+void mock_i2c_wait_busy(void)
+{
+    pthread_mutex_lock(&lock);
+    while (busy == 0) pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+void mock_i2c_fail(uint16_t addr, esp_err_t err)
+{
+    pthread_mutex_lock(&lock);
+    fail_addr = addr;
+    fail_err = err;
+    pthread_mutex_unlock(&lock);
+}
+
+void mock_i2c_device(uint16_t addr, mock_i2c_device_t device)
+{
+    pthread_mutex_lock(&lock);
+    device_addr = addr;
+    device_fn = device;
+    pthread_mutex_unlock(&lock);
+}
+
+uint8_t mock_i2c_pattern(uint16_t addr, size_t i)
+{
+    return (uint8_t)(addr * 7 + i);
+}
+
+int mock_i2c_count(void)
+{
+    pthread_mutex_lock(&lock);
+    int n = xfer_count;
+    pthread_mutex_unlock(&lock);
+    return n;
+}
+
+const mock_i2c_xfer_t *mock_i2c_log(int i)
+{
+    return &xfers[i];
+}
+
+int mock_i2c_devices_added(void)
+{
+    pthread_mutex_lock(&lock);
+    int n = devices_added;
+    pthread_mutex_unlock(&lock);
+    return n;
+}
+
+static bool on_own_stack(const void *p)
+{
+    pthread_attr_t attr;
+    void *base;
+    size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return false;
+    pthread_attr_getstack(&attr, &base, &size);
+    pthread_attr_destroy(&attr);
+    return (const uint8_t *)p >= (const uint8_t *)base && (const uint8_t *)p < (const uint8_t *)base + size;
+}
+
+static esp_err_t xfer(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len)
+{
+    pthread_mutex_lock(&lock);
+    busy++;
+    pthread_cond_broadcast(&cond);
+    while (held) pthread_cond_wait(&cond, &lock);
+    busy--;
+
+    if (xfer_count < MOCK_I2C_LOG_LEN) {
+        mock_i2c_xfer_t *x = &xfers[xfer_count++];
+        x->addr = dev->addr;
+        x->tx_len = tx_len;
+        x->rx_len = rx_len;
+        if (tx_len) memcpy(x->tx, tx, tx_len < MOCK_I2C_TX_MAX ? tx_len : MOCK_I2C_TX_MAX);
+        x->tx_on_stack = tx_len && on_own_stack(tx);
+    }
+    esp_err_t ret = dev->addr == fail_addr ? fail_err : ESP_OK;
+    mock_i2c_device_t device = dev->addr == device_addr ? device_fn : NULL;
+    pthread_mutex_unlock(&lock);
+
+    if (device) {
+        esp_err_t err = device(tx, tx_len, rx, rx_len);
+        return ret != ESP_OK ? ret : err;
+    }
+    for (size_t i = 0; i < rx_len; i++) rx[i] = mock_i2c_pattern(dev->addr, i);
+    return ret;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle)
+{
+    bus.port = bus_config->i2c_port;
+    *ret_bus_handle = &bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle)
+{
+    (void)bus_handle;
+    struct i2c_master_dev_t *dev = calloc(1, sizeof(*dev));
+    if (!dev) return ESP_ERR_NO_MEM;
+    dev->addr = dev_config->device_address;
+    dev->scl_speed_hz = dev_config->scl_speed_hz;
+    pthread_mutex_lock(&lock);
+    devices_added++;
+    pthread_mutex_unlock(&lock);
+    *ret_handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                              int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    return xfer(i2c_dev, write_buffer, write_size, NULL, 0);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer,
+                                      size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                      int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    return xfer(i2c_dev, write_buffer, write_size, read_buffer, read_size);
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size,
+                             int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    return xfer(i2c_dev, NULL, 0, read_buffer, read_size);
+}
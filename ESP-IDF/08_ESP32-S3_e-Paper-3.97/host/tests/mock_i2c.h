@@ -0,0 +1,56 @@
+#ifndef MOCK_I2C_H
+#define MOCK_I2C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * An I2C master bus for the tests of components/i2c_bsp. It logs every
+ * transfer, answers reads with a pattern of the device address, and can be
+ * held so that a transfer stays on the bus until the test lets it go. A test
+ * that drives a chip driver through i2c_bsp can put a model of the chip at
+ * its address instead of the pattern.
+ */
+
+#define MOCK_I2C_LOG_LEN    64
+#define MOCK_I2C_TX_MAX     64
+
+typedef struct {
+    uint16_t addr;
+    uint8_t tx[MOCK_I2C_TX_MAX];
+    size_t tx_len;
+    size_t rx_len;
+    bool tx_on_stack;           // The write buffer is on the stack of the calling thread
+} mock_i2c_xfer_t;
+
+// Forget the log, release the bus and stop failing
+void mock_i2c_reset(void);
+
+// Transfers wait on the bus until released
+void mock_i2c_hold(void);
+void mock_i2c_release(void);
+
+// Wait until a transfer is waiting on the held bus
+void mock_i2c_wait_busy(void);
+
+// Transfers to this address fail with err, 0 for none
+void mock_i2c_fail(uint16_t addr, esp_err_t err);
+
+// A chip model: sees each transfer to its address and fills the read buffer
+typedef esp_err_t (*mock_i2c_device_t)(const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len);
+
+// Answer the transfers to addr with device, NULL for the pattern again
+void mock_i2c_device(uint16_t addr, mock_i2c_device_t device);
+
+// What a read from addr returns at byte i
+uint8_t mock_i2c_pattern(uint16_t addr, size_t i);
+
+int mock_i2c_count(void);
+const mock_i2c_xfer_t *mock_i2c_log(int i);
+
+// Calls of i2c_master_bus_add_device() since the start
+int mock_i2c_devices_added(void);
+
+#endif
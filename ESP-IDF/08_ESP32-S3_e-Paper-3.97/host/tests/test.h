@@ -0,0 +1,71 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Checks for the host tests. A failed check prints where it is and what it
+ * compared, the test goes on, and test_done() gives the exit status that
+ * ctest sees. One test program per module, each case a function called from
+ * main() through TEST_RUN.
+ */
+
+static int test_checks;
+static int test_failures;
+static const char *test_case = "";
+
+#define TEST_FAIL(fmt, ...) do {                                                    \
+        test_failures++;                                                            \
+        fprintf(stderr, "%s:%d: %s: " fmt "\n", __FILE__, __LINE__, test_case,      \
+                ##__VA_ARGS__);                                                     \
+    } while (0)
+
+#define CHECK(cond) do {                                                            \
+        test_checks++;                                                              \
+        if (!(cond)) TEST_FAIL("%s", #cond);                                        \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                         \
+        long long a_ = (long long)(a), b_ = (long long)(b);                        \
+        test_checks++;                                                              \
+        if (a_ != b_) TEST_FAIL("%s == %s: %lld, expected %lld", #a, #b, a_, b_);   \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol) do {                                                  \
+        double a_ = (double)(a), b_ = (double)(b);                                  \
+        test_checks++;                                                              \
+        if (!(a_ - b_ <= (tol) && b_ - a_ <= (tol)))                                \
+            TEST_FAIL("%s ~ %s: %g, expected %g (+-%g)", #a, #b, a_, b_, (double)(tol)); \
+    } while (0)
+
+#define CHECK_STR(a, b) do {                                                        \
+        const char *a_ = (a), *b_ = (b);                                            \
+        test_checks++;                                                              \
+        if (strcmp(a_, b_) != 0) TEST_FAIL("%s: \"%s\", expected \"%s\"", #a, a_, b_); \
+    } while (0)
+
+// First differing byte of two buffers
+#define CHECK_MEM(a, b, n) do {                                                     \
+        const uint8_t *a_ = (const uint8_t *)(a), *b_ = (const uint8_t *)(b);       \
+        size_t n_ = (n), i_ = 0;                                                    \
+        test_checks++;                                                              \
+        while (i_ < n_ && a_[i_] == b_[i_]) i_++;                                   \
+        if (i_ < n_) TEST_FAIL("%s differs from %s at byte %zu of %zu: %02x, expected %02x", \
+                               #a, #b, i_, n_, a_[i_], b_[i_]);                      \
+    } while (0)
+
+#define TEST_RUN(fn) do {                                                           \
+        test_case = #fn;                                                            \
+        fn();                                                                       \
+    } while (0)
+
+static inline int test_done(void)
+{
+    printf("%d checks, %d failed\n", test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "page_alarm.h"
+#include "test.h"
+
+/*
+ * alarm_get_next() of main/page_alarm, which the clock and alarm pages use
+ * to program the RTC's daily alarm. It is checked minute by minute over a
+ * week against stepping the clock forward until an enabled alarm matches,
+ * so every midnight and every change of weekday is crossed.
+ */
+
+#define DAY_MINUTES (24 * 60)
+
+// What main.cc defines for the pages
+SemaphoreHandle_t alarm_mutex;
+bool wifi_enable;
+uint8_t *Image_Mono;
+
+static void set_alarms(const int *hm, int n)
+{
+    memset(alarms, 0, sizeof(alarms));
+    for (int i = 0; i < n; i++) {
+        alarms[i].hour = (uint8_t)(hm[i] / 100);
+        alarms[i].minute = (uint8_t)(hm[i] % 100);
+        alarms[i].enabled = 1;
+    }
+}
+
+// Minutes from minute of the week now to the next enabled alarm, 0 if none
+static int reference(int now)
+{
+    for (int step = 1; step <= DAY_MINUTES; step++) {
+        int t = (now + step) % DAY_MINUTES;
+        for (int i = 0; i < MAX_ALARMS; i++) {
+            if (alarms[i].enabled && alarms[i].hour * 60 + alarms[i].minute == t) return step;
+        }
+    }
+    return 0;
+}
+
+static void check_week(void)
+{
+    for (int now = 0; now < 7 * DAY_MINUTES; now++) {
+        uint8_t h = 0xFF, m = 0xFF;
+        int expect = reference(now);
+        int got = alarm_get_next((uint8_t)(now % DAY_MINUTES / 60), (uint8_t)(now % 60), &h, &m);
+        if (got != expect) {
+            TEST_FAIL("day %d %02d:%02d: %d minutes, expected %d", now / DAY_MINUTES, now % DAY_MINUTES / 60,
+                      now % 60, got, expect);
+            return;
+        }
+        if (got && (h * 60 + m) % DAY_MINUTES != (now + got) % DAY_MINUTES) {
+            TEST_FAIL("day %d %02d:%02d: next is %02d:%02d, %d minutes away", now / DAY_MINUTES,
+                      now % DAY_MINUTES / 60, now % 60, h, m, got);
+            return;
+        }
+    }
+    test_checks++;
+}
+
+static void none_enabled(void)
+{
+    memset(alarms, 0, sizeof(alarms));
+    uint8_t h = 7, m = 8;
+    CHECK_EQ(alarm_get_next(12, 0, &h, &m), 0);
+    CHECK_EQ(h, 7);             // Left alone
+    CHECK_EQ(m, 8);
+
+    alarms[0].hour = 6;
+    alarms[0].minute = 30;      // Set but off
+    CHECK_EQ(alarm_get_next(6, 0, &h, &m), 0);
+    check_week();
+}
+
+static void single_alarm(void)
+{
+    const int hm[] = {630};
+    set_alarms(hm, 1);
+    uint8_t h = 0, m = 0;
+    CHECK_EQ(alarm_get_next(6, 0, &h, &m), 30);
+    CHECK_EQ(h, 6);
+    CHECK_EQ(m, 30);
+    CHECK_EQ(alarm_get_next(6, 29, NULL, NULL), 1);
+    CHECK_EQ(alarm_get_next(6, 30, NULL, NULL), DAY_MINUTES);   // Ringing now, next is tomorrow
+    CHECK_EQ(alarm_get_next(6, 31, NULL, NULL), DAY_MINUTES - 1);
+    CHECK_EQ(alarm_get_next(23, 59, NULL, NULL), 6 * 60 + 31);
+    check_week();
+}
+
+static void across_midnight(void)
+{
+    const int hm[] = {0, 2359, 10};
+    set_alarms(hm, 3);
+    uint8_t h = 0, m = 0;
+    CHECK_EQ(alarm_get_next(23, 58, &h, &m), 1);
+    CHECK_EQ(h, 23);
+    CHECK_EQ(m, 59);
+    CHECK_EQ(alarm_get_next(23, 59, &h, &m), 1);
+    CHECK_EQ(h, 0);
+    CHECK_EQ(m, 0);
+    CHECK_EQ(alarm_get_next(0, 0, &h, &m), 10);
+    CHECK_EQ(m, 10);
+    CHECK_EQ(alarm_get_next(0, 10, &h, &m), 23 * 60 + 49);
+    CHECK_EQ(h, 23);
+    check_week();
+}
+
+static void full_table(void)
+{
+    const int hm[MAX_ALARMS] = {2200, 545, 1230, 600, 1231, 2359};
+    set_alarms(hm, MAX_ALARMS);
+    alarms[3].enabled = 0;      // 06:00 is off
+    uint8_t h = 0, m = 0;
+    CHECK_EQ(alarm_get_next(5, 50, &h, &m), 6 * 60 + 40);
+    CHECK_EQ(h, 12);
+    CHECK_EQ(m, 30);
+    check_week();
+}
+
+static void every_single_minute(void)
+{
+    // One alarm at each minute of the day in turn, from a few fixed times
+    static const int from[] = {0, 1, 59, 60, 719, 720, 1380, 1438, 1439};
+    for (int a = 0; a < DAY_MINUTES; a++) {
+        memset(alarms, 0, sizeof(alarms));
+        alarms[a % MAX_ALARMS].hour = (uint8_t)(a / 60);
+        alarms[a % MAX_ALARMS].minute = (uint8_t)(a % 60);
+        alarms[a % MAX_ALARMS].enabled = 1;
+        for (size_t i = 0; i < sizeof(from) / sizeof(from[0]); i++) {
+            int expect = (a - from[i] + DAY_MINUTES) % DAY_MINUTES;
+            if (expect == 0) expect = DAY_MINUTES;
+            CHECK_EQ(alarm_get_next((uint8_t)(from[i] / 60), (uint8_t)(from[i] % 60), NULL, NULL), expect);
+        }
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(none_enabled);
+    TEST_RUN(single_alarm);
+    TEST_RUN(across_midnight);
+    TEST_RUN(full_table);
+    TEST_RUN(every_single_minute);
+    return test_done();
+}
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include "axp_battery.h"
+#include "axp_prot.h"
+#include "test.h"
+
+/*
+ * The battery estimator of components/axpPower: the discharge curve, the
+ * EMA of the terminal voltage, the I*R compensation and the hysteresis of
+ * the published percentage, fed with synthetic traces. A trace is a resting
+ * voltage falling (or rising) steadily, to which the sag of a load that
+ * switches between idle and Wi-Fi and a few millivolts of noise are added.
+ */
+
+#define TRACE_LEN   2000
+#define SAG_MV(ma)  ((ma) * AXP_BAT_INTERNAL_RES_MOHM / 1000)
+
+static uint32_t noise_state;
+
+// -10..10 mV, the same sequence every run
+static int noise_mv(void)
+{
+    noise_state = noise_state * 1103515245u + 12345u;
+    return (int)((noise_state >> 16) % 21) - 10;
+}
+
+static void ocv_curve(void)
+{
+    CHECK_EQ(axp_battery_ocv_to_percent(4300), 100);
+    CHECK_EQ(axp_battery_ocv_to_percent(4180), 100);
+    CHECK_EQ(axp_battery_ocv_to_percent(4110), 95);
+    CHECK_EQ(axp_battery_ocv_to_percent(3810), 50);
+    CHECK_EQ(axp_battery_ocv_to_percent(3450), 0);
+    CHECK_EQ(axp_battery_ocv_to_percent(3000), 0);
+    CHECK_EQ(axp_battery_ocv_to_percent(0), 0);
+
+    // Interpolated and rounded between points
+    CHECK_EQ(axp_battery_ocv_to_percent(3820), 53);     // 3810..3830 is 50..55
+    CHECK_EQ(axp_battery_ocv_to_percent(3535), 3);      // 3450..3620 is 0..5
+
+    // Never rises as the voltage falls
+    int last = 100;
+    for (int mv = 4250; mv >= 3400; mv--) {
+        int p = axp_battery_ocv_to_percent(mv);
+        if (p > last) {
+            TEST_FAIL("%d mV: %d%%, above %d%% at %d mV", mv, p, last, mv + 1);
+            return;
+        }
+        last = p;
+    }
+    test_checks++;
+}
+
+static void ema(void)
+{
+    axp_battery_est_t est;
+    axp_battery_est_init(&est, AXP_BAT_PERCENT_UNKNOWN);
+    CHECK_EQ(est.percent, AXP_BAT_PERCENT_UNKNOWN);
+
+    // The first sample is taken as is, and what it shows at rest is published at once
+    CHECK_EQ(axp_battery_est_update(&est, 4000, 0, false, false), axp_battery_ocv_to_percent(4000));
+    CHECK_EQ(axp_battery_est_mv(&est), 4000);
+
+    // A step moves by 1/8 of the remaining distance per sample
+    double ref = 4000;
+    for (int i = 0; i < 40; i++) {
+        axp_battery_est_update(&est, 3900, 0, false, false);
+        ref += (3900 - ref) / (1 << AXP_BAT_EMA_SHIFT);
+        CHECK_NEAR(axp_battery_est_mv(&est), ref, 1);
+    }
+    CHECK_NEAR(axp_battery_est_mv(&est), 3900, 1);
+
+    // A missing battery reads 0 and changes nothing
+    axp_battery_est_t before = est;
+    CHECK_EQ(axp_battery_est_update(&est, 0, 0, false, false), before.percent);
+    CHECK_EQ(est.ema_mv_x16, before.ema_mv_x16);
+}
+
+static void load_compensation(void)
+{
+    axp_battery_est_t est;
+
+    // Under load the cell rests SAG_MV higher than its terminals
+    axp_battery_est_init(&est, AXP_BAT_PERCENT_UNKNOWN);
+    CHECK_EQ(axp_battery_est_update(&est, 3800, AXP_LOAD_WIFI_MA, false, false),
+             axp_battery_ocv_to_percent(3800 + SAG_MV(AXP_LOAD_WIFI_MA)));
+
+    // Charging current lifts the terminals
+    axp_battery_est_init(&est, AXP_BAT_PERCENT_UNKNOWN);
+    CHECK_EQ(axp_battery_est_update(&est, 3900, 0, true, false),
+             axp_battery_ocv_to_percent(3900 - SAG_MV(AXP_BAT_CHARGE_MA)));
+
+    // Not full before the charger says so, full as soon as it does
+    axp_battery_est_init(&est, AXP_BAT_PERCENT_UNKNOWN);
+    CHECK_EQ(axp_battery_est_update(&est, 4250, 0, true, false), 99);
+    CHECK_EQ(axp_battery_est_update(&est, 4250, 0, true, true), 100);
+    axp_battery_est_init(&est, AXP_BAT_PERCENT_UNKNOWN);
+    CHECK_EQ(axp_battery_est_update(&est, 4000, 0, false, true), 100);
+}
+
+static void seed_hysteresis(void)
+{
+    axp_battery_est_t est;
+
+    axp_battery_est_init(&est, 200);
+    CHECK_EQ(est.percent, AXP_BAT_PERCENT_UNKNOWN);
+
+    // Shown 80% before power-off, now reads 85%: kept, discharging does not go up
+    axp_battery_est_init(&est, 80);
+    CHECK_EQ(axp_battery_est_update(&est, 4020, 0, false, false), 80);
+    // One percent with the trend is not enough, two are
+    axp_battery_est_init(&est, 86);
+    CHECK_EQ(axp_battery_est_update(&est, 4020, 0, false, false), 86);
+    axp_battery_est_init(&est, 87);
+    CHECK_EQ(axp_battery_est_update(&est, 4020, 0, false, false), 85);
+    // Far off either way, it resyncs
+    axp_battery_est_init(&est, 60);
+    CHECK_EQ(axp_battery_est_update(&est, 4020, 0, false, false), 85);
+    axp_battery_est_init(&est, 100);
+    CHECK_EQ(axp_battery_est_update(&est, 4020, 0, false, false), 85);
+
+    // While charging only a rise is followed
+    axp_battery_est_init(&est, 80);
+    CHECK_EQ(axp_battery_est_update(&est, 3950 + SAG_MV(AXP_BAT_CHARGE_MA), 0, true, false), 80);
+    axp_battery_est_init(&est, 70);
+    CHECK_EQ(axp_battery_est_update(&est, 3950 + SAG_MV(AXP_BAT_CHARGE_MA), 0, true, false), 75);
+}
+
+// Discharge from full to empty with the load switching between idle and Wi-Fi
+static void discharge_trace(void)
+{
+    axp_battery_est_t est;
+    int last = -1, worst = 0, changes = 0;
+
+    noise_state = 1;
+    axp_battery_est_init(&est, AXP_BAT_PERCENT_UNKNOWN);
+    for (int i = 0; i < TRACE_LEN; i++) {
+        int ocv = 4180 - (4180 - 3450) * i / TRACE_LEN;
+        int load = (i / 50) % 2 ? AXP_LOAD_WIFI_MA : AXP_LOAD_IDLE_MA;
+        uint16_t vbat = (uint16_t)(ocv - SAG_MV(load) + noise_mv());
+        int p = axp_battery_est_update(&est, vbat, load, false, false);
+
+        if (last >= 0 && p > last) {
+            TEST_FAIL("sample %d: %d%% after %d%% while discharging", i, p, last);
+            return;
+        }
+        if (last >= 0 && p != last) {
+            changes++;
+            if (last - p < AXP_BAT_HYSTERESIS) {
+                TEST_FAIL("sample %d: step of %d%% from %d%%", i, last - p, last);
+                return;
+            }
+        }
+        int err = abs(p - axp_battery_ocv_to_percent(ocv));
+        if (i >= 50 && err > worst) worst = err;
+        last = p;
+    }
+    test_checks++;
+    CHECK(worst <= 5);
+    CHECK(last <= 2);
+    CHECK(changes >= 100 / 5);      // Followed the whole way down
+}
+
+// Charging from low to the charger's done flag
+static void charge_trace(void)
+{
+    axp_battery_est_t est;
+    int last = -1;
+
+    noise_state = 2;
+    axp_battery_est_init(&est, 20);
+    for (int i = 0; i < TRACE_LEN; i++) {
+        int ocv = 3720 + (4180 - 3720) * i / TRACE_LEN;
+        bool done = i >= TRACE_LEN - 10;
+        uint16_t vbat = (uint16_t)(ocv + SAG_MV(AXP_BAT_CHARGE_MA) + noise_mv());
+        int p = axp_battery_est_update(&est, vbat, 0, true, done);
+
+        if (p < last || (!done && p > 99)) {
+            TEST_FAIL("sample %d: %d%% after %d%% while charging", i, p, last);
+            return;
+        }
+        last = p;
+    }
+    test_checks++;
+    CHECK_EQ(last, 100);
+}
+
+int main(void)
+{
+    TEST_RUN(ocv_curve);
+    TEST_RUN(ema);
+    TEST_RUN(load_compensation);
+    TEST_RUN(seed_hysteresis);
+    TEST_RUN(discharge_trace);
+    TEST_RUN(charge_trace);
+    return test_done();
+}
@@ -0,0 +1,575 @@
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "GUI_Paint.h"
+#include "GUI_BMPfile.h"
+#include "img_pipeline.h"
+#include "test.h"
+
+/*
+ * GUI_LoadBmp of components/epaper_lib on a corpus written by the test: the
+ * same pictures as 1/4/8/24/32-bit files, bottom-up and top-down, with odd
+ * widths and enough rows for several bands. Every encoding of a picture must
+ * draw the same frame. Undithered frames are checked pixel by pixel against
+ * the threshold and nearest-level model, dithered ones against golden
+ * hashes of the frame. Truncated and unsupported files are checked for
+ * their error and for what they leave drawn, and a file of many bands must
+ * load without sleeping between them.
+ */
+
+#define CANVAS_W        208
+#define CANVAS_H        60
+#define AT_X            3
+#define AT_Y            2
+#define BAND_ROWS_MIN   8       // GUI_BMPfile.c reads at least this many rows per band
+#define TIMED_LOADS     50
+
+typedef struct {
+    uint8_t r, g, b;
+} rgb_t;
+
+// Eight grays and eight colours
+static const rgb_t colors[16] = {
+    {0, 0, 0}, {36, 36, 36}, {73, 73, 73}, {109, 109, 109},
+    {146, 146, 146}, {182, 182, 182}, {219, 219, 219}, {255, 255, 255},
+    {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0},
+    {0, 255, 255}, {255, 0, 255}, {128, 64, 32}, {32, 160, 200},
+};
+
+// A picture as indices into colors[]
+typedef struct {
+    int w, h;
+    uint8_t px[CANVAS_H][CANVAS_W];
+} pic_t;
+
+typedef enum {
+    ENC_1BIT, ENC_1BIT_SWAPPED,     // Two colours, the palette either way round
+    ENC_4BIT, ENC_8BIT, ENC_8BIT_SHORT, ENC_24BIT, ENC_32BIT,
+} enc_t;
+
+static const char *const enc_names[] = {"1-bit", "1-bit swapped", "4-bit", "8-bit", "8-bit 16 colours", "24-bit", "32-bit"};
+
+typedef struct {
+    uint8_t *data;
+    size_t len, cap;
+} buf_t;
+
+static char work_dir[64];
+static uint8_t canvas[CANVAS_W * CANVAS_H / 4];
+
+static void put(buf_t *b, const void *p, size_t n)
+{
+    if (b->len + n > b->cap) {
+        b->cap = (b->len + n) * 2;
+        b->data = realloc(b->data, b->cap);
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void put16(buf_t *b, uint16_t v)
+{
+    uint8_t x[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    put(b, x, 2);
+}
+
+static void put32(buf_t *b, uint32_t v)
+{
+    uint8_t x[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    put(b, x, 4);
+}
+
+static void put_rgb(buf_t *b, rgb_t c, int bytes)
+{
+    uint8_t x[4] = {c.b, c.g, c.r, 0};
+    put(b, x, bytes);
+}
+
+// Palette slot of colour i, shuffled so a loader that ignores the palette fails
+static int slot_of(enc_t enc, int i)
+{
+    switch (enc) {
+    case ENC_1BIT_SWAPPED: return 1 - i;
+    case ENC_4BIT: return (i * 7 + 3) & 15;
+    case ENC_8BIT: return (i * 37 + 11) & 255;
+    default: return i;
+    }
+}
+
+/*
+ * The file of a picture. A 1-bit encoding takes colours 0 and 1 of the
+ * picture's two: c0 and c1.
+ */
+static buf_t encode(const pic_t *p, enc_t enc, bool top_down, const rgb_t *two)
+{
+    static const int bpp_of[] = {1, 1, 4, 8, 8, 24, 32};
+    int bpp = bpp_of[enc];
+    int colors_used = bpp == 1 ? 2 : (bpp == 4 ? 16 : (enc == ENC_8BIT_SHORT ? 16 : 256));
+    int palette = bpp <= 8 ? colors_used : 0;
+    uint32_t stride = ((uint32_t)p->w * bpp + 31) / 32 * 4;
+    uint32_t offset = 14 + 40 + palette * 4;
+    buf_t b = {0};
+
+    put(&b, "BM", 2);
+    put32(&b, offset + stride * p->h);
+    put32(&b, 0);
+    put32(&b, offset);
+    put32(&b, 40);
+    put32(&b, (uint32_t)p->w);
+    put32(&b, (uint32_t)(top_down ? -p->h : p->h));
+    put16(&b, 1);
+    put16(&b, (uint16_t)bpp);
+    put32(&b, 0);
+    put32(&b, stride * p->h);
+    put32(&b, 2835);
+    put32(&b, 2835);
+    put32(&b, enc == ENC_8BIT ? 0 : (uint32_t)palette);
+    put32(&b, 0);
+
+    for (int s = 0; s < palette; s++) {
+        rgb_t c = {0x55, 0xAA, 0x55};       // Slots no pixel uses
+        for (int i = 0; i < (bpp == 1 ? 2 : 16); i++) {
+            if (slot_of(enc, i) == s) c = bpp == 1 ? two[i] : colors[i];
+        }
+        put_rgb(&b, c, 4);
+    }
+
+    uint8_t *row = malloc(stride);
+    for (int r = 0; r < p->h; r++) {
+        int y = top_down ? r : p->h - 1 - r;
+        memset(row, 0, stride);
+        for (int x = 0; x < p->w; x++) {
+            int i = p->px[y][x], s = slot_of(enc, i);
+            switch (bpp) {
+            case 1: row[x >> 3] |= s << (7 - (x & 7)); break;
+            case 4: row[x >> 1] |= s << ((x & 1) ? 0 : 4); break;
+            case 8: row[x] = (uint8_t)s; break;
+            default: {
+                rgb_t c = colors[i];
+                uint8_t *q = row + x * (bpp / 8);
+                q[0] = c.b;
+                q[1] = c.g;
+                q[2] = c.r;
+            }
+            }
+        }
+        put(&b, row, stride);
+    }
+    free(row);
+    return b;
+}
+
+static void save(const char *name, const buf_t *b, size_t len, char *path)
+{
+    snprintf(path, 128, "%s/%s", work_dir, name);
+    FILE *fp = fopen(path, "wb");
+    if (!fp || fwrite(b->data, 1, len, fp) != len) TEST_FAIL("cannot write %s", path);
+    if (fp) fclose(fp);
+}
+
+static void canvas_reset(int scale)
+{
+    Paint_NewImage(canvas, CANVAS_W, CANVAS_H, ROTATE_0, WHITE);
+    Paint_SetScale(scale);
+    Paint_Clear(WHITE);
+}
+
+// 1 for black at Scale 2, the 2-bit level (3 = white) at Scale 4
+static int pixel_of(const uint8_t *frame, int x, int y)
+{
+    if (Paint.Scale == 2) return !((frame[y * Paint.WidthByte + x / 8] >> (7 - x % 8)) & 1);
+    return (frame[y * Paint.WidthByte + x / 4] >> (6 - 2 * (x % 4))) & 3;
+}
+
+static int pixel(int x, int y)
+{
+    return pixel_of(canvas, x, y);
+}
+
+static size_t canvas_bytes(void)
+{
+    return (size_t)Paint.WidthByte * CANVAS_H;
+}
+
+// Load a file onto a clean canvas, the frame is left in canvas
+static esp_err_t render(const char *path, const BMP_OPTIONS *opt, int scale)
+{
+    canvas_reset(scale);
+    return GUI_LoadBmp(path, AT_X, AT_Y, opt);
+}
+
+static esp_err_t render_buf(const buf_t *b, size_t len, const BMP_OPTIONS *opt, int scale)
+{
+    char path[128];
+    save("pic.bmp", b, len, path);
+    return render(path, opt, scale);
+}
+
+static uint32_t fnv1a(const uint8_t *p, size_t n)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// Sixteen colours in bands, diagonals and blocks, so every row differs
+static void make_pic(pic_t *p, int w, int h, int ncolors)
+{
+    p->w = w;
+    p->h = h;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) p->px[y][x] = (uint8_t)(((x / 3) + (y / 2) * 5 + ((x ^ y) & 4)) % ncolors);
+    }
+}
+
+static void flip(const pic_t *p, pic_t *out)
+{
+    out->w = p->w;
+    out->h = p->h;
+    for (int y = 0; y < p->h; y++) memcpy(out->px[y], p->px[p->h - 1 - y], p->w);
+}
+
+// Ink or level the model gives a colour, without dithering
+static int model(rgb_t c, const BMP_OPTIONS *opt, int scale)
+{
+    uint16_t lum = img_lum_rgb(c.r, c.g, c.b, opt->Gamma);
+    if (scale == 4) return (lum >= 683) + (lum >= 2048) + (lum >= 3413);
+    uint8_t t = opt->Threshold ? opt->Threshold : 128;
+    return lum < img_lum_rgb(t, t, t, opt->Gamma);
+}
+
+// The frame of an undithered load, pixel by pixel, outside the picture white
+static void check_model(const pic_t *p, const rgb_t *pal, const BMP_OPTIONS *opt, int scale, const char *what)
+{
+    int white = scale == 2 ? 0 : 3;
+    for (int y = 0; y < CANVAS_H; y++) {
+        for (int x = 0; x < CANVAS_W; x++) {
+            int px = x - AT_X, py = y - AT_Y;
+            bool in = px >= 0 && py >= 0 && px < p->w && py < p->h;
+            int want = in ? model(pal[p->px[py][px]], opt, scale) : white;
+            if (pixel(x, y) != want) {
+                TEST_FAIL("%s: pixel %d,%d is %d, expected %d", what, x, y, pixel(x, y), want);
+                return;
+            }
+        }
+    }
+    test_checks++;
+}
+
+static const BMP_OPTIONS opt_none = {BMP_DITHER_NONE, 0, 0, false};
+
+// Every depth and orientation of a sixteen-colour picture draws the model's frame
+static void depths_undithered(void)
+{
+    static const int sizes[][2] = {{37, 23}, {1, 9}, {9, 1}, {200, 50}, {33, 17}};
+    static const enc_t encs[] = {ENC_4BIT, ENC_8BIT, ENC_8BIT_SHORT, ENC_24BIT, ENC_32BIT};
+    static const BMP_OPTIONS opts[] = {
+        {BMP_DITHER_NONE, 0, 0, false},
+        {BMP_DITHER_NONE, 90, 0, false},
+        {BMP_DITHER_NONE, 200, 0, true},
+    };
+    static pic_t p;
+    char what[96];
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        make_pic(&p, sizes[s][0], sizes[s][1], 16);
+        for (size_t e = 0; e < sizeof(encs) / sizeof(encs[0]); e++) {
+            for (int td = 0; td < 2; td++) {
+                buf_t b = encode(&p, encs[e], td, NULL);
+                for (size_t o = 0; o < sizeof(opts) / sizeof(opts[0]); o++) {
+                    snprintf(what, sizeof(what), "%dx%d %s%s threshold %d%s", p.w, p.h, enc_names[encs[e]],
+                             td ? " top-down" : "", opts[o].Threshold, opts[o].Gamma ? " gamma" : "");
+                    CHECK_EQ(render_buf(&b, b.len, &opts[o], 2), ESP_OK);
+                    check_model(&p, colors, &opts[o], 2, what);
+                }
+                CHECK_EQ(render_buf(&b, b.len, &opt_none, 4), ESP_OK);
+                check_model(&p, colors, &opt_none, 4, "4 gray");
+                free(b.data);
+            }
+        }
+    }
+}
+
+// Two-colour pictures: the 1-bit copy without the pipeline, either palette order, and as 24-bit
+static void one_bit(void)
+{
+    static const rgb_t pairs[][2] = {
+        {{0, 0, 0}, {255, 255, 255}},
+        {{255, 255, 255}, {0, 0, 0}},
+        {{255, 0, 0}, {255, 255, 0}},       // Dark and light without black or white
+        {{40, 40, 40}, {60, 60, 60}},       // Both dark
+    };
+    static const int sizes[][2] = {{37, 23}, {8, 8}, {33, 17}, {200, 50}, {1, 1}};
+    static pic_t p;
+    char what[96];
+
+    for (size_t k = 0; k < sizeof(pairs) / sizeof(pairs[0]); k++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            make_pic(&p, sizes[s][0], sizes[s][1], 2);
+            for (int td = 0; td < 2; td++) {
+                for (enc_t enc = ENC_1BIT; enc <= ENC_1BIT_SWAPPED; enc++) {
+                    buf_t b = encode(&p, enc, td, pairs[k]);
+                    snprintf(what, sizeof(what), "pair %zu %dx%d %s%s", k, p.w, p.h, enc_names[enc], td ? " top-down" : "");
+                    CHECK_EQ(render_buf(&b, b.len, &opt_none, 2), ESP_OK);
+                    check_model(&p, pairs[k], &opt_none, 2, what);
+                    CHECK_EQ(render_buf(&b, b.len, &opt_none, 4), ESP_OK);
+                    check_model(&p, pairs[k], &opt_none, 4, what);
+                    free(b.data);
+                }
+            }
+        }
+    }
+}
+
+// Dithered frames: each encoding of a picture gives the same frame, a bottom-up
+// file the flipped frame of its top-down mirror, and the frame its golden hash
+static void dithered(void)
+{
+    static const struct {
+        BMP_OPTIONS opt;
+        int scale;
+        uint32_t golden;                // Of the 37x23 picture as 24-bit bottom-up
+    } modes[] = {
+        {{BMP_DITHER_ORDERED, 0, 0, false}, 2, 0x93470587},
+        {{BMP_DITHER_FLOYD, 0, 0, false}, 2, 0x8462CEDC},
+        {{BMP_DITHER_ATKINSON, 0, 0, false}, 2, 0x2823E92C},
+        {{BMP_DITHER_FLOYD, 0, 0, true}, 2, 0x9E66A15D},
+        {{BMP_DITHER_NONE, 0, 4, false}, 2, 0x8DE91B61},
+        {{BMP_DITHER_FLOYD, 0, 2, true}, 2, 0xC3937C74},
+        {{BMP_DITHER_FLOYD, 0, 0, false}, 4, 0xA7863D5A},
+        {{BMP_DITHER_ORDERED, 0, 0, false}, 4, 0x06BC20C5},
+        {{BMP_DITHER_ATKINSON, 0, 3, false}, 4, 0x534DE9F6},
+    };
+    static const enc_t encs[] = {ENC_24BIT, ENC_4BIT, ENC_8BIT, ENC_8BIT_SHORT, ENC_32BIT};
+    static pic_t p, flipped;
+    static uint8_t ref[sizeof(canvas)];
+
+    make_pic(&p, 37, 23, 16);
+    flip(&p, &flipped);
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        const BMP_OPTIONS *opt = &modes[m].opt;
+        int scale = modes[m].scale;
+        for (size_t e = 0; e < sizeof(encs) / sizeof(encs[0]); e++) {
+            buf_t b = encode(&p, encs[e], false, NULL);
+            CHECK_EQ(render_buf(&b, b.len, opt, scale), ESP_OK);
+            free(b.data);
+            if (e == 0) {
+                memcpy(ref, canvas, canvas_bytes());
+                uint32_t h = fnv1a(canvas, canvas_bytes());
+                if (h != modes[m].golden) TEST_FAIL("mode %zu: frame 0x%08X, golden 0x%08X", m, h, modes[m].golden);
+            } else if (memcmp(ref, canvas, canvas_bytes()) != 0) {
+                TEST_FAIL("mode %zu: %s differs from 24-bit", m, enc_names[encs[e]]);
+            }
+
+            // The same rows in the same file order, top-down
+            b = encode(&flipped, encs[e], true, NULL);
+            CHECK_EQ(render_buf(&b, b.len, opt, scale), ESP_OK);
+            free(b.data);
+            int mismatch = 0;
+            for (int y = 0; y < p.h; y++) {
+                for (int x = 0; x < p.w; x++) {
+                    int got = pixel(AT_X + x, AT_Y + p.h - 1 - y);
+                    int want = pixel_of(ref, AT_X + x, AT_Y + y);
+                    mismatch += got != want;
+                }
+            }
+            if (mismatch) TEST_FAIL("mode %zu %s top-down: %d pixels differ from the flipped bottom-up frame",
+                                    m, enc_names[encs[e]], mismatch);
+        }
+    }
+    test_checks++;
+}
+
+// A file cut short in the data draws the rows before the cut
+static void truncated(void)
+{
+    static pic_t p;
+    static const rgb_t pair[2] = {{0, 0, 0}, {255, 255, 255}};
+    static const enc_t encs[] = {ENC_1BIT, ENC_4BIT, ENC_8BIT, ENC_24BIT};
+    char what[96];
+
+    make_pic(&p, 200, 50, 16);
+    for (size_t e = 0; e < sizeof(encs) / sizeof(encs[0]); e++) {
+        pic_t q = p;
+        if (encs[e] == ENC_1BIT) make_pic(&q, 200, 50, 2);
+        const rgb_t *pal = encs[e] == ENC_1BIT ? pair : colors;
+        for (int td = 0; td < 2; td++) {
+            buf_t b = encode(&q, encs[e], td, pair);
+            uint32_t offset = b.data[10] | b.data[11] << 8;
+            uint32_t stride = (b.len - offset) / q.h;
+            // At the data, inside the first band, on a band boundary, one byte short of the end
+            const size_t cuts[] = {offset, offset + stride * 3 + 1, offset + stride * BAND_ROWS_MIN,
+                                   offset + stride * 37 + stride / 2, b.len - 1};
+            for (size_t c = 0; c < sizeof(cuts) / sizeof(cuts[0]); c++) {
+                int rows = (int)((cuts[c] - offset) / stride);
+                snprintf(what, sizeof(what), "%s%s cut after %d rows", enc_names[encs[e]], td ? " top-down" : "", rows);
+                test_case = what;
+                for (int scale = 2; scale <= 4; scale += 2) {
+                    CHECK_EQ(render_buf(&b, cuts[c], &opt_none, scale), ESP_ERR_INVALID_SIZE);
+                    // The rows read are where they belong, the others not drawn
+                    pic_t drawn = q;
+                    drawn.h = rows;
+                    if (!td) {
+                        for (int y = 0; y < rows; y++) memcpy(drawn.px[y], q.px[q.h - rows + y], q.w);
+                    }
+                    int white = scale == 2 ? 0 : 3, bad = 0;
+                    for (int y = 0; y < q.h; y++) {
+                        int py = td ? y : y - (q.h - rows);
+                        for (int x = 0; x < q.w; x++) {
+                            bool in = py >= 0 && py < rows;
+                            int want = in ? model(pal[drawn.px[py][x]], &opt_none, scale) : white;
+                            bad += pixel(AT_X + x, AT_Y + y) != want;
+                        }
+                    }
+                    test_checks++;
+                    if (bad) TEST_FAIL("scale %d: %d pixels wrong", scale, bad);
+                }
+            }
+            free(b.data);
+        }
+    }
+    test_case = "truncated";
+}
+
+static void bad_files(void)
+{
+    static pic_t p;
+    char path[128];
+    make_pic(&p, 37, 23, 16);
+    buf_t good = encode(&p, ENC_8BIT, false, NULL);
+    buf_t b = {malloc(good.len), good.len, good.len};
+
+    // Cut in the file header, the info header and the palette
+    CHECK_EQ(render_buf(&good, 0, &opt_none, 2), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(render_buf(&good, 10, &opt_none, 2), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(render_buf(&good, 16, &opt_none, 2), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(render_buf(&good, 40, &opt_none, 2), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(render_buf(&good, 54 + 100, &opt_none, 2), ESP_ERR_INVALID_SIZE);
+
+    static const struct {
+        size_t at;
+        uint32_t value;
+        int bytes;
+        esp_err_t err;
+        const char *what;
+    } patches[] = {
+        {0, 0x4D41, 2, ESP_ERR_INVALID_ARG, "magic"},
+        {10, 20, 4, ESP_ERR_INVALID_ARG, "data offset inside the headers"},
+        {14, 12, 4, ESP_ERR_NOT_SUPPORTED, "OS/2 core header"},
+        {14, 4000, 4, ESP_ERR_NOT_SUPPORTED, "info header size"},
+        {18, 0, 4, ESP_ERR_INVALID_ARG, "width 0"},
+        {18, 0x80000000u, 4, ESP_ERR_INVALID_ARG, "negative width"},
+        {18, 5000, 4, ESP_ERR_INVALID_ARG, "width over the limit"},
+        {22, 0, 4, ESP_ERR_INVALID_ARG, "height 0"},
+        {22, (uint32_t)-5000, 4, ESP_ERR_INVALID_ARG, "top-down height over the limit"},
+        {26, 2, 2, ESP_ERR_INVALID_ARG, "two planes"},
+        {28, 16, 2, ESP_ERR_NOT_SUPPORTED, "16 bpp"},
+        {28, 2, 2, ESP_ERR_NOT_SUPPORTED, "2 bpp"},
+        {30, 1, 4, ESP_ERR_NOT_SUPPORTED, "RLE8"},
+        {30, 3, 4, ESP_ERR_NOT_SUPPORTED, "bit fields below 32 bpp"},
+    };
+    for (size_t i = 0; i < sizeof(patches) / sizeof(patches[0]); i++) {
+        test_case = patches[i].what;
+        memcpy(b.data, good.data, good.len);
+        for (int k = 0; k < patches[i].bytes; k++) b.data[patches[i].at + k] = (uint8_t)(patches[i].value >> (8 * k));
+        CHECK_EQ(render_buf(&b, b.len, &opt_none, 2), patches[i].err);
+        // Nothing drawn
+        uint8_t white[sizeof(canvas)];
+        memset(white, 0xFF, canvas_bytes());
+        CHECK_MEM(canvas, white, canvas_bytes());
+    }
+    test_case = "bad_files";
+
+    // 32 bpp with BI_BITFIELDS is the usual BGRX layout
+    buf_t b32 = encode(&p, ENC_32BIT, false, NULL);
+    b32.data[30] = 3;
+    CHECK_EQ(render_buf(&b32, b32.len, &opt_none, 2), ESP_OK);
+    check_model(&p, colors, &opt_none, 2, "32-bit bit fields");
+    free(b32.data);
+
+    // More palette entries claimed than the depth has
+    memcpy(b.data, good.data, good.len);
+    b.data[46] = 0;
+    b.data[47] = 2;     // 512 colours
+    CHECK_EQ(render_buf(&b, b.len, &opt_none, 2), ESP_OK);
+    check_model(&p, colors, &opt_none, 2, "512 colours claimed");
+
+    snprintf(path, sizeof(path), "%s/missing.bmp", work_dir);
+    CHECK_EQ(GUI_LoadBmp(path, 0, 0, NULL), ESP_ERR_NOT_FOUND);
+
+    free(b.data);
+    free(good.data);
+}
+
+// Clipped at the right and bottom edges of the canvas
+static void clipped(void)
+{
+    static pic_t p;
+    make_pic(&p, 37, 23, 16);
+    buf_t b = encode(&p, ENC_24BIT, false, NULL);
+    char path[128];
+    save("clip.bmp", &b, b.len, path);
+
+    for (int scale = 2; scale <= 4; scale += 2) {
+        canvas_reset(scale);
+        CHECK_EQ(GUI_LoadBmp(path, CANVAS_W - 20, CANVAS_H - 10, &opt_none), ESP_OK);
+        int bad = 0;
+        for (int y = 0; y < CANVAS_H; y++) {
+            for (int x = 0; x < CANVAS_W; x++) {
+                int px = x - (CANVAS_W - 20), py = y - (CANVAS_H - 10);
+                bool in = px >= 0 && py >= 0;
+                int want = in ? model(colors[p.px[py][px]], &opt_none, scale) : (scale == 2 ? 0 : 3);
+                bad += pixel(x, y) != want;
+            }
+        }
+        test_checks++;
+        if (bad) TEST_FAIL("scale %d: %d pixels wrong", scale, bad);
+    }
+    free(b.data);
+}
+
+// The banded decoder yields between bands; a delay of a tick each would show here
+static void band_timing(void)
+{
+    static pic_t p;
+    struct timespec t0, t1;
+    // 600-byte rows: bands of BAND_ROWS_MIN rows
+    make_pic(&p, 200, 56, 16);
+    buf_t b = encode(&p, ENC_24BIT, false, NULL);
+    char path[128];
+    save("timed.bmp", &b, b.len, path);
+    int bands = (p.h + BAND_ROWS_MIN - 1) / BAND_ROWS_MIN;
+
+    canvas_reset(2);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < TIMED_LOADS; i++) CHECK_EQ(GUI_LoadBmp(path, AT_X, AT_Y, &opt_none), ESP_OK);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    printf("banded load: %.3f ms per %dx%d file, %d bands\n", ms / TIMED_LOADS, p.w, p.h, bands);
+    check_model(&p, colors, &opt_none, 2, "timed");
+    // Less than a millisecond a band, the least a sleep would take
+    CHECK(ms < TIMED_LOADS * bands * 1.0);
+    free(b.data);
+}
+
+int main(void)
+{
+    strcpy(work_dir, "/tmp/test_bmp.XXXXXX");
+    if (!mkdtemp(work_dir)) return 1;
+
+    TEST_RUN(depths_undithered);
+    TEST_RUN(one_bit);
+    TEST_RUN(dithered);
+    TEST_RUN(truncated);
+    TEST_RUN(bad_files);
+    TEST_RUN(clipped);
+    TEST_RUN(band_timing);
+
+    int ret = test_done();
+    if (ret == 0) {
+        char cmd[96];
+        snprintf(cmd, sizeof(cmd), "rm -rf %s", work_dir);
+        if (system(cmd) != 0) return 1;
+    }
+    return ret;
+}
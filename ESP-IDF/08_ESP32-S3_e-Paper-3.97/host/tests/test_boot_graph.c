@@ -0,0 +1,218 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "boot_graph.h"
+#include "test.h"
+
+/*
+ * components/boot_graph: the ordering and selection helpers on main.cc's
+ * table, broken tables, and the scheduler running the nodes in tasks. The
+ * table below has the dependencies and wake reasons of main.cc with the
+ * SD card needed in every mode; each init records when it started and
+ * ended on one sequence, so a dependency shows as ending before its user
+ * starts.
+ */
+
+enum { I2C, RTC, AXP, EPD, SHTC3, BUTTON, IMU, SD, SPIFFS, AUDIO, NODE_NUM };
+
+#define W_HOME      (1 << 0)
+#define W_CLOCK     (1 << 1)
+#define W_CALENDAR  (1 << 2)
+#define W_WEATHER   (1 << 3)
+#define W_ANY       (W_HOME | W_CLOCK | W_CALENDAR | W_WEATHER)
+
+#define NODE_MS     10
+
+static SemaphoreHandle_t rec_lock;
+static int seq, running, max_running;
+static int started[NODE_NUM], ended[NODE_NUM], runs[NODE_NUM];
+
+static void record(int id)
+{
+    xSemaphoreTake(rec_lock, portMAX_DELAY);
+    started[id] = ++seq;
+    if (++running > max_running) max_running = running;
+    xSemaphoreGive(rec_lock);
+
+    vTaskDelay(pdMS_TO_TICKS(NODE_MS));
+
+    xSemaphoreTake(rec_lock, portMAX_DELAY);
+    running--;
+    ended[id] = ++seq;
+    runs[id]++;
+    xSemaphoreGive(rec_lock);
+}
+
+#define NODE_INIT(id) static void init_##id(void) { record(id); }
+NODE_INIT(I2C) NODE_INIT(RTC) NODE_INIT(AXP) NODE_INIT(EPD) NODE_INIT(SHTC3)
+NODE_INIT(BUTTON) NODE_INIT(IMU) NODE_INIT(SD) NODE_INIT(SPIFFS) NODE_INIT(AUDIO)
+
+static const boot_node_t nodes[NODE_NUM] = {
+    {"i2c",    init_I2C,    0,                              W_ANY},
+    {"rtc",    init_RTC,    BOOT_BIT(I2C),                  W_ANY},
+    {"axp",    init_AXP,    BOOT_BIT(I2C),                  W_ANY},
+    {"epd",    init_EPD,    BOOT_BIT(AXP),                  W_ANY},
+    {"shtc3",  init_SHTC3,  BOOT_BIT(I2C),                  W_ANY},
+    {"button", init_BUTTON, 0,                              W_HOME},
+    {"imu",    init_IMU,    BOOT_BIT(I2C),                  W_HOME},
+    {"sd",     init_SD,     0,                              W_ANY},
+    {"spiffs", init_SPIFFS, BOOT_BIT(SD),                   W_CALENDAR | W_WEATHER},
+    {"audio",  init_AUDIO,  BOOT_BIT(I2C) | BOOT_BIT(AXP),  0},
+};
+
+#define ALL         (BOOT_BIT(NODE_NUM) - 1)
+#define COMMON      (BOOT_BIT(I2C) | BOOT_BIT(RTC) | BOOT_BIT(AXP) | BOOT_BIT(EPD) | BOOT_BIT(SHTC3) | BOOT_BIT(SD))
+
+// order[] holds every node of mask once, each after all of its dependencies
+static void check_order(const boot_node_t *tab, uint32_t mask, const uint8_t *order, int n)
+{
+    uint32_t seen = 0;
+    CHECK_EQ(n, __builtin_popcount(mask));
+    for (int i = 0; i < n; i++) {
+        uint32_t bit = BOOT_BIT(order[i]);
+        CHECK((mask & bit) && !(seen & bit));
+        if ((tab[order[i]].deps & ~seen) != 0)
+            TEST_FAIL("%s at %d before its dependencies", tab[order[i]].name, i);
+        seen |= bit;
+    }
+}
+
+static void closure_and_select(void)
+{
+    CHECK_EQ(boot_graph_closure(nodes, NODE_NUM, 0), 0);
+    CHECK_EQ(boot_graph_closure(nodes, NODE_NUM, BOOT_BIT(EPD)), BOOT_BIT(EPD) | BOOT_BIT(AXP) | BOOT_BIT(I2C));
+    CHECK_EQ(boot_graph_closure(nodes, NODE_NUM, BOOT_BIT(SPIFFS)), BOOT_BIT(SPIFFS) | BOOT_BIT(SD));
+    CHECK_EQ(boot_graph_closure(nodes, NODE_NUM, ALL), ALL);
+
+    // Per wake reason
+    CHECK_EQ(boot_graph_select(nodes, NODE_NUM, W_CLOCK), COMMON);
+    CHECK_EQ(boot_graph_select(nodes, NODE_NUM, W_HOME), COMMON | BOOT_BIT(BUTTON) | BOOT_BIT(IMU));
+    CHECK_EQ(boot_graph_select(nodes, NODE_NUM, W_CALENDAR), COMMON | BOOT_BIT(SPIFFS));
+    CHECK_EQ(boot_graph_select(nodes, NODE_NUM, W_WEATHER), COMMON | BOOT_BIT(SPIFFS));
+    CHECK_EQ(boot_graph_select(nodes, NODE_NUM, W_ANY), ALL & ~BOOT_BIT(AUDIO));
+    CHECK_EQ(boot_graph_select(nodes, NODE_NUM, 0), 0);
+
+    // What every reason needs, started before the reason is known
+    CHECK_EQ(boot_graph_select_common(nodes, NODE_NUM, W_ANY), COMMON);
+    CHECK_EQ(boot_graph_select_common(nodes, NODE_NUM, W_CALENDAR | W_WEATHER), COMMON | BOOT_BIT(SPIFFS));
+    CHECK_EQ(boot_graph_select_common(nodes, NODE_NUM, W_HOME), boot_graph_select(nodes, NODE_NUM, W_HOME));
+
+    // A node needed only on first use pulls its dependencies in with it
+    CHECK_EQ(boot_graph_closure(nodes, NODE_NUM, BOOT_BIT(AUDIO)), BOOT_BIT(AUDIO) | BOOT_BIT(AXP) | BOOT_BIT(I2C));
+}
+
+static void topological_order(void)
+{
+    uint8_t order[BOOT_GRAPH_MAX_NODES];
+
+    // Ready nodes are taken level by level, in table order within a level
+    static const uint8_t expect[NODE_NUM] = {I2C, BUTTON, SD, RTC, AXP, SHTC3, IMU, SPIFFS, EPD, AUDIO};
+    int n = boot_graph_order(nodes, NODE_NUM, ALL, order);
+    CHECK_EQ(n, NODE_NUM);
+    if (n == NODE_NUM) CHECK_MEM(order, expect, NODE_NUM);
+
+    static const uint32_t reasons[] = {W_HOME, W_CLOCK, W_CALENDAR, W_WEATHER};
+    for (int i = 0; i < 4; i++) {
+        uint32_t mask = boot_graph_select(nodes, NODE_NUM, reasons[i]);
+        check_order(nodes, mask, order, boot_graph_order(nodes, NODE_NUM, mask, order));
+    }
+    CHECK_EQ(boot_graph_order(nodes, NODE_NUM, 0, order), 0);
+
+    // A chain given backwards comes out forwards
+    boot_node_t chain[BOOT_GRAPH_MAX_NODES] = {{0}};
+    for (int i = 0; i < BOOT_GRAPH_MAX_NODES - 1; i++) chain[i].deps = BOOT_BIT(i + 1);
+    CHECK_EQ(boot_graph_order(chain, BOOT_GRAPH_MAX_NODES, BOOT_BIT(BOOT_GRAPH_MAX_NODES) - 1, order),
+             BOOT_GRAPH_MAX_NODES);
+    for (int i = 0; i < BOOT_GRAPH_MAX_NODES; i++) CHECK_EQ(order[i], BOOT_GRAPH_MAX_NODES - 1 - i);
+}
+
+static void broken_tables(void)
+{
+    uint8_t order[BOOT_GRAPH_MAX_NODES];
+
+    const boot_node_t self[] = {{"a", NULL, BOOT_BIT(0), W_ANY}};
+    CHECK_EQ(boot_graph_order(self, 1, BOOT_BIT(0), order), -1);
+
+    // a -> b -> c -> a, with d outside the cycle
+    const boot_node_t cycle[] = {
+        {"a", NULL, BOOT_BIT(2), W_ANY},
+        {"b", NULL, BOOT_BIT(0), W_ANY},
+        {"c", NULL, BOOT_BIT(1), W_ANY},
+        {"d", NULL, 0,           W_ANY},
+    };
+    CHECK_EQ(boot_graph_order(cycle, 4, 0xF, order), -1);
+    CHECK_EQ(boot_graph_order(cycle, 4, BOOT_BIT(3), order), 1);
+    CHECK_EQ(boot_graph_closure(cycle, 4, BOOT_BIT(0)), 0x7);  // The closure still ends
+
+    // A dependency past the end of the table, a node outside it, a mask that is not closed
+    const boot_node_t dangling[] = {{"a", NULL, 0, W_ANY}, {"b", NULL, BOOT_BIT(5), W_ANY}};
+    CHECK_EQ(boot_graph_order(dangling, 2, 0x3, order), -1);
+    CHECK_EQ(boot_graph_order(dangling, 2, BOOT_BIT(0), order), 1);
+    CHECK_EQ(boot_graph_order(nodes, NODE_NUM, BOOT_BIT(NODE_NUM), order), -1);
+    CHECK_EQ(boot_graph_order(nodes, NODE_NUM, BOOT_BIT(EPD), order), -1);
+
+    // More nodes than event group bits
+    boot_node_t many[BOOT_GRAPH_MAX_NODES + 1] = {{0}};
+    CHECK_EQ(boot_graph_order(many, BOOT_GRAPH_MAX_NODES + 1, 1, order), -1);
+
+    // The scheduler refuses them before any task waits on them
+    CHECK_EQ(boot_graph_init(cycle, 4), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(boot_graph_init(dangling, 2), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(boot_graph_init(many, BOOT_GRAPH_MAX_NODES + 1), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(boot_graph_init(nodes, 0), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(boot_graph_spawn(BOOT_BIT(0)), ESP_ERR_INVALID_STATE);
+}
+
+// Every node that ran started after its dependencies ended
+static void check_ran(uint32_t mask)
+{
+    for (int i = 0; i < NODE_NUM; i++) {
+        CHECK_EQ(runs[i], (mask & BOOT_BIT(i)) ? 1 : 0);
+        if (!(mask & BOOT_BIT(i))) continue;
+        for (int d = 0; d < NODE_NUM; d++) {
+            if ((nodes[i].deps & BOOT_BIT(d)) && ended[d] > started[i])
+                TEST_FAIL("%s started at %d, before %s ended at %d", nodes[i].name, started[i], nodes[d].name, ended[d]);
+        }
+    }
+}
+
+// Runs last, the scheduler keeps its table
+static void scheduler(void)
+{
+    rec_lock = xSemaphoreCreateMutex();
+    CHECK_EQ(boot_graph_init(nodes, NODE_NUM), ESP_OK);
+    CHECK(!boot_graph_is_done(I2C));
+
+    // A clock wake-up: the nodes every mode needs, then the mode's own
+    CHECK_EQ(boot_graph_run(boot_graph_select_common(nodes, NODE_NUM, W_ANY)), ESP_OK);
+    check_ran(COMMON);
+    CHECK_EQ(boot_graph_run(boot_graph_select(nodes, NODE_NUM, W_CLOCK)), ESP_OK);
+    check_ran(COMMON);
+    for (int i = 0; i < NODE_NUM; i++) CHECK_EQ(boot_graph_is_done(i), (COMMON & BOOT_BIT(i)) != 0);
+
+    // rtc, axp, shtc3 and sd have nothing between them
+    CHECK(max_running >= 3);
+
+    // The home page's extras, then the deferred ones on first use
+    CHECK_EQ(boot_graph_spawn(boot_graph_select(nodes, NODE_NUM, W_HOME)), ESP_OK);
+    CHECK_EQ(boot_graph_run(boot_graph_select(nodes, NODE_NUM, W_HOME)), ESP_OK);
+    check_ran(boot_graph_select(nodes, NODE_NUM, W_HOME));
+    boot_graph_ensure(AUDIO);
+    CHECK(boot_graph_is_done(AUDIO));
+    boot_graph_ensure(AUDIO);
+    boot_graph_ensure(NODE_NUM);
+    boot_graph_ensure(-1);
+    CHECK_EQ(boot_graph_run(BOOT_BIT(SPIFFS)), ESP_OK);
+    check_ran(ALL);
+    CHECK_EQ(boot_graph_spawn(BOOT_BIT(NODE_NUM)), ESP_ERR_INVALID_ARG);
+    boot_graph_log_timeline();
+}
+
+int main(void)
+{
+    TEST_RUN(closure_and_select);
+    TEST_RUN(topological_order);
+    TEST_RUN(broken_tables);
+    TEST_RUN(scheduler);
+    return test_done();
+}
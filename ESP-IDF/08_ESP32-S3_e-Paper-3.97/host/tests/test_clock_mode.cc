@@ -0,0 +1,198 @@
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "nvs_flash.h"
+#include "sdcard_bsp.h"
+#include "epaper_port.h"
+#include "mem_arena.h"
+#include "energy_prof.h"
+#include "pcf85063_bsp.h"
+#include "page_clock.h"
+#include "sim.h"
+#include "test.h"
+
+/*
+ * Clock mode of main/page_clock across wake-ups. Each minute is a wake-up of
+ * its own, run in a child process that powers off at the end as the board
+ * does, NVS carried over in a file. A wake-up that is not on the hour or the
+ * half hour rebuilds the previous frame from the saved Clock_TH_Old and
+ * shows it before drawing the new minute into it: that first frame must be
+ * the last one of the previous wake-up, byte for byte. The frame it ends on
+ * must in turn be what a full redraw of the same minute gives.
+ */
+
+// What main.cc defines for the pages
+SemaphoreHandle_t alarm_mutex;
+SemaphoreHandle_t nvs_mutex;
+SemaphoreHandle_t qmi8658_mutex;
+bool wifi_enable;
+uint8_t *Image_Mono;
+
+typedef struct {
+    const char *at;             // Local time, "YYYY-MM-DD HH:MM"
+    float temp, humi;
+    int battery;
+} wake_t;
+
+static std::string work_dir;
+
+static time_t parse_time(const char *s)
+{
+    struct tm tm = {};
+    sscanf(s, "%d-%d-%d %d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min);
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return timegm(&tm);
+}
+
+static void wake_task(void *arg)
+{
+    (void)arg;
+    PCF85063_init();
+    _sdcard_init();
+    epaper_port_init();
+    EPD_Init();
+    mem_arena_init();
+    Image_Mono = (uint8_t *)mem_alloc(EPD_SIZE_MONO);
+    page_clock_show_mode();
+    // Clock mode ends in axp_pwr_off()
+    sim_fatal("page_clock_show_mode returned");
+}
+
+// One wake-up in clock mode, its frames written to frames_dir
+static bool run_wake(const wake_t *w, const std::string &nvs, const std::string &frames_dir)
+{
+    mkdir(frames_dir.c_str(), 0755);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // The run summary of sim_finish() is of no interest here
+        if (!freopen("/dev/null", "w", stdout)) _exit(1);
+        sim_config.sd_dir = getenv("EPAPER_TEST_SD");
+        sim_config.nvs_path = nvs.c_str();
+        sim_config.frames_dir = frames_dir.c_str();
+        host_nvs_load(sim_config.nvs_path);
+        nvs_flash_init();
+        alarm_mutex = xSemaphoreCreateMutex();
+        nvs_mutex = xSemaphoreCreateMutex();
+        qmi8658_mutex = xSemaphoreCreateMutex();
+        energy_prof_init();
+        save_mode_enable_to_nvs(1);
+        sim_rtc_set(parse_time(w->at));
+        sim_env_set(w->temp, w->humi);
+        sim_battery_set(w->battery, false);
+        xTaskCreate(wake_task, "clock_mode", 256 * 1024, NULL, 3, NULL);
+        for (;;) vTaskDelay(portMAX_DELAY);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Frames of a wake-up in the order they were shown
+static std::vector<std::string> frames_of(const std::string &dir)
+{
+    std::vector<std::string> names;
+    DIR *d = opendir(dir.c_str());
+    if (!d) return names;
+    while (struct dirent *e = readdir(d)) {
+        if (e->d_name[0] != '.') names.push_back(dir + "/" + e->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static std::vector<uint8_t> read_file(const std::string &path)
+{
+    std::vector<uint8_t> data;
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) return data;
+    int c;
+    while ((c = fgetc(fp)) != EOF) data.push_back((uint8_t)c);
+    fclose(fp);
+    return data;
+}
+
+static void check_same(const std::string &got, const std::string &expect)
+{
+    std::vector<uint8_t> a = read_file(got), b = read_file(expect);
+    if (a.empty() || a.size() != b.size()) {
+        TEST_FAIL("%s: %zu bytes, %s: %zu", got.c_str(), a.size(), expect.c_str(), b.size());
+        return;
+    }
+    CHECK_MEM(a.data(), b.data(), a.size());
+}
+
+static void consecutive_minutes(void)
+{
+    static const wake_t wakes[] = {
+        {"2026-10-19 09:27", 23.5f, 45.0f, 80},
+        {"2026-10-19 09:28", 23.5f, 45.0f, 80},
+        {"2026-10-19 09:29", 23.6f, 45.0f, 79},     // Temperature and battery change
+        {"2026-10-19 09:30", 23.6f, 46.2f, 79},     // Full refresh on the half hour
+        {"2026-10-19 09:31", 23.6f, 46.2f, 79},
+        {"2026-10-19 09:59", 21.0f, 46.2f, 100},    // Woken late, a new hour
+        {"2026-10-19 10:01", 21.0f, 46.2f, 100},
+        {"2026-10-19 23:59", 19.9f, 60.0f, 8},      // Across midnight, a new date and weekday
+        {"2026-10-20 00:01", 19.9f, 60.0f, 8},
+        {"2026-10-20 00:02", -5.5f, 99.5f, 0},
+    };
+    const int n = sizeof(wakes) / sizeof(wakes[0]);
+    std::string nvs = work_dir + "/nvs.txt";
+    std::vector<std::string> last(n);
+
+    for (int i = 0; i < n; i++) {
+        test_case = wakes[i].at;
+        std::string dir = work_dir + "/wake" + std::to_string(i);
+        CHECK(run_wake(&wakes[i], nvs, dir));
+        std::vector<std::string> frames = frames_of(dir);
+        CHECK(!frames.empty());
+        if (frames.empty()) return;
+        last[i] = frames.back();
+
+        // The minute on its own, from a device that has no saved clock state
+        std::string fresh_dir = dir + "_fresh", fresh_nvs = fresh_dir + ".nvs";
+        unlink(fresh_nvs.c_str());
+        CHECK(run_wake(&wakes[i], fresh_nvs, fresh_dir));
+        std::vector<std::string> fresh = frames_of(fresh_dir);
+        CHECK(!fresh.empty());
+        if (!fresh.empty()) check_same(last[i], fresh.back());
+
+        int minute = atoi(wakes[i].at + 14);
+        if (i == 0 || minute == 0 || minute == 30) {
+            CHECK_EQ(frames.size(), 1);
+            continue;
+        }
+        // The rebuilt frame, then the new minute
+        CHECK_EQ(frames.size(), 2);
+        check_same(frames.front(), last[i - 1]);
+    }
+}
+
+int main(void)
+{
+    if (!getenv("EPAPER_TEST_SD")) {
+        fprintf(stderr, "EPAPER_TEST_SD: directory laid out by tools/make_sdcard.py\n");
+        return 1;
+    }
+    char tmpl[] = "/tmp/test_clock_mode.XXXXXX";
+    if (!mkdtemp(tmpl)) return 1;
+    work_dir = tmpl;
+
+    TEST_RUN(consecutive_minutes);
+    int ret = test_done();
+    if (ret == 0) {
+        std::string cmd = "rm -rf " + work_dir;
+        if (system(cmd.c_str()) != 0) return 1;
+    }
+    return ret;
+}
@@ -0,0 +1,360 @@
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "dns_responder.h"
+#include "test.h"
+
+/*
+ * The captive portal DNS answers of components/esp-wifi-connect: the A
+ * record for every name, empty answers for other types, FORMERR, NOTIMP and
+ * silence for what is not a proper query, every prefix of a query, random
+ * corruptions that must never give a reply longer than the buffer or one
+ * that does not match the query, and the per-client token bucket. Queries
+ * are copied into buffers of their exact length so a build with
+ * -fsanitize=address catches any read past them.
+ */
+
+#define PORTAL_IP   0x0104A8C0u     // 192.168.4.1 in network byte order
+#define NOW         100000
+
+typedef std::vector<uint8_t> packet_t;
+
+static void put16(packet_t &p, uint16_t v)
+{
+    p.push_back(v >> 8);
+    p.push_back(v & 0xFF);
+}
+
+static void put_name(packet_t &p, const char *name)
+{
+    while (*name) {
+        const char *dot = strchr(name, '.');
+        size_t n = dot ? (size_t)(dot - name) : strlen(name);
+        p.push_back((uint8_t)n);
+        p.insert(p.end(), name, name + n);
+        name += n + (dot != nullptr);
+    }
+    p.push_back(0);
+}
+
+// A standard query with recursion desired, optionally with an EDNS OPT record
+static packet_t query(uint16_t id, const char *name, uint16_t type, uint16_t qclass = 1, bool edns = false)
+{
+    packet_t p;
+    put16(p, id);
+    put16(p, 0x0100);
+    put16(p, 1);
+    put16(p, 0);
+    put16(p, 0);
+    put16(p, edns ? 1 : 0);
+    put_name(p, name);
+    put16(p, type);
+    put16(p, qclass);
+    if (edns) {
+        static const uint8_t opt[] = {0, 0, 41, 0x10, 0, 0, 0, 0, 0, 0, 0};
+        p.insert(p.end(), opt, opt + sizeof(opt));
+    }
+    return p;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] << 8 | p[1];
+}
+
+// Ask through a buffer of the query's exact length, by default from a client the limit does not hold back
+static size_t ask(DnsResponder &dns, const packet_t &q, uint8_t *reply, size_t reply_size = DnsResponder::kMaxPacket,
+                  uint32_t client = 0, int64_t now = NOW)
+{
+    static uint32_t next_client = 1000;
+    if (client == 0) client = next_client++;
+    uint8_t *exact = (uint8_t *)malloc(q.size() ? q.size() : 1);
+    if (!q.empty()) memcpy(exact, q.data(), q.size());
+    size_t n = dns.Respond(exact, q.size(), reply, reply_size, client, now);
+    free(exact);
+    return n;
+}
+
+static size_t question_end(const packet_t &q)
+{
+    DnsQuestion question;
+    return DnsResponder::ParseQuestion(q.data(), q.size(), &question) ? question.end : 0;
+}
+
+static void answers(void)
+{
+    DnsResponder dns(PORTAL_IP);
+    uint8_t reply[DnsResponder::kMaxPacket];
+
+    packet_t q = query(0x1234, "connectivitycheck.gstatic.com", 1);
+    size_t qend = q.size();
+    CHECK_EQ(ask(dns, q, reply), qend + 16);
+    CHECK_EQ(get16(reply), 0x1234);
+    CHECK_EQ(reply[2], 0x85);                   // QR, AA, RD
+    CHECK_EQ(reply[3], 0x80);                   // RA, NOERROR
+    CHECK_EQ(get16(reply + 4), 1);
+    CHECK_EQ(get16(reply + 6), 1);
+    CHECK_EQ(get16(reply + 8), 0);
+    CHECK_EQ(get16(reply + 10), 0);
+    CHECK_MEM(reply + 12, q.data() + 12, qend - 12);
+    static const uint8_t rr[] = {0xC0, 12, 0, 1, 0, 1, 0, 0, 0, DnsResponder::kTtl, 0, 4, 192, 168, 4, 1};
+    CHECK_MEM(reply + qend, rr, sizeof(rr));
+
+    // ANY and class ANY get the address as well, the question as sent (0x20 case mixing)
+    q = query(7, "WwW.ExAmPlE.cOm", 255, 255);
+    CHECK_EQ(ask(dns, q, reply), q.size() + 16);
+    CHECK_MEM(reply + 12, q.data() + 12, q.size() - 12);
+    // The root
+    q = query(8, "", 1);
+    CHECK_EQ(q.size(), 17);
+    CHECK_EQ(ask(dns, q, reply), 17 + 16);
+
+    // No RD asked, none echoed
+    q = query(9, "a.b", 1);
+    q[2] = 0;
+    CHECK_EQ(ask(dns, q, reply), q.size() + 16);
+    CHECK_EQ(reply[2], 0x84);
+
+    // Other types and classes: NOERROR without answers
+    static const struct {
+        uint16_t type, qclass;
+    } empty[] = {{28, 1}, {65, 1}, {15, 1}, {16, 1}, {1, 3}, {1, 4}};
+    for (const auto &e : empty) {
+        q = query(10, "example.com", e.type, e.qclass);
+        size_t n = ask(dns, q, reply);
+        test_checks++;
+        if (n != q.size() || reply[3] != 0x80 || get16(reply + 6) != 0) {
+            TEST_FAIL("type %d class %d: %zu bytes, rcode %d, %d answers", e.type, e.qclass, n, reply[3] & 15,
+                      get16(reply + 6));
+        }
+    }
+
+    // EDNS is not echoed, so the client stays within 512 bytes
+    q = query(11, "example.com", 1, 1, true);
+    qend = question_end(q);
+    CHECK_EQ(ask(dns, q, reply), qend + 16);
+    CHECK_EQ(get16(reply + 10), 0);
+
+    // The address is the one set last
+    dns.SetPortalIp(0x0200000Au);
+    q = query(12, "x", 1);
+    CHECK_EQ(ask(dns, q, reply), q.size() + 16);
+    static const uint8_t ip[] = {10, 0, 0, 2};
+    CHECK_MEM(reply + q.size() + 12, ip, 4);
+
+    CHECK_EQ(dns.stats().answered, 6);
+    CHECK_EQ(dns.stats().empty, 6);
+    CHECK_EQ(dns.stats().errors, 0);
+}
+
+// A header that is readable gets FORMERR or NOTIMP, one that is not gets nothing
+static void malformed(void)
+{
+    DnsResponder dns(PORTAL_IP);
+    uint8_t reply[DnsResponder::kMaxPacket];
+    packet_t q;
+
+    auto expect_error = [&](const packet_t &p, int rcode, const char *what) {
+        memset(reply, 0xEE, sizeof(reply));
+        size_t n = ask(dns, p, reply);
+        test_checks++;
+        if (n != 12 || get16(reply) != get16(p.data()) || (reply[2] & 0x80) == 0 || (reply[3] & 15) != rcode ||
+            get16(reply + 4) || get16(reply + 6) || get16(reply + 8) || get16(reply + 10)) {
+            TEST_FAIL("%s: %zu bytes, rcode %d, expected 12 bytes, rcode %d", what, n, reply[3] & 15, rcode);
+        }
+    };
+
+    // Opcodes other than QUERY, the opcode echoed
+    q = query(1, "example.com", 1);
+    q[2] = 0x10 | 0x01;
+    expect_error(q, 4, "opcode 2");
+    CHECK_EQ(reply[2], 0x91);
+    q[2] = 0x28;
+    expect_error(q, 4, "opcode 5");
+
+    // Question count other than one
+    q = query(2, "example.com", 1);
+    q[5] = 0;
+    expect_error(q, 1, "no question");
+    q[5] = 2;
+    expect_error(q, 1, "two questions");
+    q[4] = 1;
+    q[5] = 1;
+    expect_error(q, 1, "257 questions");
+
+    // Labels of the reserved types, compression, past the end
+    q = query(3, std::string(64, 'a').c_str(), 1);
+    expect_error(q, 1, "label of 64");
+    q = query(3, "example.com", 1);
+    q[12] = 0xC0;
+    q[13] = 12;
+    expect_error(q, 1, "compression pointer");
+    q = query(3, "example.com", 1);
+    q[12] = 40;
+    expect_error(q, 1, "label past the end");
+
+    // The longest name on the wire is 255 bytes: 253 dotted characters
+    std::string name = std::string(63, 'a') + "." + std::string(63, 'b') + "." + std::string(63, 'c') + "." +
+                       std::string(61, 'd');
+    CHECK_EQ(name.size(), 253);
+    q = query(4, name.c_str(), 1);
+    CHECK_EQ(ask(dns, q, reply), q.size() + 16);
+    DnsQuestion question;
+    CHECK(DnsResponder::ParseQuestion(q.data(), q.size(), &question));
+    CHECK_STR(question.name, name.c_str());
+    name += "d";
+    q = query(4, name.c_str(), 1);
+    expect_error(q, 1, "254 characters");
+
+    // No room for type and class
+    q = query(5, "example.com", 1);
+    q.resize(q.size() - 1);
+    expect_error(q, 1, "no class");
+    q.resize(q.size() - 3);
+    expect_error(q, 1, "no type");
+    q.resize(q.size() - 1);
+    expect_error(q, 1, "no root label");
+
+    // Shorter than a header, or a response: nothing, answering could start a loop
+    uint32_t dropped = dns.stats().dropped;
+    q = query(6, "example.com", 1);
+    q[2] |= 0x80;
+    CHECK_EQ(ask(dns, q, reply), 0);
+    q.resize(11);
+    CHECK_EQ(ask(dns, q, reply), 0);
+    q.clear();
+    CHECK_EQ(ask(dns, q, reply), 0);
+    CHECK_EQ(dns.stats().dropped, dropped + 3);
+
+    // A reply buffer too small is not written past
+    q = query(7, "example.com", 1);
+    memset(reply, 0xEE, sizeof(reply));
+    CHECK_EQ(ask(dns, q, reply, q.size() + 15), 0);
+    CHECK_EQ(reply[0], 0xEE);
+    CHECK_EQ(ask(dns, q, reply, q.size() + 16), q.size() + 16);
+    q[5] = 0;
+    CHECK_EQ(ask(dns, q, reply, 11), 0);
+    CHECK_EQ(ask(dns, q, reply, 12), 12);
+}
+
+// Every prefix of a query: nothing, then FORMERR, then the answer
+static void prefixes(void)
+{
+    DnsResponder dns(PORTAL_IP);
+    uint8_t reply[DnsResponder::kMaxPacket];
+    packet_t q = query(0xBEEF, "captive.apple.com", 1, 1, true);
+    size_t qend = question_end(q);
+
+    for (size_t len = 0; len <= q.size(); len++) {
+        packet_t p(q.begin(), q.begin() + len);
+        size_t want = len < 12 ? 0 : len < qend ? 12 : qend + 16;
+        size_t n = ask(dns, p, reply, sizeof(reply), 1, NOW + 1000 * (int64_t)len);
+        test_checks++;
+        if (n != want) TEST_FAIL("%zu of %zu bytes: reply of %zu, expected %zu", len, q.size(), n, want);
+    }
+}
+
+// Whatever arrives, a reply fits its buffer, matches the query and reads back
+static void corrupted(void)
+{
+    DnsResponder dns(PORTAL_IP);
+    uint8_t reply[DnsResponder::kMaxPacket + 1];        // The last byte must stay untouched
+    uint32_t rng = 2024;
+    auto next = [&rng]() {
+        rng = rng * 1664525u + 1013904223u;
+        return rng >> 8;
+    };
+    const packet_t seeds[] = {
+        query(1, "example.com", 1), query(2, "a.b.c.d.e.f.g", 28), query(3, "", 255, 255, true),
+        query(4, (std::string(60, 'x') + "." + std::string(60, 'y') + "." + std::string(60, 'z')).c_str(), 1),
+    };
+    int replies = 0;
+
+    for (int i = 0; i < 40000; i++) {
+        packet_t p = seeds[i % 4];
+        int edits = 1 + next() % 4;
+        for (int e = 0; e < edits; e++) {
+            switch (next() % 4) {
+            case 0: p[next() % p.size()] = next(); break;
+            case 1: p[next() % p.size()] ^= 1 << (next() % 8); break;
+            case 2: p.resize(next() % (p.size() + 1)); break;
+            default: p.insert(p.end(), next() % 8, next()); break;
+            }
+            if (p.empty()) break;
+        }
+        size_t reply_size = next() % 2 ? DnsResponder::kMaxPacket : 12 + next() % 64;
+        memset(reply, 0xEE, sizeof(reply));
+        size_t n = ask(dns, p, reply, reply_size, i, NOW + i);
+        if (n == 0) continue;
+        replies++;
+        test_checks++;
+        if (n < 12 || n > reply_size || reply[reply_size] != 0xEE || p.size() < 12 || memcmp(reply, p.data(), 2) ||
+            !(reply[2] & 0x80)) {
+            TEST_FAIL("mutation %d: bad reply of %zu bytes to %zu", i, n, p.size());
+            return;
+        }
+        if ((reply[3] & 15) != 0) continue;
+        // An answer echoes the question it was given and holds at most the A record
+        DnsQuestion asked, echoed;
+        if (!DnsResponder::ParseQuestion(p.data(), p.size(), &asked) ||
+            !DnsResponder::ParseQuestion(reply, n, &echoed) || strcmp(asked.name, echoed.name) ||
+            asked.type != echoed.type || n != echoed.end + 16 * get16(reply + 6) || get16(reply + 6) > 1) {
+            TEST_FAIL("mutation %d: answer of %zu bytes does not match the query", i, n);
+            return;
+        }
+    }
+    CHECK(replies > 10000);
+    const DnsResponder::Stats &st = dns.stats();
+    CHECK_EQ(st.answered + st.empty + st.errors + st.dropped + st.limited, 40000);
+}
+
+static void rate_limit(void)
+{
+    DnsResponder dns(PORTAL_IP);
+    int64_t t = NOW;
+
+    for (int i = 0; i < DnsResponder::kBurst; i++) CHECK(dns.Allow(1, t));
+    CHECK(!dns.Allow(1, t));
+    // kRefillPerSecond: one every 125 ms
+    CHECK(!dns.Allow(1, t + 124));
+    CHECK(dns.Allow(1, t + 125));
+    CHECK(!dns.Allow(1, t + 125));
+    // However long the pause, no more than a burst
+    t += 3600 * 1000;
+    for (int i = 0; i < DnsResponder::kBurst; i++) CHECK(dns.Allow(1, t));
+    CHECK(!dns.Allow(1, t));
+    // A clock that went back refills nothing
+    CHECK(!dns.Allow(1, t - 5000));
+
+    // Each client its own bucket; a ninth takes the one of the client quiet longest
+    DnsResponder many(PORTAL_IP);
+    t = NOW;
+    for (uint32_t c = 1; c <= DnsResponder::kMaxClients; c++) {
+        for (int i = 0; i < DnsResponder::kBurst; i++) many.Allow(c, t + c);
+        CHECK(!many.Allow(c, t + c));
+    }
+    t += 20;
+    CHECK(many.Allow(9, t));
+    CHECK(many.Allow(1, t));            // Forgotten, starts full
+    CHECK(!many.Allow(3, t));           // Still drained
+    CHECK(!many.Allow(8, t));
+
+    // The limited are counted and get no reply
+    uint8_t reply[DnsResponder::kMaxPacket];
+    packet_t q = query(1, "example.com", 1);
+    for (int i = 0; i < DnsResponder::kBurst; i++) ask(dns, q, reply, sizeof(reply), 42, 0);
+    CHECK_EQ(ask(dns, q, reply, sizeof(reply), 42, 0), 0);
+    CHECK_EQ(dns.stats().limited, 1);
+    CHECK_EQ(dns.stats().answered, DnsResponder::kBurst);
+}
+
+int main(void)
+{
+    TEST_RUN(answers);
+    TEST_RUN(malformed);
+    TEST_RUN(prefixes);
+    TEST_RUN(corrupted);
+    TEST_RUN(rate_limit);
+    return test_done();
+}
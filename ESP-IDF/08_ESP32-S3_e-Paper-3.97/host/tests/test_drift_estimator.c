@@ -0,0 +1,237 @@
+#include <math.h>
+#include <stdlib.h>
+#include "drift_estimator.h"
+#include "test.h"
+
+/*
+ * The RTC drift estimator of components/time_sync against a simulated
+ * crystal: each sync measures the offset the crystal built up since the
+ * last one with the trim then programmed, plus up to DS_MEASURE_MS of NTP
+ * error. The estimate must settle on the crystal, the trim follow it, the
+ * interval between syncs grow while the error at each sync stays within
+ * DS_ERROR_BUDGET_MS, and single outliers be dropped where two in a row
+ * restart the history.
+ */
+
+#define DAY         86400
+#define T0          1760000000LL
+
+static uint32_t rng = 12345;
+
+// Uniform in [-1, 1), the same sequence on every run
+static float noise(void)
+{
+    rng = rng * 1103515245u + 12345u;
+    return (float)((rng >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+typedef struct {
+    ds_state_t s;
+    int64_t now;
+    float crystal;          // True rate without trim, ppm
+    float worst_ms;         // Largest offset met at an accepted sync
+} rtc_sim_t;
+
+static void sim_start(rtc_sim_t *r, float crystal, int max_days)
+{
+    ds_init(&r->s, max_days);
+    r->now = T0;
+    r->crystal = crystal;
+    r->worst_ms = 0;
+}
+
+// Run until the planned sync and measure, the RTC is set again after it
+static ds_result_t sim_sync(rtc_sim_t *r)
+{
+    uint32_t interval = r->s.interval_days * DAY;
+    float rate = r->crystal + r->s.trim * DS_TRIM_PPM;
+    float offset = rate * interval / 1000.0f + DS_MEASURE_MS * noise();
+    r->now += interval;
+    ds_result_t res = ds_add(&r->s, r->now, interval, offset);
+    if (res == DS_ACCEPTED && fabsf(offset) > r->worst_ms) r->worst_ms = fabsf(offset);
+    return res;
+}
+
+static void converges(void)
+{
+    static const float crystals[] = {0.0f, 3.1f, -7.5f, 20.0f, -20.0f, 55.0f, -120.0f, 250.0f};
+
+    for (size_t i = 0; i < sizeof(crystals) / sizeof(crystals[0]); i++) {
+        rtc_sim_t r;
+        sim_start(&r, crystals[i], 30);
+
+        // The first sync only measures, the trim comes with the second
+        CHECK_EQ(sim_sync(&r), DS_ACCEPTED);
+        CHECK_EQ(r.s.trim, 0);
+        CHECK_EQ(r.s.interval_days, 1);
+
+        int prev_days = 1;
+        for (int n = 0; n < 40; n++) {
+            ds_result_t res = sim_sync(&r);
+            if (res != DS_ACCEPTED) {
+                TEST_FAIL("crystal %+.1f ppm, sync %d: result %d", crystals[i], n, res);
+                break;
+            }
+            // Until the second sync the crystal runs untrimmed
+            if (n == 0) r.worst_ms = 0;
+            // Never more than doubled per sync
+            if (r.s.interval_days > 2 * prev_days) {
+                TEST_FAIL("crystal %+.1f ppm: %d days after %d", crystals[i], r.s.interval_days, prev_days);
+            }
+            prev_days = r.s.interval_days;
+        }
+        test_checks++;
+        if (fabsf(r.s.ppm - crystals[i]) > r.s.sigma) {
+            TEST_FAIL("crystal %+.1f ppm estimated %+.3f +- %.3f", crystals[i], r.s.ppm, r.s.sigma);
+        }
+        // The trim is the nearest step, or the end of its range
+        long want = lroundf(-crystals[i] / DS_TRIM_PPM);
+        if (want < DS_TRIM_MIN) want = DS_TRIM_MIN;
+        if (want > DS_TRIM_MAX) want = DS_TRIM_MAX;
+        CHECK(labs(r.s.trim - want) <= 1);
+        // The error at a sync stays in budget, NTP error aside
+        test_checks++;
+        if (r.worst_ms > DS_ERROR_BUDGET_MS + DS_MEASURE_MS) {
+            TEST_FAIL("crystal %+.1f ppm: %.0f ms at a sync", crystals[i], r.worst_ms);
+        }
+        // The longest interval in budget: what the trim step leaves decides it
+        float ms_a_day = (fabsf(ds_residual_ppm(&r.s)) + r.s.sigma) * 86.4f;
+        CHECK(r.s.interval_days * ms_a_day <= DS_ERROR_BUDGET_MS);
+        CHECK(r.s.interval_days == r.s.max_days || (r.s.interval_days + 1) * ms_a_day > DS_ERROR_BUDGET_MS);
+    }
+
+    // Past the trim range the residual leaves a shorter interval
+    rtc_sim_t r;
+    sim_start(&r, 290.0f, 30);
+    for (int n = 0; n < 20; n++) sim_sync(&r);
+    CHECK_EQ(r.s.trim, DS_TRIM_MIN);
+    CHECK_NEAR(ds_residual_ppm(&r.s), 290.0f + DS_TRIM_MIN * DS_TRIM_PPM, 0.5f);
+    CHECK(r.s.interval_days < 30);
+    sim_start(&r, -290.0f, 30);
+    for (int n = 0; n < 20; n++) sim_sync(&r);
+    CHECK_EQ(r.s.trim, DS_TRIM_MAX);
+}
+
+static void invalid(void)
+{
+    ds_state_t s, before;
+    ds_init(&s, 30);
+    CHECK_EQ(ds_add(&s, T0, DAY, 1728.0f), DS_ACCEPTED);         // +20 ppm
+    CHECK_EQ(ds_add(&s, T0 + DAY, DAY, 1728.0f), DS_ACCEPTED);
+    s.interval_days = 4;
+    before = s;
+
+    // Too short to say anything: not even the plan changes
+    CHECK_EQ(ds_add(&s, T0 + 2 * DAY, DS_MIN_INTERVAL - 1, 0.0f), DS_INVALID);
+    CHECK_MEM(&s, &before, sizeof(s));
+    // Set by hand or a wrong NTP answer: sync again soon
+    CHECK_EQ(ds_add(&s, T0 + 2 * DAY, DAY, (DS_MAX_PPM + 1) * DAY / 1000.0f), DS_INVALID);
+    CHECK_EQ(s.interval_days, 1);
+    CHECK_EQ(ds_add(&s, T0 + 2 * DAY, DAY, -(DS_MAX_PPM + 1) * DAY / 1000.0f), DS_INVALID);
+    CHECK_EQ(ds_add(&s, T0 + 2 * DAY, DAY, NAN), DS_INVALID);
+    CHECK_EQ(ds_add(&s, T0 + 2 * DAY, DAY, INFINITY), DS_INVALID);
+    CHECK_EQ(s.count, 2);
+    CHECK_EQ(s.outliers, 0);
+    CHECK_NEAR(s.ppm, 20.0f, 1e-3);
+
+    // ds_init keeps max_days in what fits its field
+    ds_init(&s, 0);
+    CHECK_EQ(s.max_days, 1);
+    ds_init(&s, 1000);
+    CHECK_EQ(s.max_days, 255);
+}
+
+static void outliers(void)
+{
+    rtc_sim_t r;
+    sim_start(&r, 12.0f, 16);
+    for (int n = 0; n < 10; n++) sim_sync(&r);
+    ds_state_t settled = r.s;
+    CHECK_EQ(settled.count, DS_MAX_SAMPLES);
+
+    // One sample far off is dropped and the next sync comes the next day
+    uint32_t interval = r.s.interval_days * DAY;
+    float far = (12.0f + 40.0f + r.s.trim * DS_TRIM_PPM) * interval / 1000.0f;
+    CHECK_EQ(ds_add(&r.s, r.now + interval, interval, far), DS_OUTLIER);
+    CHECK_EQ(r.s.count, settled.count);
+    CHECK_NEAR(r.s.ppm, settled.ppm, 0);
+    CHECK_EQ(r.s.trim, settled.trim);
+    CHECK_EQ(r.s.interval_days, 1);
+    CHECK_EQ(r.s.outliers, 1);
+    r.now += interval;
+
+    // A good one after it clears the count, so outliers apart never restart
+    CHECK_EQ(sim_sync(&r), DS_ACCEPTED);
+    CHECK_EQ(r.s.outliers, 0);
+    interval = r.s.interval_days * DAY;
+    far = (12.0f - 40.0f + r.s.trim * DS_TRIM_PPM) * interval / 1000.0f;
+    CHECK_EQ(ds_add(&r.s, r.now + interval, interval, far), DS_OUTLIER);
+    r.now += interval;
+    CHECK_EQ(sim_sync(&r), DS_ACCEPTED);
+
+    // Two in a row are a new crystal rate (another room, a new battery)
+    r.crystal = 45.0f;
+    CHECK_EQ(sim_sync(&r), DS_OUTLIER);
+    CHECK_EQ(sim_sync(&r), DS_RESTARTED);
+    CHECK_EQ(r.s.count, 1);
+    CHECK_EQ(r.s.outliers, 0);
+    CHECK_EQ(r.s.interval_days, 1);
+    CHECK_NEAR(r.s.ppm, 45.0f, 1.0f);
+    for (int n = 0; n < 20; n++) {
+        if (sim_sync(&r) != DS_ACCEPTED) {
+            TEST_FAIL("sync %d after the restart rejected", n);
+            break;
+        }
+    }
+    CHECK_NEAR(r.s.ppm, 45.0f, r.s.sigma);
+    CHECK_EQ(r.s.trim, lroundf(-45.0f / DS_TRIM_PPM));
+
+    // However tight the estimate, a few ppm is not an outlier
+    ds_state_t s;
+    ds_init(&s, 30);
+    for (int n = 0; n < DS_MAX_SAMPLES; n++) {
+        CHECK_EQ(ds_add(&s, T0 + n * 30LL * DAY, 30 * DAY, 0.0f), DS_ACCEPTED);
+    }
+    CHECK(s.sigma < 0.1f);
+    CHECK_EQ(ds_add(&s, T0 + 300LL * DAY, 30 * DAY, 2.9f * 30 * DAY / 1000.0f), DS_ACCEPTED);
+    CHECK_EQ(ds_add(&s, T0 + 330LL * DAY, 30 * DAY, 10.0f * 30 * DAY / 1000.0f), DS_OUTLIER);
+    // Before two samples there is nothing to be off from
+    ds_init(&s, 30);
+    CHECK_EQ(ds_add(&s, T0, DAY, 0.0f), DS_ACCEPTED);
+    CHECK_EQ(ds_add(&s, T0 + DAY, DAY, 100.0f * DAY / 1000.0f), DS_ACCEPTED);
+}
+
+// Long samples outweigh short ones, the oldest sample goes first
+static void weights_and_window(void)
+{
+    ds_state_t s;
+    ds_init(&s, 30);
+    CHECK_EQ(ds_add(&s, T0, DAY, 10.0f * DAY / 1000.0f), DS_ACCEPTED);
+    CHECK_EQ(ds_add(&s, T0 + 9 * DAY, 8 * DAY, 12.0f * 8 * DAY / 1000.0f), DS_ACCEPTED);
+    CHECK_NEAR(s.ppm, (1 * 10.0f + 64 * 12.0f) / 65, 1e-3);
+    CHECK(s.sigma > 0.1f);
+
+    // The trim is taken out of each sample
+    ds_init(&s, 30);
+    s.trim = -3;
+    CHECK_EQ(ds_add(&s, T0, DAY, (20.0f - 3 * DS_TRIM_PPM) * DAY / 1000.0f), DS_ACCEPTED);
+    CHECK_NEAR(s.samples[0].ppm, 20.0f, 1e-3);
+
+    ds_init(&s, 30);
+    for (int n = 0; n < DS_MAX_SAMPLES + 4; n++) {
+        ds_add(&s, T0 + n * (int64_t)DAY, DAY, (5.0f + s.trim * DS_TRIM_PPM) * DAY / 1000.0f);
+    }
+    CHECK_EQ(s.count, DS_MAX_SAMPLES);
+    CHECK_EQ(s.samples[0].time, T0 + 4LL * DAY);
+    CHECK_EQ(s.samples[DS_MAX_SAMPLES - 1].time, T0 + (DS_MAX_SAMPLES + 3LL) * DAY);
+    CHECK_NEAR(s.ppm, 5.0f, 1e-3);
+}
+
+int main(void)
+{
+    TEST_RUN(converges);
+    TEST_RUN(invalid);
+    TEST_RUN(outliers);
+    TEST_RUN(weights_and_window);
+    return test_done();
+}
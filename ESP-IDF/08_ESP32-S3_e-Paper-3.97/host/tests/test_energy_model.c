@@ -0,0 +1,256 @@
+#include "energy_model.h"
+#include "test.h"
+
+/*
+ * The energy model of components/energy_prof on synthetic voltage traces
+ * whose charge and energy are worked out by hand: a steady draw, a sag
+ * stepping in, a sag growing linearly (which the trapezoid integrates
+ * exactly), the boot before sampling, and a voltage above the reference.
+ * Then the running means of ep_stats_add() and the battery life that
+ * ep_estimate_days() gives for mode loads with known per-operation means.
+ */
+
+#define R_MOHM      100         // 1 mV of sag is 10 mA
+#define UC_PER_UAH  3600.0
+
+static void begin(ep_integrator_t *it, uint16_t ref_mv, uint16_t base_ma)
+{
+    ep_int_begin(it, 0, (int32_t)ref_mv << 4, base_ma, R_MOHM);
+}
+
+// One sample of mv every step_ms, up to ms
+static void hold(ep_integrator_t *it, int ms, int step_ms, uint16_t mv)
+{
+    for (int64_t t = it->last_us + step_ms * 1000; t <= ms * 1000LL; t += step_ms * 1000)
+        ep_int_add(it, t, mv);
+}
+
+// 20 mA at 3.9 V for a second: 20000 uA*s, 78 mJ
+static void steady(void)
+{
+    ep_integrator_t it;
+    ep_result_t res;
+
+    begin(&it, 3900, 20);
+    hold(&it, 1000, 10, 3900);
+    ep_int_result(&it, &res);
+    CHECK_EQ(res.samples, 100);
+    CHECK_EQ(res.duration_ms, 1000);
+    CHECK_NEAR(res.charge_uc, 20000.0, 0.5);
+    CHECK_NEAR(res.charge_uc / UC_PER_UAH, 5.556, 0.001);
+    CHECK_NEAR(res.energy_mj, 78.0, 0.01);
+    CHECK_EQ(ep_int_current_ua(&it, 3900), 20000);
+}
+
+/*
+ * 10 mV below 4 V from the first sample at 10 ms: 100 mA, reached by the
+ * trapezoid of that first step. 50 mA * 10 ms + 100 mA * 990 ms = 99500 uA*s;
+ * 3.995 V * 50 mA * 10 ms + 3.99 V * 100 mA * 990 ms = 397.0075 mJ.
+ */
+static void sag_step(void)
+{
+    ep_integrator_t it;
+    ep_result_t res;
+
+    begin(&it, 4000, 0);
+    CHECK_EQ(ep_int_current_ua(&it, 3990), 100000);
+    hold(&it, 1000, 10, 3990);
+    ep_int_result(&it, &res);
+    CHECK_NEAR(res.charge_uc, 99500.0, 0.5);
+    CHECK_NEAR(res.energy_mj, 397.0075, 0.01);
+}
+
+// The sag grows by 1 mV every 50 ms to 20 mV at 1 s: 0 to 200 mA, 100000 uA*s
+static void sag_ramp(void)
+{
+    ep_integrator_t it;
+    ep_result_t res;
+
+    begin(&it, 4000, 0);
+    for (int k = 1; k <= 20; k++) ep_int_add(&it, k * 50000LL, (uint16_t)(4000 - k));
+    ep_int_result(&it, &res);
+    CHECK_EQ(res.samples, 20);
+    CHECK_NEAR(res.charge_uc, 100000.0, 0.5);
+}
+
+// The boot at the base current before the first sample: 500 ms of 20 mA more
+static void preroll(void)
+{
+    ep_integrator_t it;
+    ep_result_t res;
+
+    begin(&it, 3900, 20);
+    ep_int_preroll(&it, 500000);
+    ep_int_preroll(&it, -1);
+    hold(&it, 1000, 10, 3900);
+    ep_int_result(&it, &res);
+    CHECK_EQ(res.duration_ms, 1500);
+    CHECK_NEAR(res.charge_uc, 30000.0, 0.5);
+    CHECK_NEAR(res.energy_mj, 117.0, 0.01);
+}
+
+// Samples out of order, at the same time or without a battery change nothing
+static void ignored_samples(void)
+{
+    ep_integrator_t it;
+    ep_result_t res;
+
+    begin(&it, 3900, 20);
+    hold(&it, 1000, 10, 3900);
+    ep_int_add(&it, 500000, 3000);
+    ep_int_add(&it, 1000000, 3000);
+    ep_int_add(&it, 1010000, 0);
+    ep_int_result(&it, &res);
+    CHECK_EQ(res.samples, 100);
+    CHECK_NEAR(res.charge_uc, 20000.0, 0.5);
+}
+
+// Above the reference the model gives a negative current, the totals stop at 0
+static void above_reference(void)
+{
+    ep_integrator_t it;
+    ep_result_t res;
+
+    begin(&it, 4000, 0);
+    hold(&it, 1000, 10, 4010);
+    ep_int_result(&it, &res);
+    CHECK_EQ(res.charge_uc, 0);
+    CHECK_EQ(res.energy_mj, 0);
+
+    // A charger shows as a rise of more than the margin
+    CHECK(!ep_int_charging(&it, 4040, 40));
+    CHECK(ep_int_charging(&it, 4041, 40));
+    CHECK(!ep_int_charging(&it, 3900, 40));
+}
+
+static ep_result_t result(float charge_uc, uint32_t duration_ms)
+{
+    ep_result_t res = {duration_ms, 10, charge_uc, charge_uc / 250.0f};
+    return res;
+}
+
+// A plain mean of the first EP_STATS_WINDOW operations, then each weighs 1/EP_STATS_WINDOW
+static void running_means(void)
+{
+    ep_stats_t st = {0};
+
+    for (int i = 1; i <= EP_STATS_WINDOW; i++) {
+        ep_result_t res = result((float)i, (uint32_t)(i * 10));
+        ep_stats_add(&st, &res);
+    }
+    CHECK_EQ(st.count, EP_STATS_WINDOW);
+    CHECK_NEAR(st.charge_uc, (EP_STATS_WINDOW + 1) / 2.0, 1e-4);
+    CHECK_NEAR(st.duration_ms, (EP_STATS_WINDOW + 1) * 5.0, 1e-3);
+    CHECK_NEAR(st.max_charge_uc, EP_STATS_WINDOW, 1e-6);
+
+    ep_result_t big = result(16.5f + 32.0f * 10.0f, 330);
+    ep_stats_add(&st, &big);
+    CHECK_EQ(st.count, EP_STATS_WINDOW + 1);
+    CHECK_NEAR(st.charge_uc, 26.5, 1e-4);
+    CHECK_NEAR(st.max_charge_uc, 336.5, 1e-4);
+
+    // A small one lowers the mean but not the maximum
+    ep_result_t small = result(0.0f, 0);
+    ep_stats_add(&st, &small);
+    CHECK_NEAR(st.charge_uc, 26.5 * 31.0 / 32.0, 1e-4);
+    CHECK_NEAR(st.max_charge_uc, 336.5, 1e-4);
+}
+
+/*
+ * Clock mode, synced every 7 days, 10 uA while off:
+ *   1392 partial wake-ups of 1 uAh and 2 s
+ *   48 - 1/7 full ones of 10 uAh and 5 s
+ *   1/7 syncs of 100 uAh and 10 s
+ * 6785486 uA*s awake in 3024.7 s, 833753 uA*s off: 2.11646 mAh a day,
+ * 944.98 days on 2000 mAh.
+ */
+static void clock_mode_days(void)
+{
+    ep_stats_t stats[EP_OP_COUNT] = {0};
+    ep_load_t loads[EP_MODE_MAX_LOADS];
+
+    stats[EP_OP_CLOCK_WAKE] = (ep_stats_t){1, 3600.0f, 0, 2000.0f, 3600.0f};
+    stats[EP_OP_CLOCK_FULL] = (ep_stats_t){1, 36000.0f, 0, 5000.0f, 36000.0f};
+    stats[EP_OP_SYNC_WAKE] = (ep_stats_t){1, 360000.0f, 0, 10000.0f, 360000.0f};
+
+    int n = ep_mode_loads(EP_MODE_CLOCK, 7, loads);
+    CHECK_EQ(n, 3);
+    float per_day = 0;
+    for (int i = 0; i < n; i++) per_day += loads[i].per_day;
+    CHECK_NEAR(per_day, 1440.0, 1e-3);
+
+    CHECK_NEAR(ep_estimate_days(stats, loads, n, 2000.0f, 10.0f), 944.976, 0.05);
+    CHECK_NEAR(1.0 / ep_estimate_days(stats, loads, n, 1.0f, 10.0f), 2.11646, 1e-4);
+
+    // A load never measured gives no estimate
+    stats[EP_OP_SYNC_WAKE].count = 0;
+    CHECK_EQ(ep_estimate_days(stats, loads, n, 2000.0f, 10.0f), -1);
+}
+
+/*
+ * Traces through the integrator into the means, then calendar mode synced
+ * every 4 days: 3/4 wake-ups of 30 mA for 3 s and 1/4 syncs of 80 mA for
+ * 10 s, 10 uA while off. 267500 uA*s awake in 4.75 s, 863952.5 off:
+ * 0.314292 mAh a day, 4772.6 days on 1500 mAh.
+ */
+static void calendar_mode_from_traces(void)
+{
+    ep_stats_t stats[EP_OP_COUNT] = {0};
+    ep_load_t loads[EP_MODE_MAX_LOADS];
+    ep_integrator_t it;
+    ep_result_t res;
+
+    for (int i = 0; i < 5; i++) {
+        begin(&it, 3950, 30);
+        hold(&it, 3000, 10, 3950);
+        ep_int_result(&it, &res);
+        ep_stats_add(&stats[EP_OP_CALENDAR_WAKE], &res);
+
+        begin(&it, 3950, 80);
+        hold(&it, 10000, 10, 3950);
+        ep_int_result(&it, &res);
+        ep_stats_add(&stats[EP_OP_SYNC_WAKE], &res);
+    }
+    CHECK_NEAR(stats[EP_OP_CALENDAR_WAKE].charge_uc, 90000.0, 1.0);
+    CHECK_NEAR(stats[EP_OP_SYNC_WAKE].charge_uc, 800000.0, 5.0);
+
+    int n = ep_mode_loads(EP_MODE_CALENDAR, 4, loads);
+    CHECK_EQ(n, 2);
+    CHECK_NEAR(1.0 / ep_estimate_days(stats, loads, n, 1.0f, 10.0f), 0.314292, 1e-5);
+    CHECK_NEAR(ep_estimate_days(stats, loads, n, 1500.0f, 10.0f), 4772.63, 0.5);
+
+    // Weather mode needs the weather wake-up, which was never measured
+    n = ep_mode_loads(EP_MODE_WEATHER, 4, loads);
+    CHECK_EQ(ep_estimate_days(stats, loads, n, 1500.0f, 10.0f), -1);
+}
+
+// Awake longer than a day leaves no time off; a load out of range is refused
+static void edge_loads(void)
+{
+    ep_stats_t stats[EP_OP_COUNT] = {0};
+    stats[EP_OP_AUDIO_MINUTE] = (ep_stats_t){1, 3.6e6f, 0, 60000.0f, 3.6e6f};
+
+    // 1440 minutes of playback at 1 mAh each, the off current not counted
+    ep_load_t all_day = {EP_OP_AUDIO_MINUTE, 1440.0f};
+    CHECK_NEAR(ep_estimate_days(stats, &all_day, 1, 1440.0f, 1000.0f), 1.0, 1e-4);
+
+    ep_load_t none[2] = {{EP_OP_CLOCK_WAKE, 0.0f}, {EP_OP_COUNT, 1.0f}};
+    CHECK_NEAR(ep_estimate_days(stats, none, 1, 1000.0f, 10.0f), 1000.0 * 3.6e6 / (10.0 * 86400), 1e-2);
+    CHECK_EQ(ep_estimate_days(stats, none, 2, 1000.0f, 10.0f), -1);
+    CHECK_EQ(ep_estimate_days(stats, none, 1, 1000.0f, 0.0f), -1);
+}
+
+int main(void)
+{
+    TEST_RUN(steady);
+    TEST_RUN(sag_step);
+    TEST_RUN(sag_ramp);
+    TEST_RUN(preroll);
+    TEST_RUN(ignored_samples);
+    TEST_RUN(above_reference);
+    TEST_RUN(running_means);
+    TEST_RUN(clock_mode_days);
+    TEST_RUN(calendar_mode_from_traces);
+    TEST_RUN(edge_loads);
+    return test_done();
+}
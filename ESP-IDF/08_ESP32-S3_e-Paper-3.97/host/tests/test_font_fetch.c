@@ -0,0 +1,379 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "font.h"
+#include "fonts.h"
+#include "sdcard_bsp.h"
+#include "sim.h"
+#include "test.h"
+
+/*
+ * Glyph fetching of components/epaper_lib/Fonts/font.c from the card laid out
+ * by tools/make_sdcard.py. Font_FetchGlyphs() on whole lines must give what a
+ * plain read of each glyph from the .FON gives, the offsets worked out here
+ * from the file layouts. The pool of open font files is checked through the
+ * open and seek counts of sim_vfs.c: least recently used closed first, never
+ * more than FONT_FILE_HANDLES of the card's files held, a file cut short
+ * failing only the glyphs past the cut.
+ */
+
+#define GLYPH_MAX   (font48_size_CH)
+
+static const char *const lines[] = {
+    "Hello, world! The quick brown fox jumps over the lazy dog 0123456789.",
+    "春风又绿江南岸，明月何时照我还。山重水复疑无路，柳暗花明又一村。",
+    "ＡＢＣ１２３（全角）①②③→←★☆§№ 中中中中中中 mixed 文字 and text",
+    "\x07\xF0\x9F\x98\x80\xCC\x81~",      // A control, an emoji and a combining mark have no glyph
+};
+
+typedef struct {
+    uint32_t cp[256];
+    int n;
+} cps_t;
+
+static void decode(const char *s, cps_t *out)
+{
+    out->n = 0;
+    while (*s && out->n < 256) {
+        int len = 1;
+        out->cp[out->n++] = UTF8_To_Unicode(s, &len);
+        s += len > 0 ? len : 1;
+    }
+}
+
+// Where the glyph of a code point is, from the layout of the font files
+static bool locate(const cFONT *font, uint32_t cp, const char **path, long *offset, int *size)
+{
+    if (cp < 0x80) {
+        if (cp < 0x20) return false;
+        *path = font->font_name_EN;
+        *offset = (long)(cp - 0x20) * font->size_EN;
+        *size = font->size_EN;
+        return true;
+    }
+    *size = font->size_CH;
+    uint16_t gb = unicode_to_gb2312(cp);
+    unsigned hi = gb >> 8, lo = gb & 0xFF;
+    if (font->encoding == FONT_ENCODING_UTF8) {
+        if (cp >= 0x4E00 && cp <= 0x9FFF) {
+            *path = font->font_name_CH;
+            *offset = (long)(cp - 0x4E00) * font->size_CH;
+            return true;
+        }
+        if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            *path = font->font_name_CH_ASICC;
+            *offset = (long)(cp - 0xFF00) * font->size_CH;
+            return true;
+        }
+        // Symbols come from the GBK symbol file of the size
+        if (hi < 0xA1 || lo < 0xA1) return false;
+        *path = font == &Font12_UTF8 ? GBK_Font12CH_ASICC : GBK_Font24CH_ASICC;
+        *offset = (long)((hi - 0xA1) * 94 + (lo - 0xA1)) * font->size_CH;
+        return true;
+    }
+    if (lo < 0xA1 || lo > 0xFE) return false;
+    if (hi >= 0xA1 && hi <= 0xA9) {
+        *path = font->font_name_CH_ASICC;
+        *offset = (long)((hi - 0xA1) * 94 + (lo - 0xA1)) * font->size_CH;
+    } else if (hi >= 0xB0 && hi <= 0xF7) {
+        *path = font->font_name_CH;
+        *offset = (long)((hi - 0xB0) * 94 + (lo - 0xA1)) * font->size_CH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The glyph read straight from the host file, -1 if there is none
+static int plain_read(const cFONT *font, uint32_t cp, uint8_t *buf)
+{
+    const char *path;
+    long offset;
+    int size;
+    char host[SIM_PATH_MAX];
+
+    if (!locate(font, cp, &path, &offset, &size)) return -1;
+    FILE *fp = fopen(sim_map_path(path, host, sizeof(host)), "rb");
+    if (!fp) return -1;
+    bool ok = fseek(fp, offset, SEEK_SET) == 0 && fread(buf, 1, size, fp) == (size_t)size;
+    fclose(fp);
+    return ok ? size : -1;
+}
+
+// A batch fetch of the line against the plain reads and Get_Char_Font_Data
+static void check_line(cFONT *font, const char *name, const char *line)
+{
+    static uint8_t glyphs[256][GLYPH_MAX], want[GLYPH_MAX], single[GLYPH_MAX];
+    unsigned char *out[256];
+    int len[256];
+    cps_t c;
+
+    decode(line, &c);
+    for (int i = 0; i < c.n; i++) {
+        out[i] = glyphs[i];
+        memset(glyphs[i], 0xEE, GLYPH_MAX);
+    }
+    int found = Font_FetchGlyphs(font, c.cp, c.n, out, len), expected = 0;
+    for (int i = 0; i < c.n; i++) {
+        int n = plain_read(font, c.cp[i], want);
+        expected += n > 0;
+        if (len[i] != n || (n > 0 && memcmp(glyphs[i], want, n) != 0)) {
+            TEST_FAIL("%s U+%04X (%d of \"%.20s\"): %d bytes, expected %d%s", name, c.cp[i], i, line, len[i], n,
+                      len[i] == n ? ", other bytes" : "");
+            return;
+        }
+        if (n > 0 && glyphs[i][n] != 0xEE) {
+            TEST_FAIL("%s U+%04X: wrote past the glyph", name, c.cp[i]);
+            return;
+        }
+
+        // One character at a time, as the drawing code calls it
+        char enc[4] = {0};
+        if (font->encoding == FONT_ENCODING_GBK && c.cp[i] >= 0x80) {
+            uint16_t gb = unicode_to_gb2312(c.cp[i]);
+            enc[0] = (char)(gb >> 8);
+            enc[1] = (char)gb;
+        } else {
+            const char *p = line;
+            for (int k = 0; k < i; k++) p += Get_UTF8_Char_Length((unsigned char)*p);
+            memcpy(enc, p, Get_UTF8_Char_Length((unsigned char)*p));
+        }
+        int got = c.cp[i] >= 0x80 && font->encoding == FONT_ENCODING_GBK && !enc[0] ? -1
+                : Get_Char_Font_Data(font, enc, single);
+        if (got != n || (n > 0 && memcmp(single, want, n) != 0)) {
+            TEST_FAIL("%s Get_Char_Font_Data U+%04X: %d bytes, expected %d", name, c.cp[i], got, n);
+            return;
+        }
+    }
+    CHECK_EQ(found, expected);
+}
+
+static void batch_vs_single(void)
+{
+    static const struct {
+        cFONT *font;
+        const char *name;
+    } fonts[] = {
+        {&Font12_UTF8, "Font12_UTF8"},
+        {&Font24_UTF8, "Font24_UTF8"},
+        {&Font12_GBK, "Font12_GBK"},
+    };
+
+    for (size_t f = 0; f < sizeof(fonts) / sizeof(fonts[0]); f++) {
+        for (size_t l = 0; l < sizeof(lines) / sizeof(lines[0]); l++) check_line(fonts[f].font, fonts[f].name, lines[l]);
+    }
+
+    // More code points than fit the stack, and one buffer given for all of them
+    static uint8_t glyphs[200][GLYPH_MAX], want[GLYPH_MAX], shared[GLYPH_MAX];
+    unsigned char *out[200];
+    uint32_t cps[200];
+    int len[200];
+    for (int i = 0; i < 200; i++) {
+        cps[i] = i % 3 ? 0x4E00 + (uint32_t)i * 97 : 0x21 + (uint32_t)i % 90;
+        out[i] = glyphs[i];
+    }
+    CHECK(200 > FONT_BATCH_MAX);
+    CHECK_EQ(Font_FetchGlyphs(&Font12_UTF8, cps, 200, out, len), 200);
+    for (int i = 0; i < 200; i++) {
+        int n = plain_read(&Font12_UTF8, cps[i], want);
+        if (len[i] != n || memcmp(glyphs[i], want, n) != 0) {
+            TEST_FAIL("batch of 200, U+%04X differs", cps[i]);
+            break;
+        }
+    }
+    uint32_t same[5] = {0x6C5F, 0x6C5F, 0x6C5F, 0x6C5F, 0x6C5F};
+    unsigned char *one[5] = {shared, shared, shared, shared, shared};
+    CHECK_EQ(Font_FetchGlyphs(&Font12_UTF8, same, 5, one, len), 5);
+    plain_read(&Font12_UTF8, 0x6C5F, want);
+    CHECK_MEM(shared, want, font12_size_CH);
+
+    // Nothing to fetch
+    CHECK_EQ(Font_FetchGlyphs(&Font12_UTF8, cps, 0, out, len), 0);
+    CHECK_EQ(Font_FetchGlyphs(NULL, cps, 1, out, len), 0);
+    uint32_t none[2] = {0x1F600, 0x10};
+    CHECK_EQ(Font_FetchGlyphs(&Font12_UTF8, none, 2, out, len), 0);
+    CHECK_EQ(len[0], -1);
+    CHECK_EQ(len[1], -1);
+}
+
+// Files opened by fetching a glyph of one file of the pool
+static uint32_t opens_for(cFONT *font, uint32_t cp)
+{
+    static uint8_t buf[GLYPH_MAX];
+    unsigned char *out = buf;
+    sim_io_stats_t before, after;
+    int len;
+
+    sim_io_get(&before);
+    if (Font_FetchGlyphs(font, &cp, 1, &out, &len) != 1) TEST_FAIL("U+%04X not fetched", cp);
+    sim_io_get(&after);
+    return after.opens - before.opens;
+}
+
+static void handle_pool(void)
+{
+    // Four files for three handles
+    enum { EN, CH, CH_ASICC, EN16 };
+    static cFONT *const font[] = {&Font12_UTF8, &Font12_UTF8, &Font12_UTF8, &Font16_UTF8};
+    static const uint32_t cp[] = {'A', 0x4E2D, 0xFF21, 'A'};
+    static const struct {
+        int file;
+        uint32_t opens;
+    } steps[] = {
+        {EN, 1}, {CH, 1}, {CH_ASICC, 1},    // Fill the pool
+        {EN, 0}, {CH, 0}, {EN, 0},          // Hits, CH_ASICC is now the oldest
+        {EN16, 1},                          // Closes CH_ASICC
+        {EN, 0}, {CH, 0}, {EN16, 0},
+        {CH_ASICC, 1},                      // Closes EN
+        {CH, 0}, {EN16, 0}, {CH_ASICC, 0},
+        {EN, 1},                            // Closes CH
+        {CH, 1},
+    };
+    CHECK(FONT_FILE_HANDLES == 3);
+    Font_CloseFiles();
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        uint32_t n = opens_for(font[steps[i].file], cp[steps[i].file]);
+        if (n != steps[i].opens) TEST_FAIL("step %zu: %u opens, expected %u", i, n, steps[i].opens);
+        test_checks++;
+    }
+
+    // The pool holds three of the card's five handles, and gives them back
+    FILE *other[3];
+    for (int i = 0; i < 3; i++) other[i] = fopen("/sdcard/font/ASICC/font48EN.FON", "rb");
+    CHECK(other[0] && other[1]);
+    CHECK(!other[2]);
+    for (int i = 0; i < 3; i++) {
+        if (other[i]) fclose(other[i]);
+    }
+    Font_CloseFiles();
+    for (int i = 0; i < 3; i++) other[i] = fopen("/sdcard/font/ASICC/font48EN.FON", "rb");
+    CHECK(other[0] && other[1] && other[2]);
+    for (int i = 0; i < 3; i++) {
+        if (other[i]) fclose(other[i]);
+    }
+    CHECK_EQ(opens_for(&Font12_UTF8, 'A'), 1);
+}
+
+// The card I/O of a batch fetched with the pool empty
+static sim_io_stats_t fetch_io(cFONT *font, const uint32_t *cps, int n, unsigned char *const *out, int *len)
+{
+    sim_io_stats_t a, b;
+
+    Font_CloseFiles();
+    sim_io_get(&a);
+    if (Font_FetchGlyphs(font, cps, n, out, len) != n) TEST_FAIL("%d glyphs, not all fetched", n);
+    sim_io_get(&b);
+    b.opens -= a.opens;
+    b.reads -= a.reads;
+    b.read_bytes -= a.read_bytes;
+    b.seeks -= a.seeks;
+    return b;
+}
+
+// Merged reads: one seek for a run of nearby glyphs, a repeated glyph read once
+static void merged_reads(void)
+{
+    static uint8_t glyphs[64][GLYPH_MAX];
+    unsigned char *out[64];
+    uint32_t cps[64];
+    int len[64];
+    sim_io_stats_t batch, single;
+
+    for (int i = 0; i < 64; i++) out[i] = glyphs[i];
+
+    // The alphabet backwards, sorted into one read, against a character at a time
+    for (int i = 0; i < 26; i++) cps[i] = 'z' - i;
+    batch = fetch_io(&Font12_UTF8, cps, 26, out, len);
+    memset(&single, 0, sizeof(single));
+    for (int i = 0; i < 26; i++) {
+        sim_io_stats_t one = fetch_io(&Font12_UTF8, &cps[i], 1, out, len);
+        single.opens += one.opens;
+        single.reads += one.reads;
+        single.seeks += one.seeks;
+    }
+    CHECK_EQ(batch.opens, 1);
+    CHECK(batch.seeks <= 1);
+    CHECK(batch.reads <= 2);
+    CHECK_EQ(single.opens, 26);
+    CHECK(single.seeks >= 25);
+    CHECK(single.reads >= 26);
+
+    // Forty times one character costs what it costs once
+    for (int i = 0; i < 40; i++) cps[i] = 0x6C5F;
+    batch = fetch_io(&Font24_UTF8, cps, 40, out, len);
+    single = fetch_io(&Font24_UTF8, cps, 1, out, len);
+    CHECK_EQ(batch.reads, single.reads);
+    CHECK_EQ(batch.read_bytes, single.read_bytes);
+    CHECK_EQ(batch.seeks, single.seeks);
+    for (int i = 1; i < 40; i++) CHECK_MEM(glyphs[i], glyphs[0], font24_size_CH);
+}
+
+// A font file cut short fails the glyphs past the cut and nothing else
+static void truncated_file(void)
+{
+    static uint8_t glyphs[8][GLYPH_MAX], want[GLYPH_MAX];
+    char dir[] = "/tmp/test_font_fetchXXXXXX", path[SIM_PATH_MAX], cmd[3 * SIM_PATH_MAX];
+    char src[SIM_PATH_MAX];
+    const char *card = sim_config.sd_dir;
+    unsigned char *out[8];
+    int len[8];
+
+    if (!mkdtemp(dir)) {
+        TEST_FAIL("mkdtemp");
+        return;
+    }
+    // The first 40 glyphs and part of the next
+    snprintf(path, sizeof(path), "%s/font/ASICC", dir);
+    sim_map_path(Font12EN, src, sizeof(src));
+    if (snprintf(cmd, sizeof(cmd), "mkdir -p %s && head -c %d %s > %s/font12EN.FON", path, 40 * font12_size_EN + 10,
+                 src, path) >= (int)sizeof(cmd)) {
+        TEST_FAIL("path too long");
+        return;
+    }
+    CHECK_EQ(system(cmd), 0);
+
+    Font_CloseFiles();
+    sim_config.sd_dir = dir;
+    uint32_t cps[8] = {'!', 'A', 'G', 'H', 'x', 'B', '~', 'A'};
+    int ok[8] = {1, 1, 1, 0, 0, 1, 0, 1};
+    for (int i = 0; i < 8; i++) out[i] = glyphs[i];
+    CHECK_EQ(Font_FetchGlyphs(&Font12_UTF8, cps, 8, out, len), 5);
+    sim_config.sd_dir = card;
+    for (int i = 0; i < 8; i++) {
+        plain_read(&Font12_UTF8, cps[i], want);
+        if (ok[i]) {
+            CHECK_EQ(len[i], font12_size_EN);
+            CHECK_MEM(glyphs[i], want, font12_size_EN);
+        } else {
+            CHECK_EQ(len[i], -1);
+        }
+    }
+
+    // The pool recovers once the file is whole again
+    Font_CloseFiles();
+    cps[0] = 'x';
+    CHECK_EQ(Font_FetchGlyphs(&Font12_UTF8, cps, 1, out, len), 1);
+    plain_read(&Font12_UTF8, 'x', want);
+    CHECK_MEM(glyphs[0], want, font12_size_EN);
+
+    if (test_failures == 0) {
+        snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+        if (system(cmd) != 0) fprintf(stderr, "%s left behind\n", dir);
+    }
+}
+
+int main(void)
+{
+    sim_config.sd_dir = getenv("EPAPER_TEST_SD");
+    if (!sim_config.sd_dir) {
+        fprintf(stderr, "EPAPER_TEST_SD: directory laid out by tools/make_sdcard.py\n");
+        return 2;
+    }
+    _sdcard_init();
+
+    TEST_RUN(batch_vs_single);
+    TEST_RUN(handle_pool);
+    TEST_RUN(merged_reads);
+    TEST_RUN(truncated_file);
+    Font_CloseFiles();
+    return test_done();
+}
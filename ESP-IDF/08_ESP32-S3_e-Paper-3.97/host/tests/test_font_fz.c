@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <time.h>
+#include "font_fz.h"
+#include "test.h"
+
+/*
+ * The compressed font container of components/epaper_lib: fonts packed at
+ * build time by tools/font_pack.py (see CMakeLists.txt) are decoded block by
+ * block with font_fz.c and every glyph compared with the .FON it was packed
+ * from. Damaged containers must be refused or fail to decode without writing
+ * past the block. The decode benchmark prints its figures and checks nothing.
+ */
+
+#define CANARY          0xA5
+#define CANARY_LEN      64
+#define BENCH_ROUNDS    20
+
+static volatile unsigned bench_sink;     // Keeps the timed loops
+
+typedef struct {
+    const char *font;           // Under FONT_DIR
+    const char *packed;         // Under FONT_FZ_DIR
+    int width, height;
+    int block_glyphs;
+} packed_font_t;
+
+// As packed by CMakeLists.txt, the geometry is font_pack.py's
+static const packed_font_t fonts[] = {
+    {"Font12/font12EN.FON", "font12EN.FON", 8, 21, 64},
+    {"Font16/font16EN.FON", "font16EN_b1.FON", 16, 28, 1},
+    {"Font16/font16EN.FON", "font16EN_b7.FON", 16, 28, 7},
+    {"Font24/UTF_font24CH_ASICC.FON", "UTF_font24CH_ASICC.FON", 32, 41, 64},
+    {"Font16/GBK_font16CH.FON", "GBK_font16CH.FON", 24, 28, 64},
+    {"ASCII/font182EN.FON", "font182EN.FON", 120, 182, 64},
+};
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} blob_t;
+
+static blob_t read_file(const char *dir, const char *name)
+{
+    char path[512];
+    blob_t b = {NULL, 0};
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        TEST_FAIL("cannot open %s", path);
+        return b;
+    }
+    fseek(fp, 0, SEEK_END);
+    b.size = (size_t)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    b.data = malloc(b.size ? b.size : 1);
+    if (fread(b.data, 1, b.size, fp) != b.size) {
+        TEST_FAIL("short read of %s", path);
+        b.size = 0;
+    }
+    fclose(fp);
+    return b;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// A block buffer with a canary behind it
+static uint8_t *block_buffer(const font_fz_t *fz)
+{
+    size_t len = (size_t)fz->block_glyphs * fz->glyph_size;
+    uint8_t *buf = malloc(len + CANARY_LEN);
+    memset(buf + len, CANARY, CANARY_LEN);
+    return buf;
+}
+
+static bool canary_intact(const font_fz_t *fz, const uint8_t *buf)
+{
+    const uint8_t *p = buf + (size_t)fz->block_glyphs * fz->glyph_size;
+    for (int i = 0; i < CANARY_LEN; i++) {
+        if (p[i] != CANARY) return false;
+    }
+    return true;
+}
+
+// Every glyph of every packed font equals the uncompressed one
+static void round_trip(void)
+{
+    for (size_t f = 0; f < sizeof(fonts) / sizeof(fonts[0]); f++) {
+        const packed_font_t *pf = &fonts[f];
+        test_case = pf->packed;
+        blob_t raw = read_file(FONT_DIR, pf->font);
+        blob_t packed = read_file(FONT_FZ_DIR, pf->packed);
+        font_fz_t fz;
+
+        // The plain font is not a container
+        CHECK(!font_fz_open(&fz, raw.data, raw.size));
+        CHECK(font_fz_open(&fz, packed.data, packed.size));
+        if (!raw.size || !font_fz_open(&fz, packed.data, packed.size)) goto next;
+
+        int row_bytes = (pf->width + 7) / 8;
+        CHECK_EQ(fz.row_bytes, row_bytes);
+        CHECK_EQ(fz.glyph_size, row_bytes * pf->height);
+        CHECK_EQ(fz.block_glyphs, pf->block_glyphs);
+        CHECK_EQ(fz.glyph_count, raw.size / fz.glyph_size);
+        CHECK_EQ(fz.block_count, (fz.glyph_count + fz.block_glyphs - 1) / fz.block_glyphs);
+        CHECK(packed.size < raw.size || pf->block_glyphs == 1);
+
+        uint8_t *buf = block_buffer(&fz);
+        uint32_t glyphs = 0;
+        for (uint32_t b = 0; b < fz.block_count; b++) {
+            uint16_t n = font_fz_block_glyphs(&fz, b);
+            int len = font_fz_decode_block(&fz, b, buf);
+            if (len != n * fz.glyph_size) {
+                TEST_FAIL("block %u: %d bytes, expected %d", b, len, n * fz.glyph_size);
+                break;
+            }
+            for (uint16_t g = 0; g < n; g++, glyphs++) {
+                const uint8_t *want = raw.data + (size_t)glyphs * fz.glyph_size;
+                if (memcmp(buf + (size_t)g * fz.glyph_size, want, fz.glyph_size) != 0) {
+                    TEST_FAIL("glyph %u (block %u) differs", glyphs, b);
+                    goto done;
+                }
+            }
+        }
+done:
+        CHECK_EQ(glyphs, fz.glyph_count);
+        CHECK(canary_intact(&fz, buf));
+        CHECK_EQ(font_fz_block_glyphs(&fz, fz.block_count), 0);
+        CHECK_EQ(font_fz_decode_block(&fz, fz.block_count, buf), -1);
+        free(buf);
+next:
+        free(raw.data);
+        free(packed.data);
+    }
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Containers cut short, with a bad header or offsets, or garbage for data
+static void damaged(void)
+{
+    blob_t good = read_file(FONT_FZ_DIR, "font16EN_b7.FON");
+    // Room behind the container for a block it must not reach
+    uint8_t *blob = malloc(good.size * 2);
+    font_fz_t fz;
+    if (!good.size) goto out;
+
+    memcpy(blob, good.data, good.size);
+    CHECK(font_fz_open(&fz, blob, good.size));
+    uint32_t blocks = fz.block_count;
+    uint8_t *offsets = blob + FONT_FZ_HEADER_SIZE;
+    size_t data_at = FONT_FZ_HEADER_SIZE + (blocks + 1) * 4;
+
+    // Cut anywhere: the header, the offset table or the data
+    CHECK(!font_fz_open(&fz, blob, 0));
+    CHECK(!font_fz_open(&fz, blob, FONT_FZ_HEADER_SIZE - 1));
+    CHECK(!font_fz_open(&fz, blob, FONT_FZ_HEADER_SIZE + 4));
+    CHECK(!font_fz_open(&fz, blob, good.size - 1));
+
+    // Another magic, or a zero glyph size, row size or block size
+    static const int fields[] = {0, 4, 6, 8};
+    for (int i = 0; i < 4; i++) {
+        memcpy(blob, good.data, good.size);
+        memset(blob + fields[i], 0, 2);
+        CHECK(!font_fz_open(&fz, blob, good.size));
+    }
+
+    // More blocks than the offset table the blob has room for
+    memcpy(blob, good.data, good.size);
+    put32(blob + 16, 0x40000000);
+    CHECK(!font_fz_open(&fz, blob, good.size));
+
+    uint8_t *buf;
+    // Offsets out of order or past the end of the data fail the block alone
+    memcpy(blob, good.data, good.size);
+    put32(offsets + 2 * 4, get32(offsets + 3 * 4) + 1);
+    CHECK(font_fz_open(&fz, blob, good.size));
+    buf = block_buffer(&fz);
+    CHECK_EQ(font_fz_decode_block(&fz, 2, buf), -1);
+    CHECK_EQ(font_fz_decode_block(&fz, 3, buf), font_fz_block_glyphs(&fz, 3) * fz.glyph_size);
+    uint32_t end = get32(offsets + blocks * 4);
+    uint32_t len3 = get32(offsets + 4 * 4) - get32(offsets + 3 * 4);
+    memcpy(blob + data_at + end, blob + data_at + get32(offsets + 3 * 4), len3);
+    put32(offsets + 2 * 4, end);
+    put32(offsets + 3 * 4, end + len3);
+    CHECK_EQ(font_fz_decode_block(&fz, 2, buf), -1);
+
+    // A block whose data ends early
+    memcpy(blob, good.data, good.size);
+    put32(offsets + 5 * 4, get32(offsets + 4 * 4) + 1);
+    CHECK_EQ(font_fz_decode_block(&fz, 4, buf), -1);
+    CHECK(canary_intact(&fz, buf));
+
+    // Garbage for data decodes or fails, but stays in the block
+    uint32_t state = 1;
+    for (int round = 0; round < 200; round++) {
+        memcpy(blob, good.data, good.size);
+        for (size_t i = data_at; i < good.size; i++) {
+            state = state * 1103515245u + 12345u;
+            // Mostly zero masks with long runs on some rounds, anything on others
+            blob[i] = (round & 1) ? (uint8_t)(state >> 16) : (uint8_t)((state >> 16) & 0x81);
+        }
+        for (uint32_t b = 0; b < blocks; b++) {
+            int len = font_fz_decode_block(&fz, b, buf);
+            if (len != -1 && len != font_fz_block_glyphs(&fz, b) * fz.glyph_size) {
+                TEST_FAIL("round %d, block %u: %d bytes", round, b, len);
+                goto garbage_done;
+            }
+            if (!canary_intact(&fz, buf)) {
+                TEST_FAIL("round %d, block %u: wrote past the block", round, b);
+                goto garbage_done;
+            }
+        }
+    }
+    test_checks++;
+garbage_done:
+    free(buf);
+out:
+    free(blob);
+    free(good.data);
+}
+
+// Decode time per glyph against a plain copy of the same bytes; reported only
+static void bench(void)
+{
+    static const char *const names[] = {"GBK_font16CH.FON", "font182EN.FON"};
+
+    for (int i = 0; i < 2; i++) {
+        blob_t packed = read_file(FONT_FZ_DIR, names[i]);
+        font_fz_t fz;
+        if (!packed.size || !font_fz_open(&fz, packed.data, packed.size)) {
+            CHECK(packed.size && font_fz_open(&fz, packed.data, packed.size));
+            free(packed.data);
+            continue;
+        }
+        uint8_t *buf = block_buffer(&fz);
+        uint8_t *copy = block_buffer(&fz);
+        size_t block_len = (size_t)fz.block_glyphs * fz.glyph_size;
+        unsigned sum = 0;
+
+        double t0 = now_us();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            for (uint32_t b = 0; b < fz.block_count; b++) sum += (unsigned)font_fz_decode_block(&fz, b, buf);
+        }
+        double t1 = now_us();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            for (uint32_t b = 0; b < fz.block_count; b++) {
+                memcpy(copy, buf, block_len);
+                sum += copy[b % block_len];
+            }
+        }
+        double t2 = now_us();
+
+        double glyphs = (double)fz.glyph_count * BENCH_ROUNDS;
+        double blocks = (double)fz.block_count * BENCH_ROUNDS;
+        printf("%-18s %6.1f%% of raw, decode %7.2f us/block %6.3f us/glyph, memcpy %6.3f us/block\n",
+               names[i], 100.0 * packed.size / ((double)fz.glyph_count * fz.glyph_size),
+               (t1 - t0) / blocks, (t1 - t0) / glyphs, (t2 - t1) / blocks);
+        bench_sink = sum;
+        free(copy);
+        free(buf);
+        free(packed.data);
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(round_trip);
+    TEST_RUN(damaged);
+    TEST_RUN(bench);
+    return test_done();
+}
@@ -0,0 +1,319 @@
+#include <stdlib.h>
+#include "GUI_Paint.h"
+#include "font.h"
+#include "sdcard_bsp.h"
+#include "sim.h"
+#include "test.h"
+
+/*
+ * Proportional English metrics of components/epaper_lib/Fonts/font_metrics.c
+ * at every size, against the ink of the .FON cells on the card laid out by
+ * tools/make_sdcard.py: the ink of a glyph stays within its advance, digits
+ * share one advance, and kerned pairs never make ink touch. Font_Kerning must
+ * find what a scan of the table finds, Font_TextWidth must add up the
+ * advances, and Paint_DrawString_CN must draw a line as the union of its
+ * glyphs drawn alone at the pen positions the metrics give, within the width
+ * Font_TextWidth measured. The host sdkconfig leaves CONFIG_FONT_PROPORTIONAL
+ * unset, so the fonts here are copies with the metrics put in.
+ */
+
+#define CANVAS_W    800
+#define CANVAS_H    100
+#define AT_X        7
+#define AT_Y        5
+#define CELL_MAX    (font48_Width_EN * font48_Height / 8)
+
+typedef struct {
+    const char *name;
+    cFONT *font;
+    const FONT_METRICS *metrics;
+} size_entry_t;
+
+static const size_entry_t sizes[] = {
+    {"12", &Font12_UTF8, &Font12_Metrics},
+    {"16", &Font16_UTF8, &Font16_Metrics},
+    {"18", &Font18_UTF8, &Font18_Metrics},
+    {"24", &Font24_UTF8, &Font24_Metrics},
+    {"28", &Font28_UTF8, &Font28_Metrics},
+    {"36", &Font36_UTF8, &Font36_Metrics},
+    {"48", &Font48_UTF8, &Font48_Metrics},
+};
+#define N_SIZES     (sizeof(sizes) / sizeof(sizes[0]))
+
+static uint8_t canvas[CANVAS_W * CANVAS_H / 8];
+
+// The size's font with its metrics
+static cFONT prop_font(const size_entry_t *s)
+{
+    cFONT f = *s->font;
+    f.metrics_EN = s->metrics;
+    return f;
+}
+
+// Ink columns of each row of the cell of c, -1 for a row without ink
+typedef struct {
+    int left[font48_Height], right[font48_Height];     // right is one past the ink
+    int min, max;                                       // Over all rows, min > max when blank
+} ink_t;
+
+static bool read_ink(const cFONT *font, uint32_t c, ink_t *ink)
+{
+    uint8_t cell[CELL_MAX];
+    unsigned char *out = cell;
+    int len;
+
+    if (Font_FetchGlyphs((cFONT *)font, &c, 1, &out, &len) != 1) return false;
+    int row_bytes = (font->Width_EN + 7) / 8;
+    ink->min = font->Width_EN;
+    ink->max = -1;
+    for (int r = 0; r < font->Height; r++) {
+        ink->left[r] = -1;
+        ink->right[r] = -1;
+        for (int x = 0; x < font->Width_EN; x++) {
+            if ((cell[r * row_bytes + x / 8] >> (7 - x % 8)) & 1) continue;     // Paper
+            if (ink->left[r] < 0) ink->left[r] = x;
+            ink->right[r] = x + 1;
+        }
+        if (ink->left[r] >= 0) {
+            if (ink->left[r] < ink->min) ink->min = ink->left[r];
+            if (ink->right[r] - 1 > ink->max) ink->max = ink->right[r] - 1;
+        }
+    }
+    return true;
+}
+
+// Ink in [pen, pen + advance), digits tabular, narrow letters narrower than the cell
+static void ink_in_advance(void)
+{
+    for (size_t s = 0; s < N_SIZES; s++) {
+        cFONT f = prop_font(&sizes[s]);
+        ink_t ink;
+        test_case = sizes[s].name;
+        for (uint32_t c = 0x21; c <= 0x7E; c++) {
+            int adv = Font_Advance(&f, c), bear = Font_Bearing(&f, c);
+            if (!read_ink(&f, c, &ink)) {
+                TEST_FAIL("no glyph for '%c'", c);
+                break;
+            }
+            if (adv <= 0 || adv > 255 || (ink.min <= ink.max && (bear + ink.min < 0 || bear + ink.max >= adv))) {
+                TEST_FAIL("'%c': ink %d..%d, bearing %d, advance %d", c, ink.min, ink.max, bear, adv);
+                break;
+            }
+            test_checks++;
+        }
+        for (uint32_t d = '1'; d <= '9'; d++) CHECK_EQ(Font_Advance(&f, d), Font_Advance(&f, '0'));
+        CHECK(Font_Advance(&f, 'i') < Font_Advance(&f, 'm'));
+        CHECK(Font_Advance(&f, ' ') > 0 && Font_Advance(&f, ' ') < f.Width_EN);
+
+        // Outside the table: the cell width, or the CJK width
+        CHECK_EQ(Font_Advance(&f, 0x1F), f.Width_EN);
+        CHECK_EQ(Font_Advance(&f, 0x7F), f.Width_EN);
+        CHECK_EQ(Font_Advance(&f, 0x4E2D), f.Width_CH);
+        CHECK_EQ(Font_Bearing(&f, 0x4E2D), 0);
+        CHECK_EQ(Font_Advance(sizes[s].font, 'i'), f.Width_EN);     // No metrics on the host
+        CHECK_EQ(Font_Bearing(sizes[s].font, 'i'), 0);
+    }
+}
+
+// Font_Kerning against a scan, and kerned pairs keep their ink apart
+static void kerning(void)
+{
+    for (size_t s = 0; s < N_SIZES; s++) {
+        cFONT f = prop_font(&sizes[s]);
+        const FONT_METRICS *m = sizes[s].metrics;
+        test_case = sizes[s].name;
+
+        CHECK(m->kern_count > 0);
+        for (int i = 1; i < m->kern_count; i++) {
+            if ((m->kern[i - 1].left << 8 | m->kern[i - 1].right) >= (m->kern[i].left << 8 | m->kern[i].right)) {
+                TEST_FAIL("pair %d ('%c%c') out of order", i, m->kern[i].left, m->kern[i].right);
+                break;
+            }
+        }
+        for (uint32_t l = 0; l < 0x90; l++) {
+            for (uint32_t r = 0; r < 0x90; r++) {
+                int want = 0;
+                for (int i = 0; i < m->kern_count; i++) {
+                    if (m->kern[i].left == l && m->kern[i].right == r) want = m->kern[i].adjust;
+                }
+                if (Font_Kerning(&f, l, r) != want) {
+                    TEST_FAIL("0x%02X 0x%02X: %d, expected %d", l, r, Font_Kerning(&f, l, r), want);
+                    goto scanned;
+                }
+            }
+        }
+        test_checks++;
+scanned:
+        CHECK_EQ(Font_Kerning(sizes[s].font, m->kern[0].left, m->kern[0].right), 0);
+
+        // On every row the left glyph's ink ends before the right one's starts
+        for (int i = 0; i < m->kern_count; i++) {
+            const FONT_KERN *k = &m->kern[i];
+            ink_t a, b;
+            if (k->adjust >= 0 || !read_ink(&f, k->left, &a) || !read_ink(&f, k->right, &b)) {
+                TEST_FAIL("'%c%c': adjust %d", k->left, k->right, k->adjust);
+                break;
+            }
+            int shift = Font_Advance(&f, k->left) + k->adjust + Font_Bearing(&f, k->right) - Font_Bearing(&f, k->left);
+            for (int r = 0; r < f.Height; r++) {
+                if (a.right[r] >= 0 && b.left[r] >= 0 && a.right[r] > b.left[r] + shift) {
+                    TEST_FAIL("'%c%c' adjust %d: the ink touches on row %d", k->left, k->right, k->adjust, r);
+                    goto pairs_done;
+                }
+            }
+            test_checks++;
+        }
+pairs_done:;
+    }
+}
+
+static void text_width(void)
+{
+    cFONT f = prop_font(&sizes[0]), gbk = Font12_GBK;
+    gbk.metrics_EN = &Font12_Metrics;
+    test_case = "12";
+
+    int want = Font_Advance(&f, 'A') + Font_Kerning(&f, 'A', 'V') + Font_Advance(&f, 'V') +
+               Font_Kerning(&f, 'V', 'A') + Font_Advance(&f, 'A') + Font_Kerning(&f, 'A', 'T') + Font_Advance(&f, 'T');
+    CHECK_EQ(Font_TextWidth(&f, "AVAT"), want);
+    CHECK(Font_TextWidth(&f, "il.,") < 4 * f.Width_EN);
+    CHECK_EQ(Font_TextWidth(&f, ""), 0);
+
+    // CJK keeps its cell and breaks the kerning of its neighbours
+    want = Font_Advance(&f, 'T') + 2 * f.Width_CH + Font_Advance(&f, 'o');
+    CHECK_EQ(Font_TextWidth(&f, "T\xE4\xB8\xAD\xE6\x96\x87o"), want);
+    CHECK_EQ(Font_TextWidth(&gbk, "T\xD6\xD0\xCE\xC4o"), want);
+
+    // A sequence cut short by the end of the string is not measured
+    CHECK_EQ(Font_TextWidth(&f, "Ti\xE4\xB8"), Font_TextWidth(&f, "Ti"));
+    CHECK_EQ(Font_TextWidth(&gbk, "Ti\xD6"), Font_TextWidth(&gbk, "Ti"));
+
+    // Without metrics every English character is a cell
+    CHECK_EQ(Font_TextWidth(&Font12_UTF8, "AVAT"), 4 * font12_Width_EN);
+    CHECK_EQ(reassignCoordinates_CH(400, "AVAT", &f), 400 - Font_TextWidth(&f, "AVAT") / 2);
+}
+
+static int pixel(const uint8_t *frame, int x, int y)
+{
+    return !((frame[y * (CANVAS_W / 8) + x / 8] >> (7 - x % 8)) & 1);
+}
+
+static void canvas_reset(void)
+{
+    Paint_NewImage(canvas, CANVAS_W, CANVAS_H, ROTATE_0, WHITE);
+    Paint_SetScale(2);
+    Paint_Clear(WHITE);
+}
+
+// A line drawn at once against its characters drawn one by one, and with
+// the colours swapped against the complement of its box
+static void drawn_line(void)
+{
+    static const char *const lines[] = {
+        "AVATAR To. Wavy \"quoted\" yj, fly 0123456789",
+        "Typeface kerning: LT Vo Ty P. r, f. y.",
+        "Mixed \xE4\xB8\xAD\xE6\x96\x87 and Latin, T\xE4\xB8\xADo",
+    };
+    static uint8_t line_ink[sizeof(canvas)], alone[sizeof(canvas)], swapped[sizeof(canvas)];
+    static const int check_sizes[] = {0, 3, 6};
+
+    for (size_t si = 0; si < sizeof(check_sizes) / sizeof(check_sizes[0]); si++) {
+        const size_entry_t *s = &sizes[check_sizes[si]];
+        cFONT f = prop_font(s);
+        test_case = s->name;
+        for (size_t l = 0; l < sizeof(lines) / sizeof(lines[0]); l++) {
+            const char *line = lines[l];
+            uint32_t han = 0x4E2D;
+            uint8_t cell[CELL_MAX];
+            unsigned char *out = cell;
+            int han_len;
+            // Not every size has its Chinese font on the card
+            if (strchr(line, '\xE4') && Font_FetchGlyphs(&f, &han, 1, &out, &han_len) != 1) continue;
+            int width = Font_TextWidth(&f, line);
+            if (AT_X + width > CANVAS_W) {
+                // Only as much as fits one row
+                char part[64];
+                int n = 0;
+                while (line[n] && n < 63) {
+                    memcpy(part, line, n + 1);
+                    part[n + 1] = 0;
+                    if (AT_X + Font_TextWidth(&f, part) > CANVAS_W) break;
+                    n++;
+                }
+                while (n > 0 && ((unsigned char)line[n] & 0xC0) == 0x80) n--;
+                memcpy(part, line, n);
+                part[n] = 0;
+                line = part;
+                width = Font_TextWidth(&f, line);
+            }
+
+            // Paper colour first, as the reader draws
+            canvas_reset();
+            Paint_DrawString_CN(AT_X, AT_Y, line, &f, WHITE, BLACK);
+            memcpy(line_ink, canvas, sizeof(canvas));
+            canvas_reset();
+            Paint_DrawString_CN(AT_X, AT_Y, line, &f, BLACK, WHITE);
+            memcpy(swapped, canvas, sizeof(canvas));
+
+            // The union of the characters alone, each at its pen and kerning
+            memset(alone, 0xFF, sizeof(alone));
+            int pen = AT_X;
+            uint32_t prev = 0;
+            for (const char *p = line; *p; ) {
+                int len;
+                uint32_t cp = UTF8_To_Unicode(p, &len);
+                char one[5] = {0};
+                memcpy(one, p, len);
+                int kern = Font_Kerning(&f, prev, cp);
+                canvas_reset();
+                Paint_DrawString_CN(pen + kern, AT_Y, one, &f, WHITE, BLACK);
+                for (size_t i = 0; i < sizeof(canvas); i++) alone[i] &= canvas[i];
+                pen += kern + Font_Advance(&f, cp);
+                prev = cp;
+                p += len;
+            }
+            CHECK_EQ(pen - AT_X, width);
+
+            int first = CANVAS_W, last = -1;
+            for (int y = 0; y < CANVAS_H; y++) {
+                for (int x = 0; x < CANVAS_W; x++) {
+                    if (pixel(line_ink, x, y) != pixel(alone, x, y)) {
+                        TEST_FAIL("\"%s\": (%d, %d) is %s drawn as a line", line, x, y,
+                                  pixel(line_ink, x, y) ? "ink" : "paper");
+                        goto next;
+                    }
+                    bool in_box = x >= AT_X && x < AT_X + width && y >= AT_Y && y < AT_Y + f.Height;
+                    if (pixel(swapped, x, y) != (in_box ? !pixel(line_ink, x, y) : 0)) {
+                        TEST_FAIL("\"%s\": (%d, %d) swapped is not the complement", line, x, y);
+                        goto next;
+                    }
+                    if (pixel(line_ink, x, y)) {
+                        if (x < first) first = x;
+                        if (x > last) last = x;
+                    }
+                }
+            }
+            CHECK(first >= AT_X);
+            CHECK(last < AT_X + width);
+            CHECK(last > AT_X + width - 2 * f.Width_EN);
+next:;
+        }
+    }
+}
+
+int main(void)
+{
+    sim_config.sd_dir = getenv("EPAPER_TEST_SD");
+    if (!sim_config.sd_dir) {
+        fprintf(stderr, "EPAPER_TEST_SD: directory laid out by tools/make_sdcard.py\n");
+        return 2;
+    }
+    _sdcard_init();
+
+    TEST_RUN(ink_in_advance);
+    TEST_RUN(kerning);
+    TEST_RUN(text_width);
+    TEST_RUN(drawn_line);
+    Font_CloseFiles();
+    return test_done();
+}
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <time.h>
+#include "fonts.h"
+#include "font.h"
+#include "gb2312_map.h"
+#include "gb2312_pairs.h"
+#include "gb2312_legacy.h"
+#include "test.h"
+
+/*
+ * The Unicode <-> GB2312 tables of components/epaper_lib/Fonts/gb2312_map.c
+ * against a linear scan of the codec's pairs, which
+ * tools/gen_gb2312_map.py --pairs writes at build time (see CMakeLists.txt).
+ * Both directions are checked for every GB2312 code and every BMP code point.
+ * The hand-written table the tables replaced (gb2312_legacy.h) must agree
+ * wherever the codec agrees with it, and is timed against the tables.
+ */
+
+#define N_PAIRS     (sizeof(gb2312_pairs) / sizeof(gb2312_pairs[0]))
+#define N_ALIASES   (sizeof(gb2312_aliases) / sizeof(gb2312_aliases[0]))
+#define N_LEGACY    (sizeof(conversion_table) / sizeof(conversion_table[0]))
+
+// Entries of the legacy table the codec agrees with; the others had the
+// wrong code, or a key that is not the UTF-8 of the character
+#define LEGACY_RIGHT    260
+
+static uint32_t scan_unicode(uint16_t gb)
+{
+    for (size_t i = 0; i < N_PAIRS; i++) {
+        if (gb2312_pairs[i][0] == gb) return gb2312_pairs[i][1];
+    }
+    return 0;
+}
+
+// The code of the character, or of the character it stands for
+static uint16_t scan_gb2312(uint32_t unicode)
+{
+    for (size_t i = 0; i < N_PAIRS; i++) {
+        if (gb2312_pairs[i][1] == unicode) return gb2312_pairs[i][0];
+    }
+    for (size_t i = 0; i < N_ALIASES; i++) {
+        if (gb2312_aliases[i][1] == unicode) return gb2312_aliases[i][0];
+    }
+    return 0;
+}
+
+// The scan fonts.c did, the key built from the bytes of the sequence
+static uint16_t legacy_scan(const char *utf8)
+{
+    const unsigned char *s = (const unsigned char *)utf8;
+    uint32_t key = 0;
+    for (size_t i = 0; i < 3 && s[i]; i++) key = (key << 8) | s[i];
+    for (size_t i = 0; i < N_LEGACY; i++) {
+        if (conversion_table[i].utf8_code == key) return conversion_table[i].gb2312_code;
+    }
+    return 0;
+}
+
+static int utf8_encode(uint32_t cp, char *out)
+{
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        out[1] = 0;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        out[2] = 0;
+        return 2;
+    }
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    out[3] = 0;
+    return 3;
+}
+
+// Every code of the 87 x 94 area, the rows without characters included
+static void every_code(void)
+{
+    CHECK_EQ(N_PAIRS, 7478);
+    for (unsigned row = GB2312_FIRST_ROW; row < GB2312_FIRST_ROW + GB2312_ROWS; row++) {
+        for (unsigned col = GB2312_FIRST_COL; col < GB2312_FIRST_COL + GB2312_COLS; col++) {
+            uint16_t gb = (uint16_t)(row << 8 | col);
+            uint32_t want = scan_unicode(gb);
+            uint32_t got = gb2312_to_unicode(gb);
+            if (got != want) {
+                TEST_FAIL("0x%04X: U+%04X, expected U+%04X", gb, got, want);
+                return;
+            }
+            char bytes[3] = {(char)row, (char)col, 0};
+            if (GBK_To_Unicode(bytes) != want) {
+                TEST_FAIL("GBK_To_Unicode 0x%04X: U+%04X, expected U+%04X", gb, GBK_To_Unicode(bytes), want);
+                return;
+            }
+        }
+    }
+    test_checks++;
+
+    // ASCII passes through, codes outside the area have no character
+    CHECK_EQ(gb2312_to_unicode('A'), 'A');
+    CHECK_EQ(gb2312_to_unicode(0xA0A1), 0);
+    CHECK_EQ(gb2312_to_unicode(0xA1A0), 0);
+    CHECK_EQ(gb2312_to_unicode(0xA1FF), 0);
+    CHECK_EQ(gb2312_to_unicode(0xF8A1), 0);
+    CHECK_EQ(gb2312_to_unicode(0xFFFF), 0);
+}
+
+// Every BMP code point, straight and as UTF-8
+static void every_code_point(void)
+{
+    int mapped = 0;
+    for (uint32_t cp = 0x80; cp <= 0xFFFF; cp++) {
+        uint16_t want = scan_gb2312(cp);
+        uint16_t got = unicode_to_gb2312(cp);
+        if (got != want) {
+            TEST_FAIL("U+%04X: 0x%04X, expected 0x%04X", cp, got, want);
+            return;
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF) continue;    // Not encodable
+        char utf8[4];
+        int len = utf8_encode(cp, utf8), char_len = -1;
+        got = utf8_char_to_gb2312(utf8, &char_len);
+        if (got != want || char_len != len) {
+            TEST_FAIL("UTF-8 of U+%04X: 0x%04X, %d bytes, expected 0x%04X, %d bytes", cp, got, char_len, want, len);
+            return;
+        }
+        mapped += want != 0;
+    }
+    test_checks++;
+    CHECK_EQ(mapped, N_PAIRS + N_ALIASES);        // No two codes share a character
+
+    CHECK_EQ(unicode_to_gb2312('A'), 'A');
+    CHECK_EQ(unicode_to_gb2312(0x10000), 0);
+    CHECK_EQ(unicode_to_gb2312(0x1F600), 0);
+}
+
+// A code's character maps back to the code
+static void round_trip(void)
+{
+    for (size_t i = 0; i < N_PAIRS; i++) {
+        uint16_t gb = gb2312_pairs[i][0];
+        uint16_t back = unicode_to_gb2312(gb2312_to_unicode(gb));
+        if (back != gb) {
+            TEST_FAIL("0x%04X -> U+%04X -> 0x%04X", gb, gb2312_to_unicode(gb), back);
+            return;
+        }
+    }
+    test_checks++;
+}
+
+// Code point of a legacy key, 0 if the key is not well-formed UTF-8
+static uint32_t legacy_key_unicode(uint32_t key)
+{
+    if (key >= 0xE00000 && (key & 0xC0C0) == 0x8080)
+        return ((key >> 16) & 0x0F) << 12 | ((key >> 8) & 0x3F) << 6 | (key & 0x3F);
+    if (key >= 0xC000 && key < 0xE000 && (key & 0xC0) == 0x80)
+        return ((key >> 8) & 0x1F) << 6 | (key & 0x3F);
+    return 0;
+}
+
+// The old scan and the tables give the same code both ways where the codec
+// agrees with the old table, and the codec's code where it does not
+static void legacy_table(void)
+{
+    int right = 0;
+    for (size_t i = 0; i < N_LEGACY; i++) {
+        uint32_t key = conversion_table[i].utf8_code;
+        uint32_t cp = legacy_key_unicode(key);
+        char utf8[4] = {0};
+        int n = 0;
+        if (key > 0xFFFF) utf8[n++] = (char)(key >> 16);
+        utf8[n++] = (char)(key >> 8);
+        utf8[n++] = (char)key;
+
+        // A key listed twice finds its first entry
+        uint16_t old = legacy_scan(utf8);
+        int char_len;
+        uint16_t now = utf8_char_to_gb2312(utf8, &char_len);
+        if (cp != 0 && scan_gb2312(cp) == old) {
+            right++;
+            CHECK_EQ(now, old);
+            CHECK_EQ(gb2312_to_unicode(old), cp);
+        } else {
+            CHECK(now != old);
+            if (cp) CHECK_EQ(now, scan_gb2312(cp));
+        }
+    }
+    CHECK_EQ(right, LEGACY_RIGHT);
+}
+
+#define SPEED_PASSES    20
+
+static volatile uint32_t speed_sink;
+
+static double elapsed_s(const struct timespec *t0)
+{
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// Lookups per second of every GB2312 character as UTF-8, through the old
+// scan of conversion_table and through utf8_char_to_gb2312()
+static void lookup_speed(void)
+{
+    static char utf8[N_PAIRS][4];
+    for (size_t i = 0; i < N_PAIRS; i++) utf8_encode(gb2312_pairs[i][1], utf8[i]);
+
+    struct timespec t0;
+    uint32_t sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int pass = 0; pass < SPEED_PASSES; pass++) {
+        for (size_t i = 0; i < N_PAIRS; i++) sum += legacy_scan(utf8[i]);
+    }
+    double legacy_rate = SPEED_PASSES * N_PAIRS / elapsed_s(&t0);
+
+    uint32_t found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int pass = 0; pass < SPEED_PASSES; pass++) {
+        for (size_t i = 0; i < N_PAIRS; i++) {
+            int len;
+            uint16_t gb = utf8_char_to_gb2312(utf8[i], &len);
+            sum += gb;
+            found += gb == gb2312_pairs[i][0];
+        }
+    }
+    double map_rate = SPEED_PASSES * N_PAIRS / elapsed_s(&t0);
+    speed_sink = sum;
+
+    printf("legacy scan %8.2f M lookups/s\n", legacy_rate / 1e6);
+    printf("tables      %8.2f M lookups/s\n", map_rate / 1e6);
+    CHECK_EQ(found, SPEED_PASSES * N_PAIRS);
+    // A page lookup against a scan of 365 entries, most of them missed
+    CHECK(map_rate > 10 * legacy_rate);
+}
+
+int main(void)
+{
+    TEST_RUN(every_code);
+    TEST_RUN(every_code_point);
+    TEST_RUN(round_trip);
+    TEST_RUN(legacy_table);
+    TEST_RUN(lookup_speed);
+    return test_done();
+}
@@ -0,0 +1,170 @@
+#include <string.h>
+#include "GUI_Paint.h"
+#include "font.h"
+#include "epaper_port.h"
+#include "test.h"
+
+/*
+ * Paint_DrawGlyph of components/epaper_lib against the per-pixel loop it
+ * replaced in Paint_DrawChar and Paint_DrawString_CN: a Paint_SetPixel for
+ * every glyph pixel. Both draw the same glyphs into two copies of a noisy
+ * frame, which must stay equal byte for byte, for every rotation and mirror,
+ * the glyph size of every font, opaque and transparent backgrounds, on a
+ * whole and a ragged memory width, inside the image and cut by its edges.
+ */
+
+#define MEM_W_RAGGED    797
+#define GLYPH_MAX       (font182_Width_EN / 8 * font182_Height)
+#define GLYPHS          3
+#define POSITIONS       5
+
+static UBYTE frame_blit[EPD_WIDTH / 8 * EPD_HEIGHT];
+static UBYTE frame_ref[EPD_WIDTH / 8 * EPD_HEIGHT];
+static UBYTE glyph[GLYPH_MAX];
+
+static uint32_t rand_state;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1664525u + 1013904223u;
+    return rand_state >> 8;
+}
+
+// Glyph 0 is solid, the others noise
+static void make_glyph(int n, int w, int h)
+{
+    int bytes = (w + 7) / 8 * h;
+    for (int i = 0; i < bytes; i++) glyph[i] = n == 0 ? 0xFF : (UBYTE)next_rand();
+}
+
+// The loop of Paint_DrawChar before the blitter, cut at the image edge
+static void draw_per_pixel(int x0, int y0, int w, int h, UWORD fore, UWORD back)
+{
+    const UBYTE *ptr = glyph;
+    for (int row = 0; row < h; row++) {
+        for (int col = 0; col < w; col++) {
+            bool inside = x0 + col < Paint.Width && y0 + row < Paint.Height;
+            if (*ptr & (0x80 >> (col % 8))) {
+                if (inside) Paint_SetPixel(x0 + col, y0 + row, fore);
+            } else if (back != TRANSPARENT) {
+                if (inside) Paint_SetPixel(x0 + col, y0 + row, back);
+            }
+            if (col % 8 == 7) ptr++;
+        }
+        if (w % 8 != 0) ptr++;
+    }
+}
+
+static const struct {
+    int w, h;
+} sizes[] = {
+    {font12_Width_EN, font12_Height}, {font12_Width_CH, font12_Height},
+    {font16_Width_EN, font16_Height}, {font16_Width_CH, font16_Height},
+    {font18_Width_EN, font18_Height}, {font18_Width_CH, font18_Height},
+    {font24_Width_EN, font24_Height}, {font24_Width_CH, font24_Height},
+    {font28_Width_EN, font28_Height}, {font28_Width_CH, font28_Height},
+    {font36_Width_EN, font36_Height}, {font36_Width_CH, font36_Height},
+    {font48_Width_EN, font48_Height}, {font48_Width_CH, font48_Height},
+    {font80_Width_EN, font80_Height},
+    {font182_Width_EN, font182_Height},
+    {5, 9},         // Widths that are not whole bytes
+    {13, 11},
+};
+
+static const struct {
+    UWORD fore, back;
+} colors[] = {
+    {BLACK, WHITE},
+    {WHITE, BLACK},
+    {BLACK, TRANSPARENT},
+    {WHITE, TRANSPARENT},
+};
+
+static const UWORD rotations[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+static const UBYTE mirrors[] = {MIRROR_NONE, MIRROR_HORIZONTAL, MIRROR_VERTICAL, MIRROR_ORIGIN};
+
+static void select_frame(UBYTE *frame, int mem_w, UWORD rotate, UBYTE mirror)
+{
+    Paint_NewImage(frame, mem_w, EPD_HEIGHT, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+}
+
+// One glyph into both frames, false once they differ
+static bool draw_both(int mem_w, UWORD rotate, UBYTE mirror, int x0, int y0, int w, int h,
+                      UWORD fore, UWORD back)
+{
+    Paint_SelectImage(frame_blit);
+    Paint_DrawGlyph(x0, y0, glyph, w, h, fore, back);
+    Paint_SelectImage(frame_ref);
+    draw_per_pixel(x0, y0, w, h, fore, back);
+
+    size_t bytes = (size_t)(mem_w + 7) / 8 * EPD_HEIGHT;
+    if (memcmp(frame_blit, frame_ref, bytes) == 0) return true;
+    size_t at = 0;
+    while (frame_blit[at] == frame_ref[at]) at++;
+    TEST_FAIL("rotate %d mirror %d width %d: %dx%d glyph at (%d, %d) fore %d back %d, byte %zu is %02X, expected %02X",
+              rotate, mirror, mem_w, w, h, x0, y0, fore, back, at, frame_blit[at], frame_ref[at]);
+    return false;
+}
+
+static void every_transform(void)
+{
+    static const int mem_widths[] = {EPD_WIDTH, MEM_W_RAGGED};
+    long cases = 0;
+
+    rand_state = 1;
+    for (size_t mw = 0; mw < sizeof(mem_widths) / sizeof(mem_widths[0]); mw++) {
+        int mem_w = mem_widths[mw];
+        for (size_t r = 0; r < sizeof(rotations) / sizeof(rotations[0]); r++) {
+            for (size_t m = 0; m < sizeof(mirrors) / sizeof(mirrors[0]); m++) {
+                for (size_t i = 0; i < sizeof(frame_ref); i++) frame_ref[i] = (UBYTE)next_rand();
+                memcpy(frame_blit, frame_ref, sizeof(frame_blit));
+                select_frame(frame_ref, mem_w, rotations[r], mirrors[m]);
+                int pw = Paint.Width, ph = Paint.Height;
+
+                for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+                    int w = sizes[s].w, h = sizes[s].h;
+                    // Inside, on odd pixels, flush with the far edges, cut by them,
+                    // and only the first pixel left
+                    const int pos[POSITIONS][2] = {
+                        {0, 0}, {37, 51}, {pw - w, ph - h}, {pw - w / 2, ph - h / 3}, {pw - 1, ph - 1},
+                    };
+                    for (int g = 0; g < GLYPHS; g++) {
+                        make_glyph(g, w, h);
+                        for (size_t c = 0; c < sizeof(colors) / sizeof(colors[0]); c++) {
+                            for (int p = 0; p < POSITIONS; p++) {
+                                if (!draw_both(mem_w, rotations[r], mirrors[m], pos[p][0], pos[p][1], w, h,
+                                               colors[c].fore, colors[c].back))
+                                    return;
+                                cases++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    test_checks++;
+    CHECK_EQ(cases, 2L * 4 * 4 * (long)(sizeof(sizes) / sizeof(sizes[0])) * GLYPHS * 4 * POSITIONS);
+}
+
+// Outside the image nothing is drawn, a glyph starting on the edge is dropped
+static void outside(void)
+{
+    memset(frame_ref, 0x5A, sizeof(frame_ref));
+    memcpy(frame_blit, frame_ref, sizeof(frame_blit));
+    make_glyph(0, font24_Width_EN, font24_Height);
+    select_frame(frame_blit, EPD_WIDTH, ROTATE_270, MIRROR_NONE);
+    Paint_DrawGlyph(Paint.Width, 0, glyph, font24_Width_EN, font24_Height, BLACK, WHITE);
+    Paint_DrawGlyph(0, Paint.Height, glyph, font24_Width_EN, font24_Height, BLACK, WHITE);
+    Paint_DrawGlyph(0, 0, NULL, font24_Width_EN, font24_Height, BLACK, WHITE);
+    Paint_DrawGlyph(0, 0, glyph, 0, font24_Height, BLACK, WHITE);
+    CHECK_MEM(frame_blit, frame_ref, sizeof(frame_ref));
+}
+
+int main(void)
+{
+    TEST_RUN(every_transform);
+    TEST_RUN(outside);
+    return test_done();
+}
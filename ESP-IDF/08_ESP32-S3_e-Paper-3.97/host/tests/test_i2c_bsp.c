@@ -0,0 +1,232 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "i2c_bsp.h"
+#include "mock_i2c.h"
+#include "test.h"
+
+/*
+ * The bus scheduler of components/i2c_bsp on a mock bus (mock_i2c.c). The
+ * bus is held while callers in other tasks queue up behind one transfer, so
+ * the order the executor drains them in is the order they reach the bus.
+ */
+
+#define QUEUE_SETTLE_MS     20
+
+// A task issuing one register read
+typedef struct {
+    uint8_t addr;
+    uint8_t data[4];
+    esp_err_t ret;
+    uint32_t notified_after;    // Task notifications left on slot 0 after the read
+    SemaphoreHandle_t finished;
+    TaskHandle_t task;
+} reader_t;
+
+static void reader_task(void *arg)
+{
+    reader_t *r = arg;
+    r->ret = i2c_read_reg(r->addr, 0x10, r->data, sizeof(r->data));
+    r->notified_after = ulTaskNotifyTake(pdTRUE, 0);
+    xSemaphoreGive(r->finished);
+    vTaskDelete(NULL);
+}
+
+static void reader_start(reader_t *r, uint8_t addr)
+{
+    memset(r, 0, sizeof(*r));
+    r->addr = addr;
+    r->ret = ESP_FAIL;
+    r->finished = xSemaphoreCreateBinary();
+    xTaskCreate(reader_task, "reader", 4096, r, 5, &r->task);
+}
+
+static void reader_check(reader_t *r)
+{
+    CHECK(xSemaphoreTake(r->finished, pdMS_TO_TICKS(1000)) == pdTRUE);
+    CHECK_EQ(r->ret, ESP_OK);
+    for (size_t i = 0; i < sizeof(r->data); i++) CHECK_EQ(r->data[i], mock_i2c_pattern(r->addr, i));
+    vSemaphoreDelete(r->finished);
+}
+
+static const i2c_dev_stats_t *stats_of(uint8_t addr, i2c_dev_stats_t *all, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (all[i].addr == addr) return &all[i];
+    }
+    return NULL;
+}
+
+static void priority_order(void)
+{
+    // Behind a sensor read on the bus: two more sensors, the RTC, then the codec
+    static const uint8_t queued[] = {QMI8658_SLAVE_ADDR_L, SHTC3Addr, PCF85063Addr, ES8311_I2C_ADDR};
+    static const uint8_t expect[] = {AXP2101Addr, ES8311_I2C_ADDR, PCF85063Addr, QMI8658_SLAVE_ADDR_L, SHTC3Addr};
+    reader_t readers[5];
+
+    mock_i2c_reset();
+    mock_i2c_hold();
+    reader_start(&readers[0], AXP2101Addr);
+    mock_i2c_wait_busy();
+    for (int i = 0; i < 4; i++) {
+        reader_start(&readers[i + 1], queued[i]);
+        vTaskDelay(pdMS_TO_TICKS(QUEUE_SETTLE_MS));
+    }
+    CHECK_EQ(mock_i2c_count(), 0);
+    mock_i2c_release();
+
+    for (int i = 0; i < 5; i++) reader_check(&readers[i]);
+    CHECK_EQ(mock_i2c_count(), 5);
+    for (int i = 0; i < 5 && i < mock_i2c_count(); i++) {
+        CHECK_EQ(mock_i2c_log(i)->addr, expect[i]);
+        CHECK_EQ(mock_i2c_log(i)->tx_len, 1);
+        CHECK_EQ(mock_i2c_log(i)->tx[0], 0x10);
+        CHECK_EQ(mock_i2c_log(i)->rx_len, 4);
+    }
+}
+
+// A wake-up given to a task while it waits on the bus is not taken for the
+// end of its transaction, and is still there afterwards
+static void foreign_notify(void)
+{
+    reader_t r;
+
+    mock_i2c_reset();
+    mock_i2c_hold();
+    reader_start(&r, QMI8658_SLAVE_ADDR_L);
+    mock_i2c_wait_busy();
+    xTaskNotifyGive(r.task);
+    CHECK(xSemaphoreTake(r.finished, pdMS_TO_TICKS(QUEUE_SETTLE_MS)) == pdFALSE);
+    mock_i2c_release();
+    reader_check(&r);
+    CHECK_EQ(r.notified_after, 1);
+}
+
+static void transfer_shapes(void)
+{
+    uint8_t wbuf[3] = {1, 2, 3};
+    uint8_t rbuf[2] = {0};
+
+    mock_i2c_reset();
+    CHECK_EQ(i2c_write_reg(AXP2101Addr, 0x20, wbuf, 3), ESP_OK);
+    CHECK_EQ(i2c_write_bytes(SHTC3Addr, wbuf, 2), ESP_OK);
+    CHECK_EQ(i2c_read_bytes(SHTC3Addr, rbuf, 2), ESP_OK);
+    CHECK_EQ(rbuf[1], mock_i2c_pattern(SHTC3Addr, 1));
+    CHECK_EQ(i2c_write_read(PCF85063Addr, wbuf, 1, rbuf, 2), ESP_OK);
+    CHECK_EQ(rbuf[0], mock_i2c_pattern(PCF85063Addr, 0));
+
+    CHECK_EQ(mock_i2c_count(), 4);
+    const mock_i2c_xfer_t *x = mock_i2c_log(0);
+    const uint8_t reg_write[] = {0x20, 1, 2, 3};
+    CHECK_EQ(x->tx_len, 4);
+    CHECK_MEM(x->tx, reg_write, 4);
+    CHECK_EQ(x->rx_len, 0);
+    x = mock_i2c_log(1);
+    CHECK_EQ(x->tx_len, 2);
+    CHECK_MEM(x->tx, wbuf, 2);
+    x = mock_i2c_log(2);
+    CHECK_EQ(x->tx_len, 0);
+    CHECK_EQ(x->rx_len, 2);
+    x = mock_i2c_log(3);
+    CHECK_EQ(x->tx_len, 1);
+    CHECK_EQ(x->rx_len, 2);
+}
+
+// Register writes are framed on the executor's stack up to the buffer size, on the heap beyond it
+static void register_write_buffer(void)
+{
+    uint8_t data[I2C_BSP_TX_BUF_LEN + 8];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)(0xA0 + i);
+
+    mock_i2c_reset();
+    CHECK_EQ(i2c_write_reg(AXP2101Addr, 0x40, data, I2C_BSP_TX_BUF_LEN - 1), ESP_OK);
+    CHECK_EQ(i2c_write_reg(AXP2101Addr, 0x40, data, I2C_BSP_TX_BUF_LEN), ESP_OK);
+    CHECK_EQ(i2c_write_reg(AXP2101Addr, 0x40, data, sizeof(data)), ESP_OK);
+
+    CHECK_EQ(mock_i2c_count(), 3);
+    const size_t lens[] = {I2C_BSP_TX_BUF_LEN - 1, I2C_BSP_TX_BUF_LEN, sizeof(data)};
+    for (int i = 0; i < 3 && i < mock_i2c_count(); i++) {
+        const mock_i2c_xfer_t *x = mock_i2c_log(i);
+        CHECK_EQ(x->tx_len, lens[i] + 1);
+        CHECK_EQ(x->tx[0], 0x40);
+        CHECK_MEM(&x->tx[1], data, lens[i]);
+        CHECK_EQ(x->tx_on_stack, i == 0);
+    }
+}
+
+static void statistics(void)
+{
+    i2c_dev_stats_t before[I2C_BSP_MAX_DEVICES], after[I2C_BSP_MAX_DEVICES];
+    uint8_t buf[6] = {0};
+
+    int n = i2c_bsp_get_stats(before, I2C_BSP_MAX_DEVICES);
+    const i2c_dev_stats_t *b = stats_of(QMI8658_SLAVE_ADDR_L, before, n);
+    CHECK(b != NULL);
+    if (!b) return;
+
+    mock_i2c_reset();
+    CHECK_EQ(i2c_read_reg(QMI8658_SLAVE_ADDR_L, 0x35, buf, 6), ESP_OK);
+    mock_i2c_fail(QMI8658_SLAVE_ADDR_L, ESP_ERR_TIMEOUT);
+    CHECK_EQ(i2c_write_reg(QMI8658_SLAVE_ADDR_L, 0x02, buf, 1), ESP_ERR_TIMEOUT);
+    mock_i2c_reset();
+
+    n = i2c_bsp_get_stats(after, I2C_BSP_MAX_DEVICES);
+    const i2c_dev_stats_t *a = stats_of(QMI8658_SLAVE_ADDR_L, after, n);
+    CHECK(a != NULL);
+    if (!a) return;
+    CHECK_EQ(a->transactions - b->transactions, 2);
+    CHECK_EQ(a->errors - b->errors, 1);
+    CHECK_EQ(a->bytes - b->bytes, (1 + 6) + (1 + 1));
+    CHECK(a->busy_us >= b->busy_us);
+}
+
+// Runs last, it fills the cache
+static void handle_cache(void)
+{
+    i2c_master_dev_handle_t h = NULL, h_slow = NULL, again = NULL;
+    int added = mock_i2c_devices_added();
+
+    // Every device was used above, so none of them is added again
+    CHECK_EQ(i2c_devices_init(), ESP_OK);
+    CHECK_EQ(mock_i2c_devices_added(), added);
+    CHECK(rtc_dev_handle != NULL);
+    CHECK_EQ(i2c_bus_add_device(PCF85063Addr, I2C_MASTER_FREQ_HZ, &h), ESP_OK);
+    CHECK(h == rtc_dev_handle);
+
+    // Another speed is another handle, created once
+    CHECK_EQ(i2c_bus_add_device(PCF85063Addr, 100000, &h_slow), ESP_OK);
+    CHECK_EQ(i2c_bus_add_device(PCF85063Addr, 100000, &again), ESP_OK);
+    CHECK(h_slow != rtc_dev_handle);
+    CHECK(again == h_slow);
+    CHECK_EQ(mock_i2c_devices_added(), added + 1);
+
+    // Fill the cache, then a new device is refused without touching the bus
+    i2c_dev_stats_t stats[I2C_BSP_MAX_DEVICES];
+    uint8_t addr = 0x20, buf[1];
+    while (i2c_bsp_get_stats(stats, I2C_BSP_MAX_DEVICES) < I2C_BSP_MAX_DEVICES) {
+        CHECK_EQ(i2c_read_reg(addr++, 0, buf, 1), ESP_OK);
+    }
+    added = mock_i2c_devices_added();
+    mock_i2c_reset();
+    CHECK_EQ(i2c_read_reg(addr, 0, buf, 1), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(i2c_bus_add_device(addr, I2C_MASTER_FREQ_HZ, &h), ESP_FAIL);
+    CHECK_EQ(mock_i2c_devices_added(), added);
+    CHECK_EQ(mock_i2c_count(), 0);
+
+    // Cached devices still work
+    CHECK_EQ(i2c_read_reg(0x20, 0, buf, 1), ESP_OK);
+    CHECK_EQ(mock_i2c_devices_added(), added);
+}
+
+int main(void)
+{
+    i2c_master_init();
+    TEST_RUN(priority_order);
+    TEST_RUN(foreign_notify);
+    TEST_RUN(transfer_shapes);
+    TEST_RUN(register_write_buffer);
+    TEST_RUN(statistics);
+    TEST_RUN(handle_cache);
+    return test_done();
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+#include "GUI_Paint.h"
+#include "ImageData.h"
+#include "epaper_port.h"
+#include "test.h"
+
+/*
+ * The PackBits icons of components/epaper_port/ImageData_packed.c, which
+ * tools/img_pack.py generates from the raw arrays of ImageData.c. Every
+ * packed icon is unpacked here and must give its raw array back; then
+ * Paint_BlitImage draws it packed and raw into two copies of a noisy frame,
+ * which must stay equal for every PAINT_ROP, rotation and a position cut by
+ * the edge. The raw draws are held against a Paint_SetPixel() per pixel.
+ */
+
+#define IMG_MAX     (96 / 8 * 132)
+
+typedef struct {
+    const char *name;
+    const PAINT_IMAGE *packed;
+    const unsigned char *raw;
+} asset_t;
+
+#define ASSET(n)    {#n, &Image_##n, gImage_##n}
+
+static const asset_t assets[] = {
+    ASSET(audio), ASSET(folder), ASSET(picture), ASSET(rests), ASSET(text), ASSET(WIFI), ASSET(BAT),
+    ASSET(alarm), ASSET(audio_file), ASSET(calendar), ASSET(clock), ASSET(file), ASSET(network),
+    ASSET(read), ASSET(weather), ASSET(Alarm_clock_time_point), ASSET(temperature), ASSET(humidity),
+    ASSET(point_in_time), ASSET(BAT_1), ASSET(fx), ASSET(quality), ASSET(shidu), ASSET(sunrise),
+    ASSET(sunset), ASSET(wendu), ASSET(GPS),
+};
+
+#define N_ASSETS    (sizeof(assets) / sizeof(assets[0]))
+
+static UBYTE frame_packed[EPD_SIZE_MONO];
+static UBYTE frame_raw[EPD_SIZE_MONO];
+static UBYTE frame_ref[EPD_SIZE_MONO];
+static uint32_t rand_state;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1664525u + 1013904223u;
+    return rand_state >> 8;
+}
+
+static size_t raw_size(const PAINT_IMAGE *img)
+{
+    return (size_t)(img->Width + 7) / 8 * img->Height;
+}
+
+// The format as tools/img_pack.py writes it, decoded without the blitter
+static size_t unpack(const PAINT_IMAGE *img, UBYTE *out)
+{
+    const UBYTE *p = img->Data, *end = img->Data + img->Size;
+    size_t n = 0, max = raw_size(img);
+    while (p < end && n < max) {
+        int c = (signed char)*p++;
+        if (c >= 0) {
+            for (int i = 0; i <= c && p < end && n < max; i++) out[n++] = *p++;
+        } else if (c != -128 && p < end) {
+            for (int i = 0; i < 1 - c && n < max; i++) out[n++] = *p;
+            p++;
+        }
+    }
+    int row = (img->Width + 7) / 8;
+    for (size_t i = row; i < n; i++) out[i] ^= out[i - row];
+    return n;
+}
+
+static void every_asset_unpacks(void)
+{
+    static UBYTE out[IMG_MAX];
+    size_t raw_total = 0, packed_total = 0;
+    for (size_t a = 0; a < N_ASSETS; a++) {
+        const PAINT_IMAGE *img = assets[a].packed;
+        CHECK_EQ(img->Format, IMAGE_PACKBITS);
+        if (raw_size(img) > sizeof(out)) {
+            test_checks++;
+            TEST_FAIL("%s: %dx%d is larger than the test buffer", assets[a].name, img->Width, img->Height);
+            continue;
+        }
+        memset(out, 0xA5, sizeof(out));
+        CHECK_EQ(unpack(img, out), raw_size(img));
+        CHECK_MEM(out, assets[a].raw, raw_size(img));
+        raw_total += raw_size(img);
+        packed_total += img->Size;
+    }
+    printf("%zu icons: %zu bytes raw, %zu packed\n", N_ASSETS, raw_total, packed_total);
+}
+
+// A Paint_SetPixel() per pixel of a raw icon, cut at the image edge
+static void draw_per_pixel(const PAINT_IMAGE *img, int x0, int y0, PAINT_ROP rop)
+{
+    int row = (img->Width + 7) / 8;
+    for (int y = 0; y < img->Height && y0 + y < Paint.Height; y++) {
+        for (int x = 0; x < img->Width && x0 + x < Paint.Width; x++) {
+            bool ink = img->Data[y * row + x / 8] & (0x80 >> (x % 8));
+            switch (rop) {
+            case ROP_COPY:   Paint_SetPixel(x0 + x, y0 + y, ink ? BLACK : WHITE); break;
+            case ROP_OR:     if (ink) Paint_SetPixel(x0 + x, y0 + y, BLACK); break;
+            case ROP_AND:    if (!ink) Paint_SetPixel(x0 + x, y0 + y, WHITE); break;
+            case ROP_INVERT: Paint_SetPixel(x0 + x, y0 + y, ink ? WHITE : BLACK); break;
+            default:         break;
+            }
+        }
+    }
+}
+
+static bool frames_equal(const UBYTE *got, const UBYTE *want, const char *what, const char *name,
+                         int rotate, PAINT_ROP rop, int x0, int y0)
+{
+    if (memcmp(got, want, EPD_SIZE_MONO) == 0) return true;
+    size_t at = 0;
+    while (got[at] == want[at]) at++;
+    TEST_FAIL("%s %s rotate %d rop %d at (%d, %d): byte %zu is %02X, expected %02X",
+              what, name, rotate, rop, x0, y0, at, got[at], want[at]);
+    return false;
+}
+
+static void every_rop(void)
+{
+    static const UWORD rotations[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+    static const PAINT_ROP rops[] = {ROP_COPY, ROP_OR, ROP_AND, ROP_XOR, ROP_INVERT};
+    long cases = 0;
+
+    rand_state = 5;
+    for (size_t r = 0; r < sizeof(rotations) / sizeof(rotations[0]); r++) {
+        Paint_NewImage(frame_raw, EPD_WIDTH, EPD_HEIGHT, rotations[r], WHITE);
+        for (size_t i = 0; i < EPD_SIZE_MONO; i++) frame_raw[i] = (UBYTE)next_rand();
+        memcpy(frame_packed, frame_raw, EPD_SIZE_MONO);
+
+        for (size_t a = 0; a < N_ASSETS; a++) {
+            const PAINT_IMAGE *packed = assets[a].packed;
+            PAINT_IMAGE raw = *packed;
+            raw.Data = assets[a].raw;
+            raw.Size = raw_size(packed);
+            raw.Format = IMAGE_RAW;
+            // On odd pixels inside, and cut by the far edges
+            const int pos[2][2] = {
+                {13, 29}, {Paint.Width - packed->Width / 2 - 3, Paint.Height - packed->Height / 2 - 1},
+            };
+
+            for (size_t o = 0; o < sizeof(rops) / sizeof(rops[0]); o++) {
+                for (int p = 0; p < 2; p++) {
+                    int x0 = pos[p][0], y0 = pos[p][1];
+                    memcpy(frame_ref, frame_raw, EPD_SIZE_MONO);
+                    Paint_SelectImage(frame_packed);
+                    Paint_BlitImage(x0, y0, packed, rops[o]);
+                    Paint_SelectImage(frame_raw);
+                    Paint_BlitImage(x0, y0, &raw, rops[o]);
+                    if (!frames_equal(frame_packed, frame_raw, "packed", assets[a].name, rotations[r], rops[o],
+                                      x0, y0))
+                        return;
+
+                    Paint_SelectImage(frame_ref);
+                    if (rops[o] == ROP_XOR) {
+                        // Twice is no change
+                        memcpy(frame_ref, frame_raw, EPD_SIZE_MONO);
+                        Paint_BlitImage(x0, y0, &raw, ROP_XOR);
+                        Paint_BlitImage(x0, y0, &raw, ROP_XOR);
+                        if (!frames_equal(frame_ref, frame_raw, "xor twice", assets[a].name, rotations[r],
+                                          rops[o], x0, y0))
+                            return;
+                    } else {
+                        draw_per_pixel(&raw, x0, y0, rops[o]);
+                        if (!frames_equal(frame_raw, frame_ref, "raw", assets[a].name, rotations[r], rops[o],
+                                          x0, y0))
+                            return;
+                    }
+                    cases++;
+                }
+            }
+        }
+    }
+    test_checks++;
+    CHECK_EQ(cases, 4L * N_ASSETS * 5 * 2);
+}
+
+// A stream cut short draws the rows before the cut and never reads past it
+static void truncated(void)
+{
+    PAINT_IMAGE cut = Image_clock;
+    cut.Size = Image_clock.Size / 2;
+    int row = Image_clock.Width / 8, rows_same = 0;
+
+    Paint_NewImage(frame_packed, EPD_WIDTH, EPD_HEIGHT, ROTATE_0, WHITE);
+    Paint_Clear(WHITE);
+    Paint_BlitImage(0, 0, &cut, ROP_COPY);
+    // Image ink is 1, frame black is 0
+    for (bool same = true; same && rows_same < Image_clock.Height; rows_same += same) {
+        const UBYTE *f = frame_packed + rows_same * (EPD_WIDTH / 8), *r = gImage_clock + rows_same * row;
+        for (int i = 0; i < row; i++) same &= f[i] == (UBYTE)~r[i];
+    }
+    CHECK(rows_same > 0);
+    CHECK(rows_same < Image_clock.Height);
+}
+
+int main(void)
+{
+    TEST_RUN(every_asset_unpacks);
+    TEST_RUN(every_rop);
+    TEST_RUN(truncated);
+    return test_done();
+}
@@ -0,0 +1,483 @@
+#include <stdlib.h>
+#include <time.h>
+#include "img_pipeline.h"
+#include "test.h"
+
+/*
+ * components/img_pipeline: the streaming pipeline against a whole-image
+ * reference written here from the description in img_pipeline.h (sharpen
+ * over the whole frame, then each dither over the whole frame with a full
+ * error plane). Rows are pushed one at a time from a buffer overwritten
+ * after every push, in every output format, dither, gamma, sharpening and
+ * threshold. Golden hashes pin the mono and 4-gray output of a test card,
+ * and flat grays check that the dithers keep their density. The row
+ * throughput benchmark prints its figures and checks nothing.
+ */
+
+#define MAX_W   256
+#define MAX_H   64
+#define BENCH_W 480
+#define BENCH_H 800
+
+// 8x8 Bayer matrix, 0..63, as img_pipeline.c has it
+static const uint8_t bayer8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+typedef struct {
+    int w, h;
+    uint8_t rgb[MAX_H][MAX_W * 3];
+} card_t;
+
+// What the callback received
+typedef struct {
+    int rows, bytes;
+    bool order_ok;
+    uint8_t out[MAX_H][MAX_W / 4 + 1];
+} sink_t;
+
+static void collect(void *ctx, int y, const uint8_t *row)
+{
+    sink_t *s = ctx;
+    if (y != s->rows || y >= MAX_H) {
+        s->order_ok = false;
+        return;
+    }
+    memcpy(s->out[y], row, s->bytes);
+    s->rows++;
+}
+
+static int clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// A photo-like card: a diagonal ramp, a disc, colour bars and a fine checker
+static void make_card(card_t *c, int w, int h)
+{
+    c->w = w;
+    c->h = h;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint8_t *p = &c->rgb[y][x * 3];
+            int ramp = w + h > 2 ? (x + y) * 255 / (w + h - 2) : 128;
+            int dx = x - w / 2, dy = y - h / 2;
+            p[0] = p[1] = p[2] = (uint8_t)ramp;
+            if (dx * dx + dy * dy < (w * w + h * h) / 36) {
+                p[0] = (uint8_t)(255 - ramp);
+                p[1] = (uint8_t)(ramp / 2);
+                p[2] = 200;
+            }
+            if (y < h / 4 && x >= w / 2) {
+                static const uint8_t bars[4][3] = {{255, 0, 0}, {0, 200, 0}, {40, 40, 255}, {250, 250, 250}};
+                memcpy(p, bars[(x * 4 / w) & 3], 3);
+            }
+            if (y >= h - h / 5 && x < w / 3 && ((x ^ y) & 1)) p[0] = p[1] = p[2] = 0;
+        }
+    }
+}
+
+// The whole image at once: luminance, sharpening, dithering, packing
+static void reference(const img_pipe_cfg_t *cfg, const card_t *c, sink_t *s)
+{
+    static int lum[MAX_H][MAX_W], v[MAX_H][MAX_W], err[MAX_H + 2][MAX_W + 4];
+    static uint16_t row[MAX_W];
+    int w = c->w, h = c->h;
+    int levels = cfg->out == IMG_OUT_GRAY2 ? 4 : 2, top = levels - 1;
+    uint8_t t = cfg->threshold ? cfg->threshold : 128;
+    int thr = img_lum_rgb(t, t, t, cfg->gamma);
+
+    for (int y = 0; y < h; y++) {
+        img_lum_row(IMG_SRC_RGB24, c->rgb[y], w, NULL, cfg->gamma, row);
+        for (int x = 0; x < w; x++) lum[y][x] = row[x];
+    }
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int cv = lum[y][x];
+            if (cfg->sharpen) {
+                int lap = 4 * cv - lum[y > 0 ? y - 1 : 0][x] - lum[y < h - 1 ? y + 1 : h - 1][x]
+                        - lum[y][x > 0 ? x - 1 : 0] - lum[y][x < w - 1 ? x + 1 : w - 1];
+                cv = clamp(cv + lap * cfg->sharpen / 16, 0, IMG_LUM_MAX);
+            }
+            v[y][x] = cv;
+        }
+    }
+
+    memset(err, 0, sizeof(err));
+    s->bytes = img_out_row_bytes(cfg->out, w);
+    s->rows = h;
+    for (int y = 0; y < h; y++) {
+        int dir = (cfg->dither == IMG_DITHER_FLOYD && (y & 1)) ? -1 : 1;
+        memset(s->out[y], 0, s->bytes);
+        for (int i = 0; i < w; i++) {
+            int x = dir > 0 ? i : w - 1 - i, q;
+            int *e = &err[y][x + 2];
+            if (cfg->dither == IMG_DITHER_BAYER8) {
+                q = (v[y][x] * top + bayer8[y & 7][x & 7] * 64 + 32) >> 12;
+            } else {
+                int val = v[y][x] + (cfg->dither == IMG_DITHER_NONE ? 0 : *e);
+                q = levels == 2 ? val >= thr : (val >= 683) + (val >= 2048) + (val >= 3413);
+                int d = val - q * IMG_LUM_MAX / top;
+                int *below = &err[y + 1][x + 2], *below2 = &err[y + 2][x + 2];
+                if (cfg->dither == IMG_DITHER_FLOYD) {
+                    int e7 = d * 7 / 16, e3 = d * 3 / 16, e5 = d * 5 / 16;
+                    e[dir] += e7;
+                    below[-dir] += e3;
+                    below[0] += e5;
+                    below[dir] += d - e7 - e3 - e5;
+                } else if (cfg->dither == IMG_DITHER_ATKINSON) {
+                    d /= 8;
+                    e[1] += d;
+                    e[2] += d;
+                    below[-1] += d;
+                    below[0] += d;
+                    below[1] += d;
+                    below2[0] += d;
+                }
+            }
+            if (levels == 4)
+                s->out[y][x >> 2] |= q << (6 - 2 * (x & 3));
+            else if (q == 0)
+                s->out[y][x >> 3] |= 0x80 >> (x & 7);
+        }
+        // Error that fell off the left or right edge goes nowhere
+        for (int k = 0; k < 2; k++) {
+            err[y + 1][k] = err[y + 1][w + 2 + k] = 0;
+            err[y + 2][k] = err[y + 2][w + 2 + k] = 0;
+        }
+    }
+}
+
+// The pipeline fed a row at a time from one buffer, overwritten after each push
+static esp_err_t stream(img_pipe_cfg_t cfg, const card_t *c, sink_t *s)
+{
+    static uint8_t scratch[MAX_W * 3];
+    img_pipe_t *pipe;
+
+    memset(s, 0, sizeof(*s));
+    s->order_ok = true;
+    s->bytes = img_out_row_bytes(cfg.out, c->w);
+    cfg.width = c->w;
+    cfg.emit = collect;
+    cfg.ctx = s;
+    esp_err_t err = img_pipe_create(&cfg, &pipe);
+    if (err != ESP_OK) return err;
+    for (int y = 0; y < c->h; y++) {
+        memcpy(scratch, c->rgb[y], c->w * 3);
+        img_pipe_push(pipe, IMG_SRC_RGB24, scratch, NULL);
+        memset(scratch, 0xA5, sizeof(scratch));
+    }
+    img_pipe_finish(pipe);
+    img_pipe_destroy(pipe);
+    return ESP_OK;
+}
+
+static bool same_output(const sink_t *a, const sink_t *b, int h, const char *what)
+{
+    if (!a->order_ok || a->rows != h) {
+        TEST_FAIL("%s: %d rows emitted%s, expected %d", what, a->rows, a->order_ok ? "" : " out of order", h);
+        return false;
+    }
+    for (int y = 0; y < h; y++) {
+        if (memcmp(a->out[y], b->out[y], a->bytes) != 0) {
+            TEST_FAIL("%s: row %d differs from the whole-image reference", what, y);
+            return false;
+        }
+    }
+    return true;
+}
+
+static const char *const dither_names[] = {"none", "bayer8", "floyd", "atkinson"};
+
+static void stream_vs_whole(void)
+{
+    static const int sizes[][2] = {{1, 1}, {1, 7}, {7, 1}, {2, 2}, {37, 23}, {64, 64}, {256, 9}};
+    static const uint8_t sharpen[] = {0, 1, 4, 8};
+    static const uint8_t thresholds[] = {0, 90, 200};
+    static card_t c;
+    static sink_t got, want;
+    char what[128];
+    int runs = 0;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        make_card(&c, sizes[s][0], sizes[s][1]);
+        for (int out = IMG_OUT_INK1; out <= IMG_OUT_GRAY2; out++) {
+            for (int d = IMG_DITHER_NONE; d <= IMG_DITHER_ATKINSON; d++) {
+                for (int g = 0; g < 2; g++) {
+                    for (size_t k = 0; k < sizeof(sharpen); k++) {
+                        for (size_t t = 0; t < sizeof(thresholds); t++) {
+                            // The cut-off is for 1 bit only
+                            if (out == IMG_OUT_GRAY2 && t > 0) continue;
+                            img_pipe_cfg_t cfg = {
+                                .out = out, .dither = d, .gamma = g, .sharpen = sharpen[k],
+                                .threshold = thresholds[t],
+                            };
+                            snprintf(what, sizeof(what), "%dx%d %s %s%s sharpen %d threshold %d", c.w, c.h,
+                                     out == IMG_OUT_GRAY2 ? "gray2" : "ink1", dither_names[d],
+                                     g ? " gamma" : "", sharpen[k], thresholds[t]);
+                            CHECK_EQ(stream(cfg, &c, &got), ESP_OK);
+                            reference(&cfg, &c, &want);
+                            if (!same_output(&got, &want, c.h, what)) return;
+                            runs++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    test_checks++;
+    CHECK(runs > 500);
+}
+
+// A gray picture as every source format gives the same rows
+static void source_formats(void)
+{
+    static const img_src_fmt_t fmts[] = {IMG_SRC_GRAY8, IMG_SRC_RGB24, IMG_SRC_BGR24, IMG_SRC_BGRX32,
+                                         IMG_SRC_INDEX8, IMG_SRC_INDEX4, IMG_SRC_INDEX1};
+    static const char *const names[] = {"gray8", "rgb24", "bgr24", "bgrx32", "index8", "index4", "index1"};
+    enum { W = 45, H = 11 };
+    uint8_t src[W * 4];
+    uint16_t lum[W], ref[W], palette[256];
+
+    for (int g = 0; g < 2; g++) {
+        for (int i = 0; i < 256; i++) palette[i] = img_lum_rgb((uint8_t)(255 - i), (uint8_t)(255 - i), (uint8_t)(255 - i), g);
+        for (int y = 0; y < H; y++) {
+            uint8_t gray[W];
+            for (int x = 0; x < W; x++) gray[x] = (uint8_t)((x * 37 + y * 11) & 0xFF);
+            img_lum_row(IMG_SRC_GRAY8, gray, W, NULL, g, ref);
+            for (size_t f = 1; f < sizeof(fmts) / sizeof(fmts[0]); f++) {
+                // Index formats store 255 - gray, their palette undoes it; 4 and 1 bit keep the top bits
+                memset(src, 0, sizeof(src));
+                uint16_t want[W];
+                memcpy(want, ref, sizeof(want));
+                for (int x = 0; x < W; x++) {
+                    uint8_t v = gray[x];
+                    switch (fmts[f]) {
+                    case IMG_SRC_RGB24: src[3 * x] = src[3 * x + 1] = src[3 * x + 2] = v; break;
+                    case IMG_SRC_BGR24: src[3 * x] = src[3 * x + 1] = src[3 * x + 2] = v; break;
+                    case IMG_SRC_BGRX32: src[4 * x] = src[4 * x + 1] = src[4 * x + 2] = v; src[4 * x + 3] = 0x5A; break;
+                    case IMG_SRC_INDEX8: src[x] = (uint8_t)(255 - v); break;
+                    case IMG_SRC_INDEX4:
+                        src[x >> 1] |= (uint8_t)((15 - (v >> 4)) << ((x & 1) ? 0 : 4));
+                        want[x] = palette[15 - (v >> 4)];
+                        break;
+                    case IMG_SRC_INDEX1:
+                        src[x >> 3] |= (uint8_t)((v >> 7) << (7 - (x & 7)));
+                        want[x] = palette[v >> 7];
+                        break;
+                    default: break;
+                    }
+                }
+                img_lum_row(fmts[f], src, W, palette, g, lum);
+                if (memcmp(lum, want, sizeof(lum)) != 0) {
+                    TEST_FAIL("%s%s row %d", names[f], g ? " gamma" : "", y);
+                    return;
+                }
+            }
+        }
+    }
+    test_checks++;
+
+    // The working scale ends on black and white, the cut-off gray sits on itself
+    CHECK_EQ(img_lum_rgb(0, 0, 0, false), 0);
+    CHECK_EQ(img_lum_rgb(255, 255, 255, false), IMG_LUM_MAX);
+    CHECK_EQ(img_lum_rgb(0, 0, 0, true), 0);
+    CHECK_EQ(img_lum_rgb(255, 255, 255, true), IMG_LUM_MAX);
+    CHECK_NEAR(img_lum_rgb(128, 128, 128, false), 128 * 4095 / 255, 16);
+    CHECK_NEAR(img_lum_rgb(128, 128, 128, true), 0.2158 * 4095, 8);    // sRGB mid gray in linear light
+    CHECK(img_lum_rgb(0, 255, 0, false) > img_lum_rgb(255, 0, 0, false));
+    CHECK(img_lum_rgb(255, 0, 0, false) > img_lum_rgb(0, 0, 255, false));
+}
+
+// img_pipe_push_lum on rows already converted gives what img_pipe_push does
+static void push_lum(void)
+{
+    static card_t c;
+    static sink_t a, b;
+    uint16_t lum[MAX_W];
+    img_pipe_t *pipe;
+
+    make_card(&c, 61, 19);
+    img_pipe_cfg_t cfg = {.width = c.w, .out = IMG_OUT_GRAY2, .dither = IMG_DITHER_FLOYD, .sharpen = 3,
+                          .emit = collect, .ctx = &b};
+    CHECK_EQ(stream(cfg, &c, &a), ESP_OK);
+    memset(&b, 0, sizeof(b));
+    b.order_ok = true;
+    b.bytes = a.bytes;
+    CHECK_EQ(img_pipe_create(&cfg, &pipe), ESP_OK);
+    for (int y = 0; y < c.h; y++) {
+        img_lum_row(IMG_SRC_RGB24, c.rgb[y], c.w, NULL, false, lum);
+        img_pipe_push_lum(pipe, lum);
+        memset(lum, 0x5A, sizeof(lum));
+    }
+    // Sharpening holds the last row back until finish
+    CHECK_EQ(b.rows, c.h - 1);
+    img_pipe_finish(pipe);
+    img_pipe_finish(pipe);
+    img_pipe_destroy(pipe);
+    same_output(&b, &a, c.h, "push_lum");
+}
+
+static uint32_t fnv1a(uint32_t h, const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// The test card in each output format and dither, hashed
+static void golden(void)
+{
+    static const struct {
+        img_out_fmt_t out;
+        img_dither_t dither;
+        bool gamma;
+        uint8_t sharpen;
+        uint32_t hash;
+    } cases[] = {
+        {IMG_OUT_INK1, IMG_DITHER_NONE, false, 0, 0xD3DD75D3},
+        {IMG_OUT_INK1, IMG_DITHER_BAYER8, false, 0, 0xFBB73859},
+        {IMG_OUT_INK1, IMG_DITHER_FLOYD, false, 0, 0xEDEA4B4F},
+        {IMG_OUT_INK1, IMG_DITHER_ATKINSON, false, 0, 0x0DD0AE2E},
+        {IMG_OUT_INK1, IMG_DITHER_FLOYD, true, 2, 0x63D5AB80},
+        {IMG_OUT_GRAY2, IMG_DITHER_NONE, false, 0, 0xA4A98970},
+        {IMG_OUT_GRAY2, IMG_DITHER_BAYER8, false, 0, 0xBFEE0E16},
+        {IMG_OUT_GRAY2, IMG_DITHER_FLOYD, false, 0, 0xB35419DB},
+        {IMG_OUT_GRAY2, IMG_DITHER_ATKINSON, false, 0, 0x19335A77},
+        {IMG_OUT_GRAY2, IMG_DITHER_FLOYD, true, 4, 0xD0BAE073},
+    };
+    static card_t c;
+    static sink_t s;
+
+    make_card(&c, 96, 64);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        img_pipe_cfg_t cfg = {.out = cases[i].out, .dither = cases[i].dither, .gamma = cases[i].gamma,
+                              .sharpen = cases[i].sharpen};
+        CHECK_EQ(stream(cfg, &c, &s), ESP_OK);
+        uint32_t h = 2166136261u;
+        for (int y = 0; y < s.rows; y++) h = fnv1a(h, s.out[y], s.bytes);
+        if (h != cases[i].hash)
+            TEST_FAIL("%s %s%s sharpen %d: 0x%08X, golden 0x%08X", cases[i].out == IMG_OUT_GRAY2 ? "gray2" : "ink1",
+                      dither_names[cases[i].dither], cases[i].gamma ? " gamma" : "", cases[i].sharpen, h, cases[i].hash);
+        test_checks++;
+    }
+}
+
+// Flat grays come out with the density of the gray, in mono and 4 gray
+static void density(void)
+{
+    static card_t c;
+    static sink_t s;
+    static const img_dither_t dithers[] = {IMG_DITHER_BAYER8, IMG_DITHER_FLOYD};
+
+    for (int out = IMG_OUT_INK1; out <= IMG_OUT_GRAY2; out++) {
+        for (size_t d = 0; d < 2; d++) {
+            for (int gray = 8; gray < 256; gray += 16) {
+                c.w = 64;
+                c.h = 64;
+                for (int y = 0; y < c.h; y++) memset(c.rgb[y], gray, c.w * 3);
+                img_pipe_cfg_t cfg = {.out = out, .dither = dithers[d]};
+                CHECK_EQ(stream(cfg, &c, &s), ESP_OK);
+                // Mean output level on the 0..1 scale
+                double sum = 0;
+                for (int y = 0; y < c.h; y++) {
+                    for (int x = 0; x < c.w; x++) {
+                        if (out == IMG_OUT_GRAY2)
+                            sum += ((s.out[y][x >> 2] >> (6 - 2 * (x & 3))) & 3) / 3.0;
+                        else
+                            sum += !((s.out[y][x >> 3] >> (7 - (x & 7))) & 1);
+                    }
+                }
+                double mean = sum / (c.w * c.h), want = img_lum_rgb(gray, gray, gray, false) / (double)IMG_LUM_MAX;
+                if (mean - want > 0.02 || want - mean > 0.02)
+                    TEST_FAIL("%s %s gray %d: mean %.3f, expected %.3f", out == IMG_OUT_GRAY2 ? "gray2" : "ink1",
+                              dither_names[dithers[d]], gray, mean, want);
+                test_checks++;
+            }
+        }
+    }
+}
+
+static void bad_config(void)
+{
+    sink_t s;
+    img_pipe_t *pipe = NULL;
+    img_pipe_cfg_t cfg = {.width = 10, .emit = collect, .ctx = &s};
+
+    CHECK_EQ(img_pipe_create(NULL, &pipe), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(img_pipe_create(&cfg, NULL), ESP_ERR_INVALID_ARG);
+    cfg.width = 0;
+    CHECK_EQ(img_pipe_create(&cfg, &pipe), ESP_ERR_INVALID_ARG);
+    cfg.width = IMG_MAX_WIDTH + 1;
+    CHECK_EQ(img_pipe_create(&cfg, &pipe), ESP_ERR_INVALID_ARG);
+    cfg.width = IMG_MAX_WIDTH;
+    cfg.emit = NULL;
+    CHECK_EQ(img_pipe_create(&cfg, &pipe), ESP_ERR_INVALID_ARG);
+    cfg.emit = collect;
+    CHECK_EQ(img_pipe_create(&cfg, &pipe), ESP_OK);
+    img_pipe_destroy(pipe);
+    img_pipe_destroy(NULL);
+
+    CHECK_EQ(img_out_row_bytes(IMG_OUT_INK1, 1), 1);
+    CHECK_EQ(img_out_row_bytes(IMG_OUT_INK1, 9), 2);
+    CHECK_EQ(img_out_row_bytes(IMG_OUT_GRAY2, 4), 1);
+    CHECK_EQ(img_out_row_bytes(IMG_OUT_GRAY2, 5), 2);
+}
+
+static volatile unsigned bench_sink;     // Keeps the timed loops
+
+static void count_rows(void *ctx, int y, const uint8_t *row)
+{
+    *(unsigned *)ctx += row[0] + (unsigned)y;
+}
+
+// Rows per second for a 480 x 800 page in each mode; reported only
+static void bench(void)
+{
+    static uint8_t rgb[BENCH_W * 3];
+    static const img_dither_t dithers[] = {IMG_DITHER_NONE, IMG_DITHER_BAYER8, IMG_DITHER_FLOYD, IMG_DITHER_ATKINSON};
+
+    for (int out = IMG_OUT_INK1; out <= IMG_OUT_GRAY2; out++) {
+        for (size_t d = 0; d < 4; d++) {
+            unsigned sum = 0;
+            img_pipe_t *pipe;
+            img_pipe_cfg_t cfg = {.width = BENCH_W, .out = out, .dither = dithers[d], .sharpen = 2,
+                                  .emit = count_rows, .ctx = &sum};
+            if (img_pipe_create(&cfg, &pipe) != ESP_OK) {
+                TEST_FAIL("cannot create a %d wide pipeline", BENCH_W);
+                return;
+            }
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            for (int y = 0; y < BENCH_H; y++) {
+                for (int x = 0; x < BENCH_W * 3; x++) rgb[x] = (uint8_t)(x * 7 + y * 3);
+                img_pipe_push(pipe, IMG_SRC_RGB24, rgb, NULL);
+            }
+            img_pipe_finish(pipe);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            img_pipe_destroy(pipe);
+            double us = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+            printf("%-5s %-8s %8.2f us/row %7.2f ms/page\n", out == IMG_OUT_GRAY2 ? "gray2" : "ink1",
+                   dither_names[dithers[d]], us / BENCH_H, us / 1e3);
+            bench_sink = sum;
+        }
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(stream_vs_whole);
+    TEST_RUN(source_formats);
+    TEST_RUN(push_lum);
+    TEST_RUN(golden);
+    TEST_RUN(density);
+    TEST_RUN(bad_config);
+    TEST_RUN(bench);
+    return test_done();
+}
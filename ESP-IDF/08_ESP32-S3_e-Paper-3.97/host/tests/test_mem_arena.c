@@ -0,0 +1,361 @@
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mem_arena.h"
+#include "test.h"
+
+/*
+ * The PSRAM pools of components/mem_arena: which pool a size goes to, blocks
+ * reused in place, overflow to the heap when a pool is full, scopes pushed
+ * and popped (nested, too deep, left twice, other tasks untouched), stale
+ * and bad frees, and running out of memory. malloc is wrapped (see
+ * CMakeLists.txt) so a test can make the heap fail; a pool that cannot be
+ * reserved at start-up is tried in a child process, as init runs once.
+ */
+
+static size_t fail_from;            // Allocations of at least this many bytes fail, 0: none
+static size_t fail_size;            // Allocations of exactly this many bytes fail
+
+void *__real_malloc(size_t size);
+void *__wrap_malloc(size_t size)
+{
+    if ((fail_from && size >= fail_from) || size == fail_size) return NULL;
+    return __real_malloc(size);
+}
+
+static mem_arena_stats_t stats(void)
+{
+    mem_arena_stats_t s;
+    mem_arena_get_stats(&s);
+    return s;
+}
+
+// The pool ptr is a block of, -1 for the heap
+static int pool_of(const void *ptr)
+{
+    static uint8_t *lo[MEM_POOL_COUNT], *hi[MEM_POOL_COUNT];
+    static bool known;
+    if (!known) {
+        // Fill each pool once to learn where it lies
+        mem_arena_stats_t s = stats();
+        static const size_t sizes[MEM_POOL_COUNT] = {MEM_GLYPH_SIZE, MEM_LINE_SIZE, MEM_MONO_SIZE, MEM_GRAY_SIZE};
+        for (int p = 0; p < MEM_POOL_COUNT; p++) {
+            void *blocks[32];
+            int n = s.pools[p].blocks;
+            if (n == 0) continue;
+            for (int i = 0; i < n; i++) blocks[i] = mem_alloc(sizes[p]);
+            lo[p] = hi[p] = blocks[0];
+            for (int i = 1; i < n; i++) {
+                if ((uint8_t *)blocks[i] < lo[p]) lo[p] = blocks[i];
+                if ((uint8_t *)blocks[i] > hi[p]) hi[p] = blocks[i];
+            }
+            for (int i = 0; i < n; i++) mem_free(blocks[i]);
+        }
+        known = true;
+    }
+    for (int p = 0; p < MEM_POOL_COUNT; p++) {
+        if ((const uint8_t *)ptr >= lo[p] && (const uint8_t *)ptr <= hi[p]) return p;
+    }
+    return -1;
+}
+
+// Run in a child before anything else: the gray pool cannot be reserved
+static void init_failure(void)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        fail_size = (size_t)MEM_GRAY_SIZE * CONFIG_MEM_ARENA_GRAY_FRAMES;
+        esp_err_t err = mem_arena_init();
+        fail_size = 0;
+        mem_arena_stats_t s = stats();
+        CHECK_EQ(err, ESP_ERR_NO_MEM);
+        CHECK_EQ(s.pools[MEM_POOL_GRAY].blocks, 0);
+        CHECK_EQ(s.pools[MEM_POOL_MONO].blocks, CONFIG_MEM_ARENA_MONO_FRAMES);
+        // A gray frame still comes, from the heap
+        void *gray = mem_alloc(MEM_GRAY_SIZE);
+        CHECK(gray != NULL);
+        CHECK_EQ(stats().heap_blocks, 1);
+        CHECK_EQ(stats().pools[MEM_POOL_GRAY].overflows, 1);
+        mem_free(gray);
+        CHECK_EQ(stats().heap_blocks, 0);
+        _exit(test_failures ? 1 : 0);
+    }
+    int status = -1;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void routing(void)
+{
+    pool_of(NULL);
+    static const struct {
+        size_t size;
+        int pool;
+    } table[] = {
+        {1, MEM_POOL_GLYPH},
+        {MEM_GLYPH_SIZE, MEM_POOL_GLYPH},
+        {MEM_GLYPH_SIZE + 1, -1},               // Would waste most of a line block
+        {MEM_GLYPH_SIZE * 4, -1},
+        {MEM_GLYPH_SIZE * 4 + 1, MEM_POOL_LINE},
+        {MEM_LINE_SIZE, MEM_POOL_LINE},
+        {MEM_LINE_SIZE + 1, -1},
+        {32 * 1024, -1},
+        {32 * 1024 + 1, MEM_POOL_MONO},
+        {MEM_MONO_SIZE, MEM_POOL_MONO},
+        {MEM_MONO_SIZE + 1, MEM_POOL_GRAY},
+        {MEM_GRAY_SIZE, MEM_POOL_GRAY},
+        {MEM_GRAY_SIZE + 1, -1},
+        {1 << 20, -1},
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        mem_arena_stats_t before = stats();
+        uint8_t *p = mem_alloc(table[i].size);
+        int pool = pool_of(p);
+        test_checks++;
+        if (!p || pool != table[i].pool) TEST_FAIL("%zu bytes: pool %d, expected %d", table[i].size, pool, table[i].pool);
+        // The block is the caller's, every byte of it
+        if (p) memset(p, 0xA5, table[i].size);
+        mem_arena_stats_t after = stats();
+        if (table[i].pool < 0) {
+            CHECK_EQ(after.heap_blocks, before.heap_blocks + 1);
+            CHECK_EQ(after.heap_bytes, before.heap_bytes + table[i].size);
+            CHECK_EQ((uintptr_t)p % 16, 0);
+        } else {
+            CHECK_EQ(after.pools[table[i].pool].in_use, before.pools[table[i].pool].in_use + 1);
+        }
+        mem_free(p);
+        mem_arena_stats_t freed = stats();
+        for (int k = 0; k < MEM_POOL_COUNT; k++) CHECK_EQ(freed.pools[k].in_use, before.pools[k].in_use);
+        CHECK_EQ(freed.heap_blocks, before.heap_blocks);
+        CHECK_EQ(freed.heap_bytes, before.heap_bytes);
+    }
+
+    CHECK(mem_alloc(0) == NULL);
+    mem_free(NULL);
+    CHECK(mem_calloc(SIZE_MAX / 2, 4) == NULL);
+    // calloc clears a block the last user left dirty
+    uint8_t *dirty = mem_alloc(300);
+    memset(dirty, 0xFF, 300);
+    mem_free(dirty);
+    uint8_t *clean = mem_calloc(30, 10);
+    CHECK(clean == dirty);
+    uint8_t zero[300] = {0};
+    CHECK_MEM(clean, zero, 300);
+    mem_free(clean);
+}
+
+// Freed blocks are taken again in place, a full pool overflows to the heap
+static void slab_reuse(void)
+{
+    void *glyphs[MEM_GLYPH_BLOCKS];
+    mem_arena_stats_t before = stats();
+
+    for (int i = 0; i < MEM_GLYPH_BLOCKS; i++) {
+        glyphs[i] = mem_alloc(64);
+        test_checks++;
+        if (pool_of(glyphs[i]) != MEM_POOL_GLYPH) TEST_FAIL("glyph %d not from its pool", i);
+        for (int j = 0; j < i; j++) {
+            if (glyphs[j] == glyphs[i]) TEST_FAIL("glyphs %d and %d share a block", j, i);
+        }
+    }
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].in_use, MEM_GLYPH_BLOCKS);
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].high_water, MEM_GLYPH_BLOCKS);
+
+    // The pool is full: the next one is an overflow from the heap
+    void *extra = mem_alloc(64);
+    CHECK_EQ(pool_of(extra), -1);
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].overflows, before.pools[MEM_POOL_GLYPH].overflows + 1);
+    CHECK_EQ(stats().heap_blocks, before.heap_blocks + 1);
+
+    // A freed block is the next one handed out
+    mem_free(glyphs[17]);
+    void *again = mem_alloc(100);
+    CHECK(again == glyphs[17]);
+    glyphs[17] = again;
+    mem_free(extra);
+
+    for (int i = MEM_GLYPH_BLOCKS - 1; i >= 0; i--) mem_free(glyphs[i]);
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].in_use, 0);
+    CHECK_EQ(stats().heap_blocks, before.heap_blocks);
+
+    // Frames freed in any order come back without touching the heap
+    void *frames[CONFIG_MEM_ARENA_MONO_FRAMES], *first_round[CONFIG_MEM_ARENA_MONO_FRAMES];
+    uint32_t rng = 7;
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < CONFIG_MEM_ARENA_MONO_FRAMES; i++) frames[i] = mem_alloc(MEM_MONO_SIZE);
+        for (int i = CONFIG_MEM_ARENA_MONO_FRAMES - 1; i > 0; i--) {
+            rng = rng * 1103515245u + 12345u;
+            int j = (rng >> 16) % (i + 1);
+            void *t = frames[i];
+            frames[i] = frames[j];
+            frames[j] = t;
+        }
+        for (int i = 0; i < CONFIG_MEM_ARENA_MONO_FRAMES; i++) mem_free(frames[i]);
+        if (round == 0) memcpy(first_round, frames, sizeof(frames));
+    }
+    for (int i = 0; i < CONFIG_MEM_ARENA_MONO_FRAMES; i++) {
+        test_checks++;
+        if (pool_of(first_round[i]) != MEM_POOL_MONO) TEST_FAIL("frame %d not from its pool", i);
+    }
+    mem_arena_stats_t after = stats();
+    CHECK_EQ(after.pools[MEM_POOL_MONO].in_use, 0);
+    CHECK_EQ(after.pools[MEM_POOL_MONO].overflows, before.pools[MEM_POOL_MONO].overflows);
+
+    // A pointer into a block, or freed twice: reported, the block stays as it is
+    uint8_t *line = mem_alloc(MEM_LINE_SIZE);
+    mem_free(line + 8);
+    CHECK_EQ(stats().pools[MEM_POOL_LINE].in_use, 1);
+    mem_free(line);
+    mem_free(line);
+    CHECK_EQ(stats().pools[MEM_POOL_LINE].in_use, 0);
+}
+
+typedef struct {
+    SemaphoreHandle_t done;
+    void *glyph, *heap;
+} other_task_t;
+
+static void other_task(void *arg)
+{
+    other_task_t *t = arg;
+    t->glyph = mem_alloc(32);
+    t->heap = mem_alloc(100000);
+    xSemaphoreGive(t->done);
+    vTaskDelete(NULL);
+}
+
+static void scopes(void)
+{
+    mem_arena_stats_t before = stats();
+
+    // What was there before the page stays
+    void *kept = mem_alloc(MEM_MONO_SIZE);
+    int page = mem_scope_enter("page");
+    CHECK(page > 0);
+    void *frame = mem_alloc(MEM_MONO_SIZE);
+    void *glyph = mem_alloc(10);
+    void *big = mem_alloc(200000);
+    mem_free(glyph);                            // Freed by the page itself: not counted
+    CHECK(frame && big);
+
+    // An alarm task allocating meanwhile is not the page's
+    other_task_t other = {xSemaphoreCreateBinary(), NULL, NULL};
+    xTaskCreatePinnedToCore(other_task, "alarm", 4096, &other, 5, NULL, 0);
+    xSemaphoreTake(other.done, portMAX_DELAY);
+
+    mem_scope_leave(page);
+    mem_arena_stats_t after = stats();
+    CHECK_EQ(after.scope_freed, before.scope_freed + 2);
+    CHECK_EQ(after.pools[MEM_POOL_MONO].in_use, 1);
+    CHECK_EQ(after.pools[MEM_POOL_GLYPH].in_use, 1);
+    CHECK_EQ(after.heap_blocks, before.heap_blocks + 1);
+    mem_free(other.glyph);
+    mem_free(other.heap);
+    // The page's own stale frees after its scope: reported, nothing touched
+    mem_free(frame);
+    mem_free(big);
+    CHECK_EQ(stats().pools[MEM_POOL_MONO].in_use, 1);
+    CHECK_EQ(stats().heap_blocks, before.heap_blocks);
+    mem_free(kept);
+
+    // Nested: the outer scope takes what an inner one left, and the inner one with it
+    int outer = mem_scope_enter("outer");
+    void *a = mem_alloc(100);
+    int inner = mem_scope_enter("inner");
+    CHECK_EQ(inner, outer + 1);
+    void *b = mem_alloc(100);
+    void *c = mem_alloc(70000);
+    mem_scope_leave(inner);
+    CHECK_EQ(stats().scope_freed, after.scope_freed + 2);
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].in_use, 1);
+    inner = mem_scope_enter("inner again");
+    CHECK_EQ(inner, outer + 1);
+    b = mem_alloc(100);
+    c = mem_alloc(MEM_LINE_SIZE);
+    void *d = mem_alloc(MEM_GRAY_SIZE + 1);
+    mem_scope_leave(outer);
+    CHECK_EQ(stats().scope_freed, after.scope_freed + 6);
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].in_use, 0);
+    CHECK_EQ(stats().pools[MEM_POOL_LINE].in_use, 0);
+    CHECK_EQ(stats().heap_blocks, before.heap_blocks);
+    (void)a;
+    (void)b;
+    (void)c;
+    (void)d;
+    // Left twice, or the inner one after its outer: ignored
+    mem_scope_leave(inner);
+    mem_scope_leave(outer);
+    mem_scope_leave(0);
+    CHECK_EQ(stats().scope_freed, after.scope_freed + 6);
+
+    // Too deep: the allocations go to the deepest scope there is
+    int stack[MEM_SCOPE_MAX];
+    for (int i = 0; i < MEM_SCOPE_MAX; i++) stack[i] = mem_scope_enter("nest");
+    CHECK_EQ(stack[MEM_SCOPE_MAX - 1], MEM_SCOPE_MAX);
+    CHECK_EQ(mem_scope_enter("too deep"), 0);
+    void *deep = mem_alloc(64);
+    mem_scope_leave(stack[MEM_SCOPE_MAX - 1]);
+    CHECK_EQ(stats().pools[MEM_POOL_GLYPH].in_use, 0);
+    (void)deep;
+    mem_scope_leave(stack[0]);
+    CHECK_EQ(mem_scope_enter("again"), 1);
+    mem_scope_leave(1);
+
+    mem_arena_stats_t end = stats();
+    for (int p = 0; p < MEM_POOL_COUNT; p++) CHECK_EQ(end.pools[p].in_use, before.pools[p].in_use);
+    CHECK_EQ(end.heap_blocks, before.heap_blocks);
+}
+
+static void out_of_memory(void)
+{
+    mem_arena_stats_t before = stats();
+
+    // Pools are reserved, so what fits one still comes while the heap is gone
+    fail_from = 1;
+    void *frame = mem_alloc(MEM_MONO_SIZE);
+    CHECK(frame != NULL);
+    CHECK(mem_alloc(MEM_GRAY_SIZE + 1) == NULL);
+    CHECK(mem_calloc(1000, 1000) == NULL);
+    mem_arena_stats_t s = stats();
+    CHECK_EQ(s.heap_blocks, before.heap_blocks);
+    CHECK_EQ(s.heap_bytes, before.heap_bytes);
+
+    // A full pool with no heap behind it: NULL, counted as an overflow
+    void *gray[CONFIG_MEM_ARENA_GRAY_FRAMES];
+    for (int i = 0; i < CONFIG_MEM_ARENA_GRAY_FRAMES; i++) gray[i] = mem_alloc(MEM_GRAY_SIZE);
+    CHECK(mem_alloc(MEM_GRAY_SIZE) == NULL);
+    CHECK_EQ(stats().pools[MEM_POOL_GRAY].overflows, before.pools[MEM_POOL_GRAY].overflows + 1);
+
+    // The heap back: the overflow is served from it, and freed like any other
+    fail_from = 0;
+    void *over = mem_alloc(MEM_GRAY_SIZE);
+    CHECK(over != NULL);
+    CHECK_EQ(stats().heap_blocks, before.heap_blocks + 1);
+    mem_free(over);
+    for (int i = 0; i < CONFIG_MEM_ARENA_GRAY_FRAMES; i++) mem_free(gray[i]);
+    mem_free(frame);
+
+    // Failing inside a scope leaves nothing to free at its end
+    int page = mem_scope_enter("page");
+    fail_from = 1;
+    CHECK(mem_alloc(1 << 20) == NULL);
+    fail_from = 0;
+    mem_scope_leave(page);
+    s = stats();
+    CHECK_EQ(s.scope_freed, before.scope_freed);
+    for (int p = 0; p < MEM_POOL_COUNT; p++) CHECK_EQ(s.pools[p].in_use, before.pools[p].in_use);
+    CHECK_EQ(s.heap_blocks, before.heap_blocks);
+}
+
+int main(void)
+{
+    TEST_RUN(init_failure);
+    TEST_RUN(routing);
+    TEST_RUN(slab_reuse);
+    TEST_RUN(scopes);
+    TEST_RUN(out_of_memory);
+    return test_done();
+}
@@ -0,0 +1,330 @@
+#include <string.h>
+#include <time.h>
+#include "pcf85063_bsp.h"
+#include "i2c_bsp.h"
+#include "driver/gpio.h"
+#include "test.h"
+
+/*
+ * components/pcf85063_bsp against a register model of the chip. The model
+ * answers i2c_read_reg()/i2c_write_reg() as the PCF85063 does, the address
+ * pointer wrapping after the last register, and can let a second pass after
+ * every transfer so that a time read register by register would come out
+ * torn across a rollover.
+ */
+
+#define REG_NUM     0x12
+
+static uint8_t regs[REG_NUM];
+static time_t clock_now;            // What the time registers hold, UTC fields
+static bool clock_ticks;            // A second passes after each transfer
+static bool bus_fails;
+static int reads, writes;
+static uint8_t last_read_reg;
+static size_t last_read_len;
+
+static uint8_t bcd(int v)
+{
+    return (uint8_t)(((v / 10) << 4) | (v % 10));
+}
+
+static time_t at(int year, int month, int day, int hour, int minute, int second)
+{
+    struct tm tm = {
+        .tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = day,
+        .tm_hour = hour, .tm_min = minute, .tm_sec = second,
+    };
+    return timegm(&tm);
+}
+
+static void clock_to_regs(void)
+{
+    struct tm tm;
+    gmtime_r(&clock_now, &tm);
+    regs[SECONDS_REG] = (regs[SECONDS_REG] & 0x80) | bcd(tm.tm_sec);
+    regs[MINUTES_REG] = bcd(tm.tm_min);
+    regs[HOURS_REG] = bcd(tm.tm_hour);
+    regs[DAYS_REG] = bcd(tm.tm_mday);
+    regs[WEEKDAYS_REG] = (uint8_t)tm.tm_wday;
+    regs[MONTHS_REG] = bcd(tm.tm_mon + 1);
+    regs[YEARS_REG] = bcd(tm.tm_year % 100);
+}
+
+static void transferred(void)
+{
+    if (clock_ticks) {
+        clock_now++;
+        clock_to_regs();
+    }
+}
+
+esp_err_t i2c_read_reg(uint8_t dev_addr, uint8_t reg, uint8_t *data, size_t len)
+{
+    CHECK_EQ(dev_addr, PCF85063Addr);
+    reads++;
+    last_read_reg = reg;
+    last_read_len = len;
+    if (bus_fails) return ESP_FAIL;
+    for (size_t i = 0; i < len; i++) data[i] = regs[(reg + i) % REG_NUM];
+    transferred();
+    return ESP_OK;
+}
+
+esp_err_t i2c_write_reg(uint8_t dev_addr, uint8_t reg, uint8_t *data, size_t len)
+{
+    CHECK_EQ(dev_addr, PCF85063Addr);
+    writes++;
+    if (bus_fails) return ESP_FAIL;
+    for (size_t i = 0; i < len; i++) regs[(reg + i) % REG_NUM] = data[i];
+    transferred();
+    return ESP_OK;
+}
+
+// The driver's INT pin setup, not exercised here
+esp_err_t gpio_config(const gpio_config_t *config) { (void)config; return ESP_OK; }
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type) { (void)gpio; (void)type; return ESP_OK; }
+esp_err_t gpio_install_isr_service(int flags) { (void)flags; return ESP_OK; }
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg)
+{
+    (void)gpio;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
+int gpio_get_level(gpio_num_t gpio) { (void)gpio; return 1; }
+
+static void reset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    clock_now = 0;
+    clock_ticks = false;
+    bus_fails = false;
+    reads = writes = 0;
+}
+
+static void check_time(Time_data t, int year, int month, int day, int week, int hour, int minute, int second)
+{
+    CHECK_EQ(t.years, year);
+    CHECK_EQ(t.months, month);
+    CHECK_EQ(t.days, day);
+    CHECK_EQ(t.week, week);
+    CHECK_EQ(t.hours, hour);
+    CHECK_EQ(t.minutes, minute);
+    CHECK_EQ(t.seconds, second);
+}
+
+static void bcd_round_trip(void)
+{
+    for (int v = 0; v < 100; v++) {
+        CHECK_EQ(DecToBcd(v), bcd(v));
+        CHECK_EQ(BcdToDec(bcd(v)), v);
+    }
+}
+
+static void decode_masks_flag_bits(void)
+{
+    // Every bit the time registers do not use is set, OS flag and century included
+    const uint8_t raw[PCF85063_TIME_REG_NUM] = {0x80 | 0x59, 0x80 | 0x59, 0xC0 | 0x23, 0xC0 | 0x31,
+                                                0xF8 | 0x06, 0xE0 | 0x12, 0x99};
+    check_time(PCF85063_DecodeTime(raw), 99, 12, 31, 6, 23, 59, 59);
+
+    const uint8_t zero[PCF85063_TIME_REG_NUM] = {0x80, 0, 0, 0x01, 0, 0x01, 0};
+    check_time(PCF85063_DecodeTime(zero), 0, 1, 1, 0, 0, 0, 0);
+}
+
+static void decode_every_field_value(void)
+{
+    uint8_t raw[PCF85063_TIME_REG_NUM] = {0, 0, 0, 1, 0, 1, 0};
+    for (int v = 0; v < 60; v++) {
+        raw[0] = bcd(v);
+        raw[1] = bcd(v);
+        Time_data t = PCF85063_DecodeTime(raw);
+        CHECK_EQ(t.seconds, v);
+        CHECK_EQ(t.minutes, v);
+    }
+    for (int h = 0; h < 24; h++) {
+        raw[2] = bcd(h);
+        CHECK_EQ(PCF85063_DecodeTime(raw).hours, h);
+    }
+    for (int d = 1; d <= 31; d++) {
+        raw[3] = bcd(d);
+        CHECK_EQ(PCF85063_DecodeTime(raw).days, d);
+    }
+    for (int m = 1; m <= 12; m++) {
+        raw[5] = bcd(m);
+        CHECK_EQ(PCF85063_DecodeTime(raw).months, m);
+    }
+    for (int y = 0; y < 100; y++) {
+        raw[6] = bcd(y);
+        CHECK_EQ(PCF85063_DecodeTime(raw).years, y);
+    }
+}
+
+// The rollovers of every field, read through the driver
+static void get_time_across_rollovers(void)
+{
+    static const struct {
+        int y, mo, d, h, mi, s;
+    } edges[] = {
+        {2024, 3, 10, 12, 0, 59},       // minute
+        {2024, 3, 10, 12, 59, 59},      // hour
+        {2024, 3, 10, 23, 59, 59},      // midnight, Sunday to Monday
+        {2024, 3, 16, 23, 59, 59},      // Saturday to Sunday
+        {2024, 4, 30, 23, 59, 59},      // 30-day month
+        {2023, 2, 28, 23, 59, 59},      // February
+        {2024, 2, 28, 23, 59, 59},      // leap day
+        {2024, 2, 29, 23, 59, 59},
+        {2099, 12, 31, 23, 59, 59},     // year and century
+    };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        reset();
+        for (int step = 0; step < 2; step++) {
+            clock_now = at(edges[i].y, edges[i].mo, edges[i].d, edges[i].h, edges[i].mi, edges[i].s) + step;
+            clock_to_regs();
+            struct tm tm;
+            gmtime_r(&clock_now, &tm);
+            check_time(PCF85063_GetTime(), tm.tm_year % 100, tm.tm_mon + 1, tm.tm_mday, tm.tm_wday, tm.tm_hour,
+                       tm.tm_min, tm.tm_sec);
+        }
+    }
+}
+
+// A second passes after every transfer: only a single burst gives a time that existed
+static void get_time_is_one_burst(void)
+{
+    reset();
+    clock_now = at(2024, 12, 31, 23, 59, 59);
+    clock_to_regs();
+    clock_ticks = true;
+    Time_data t = PCF85063_GetTime();
+    CHECK_EQ(reads, 1);
+    CHECK_EQ(last_read_reg, SECONDS_REG);
+    CHECK_EQ(last_read_len, PCF85063_TIME_REG_NUM);
+    check_time(t, 24, 12, 31, 2, 23, 59, 59);
+    t = PCF85063_GetTime();
+    check_time(t, 25, 1, 1, 3, 0, 0, 0);
+}
+
+static void get_time_bus_error(void)
+{
+    reset();
+    clock_now = at(2024, 6, 1, 8, 30, 0);
+    clock_to_regs();
+    bus_fails = true;
+    check_time(PCF85063_GetTime(), 0, 0, 0, 0, 0, 0, 0);
+}
+
+static void set_time_is_one_burst(void)
+{
+    reset();
+    Time_data t = {.years = 25, .months = 1, .days = 31, .hours = 23, .minutes = 59, .seconds = 58, .week = 5};
+    PCF85063_SetTime(t);
+    CHECK_EQ(writes, 1);
+    CHECK_EQ(regs[SECONDS_REG], 0x58);
+    CHECK_EQ(regs[MINUTES_REG], 0x59);
+    CHECK_EQ(regs[HOURS_REG], 0x23);
+    CHECK_EQ(regs[DAYS_REG], 0x31);
+    CHECK_EQ(regs[WEEKDAYS_REG], 5);
+    CHECK_EQ(regs[MONTHS_REG], 0x01);
+    CHECK_EQ(regs[YEARS_REG], 0x25);
+
+    // Out of range fields are clamped, not wrapped
+    Time_data bad = {.years = 120, .months = 13, .days = 40, .hours = 24, .minutes = 60, .seconds = 60, .week = 9};
+    PCF85063_SetTime(bad);
+    check_time(PCF85063_GetTime(), 99, 12, 31, 1, 23, 59, 59);
+}
+
+static void alarm_set_hm(void)
+{
+    reset();
+    regs[CONTROL_2_REG] = 0x40;        // A stale alarm flag
+    PCF85063_alarm_Set_HM(7, 5);
+    CHECK_EQ(regs[SECOND_ALARM_REG], 0x00);
+    CHECK_EQ(regs[MINUTES_ALARM_REG], 0x05);
+    CHECK_EQ(regs[HOUR_ARARM_REG], 0x07);
+    CHECK_EQ(regs[DAY_ALARM_REG], 0x80);        // Every day
+    CHECK_EQ(regs[WEEKDAY_ALARM_REG], 0x80);    // Every weekday
+    CHECK_EQ(regs[CONTROL_2_REG], 0x80);        // AIE on, AF cleared
+    CHECK_EQ(PCF85063_get_alarm_flag(), 0);
+
+    PCF85063_alarm_Set_HM(24, 60);              // Wraps to midnight
+    CHECK_EQ(regs[MINUTES_ALARM_REG], 0x00);
+    CHECK_EQ(regs[HOUR_ARARM_REG], 0x00);
+
+    PCF85063_alarm_Set_HM(23, 59);
+    CHECK_EQ(regs[MINUTES_ALARM_REG], 0x59);
+    CHECK_EQ(regs[HOUR_ARARM_REG], 0x23);
+}
+
+// An alarm given as the time plus an interval carries into the next day and month
+static void alarm_time_enabled_carries(void)
+{
+    static const struct {
+        Time_data in;
+        int day, hour, minute, second;
+    } cases[] = {
+        {{.years = 24, .months = 1, .days = 31, .hours = 23, .minutes = 59, .seconds = 75}, 1, 0, 0, 15},
+        {{.years = 24, .months = 4, .days = 30, .hours = 23, .minutes = 59, .seconds = 60}, 1, 0, 0, 0},
+        {{.years = 24, .months = 4, .days = 29, .hours = 23, .minutes = 59, .seconds = 60}, 30, 0, 0, 0},
+        {{.years = 23, .months = 2, .days = 28, .hours = 23, .minutes = 59, .seconds = 60}, 1, 0, 0, 0},
+        {{.years = 24, .months = 2, .days = 28, .hours = 23, .minutes = 59, .seconds = 60}, 29, 0, 0, 0},
+        {{.years = 24, .months = 2, .days = 29, .hours = 23, .minutes = 59, .seconds = 60}, 1, 0, 0, 0},
+        {{.years = 24, .months = 6, .days = 10, .hours = 12, .minutes = 30, .seconds = 10}, 10, 12, 30, 10},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        reset();
+        PCF85063_alarm_Time_Enabled(cases[i].in);
+        CHECK_EQ(regs[DAY_ALARM_REG], bcd(cases[i].day));
+        CHECK_EQ(regs[HOUR_ARARM_REG], bcd(cases[i].hour));
+        CHECK_EQ(regs[MINUTES_ALARM_REG], bcd(cases[i].minute));
+        CHECK_EQ(regs[SECOND_ALARM_REG], bcd(cases[i].second));
+        CHECK(regs[CONTROL_2_REG] & 0x80);
+    }
+
+    PCF85063_alarm_Time_Disable();
+    CHECK(regs[HOUR_ARARM_REG] & 0x80);
+    CHECK(regs[MINUTES_ALARM_REG] & 0x80);
+    CHECK(regs[SECOND_ALARM_REG] & 0x80);
+    CHECK(regs[DAY_ALARM_REG] & 0x80);
+    CHECK_EQ(regs[CONTROL_2_REG] & 0x80, 0);
+}
+
+static void alarm_flag(void)
+{
+    reset();
+    regs[CONTROL_2_REG] = 0xC0;
+    CHECK_EQ(PCF85063_get_alarm_flag(), 1);
+    PCF85063_clear_alarm_flag();
+    CHECK_EQ(PCF85063_get_alarm_flag(), 0);
+    CHECK_EQ(regs[CONTROL_2_REG], 0x80);
+}
+
+static void offset_sign_and_clamp(void)
+{
+    reset();
+    for (int v = -64; v <= 63; v++) {
+        PCF85063_offset_write((int8_t)v);
+        CHECK_EQ(regs[OFFSET_REG] & 0x80, 0);   // MODE stays normal
+        CHECK_EQ(PCF85063_offset_read(), v);
+    }
+    PCF85063_offset_write(-100);
+    CHECK_EQ(PCF85063_offset_read(), -64);
+    PCF85063_offset_write(100);
+    CHECK_EQ(PCF85063_offset_read(), 63);
+}
+
+int main(void)
+{
+    TEST_RUN(bcd_round_trip);
+    TEST_RUN(decode_masks_flag_bits);
+    TEST_RUN(decode_every_field_value);
+    TEST_RUN(get_time_across_rollovers);
+    TEST_RUN(get_time_is_one_burst);
+    TEST_RUN(get_time_bus_error);
+    TEST_RUN(set_time_is_one_burst);
+    TEST_RUN(alarm_set_hm);
+    TEST_RUN(alarm_time_enabled_carries);
+    TEST_RUN(alarm_flag);
+    TEST_RUN(offset_sign_and_clamp);
+    return test_done();
+}
@@ -0,0 +1,473 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "perf_trace.h"
+#include "test.h"
+
+/*
+ * The span trace of components/perf_trace, built here with
+ * CONFIG_PERF_TRACE_ENABLE (see CMakeLists.txt): the ring wrapping over its
+ * oldest events and counting what it wrote, the dump laid out as
+ * trace_ring.h says, tools/trace2json.py placing events from the syncs of
+ * their core across both 32-bit wraps and dropping what it cannot place,
+ * and the recorder end to end, its ring overflowed included.
+ */
+
+#define CPU_MHZ     160
+
+static char work_dir[64];
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    trace_dump_header_t header;
+    const char *tasks[8];
+    uint32_t count[portNUM_PROCESSORS], written[portNUM_PROCESSORS];
+    trace_event_t *events[portNUM_PROCESSORS];
+} dump_t;
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(*size + 1);
+    if (fread(data, 1, *size, f) != *size) *size = 0;
+    data[*size] = 0;
+    fclose(f);
+    return data;
+}
+
+// Task names come back NUL-terminated in place of the length byte after them
+static bool read_dump(const char *path, dump_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->data = read_file(path, &d->size);
+    if (!d->data || d->size < sizeof(d->header)) return false;
+    memcpy(&d->header, d->data, sizeof(d->header));
+    size_t pos = sizeof(d->header);
+    for (int i = 0; i < d->header.points + d->header.tasks && pos < d->size; i++) {
+        size_t n = d->data[pos];
+        if (i >= d->header.points && i - d->header.points < 8) {
+            memmove(d->data + pos, d->data + pos + 1, n);
+            d->data[pos + n] = 0;
+            d->tasks[i - d->header.points] = (const char *)d->data + pos;
+        }
+        pos += 1 + n;
+    }
+    for (int c = 0; c < d->header.cores && c < portNUM_PROCESSORS; c++) {
+        if (pos + 8 > d->size) return false;
+        memcpy(&d->count[c], d->data + pos, 4);
+        memcpy(&d->written[c], d->data + pos + 4, 4);
+        pos += 8;
+        d->events[c] = (trace_event_t *)(d->data + pos);
+        pos += d->count[c] * sizeof(trace_event_t);
+    }
+    return pos == d->size;
+}
+
+// Runs trace2json.py on the dump, 0 and the trace when it succeeds
+static int trace2json(const char *dump, cJSON **trace)
+{
+    char json[96], cmd[512];
+    snprintf(json, sizeof(json), "%s/trace.json", work_dir);
+    snprintf(cmd, sizeof(cmd), "%s %s %s -o %s --summary > %s/summary.txt 2>&1",
+             PYTHON, TRACE2JSON, dump, json, work_dir);
+    unlink(json);
+    int ret = system(cmd);
+    if (trace) {
+        size_t size;
+        char *text = ret == 0 ? (char *)read_file(json, &size) : NULL;
+        *trace = text ? cJSON_Parse(text) : NULL;
+        free(text);
+    }
+    return ret;
+}
+
+// The index-th event of the trace named name and of phase ph, NULL if fewer
+static cJSON *find_event(cJSON *trace, const char *name, const char *ph, int index)
+{
+    cJSON *ev;
+    cJSON_ArrayForEach(ev, cJSON_GetObjectItem(trace, "traceEvents")) {
+        if (strcmp(cJSON_GetObjectItem(ev, "name")->valuestring, name) == 0 &&
+            strcmp(cJSON_GetObjectItem(ev, "ph")->valuestring, ph) == 0 && index-- == 0) {
+            return ev;
+        }
+    }
+    return NULL;
+}
+
+static double number(cJSON *obj, const char *key)
+{
+    cJSON *item = obj ? cJSON_GetObjectItem(obj, key) : NULL;
+    return item ? item->valuedouble : -1;
+}
+
+static const char *thread_name(cJSON *trace, int tid)
+{
+    cJSON *ev;
+    cJSON_ArrayForEach(ev, cJSON_GetObjectItem(trace, "traceEvents")) {
+        if (strcmp(cJSON_GetObjectItem(ev, "name")->valuestring, "thread_name") == 0 && number(ev, "tid") == tid) {
+            return cJSON_GetObjectItem(cJSON_GetObjectItem(ev, "args"), "name")->valuestring;
+        }
+    }
+    return "";
+}
+
+static trace_event_t ev(uint32_t cycles, uint16_t id, uint8_t type, uint8_t task, int32_t value)
+{
+    return (trace_event_t){.cycles = cycles, .id = id, .type = type, .task = task, .value = value};
+}
+
+static void ring(void)
+{
+    trace_event_t mem[100], out[100];
+    trace_ring_t r;
+
+    // A power of two, rounded down
+    trace_ring_init(&r, mem, 100);
+    CHECK_EQ(r.mask, 63);
+    trace_ring_init(&r, mem, 64);
+    CHECK_EQ(r.mask, 63);
+    trace_ring_init(&r, mem, 1);
+    CHECK_EQ(r.mask, 0);
+    trace_ring_t none = {0};
+    CHECK_EQ(trace_ring_count(&none), 0);
+
+    trace_ring_init(&r, mem, 64);
+    CHECK_EQ(trace_ring_count(&r), 0);
+    for (int i = 0; i < 10; i++) {
+        trace_event_t e = ev(i, 1, TRACE_EV_INSTANT, 0, i);
+        trace_ring_push(&r, &e);
+    }
+    CHECK_EQ(trace_ring_count(&r), 10);
+    CHECK_EQ(trace_ring_read(&r, out, 100), 10);
+    CHECK_EQ(out[0].value, 0);
+    CHECK_EQ(out[9].value, 9);
+
+    // Exactly full, then over: the oldest go, head keeps counting
+    for (int i = 10; i < 64; i++) {
+        trace_event_t e = ev(i, 1, TRACE_EV_INSTANT, 0, i);
+        trace_ring_push(&r, &e);
+    }
+    CHECK(r.full);
+    CHECK_EQ(trace_ring_count(&r), 64);
+    for (int i = 64; i < 100; i++) {
+        trace_event_t e = ev(i, 1, TRACE_EV_INSTANT, 0, i);
+        trace_ring_push(&r, &e);
+    }
+    CHECK_EQ(trace_ring_count(&r), 64);
+    CHECK_EQ(r.head, 100);
+    CHECK_EQ(r.head - trace_ring_count(&r), 36);
+    CHECK_EQ(trace_ring_read(&r, out, 100), 64);
+    for (int i = 0; i < 64; i++) {
+        test_checks++;
+        if (out[i].value != 36 + i) TEST_FAIL("event %d of the ring is %d", i, (int)out[i].value);
+    }
+    // Fewer asked: the newest of them, still oldest first
+    CHECK_EQ(trace_ring_read(&r, out, 10), 10);
+    CHECK_EQ(out[0].value, 90);
+    CHECK_EQ(out[9].value, 99);
+
+    // The write counter wraps at 2^32 without losing the order
+    for (int i = 0; i < 64; i++) {
+        trace_event_t e = ev(0, 1, TRACE_EV_INSTANT, 0, -1);
+        trace_ring_push(&r, &e);
+    }
+    r.head = 0xFFFFFFF0u;
+    for (int i = 0; i < 40; i++) {
+        trace_event_t e = ev(i, 1, TRACE_EV_INSTANT, 0, i);
+        trace_ring_push(&r, &e);
+    }
+    CHECK_EQ(r.head, 40 - 16);
+    CHECK_EQ(trace_ring_count(&r), 64);
+    CHECK_EQ(trace_ring_read(&r, out, 64), 64);
+    CHECK_EQ(out[23].value, -1);
+    for (int i = 0; i < 40; i++) {
+        test_checks++;
+        if (out[24 + i].value != i) TEST_FAIL("event %d after the wrap is %d", i, (int)out[24 + i].value);
+    }
+}
+
+static void dump_layout(void)
+{
+    trace_event_t mem0[16], mem1[16];
+    trace_ring_t rings[portNUM_PROCESSORS] = {0};
+    trace_ring_init(&rings[0], mem0, 16);
+    trace_ring_init(&rings[1], mem1, 16);
+    // Wrapped on core 0, so the dump takes it in two pieces; core 1 holds three
+    for (int i = 0; i < 21; i++) {
+        trace_event_t e = ev(1000 + i, 2, TRACE_EV_COUNTER, 1, i);
+        trace_ring_push(&rings[0], &e);
+    }
+    for (int i = 0; i < 3; i++) {
+        trace_event_t e = ev(i, 3, TRACE_EV_BEGIN, 0, -i);
+        trace_ring_push(&rings[1], &e);
+    }
+    const char *points[] = {"sync", "one", "two", "three"};
+    char long_name[300];
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = 0;
+    const char *tasks[] = {"main", NULL, long_name};      // Cut at 255, what its length byte holds
+    char path[96];
+    snprintf(path, sizeof(path), "%s/layout.bin", work_dir);
+    FILE *f = fopen(path, "wb");
+    CHECK_EQ(trace_dump_write(f, CPU_MHZ * 1000000, points, 4, tasks, 3, rings, 2), 0);
+    fclose(f);
+
+    dump_t d;
+    CHECK(read_dump(path, &d));
+    CHECK_EQ(d.header.magic, TRACE_DUMP_MAGIC);
+    CHECK_EQ(d.header.version, TRACE_DUMP_VERSION);
+    CHECK_EQ(d.header.event_size, 12);
+    CHECK_EQ(d.header.cpu_hz, CPU_MHZ * 1000000);
+    CHECK_EQ(d.header.points, 4);
+    CHECK_EQ(d.header.tasks, 3);
+    CHECK_EQ(d.header.cores, 2);
+    CHECK_STR(d.tasks[0], "main");
+    CHECK_STR(d.tasks[1], "");
+    CHECK_EQ(strlen(d.tasks[2]), 255);
+    CHECK_EQ(d.count[0], 16);
+    CHECK_EQ(d.written[0], 21);
+    for (uint32_t i = 0; i < d.count[0]; i++) {
+        test_checks++;
+        if (d.events[0][i].value != (int32_t)(5 + i) || d.events[0][i].cycles != 1005 + i) {
+            TEST_FAIL("core 0 event %u is %d", (unsigned)i, (int)d.events[0][i].value);
+        }
+    }
+    CHECK_EQ(d.count[1], 3);
+    CHECK_EQ(d.written[1], 3);
+    CHECK_EQ(d.events[1][2].value, -2);
+    CHECK_EQ(d.events[1][2].type, TRACE_EV_BEGIN);
+    free(d.data);
+
+    // A full card: nothing written pretends to have succeeded
+    f = fopen("/dev/full", "wb");
+    if (f) {
+        setvbuf(f, NULL, _IONBF, 0);
+        CHECK_EQ(trace_dump_write(f, 1, points, 4, tasks, 3, rings, 2), -1);
+        fclose(f);
+    }
+}
+
+static void converter(void)
+{
+    // Core 0's cycle counter wraps between a begin and its end, the microsecond
+    // clock's low 32 bits between its two syncs
+    const uint32_t c0 = 0xFFFFE000u, c0b = 0x10000, c1 = 5000;
+    trace_event_t core0[] = {
+        ev(100, 1, TRACE_EV_BEGIN, 0, 0),                   // Before any sync: dropped
+        ev(c0, 0, TRACE_EV_SYNC, 0, -100),
+        ev(c0 + CPU_MHZ * 10, 1, TRACE_EV_BEGIN, 0, 7),     // 10 us
+        ev(0x800, 1, TRACE_EV_END, 0, 0),                   // 64 us
+        ev(0x800 + CPU_MHZ * 6, 3, TRACE_EV_COUNTER, 0, 42),
+        ev(0x800 + CPU_MHZ * 20, 2, TRACE_EV_END, 1, 0),    // Its begin overwritten: dropped
+        ev(c0b, 0, TRACE_EV_SYNC, 0, 300),                  // 400 us
+        ev(c0b + CPU_MHZ * 5, 2, TRACE_EV_INSTANT, TRACE_TASK_ISR, 9),
+    };
+    trace_event_t core1[] = {
+        ev(c1, 0, TRACE_EV_SYNC, 1, -80),                   // 20 us
+        ev(c1 + CPU_MHZ * 15, 2, TRACE_EV_BEGIN, 1, 0),
+        ev(c1 + CPU_MHZ * 45, 2, TRACE_EV_END, 1, 0),
+        ev(c1 + CPU_MHZ * 52, 3, TRACE_EV_COUNTER, TRACE_TASK_OTHER, -5),
+    };
+    trace_ring_t rings[2];
+    trace_event_t mem0[8], mem1[4];
+    trace_ring_init(&rings[0], mem0, 8);
+    trace_ring_init(&rings[1], mem1, 4);
+    for (size_t i = 0; i < 8; i++) trace_ring_push(&rings[0], &core0[i]);
+    for (size_t i = 0; i < 4; i++) trace_ring_push(&rings[1], &core1[i]);
+
+    const char *points[] = {"sync", "epd.spi", "font.read", "i2c.wait_us"};
+    const char *tasks[] = {"main", "preload"};
+    char path[96];
+    snprintf(path, sizeof(path), "%s/converter.bin", work_dir);
+    FILE *f = fopen(path, "wb");
+    trace_dump_write(f, CPU_MHZ * 1000000, points, 4, tasks, 2, rings, 2);
+    fclose(f);
+
+    cJSON *trace;
+    CHECK_EQ(trace2json(path, &trace), 0);
+    CHECK(trace != NULL);
+    if (!trace) return;
+    cJSON *other = cJSON_GetObjectItem(trace, "otherData");
+    CHECK_EQ(number(other, "dropped"), 2);
+    CHECK_EQ(number(other, "cpu_hz"), CPU_MHZ * 1000000);
+    // process_name, three threads and seven events
+    CHECK_EQ(cJSON_GetArraySize(cJSON_GetObjectItem(trace, "traceEvents")), 11);
+    CHECK_STR(thread_name(trace, 0), "main");
+    CHECK_STR(thread_name(trace, 1), "preload");
+    CHECK_STR(thread_name(trace, TRACE_TASK_ISR), "ISR");
+
+    cJSON *b = find_event(trace, "epd.spi", "B", 0), *e = find_event(trace, "epd.spi", "E", 0);
+    CHECK_NEAR(number(b, "ts"), 0, 1e-6);
+    CHECK_EQ(number(cJSON_GetObjectItem(b, "args"), "arg"), 7);
+    CHECK_NEAR(number(e, "ts"), 54, 1e-6);
+    CHECK_EQ(number(e, "tid"), 0);
+    b = find_event(trace, "font.read", "B", 0);
+    e = find_event(trace, "font.read", "E", 0);
+    CHECK_NEAR(number(b, "ts"), 25, 1e-6);
+    CHECK_EQ(number(cJSON_GetObjectItem(b, "args"), "core"), 1);
+    CHECK(cJSON_GetObjectItem(cJSON_GetObjectItem(b, "args"), "arg") == NULL);
+    CHECK_NEAR(number(e, "ts"), 55, 1e-6);
+    CHECK(find_event(trace, "font.read", "E", 1) == NULL);
+    cJSON *c = find_event(trace, "i2c.wait_us", "C", 0);
+    CHECK_NEAR(number(c, "ts"), 60, 1e-6);
+    CHECK_EQ(number(cJSON_GetObjectItem(c, "args"), "i2c.wait_us"), 42);
+    c = find_event(trace, "i2c.wait_us", "C", 1);
+    CHECK_NEAR(number(c, "ts"), 62, 1e-6);
+    CHECK_EQ(number(cJSON_GetObjectItem(c, "args"), "i2c.wait_us"), -5);
+    cJSON *i = find_event(trace, "font.read", "i", 0);
+    CHECK_NEAR(number(i, "ts"), 395, 1e-6);
+    CHECK_EQ(number(i, "tid"), TRACE_TASK_ISR);
+
+    // In time order across the cores
+    double last = -1;
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(trace, "traceEvents")) {
+        if (strcmp(cJSON_GetObjectItem(item, "ph")->valuestring, "M") == 0) continue;
+        test_checks++;
+        if (number(item, "ts") < last) TEST_FAIL("%s at %g after %g", cJSON_GetObjectItem(item, "name")->valuestring,
+                                                 number(item, "ts"), last);
+        last = number(item, "ts");
+    }
+    cJSON_Delete(trace);
+
+    // The summary has both spans
+    char summary[96];
+    size_t size;
+    snprintf(summary, sizeof(summary), "%s/summary.txt", work_dir);
+    char *text = (char *)read_file(summary, &size);
+    CHECK(text && strstr(text, "\nepd.spi ") && strstr(text, "\nfont.read "));
+    free(text);
+
+    // Not a dump, or cut short: an error, not a trace
+    size_t n;
+    uint8_t *data = read_file(path, &n);
+    f = fopen(path, "wb");
+    fwrite(data, 1, n - 5, f);
+    fclose(f);
+    CHECK(trace2json(path, NULL) != 0);
+    data[0] ^= 1;
+    f = fopen(path, "wb");
+    fwrite(data, 1, n, f);
+    fclose(f);
+    CHECK(trace2json(path, NULL) != 0);
+    free(data);
+}
+
+typedef struct {
+    SemaphoreHandle_t done;
+    int job;
+} preload_t;
+
+static void preload_task(void *arg)
+{
+    preload_t *p = arg;
+    TRACE_BEGIN_ARG(FICTION_PRELOAD, p->job);
+    TRACE_END(FICTION_PRELOAD);
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+static void recorder(void)
+{
+    char path[96];
+    snprintf(path, sizeof(path), "%s/trace.bin", work_dir);
+    CHECK_EQ(trace_dump(path), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(trace_start(), ESP_OK);
+
+    TRACE_BEGIN(FICTION_TURN);
+    vTaskDelay(1);
+    TRACE_BEGIN_ARG(FONT_READ, 5);
+    TRACE_END(FONT_READ);
+    TRACE_END(FICTION_TURN);
+    TRACE_COUNTER(I2C_WAIT_US, 123);
+    // A task per job: the same name is the same thread
+    preload_t p = {xSemaphoreCreateBinary(), 0};
+    for (p.job = 1; p.job <= 2; p.job++) {
+        xTaskCreate(preload_task, "preload", 4096, &p, 5, NULL);
+        xSemaphoreTake(p.done, portMAX_DELAY);
+    }
+    CHECK_EQ(trace_dump(path), ESP_OK);
+
+    dump_t d;
+    CHECK(read_dump(path, &d));
+    CHECK_EQ(d.header.points, TRACE_POINT_COUNT);
+    CHECK_EQ(d.header.tasks, 2);
+    CHECK_STR(d.tasks[0], "main");
+    CHECK_STR(d.tasks[1], "preload");
+    CHECK_EQ(d.header.cores, portNUM_PROCESSORS);
+    CHECK_EQ(d.count[1], 0);
+    CHECK_EQ(d.events[0][0].type, TRACE_EV_SYNC);
+    int events = 0;
+    for (uint32_t i = 0; i < d.count[0]; i++) events += d.events[0][i].type != TRACE_EV_SYNC;
+    CHECK_EQ(events, 9);
+    CHECK_EQ(d.written[0], d.count[0]);
+    free(d.data);
+
+    cJSON *trace;
+    CHECK_EQ(trace2json(path, &trace), 0);
+    if (trace) {
+        CHECK_EQ(number(cJSON_GetObjectItem(trace, "otherData"), "dropped"), 0);
+        cJSON *b = find_event(trace, "fiction.turn", "B", 0), *e = find_event(trace, "fiction.turn", "E", 0);
+        CHECK(number(e, "ts") - number(b, "ts") >= portTICK_PERIOD_MS * 1000);
+        CHECK(find_event(trace, "font.read", "E", 0) != NULL);
+        cJSON *second = find_event(trace, "fiction.preload", "B", 1);
+        CHECK_EQ(number(second, "tid"), 1);
+        CHECK_EQ(number(cJSON_GetObjectItem(second, "args"), "arg"), 2);
+        CHECK_STR(thread_name(trace, 1), "preload");
+        cJSON_Delete(trace);
+    }
+
+    // Recording goes on after a dump; far more than the ring holds
+    for (int i = 0; i < 500; i++) TRACE_INSTANT(PAGE, i);
+    CHECK_EQ(trace_dump(path), ESP_OK);
+    CHECK(read_dump(path, &d));
+    uint32_t capacity = d.count[0];
+    CHECK_EQ(capacity, 64);
+    CHECK(d.written[0] - capacity >= 9 + 500 - 64);
+    CHECK_EQ(d.events[0][capacity - 1].value, 499);
+    // Events before the first sync left cannot be placed, a sync every half ring keeps them few
+    uint32_t first_sync = capacity;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (d.events[0][i].type == TRACE_EV_SYNC) {
+            first_sync = i;
+            break;
+        }
+        test_checks++;
+        if (i > 0 && d.events[0][i].value != d.events[0][i - 1].value + 1) TEST_FAIL("instant %u out of order", i);
+    }
+    CHECK(first_sync <= capacity / 2);
+    free(d.data);
+    CHECK_EQ(trace2json(path, &trace), 0);
+    if (trace) {
+        CHECK_EQ(number(cJSON_GetObjectItem(trace, "otherData"), "dropped"), first_sync);
+        CHECK(find_event(trace, "page", "i", 0) != NULL);
+        cJSON_Delete(trace);
+    }
+}
+
+int main(void)
+{
+    strcpy(work_dir, "/tmp/test_perf_trace.XXXXXX");
+    if (!mkdtemp(work_dir)) return 1;
+
+    TEST_RUN(ring);
+    TEST_RUN(dump_layout);
+    TEST_RUN(converter);
+    TEST_RUN(recorder);
+
+    int ret = test_done();
+    if (ret == 0) {
+        char cmd[96];
+        snprintf(cmd, sizeof(cmd), "rm -rf %s", work_dir);
+        if (system(cmd) != 0) return 1;
+    }
+    return ret;
+}
@@ -0,0 +1,321 @@
+#include <string.h>
+#include "qmi8658_bsp.h"
+#include "i2c_bsp.h"
+#include "driver/gpio.h"
+#include "test.h"
+
+/*
+ * The FIFO path of components/qmi8658_bsp: QMI8658_fifo_decode() on FIFO
+ * dumps, and QMI8658_read_fifo() against a model of the chip's FIFO and
+ * CTRL9 handshake. The dumps are built from known samples the way the
+ * sensor lays them out, a frame being 6 bytes of accelerometer and 6 of
+ * gyroscope, little endian: a board lying still (1 g on z), then turned.
+ */
+
+#define REG_NUM     0x80
+#define FIFO_BYTES  (QMI8658_FIFO_MAX_SAMPLES * 12)
+
+static uint8_t regs[REG_NUM];
+static uint8_t fifo[FIFO_BYTES + 12];
+static int fifo_len, fifo_pos;
+static uint8_t fifo_status;         // Flags of FIFO_STATUS besides the count
+static bool ctrl9_answers;
+static uint8_t ctrl9_log[16];
+static int ctrl9_count;
+static size_t last_data_read;
+
+esp_err_t i2c_read_reg(uint8_t dev_addr, uint8_t reg, uint8_t *data, size_t len)
+{
+    CHECK_EQ(dev_addr, QMI8658_SLAVE_ADDR_L);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t r = (uint8_t)(reg + i);
+        if (reg == QMI8658_REG_FIFO_DATA) {
+            // The data register does not advance, each read pops the next byte
+            data[i] = fifo_pos < fifo_len ? fifo[fifo_pos++] : 0;
+            continue;
+        }
+        int words = (fifo_len - fifo_pos) / 2;
+        if (r == QMI8658_REG_FIFO_COUNT)
+            data[i] = (uint8_t)words;
+        else if (r == QMI8658_REG_FIFO_STATUS)
+            data[i] = fifo_status | (uint8_t)((words >> 8) & 0x03);
+        else
+            data[i] = regs[r % REG_NUM];
+    }
+    if (reg == QMI8658_REG_FIFO_DATA) last_data_read = len;
+    return ESP_OK;
+}
+
+esp_err_t i2c_write_reg(uint8_t dev_addr, uint8_t reg, uint8_t *data, size_t len)
+{
+    CHECK_EQ(dev_addr, QMI8658_SLAVE_ADDR_L);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t r = (uint8_t)(reg + i);
+        regs[r % REG_NUM] = data[i];
+        if (r != QMI8658Register_Ctrl9) continue;
+        // CmdDone is raised for a command and dropped by the NOP that acknowledges it
+        if (data[i] == QMI8658_Ctrl9_Cmd_NOP) {
+            regs[QMI8658Register_StatusInt] &= 0x7F;
+        } else {
+            if (ctrl9_count < (int)sizeof(ctrl9_log)) ctrl9_log[ctrl9_count++] = data[i];
+            if (ctrl9_answers) regs[QMI8658Register_StatusInt] |= 0x80;
+            if (data[i] == QMI8658_Ctrl9_Cmd_Rst_Fifo) fifo_len = fifo_pos = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config) { (void)config; return ESP_OK; }
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type) { (void)gpio; (void)type; return ESP_OK; }
+esp_err_t gpio_install_isr_service(int flags) { (void)flags; return ESP_OK; }
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg)
+{
+    (void)gpio;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio) { (void)gpio; return ESP_OK; }
+int gpio_get_level(gpio_num_t gpio) { (void)gpio; return 0; }
+
+// Raw acc x, y, z then gyro x, y, z of sample i
+static void raw_sample(int i, int16_t raw[6])
+{
+    static const int16_t still[6] = {-23, 41, 4102, 3, -5, 1};     // +-8g, +-512dps
+    for (int k = 0; k < 6; k++) raw[k] = still[k];
+    raw[0] += (int16_t)((i * 7) % 13 - 6);
+    raw[2] += (int16_t)((i * 5) % 9 - 4);
+    if (i >= 40) {
+        // Turning about x, rates up to the ends of the range
+        raw[1] = (int16_t)(i * 700 - 32768);
+        raw[2] = (int16_t)(4096 - (i - 40) * 97);
+        raw[3] = (int16_t)(i % 2 ? 32767 : -32768);
+        raw[4] = (int16_t)(-(i * 331));
+        raw[5] = (int16_t)(i * 113);
+    }
+}
+
+static int fill(int samples, int extra_bytes)
+{
+    fifo_len = fifo_pos = 0;
+    for (int i = 0; i < samples; i++) {
+        int16_t raw[6];
+        raw_sample(i, raw);
+        for (int k = 0; k < 6; k++) {
+            fifo[fifo_len++] = (uint8_t)(raw[k] & 0xFF);
+            fifo[fifo_len++] = (uint8_t)((uint16_t)raw[k] >> 8);
+        }
+    }
+    for (int i = 0; i < extra_bytes; i++) fifo[fifo_len++] = (uint8_t)(0xA0 + i);
+    return fifo_len;
+}
+
+static int32_t floor_div(int32_t a, int32_t b)
+{
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+static void check_sample(const qmi8658_sample_t *s, int i, int acc_shift, int gyro_shift)
+{
+    int16_t raw[6];
+    raw_sample(i, raw);
+    for (int k = 0; k < 3; k++) CHECK_EQ(s->acc_mg[k], floor_div(raw[k] * 1000, 1 << acc_shift));
+    // Gyroscope x and y swapped as in QMI8658_read_xyz
+    CHECK_EQ(s->gyro_mdps[1], floor_div(raw[3] * 1000, 1 << gyro_shift));
+    CHECK_EQ(s->gyro_mdps[0], floor_div(raw[4] * 1000, 1 << gyro_shift));
+    CHECK_EQ(s->gyro_mdps[2], floor_div(raw[5] * 1000, 1 << gyro_shift));
+}
+
+static void reset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    fifo_len = fifo_pos = 0;
+    fifo_status = 0;
+    ctrl9_answers = true;
+    ctrl9_count = 0;
+    last_data_read = 0;
+}
+
+static void decode_units(void)
+{
+    static qmi8658_sample_t out[QMI8658_FIFO_MAX_SAMPLES];
+    int bytes = fill(QMI8658_FIFO_MAX_SAMPLES, 0);
+    static const int shifts[][2] = {{14, 10}, {11, 3}, {12, 6}};
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+        int n = QMI8658_fifo_decode(fifo, bytes, shifts[s][0], shifts[s][1], out, QMI8658_FIFO_MAX_SAMPLES);
+        CHECK_EQ(n, QMI8658_FIFO_MAX_SAMPLES);
+        for (int i = 0; i < n; i++) check_sample(&out[i], i, shifts[s][0], shifts[s][1]);
+    }
+    // Lying still at +-8g: about 1 g on z
+    CHECK_NEAR(out[0].acc_mg[2], 1000, 5);
+}
+
+static void decode_partial_frame(void)
+{
+    qmi8658_sample_t out[8];
+    memset(out, 0x5A, sizeof(out));
+    for (int extra = 0; extra < 12; extra++) {
+        int bytes = fill(5, extra);
+        CHECK_EQ(QMI8658_fifo_decode(fifo, bytes, 12, 6, out, 8), 5);
+        for (int i = 0; i < 5; i++) check_sample(&out[i], i, 12, 6);
+    }
+    // Nothing is written past the last whole frame
+    uint8_t pattern[sizeof(qmi8658_sample_t)];
+    memset(pattern, 0x5A, sizeof(pattern));
+    CHECK_MEM(&out[5], pattern, sizeof(pattern));
+    CHECK_EQ(QMI8658_fifo_decode(fifo, 11, 12, 6, out, 8), 0);
+    CHECK_EQ(QMI8658_fifo_decode(fifo, 0, 12, 6, out, 8), 0);
+}
+
+static void decode_stops_at_max(void)
+{
+    qmi8658_sample_t out[4 + 1];
+    memset(out, 0x5A, sizeof(out));
+    int bytes = fill(16, 0);
+    CHECK_EQ(QMI8658_fifo_decode(fifo, bytes, 12, 6, out, 4), 4);
+    uint8_t pattern[sizeof(qmi8658_sample_t)];
+    memset(pattern, 0x5A, sizeof(pattern));
+    CHECK_MEM(&out[4], pattern, sizeof(pattern));
+}
+
+static void configure(enum QMI8658_FifoSize size, unsigned char watermark, enum QMI8658_Interrupt pin)
+{
+    reset();
+    QMI8658_config_acc(QMI8658AccRange_8g, QMI8658AccOdr_250Hz, QMI8658Lpf_Disable, QMI8658St_Disable);
+    QMI8658_config_gyro(QMI8658GyrRange_512dps, QMI8658GyrOdr_250Hz, QMI8658Lpf_Disable, QMI8658St_Disable);
+    regs[QMI8658Register_Ctrl7] = QMI8658_CTRL7_ACC_ENABLE | QMI8658_CTRL7_GYR_ENABLE;
+    CHECK_EQ(QMI8658_config_fifo(QMI8658Fifo_Stream, size, watermark, pin), 1);
+    ctrl9_count = 0;
+}
+
+static void config_registers(void)
+{
+    configure(QMI8658FifoSize_64, 32, QMI8658_Int1);
+    CHECK_EQ(regs[QMI8658_REG_FIFO_CTRL], QMI8658FifoSize_64 | QMI8658Fifo_Stream);
+    CHECK_EQ(regs[QMI8658_REG_FIFO_WTM_TH], 32);
+    CHECK_EQ(regs[QMI8658Register_Ctrl1] & 0x1C, 0x0C);        // FIFO interrupt on INT1, INT1 enabled
+    CHECK_EQ(regs[QMI8658Register_Ctrl7], QMI8658_CTRL7_ACC_ENABLE | QMI8658_CTRL7_GYR_ENABLE);
+
+    configure(QMI8658FifoSize_128, 100, QMI8658_Int2);
+    CHECK_EQ(regs[QMI8658_REG_FIFO_CTRL], QMI8658FifoSize_128 | QMI8658Fifo_Stream);
+    CHECK_EQ(regs[QMI8658Register_Ctrl1] & 0x1C, 0x10);        // INT2
+
+    // The reset fails: sensors are turned back on, the FIFO is left alone
+    reset();
+    regs[QMI8658Register_Ctrl7] = QMI8658_CTRL7_ACC_ENABLE;
+    regs[QMI8658_REG_FIFO_CTRL] = 0x33;
+    ctrl9_answers = false;
+    CHECK_EQ(QMI8658_config_fifo(QMI8658Fifo_Stream, QMI8658FifoSize_16, 8, QMI8658_Int1), 0);
+    CHECK_EQ(regs[QMI8658Register_Ctrl7], QMI8658_CTRL7_ACC_ENABLE);
+    CHECK_EQ(regs[QMI8658_REG_FIFO_CTRL], 0x33);
+}
+
+// The interrupt came at the watermark, the FIFO holds exactly that
+static void read_at_watermark(void)
+{
+    static qmi8658_sample_t out[QMI8658_FIFO_MAX_SAMPLES];
+    configure(QMI8658FifoSize_64, 32, QMI8658_Int1);
+    fill(32, 0);
+    fifo_status = QMI8658_FIFO_STATUS_WTM | QMI8658_FIFO_STATUS_NOT_EMPTY;
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), 32);
+    for (int i = 0; i < 32; i++) check_sample(&out[i], i, 12, 6);
+    CHECK_EQ(last_data_read, 32 * 12);
+    CHECK_EQ(ctrl9_count, 1);
+    CHECK_EQ(ctrl9_log[0], QMI8658_Ctrl9_Cmd_Req_Fifo);
+    CHECK_EQ(regs[QMI8658Register_StatusInt] & 0x80, 0);       // Acknowledged
+    CHECK_EQ(regs[QMI8658_REG_FIFO_CTRL], QMI8658FifoSize_64 | QMI8658Fifo_Stream);
+    CHECK_EQ(fifo_pos, fifo_len);
+
+    // Nothing new: no CTRL9 request and no data read
+    fifo_status = 0;
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), 0);
+    CHECK_EQ(ctrl9_count, 1);
+}
+
+// A frame was still being written when the count was read
+static void read_partial_frame(void)
+{
+    static qmi8658_sample_t out[QMI8658_FIFO_MAX_SAMPLES];
+    configure(QMI8658FifoSize_64, 16, QMI8658_Int1);
+    fill(17, 6);
+    fifo_status = QMI8658_FIFO_STATUS_WTM | QMI8658_FIFO_STATUS_NOT_EMPTY;
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), 17);
+    CHECK_EQ(last_data_read, 17 * 12);
+    for (int i = 0; i < 17; i++) check_sample(&out[i], i, 12, 6);
+
+    // Less than a frame: left for the next interrupt
+    configure(QMI8658FifoSize_64, 16, QMI8658_Int1);
+    fill(0, 10);
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), 0);
+    CHECK_EQ(ctrl9_count, 0);
+    CHECK_EQ(fifo_pos, 0);
+}
+
+// Stream mode overwrote old samples: a full FIFO comes out, clipped to what the caller takes
+static void read_after_overflow(void)
+{
+    static qmi8658_sample_t out[QMI8658_FIFO_MAX_SAMPLES];
+    configure(QMI8658FifoSize_128, 64, QMI8658_Int1);
+    fill(QMI8658_FIFO_MAX_SAMPLES, 0);
+    fifo_status = QMI8658_FIFO_STATUS_FULL | QMI8658_FIFO_STATUS_OVERFLOW | QMI8658_FIFO_STATUS_WTM |
+                  QMI8658_FIFO_STATUS_NOT_EMPTY;
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), QMI8658_FIFO_MAX_SAMPLES);
+    CHECK_EQ(last_data_read, FIFO_BYTES);
+    for (int i = 0; i < QMI8658_FIFO_MAX_SAMPLES; i++) check_sample(&out[i], i, 12, 6);
+
+    configure(QMI8658FifoSize_128, 64, QMI8658_Int1);
+    fill(QMI8658_FIFO_MAX_SAMPLES, 0);
+    fifo_status = QMI8658_FIFO_STATUS_FULL | QMI8658_FIFO_STATUS_OVERFLOW;
+    CHECK_EQ(QMI8658_read_fifo(out, 50), 50);
+    CHECK_EQ(last_data_read, 50 * 12);
+    for (int i = 0; i < 50; i++) check_sample(&out[i], i, 12, 6);
+}
+
+static void read_without_handshake(void)
+{
+    static qmi8658_sample_t out[QMI8658_FIFO_MAX_SAMPLES];
+    configure(QMI8658FifoSize_64, 32, QMI8658_Int1);
+    fill(32, 0);
+    ctrl9_answers = false;
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), -1);
+    CHECK_EQ(last_data_read, 0);
+
+    // In bypass mode there is no FIFO to read
+    reset();
+    CHECK_EQ(QMI8658_config_fifo(QMI8658Fifo_Bypass, QMI8658FifoSize_16, 0, QMI8658_Int1), 1);
+    fill(4, 0);
+    CHECK_EQ(QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES), -1);
+}
+
+// The same handshake serves the wake-on-motion command
+static void wake_on_motion(void)
+{
+    reset();
+    QMI8658_enableWakeOnMotion();
+    CHECK_EQ(ctrl9_count, 1);
+    CHECK_EQ(ctrl9_log[0], QMI8658_Ctrl9_Cmd_WoM_Setting);
+    CHECK_EQ(regs[QMI8658Register_Cal1_L], QMI8658WomThreshold_low);
+    CHECK_EQ(regs[QMI8658Register_StatusInt] & 0x80, 0);
+    CHECK_EQ(regs[QMI8658Register_Ctrl7], QMI8658_CTRL7_ACC_ENABLE);
+
+    // Not taken: the accelerometer is left off rather than armed without WoM
+    reset();
+    ctrl9_answers = false;
+    QMI8658_enableWakeOnMotion();
+    CHECK_EQ(ctrl9_count, 1);
+    CHECK_EQ(regs[QMI8658Register_Ctrl7], QMI8658_CTRL7_DISABLE_ALL);
+}
+
+int main(void)
+{
+    TEST_RUN(decode_units);
+    TEST_RUN(decode_partial_frame);
+    TEST_RUN(decode_stops_at_max);
+    TEST_RUN(config_registers);
+    TEST_RUN(read_at_watermark);
+    TEST_RUN(read_partial_frame);
+    TEST_RUN(read_after_overflow);
+    TEST_RUN(read_without_handshake);
+    TEST_RUN(wake_on_motion);
+    return test_done();
+}
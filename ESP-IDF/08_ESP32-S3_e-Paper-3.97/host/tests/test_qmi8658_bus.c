@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <string.h>
+#include "qmi8658_bsp.h"
+#include "i2c_bsp.h"
+#include "driver/gpio.h"
+#include "mock_i2c.h"
+#include "test.h"
+
+/*
+ * The I2C traffic of components/qmi8658_bsp, counted by the i2c_bsp
+ * statistics with a model of the chip on the mock bus (mock_i2c.c). Eight
+ * seconds of the six-axis page at 62.5 Hz are read twice: a QMI8658_read_xyz()
+ * per sample as the polling loop would need to see every sample, then a
+ * QMI8658_read_fifo() per 32-sample watermark as the FIFO stream does.
+ */
+
+#define ODR_HZ      62.5
+#define SECONDS     8
+#define WATERMARK   32
+
+static uint8_t regs[0x80];
+static uint8_t fifo[QMI8658_FIFO_MAX_SAMPLES * 12];
+static int fifo_len, fifo_pos;
+
+// Register reads and writes as the chip sees them, the register address first
+static esp_err_t qmi8658_model(const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len)
+{
+    if (tx_len == 0) return ESP_ERR_INVALID_ARG;
+    uint8_t reg = tx[0];
+    for (size_t i = 1; i < tx_len; i++) {
+        uint8_t r = (uint8_t)(reg + i - 1) & 0x7F;
+        regs[r] = tx[i];
+        if (r != QMI8658Register_Ctrl9) continue;
+        if (tx[i] == QMI8658_Ctrl9_Cmd_NOP) {
+            regs[QMI8658Register_StatusInt] &= 0x7F;
+        } else {
+            regs[QMI8658Register_StatusInt] |= 0x80;
+            if (tx[i] == QMI8658_Ctrl9_Cmd_Rst_Fifo) fifo_len = fifo_pos = 0;
+        }
+    }
+    for (size_t i = 0; i < rx_len; i++) {
+        uint8_t r = (uint8_t)(reg + i) & 0x7F;
+        int words = (fifo_len - fifo_pos) / 2;
+        if (reg == QMI8658_REG_FIFO_DATA)
+            rx[i] = fifo_pos < fifo_len ? fifo[fifo_pos++] : 0;
+        else if (r == QMI8658_REG_FIFO_COUNT)
+            rx[i] = (uint8_t)words;
+        else if (r == QMI8658_REG_FIFO_STATUS)
+            rx[i] = (uint8_t)((words >> 8) & 0x03);
+        else
+            rx[i] = regs[r];
+    }
+    if (reg == QMI8658_REG_FIFO_DATA && fifo_pos == fifo_len) fifo_len = fifo_pos = 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config) { (void)config; return ESP_OK; }
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type) { (void)gpio; (void)type; return ESP_OK; }
+esp_err_t gpio_install_isr_service(int flags) { (void)flags; return ESP_OK; }
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg)
+{
+    (void)gpio;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio) { (void)gpio; return ESP_OK; }
+int gpio_get_level(gpio_num_t gpio) { (void)gpio; return 0; }
+
+// A board lying still: 1 g on z at +-8g
+static const uint8_t frame[12] = {0xE9, 0xFF, 0x29, 0x00, 0x06, 0x10, 0x03, 0x00, 0xFB, 0xFF, 0x01, 0x00};
+
+static void push_sample(void)
+{
+    memcpy(fifo + fifo_len, frame, sizeof(frame));
+    fifo_len += sizeof(frame);
+}
+
+static i2c_dev_stats_t qmi8658_stats(void)
+{
+    i2c_dev_stats_t stats[I2C_BSP_MAX_DEVICES], none = {0};
+    int n = i2c_bsp_get_stats(stats, I2C_BSP_MAX_DEVICES);
+    for (int i = 0; i < n; i++) {
+        if (stats[i].addr == QMI8658_SLAVE_ADDR_L) return stats[i];
+    }
+    return none;
+}
+
+static void stream_config(void)
+{
+    QMI8658_config_acc(QMI8658AccRange_8g, QMI8658AccOdr_62_5Hz, QMI8658Lpf_Enable, QMI8658St_Disable);
+    QMI8658_config_gyro(QMI8658GyrRange_512dps, QMI8658GyrOdr_62_5Hz, QMI8658Lpf_Enable, QMI8658St_Disable);
+}
+
+static double polled_rate, fifo_rate;
+
+static void polling(void)
+{
+    int samples = (int)(ODR_HZ * SECONDS);
+    float acc[3], gyro[3];
+
+    stream_config();
+    memcpy(regs + QMI8658Register_Ax_L, frame, sizeof(frame));
+    i2c_dev_stats_t before = qmi8658_stats();
+    for (int i = 0; i < samples; i++) {
+        QMI8658_read_xyz(acc, gyro, NULL);
+    }
+    i2c_dev_stats_t after = qmi8658_stats();
+
+    CHECK_EQ(after.transactions - before.transactions, samples);
+    CHECK_EQ(after.errors, before.errors);
+    CHECK_NEAR(acc[2], 1000.0f, 10.0f);
+    polled_rate = (double)(after.transactions - before.transactions) / SECONDS;
+    printf("polling: %.1f transactions/s, %.0f bytes/s\n", polled_rate,
+           (double)(after.bytes - before.bytes) / SECONDS);
+}
+
+static void fifo_stream(void)
+{
+    static qmi8658_sample_t out[QMI8658_FIFO_MAX_SAMPLES];
+    int batches = (int)(ODR_HZ * SECONDS) / WATERMARK;
+
+    stream_config();
+    CHECK(QMI8658_config_fifo(QMI8658Fifo_Stream, QMI8658FifoSize_64, WATERMARK, QMI8658_Int1));
+    i2c_dev_stats_t before = qmi8658_stats();
+    int delivered = 0;
+    for (int b = 0; b < batches; b++) {
+        for (int i = 0; i < WATERMARK; i++) push_sample();
+        int n = QMI8658_read_fifo(out, QMI8658_FIFO_MAX_SAMPLES);
+        if (n != WATERMARK) {
+            test_checks++;
+            TEST_FAIL("batch %d: %d samples", b, n);
+            return;
+        }
+        delivered += n;
+    }
+    i2c_dev_stats_t after = qmi8658_stats();
+
+    CHECK_EQ(delivered, batches * WATERMARK);
+    CHECK_EQ(after.errors, before.errors);
+    CHECK_EQ(out[0].acc_mg[2], 1001);
+    // FIFO_COUNT, CTRL9 request, CmdDone, NOP, CmdDone cleared, the burst, FIFO_CTRL
+    CHECK_EQ(after.transactions - before.transactions, batches * 7);
+    fifo_rate = (double)(after.transactions - before.transactions) / SECONDS;
+    printf("fifo:    %.1f transactions/s, %.0f bytes/s\n", fifo_rate,
+           (double)(after.bytes - before.bytes) / SECONDS);
+
+    // Same samples for less than a quarter of the transactions
+    CHECK(fifo_rate * 4 < polled_rate);
+}
+
+int main(void)
+{
+    i2c_master_init();
+    mock_i2c_device(QMI8658_SLAVE_ADDR_L, qmi8658_model);
+    TEST_RUN(polling);
+    TEST_RUN(fifo_stream);
+    return test_done();
+}
@@ -0,0 +1,362 @@
+#include <stdlib.h>
+#include "text_layout.h"
+#include "test.h"
+
+/*
+ * The line breaker of components/text_layout with widths from a callback:
+ * exact breaks of small Latin, CJK and mixed paragraphs, kinsoku (no closing
+ * punctuation, small kana or iteration marks at the start of a line, no
+ * opening bracket at its end) over a sweep of widths, how the slack of a line
+ * is spread, hyphenation, and the same lines when the text arrives in chunks
+ * as the reader feeds it.
+ */
+
+#define EM          20
+#define MAX_LINES   256
+
+// ASCII 10 px with narrow punctuation, space 5, hyphen 6, everything else an em; AV kerned
+static int advance(void *ctx, uint32_t prev, uint32_t cp)
+{
+    (void)ctx;
+    int kern = (prev == 'A' && cp == 'V') ? -2 : 0;
+    if (cp >= 0x80) return EM + kern;
+    switch (cp) {
+    case ' ': return 5;
+    case '-': return 6;
+    case 'i': case 'l': case '.': case ',': case ':': case ';': case '!': case '\'': return 4 + kern;
+    default: return 10 + kern;
+    }
+}
+
+static tl_config_t config(int width, bool justify, bool hyphenate)
+{
+    tl_config_t cfg = {
+        .width = width, .em = EM, .justify = justify, .hyphenate = hyphenate, .advance = advance,
+    };
+    return cfg;
+}
+
+typedef struct {
+    int n;
+    tl_line_t line[MAX_LINES];
+    char text[MAX_LINES][TL_MAX_CHARS * 4 + 2];
+} layout_t;
+
+static void lay_out(const tl_config_t *cfg, const char *text, layout_t *out)
+{
+    size_t pos = 0, len = strlen(text);
+    bool para = true;
+
+    out->n = 0;
+    while (out->n < MAX_LINES && tl_break_line(cfg, text, len, pos, true, para, &out->line[out->n])) {
+        tl_line_t *l = &out->line[out->n];
+        tl_copy_line(cfg, text, l, out->text[out->n], sizeof(out->text[0]));
+        if (l->next <= pos) {
+            TEST_FAIL("line %d does not advance: %u -> %u", out->n, (unsigned)pos, (unsigned)l->next);
+            break;
+        }
+        pos = l->next;
+        para = l->flags & TL_LINE_PARA_END;
+        out->n++;
+    }
+    if (pos != len) TEST_FAIL("stopped at byte %zu of %zu", pos, len);
+}
+
+// The drawn text of each line, '|' between them
+static void joined(const layout_t *l, char *out, size_t size)
+{
+    size_t o = 0;
+    out[0] = 0;
+    for (int i = 0; i < l->n; i++) o += snprintf(out + o, o < size ? size - o : 0, "%s%s", i ? "|" : "", l->text[i]);
+}
+
+static void expect_lines(const tl_config_t *cfg, const char *text, const char *want)
+{
+    static layout_t l;
+    char got[4096];
+    lay_out(cfg, text, &l);
+    joined(&l, got, sizeof(got));
+    test_checks++;
+    if (strcmp(got, want) != 0) TEST_FAIL("width %d \"%s\":\n  got  \"%s\"\n  want \"%s\"", cfg->width, text, got, want);
+}
+
+static void breaks(void)
+{
+    tl_config_t cfg = config(100, false, false);
+
+    // the quick = 85, + " brown" = 140
+    expect_lines(&cfg, "the quick brown fox jumps", "the quick|brown fox|jumps");
+    // Spaces may hang in the margin, runs of them collapse at the break
+    expect_lines(&cfg, "abcdefghij     klm", "abcdefghij|klm");
+    // Numbers, currency, percent, contractions and closing punctuation stay together
+    expect_lines(&cfg, "pi is 3.14159 ok", "pi is|3.14159 ok");
+    expect_lines(&cfg, "aaaaa $1000", "aaaaa|$1000");
+    expect_lines(&cfg, "aaaa bb 100%", "aaaa bb|100%");
+    expect_lines(&cfg, "aaaa bbb don't", "aaaa bbb|don't");
+    expect_lines(&cfg, "aaaa bbbbb (cc)", "aaaa bbbbb|(cc)");
+    expect_lines(&cfg, "aaaaaaaa bb!", "aaaaaaaa|bb!");
+    // A word longer than the line is cut where it overflows
+    expect_lines(&cfg, "abcdefghijklmnopqrstu", "abcdefghij|klmnopqrst|u");
+    // Line feeds end paragraphs, blank lines are kept
+    expect_lines(&cfg, "one\ntwo\r\n\r\nthree", "one|two||three");
+    // Breaking after a hyphen, not before it
+    expect_lines(&cfg, "aaaa well-known", "aaaa well-|known");
+    // No break at a no-break space
+    expect_lines(&cfg, "aaa bbbb\xC2\xA0" "cc", "aaa|bbbb\xC2\xA0" "cc");
+    // A zero width space allows one and is not drawn
+    expect_lines(&cfg, "abcdefgh\xE2\x80\x8Bijklmn", "abcdefgh|ijklmn");
+
+    // CJK breaks between any two ideographs, 5 to a line
+    expect_lines(&cfg, "春风又绿江南岸明月何时照我还", "春风又绿江|南岸明月何|时照我还");
+    // Mixed: Latin words stay whole, breaks around them
+    expect_lines(&cfg, "我爱Python编程", "我爱Python|编程");
+    expect_lines(&cfg, "我爱编程Python", "我爱编程|Python");
+    expect_lines(&cfg, "用C语言写", "用C语言写");
+}
+
+// Never at the start of a line
+static bool no_start(uint32_t cp)
+{
+    static const uint32_t set[] = {
+        0x3001, 0x3002, 0xFF0C, 0xFF0E, 0xFF09, 0xFF3D, 0xFF5D, 0x300D, 0x300F, 0x3011, 0x3015, 0x3009, 0x300B,
+        0xFF01, 0xFF1F, 0xFF1A, 0xFF1B, 0x30FC, 0x3005, 0x309D, 0x30FD, 0x3063, 0x30C3, 0x3083, 0x30E3, 0x3041,
+        0x30A1, 0x30FB, 0x2026, 0x201D, ',', '.', ';', ':', '!', '?', ')', ']', '}',
+    };
+    for (size_t i = 0; i < sizeof(set) / sizeof(set[0]); i++) {
+        if (set[i] == cp) return true;
+    }
+    return false;
+}
+
+// Never at the end of a line
+static bool no_end(uint32_t cp)
+{
+    static const uint32_t set[] = {0xFF08, 0xFF3B, 0xFF5B, 0x300C, 0x300E, 0x3010, 0x3014, 0x3008, 0x300A,
+                                   0x201C, 0x2018, '(', '[', '{'};
+    for (size_t i = 0; i < sizeof(set) / sizeof(set[0]); i++) {
+        if (set[i] == cp) return true;
+    }
+    return false;
+}
+
+static uint32_t first_cp(const char *s)
+{
+    int len;
+    return *s ? tl_decode_utf8(s, strlen(s), &len) : 0;
+}
+
+static uint32_t last_cp(const char *s)
+{
+    size_t n = strlen(s);
+    if (!n) return 0;
+    size_t i = n - 1;
+    while (i > 0 && ((unsigned char)s[i] & 0xC0) == 0x80) i--;
+    int len;
+    return tl_decode_utf8(s + i, n - i, &len);
+}
+
+static const char *const kinsoku_text =
+    "「春眠不觉晓，处处闻啼鸟。」夜来风雨声、花落知多少？"
+    "カッコいいショッピング、ちょっとジャーナル！々ゝ（注：括弧）【重要】『引用』〔注〕《书名》"
+    "He said “hello,” then left (quickly). 中文和English混排，效果如何？好……非常好！";
+
+static void kinsoku(void)
+{
+    static layout_t l;
+    int lines = 0;
+
+    // From four ems: a run like 鸟。」 wider than the line is cut anyhow
+    for (int width = 4 * EM; width <= 24 * EM; width += 3) {
+        for (int j = 0; j < 2; j++) {
+            tl_config_t cfg = config(width, j, false);
+            lay_out(&cfg, kinsoku_text, &l);
+            for (int i = 0; i < l.n; i++) {
+                uint32_t a = first_cp(l.text[i]), z = last_cp(l.text[i]);
+                if ((i > 0 && no_start(a)) || (i < l.n - 1 && no_end(z))) {
+                    TEST_FAIL("width %d%s, line %d \"%s\": %s with U+%04X", width, j ? " justified" : "", i,
+                              l.text[i], i > 0 && no_start(a) ? "starts" : "ends", i > 0 && no_start(a) ? a : z);
+                    return;
+                }
+                // Overflow only when narrowed spaces make up for it
+                if (l.line[i].width > width && l.line[i].width + l.line[i].extra > width) {
+                    TEST_FAIL("width %d, line %d \"%s\": %d px", width, i, l.text[i], l.line[i].width);
+                    return;
+                }
+            }
+            lines += l.n;
+        }
+    }
+    test_checks++;
+    CHECK(lines > 1000);
+
+    // Where the greedy break would put them, punctuation goes up and brackets down
+    tl_config_t cfg = config(5 * EM, false, false);
+    expect_lines(&cfg, "春风又绿江，南岸", "春风又绿|江，南岸");
+    expect_lines(&cfg, "春风又绿江ー南岸", "春风又绿|江ー南岸");
+    expect_lines(&cfg, "春风又绿「江南岸」", "春风又绿|「江南岸」");
+    expect_lines(&cfg, "春风又绿江。」南岸", "春风又绿|江。」南岸");
+}
+
+// Every line but the last of a paragraph fills the width once its extra is spread
+static void justification(void)
+{
+    static layout_t l;
+    static const char *const texts[] = {
+        "the quick brown fox jumps over the lazy dog and keeps on running far away from here",
+        "春风又绿江南岸明月何时照我还山重水复疑无路柳暗花明又一村",
+        "中文 mixed with English 和更多的中文 words here 以及结尾。",
+    };
+
+    for (size_t t = 0; t < sizeof(texts) / sizeof(texts[0]); t++) {
+        for (int width = 100; width <= 400; width += 7) {
+            tl_config_t cfg = config(width, true, false);
+            lay_out(&cfg, texts[t], &l);
+            for (int i = 0; i < l.n; i++) {
+                const tl_line_t *ln = &l.line[i];
+                bool has_space = strchr(l.text[i], ' ') != NULL;
+                if (ln->flags & TL_LINE_PARA_END) {
+                    if (ln->extra > 0) TEST_FAIL("width %d: last line \"%s\" stretched", width, l.text[i]);
+                    continue;
+                }
+                if (ln->stretch == TL_STRETCH_NONE) {
+                    // Left ragged only when stretching would go past the limits
+                    int slack = width - ln->width;
+                    int chars = 0, spaces = 0;
+                    for (const char *p = l.text[i]; *p; p++) {
+                        chars += ((unsigned char)*p & 0xC0) != 0x80;
+                        spaces += *p == ' ';
+                    }
+                    if (slack > 0 && (has_space ? slack <= spaces * EM : slack <= (chars - 1) * EM / 4)) {
+                        TEST_FAIL("width %d: \"%s\" left ragged with %d px", width, l.text[i], slack);
+                        return;
+                    }
+                    continue;
+                }
+                if (ln->width + ln->extra != width ||
+                    ln->stretch != (has_space ? TL_STRETCH_SPACES : TL_STRETCH_CHARS)) {
+                    TEST_FAIL("width %d: \"%s\" %d + %d px, stretch %d", width, l.text[i], ln->width, ln->extra,
+                              ln->stretch);
+                    return;
+                }
+            }
+            test_checks++;
+        }
+    }
+
+    // Ragged when not justifying, except to narrow spaces on an overflowing line
+    tl_config_t cfg = config(100, false, false);
+    lay_out(&cfg, texts[0], &l);
+    for (int i = 0; i < l.n; i++) CHECK(l.line[i].extra <= 0);
+
+    // A word kept on the line by narrowing its spaces: 5 + 5 + 10*8 + 4*3 = 100 + 2
+    cfg = config(100, true, false);
+    lay_out(&cfg, "aaaa bbbb iii dd", &l);
+    CHECK_STR(l.text[0], "aaaa bbbb iii");
+    CHECK_EQ(l.line[0].width, 102);
+    CHECK_EQ(l.line[0].extra, -2);
+    CHECK_EQ(l.line[0].stretch, TL_STRETCH_SPACES);
+
+    // Too far to stretch between characters: 2 chars, 60 px short
+    lay_out(&cfg, "春风(aaaaaaaaaaa)", &l);
+    CHECK_EQ(l.line[0].stretch, TL_STRETCH_NONE);
+
+    // The indent of a paragraph's first line comes off its width
+    cfg.indent = 2 * EM;
+    lay_out(&cfg, "春风又绿江南岸明月何时照我还", &l);
+    CHECK_EQ(l.line[0].indent, 2 * EM);
+    CHECK_STR(l.text[0], "春风又");
+    CHECK_EQ(l.line[1].indent, 0);
+    CHECK_STR(l.text[1], "绿江南岸明");
+}
+
+static void hyphens(void)
+{
+    static layout_t l;
+    tl_config_t cfg = config(100, false, true);
+
+    // A loose line takes as much of the next word as fits, between two consonants
+    expect_lines(&cfg, "aa wonderful", "aa wonder-|ful");
+    expect_lines(&cfg, "aaaaa wonderful", "aaaaa won-|derful");
+    lay_out(&cfg, "aa wonderful", &l);
+    CHECK(l.line[0].flags & TL_LINE_HYPHEN);
+    CHECK_EQ(l.line[0].width, 25 + 60 + 6);
+    // Never inside a digraph, never acronyms, never without hyphenate
+    lay_out(&cfg, "aaaa nothing", &l);
+    CHECK_STR(l.text[0], "aaaa");
+    lay_out(&cfg, "aa ABCDEFGHIJ", &l);
+    CHECK_STR(l.text[0], "aa");
+    cfg.hyphenate = false;
+    lay_out(&cfg, "aa wonderful", &l);
+    CHECK_STR(l.text[0], "aa");
+
+    // Soft hyphens are always used, and not drawn elsewhere
+    lay_out(&cfg, "aa won\xC2\xAD" "der\xC2\xAD" "ful", &l);
+    CHECK_STR(l.text[0], "aa wonder-");
+    CHECK_STR(l.text[1], "ful");
+    lay_out(&cfg, "won\xC2\xAD" "der", &l);
+    CHECK_EQ(l.n, 1);
+    CHECK_STR(l.text[0], "wonder");
+
+    // Tabs are drawn as spaces, a kerned pair measures with its kerning
+    cfg = config(200, false, false);
+    lay_out(&cfg, "a\tAVb", &l);
+    CHECK_STR(l.text[0], "a AVb");
+    CHECK_EQ(l.line[0].width, 10 + 5 + 10 + 8 + 10);
+}
+
+// Text that arrives in chunks gives the lines of the whole text
+static void chunks(void)
+{
+    static layout_t whole;
+    static const char *const texts[] = {
+        "the quick brown fox jumps over the lazy dog\r\nand 春风又绿江南岸，明月何时照我还。\n\nend",
+        "「春眠不觉晓，处处闻啼鸟。」夜来风雨声、花落知多少？",
+    };
+
+    for (size_t t = 0; t < 2; t++) {
+        const char *text = texts[t];
+        size_t len = strlen(text);
+        tl_config_t cfg = config(110, true, true);
+        lay_out(&cfg, text, &whole);
+
+        for (size_t step = 1; step < 24; step += 5) {
+            size_t pos = 0, avail = 0;
+            bool para = true;
+            int n = 0;
+            tl_line_t line;
+            while (pos < len) {
+                bool eof = avail >= len;
+                if (!tl_break_line(&cfg, text, avail, pos, eof, para, &line)) {
+                    if (eof) break;
+                    avail = avail + step < len ? avail + step : len;    // More text
+                    continue;
+                }
+                if (n >= whole.n || memcmp(&line, &whole.line[n], sizeof(line)) != 0) {
+                    TEST_FAIL("text %zu, chunks of %zu: line %d differs", t, step, n);
+                    return;
+                }
+                pos = line.next;
+                para = line.flags & TL_LINE_PARA_END;
+                n++;
+            }
+            CHECK_EQ(n, whole.n);
+        }
+    }
+
+    // A sequence cut by the end of the buffer waits for more
+    tl_line_t line;
+    tl_config_t cfg = config(110, false, false);
+    CHECK(!tl_break_line(&cfg, "ab\xE6\x98", 4, 0, false, true, &line));
+    CHECK(tl_break_line(&cfg, "ab\xE6\x98", 4, 0, true, true, &line));
+    CHECK(!tl_break_line(&cfg, "ab\r", 3, 0, false, true, &line));
+}
+
+int main(void)
+{
+    TEST_RUN(breaks);
+    TEST_RUN(kinsoku);
+    TEST_RUN(justification);
+    TEST_RUN(hyphens);
+    TEST_RUN(chunks);
+    return test_done();
+}
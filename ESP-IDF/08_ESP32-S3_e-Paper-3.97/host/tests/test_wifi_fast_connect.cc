@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "ssid_manager.h"
+#include "wifi_fast_connect.h"
+#include "test.h"
+
+/*
+ * The fast reconnect of components/esp-wifi-connect: which first step a cache
+ * leads to (static address, known channel, full scan), the age at which a
+ * DHCP lease stops being reused, every sequence of failures ending in a full
+ * scan within two fast attempts, and SsidManager keeping the cache in NVS:
+ * what it refuses to load, no write when nothing changed, the cache going
+ * with its SSID, and the last addresses of at most four hosts.
+ */
+
+typedef WifiFastConnect::Step Step;
+
+static const int64_t kNow = 1760000000;     // 2025-10-09, any time after the RTC is set
+
+static WifiConnectCache good_cache(void)
+{
+    WifiConnectCache cache = {};
+    cache.version = WIFI_CONNECT_CACHE_VERSION;
+    cache.channel = 6;
+    cache.authmode = 3;
+    const uint8_t bssid[6] = {0x24, 0x0a, 0xc4, 0x12, 0x34, 0x56};
+    memcpy(cache.bssid, bssid, sizeof(bssid));
+    strcpy(cache.ssid, "home");
+    cache.ip = 0x6401a8c0;          // 192.168.1.100
+    cache.netmask = 0x00ffffff;
+    cache.gateway = 0x0101a8c0;
+    cache.dns = 0x0101a8c0;
+    cache.lease_start = kNow - 600;
+    cache.lease_time = 7200;
+    return cache;
+}
+
+static void first_step(void)
+{
+    WifiFastConnect fc;
+    WifiConnectCache cache = good_cache();
+
+    CHECK(fc.Begin(&cache, true, kNow) == Step::kStaticIp);
+    CHECK(fc.fast());
+    CHECK_EQ(fc.attempts(), 1);
+    // Without a clock the lease age is unknown, the channel still is
+    CHECK(fc.Begin(&cache, true, -1) == Step::kDhcp);
+    CHECK(fc.Begin(nullptr, true, kNow) == Step::kScan);
+    CHECK(!fc.fast());
+    // The SSID was forgotten since
+    CHECK(fc.Begin(&cache, false, kNow) == Step::kScan);
+
+    static const struct {
+        uint8_t version, channel;
+        Step step;
+    } table[] = {
+        {WIFI_CONNECT_CACHE_VERSION, 1, Step::kStaticIp},
+        {WIFI_CONNECT_CACHE_VERSION, 14, Step::kStaticIp},
+        {WIFI_CONNECT_CACHE_VERSION, 0, Step::kScan},
+        {WIFI_CONNECT_CACHE_VERSION, 15, Step::kScan},
+        {WIFI_CONNECT_CACHE_VERSION, 255, Step::kScan},
+        {0, 6, Step::kScan},
+        {WIFI_CONNECT_CACHE_VERSION + 1, 6, Step::kScan},
+    };
+    for (const auto &row : table) {
+        cache = good_cache();
+        cache.version = row.version;
+        cache.channel = row.channel;
+        Step step = fc.Begin(&cache, true, kNow);
+        test_checks++;
+        if (step != row.step) {
+            TEST_FAIL("version %d channel %d: %s, expected %s", row.version, row.channel,
+                      WifiFastConnect::StepName(step), WifiFastConnect::StepName(row.step));
+        }
+    }
+
+    // Anything that makes the lease unusable still leaves the known channel
+    cache = good_cache();
+    cache.ip = 0;
+    CHECK(fc.Begin(&cache, true, kNow) == Step::kDhcp);
+}
+
+static void lease(void)
+{
+    WifiConnectCache cache = good_cache();
+    int64_t start = cache.lease_start;
+
+    // Reused in the first half only, before a DHCP client would renew it
+    CHECK(WifiFastConnect::LeaseUsable(cache, start));
+    CHECK(WifiFastConnect::LeaseUsable(cache, start + 3599));
+    CHECK(!WifiFastConnect::LeaseUsable(cache, start + 3600));
+    CHECK(!WifiFastConnect::LeaseUsable(cache, start + 7200));
+    // A clock that went back
+    CHECK(!WifiFastConnect::LeaseUsable(cache, start - 1));
+    CHECK(!WifiFastConnect::LeaseUsable(cache, -1));
+    // An odd lease rounds down
+    cache.lease_time = 3;
+    CHECK(WifiFastConnect::LeaseUsable(cache, start));
+    CHECK(!WifiFastConnect::LeaseUsable(cache, start + 1));
+
+    static const struct {
+        const char *what;
+        void (*spoil)(WifiConnectCache &);
+    } spoilt[] = {
+        {"no lease start", [](WifiConnectCache &c) { c.lease_start = 0; }},
+        {"negative lease start", [](WifiConnectCache &c) { c.lease_start = -5; }},
+        {"no lease time", [](WifiConnectCache &c) { c.lease_time = 0; }},
+        {"no address", [](WifiConnectCache &c) { c.ip = 0; }},
+        {"no gateway", [](WifiConnectCache &c) { c.gateway = 0; }},
+    };
+    for (const auto &s : spoilt) {
+        cache = good_cache();
+        s.spoil(cache);
+        test_checks++;
+        if (WifiFastConnect::LeaseUsable(cache, kNow)) TEST_FAIL("%s: lease usable", s.what);
+    }
+}
+
+static const WifiFailure failures[] = {WifiFailure::kNoAp, WifiFailure::kAuth, WifiFailure::kTimeout,
+                                       WifiFailure::kOther};
+#define FAILURE_KINDS (int)(sizeof(failures) / sizeof(failures[0]))
+
+// Every sequence of three failures from both fast starts
+static void failure_sequences(void)
+{
+    WifiConnectCache cache = good_cache();
+    static const int64_t clocks[] = {kNow, -1};
+
+    for (int64_t now : clocks) {
+        for (int seq = 0; seq < FAILURE_KINDS * FAILURE_KINDS * FAILURE_KINDS; seq++) {
+            WifiFastConnect fc;
+            Step step = fc.Begin(&cache, true, now);
+            int fast_attempts = 1;
+            for (int i = 0, s = seq; i < 3; i++, s /= FAILURE_KINDS) {
+                WifiFailure f = failures[s % FAILURE_KINDS];
+                Step prev = step;
+                step = fc.OnFailure(f);
+                if (prev == Step::kScan) {
+                    // The scan is the last resort, it stays
+                    if (step != Step::kScan) TEST_FAIL("seq %d: left the scan for %s", seq, WifiFastConnect::StepName(step));
+                    continue;
+                }
+                if (f == WifiFailure::kNoAp && step != Step::kScan) {
+                    TEST_FAIL("seq %d: AP gone, then %s", seq, WifiFastConnect::StepName(step));
+                }
+                if (step != Step::kScan) {
+                    fast_attempts++;
+                    // Only a timeout with the static address gives it up
+                    Step want = prev == Step::kStaticIp && f != WifiFailure::kTimeout ? Step::kStaticIp : Step::kDhcp;
+                    if (step != want) {
+                        TEST_FAIL("seq %d: %s after %s, expected %s", seq, WifiFastConnect::StepName(step),
+                                  WifiFastConnect::StepName(prev), WifiFastConnect::StepName(want));
+                    }
+                    if (fc.attempts() != fast_attempts) TEST_FAIL("seq %d: %d attempts, expected %d", seq, fc.attempts(), fast_attempts);
+                }
+            }
+            test_checks++;
+            if (step != Step::kScan) TEST_FAIL("seq %d: still %s after three failures", seq, WifiFastConnect::StepName(step));
+            if (fast_attempts > WifiFastConnect::kMaxFastAttempts) TEST_FAIL("seq %d: %d fast attempts", seq, fast_attempts);
+        }
+    }
+
+    WifiFastConnect fc;
+    fc.Begin(&cache, true, kNow);
+    fc.OnConnected();
+    CHECK(fc.step() == Step::kDone);
+    CHECK(!fc.fast());
+    CHECK(fc.OnFailure(WifiFailure::kTimeout) == Step::kDone);
+}
+
+static std::string work_dir, store;
+
+static bool file_exists(const std::string &path)
+{
+    return access(path.c_str(), F_OK) == 0;
+}
+
+static void put_blob(const void *data, size_t len)
+{
+    nvs_handle_t h;
+    CHECK_EQ(nvs_open("wifi", NVS_READWRITE, &h), ESP_OK);
+    nvs_set_blob(h, "fast_conn", data, len);
+    nvs_commit(h);
+    nvs_close(h);
+}
+
+static void cache_in_nvs(void)
+{
+    auto &ssid_manager = SsidManager::GetInstance();
+    WifiConnectCache cache = good_cache(), loaded;
+
+    ssid_manager.ClearConnectCache();
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+    ssid_manager.SaveConnectCache(cache);
+    memset(&loaded, 0xAA, sizeof(loaded));
+    CHECK(ssid_manager.LoadConnectCache(loaded));
+    CHECK_MEM(&loaded, &cache, sizeof(cache));
+
+    // What the loader refuses: a blob of another size, another version, a bad SSID
+    uint8_t bigger[sizeof(cache) + 8] = {};
+    memcpy(bigger, &cache, sizeof(cache));
+    put_blob(bigger, sizeof(bigger));
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+    put_blob(&cache, sizeof(cache) - 8);
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+
+    WifiConnectCache bad = cache;
+    bad.version = WIFI_CONNECT_CACHE_VERSION + 1;
+    put_blob(&bad, sizeof(bad));
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+    bad = cache;
+    memset(bad.ssid, 'x', sizeof(bad.ssid));
+    put_blob(&bad, sizeof(bad));
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+    bad = cache;
+    bad.ssid[0] = '\0';
+    put_blob(&bad, sizeof(bad));
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+    // The longest SSID there is
+    bad = cache;
+    memset(bad.ssid, 'y', 32);
+    bad.ssid[32] = '\0';
+    put_blob(&bad, sizeof(bad));
+    CHECK(ssid_manager.LoadConnectCache(loaded));
+
+    // Nothing written to flash when the cache did not change
+    ssid_manager.SaveConnectCache(cache);
+    CHECK(file_exists(store));
+    unlink(store.c_str());
+    ssid_manager.SaveConnectCache(cache);
+    CHECK(!file_exists(store));
+    cache.lease_start += 60;
+    ssid_manager.SaveConnectCache(cache);
+    CHECK(file_exists(store));
+    CHECK(ssid_manager.LoadConnectCache(loaded));
+    CHECK_EQ(loaded.lease_start, cache.lease_start);
+
+    ssid_manager.ClearConnectCache();
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+}
+
+// Forgetting a network forgets its cache, and only its own
+static void cache_follows_ssid(void)
+{
+    auto &ssid_manager = SsidManager::GetInstance();
+    WifiConnectCache cache = good_cache(), loaded;
+
+    ssid_manager.Clear();
+    ssid_manager.AddSsid("home", "secret1");
+    ssid_manager.AddSsid("office", "secret2");
+    ssid_manager.SaveConnectCache(cache);
+
+    CHECK_STR(ssid_manager.GetSsidList()[0].ssid.c_str(), "office");
+    ssid_manager.RemoveSsid(0);
+    CHECK(ssid_manager.LoadConnectCache(loaded));
+    ssid_manager.RemoveSsid(0);
+    CHECK_EQ(ssid_manager.GetSsidList().size(), 0);
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+
+    ssid_manager.AddSsid("home", "secret1");
+    ssid_manager.SaveConnectCache(cache);
+    ssid_manager.Clear();
+    CHECK(!ssid_manager.LoadConnectCache(loaded));
+}
+
+static void host_addresses(void)
+{
+    auto &ssid_manager = SsidManager::GetInstance();
+    uint32_t ip;
+    int64_t resolved;
+    const char *const hosts[] = {"api.a.com", "api.b.com", "api.c.com", "api.d.com", "api.e.com"};
+
+    for (int i = 0; i < 5; i++) ssid_manager.SetHostAddress(hosts[i], 0x0a000001 + i, kNow + i);
+    // Four kept, the oldest fell off
+    CHECK(!ssid_manager.GetHostAddress(hosts[0], ip, resolved));
+    for (int i = 1; i < 5; i++) {
+        test_checks++;
+        if (!ssid_manager.GetHostAddress(hosts[i], ip, resolved) || ip != 0x0a000001u + i || resolved != kNow + i) {
+            TEST_FAIL("%s not kept", hosts[i]);
+        }
+    }
+
+    // A new address for a known host moves it to the front
+    ssid_manager.SetHostAddress(hosts[1], 0x0a0000ff, kNow + 10);
+    ssid_manager.SetHostAddress(hosts[0], 0x0a000001, kNow + 11);
+    CHECK(ssid_manager.GetHostAddress(hosts[1], ip, resolved));
+    CHECK_EQ(ip, 0x0a0000ff);
+    CHECK(!ssid_manager.GetHostAddress(hosts[2], ip, resolved));
+
+    // What is stored is what is kept
+    nvs_handle_t h;
+    size_t length = 0;
+    CHECK_EQ(nvs_open("wifi", NVS_READONLY, &h), ESP_OK);
+    CHECK_EQ(nvs_get_blob(h, "host_ips", nullptr, &length), ESP_OK);
+    CHECK_EQ(length % 4, 0);
+    CHECK(length / 4 >= 48);
+    size_t entry = length / 4;
+    nvs_close(h);
+
+    // A name that does not fit is not cached
+    std::string long_name(entry, 'n');
+    ssid_manager.SetHostAddress(long_name, 0x0a000009, kNow);
+    CHECK(!ssid_manager.GetHostAddress(long_name, ip, resolved));
+
+    for (const char *host : hosts) ssid_manager.RemoveHostAddress(host);
+    CHECK(!ssid_manager.GetHostAddress(hosts[1], ip, resolved));
+    CHECK_EQ(nvs_open("wifi", NVS_READWRITE, &h), ESP_OK);
+    CHECK_EQ(nvs_get_blob(h, "host_ips", nullptr, &length), ESP_ERR_NVS_NOT_FOUND);
+    nvs_close(h);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/test_wifi_fast_connect.XXXXXX";
+    if (!mkdtemp(dir)) return 2;
+    work_dir = dir;
+    store = work_dir + "/nvs.txt";
+    host_nvs_load(store.c_str());
+    nvs_flash_init();
+
+    TEST_RUN(first_step);
+    TEST_RUN(lease);
+    TEST_RUN(failure_sequences);
+    TEST_RUN(cache_in_nvs);
+    TEST_RUN(cache_follows_ssid);
+    TEST_RUN(host_addresses);
+
+    unlink(store.c_str());
+    rmdir(dir);
+    return test_done();
+}
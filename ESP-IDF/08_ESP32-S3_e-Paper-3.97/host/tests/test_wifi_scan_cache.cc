@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+#include "cJSON.h"
+#include "wifi_scan_cache.h"
+#include "test.h"
+
+/*
+ * The /scan list of components/esp-wifi-connect: one entry per SSID,
+ * strongest first; JSON that parses whatever bytes an SSID holds; a new
+ * snapshot and ETag only when a network comes, goes, changes security or
+ * moves by the hysteresis from what was published; the ETag a function of
+ * the list alone, so the same list has the same tag after a restart; and
+ * If-None-Match compared weakly, lists and "*" included.
+ */
+
+typedef std::vector<WifiScanEntry> scan_t;
+
+static WifiScanEntry ap(const char *ssid, int rssi, uint8_t authmode = 3)
+{
+    return WifiScanEntry{ssid, (int8_t)rssi, authmode, 6};
+}
+
+static void dedup(void)
+{
+    scan_t s = {ap("b", -70), ap("a", -50), ap("", -30), ap("b", -60), ap("c", -60), ap("a", -80), ap("", -90)};
+    WifiScanCache::Deduplicate(s);
+    // Hidden ones dropped, the strongest BSSID of each, ties by name
+    CHECK_EQ(s.size(), 3);
+    CHECK_STR(s[0].ssid.c_str(), "a");
+    CHECK_EQ(s[0].rssi, -50);
+    CHECK_STR(s[1].ssid.c_str(), "b");
+    CHECK_EQ(s[1].rssi, -60);
+    CHECK_STR(s[2].ssid.c_str(), "c");
+
+    s.clear();
+    for (int i = 0; i < 40; i++) s.push_back(ap(("net" + std::to_string(i)).c_str(), -90 + i));
+    WifiScanCache::Deduplicate(s);
+    CHECK_EQ(s.size(), WifiScanCache::kMaxEntries);
+    CHECK_STR(s[0].ssid.c_str(), "net39");
+    CHECK_EQ(s.back().rssi, -90 + 40 - (int)WifiScanCache::kMaxEntries);
+}
+
+static void json(void)
+{
+    std::string out = WifiScanCache::ToJson({});
+    CHECK_STR(out.c_str(), "[]");
+    out = WifiScanCache::ToJson({ap("home", -42, 3)});
+    CHECK_STR(out.c_str(), "[{\"ssid\":\"home\",\"rssi\":-42,\"authmode\":3}]");
+
+    // What each SSID reads back as: valid UTF-8 as it is, other bytes as Latin-1
+    static const struct {
+        const char *ssid, *want;
+    } names[] = {
+        {"plain", "plain"},
+        {"quote\"back\\slash", "quote\"back\\slash"},
+        {"tab\there\x01\x1f", "tab\there\x01\x1f"},
+        {"中文网络", "中文网络"},
+        {"emoji \xF0\x9F\x93\xB6", "emoji \xF0\x9F\x93\xB6"},
+        {"gbk \xC4\xE3\xBA\xC3", "gbk \xC3\x84\xC3\xA3\xC2\xBA\xC3\x83"},
+        {"overlong \xC0\x80", "overlong \xC3\x80\xC2\x80"},
+        {"surrogate \xED\xA0\x80", "surrogate \xC3\xAD\xC2\xA0\xC2\x80"},
+        {"cut \xE4\xB8", "cut \xC3\xA4\xC2\xB8"},
+        {"big \xF4\x90\x80\x80", "big \xC3\xB4\xC2\x90\xC2\x80\xC2\x80"},
+    };
+    scan_t s;
+    for (const auto &n : names) s.push_back(ap(n.ssid, -40));
+    out = WifiScanCache::ToJson(s);
+    cJSON *root = cJSON_Parse(out.c_str());
+    CHECK(root != NULL && cJSON_IsArray(root));
+    if (!root) return;
+    CHECK_EQ(cJSON_GetArraySize(root), sizeof(names) / sizeof(names[0]));
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        cJSON *item = cJSON_GetArrayItem(root, i);
+        cJSON *ssid = item ? cJSON_GetObjectItem(item, "ssid") : NULL;
+        test_checks++;
+        if (!ssid || !cJSON_IsString(ssid) || strcmp(ssid->valuestring, names[i].want) != 0) {
+            TEST_FAIL("SSID %zu reads back as \"%s\"", i, ssid && ssid->valuestring ? ssid->valuestring : "(none)");
+        }
+    }
+    cJSON_Delete(root);
+    // Control characters only escaped on the wire
+    for (unsigned char c : out) {
+        if (c < 0x20) {
+            TEST_FAIL("control byte %02x in the JSON", c);
+            break;
+        }
+    }
+}
+
+static uint32_t fnv1a(const std::string &s)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned char c : s) h = (h ^ c) * 16777619u;
+    return h;
+}
+
+static void snapshots(void)
+{
+    WifiScanCache cache;
+    CHECK(!cache.ready());
+    CHECK_STR(cache.json().c_str(), "[]");
+    CHECK(cache.etag().empty());
+
+    // The first scan is published even when empty
+    CHECK(cache.Update({}));
+    CHECK(cache.ready());
+    CHECK_EQ(cache.version(), 1);
+    CHECK(!cache.Update({}));
+
+    scan_t base = {ap("home", -50), ap("cafe", -70), ap("lab", -80, 4)};
+    CHECK(cache.Update(base));
+    CHECK_EQ(cache.version(), 2);
+    CHECK_EQ(cache.size(), 3);
+    std::string tag = cache.etag();
+    char want[16];
+    snprintf(want, sizeof(want), "\"%08lx\"", (unsigned long)fnv1a(cache.json()));
+    CHECK_STR(tag.c_str(), want);
+
+    // The same networks in another order, with their other BSSIDs, under the hysteresis
+    scan_t noisy = {ap("lab", -76, 4), ap("home", -55), ap("home", -90), ap("cafe", -65)};
+    CHECK(!cache.Update(noisy));
+    CHECK_STR(cache.etag().c_str(), tag.c_str());
+    CHECK_EQ(cache.version(), 2);
+
+    // Small steps add up against what was published, not against the last scan
+    int rssi = -50, published = -50;
+    for (int step = 0; step < 12; step++) {
+        rssi -= 1;
+        scan_t s = {ap("home", rssi), ap("cafe", -70), ap("lab", -80, 4)};
+        bool changed = cache.Update(s);
+        test_checks++;
+        if (changed != (published - rssi >= WifiScanCache::kRssiHysteresis)) {
+            TEST_FAIL("%d dBm after %d published: changed %d", rssi, published, changed);
+        }
+        if (changed) published = rssi;
+    }
+    CHECK_EQ(published, -50 - 2 * WifiScanCache::kRssiHysteresis);
+
+    // A network that comes, goes or changes its security always counts
+    scan_t s = {ap("home", published), ap("cafe", -70), ap("lab", -80, 4)};
+    CHECK(!cache.Update(s));
+    s.push_back(ap("guest", -85));
+    CHECK(cache.Update(s));
+    s.pop_back();
+    CHECK(cache.Update(s));
+    s[2].authmode = 3;
+    CHECK(cache.Update(s));
+    s[1] = ap("cafe2", -70);
+    CHECK(cache.Update(s));
+    // Back to a list seen before: its tag again
+    s = {ap("home", published), ap("cafe", -70), ap("lab", -80, 4)};
+    CHECK(cache.Update(s));
+    std::string again = cache.etag();
+
+    // A restart that scans the same list sends the same tag
+    WifiScanCache restarted;
+    CHECK(restarted.Update(s));
+    CHECK_STR(restarted.etag().c_str(), again.c_str());
+    CHECK_STR(restarted.json().c_str(), cache.json().c_str());
+
+    // Different lists, different tags
+    std::set<std::string> tags;
+    for (int i = 0; i < 2000; i++) {
+        WifiScanCache c;
+        c.Update({ap(("n" + std::to_string(i % 50)).c_str(), -30 - i / 50), ap("x", -90)});
+        tags.insert(c.etag());
+    }
+    CHECK_EQ(tags.size(), 2000);
+}
+
+static void if_none_match(void)
+{
+    WifiScanCache cache;
+    // Nothing to match before the first scan, whatever is asked
+    CHECK(!cache.Matches("*"));
+    CHECK(!cache.Matches(""));
+
+    cache.Update({ap("home", -50)});
+    const std::string tag = cache.etag();
+    const std::string bare = tag.substr(1, tag.size() - 2);
+    char other[16];
+    snprintf(other, sizeof(other), "\"%08lx\"", (unsigned long)(fnv1a(cache.json()) ^ 1));
+
+    static const struct {
+        const char *fmt;        // %s is the tag
+        bool match;
+    } cases[] = {
+        {"%s", true},
+        {"W/%s", true},
+        {"  %s  ", true},
+        {"*", true},
+        {"\"00000000\", %s", true},
+        {"W/\"00000000\",W/%s", true},
+        {"garbage, %s", true},
+        {"", false},
+        {"\"00000000\"", false},
+        {"W/\"00000000\"", false},
+        {"%s\"", true},
+    };
+    for (const auto &c : cases) {
+        char header[64];
+        snprintf(header, sizeof(header), c.fmt, tag.c_str());
+        test_checks++;
+        if (cache.Matches(header) != c.match) TEST_FAIL("If-None-Match: %s: %d", header, !c.match);
+    }
+    CHECK(!cache.Matches(other));
+    // Unquoted, truncated or longer, not the tag
+    CHECK(!cache.Matches(bare.c_str()));
+    CHECK(!cache.Matches(tag.substr(0, tag.size() - 1).c_str()));
+    CHECK(!cache.Matches(("\"" + bare + "0\"").c_str()));
+    CHECK(!cache.Matches(("\"0" + bare + "\"").c_str()));
+
+    // Once the list moves the old tag no longer holds the request
+    cache.Update({ap("home", -50), ap("cafe", -60)});
+    CHECK(!cache.Matches(tag.c_str()));
+    CHECK(cache.Matches(cache.etag().c_str()));
+    CHECK(!WifiScanCache::EtagMatches("", "*"));
+}
+
+int main(void)
+{
+    TEST_RUN(dedup);
+    TEST_RUN(json);
+    TEST_RUN(snapshots);
+    TEST_RUN(if_none_match);
+    return test_done();
+}
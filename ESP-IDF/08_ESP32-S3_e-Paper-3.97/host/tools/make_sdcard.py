@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Lays out a directory for epaper_sim --sd: the fonts of components/epaper_lib
+where the firmware looks for them (font/ASICC, font/UTF, font/GBK), and a
+generated book in fiction/ for the reader.
+
+The GUI and weather icons are not in the repository. Copy the card the board
+uses with --from to have them; without, the pages draw without the icons.
+
+Fonts are symlinked unless --copy is given, so the directory stays small.
+
+Usage: make_sdcard.py OUT [--from CARD] [--book-kb 600] [--copy]
+"""
+
+import argparse
+import os
+import random
+import shutil
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FONTS = os.path.normpath(os.path.join(HERE, "..", "..", "components", "epaper_lib", "Fonts"))
+
+WORDS = (
+    "the river ran past the old mill and under the bridge where nobody had "
+    "walked since the winter of the long rain she kept the letters in a box "
+    "of cedar and read them again whenever the lamp was low and the house "
+    "was quiet enough to hear the clock in the hall"
+).split()
+
+HANZI = "春风又绿江南岸明月何时照我还山重水复疑无路柳暗花明又一村"
+
+
+def place(src, dst, copy):
+    os.makedirs(os.path.dirname(dst), exist_ok=True)
+    if os.path.lexists(dst):
+        os.remove(dst)
+    if copy:
+        shutil.copyfile(src, dst)
+    else:
+        os.symlink(src, dst)
+
+
+def layout_fonts(out, copy):
+    count = 0
+    for sub in sorted(os.listdir(FONTS)):
+        d = os.path.join(FONTS, sub)
+        if not os.path.isdir(d):
+            continue
+        for name in sorted(os.listdir(d)):
+            if not name.upper().endswith(".FON"):
+                continue
+            src = os.path.join(d, name)
+            if name.startswith("UTF_"):
+                dst = os.path.join(out, "font", "UTF", name[4:])
+            elif name.startswith("GBK_"):
+                dst = os.path.join(out, "font", "GBK", name[4:])
+            else:
+                dst = os.path.join(out, "font", "ASICC", name)
+            place(src, dst, copy)
+            count += 1
+    return count
+
+
+def make_book(path, kb, seed):
+    """UTF-8 prose in paragraphs, with a line of hanzi now and then."""
+    rng = random.Random(seed)
+    # A title in hanzi first, so the reader detects UTF-8 from the start
+    parts = ["".join(rng.choice(HANZI) for _ in range(8)) + "\n"]
+    size = len(parts[0].encode("utf-8"))
+    chapter = 1
+    while size < kb * 1024:
+        if rng.random() < 0.04 or chapter == 1:
+            text = "\nChapter %d\n\n" % chapter
+            chapter += 1
+        elif rng.random() < 0.15:
+            text = "".join(rng.choice(HANZI) for _ in range(rng.randint(12, 60))) + "。\n"
+        else:
+            words = [rng.choice(WORDS) for _ in range(rng.randint(20, 120))]
+            text = "    " + " ".join(words).capitalize() + ".\n"
+        parts.append(text)
+        size += len(text.encode("utf-8"))
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "w", encoding="utf-8") as f:
+        f.write("".join(parts))
+    return size
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("out", help="directory to give epaper_sim --sd")
+    ap.add_argument("--from", dest="card", help="copy this SD card image first (GUI, Weather_img, music...)")
+    ap.add_argument("--book-kb", type=int, default=600, help="size of the generated book (default 600)")
+    ap.add_argument("--copy", action="store_true", help="copy the fonts instead of linking them")
+    args = ap.parse_args()
+
+    if args.card:
+        shutil.copytree(args.card, args.out, symlinks=True, dirs_exist_ok=True)
+    os.makedirs(args.out, exist_ok=True)
+    fonts = layout_fonts(args.out, args.copy)
+    size = make_book(os.path.join(args.out, "fiction", "sample.txt"), args.book_kb, 1)
+    os.makedirs(os.path.join(args.out, "bookmarks"), exist_ok=True)
+    print("%s: %d fonts, fiction/sample.txt of %d KB" % (args.out, fonts, size // 1024))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
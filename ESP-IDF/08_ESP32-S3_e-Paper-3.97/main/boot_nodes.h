@@ -0,0 +1,39 @@
+#ifndef BOOT_NODES_H
+#define BOOT_NODES_H
+
+#include "boot_graph.h"
+#include "page_clock.h"
+
+// Subsystems brought up by app_main through the boot graph
+enum {
+    BOOT_I2C = 0,
+    BOOT_RTC,
+    BOOT_AXP,
+    BOOT_EPD,
+    BOOT_SHTC3,
+    BOOT_BUTTON,
+    BOOT_IMU,
+    BOOT_SD,
+    BOOT_SPIFFS,
+    BOOT_AUDIO,
+    BOOT_NODE_NUM
+};
+
+// Wake reasons, one per NVS "mode"
+#define WAKE_HOME       (1 << 0)    // mode 0, normal power-on
+#define WAKE_CLOCK      (1 << 1)    // mode 1
+#define WAKE_CALENDAR   (1 << 2)    // mode 2
+#define WAKE_WEATHER    (1 << 3)    // mode 3
+#define WAKE_ANY        (WAKE_HOME | WAKE_CLOCK | WAKE_CALENDAR | WAKE_WEATHER)
+
+// The home page reads its icons and text from the SD card unless they are built in
+#if CLOCK_MODE_NEEDS_SDCARD || !defined(CONFIG_FONT16_EMBEDDED)
+#define HOME_NEEDS_SDCARD 1
+#else
+#define HOME_NEEDS_SDCARD 0
+#endif
+
+// Started in the background once the home page is up, waited for on first use
+#define BOOT_DEFERRED   (BOOT_BIT(BOOT_SD) | BOOT_BIT(BOOT_SPIFFS) | BOOT_BIT(BOOT_AUDIO))
+
+#endif
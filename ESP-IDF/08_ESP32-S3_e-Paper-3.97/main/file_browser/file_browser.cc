@@ -11,6 +11,7 @@
 #include "page_fiction.h"
 
 #include "epaper_port.h"
+#include "mem_arena.h"
 #include "GUI_Paint.h"
 #include "font.h"
 
@@ -52,7 +53,6 @@
 extern uint8_t *Image_Mono;
 uint8_t *Image_Mono_fz;
 
-extern SemaphoreHandle_t rtc_mutex;  
 
 static const char *TAG = "file_browser";
 
@@ -170,7 +170,7 @@ void file_browser_task(void)
     int last_minutes = -1;
 
     // Auxiliary page memory application and processing
-    if((Image_Mono_fz = (UBYTE *)heap_caps_malloc(EPD_SIZE_MONO,MALLOC_CAP_SPIRAM)) == NULL){
+    if((Image_Mono_fz = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL){
         ESP_LOGE(TAG,"Failed to apply for black memory...");
     }
     Paint_NewImage(Image_Mono_fz, SCREEN_HEIGHT, SCREEN_WIDTH, 270, WHITE);
@@ -222,9 +222,7 @@ void file_browser_task(void)
 
         ESP_LOGI("file", "Page %d: Found %d entries in %s", page_index[Directory_count], num, full_path);
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         last_minutes = rtc_time.minutes;
         
         // File/directory selection loop
@@ -317,14 +315,14 @@ void file_browser_task(void)
                     break;
                 } else {
                     heap_caps_free(entries);
+                    mem_free(Image_Mono_fz);
+                    Image_Mono_fz = NULL;
                     return;
                 }
                 time_count = 0;
             }
 
-            xSemaphoreTake(rtc_mutex, portMAX_DELAY);
             rtc_time = PCF85063_GetTime();
-            xSemaphoreGive(rtc_mutex);
             if ((rtc_time.minutes != last_minutes)  && (time_count <EPD_Sleep_Time)) {
                 last_minutes = rtc_time.minutes;
                 display_time_bet_browser_last(rtc_time);
@@ -612,9 +610,7 @@ void display_status_bar(int current_page, int total_pages, int total_items)
     char Time_str[16]={0};
     int BAT_Power;
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     snprintf(Time_str, sizeof(Time_str), "%02d:%02d", rtc_time.hours, rtc_time.minutes);
     Paint_DrawString_EN(SCREEN_WIDTH - 120, SCREEN_HEIGHT - 5 - Font12.Height, Time_str, &Font12, WHITE, BLACK);
 #if defined(CONFIG_IMG_SOURCE_EMBEDDED)
@@ -771,9 +767,7 @@ int Sleep_wake(void)
             Refresh_page();
             break;
         } 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             ESP_LOGI("home", "EPD_Init");
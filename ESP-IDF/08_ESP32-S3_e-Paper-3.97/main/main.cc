@@ -20,6 +20,10 @@
 #include "sdcard_bsp.h"
 #include "epaper_bsp.h"
 #include "epaper_port.h"
+#include "mem_arena.h"
+#include "perf_trace.h"
+#include "energy_prof.h"
+#include "perf_bench.h"
 #include "es8311_bsp.h"
 #include "qmi8658_bsp.h"
 #include "axp_prot.h"
@@ -36,13 +40,13 @@
 #include "page_audio.h"
 #include "page_settings.h"
 #include "page_fiction.h"
+#include "boot_nodes.h"
 
 #include "freertos/semphr.h"
 
 
 // Create a mutex lock to protect the device from interference when reading
 SemaphoreHandle_t alarm_mutex = NULL; // protect alarms
-SemaphoreHandle_t rtc_mutex = NULL;   // protect RTC
 SemaphoreHandle_t nvs_mutex = NULL;   // protect NVS
 SemaphoreHandle_t qmi8658_mutex = NULL;   // protect qmi8658
 
@@ -134,15 +138,13 @@ void esp_home(int selection, int Refresh_mode)
     char BAT_Power_str[16]={0};
 
     // Draw the top state
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     
     snprintf(Time_str, sizeof(Time_str), "%02d:%02d", rtc_time.hours, rtc_time.minutes);
     Paint_DrawString_EN(20, 11, Time_str, &Font16, WHITE, BLACK);
 #if defined(CONFIG_IMG_SOURCE_EMBEDDED)
-    if (wifi_enable) Paint_ReadBmp(gImage_WIFI, 326, 8, 32, 32);
-    Paint_ReadBmp(gImage_BAT, 370, 17, 32, 16);
+    if (wifi_enable) Paint_BlitImage(326, 8, &Image_WIFI, ROP_COPY);
+    Paint_BlitImage(370, 17, &Image_BAT, ROP_COPY);
 #elif defined(CONFIG_IMG_SOURCE_TFCARD)
     if (wifi_enable) GUI_ReadBmp(BMP_WIFI_PATH, 326, 8);
     GUI_ReadBmp(BMP_BAT_PATH, 370, 17);
@@ -159,14 +161,14 @@ void esp_home(int selection, int Refresh_mode)
 
 // Use the built-in image or the TF card image
 #if defined(CONFIG_IMG_SOURCE_EMBEDDED)
-    Paint_ReadBmp(gImage_file,Icon_X_1,Icon_Y_1,96,96);
-    Paint_ReadBmp(gImage_clock,Icon_X_2,Icon_Y_1,96,96);
-    Paint_ReadBmp(gImage_calendar,Icon_Y_1,Icon_Y_2,96,96);
-    Paint_ReadBmp(gImage_alarm,Icon_X_2,Icon_Y_2,96,96);
-    Paint_ReadBmp(gImage_weather,Icon_Y_1,Icon_Y_3,96,96);
-    Paint_ReadBmp(gImage_network,Icon_X_2,Icon_Y_3,96,96);
-    Paint_ReadBmp(gImage_audio_file,Icon_Y_1,Icon_Y_4,96,96);
-    Paint_ReadBmp(gImage_read,Icon_X_2,Icon_Y_4,96,96);
+    Paint_BlitImage(Icon_X_1,Icon_Y_1,&Image_file,ROP_COPY);
+    Paint_BlitImage(Icon_X_2,Icon_Y_1,&Image_clock,ROP_COPY);
+    Paint_BlitImage(Icon_Y_1,Icon_Y_2,&Image_calendar,ROP_COPY);
+    Paint_BlitImage(Icon_X_2,Icon_Y_2,&Image_alarm,ROP_COPY);
+    Paint_BlitImage(Icon_Y_1,Icon_Y_3,&Image_weather,ROP_COPY);
+    Paint_BlitImage(Icon_X_2,Icon_Y_3,&Image_network,ROP_COPY);
+    Paint_BlitImage(Icon_Y_1,Icon_Y_4,&Image_audio_file,ROP_COPY);
+    Paint_BlitImage(Icon_X_2,Icon_Y_4,&Image_read,ROP_COPY);
 #elif defined(CONFIG_IMG_SOURCE_TFCARD)
     GUI_ReadBmp(BMP_FILE_PATH,Icon_X_1,Icon_Y_1);
     GUI_ReadBmp(BMP_CLOCK_PATH,Icon_X_2,Icon_Y_1);
@@ -244,8 +246,8 @@ void display_home_time_img(Time_data rtc_time)
 
 // Use the built-in image or the TF card image
 #if defined(CONFIG_IMG_SOURCE_EMBEDDED)
-    if (wifi_enable) Paint_ReadBmp(gImage_WIFI, 326, 8, 32, 32);
-    Paint_ReadBmp(gImage_BAT, 370, 17, 32, 16);
+    if (wifi_enable) Paint_BlitImage(326, 8, &Image_WIFI, ROP_COPY);
+    Paint_BlitImage(370, 17, &Image_BAT, ROP_COPY);
 #elif defined(CONFIG_IMG_SOURCE_TFCARD)
     if (wifi_enable) GUI_ReadBmp(BMP_WIFI_PATH, 326, 8);
     GUI_ReadBmp(BMP_BAT_PATH, 370, 17);
@@ -292,9 +294,7 @@ void user_Task(void *arg)
     int last_minutes = -1;
     
     esp_home(home_selection, Global_refresh);
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     last_minutes = rtc_time.minutes;
 
     while (1)
@@ -326,9 +326,7 @@ void user_Task(void *arg)
                     time_count = 0;
                     break;
                 }
-                xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                 rtc_time = PCF85063_GetTime();
-                xSemaphoreGive(rtc_mutex);
                 // Refresh the time and battery level once every minute
                 if(rtc_time.minutes != last_minutes) {
                     last_minutes = rtc_time.minutes;
@@ -362,6 +360,10 @@ void user_Task(void *arg)
             time_count = 0;
         } else if (button == 7) {
             // Enter the sub-menu
+            boot_graph_run(BOOT_DEFERRED);
+            // Whatever the page leaves allocated is freed on the way out
+            int scope = mem_scope_enter(home_page[home_selection]);
+            TRACE_BEGIN_ARG(PAGE, home_selection);
             if (home_selection == 0) {
                 // Enter File browsing
                 file_browser_task();
@@ -389,6 +391,14 @@ void user_Task(void *arg)
                 ESP_LOGI("home", "entry page: %s", home_page[home_selection]);
                 // Other pages can be expanded here
             }
+            TRACE_END(PAGE);
+            mem_scope_leave(scope);
+            // Give back the card handles the page's text left open
+            Font_CloseFiles();
+            // Latest events to /sdcard/trace.bin, see components/perf_trace
+            TRACE_DUMP();
+            // Page turn and playback measurements to NVS
+            energy_prof_flush();
             vTaskDelay(pdMS_TO_TICKS(50)); 
             esp_home(home_selection, Partial_refresh);
             time_count = 0;
@@ -402,13 +412,15 @@ void user_Task(void *arg)
             axp_pwr_off();
         } else if (button == 23) {
             ESP_LOGI("home", "settings");
+            boot_graph_run(BOOT_DEFERRED);
+            int scope = mem_scope_enter("settings");
             page_settings_show();
+            mem_scope_leave(scope);
+            Font_CloseFiles();
             esp_home(home_selection, Partial_refresh);
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         // Refresh the time and battery level once every minute
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
@@ -418,6 +430,53 @@ void user_Task(void *arg)
 }
 
 
+// Boot graph nodes
+static void boot_i2c_init(void)
+{
+    i2c_master_init();   // Initialize the I2C bus
+    i2c_devices_init();  // Initialize all I2C devices
+}
+static void boot_epd_init(void)
+{
+    // E-ink screen pin initialization
+    epaper_port_init();
+    EPD_Init();
+    // Reserve the frame pools before anything takes a frame from them
+    mem_arena_init();
+    // Create a data cache area for the e-paper
+    if((Image_Mono = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL) 
+    {
+        ESP_LOGE(TAG,"Failed to apply for black memory...");
+    }
+}
+static void boot_imu_init(void)
+{
+    // Initialize the six-axis sensor
+    QMI8658_init();
+}
+static void boot_spiffs_init(void)
+{
+    spiffs_init();
+}
+
+// In BOOT_* order: name, init, dependencies, wake reasons that need it at boot
+static const boot_node_t boot_nodes[BOOT_NODE_NUM] = {
+    {"i2c",    boot_i2c_init,   0,                                        WAKE_ANY},
+    {"rtc",    PCF85063_init,   BOOT_BIT(BOOT_I2C),                       WAKE_ANY},
+    {"axp",    axp_init,        BOOT_BIT(BOOT_I2C),                       WAKE_ANY},
+    // The panel is powered from ALDO3 of the PMU
+    {"epd",    boot_epd_init,   BOOT_BIT(BOOT_AXP),                       WAKE_ANY},
+    {"shtc3",  i2c_shtc3_init,  BOOT_BIT(BOOT_I2C),                       WAKE_ANY},
+    {"button", button_Init,     0,                                        WAKE_HOME},
+    {"imu",    boot_imu_init,   BOOT_BIT(BOOT_I2C),                       WAKE_HOME},
+    {"sd",     _sdcard_init,    0,                                        (HOME_NEEDS_SDCARD ? WAKE_HOME : 0) |
+                                                                              (CLOCK_MODE_NEEDS_SDCARD ? WAKE_CLOCK : 0) |
+                                                                              WAKE_CALENDAR | WAKE_WEATHER},
+    // Mounted after the SD card so the two VFS registrations never overlap
+    {"spiffs", boot_spiffs_init, BOOT_BIT(BOOT_SD),                       WAKE_CALENDAR | WAKE_WEATHER},
+    {"audio",  page_audio_int,  BOOT_BIT(BOOT_I2C) | BOOT_BIT(BOOT_AXP),  0},
+};
+
 // Add threads that work in modes such as clock, weather, and calendar
 static void clock_mode_task(void *arg)
 {
@@ -439,23 +498,16 @@ extern "C" void app_main(void)
 {
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_LOGE("EVEN","Hello world!\n");
+    // Does nothing without CONFIG_PERF_TRACE_ENABLE
+    trace_start();
+    energy_prof_init();
 
-    // Initialize the SD card
-    _sdcard_init();
-    i2c_master_init();   // Initialize the I2C bus
-    vTaskDelay(pdMS_TO_TICKS(50)); 
-    i2c_devices_init();  // Initialize all I2C devices
-    vTaskDelay(pdMS_TO_TICKS(50));
-
-    spiffs_init();
-
-    // Initialize the RTC
-    PCF85063_init();
-    // PCF85063_alarm_Time_Disable();
-    // PCF85063_clear_alarm_flag();
+    // Bring up what is needed whatever the wake reason, and the RTC and PMU the reason is read from
+    ESP_ERROR_CHECK(boot_graph_init(boot_nodes, BOOT_NODE_NUM));
+    boot_graph_spawn(boot_graph_select_common(boot_nodes, BOOT_NODE_NUM, WAKE_ANY));
+    boot_graph_run(BOOT_BIT(BOOT_RTC) | BOOT_BIT(BOOT_AXP));
 
-    // Initialize the power supply and perform mode judgment simultaneously
-    axp_init();
+    // Perform mode judgment
     char mode = load_mode_enable_from_nvs();
     if(RTC_INT && mode!=0)
     {
@@ -476,34 +528,14 @@ extern "C" void app_main(void)
         mode = 0;
     }
 
-    // The program officially begins to execute
-    // ESP_LOGE(TAG,"Hello world!\n");
-    // Initialize key
-    button_Init();
-
-    // Initialize the temperature and humidity sensor
-    i2c_shtc3_init();  
-
-    // Initialize the audio
-    page_audio_int();
-
-    // E-ink screen pin initialization
-    epaper_port_init();
-    // EPD_display_BMP(NULL);
-    // vTaskDelay(pdMS_TO_TICKS(500));
-
-    // EPD_Init
-    EPD_Init();
-    // Create a data cache area for the e-paper
-    if((Image_Mono = (UBYTE *)heap_caps_malloc(EPD_SIZE_MONO,MALLOC_CAP_SPIRAM)) == NULL) 
-    {
-        ESP_LOGE(TAG,"Failed to apply for black memory...");
-        // return ESP_FAIL;
-    }
-
     // Confirm the current mode
     ESP_LOGE(TAG,"mode = %d",mode);
 
+    // Only the subsystems this wake-up needs, the rest are started on first use
+    uint32_t wake_reason = (mode == 1) ? WAKE_CLOCK : (mode == 2) ? WAKE_CALENDAR : (mode == 3) ? WAKE_WEATHER : WAKE_HOME;
+    boot_graph_run(boot_graph_select(boot_nodes, BOOT_NODE_NUM, wake_reason));
+    boot_graph_log_timeline();
+
     // Clear the alarm clock
     PCF85063_clear_alarm_flag();
     
@@ -521,8 +553,9 @@ extern "C" void app_main(void)
         PCF85063_alarm_Time_Disable();
         PCF85063_clear_alarm_flag();
 
-        // Initialize the six-axis sensor
-        QMI8658_init();
+#ifdef CONFIG_PERF_BENCH_AT_BOOT
+        perf_bench_boot();
+#endif
 
         Paint_NewImage(Image_Mono, EPD_WIDTH, EPD_HEIGHT, 270, WHITE);
         Paint_SetScale(2);
@@ -534,6 +567,7 @@ extern "C" void app_main(void)
         if (wifi_enable)
         {
             ESP_LOGI("network", "WiFi is enabled and the connection to WiFi begins");
+            axp_set_load_hint(AXP_LOAD_WIFI_MA);
             EPD_Clear();
             vTaskDelay(pdMS_TO_TICKS(500));
             page_network_init_main();
@@ -548,17 +582,17 @@ extern "C" void app_main(void)
 
         // Initialize the mutex lock
         alarm_mutex = xSemaphoreCreateMutex();
-        rtc_mutex = xSemaphoreCreateMutex();
         qmi8658_mutex = xSemaphoreCreateMutex();
 
         // Check whether the creation was successful
         assert(alarm_mutex != NULL);
-        assert(rtc_mutex != NULL);
 
         // Create the main menu task
         xTaskCreate(user_Task, "user_Task", 64 * 1024, NULL, USER_TASK_PRIO, NULL);
         // Create an alarm clock background monitoring task
         xTaskCreate(alarm_task, "alarm_task", 4 * 1024, NULL, ALARM_TASK_PRIO, NULL);
+        // SD card, SPIFFS and audio come up in the background, pages wait for them on entry
+        boot_graph_spawn(BOOT_DEFERRED);
 
         ESP_LOGE("EVEN","Restarting now.\n");
     }
@@ -566,7 +600,7 @@ extern "C" void app_main(void)
         vTaskDelay(portMAX_DELAY);
     }
 
-    heap_caps_free(Image_Mono);
+    mem_free(Image_Mono);
     fflush(stdout);
     // esp_restart();
 }
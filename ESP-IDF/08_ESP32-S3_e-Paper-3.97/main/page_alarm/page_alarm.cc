@@ -14,13 +14,13 @@
 #include "freertos/semphr.h"
 
 #include "epaper_port.h"
+#include "mem_arena.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
 
 #include "page_audio.h"
 
 extern SemaphoreHandle_t alarm_mutex; // Protect alarms
-extern SemaphoreHandle_t rtc_mutex;   // Protect RTC
 extern bool wifi_enable;              // Is the wifi turned on?
 
 Alarm alarms[MAX_ALARMS] = {0};
@@ -28,7 +28,7 @@ Alarm alarms[MAX_ALARMS] = {0};
 static const char *TAG = "alarm";
 
 // 定义墨水屏的数据缓存区
-uint8_t *Image_alarm;
+uint8_t *Image_Mono_alarm;
 
 // E-ink screen sleep time (S)
 #define EPD_Sleep_Time   5
@@ -136,6 +136,24 @@ bool check_alarm(uint8_t hour, uint8_t minute) {
     return false;
 }
 
+// Find the first enabled alarm strictly after hour:minute, wrapping past midnight.
+// Returns the number of minutes until it (1..1440), or 0 if no alarm is enabled.
+int alarm_get_next(uint8_t hour, uint8_t minute, uint8_t *next_hour, uint8_t *next_minute) {
+    int now = hour * 60 + minute;
+    int best = 0;
+    for (int i = 0; i < MAX_ALARMS; ++i) {
+        if (!alarms[i].enabled) continue;
+        int delta = (alarms[i].hour * 60 + alarms[i].minute - now + 24 * 60) % (24 * 60);
+        if (delta == 0) delta = 24 * 60;   // The current minute counts as tomorrow
+        if (best == 0 || delta < best) {
+            best = delta;
+            if (next_hour) *next_hour = alarms[i].hour;
+            if (next_minute) *next_minute = alarms[i].minute;
+        }
+    }
+    return best;
+}
+
 // Print all the alarm clocks
 void print_alarms(void) {
     printf("当前闹钟：\n");
@@ -189,9 +207,7 @@ int Sleep_wake_alarm()
             Refresh_page_alarm();
             break;
         } 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             ESP_LOGI("home", "EPD_Init");
@@ -228,9 +244,7 @@ static void edit_alarm_item(int idx) {
     Time_data rtc_time = {0};
     int last_minutes = -1;
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     last_minutes = rtc_time.minutes;
 
     // display options
@@ -288,9 +302,7 @@ static void edit_alarm_item(int idx) {
                         break;
                     }
                     
-                    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                     rtc_time = PCF85063_GetTime();
-                    xSemaphoreGive(rtc_mutex);
                     if ((rtc_time.minutes != last_minutes)) {
                         last_minutes = rtc_time.minutes;
                         display_alarm_time_img(rtc_time);
@@ -326,9 +338,7 @@ static void edit_alarm_item(int idx) {
                     } else if(button == 7 || button == 8 || button == 22) {
                         break;
                     }
-                    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                     rtc_time = PCF85063_GetTime();
-                    xSemaphoreGive(rtc_mutex);
                     if ((rtc_time.minutes != last_minutes)) {
                         last_minutes = rtc_time.minutes;
                         display_alarm_time_img(rtc_time);
@@ -357,9 +367,7 @@ static void edit_alarm_item(int idx) {
             return;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if ((rtc_time.minutes != last_minutes)) {
             last_minutes = rtc_time.minutes;
             display_alarm_time_img(rtc_time);
@@ -379,12 +387,10 @@ void page_alarm_menu(void)
     Time_data rtc_time = {0};
     int last_minutes = -1;
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     last_minutes = rtc_time.minutes;
 
-    if((Image_alarm = (UBYTE *)heap_caps_malloc(EPD_SIZE_MONO,MALLOC_CAP_SPIRAM)) == NULL) 
+    if((Image_Mono_alarm = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL) 
     {
         ESP_LOGE("alarm","Failed to apply for black memory...");
         // return ESP_FAIL;
@@ -413,6 +419,7 @@ void page_alarm_menu(void)
                 qsort(alarms, MAX_ALARMS, sizeof(Alarm), alarm_compare);
                 save_alarms_to_nvs();
                 xSemaphoreGive(alarm_mutex);
+                PCF85063_int_notify();   // Let alarm_task re-arm the RTC
                 break;
             } else {
                 xSemaphoreTake(alarm_mutex, portMAX_DELAY);
@@ -428,67 +435,75 @@ void page_alarm_menu(void)
             qsort(alarms, MAX_ALARMS, sizeof(Alarm), alarm_compare);
             save_alarms_to_nvs();
             xSemaphoreGive(alarm_mutex);
+            PCF85063_int_notify();   // Let alarm_task re-arm the RTC
             break;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if ((rtc_time.minutes != last_minutes)) {
             last_minutes = rtc_time.minutes;
             display_alarm_time_img(rtc_time);
         }
     }
-    heap_caps_free(Image_alarm);
+    mem_free(Image_Mono_alarm);
 }
 
-// 
+// Alarm clock background task
+// The RTC alarm register is programmed with the next enabled alarm and the task
+// blocks on the RTC INT pin, so nothing touches the I2C bus between alarms.
 void alarm_task(void *param) {
-    int last_minute = -1;
+    int last_ring = -1;      // Day and minute of the last ring, to ring only once
     bool check_alarm_flag = 0;
     int button;
+    uint8_t next_hour = 0, next_minute = 0;
+    int wait_minutes;
+
+    PCF85063_int_isr_init();
     while (1) {
-        // Mutex lock, preventing internal call conflicts
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         Time_data rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
-        // ESP_LOGI("clock", "The RTC reading result: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
-        
-        if (rtc_time.minutes != last_minute) {
-            last_minute = rtc_time.minutes;
-
-            xSemaphoreTake(alarm_mutex, portMAX_DELAY);
-            check_alarm_flag = check_alarm(rtc_time.hours, rtc_time.minutes);
-            xSemaphoreGive(alarm_mutex);
-
-            if (check_alarm_flag) {
-                // Notify the main task to pause and enter the ringing interface
-                ESP_LOGI(TAG, "The time to enter the ringing interface %d:%d",rtc_time.hours, rtc_time.minutes);
-                page_audio_play_memory();
-                // alarm_ring_handler(rtc_time.hours, rtc_time.minutes);
-                while(1)
+        PCF85063_clear_alarm_flag();
+
+        xSemaphoreTake(alarm_mutex, portMAX_DELAY);
+        check_alarm_flag = check_alarm(rtc_time.hours, rtc_time.minutes);
+        wait_minutes = alarm_get_next(rtc_time.hours, rtc_time.minutes, &next_hour, &next_minute);
+        xSemaphoreGive(alarm_mutex);
+
+        int stamp = rtc_time.days * 24 * 60 + rtc_time.hours * 60 + rtc_time.minutes;
+        if (check_alarm_flag && stamp != last_ring) {
+            last_ring = stamp;
+            // Notify the main task to pause and enter the ringing interface
+            ESP_LOGI(TAG, "The time to enter the ringing interface %d:%d",rtc_time.hours, rtc_time.minutes);
+            page_audio_play_memory();
+            // alarm_ring_handler(rtc_time.hours, rtc_time.minutes);
+
+            // Only perform the bell ringing operation until the end of this minute
+            TickType_t ring_end = xTaskGetTickCount() + pdMS_TO_TICKS((60 - rtc_time.seconds) * 1000);
+            while ((int32_t)(ring_end - xTaskGetTickCount()) > 0) {
+                button = wait_key_event_and_return_code(pdMS_TO_TICKS(1000));
+                if(button != -1)
                 {
-                    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
-                    Time_data rtc_time = PCF85063_GetTime();
-                    xSemaphoreGive(rtc_mutex);
-                    if(rtc_time.minutes != last_minute)
-                    {
-                        // Only perform the bell ringing operation for one minute
-                        ESP_LOGI(TAG, "When the time is up, the bell rings to end");
-                        break;
-                    }
-                    button = wait_key_event_and_return_code(pdMS_TO_TICKS(1000));
-                    if(button != -1)
-                    {
-                        // When a key is pressed, the bell stops ringing
-                        ESP_LOGI(TAG, "Press the button and the bell will ring to end");
-                        break;
-                    }
-        
+                    // When a key is pressed, the bell stops ringing
+                    ESP_LOGI(TAG, "Press the button and the bell will ring to end");
+                    break;
                 }
             }
+            ESP_LOGI(TAG, "When the time is up, the bell rings to end");
+        }
+
+        // Arm the RTC for the next alarm and sleep until INT fires or the table changes.
+        // The wait is capped at one hour so a missed edge is recovered.
+        int wait_ms;
+        if (wait_minutes > 0) {
+            PCF85063_alarm_Set_HM(next_hour, next_minute);
+            ESP_LOGI(TAG, "Next alarm %02d:%02d in %d min", next_hour, next_minute, wait_minutes);
+            wait_ms = (wait_minutes * 60 - rtc_time.seconds) * 1000;
+        } else {
+            PCF85063_alarm_Time_Disable();
+            wait_ms = 60 * 60 * 1000;
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (wait_ms > 60 * 60 * 1000) wait_ms = 60 * 60 * 1000;
+        if (wait_ms < 1000) wait_ms = 1000;
+        PCF85063_int_wait(pdMS_TO_TICKS(wait_ms));
     }
 }
 
@@ -499,18 +514,16 @@ void alarm_task(void *param) {
 static void display_alarm_init(void)
 {
 
-    Paint_NewImage(Image_alarm, EPD_WIDTH, EPD_HEIGHT, 270, WHITE);
+    Paint_NewImage(Image_Mono_alarm, EPD_WIDTH, EPD_HEIGHT, 270, WHITE);
     Paint_SetScale(2);
-    Paint_SelectImage(Image_alarm);
+    Paint_SelectImage(Image_Mono_alarm);
     Paint_Clear(WHITE);
 
     char Time_str[16]={0};
     int BAT_Power;
     char BAT_Power_str[16]={0};
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
 
     snprintf(Time_str, sizeof(Time_str), "%02d:%02d", rtc_time.hours, rtc_time.minutes);
     Paint_DrawString_EN(20, 11, Time_str, &Font16, WHITE, BLACK);
@@ -661,7 +674,7 @@ static void display_alarm_init(void)
     Paint_DrawRectangle(20, 562, 460, 652, BLACK, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
     Paint_DrawString_CN(184, 700, " 退出 ", &Font24_UTF8, WHITE, BLACK);
 
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 // Display time and battery level
@@ -689,7 +702,7 @@ static void display_alarm_time_img(Time_data rtc_time)
     Paint_DrawRectangle(375, 22, 395, 30, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
     Paint_DrawRectangle(375, 22, 375+BAT_Power, 30, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
 
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 // Alarm clock selection
@@ -739,7 +752,7 @@ static void display_alarm_selection(int count)
         Paint_DrawString_CN(184, 700, " 退出 ", &Font24_UTF8, BLACK, WHITE);
     }
 
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 // display options
@@ -747,7 +760,7 @@ static void display_alarm_option(void)
 {
     Paint_DrawRectangle(10, 670, 480, 780, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
     Paint_DrawString_CN(208, 700, " 退出 ", &Font24_UTF8, WHITE, BLACK);
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 static void display_alarm_option_img(void)
@@ -761,7 +774,7 @@ static void display_alarm_option_img(void)
     Paint_DrawString_CN(79, 740, " 开/关 ", &Font16_UTF8, WHITE, BLACK);
     Paint_DrawString_CN(300, 740, " 保存退出 ", &Font16_UTF8, WHITE, BLACK);
 
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 static void display_alarm_option_img_Up_Down(int count, int enabled)
@@ -799,7 +812,7 @@ static void display_alarm_option_img_Up_Down(int count, int enabled)
         Paint_DrawString_CN(300, 740, " 保存退出 ", &Font16_UTF8, WHITE, BLACK);
     }
 
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 static void display_alarm_hour_img(int hour, int count, int en)
@@ -826,7 +839,7 @@ static void display_alarm_hour_img(int hour, int count, int en)
         default:
             break;
     }
-    if(en) EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    if(en) EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 static void display_alarm_minute_img(int minute, int count, int en)
@@ -853,7 +866,7 @@ static void display_alarm_minute_img(int minute, int count, int en)
         default:
             break;
     }
-    if(en) EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    if(en) EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 static void display_alarm_enabled_img(int enabled, int count, int en)
@@ -915,17 +928,17 @@ static void display_alarm_enabled_img(int enabled, int count, int en)
             Paint_DrawString_CN(397, 592, "关", &Font16_UTF8, WHITE, BLACK);
         }
     }
-    if(en) EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    if(en) EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 // refresh
 void Forced_refresh_alarm(void)
 {
-    EPD_Display_Base(Image_alarm);
+    EPD_Display_Base(Image_Mono_alarm);
 }
 void Refresh_page_alarm(void)
 {
-    EPD_Display_Partial(Image_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
+    EPD_Display_Partial(Image_Mono_alarm,0,0,EPD_WIDTH,EPD_HEIGHT);
 }
 
 
@@ -20,6 +20,7 @@ extern Alarm alarms[MAX_ALARMS];
 bool add_alarm(uint8_t hour, uint8_t minute);
 bool remove_alarm(uint8_t hour, uint8_t minute);
 bool check_alarm(uint8_t hour, uint8_t minute);
+int alarm_get_next(uint8_t hour, uint8_t minute, uint8_t *next_hour, uint8_t *next_minute);
 void print_alarms(void);
 
 void save_alarms_to_nvs(void);
@@ -20,11 +20,15 @@
 #include <string.h>
 
 #include "epaper_port.h"
+#include "mem_arena.h"
+#include "perf_trace.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
 #include "pcf85063_bsp.h"
 #include "axp_prot.h"
+#include "energy_prof.h"
 #include "sdcard_bsp.h"
+#include "boot_nodes.h"
 
 static const char *TAG = "page_audio";
 
@@ -41,7 +45,6 @@ static volatile record_state_t record_state = RECORD_STATE_IDLE;
 static float duration = 0;
 
 extern bool wifi_enable;                
-extern SemaphoreHandle_t rtc_mutex;  
 // Define the data cache area of the e-paper
 extern uint8_t *Image_Mono;
 uint8_t *Image_Mono_audio;
@@ -84,7 +87,11 @@ int Volume = 90;  // Volume (reset after power failure)
 // I2S write function - Adapted to existing I2S handles
 static esp_err_t bsp_i2s_write(void *audio_buffer, size_t len, size_t *bytes_written, uint32_t timeout_ms)
 {
-    return i2s_channel_write(tx_handle, (char *)audio_buffer, len, bytes_written, timeout_ms);
+    // Mostly time blocked on the DMA, what is left is decoding
+    TRACE_BEGIN_ARG(AUDIO_WRITE, len);
+    esp_err_t ret = i2s_channel_write(tx_handle, (char *)audio_buffer, len, bytes_written, timeout_ms);
+    TRACE_END(AUDIO_WRITE);
+    return ret;
 }
 
 // I2S clock reconfiguration function - Supports dual-channel file playback on TF cards
@@ -171,7 +178,7 @@ void page_audio_play_file(const char* file_path_name)
 {
     int Image_Mono_audio_flag = 0;
     if (Image_Mono_audio == NULL) {
-        Image_Mono_audio = (uint8_t*)heap_caps_malloc(EPD_SIZE_MONO, MALLOC_CAP_SPIRAM);
+        Image_Mono_audio = (uint8_t*)mem_alloc(EPD_SIZE_MONO);
         if (Image_Mono_audio == NULL) {
             ESP_LOGE(TAG, "Image Mono audio cannot be allocated. Cancel playback");
             return;
@@ -184,9 +191,7 @@ void page_audio_play_file(const char* file_path_name)
     Paint_SelectImage(Image_Mono_audio);
     Paint_Clear(WHITE);
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = rtc_time.minutes;
     display_audio_time(rtc_time);
 
@@ -194,6 +199,10 @@ void page_audio_play_file(const char* file_path_name)
     audio_player_state_t state = audio_player_get_state();
     if (state == AUDIO_PLAYER_STATE_SHUTDOWN) {
         ESP_LOGE(TAG, "Audio player not initialized");
+        if(Image_Mono_audio_flag) {
+            mem_free(Image_Mono_audio);
+            Image_Mono_audio = NULL;
+        }
         return;
     }
 
@@ -289,6 +298,7 @@ void page_audio_play_file(const char* file_path_name)
             if (audio_play_state) {
                 // ESP_LOGI(TAG, "stop playing");
                 audio_player_pause();
+                energy_prof_cancel(EP_OP_AUDIO_MINUTE);
 
                 // ESP_LOGI("home", "EPD_Init");
                 EPD_Init();
@@ -327,11 +337,14 @@ void page_audio_play_file(const char* file_path_name)
             break;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
+            // Whole minutes of playback, each with its clock refresh
+            energy_prof_end(EP_OP_AUDIO_MINUTE);
+            if (!audio_play_state) {
+                energy_prof_begin(EP_OP_AUDIO_MINUTE, false);
+            }
             // ESP_LOGI("home", "EPD_Init");
             EPD_Init();
             display_audio_time_last(rtc_time);
@@ -342,20 +355,27 @@ void page_audio_play_file(const char* file_path_name)
             EPD_Sleep();
         }
     } while (state != AUDIO_PLAYER_STATE_IDLE && state != AUDIO_PLAYER_STATE_SHUTDOWN);
+    energy_prof_cancel(EP_OP_AUDIO_MINUTE);
 
     ESP_LOGI("home", "EPD_Init");
     EPD_Init();
     Refresh_page_audio(Image_Mono_audio);
     // Play over. Mute
     esp_codec_dev_set_out_mute(play_dev_handle, true);
-    if(Image_Mono_audio_flag)
-        heap_caps_free(Image_Mono_audio);
+    if(Image_Mono_audio_flag) {
+        mem_free(Image_Mono_audio);
+        Image_Mono_audio = NULL;
+    }
 }
 
 // Play the built-in audio file
 // For an alarm clock
 void page_audio_play_memory(void)
 {
+    // In the low-power modes the codec and keys are only brought up when an alarm rings
+    boot_graph_ensure(BOOT_AUDIO);
+    boot_graph_ensure(BOOT_BUTTON);
+
     audio_player_state_t state = audio_player_get_state();
     if (state == AUDIO_PLAYER_STATE_SHUTDOWN) {
         ESP_LOGE(TAG, "Audio player not initialized");
@@ -393,7 +413,7 @@ void page_audio_play_memory_1(void)
 { 
     int Image_Mono_audio_flag = 0;
     if (Image_Mono_audio == NULL) {
-        Image_Mono_audio = (uint8_t*)heap_caps_malloc(EPD_SIZE_MONO, MALLOC_CAP_SPIRAM);
+        Image_Mono_audio = (uint8_t*)mem_alloc(EPD_SIZE_MONO);
         if (Image_Mono_audio == NULL) {
             ESP_LOGE(TAG, "Image Mono audio cannot be allocated. Cancel playback");
             return;
@@ -406,9 +426,7 @@ void page_audio_play_memory_1(void)
     Paint_SelectImage(Image_Mono_audio);
     Paint_Clear(WHITE);
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = rtc_time.minutes;
     display_audio_time(rtc_time);
 
@@ -424,6 +442,10 @@ void page_audio_play_memory_1(void)
     audio_player_state_t state = audio_player_get_state();
     if (state == AUDIO_PLAYER_STATE_SHUTDOWN) {
         ESP_LOGE(TAG, "Audio player not initialized");
+        if(Image_Mono_audio_flag) {
+            mem_free(Image_Mono_audio);
+            Image_Mono_audio = NULL;
+        }
         return;
     }
 
@@ -463,6 +485,10 @@ void page_audio_play_memory_1(void)
         }
     }
     esp_codec_dev_set_out_mute(play_dev_handle, true);
+    if(Image_Mono_audio_flag) {
+        mem_free(Image_Mono_audio);
+        Image_Mono_audio = NULL;
+    }
 }
 
 // Get the list of audio files in the "music" directory
@@ -542,9 +568,7 @@ static int select_music_file(int menu_idx)
     
     int button;
     int time_count = 0;
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = -1;
     last_minutes = rtc_time.minutes;
     display_audio_time(rtc_time);
@@ -613,9 +637,7 @@ static int select_music_file(int menu_idx)
 
                     num = list_dir_page("/sdcard/music", entries, page_index * page_size, page_size);
 
-                    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                     rtc_time = PCF85063_GetTime();
-                    xSemaphoreGive(rtc_mutex);
                     last_minutes = rtc_time.minutes;
                     display_audio_time(rtc_time);
 
@@ -643,9 +665,7 @@ static int select_music_file(int menu_idx)
             time_count = 0;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             display_audio_time(rtc_time);
@@ -659,7 +679,7 @@ void page_audio_main(void)
     int menu_idx = 0;
 
     // Create a data cache area for the e-ink screen
-    if((Image_Mono_audio = (UBYTE *)heap_caps_malloc(EPD_SIZE_MONO,MALLOC_CAP_SPIRAM)) == NULL) 
+    if((Image_Mono_audio = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL) 
     {
         ESP_LOGE(TAG,"Failed to apply for black memory...");
         // return ESP_FAIL;
@@ -669,9 +689,7 @@ void page_audio_main(void)
     Paint_SelectImage(Image_Mono);
     Paint_Clear(WHITE);
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = rtc_time.minutes;
     display_audio_init(rtc_time);
     display_audio_option(menu_idx);
@@ -730,15 +748,15 @@ void page_audio_main(void)
             break; // quit
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             display_audio_time(rtc_time);
             Refresh_page_audio(Image_Mono);
         }
     }
+    mem_free(Image_Mono_audio);
+    Image_Mono_audio = NULL;
 }
 
 void page_audio_deinit(void)
@@ -774,9 +792,7 @@ void write_wav_header(FILE *fp, uint32_t sample_rate, uint16_t channels, uint16_
 // Generate a file name based on the current time - using RTC time
 static void generate_record_filename(char *filename, size_t max_len, const char *prefix)
 {
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     
     snprintf(filename, max_len, "/sdcard/music/%s_%04d%02d%02d_%02d%02d%02d.wav",
              prefix,
@@ -925,6 +941,8 @@ void page_audio_record_task(void *param)
     // Wait for the configuration to stabilize
     vTaskDelay(pdMS_TO_TICKS(100));
     
+    // The player may hold a handle too, give the recording one of the fonts'
+    Font_CloseFiles();
     FILE *fp = fopen(file_path, "wb");
     if (!fp) {
         ESP_LOGE(TAG, "The recording file cannot be created: %s", file_path);
@@ -1007,9 +1025,7 @@ void page_audio_record_control(void)
     int button = 0;
     bool audio_flag = true;
     
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = rtc_time.minutes;
 
     char duration_str[]="00:00";
@@ -1068,9 +1084,7 @@ void page_audio_record_control(void)
             Refresh_page_audio(Image_Mono);
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             display_audio_time(rtc_time);
@@ -1109,9 +1123,7 @@ int page_audio_file_management(const char* file_path_name)
 
     int button;
     int time_count = 0;
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = -1;
     last_minutes = rtc_time.minutes;
     display_audio_time(rtc_time);
@@ -1156,9 +1168,7 @@ int page_audio_file_management(const char* file_path_name)
             break;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             display_audio_time(rtc_time);
@@ -1319,9 +1329,7 @@ void show_file_info(const char* file_path_name)
 
     int button;
     int time_count = 0;
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = -1;
     last_minutes = rtc_time.minutes;
     while(1)
@@ -1337,9 +1345,7 @@ void show_file_info(const char* file_path_name)
             time_count = 0;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             display_audio_time(rtc_time);
@@ -1824,9 +1830,7 @@ static int Sleep_wake_audio(void)
             Refresh_page_audio(Image_Mono);
             break;
         } 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             ESP_LOGI("home", "EPD_Init");
@@ -1,10 +1,12 @@
 #include "page_clock.h"
 #include "esp_log.h"
 #include "pcf85063_bsp.h"
+#include "time_sync.h"
 #include "page_network.h"
 #include "button_bsp.h"
 #include "shtc3_bsp.h"
 #include "axp_prot.h"
+#include "energy_prof.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -20,6 +22,7 @@
 #include "esp_err.h"   
 
 #include "epaper_port.h"
+#include "mem_arena.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
 
@@ -30,6 +33,7 @@
 #include "nvs_flash.h"
 #include "nvs.h"
 #include <inttypes.h>
+#include <string.h>
 
 // Time zone configuration structure
 typedef struct {
@@ -83,7 +87,6 @@ static const timezone_config_t timezone_list[] = {
 #define Unattended_Time  10
 
 
-extern SemaphoreHandle_t rtc_mutex; 
 extern bool wifi_enable; 
 extern Alarm alarms[MAX_ALARMS];
 
@@ -108,30 +111,10 @@ static void display_clock_img(Time_data rtc_time, int Refresh_mode);
 static void display_calendar_img(Time_data rtc_time, LunarInfo* month_info);
 static void display_clock_mode_img(Time_data rtc_time);
 
+// Get the time from NTP. On success the RTC has already been set (and trimmed) by time_sync
 int get_time_from_ntp(struct tm *t)
 {
-    esp_sntp_stop(); // Stop first to prevent repeated initialization
-    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, "ntp1.aliyun.com");
-    esp_sntp_init();
-
-    // Wait for synchronization
-    time_t now = 0;
-    struct tm timeinfo = {0};
-    int retry = 0;
-    const int retry_count = 10;
-    while (retry++ < retry_count) {
-        time(&now);
-        localtime_r(&now, &timeinfo);
-        if (timeinfo.tm_year > (2020 - 1900)) {
-            *t = timeinfo;
-            esp_sntp_stop();
-            return 0;
-        }
-        vTaskDelay(pdMS_TO_TICKS(500));
-    }
-    esp_sntp_stop();
-    return -1;
+    return time_sync_now(5000, t);
 }
 
 
@@ -215,19 +198,28 @@ static esp_err_t save_timezone_index_to_nvs(int timezone_idx)
 }
 
 
-void load_clock_from_nvs(void) {
+// The clock face shown before power-off is described by Clock_TH_Old alone, so this
+// small blob is all clock mode keeps between wake-ups (NVS spreads the writes)
+bool load_clock_from_nvs(void) {
     nvs_handle_t handle;
     size_t required_size = sizeof(Clock_TH_Old);
+    esp_err_t err = ESP_FAIL;
     if (nvs_open("clock_th", NVS_READONLY, &handle) == ESP_OK) {
-        nvs_get_blob(handle, "th_data", &Clock_TH_Old, &required_size);
+        err = nvs_get_blob(handle, "th_data", &Clock_TH_Old, &required_size);
         nvs_close(handle);
     }
+    return err == ESP_OK && required_size == sizeof(Clock_TH_Old);
 }
 void save_clock_to_nvs_if_changed(void) {
     nvs_handle_t handle;
+    Clock_TH stored;
+    size_t required_size = sizeof(stored);
     if (nvs_open("clock_th", NVS_READWRITE, &handle) == ESP_OK) {
-        nvs_set_blob(handle, "th_data", &Clock_TH_Old, sizeof(Clock_TH_Old));
-        nvs_commit(handle);
+        if (nvs_get_blob(handle, "th_data", &stored, &required_size) != ESP_OK ||
+            required_size != sizeof(stored) || memcmp(&stored, &Clock_TH_Old, sizeof(stored)) != 0) {
+            nvs_set_blob(handle, "th_data", &Clock_TH_Old, sizeof(Clock_TH_Old));
+            nvs_commit(handle);
+        }
         nvs_close(handle);
     }
 }
@@ -329,9 +321,7 @@ void page_clock_init(void)
         {
             ESP_LOGI("clock", "The NTP successfully obtained the time and wrote it to the RTC");
             tm_to_timedata(&ntp_tm, &rtc_time);
-            ESP_LOGI("clock", "Prepare to write into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
-            PCF85063_SetTime(rtc_time);
-            vTaskDelay(pdMS_TO_TICKS(1000));
+            ESP_LOGI("clock", "Written into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
             break;
         }
         i++;
@@ -348,7 +338,7 @@ void page_clock_show(void)
     int last_hours = -1;
     int sleep_js = 0;
 
-    if((Image_Mono_last = (UBYTE *)heap_caps_malloc(EPD_SIZE_MONO,MALLOC_CAP_SPIRAM)) == NULL) 
+    if((Image_Mono_last = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL) 
     {
         ESP_LOGE("clock","Failed to apply for black memory...");
         // return ESP_FAIL;
@@ -364,16 +354,11 @@ void page_clock_show(void)
             if (wifi_is_connected() && get_time_from_ntp(&ntp_tm) == 0) {
                 ESP_LOGI("clock", "The NTP successfully obtained the time and wrote it to the RTC");
                 tm_to_timedata(&ntp_tm, &rtc_time);
-                ESP_LOGI("clock", "Prepare to write into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
-                xSemaphoreTake(rtc_mutex, portMAX_DELAY);
-                PCF85063_SetTime(rtc_time);
-                xSemaphoreGive(rtc_mutex);
+                ESP_LOGI("clock", "Written into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
             } else {
                 ESP_LOGW("clock", "The NTP time acquisition failed. Read the RTC time");
                 // Mutex lock, preventing internal call conflicts
-                xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                 rtc_time = PCF85063_GetTime();
-                xSemaphoreGive(rtc_mutex);
                 ESP_LOGI("clock", "The RTC reading result: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
 
             }
@@ -386,9 +371,7 @@ void page_clock_show(void)
             ESP_LOGI("clock", "EPD_Sleep");
             EPD_Sleep();
         } else {
-            xSemaphoreTake(rtc_mutex, portMAX_DELAY);
             rtc_time = PCF85063_GetTime();
-            xSemaphoreGive(rtc_mutex);
             ESP_LOGI("clock", "The RTC reading result: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
         }
 
@@ -413,10 +396,7 @@ void page_clock_show(void)
                 alarm_time.minutes += 1;
                 alarm_time.seconds = 0;
                 PCF85063_alarm_Time_Enabled(alarm_time);
-                if (!sd_write_buffer_to_file(CLOCK_PARTIAL_PATH, Image_Mono, EPD_SIZE_MONO)) {
-                    ESP_LOGW("sdio", "Failed to save the local cache to SD: %s", CLOCK_PARTIAL_PATH);
-                    save_clock_to_nvs_if_changed();
-                }
+                save_clock_to_nvs_if_changed();
                 vTaskDelay(pdMS_TO_TICKS(50));
                 axp_pwr_off();
             } 
@@ -447,7 +427,7 @@ void page_clock_show(void)
             break;
         }
     }
-    heap_caps_free(Image_Mono_last);
+    mem_free(Image_Mono_last);
 }
 
 // Used in clock mode
@@ -455,9 +435,17 @@ void page_clock_show_mode()
 {
     load_alarms_from_nvs();
     Time_data rtc_time = PCF85063_GetTime();
+    bool ntp_due = rtc_time.hours == 8 && rtc_time.minutes == 0 && time_sync_due(&rtc_time);
 
-    // Clock calibration time
-    if(rtc_time.hours == 8 && rtc_time.minutes == 0)
+    // Partial wake-ups are all alike, measuring one in ten is enough. Alarms are left out.
+    ep_op_t ep_op = ntp_due ? EP_OP_SYNC_WAKE :
+                    (rtc_time.minutes == 0 || rtc_time.minutes == 30) ? EP_OP_CLOCK_FULL : EP_OP_CLOCK_WAKE;
+    if ((ep_op != EP_OP_CLOCK_WAKE || rtc_time.minutes % 10 == 5) && !check_alarm(rtc_time.hours, rtc_time.minutes)) {
+        energy_prof_begin(ep_op, true);
+    }
+
+    // Clock calibration time, daily until the RTC is trimmed, then up to a week apart
+    if(ntp_due)
     {
         if(page_network_init_mode())
         {   
@@ -468,8 +456,7 @@ void page_clock_show_mode()
             if (wifi_is_connected() && get_time_from_ntp(&ntp_tm) == 0) {
                 ESP_LOGI("clock", "The NTP successfully obtained the time and wrote it to the RTC");
                 tm_to_timedata(&ntp_tm, &rtc_time);
-                ESP_LOGI("clock", "Prepare to write into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
-                PCF85063_SetTime(rtc_time);
+                ESP_LOGI("clock", "Written into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
             }
         }
         
@@ -501,6 +488,8 @@ void page_clock_show_mode()
     alarm_time.minutes += 1;
     alarm_time.seconds = 0;
     PCF85063_alarm_Time_Enabled(alarm_time);
+    energy_prof_end(ep_op);
+    energy_prof_flush();
     vTaskDelay(pdMS_TO_TICKS(50));
     axp_pwr_off();
 }
@@ -508,38 +497,24 @@ void page_clock_show_mode()
 
 
 // Wake-up time setting
+// Wake for the next enabled alarm if it is still today, otherwise at midnight to turn the page
 void Wake_up_time_setting_calendar(Time_data rtc_time)
 {
-    for (size_t i = 0; i < MAX_ALARMS; i++)
-    {
-        if (alarms[i].enabled){
-            if(alarms[i].hour > rtc_time.hours){
-                Time_data alarm_time = rtc_time;
-                alarm_time.hours = alarms[i].hour;
-                alarm_time.minutes = alarms[i].minute;
-                PCF85063_alarm_Time_Enabled(alarm_time);
-                break;
-            } else if((alarms[i].hour == rtc_time.hours) && (alarms[i].minute > rtc_time.minutes)){
-                Time_data alarm_time = rtc_time;
-                alarm_time.hours = alarms[i].hour;
-                alarm_time.minutes = alarms[i].minute;
-                PCF85063_alarm_Time_Enabled(alarm_time);
-                break;
-            } else {
-                Time_data alarm_time = rtc_time;
-                alarm_time.days += 1;
-                alarm_time.hours = 0;
-                alarm_time.minutes = 0;
-                PCF85063_alarm_Time_Enabled(alarm_time);
-            }
-        } else {
-            Time_data alarm_time = rtc_time;
-            alarm_time.days += 1;
-            alarm_time.hours = 0;
-            alarm_time.minutes = 0;
-            PCF85063_alarm_Time_Enabled(alarm_time);
-        }
+    uint8_t next_hour = 0, next_minute = 0;
+    int wait_minutes = alarm_get_next(rtc_time.hours, rtc_time.minutes, &next_hour, &next_minute);
+    int minutes_to_midnight = 24 * 60 - (rtc_time.hours * 60 + rtc_time.minutes);
+
+    Time_data alarm_time = rtc_time;
+    alarm_time.seconds = 0;
+    if (wait_minutes > 0 && wait_minutes < minutes_to_midnight) {
+        alarm_time.hours = next_hour;
+        alarm_time.minutes = next_minute;
+    } else {
+        alarm_time.days += 1;
+        alarm_time.hours = 0;
+        alarm_time.minutes = 0;
     }
+    PCF85063_alarm_Time_Enabled(alarm_time);
 }
 
 // calendar
@@ -565,9 +540,7 @@ void page_calendar_show(void)
         ESP_LOGE("lunar", "PSRAM allocation failed");
     }
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     last_days = rtc_time.days;
     last_hour = rtc_time.hours;
     display_calendar_img(rtc_time, month_info);
@@ -578,20 +551,13 @@ void page_calendar_show(void)
             if (get_time_from_ntp(&ntp_tm) == 0) {
                 ESP_LOGI("clock", "The NTP successfully obtained the time and wrote it to the RTC");
                 tm_to_timedata(&ntp_tm, &rtc_time);
-                xSemaphoreTake(rtc_mutex, portMAX_DELAY);
-                PCF85063_SetTime(rtc_time);
-                xSemaphoreGive(rtc_mutex);
             } else {
                 ESP_LOGW("clock", "The NTP time acquisition failed. Read the RTC time");
-                xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                 rtc_time = PCF85063_GetTime();
-                xSemaphoreGive(rtc_mutex);
             }
             force_update = 0;
         } else {
-            xSemaphoreTake(rtc_mutex, portMAX_DELAY);
             rtc_time = PCF85063_GetTime();
-            xSemaphoreGive(rtc_mutex);
         }
 
         //print time
@@ -680,13 +646,19 @@ void page_calendar_show_mode()
     Time_data rtc_time = PCF85063_GetTime();
     Wake_up_time_setting_calendar(rtc_time);
 
+    // Alarm wake-ups are left out
+    ep_op_t ep_op = time_sync_due(&rtc_time) ? EP_OP_SYNC_WAKE : EP_OP_CALENDAR_WAKE;
+    if (!check_alarm(rtc_time.hours, rtc_time.minutes)) {
+        energy_prof_begin(ep_op, true);
+    }
+
     LunarInfo* month_info = (LunarInfo*)heap_caps_calloc(31, sizeof(LunarInfo), MALLOC_CAP_SPIRAM);
     if (!month_info) {
         ESP_LOGE("lunar", "PSRAM allocation failed");
     }
 
     if((!check_alarm(rtc_time.hours, rtc_time.minutes)) || (rtc_time.hours == 0 && rtc_time.minutes == 0)){
-        if(page_network_init_mode())
+        if(ep_op == EP_OP_SYNC_WAKE && page_network_init_mode())
         {   
             setenv("TZ", "CST-8", 1);
             tzset();
@@ -694,8 +666,7 @@ void page_calendar_show_mode()
             if (wifi_is_connected() && get_time_from_ntp(&ntp_tm) == 0) {
                 ESP_LOGI("clock", "The NTP successfully obtained the time and wrote it to the RTC");
                 tm_to_timedata(&ntp_tm, &rtc_time);
-                ESP_LOGI("clock", "Prepare to write into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
-                PCF85063_SetTime(rtc_time);
+                ESP_LOGI("clock", "Written into the RTC: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years+2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
             }
         }
         display_calendar_img(rtc_time, month_info);
@@ -710,6 +681,8 @@ void page_calendar_show_mode()
         EPD_Sleep();
         page_audio_play_memory();
     }
+    energy_prof_end(ep_op);
+    energy_prof_flush();
     vTaskDelay(pdMS_TO_TICKS(50));
     axp_pwr_off();
 }
@@ -1047,9 +1020,9 @@ static void display_clock_nvs_img()
     char minutes[10] = {0};
     const char* week_str[] = {"星期日", "星期一", "星期二", "星期三", "星期四", "星期五", "星期六"};
 
-    ESP_LOGI("clock", "current time: %04d-%02d-%02d %02d:%02d week:%s", Clock_TH_Old.years + 2000, Clock_TH_Old.months, Clock_TH_Old.days, Clock_TH_Old.hours, Clock_TH_Old.minutes, week_str[Clock_TH_Old.week]);
+    ESP_LOGI("clock", "current time: %04d-%02d-%02d %02d:%02d week:%s", Clock_TH_Old.years + 2000, Clock_TH_Old.months, Clock_TH_Old.days, Clock_TH_Old.hours, Clock_TH_Old.minutes, week_str[Clock_TH_Old.week % 7]);
 
-    snprintf(Time_str, sizeof(Time_str), "%04d-%02d-%02d %s", Clock_TH_Old.years + 2000, Clock_TH_Old.months, Clock_TH_Old.days, week_str[Clock_TH_Old.week]);
+    snprintf(Time_str, sizeof(Time_str), "%04d-%02d-%02d %s", Clock_TH_Old.years + 2000, Clock_TH_Old.months, Clock_TH_Old.days, week_str[Clock_TH_Old.week % 7]);
 
     snprintf(hours, sizeof(hours), "%02d", Clock_TH_Old.hours);
     snprintf(minutes, sizeof(minutes), "%02d", Clock_TH_Old.minutes);
@@ -1082,64 +1055,86 @@ static void display_clock_nvs_img()
     Paint_DrawString_CN(568, 410, BAT_str, &Font18_UTF8, WHITE, BLACK);
 }
 
+// Minute update in clock mode. The frame shown before power-off is rebuilt in RAM
+// from the saved Clock_TH_Old, then only the fields that changed are redrawn.
 static void display_clock_mode_img(Time_data rtc_time)
 {
-    Paint_NewImage(Image_Mono, EPD_WIDTH, EPD_HEIGHT, 0, WHITE);
-    Paint_SetScale(2);
-    Paint_SelectImage(Image_Mono);
-    Paint_Clear(WHITE);
-
-    // The SD card reads the corresponding file and writes it into the cache
-    if (!sd_read_file_to_buffer(CLOCK_PARTIAL_PATH, Image_Mono, EPD_SIZE_MONO)) {
-        ESP_LOGI("sdio", "The local cache file is not loaded and is displayed using the current buffer");
-        load_clock_from_nvs();
-        display_clock_nvs_img();
+    if (!load_clock_from_nvs()) {
+        ESP_LOGI("clock", "No saved clock state, doing a full refresh");
+        display_clock_init();
+        display_clock_img(rtc_time, Global_refresh);
+        return;
     }
+    display_clock_nvs_img();
 
     EPD_Display_Partial(Image_Mono, 0, 0, EPD_WIDTH, EPD_HEIGHT);
 
     ESP_LOGI("clock", "current time: %04d-%02d-%02d %02d:%02d:%02d", rtc_time.years + 2000, rtc_time.months, rtc_time.days, rtc_time.hours, rtc_time.minutes, rtc_time.seconds);
-    
+
+    // A missed wake-up can leave the hour or date behind as well
+    if (rtc_time.hours != Clock_TH_Old.hours) {
+        char hours[10] = {0};
+        Clock_TH_Old.hours = rtc_time.hours;
+        snprintf(hours, sizeof(hours), "%02d", rtc_time.hours);
+        Paint_DrawString_EN(129, 157, hours, &Font182, WHITE, BLACK);
+    }
+    if (rtc_time.days != Clock_TH_Old.days || rtc_time.months != Clock_TH_Old.months || rtc_time.years != Clock_TH_Old.years) {
+        const char* week_str[] = {"星期日", "星期一", "星期二", "星期三", "星期四", "星期五", "星期六"};
+        char Time_str[50] = {0};
+        Clock_TH_Old.years = rtc_time.years;
+        Clock_TH_Old.months = rtc_time.months;
+        Clock_TH_Old.days = rtc_time.days;
+        Clock_TH_Old.week = rtc_time.week;
+        snprintf(Time_str, sizeof(Time_str), "%04d-%02d-%02d %s", rtc_time.years + 2000, rtc_time.months, rtc_time.days, week_str[rtc_time.week % 7]);
+        Paint_DrawString_CN(125, 410, Time_str, &Font18_UTF8, WHITE, BLACK);
+    }
+
     char minutes[10] = {0};
     Clock_TH_Old.minutes = rtc_time.minutes;
     snprintf(minutes, sizeof(minutes), "%02d", rtc_time.minutes);
     Paint_DrawString_EN(431, 157, minutes, &Font182, WHITE, BLACK);
 
+    // Temperature, humidity and battery are redrawn only when their text changes
     float temperature_val = 0.0f;
     float humidity_val = 0.0f;
     char temperature_str[10] = {0};
     char humidity_str[10] = {0};
+    char old_str[10] = {0};
     SHTC3_GetEnvTemperatureHumidity(&temperature_val, &humidity_val);
     ESP_LOGI("TemperatureHumidity", "Temperature = %.2f C, Humidity = %.2f%%", temperature_val, humidity_val);
-    Clock_TH_Old.temperature_val = temperature_val;
-    Clock_TH_Old.humidity_val = humidity_val;
     snprintf(temperature_str, sizeof(temperature_str), "%2.1f℃", temperature_val);
+    snprintf(old_str, sizeof(old_str), "%2.1f℃", Clock_TH_Old.temperature_val);
+    if (strcmp(temperature_str, old_str) != 0) {
+        Clock_TH_Old.temperature_val = temperature_val;
+        Paint_DrawRectangle(208, 67, 328, 108, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_CN(208, 67, temperature_str, &Font24_UTF8, WHITE, BLACK);
+    }
     snprintf(humidity_str, sizeof(humidity_str), "%2.1f％", humidity_val);
-    Paint_DrawRectangle(208, 67, 328, 108, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawString_CN(208, 67, temperature_str, &Font24_UTF8, WHITE, BLACK);
-    Paint_DrawRectangle(510, 67, 630, 108, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawString_CN(510, 67, humidity_str, &Font24_UTF8, WHITE, BLACK);    
+    snprintf(old_str, sizeof(old_str), "%2.1f％", Clock_TH_Old.humidity_val);
+    if (strcmp(humidity_str, old_str) != 0) {
+        Clock_TH_Old.humidity_val = humidity_val;
+        Paint_DrawRectangle(510, 67, 630, 108, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_CN(510, 67, humidity_str, &Font24_UTF8, WHITE, BLACK);
+    }
 
     int BAT_Power;
     char BAT_str[10] = {0};
     BAT_Power = get_battery_power();
     ESP_LOGI("BAT_Power", "BAT_Power = %d%%", BAT_Power);
-    Clock_TH_Old.BAT_Power = BAT_Power;
-    snprintf(BAT_str, sizeof(BAT_str), "%d％", BAT_Power);
-    if (BAT_Power == -1) BAT_Power = 20;
-    else BAT_Power = BAT_Power * 20 / 100;
-    Paint_DrawRectangle(531, 423, 551, 431, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawRectangle(531, 423, 531 + BAT_Power, 431, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawRectangle(568, 410, 688, 441, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawString_CN(568, 410, BAT_str, &Font18_UTF8, WHITE, BLACK);
+    if (BAT_Power != Clock_TH_Old.BAT_Power) {
+        Clock_TH_Old.BAT_Power = BAT_Power;
+        snprintf(BAT_str, sizeof(BAT_str), "%d％", BAT_Power);
+        if (BAT_Power == -1) BAT_Power = 20;
+        else BAT_Power = BAT_Power * 20 / 100;
+        Paint_DrawRectangle(531, 423, 551, 431, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawRectangle(531, 423, 531 + BAT_Power, 431, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawRectangle(568, 410, 688, 441, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_CN(568, 410, BAT_str, &Font18_UTF8, WHITE, BLACK);
+    }
 
     EPD_Display_Partial(Image_Mono, 0, 0, EPD_WIDTH, EPD_HEIGHT);
 
-    // The data in the cache is written to the corresponding SD card
-    if (!sd_write_buffer_to_file(CLOCK_PARTIAL_PATH, Image_Mono, EPD_SIZE_MONO)) {
-        ESP_LOGW("sdio", "Failed to save the local cache to SD: %s", CLOCK_PARTIAL_PATH);
-        save_clock_to_nvs_if_changed();
-    }
+    save_clock_to_nvs_if_changed();
 }
 
 
@@ -1204,10 +1199,7 @@ static void display_clock_img(Time_data rtc_time, int Refresh_mode)
     }
 
     if(load_mode_enable_from_nvs()) {
-        if (!sd_write_buffer_to_file(CLOCK_PARTIAL_PATH, Image_Mono, EPD_SIZE_MONO)) {
-            ESP_LOGW("sdio", "Failed to save the local cache to SD: %s", CLOCK_PARTIAL_PATH);
-            save_clock_to_nvs_if_changed();
-        }
+        save_clock_to_nvs_if_changed();
     } else {
         for (size_t i = 0; i < EPD_SIZE_MONO; i++)
         {
@@ -4,6 +4,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
+
+// Clock mode only touches the SD card for icons and fonts that are not built in
+#if defined(CONFIG_IMG_SOURCE_EMBEDDED) && defined(CONFIG_FONT18_EMBEDDED) && \
+    defined(CONFIG_FONT24_EMBEDDED) && defined(CONFIG_Auxiliary_Font_EMBEDDED)
+#define CLOCK_MODE_NEEDS_SDCARD 0
+#else
+#define CLOCK_MODE_NEEDS_SDCARD 1
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -7,13 +7,20 @@
 #include "sdcard_bsp.h"
 #include <string.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include "dirent.h"
+#include "esp_heap_caps.h"
 
 #include "epaper_port.h"
+#include "mem_arena.h"
+#include "perf_trace.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
+#include "text_layout.h"
 #include "pcf85063_bsp.h"
 #include "axp_prot.h"
+#include "energy_prof.h"
+#include "kv_log.h"
 
 #include <nvs.h>
 #include <nvs_flash.h>
@@ -43,7 +50,6 @@
 #define MARGIN_LEFT   10    // leftmargin
 #define MARGIN_TOP    10    // top margin
 
-extern SemaphoreHandle_t rtc_mutex;   // Protect RTC
 extern bool wifi_enable;                       // Is the wifi turned on?
 
 static const char *TAG = "page_fiction";
@@ -92,12 +98,30 @@ static const char* font_names_1[FONT_SIZE_MAX] = {
 };
 
 
+// Progress and bookmarks of every book, see components/kv_log
+#define FICTION_KV_PATH     "/sdcard/bookmarks/progress.kv"
+#define KV_TAG_PROGRESS     0       // Bookmarks take the tags from 1 up
+static kv_log_t* progress_log = NULL;
+
+typedef struct __attribute__((packed)) {
+    uint32_t position;
+    int32_t page;
+} progress_rec_t;
+
+// Followed by the description and the content preview, each ending with its zero
+typedef struct __attribute__((packed)) {
+    uint32_t position;
+    int32_t page;
+    float progress;
+} bookmark_rec_t;
+
 static uint8_t* bookmark_display_buffer = NULL;  // Bookmark display cache
 static uint8_t* bookmark_preview_buffer = NULL;  // Bookmark preview cache
 static uint8_t* page_backup_buffer = NULL;       // Page backup cache
 
 // Novel cache area
 char lines_char[25][256] = {0};
+static tl_line_t lines_layout[25];      // Indent and justification of each line
 static bool lines_char_bool = 0;
 
 // Add a function declaration for calculating display parameters
@@ -236,25 +260,91 @@ void create_bookmark_directory()
     DIR* dir = opendir(bookmark_dir);
     if (dir) {
         closedir(dir);
-        ESP_LOGI(TAG, "Bookmark directory exists: %s", bookmark_dir);
         return;
     }
     
     // The directory does not exist. Try to create it
     ESP_LOGI(TAG, "Creating bookmark directory: %s", bookmark_dir);
-    char temp_file[300];
-    snprintf(temp_file, sizeof(temp_file), "%s/.keep", bookmark_dir);
-    FILE* fp = fopen(temp_file, "w");
-    if (fp) {
-        fprintf(fp, "bookmark directory marker\n");
-        fclose(fp);
+    if (mkdir(bookmark_dir, 0775) == 0) {
         ESP_LOGI(TAG, "Created bookmark directory successfully");
     } else {
         ESP_LOGE(TAG, "Failed to create bookmark directory");
     }
 }
 
-// Get the path of the bookmark file
+// Open the progress log on first use, it stays open until the book is closed
+static bool open_progress_log(void)
+{
+    if (progress_log) return true;
+    create_bookmark_directory();
+    // Opening may compact, which takes a card handle more than the log
+    Font_CloseFiles();
+    esp_err_t err = kv_log_open(FICTION_KV_PATH, CONFIG_KV_LOG_SIZE_KB * 1024, &progress_log);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot open %s: %s", FICTION_KV_PATH, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+// A put that compacts first gets the font files' handles for the copy
+static esp_err_t put_progress_log(uint64_t book, uint32_t tag, const void* data, size_t len)
+{
+    if (kv_log_full(progress_log, len)) Font_CloseFiles();
+    return kv_log_put(progress_log, book, tag, data, len);
+}
+
+static void close_progress_log(void)
+{
+    kv_log_close(progress_log);
+    progress_log = NULL;
+}
+
+// Room for one more bookmark at the end of the array, NULL if out of memory
+static bookmark_t* bookmark_append(fiction_context_t* ctx)
+{
+    if (ctx->bookmark_count == ctx->bookmark_capacity) {
+        int capacity = ctx->bookmark_capacity ? ctx->bookmark_capacity * 2 : 8;
+        bookmark_t* grown = (bookmark_t*)heap_caps_realloc(ctx->bookmarks, capacity * sizeof(bookmark_t), MALLOC_CAP_SPIRAM);
+        if (!grown) {
+            ESP_LOGE(TAG, "No memory for %d bookmarks", capacity);
+            return NULL;
+        }
+        ctx->bookmarks = grown;
+        ctx->bookmark_capacity = capacity;
+    }
+    bookmark_t* bm = &ctx->bookmarks[ctx->bookmark_count++];
+    memset(bm, 0, sizeof(*bm));
+    return bm;
+}
+
+static void free_bookmarks(fiction_context_t* ctx)
+{
+    heap_caps_free(ctx->bookmarks);
+    ctx->bookmarks = NULL;
+    ctx->bookmark_count = 0;
+    ctx->bookmark_capacity = 0;
+}
+
+// Write one bookmark to the log under its tag
+static esp_err_t put_bookmark(const fiction_context_t* ctx, const bookmark_t* bm)
+{
+    uint8_t buf[sizeof(bookmark_rec_t) + sizeof(bm->description) + sizeof(bm->content_preview)];
+    bookmark_rec_t rec = { (uint32_t)bm->position, bm->page, bm->progress };
+    memcpy(buf, &rec, sizeof(rec));
+    size_t len = sizeof(rec);
+    size_t n = strnlen(bm->description, sizeof(bm->description) - 1);
+    memcpy(buf + len, bm->description, n);
+    len += n;
+    buf[len++] = '\0';
+    n = strnlen(bm->content_preview, sizeof(bm->content_preview) - 1);
+    memcpy(buf + len, bm->content_preview, n);
+    len += n;
+    buf[len++] = '\0';
+    return put_progress_log(ctx->book_id, bm->tag, buf, len);
+}
+
+// Get the path of the bookmark file written before the progress log
 void get_bookmark_filepath(const char* txt_filepath, char* bookmark_filepath, int max_len)
 {
     const char* filename = strrchr(txt_filepath, '/');
@@ -268,84 +358,116 @@ void get_bookmark_filepath(const char* txt_filepath, char* bookmark_filepath, in
     snprintf(bookmark_filepath, max_len, "/sdcard/bookmarks/%s.bookmarks", filename);
 }
 
-// Save the bookmarks to the unified directory
-void fiction_save_bookmarks(const fiction_context_t* ctx)
+// Move the bookmarks of a file written before the progress log into it
+static void fiction_import_bookmarks(fiction_context_t* ctx)
 {
-    create_bookmark_directory();
-    
     char bookmark_file[MAX_FILEPATH_LEN + 32];
     get_bookmark_filepath(ctx->filepath, bookmark_file, sizeof(bookmark_file));
     
-    FILE* fp = fopen(bookmark_file, "w");
-    if (fp) {
-        fprintf(fp, "# Bookmarks for: %s\n", ctx->filepath);
-        fprintf(fp, "%d\n", ctx->bookmark_count);
-        
-        for (int i = 0; i < ctx->bookmark_count; i++) {
-            fprintf(fp, "%zu %d %.2f %s %s\n", 
-                    ctx->bookmarks[i].position, 
-                    ctx->bookmarks[i].page,
-                    ctx->bookmarks[i].progress,
-                    ctx->bookmarks[i].description,
-                    ctx->bookmarks[i].content_preview);
-        }
-        fclose(fp);
-        ESP_LOGI(TAG, "Bookmarks saved to: %s (%d bookmarks)", bookmark_file, ctx->bookmark_count);
+    FILE* fp = fopen(bookmark_file, "r");
+    if (!fp) return;
+
+    char line[256];
+    // Skip the comment line
+    if (fgets(line, sizeof(line), fp) && line[0] == '#') {
     } else {
-        ESP_LOGE(TAG, "Failed to save bookmarks to: %s", bookmark_file);
+        fseek(fp, 0, SEEK_SET);
+    }
+    
+    int count = 0;
+    if (fscanf(fp, "%d\n", &count) == 1) {
+        for (int i = 0; i < count; i++) {
+            bookmark_t* bm = bookmark_append(ctx);
+            if (!bm) break;
+            if (fscanf(fp, "%zu %d %f %63s %127[^\n]\n", 
+                      &bm->position, 
+                      &bm->page,
+                      &bm->progress,
+                      bm->description,
+                      bm->content_preview) != 5) {
+                ctx->bookmark_count--;
+                break;
+            }
+            bm->tag = i + 1;
+        }
     }
+    fclose(fp);
+
+    bool saved = true;
+    for (int i = 0; i < ctx->bookmark_count && saved; i++) {
+        saved = put_bookmark(ctx, &ctx->bookmarks[i]) == ESP_OK;
+    }
+    if (saved) {
+        remove(bookmark_file);
+    }
+    ESP_LOGI(TAG, "Bookmarks imported from: %s (%d bookmarks)", bookmark_file, ctx->bookmark_count);
 }
 
-// Load bookmarks from the unified directory
+// Load the bookmarks of the book from the progress log
 void fiction_load_bookmarks(fiction_context_t* ctx)
 {
-    char bookmark_file[MAX_FILEPATH_LEN + 32];
-    get_bookmark_filepath(ctx->filepath, bookmark_file, sizeof(bookmark_file));
-    
-    FILE* fp = fopen(bookmark_file, "r");
-    if (fp) {
-        char line[256];
-        // Skip the comment line
-        if (fgets(line, sizeof(line), fp) && line[0] == '#') {
-        } else {
-            fseek(fp, 0, SEEK_SET);
-        }
-        
-        if (fscanf(fp, "%d\n", &ctx->bookmark_count) == 1) {
-            if (ctx->bookmark_count > MAX_BOOKMARKS) ctx->bookmark_count = MAX_BOOKMARKS;
-            
-            for (int i = 0; i < ctx->bookmark_count; i++) {
-                if (fscanf(fp, "%zu %d %f %63s %127[^\n]\n", 
-                          &ctx->bookmarks[i].position, 
-                          &ctx->bookmarks[i].page,
-                          &ctx->bookmarks[i].progress,
-                          ctx->bookmarks[i].description,
-                          ctx->bookmarks[i].content_preview) != 5) {
-                    ctx->bookmark_count = i;
-                    break;
-                }
+    free_bookmarks(ctx);
+    if (!open_progress_log()) return;
+
+    int n = kv_log_tags(progress_log, ctx->book_id, NULL, 0);
+    uint32_t* tags = n > 0 ? (uint32_t*)heap_caps_malloc(n * sizeof(uint32_t), MALLOC_CAP_SPIRAM) : NULL;
+    if (tags) {
+        n = kv_log_tags(progress_log, ctx->book_id, tags, n);
+        uint8_t buf[KV_LOG_VALUE_MAX + 1];
+        for (int i = 0; i < n; i++) {
+            size_t len = 0;
+            if (tags[i] == KV_TAG_PROGRESS) continue;
+            if (kv_log_get(progress_log, ctx->book_id, tags[i], buf, KV_LOG_VALUE_MAX, &len) != ESP_OK ||
+                len < sizeof(bookmark_rec_t) + 2) {
+                continue;
+            }
+            buf[len] = '\0';
+            bookmark_t* bm = bookmark_append(ctx);
+            if (!bm) break;
+
+            bookmark_rec_t rec;
+            memcpy(&rec, buf, sizeof(rec));
+            const char* description = (const char*)buf + sizeof(rec);
+            const char* preview = description + strlen(description) + 1;
+            bm->position = rec.position;
+            bm->page = rec.page;
+            bm->progress = rec.progress;
+            bm->tag = tags[i];
+            snprintf(bm->description, sizeof(bm->description), "%s", description);
+            if (preview < (const char*)buf + len) {
+                snprintf(bm->content_preview, sizeof(bm->content_preview), "%s", preview);
             }
         }
-        fclose(fp);
-        ESP_LOGI(TAG, "Bookmarks loaded from: %s (%d bookmarks)", bookmark_file, ctx->bookmark_count);
-    } else {
-        ctx->bookmark_count = 0;
-        ESP_LOGI(TAG, "No bookmark file found: %s", bookmark_file);
+        heap_caps_free(tags);
+    }
+
+    if (ctx->bookmark_count == 0) {
+        fiction_import_bookmarks(ctx);
     }
+    ESP_LOGI(TAG, "Bookmarks loaded: %d", ctx->bookmark_count);
 }
 
-// Modify progress save (Enhanced Debugging version)
+// Save the reading position, one record appended to the progress log
 void fiction_save_progress(const fiction_context_t* ctx)
 {
     if (!ctx->is_open) {
         ESP_LOGW(TAG, "Cannot save progress: file not open");
         return;
     }
-    
-    // Make sure the directory exists
-    create_bookmark_directory();
-    
-    // Extract the file name
+    if (!open_progress_log()) return;
+
+    progress_rec_t rec = { (uint32_t)ctx->current_position, ctx->current_page };
+    esp_err_t err = put_progress_log(ctx->book_id, KV_TAG_PROGRESS, &rec, sizeof(rec));
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Progress saved: pos=%zu, page=%d", ctx->current_position, ctx->current_page);
+    } else {
+        ESP_LOGE(TAG, "Failed to save progress: %s", esp_err_to_name(err));
+    }
+}
+
+// Move the progress file written before the progress log into it
+static bool fiction_import_progress(fiction_context_t* ctx)
+{
     const char* filename = strrchr(ctx->filepath, '/');
     if (filename) {
         filename++;
@@ -356,62 +478,48 @@ void fiction_save_progress(const fiction_context_t* ctx)
     char progress_file[MAX_FILEPATH_LEN + 32];
     snprintf(progress_file, sizeof(progress_file), "/sdcard/bookmarks/%s.progress", filename);
     
-    ESP_LOGI(TAG, "Saving progress to: %s", progress_file);
-    ESP_LOGI(TAG, "Progress data: pos=%zu, page=%d", ctx->current_position, ctx->current_page);
+    FILE* fp = fopen(progress_file, "r");
+    if (!fp) return false;
+
+    char line[256];
+    if (fgets(line, sizeof(line), fp)) {
+        if (line[0] != '#') {
+            fseek(fp, 0, SEEK_SET);
+        }
+    }
     
-    FILE* fp = fopen(progress_file, "w");
-    if (fp) {
-        fprintf(fp, "# Progress for: %s\n", ctx->filepath);
-        fprintf(fp, "%zu\n%d\n", ctx->current_position, ctx->current_page);
-        fclose(fp);
-        ESP_LOGI(TAG, "Progress saved successfully");
-    } else {
-        ESP_LOGE(TAG, "Failed to save progress file: %s", progress_file);
+    size_t pos;
+    int page;
+    bool ok = fscanf(fp, "%zu\n%d\n", &pos, &page) == 2;
+    fclose(fp);
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to parse progress file: %s", progress_file);
+        return false;
     }
+
+    ctx->current_position = pos;
+    ctx->current_page = page;
+    fiction_save_progress(ctx);
+    remove(progress_file);
+    ESP_LOGI(TAG, "Progress imported from: %s, pos=%zu, page=%d", progress_file, pos, page);
+    return true;
 }
 
 // Progress loading
 bool fiction_load_progress(fiction_context_t* ctx)
 {
-    create_bookmark_directory();
-    const char* filename = strrchr(ctx->filepath, '/');
-    if (filename) {
-        filename++;
-    } else {
-        filename = ctx->filepath;
+    progress_rec_t rec;
+    size_t len = 0;
+    if (open_progress_log() &&
+        kv_log_get(progress_log, ctx->book_id, KV_TAG_PROGRESS, &rec, sizeof(rec), &len) == ESP_OK &&
+        len == sizeof(rec)) {
+        ctx->current_position = rec.position;
+        ctx->current_page = rec.page;
+        ESP_LOGI(TAG, "Progress loaded successfully: pos=%zu, page=%d", ctx->current_position, ctx->current_page);
+        return true;
     }
-    
-    char progress_file[MAX_FILEPATH_LEN + 32];
-    snprintf(progress_file, sizeof(progress_file), "/sdcard/bookmarks/%s.progress", filename);
-    
-    ESP_LOGI(TAG, "Trying to load progress from: %s", progress_file);
-    
-    FILE* fp = fopen(progress_file, "r");
-    if (fp) {
-        ESP_LOGI(TAG, "Progress file opened successfully");
-        
-        char line[256];
-        if (fgets(line, sizeof(line), fp)) {
-            ESP_LOGI(TAG, "First line: %s", line);
-            if (line[0] != '#') {
-                fseek(fp, 0, SEEK_SET);
-            }
-        }
-        
-        size_t pos;
-        int page;
-        if (fscanf(fp, "%zu\n%d\n", &pos, &page) == 2) {
-            ctx->current_position = pos;
-            ctx->current_page = page;
-            fclose(fp);
-            ESP_LOGI(TAG, "Progress loaded successfully: pos=%zu, page=%d", pos, page);
-            return true;
-        } else {
-            ESP_LOGE(TAG, "Failed to parse progress file");
-        }
-        fclose(fp);
-    } else {
-        ESP_LOGI(TAG, "Progress file not found: %s", progress_file);
+    if (fiction_import_progress(ctx)) {
+        return true;
     }
 
     ctx->current_position = 0;
@@ -423,14 +531,10 @@ bool fiction_load_progress(fiction_context_t* ctx)
 // add bookmark
 void fiction_add_bookmark(fiction_context_t* ctx)
 {
-    if (ctx->bookmark_count >= MAX_BOOKMARKS) {
-        ESP_LOGW(TAG, "Maximum bookmarks reached, replacing oldest");
-        // Delete the oldest bookmark and add a new one
-        for (int i = 0; i < MAX_BOOKMARKS - 1; i++) {
-            ctx->bookmarks[i] = ctx->bookmarks[i + 1];
-        }
-        ctx->bookmark_count = MAX_BOOKMARKS - 1;
-    }
+    // Tags only grow, a deleted bookmark's is not taken again
+    uint32_t tag = ctx->bookmark_count > 0 ? ctx->bookmarks[ctx->bookmark_count - 1].tag + 1 : 1;
+    bookmark_t* bm = bookmark_append(ctx);
+    if (!bm) return;
     
     // Percentage of calculation progress
     float progress = (float)ctx->current_position * 100.0f / ctx->file_size;
@@ -440,15 +544,17 @@ void fiction_add_bookmark(fiction_context_t* ctx)
     fiction_get_content_preview(ctx, preview, sizeof(preview));
     
     // Add the current position as a bookmark
-    ctx->bookmarks[ctx->bookmark_count].position = ctx->current_position;
-    ctx->bookmarks[ctx->bookmark_count].page = ctx->current_page;
-    ctx->bookmarks[ctx->bookmark_count].progress = progress;
-    snprintf(ctx->bookmarks[ctx->bookmark_count].description, 64, "第%d页", ctx->current_page + 1);
-    strncpy(ctx->bookmarks[ctx->bookmark_count].content_preview, preview, 127);
-    ctx->bookmarks[ctx->bookmark_count].content_preview[127] = '\0';
-    
-    ctx->bookmark_count++;
-    fiction_save_bookmarks(ctx);
+    bm->position = ctx->current_position;
+    bm->page = ctx->current_page;
+    bm->progress = progress;
+    bm->tag = tag;
+    snprintf(bm->description, sizeof(bm->description), "第%d页", ctx->current_page + 1);
+    snprintf(bm->content_preview, sizeof(bm->content_preview), "%s", preview);
+    
+    esp_err_t err = progress_log ? put_bookmark(ctx, bm) : ESP_ERR_INVALID_STATE;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save bookmark: %s", esp_err_to_name(err));
+    }
     ESP_LOGI(TAG, "Bookmark added at page %d (%.1f%%): %s",  ctx->current_page + 1, progress, preview);
 }
 
@@ -495,6 +601,12 @@ void fiction_delete_bookmark(fiction_context_t* ctx, int bookmark_index)
     }
     
     ESP_LOGI(TAG, "Delete bookmark: %s (page %d)", ctx->bookmarks[bookmark_index].content_preview, ctx->bookmarks[bookmark_index].page + 1);
+    // A delete is a record without a value, and may compact as a put does
+    if (progress_log && kv_log_full(progress_log, 0)) Font_CloseFiles();
+    esp_err_t err = progress_log ? kv_log_del(progress_log, ctx->book_id, ctx->bookmarks[bookmark_index].tag) : ESP_ERR_INVALID_STATE;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to delete bookmark: %s", esp_err_to_name(err));
+    }
     
     // Move the subsequent bookmarks forward to cover them
     for (int i = bookmark_index; i < ctx->bookmark_count - 1; i++) {
@@ -502,7 +614,6 @@ void fiction_delete_bookmark(fiction_context_t* ctx, int bookmark_index)
     }
     
     ctx->bookmark_count--;
-    fiction_save_bookmarks(ctx);
     ESP_LOGI(TAG, "The bookmarks have been deleted. There are still %d bookmarks left", ctx->bookmark_count);
 }
 
@@ -568,6 +679,8 @@ void fiction_close_file(fiction_context_t* ctx)
 {
     if (ctx->is_open) {
         fiction_save_progress(ctx);
+        free_bookmarks(ctx);
+        close_progress_log();
         ctx->is_open = false;
         ESP_LOGI(TAG, "Fiction file closed");
     }
@@ -586,6 +699,7 @@ void page_fiction_open_file(const char* filepath, const char* encoding)
     }
     
     // Initialize the context
+    free_bookmarks(&g_fiction_ctx);
     memset(&g_fiction_ctx, 0, sizeof(g_fiction_ctx));
     strncpy(g_fiction_ctx.filepath, filepath, MAX_FILEPATH_LEN - 1);
     // strncpy(g_fiction_ctx.encoding, encoding, sizeof(g_fiction_ctx.encoding) - 1);
@@ -601,6 +715,7 @@ void page_fiction_open_file(const char* filepath, const char* encoding)
     fseek(fp, 0, SEEK_END);
     g_fiction_ctx.file_size = ftell(fp);
     fclose(fp);
+    g_fiction_ctx.book_id = kv_log_book_id(filepath, g_fiction_ctx.file_size);
     
     g_fiction_ctx.is_open = true;
     
@@ -669,9 +784,7 @@ static int Sleep_wake_fiction(const bool font_menu_mode, const bool bookmark_mod
             }
             break;
         } 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             ESP_LOGI("home", "EPD_Init");
@@ -1047,11 +1160,11 @@ void free_fiction_display_buffers(void) {
         ESP_LOGI(TAG, "fs_access_mutex deleted");
     }
 
-    heap_caps_free(page_backup_buffer);
+    mem_free(page_backup_buffer);
     page_backup_buffer = NULL;
     for (int i = 0; i < 3; i++) {
         if (g_display_ctx.page_buffers[i].buffer) {
-            heap_caps_free(g_display_ctx.page_buffers[i].buffer);
+            mem_free(g_display_ctx.page_buffers[i].buffer);
             g_display_ctx.page_buffers[i].buffer = NULL;
             g_display_ctx.page_buffers[i].is_valid = false;
             g_display_ctx.page_buffers[i].is_rendering = false;
@@ -1063,14 +1176,14 @@ void free_fiction_display_buffers(void) {
 // Initialize the display cache area
 void init_fiction_display_buffers(void) {
     size_t page_buffer_size = (SCREEN_WIDTH * SCREEN_HEIGHT) / 8;
-    page_backup_buffer = (uint8_t*)heap_caps_malloc(page_buffer_size, MALLOC_CAP_SPIRAM);
+    page_backup_buffer = (uint8_t*)mem_alloc(page_buffer_size);
     if (!page_backup_buffer) {
         ESP_LOGE(TAG, "Failed to allocate page buffer ");
         return;
     }
 
     for (int i = 0; i < 3; i++) {
-        g_display_ctx.page_buffers[i].buffer = (uint8_t*)heap_caps_malloc(page_buffer_size, MALLOC_CAP_SPIRAM);
+        g_display_ctx.page_buffers[i].buffer = (uint8_t*)mem_alloc(page_buffer_size);
         if (!g_display_ctx.page_buffers[i].buffer) {
             ESP_LOGE(TAG, "Failed to allocate page buffer %d", i);
             return;
@@ -1248,116 +1361,111 @@ int copy_chars_by_count(const char* source, char* dest, int target_chars, const
 }
 
 
-// File reading
+#define FICTION_LAYOUT_BLOCK    8192    // File bytes laid out at a time, a page or more
+
+// GBK for text_layout, characters the font has no mapping for still take a cell
+static uint32_t fiction_decode_gbk(const char *s, size_t avail, int *len)
+{
+    if ((unsigned char)s[0] < 0x80) {
+        *len = 1;
+        return (unsigned char)s[0];
+    }
+    if (avail < 2) {
+        *len = 0;
+        return 0;
+    }
+    *len = 2;
+    uint32_t cp = GBK_To_Unicode(s);
+    return cp < 0x80 ? 0xFFFD : cp;
+}
+
+// Same widths as Paint_DrawString_CN, kerning with the previous character included
+static int fiction_advance(void *ctx, uint32_t prev, uint32_t cp)
+{
+    const cFONT *font = (const cFONT *)ctx;
+    return Font_Kerning(font, prev, cp) + Font_Advance(font, cp);
+}
+
+// File reading, the lines go to lines_char / lines_layout
 bool read_page_from_file(size_t start_position, char* content, int max_len, size_t* end_position) {
     FILE* fp = fopen(g_display_ctx.filepath, "rb");
     if (!fp) {
         ESP_LOGE(TAG, "Failed to open file: %s", g_display_ctx.filepath);
         return false;
     }
-    
-    fseek(fp, start_position, SEEK_SET);
-    
-    int content_pos = 0;
+
+    char *block = (char *)mem_alloc(FICTION_LAYOUT_BLOCK);
+    if (!block) {
+        ESP_LOGE(TAG, "Failed to allocate the layout block");
+        fclose(fp);
+        return false;
+    }
+    TRACE_BEGIN(FICTION_LAYOUT);
+
     int line_count = 0;
-    
     content[0] = '\0';
     int target_lines = g_display_ctx.lines_per_page;
-    
-    ESP_LOGI(TAG, "Reading page: target %d lines, max_len=%d bytes", target_lines, max_len);
-
-    const int LINE_BUF_BYTES = sizeof(lines_char[0]); 
-    int columns_count = 0;
-    int line_count_char_len = 0; 
-    const bool is_utf8 = strstr(g_display_ctx.encoding, "UTF") != NULL;
-    int ch;
+    if (target_lines > (int)(sizeof(lines_char) / sizeof(lines_char[0])))
+        target_lines = sizeof(lines_char) / sizeof(lines_char[0]);
 
-    while (line_count < target_lines) {
-        ch = fgetc(fp);
-        if (ch == EOF) break;
-        unsigned char uc = (unsigned char)ch;
-        if (uc == '\r') continue;
-        if (uc == '\n') {
-            if (columns_count < LINE_BUF_BYTES) lines_char[line_count][columns_count] = '\0';
-            else lines_char[line_count][LINE_BUF_BYTES - 1] = '\0';
-            
-            content_pos = content_pos + columns_count;
-            columns_count = 0;
-            line_count_char_len = 0;
-            line_count++;
-            continue;
-        }
+    ESP_LOGI(TAG, "Reading page: target %d lines, max_len=%d bytes", target_lines, max_len);
 
-        int char_len = 1;
-        int char_pixel = g_display_ctx.current_font->Width_EN;
-        unsigned char tmp[4];
-        tmp[0] = uc;
-
-        if (is_utf8) {
-            if (uc < 0x80) { char_len = 1; char_pixel = g_display_ctx.current_font->Width_EN; }
-            else if ((uc & 0xE0) == 0xC0) { char_len = 2; char_pixel = g_display_ctx.current_font->Width_CH; }
-            else if ((uc & 0xF0) == 0xE0) { char_len = 3; char_pixel = g_display_ctx.current_font->Width_CH; }
-            else if ((uc & 0xF8) == 0xF0) { char_len = 4; char_pixel = g_display_ctx.current_font->Width_CH; }
-            for (int i = 1; i < char_len; i++) {
-                int nb = fgetc(fp);
-                if (nb == EOF) { char_len = i; break; }
-                tmp[i] = (unsigned char)nb;
-            }
-        } else {
-            if (uc < 0x80) { char_len = 1; char_pixel = g_display_ctx.current_font->Width_EN; }
-            else {
-                char_len = 2; char_pixel = g_display_ctx.current_font->Width_CH;
-                int nb = fgetc(fp);
-                if (nb == EOF) { char_len = 1; }
-                else tmp[1] = (unsigned char)nb;
-            }
-        }
+    cFONT* font = g_display_ctx.current_font;
+    tl_config_t cfg = {};
+    cfg.width = SCREEN_WIDTH - 20;
+    cfg.indent = 2 * font->Width_CH;
+    cfg.em = font->Width_CH;
+    cfg.max_bytes = sizeof(lines_char[0]);
+#ifdef CONFIG_FICTION_JUSTIFY
+    cfg.justify = true;
+#endif
+#ifdef CONFIG_FICTION_HYPHENATE
+    cfg.hyphenate = true;
+#endif
+    cfg.decode = strstr(g_display_ctx.encoding, "UTF") ? NULL : fiction_decode_gbk;
+    cfg.advance = fiction_advance;
+    cfg.ctx = font;
 
-        if (columns_count + char_len >= LINE_BUF_BYTES - 1) {
-            for (int i = char_len - 1; i >= 0; i--) ungetc(tmp[i], fp);
-            if (columns_count < LINE_BUF_BYTES) lines_char[line_count][columns_count] = '\0';
-            else lines_char[line_count][LINE_BUF_BYTES - 1] = '\0';
-            content_pos = content_pos + columns_count;
-            columns_count = 0;
-            line_count_char_len = 0;
-            line_count++;
-            continue;
-        }
+    // A page starts a paragraph when the previous one ended at a line feed
+    bool para_start = true;
+    if (start_position > 0 && fseek(fp, start_position - 1, SEEK_SET) == 0) {
+        int prev = fgetc(fp);
+        para_start = (prev == '\n' || prev == '\r');
+    }
 
-        if (line_count_char_len + char_pixel > (SCREEN_WIDTH - 20)) {
-            for (int i = char_len - 1; i >= 0; i--) ungetc(tmp[i], fp);
-            if (columns_count < LINE_BUF_BYTES) lines_char[line_count][columns_count] = '\0';
-            else lines_char[line_count][LINE_BUF_BYTES - 1] = '\0';
-            content_pos = content_pos + columns_count;
-            columns_count = 0;
-            line_count_char_len = 0;
-            line_count++;
+    size_t base = start_position, pos = 0, len = 0;
+    bool eof = false;
+    while (line_count < target_lines) {
+        tl_line_t *line = &lines_layout[line_count];
+        if (!tl_break_line(&cfg, block, len, pos, eof, para_start, line)) {
+            if (eof || (pos == 0 && len == FICTION_LAYOUT_BLOCK)) break;
+            // The rest of the block is not a whole line, read on from where it starts
+            base += pos;
+            pos = 0;
+            TRACE_BEGIN(FICTION_READ);
+            fseek(fp, base, SEEK_SET);
+            len = fread(block, 1, FICTION_LAYOUT_BLOCK, fp);
+            TRACE_END(FICTION_READ);
+            eof = len < FICTION_LAYOUT_BLOCK;
             continue;
         }
-
-        for (int i = 0; i < char_len; i++) {
-            lines_char[line_count][columns_count++] = tmp[i];
-        }
-        line_count_char_len += char_pixel;
-    }
-
-    if (columns_count > 0 && line_count < target_lines) {
-        if (columns_count < LINE_BUF_BYTES) lines_char[line_count][columns_count] = '\0';
-        else lines_char[line_count][LINE_BUF_BYTES - 1] = '\0';
+        tl_copy_line(&cfg, block, line, lines_char[line_count], sizeof(lines_char[0]));
+        pos = line->next;
+        para_start = line->flags & TL_LINE_PARA_END;
         line_count++;
     }
-
-    long ft = ftell(fp);
-    if (ft < 0) {
-        ESP_LOGW(TAG, "ftell failed, using start_position as end_position");
-        *end_position = start_position;
-    } else {
-        *end_position = (size_t)ft;
+    for (int i = line_count; i < (int)(sizeof(lines_char) / sizeof(lines_char[0])); i++) {
+        lines_char[i][0] = '\0';
+        memset(&lines_layout[i], 0, sizeof(lines_layout[i]));
     }
+
+    *end_position = base + pos;
+    mem_free(block);
     fclose(fp);
-    
+    TRACE_END(FICTION_LAYOUT);
+
     float fill_rate = (float)line_count / target_lines * 100.0f;
-    ESP_LOGI(TAG, "Page read result: %d/%d lines (%.1f%%), %d bytes", line_count, target_lines, fill_rate, content_pos);
+    ESP_LOGI(TAG, "Page read result: %d/%d lines (%.1f%%), %d bytes", line_count, target_lines, fill_rate, (int)(*end_position - start_position));
 
     return (line_count > 0);
 }
@@ -1366,6 +1474,7 @@ bool read_page_from_file(size_t start_position, char* content, int max_len, size
 void render_page_to_buffer(page_cache_t* cache, const char* content, bool is_current) {
     if (!cache || !cache->buffer || cache->is_rendering) return;
     
+    TRACE_BEGIN(FICTION_PAINT);
     cache->is_rendering = true;
     Paint_NewImage(cache->buffer, EPD_WIDTH, EPD_HEIGHT, 270, WHITE);
     Paint_SelectImage(cache->buffer);
@@ -1405,7 +1514,9 @@ void render_page_to_buffer(page_cache_t* cache, const char* content, bool is_cur
     int target_lines = g_display_ctx.lines_per_page;
     for (size_t i = 0; i < target_lines; i++)
     {
-        Paint_DrawString_CN(10, start_y + i*line_height, lines_char[i], font, WHITE, BLACK);
+        const tl_line_t *line = &lines_layout[i];
+        Paint_DrawStringSpaced_CN(10 + line->indent, start_y + i*line_height, lines_char[i], font,
+                                  line->extra, line->stretch == TL_STRETCH_SPACES, WHITE, BLACK);
     }
     
     if (is_current) {
@@ -1419,6 +1530,7 @@ void render_page_to_buffer(page_cache_t* cache, const char* content, bool is_cur
     cache->lines_count = max_lines;
     cache->is_valid = true;
     cache->is_rendering = false;
+    TRACE_END(FICTION_PAINT);
     
     // ESP_LOGI(TAG, "Page rendered successfully: %d lines displayed", rendered_lines);
 }
@@ -1430,9 +1542,7 @@ void display_time_bet_fiction(uint8_t* buffer)
     char Time_str[16]={0};
     int BAT_Power;
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     snprintf(Time_str, sizeof(Time_str), "%02d:%02d", rtc_time.hours, rtc_time.minutes);
     Paint_DrawString_EN(SCREEN_WIDTH - 120, SCREEN_HEIGHT - 25, Time_str, &Font12, WHITE, BLACK);
 #if defined(CONFIG_IMG_SOURCE_EMBEDDED)
@@ -1534,6 +1644,9 @@ void display_current_page(void) {
 
 // Turn to the next page
 bool turn_to_next_page(void) {
+    TRACE_BEGIN_ARG(FICTION_TURN, 1);
+    // Measured until the preload task is done
+    energy_prof_begin(EP_OP_PAGE_TURN, false);
     // if (fs_access_mutex) xSemaphoreTake(fs_access_mutex, pdMS_TO_TICKS(5000));
     if (fs_access_mutex) xSemaphoreTake(fs_access_mutex, portMAX_DELAY);
 
@@ -1545,6 +1658,8 @@ bool turn_to_next_page(void) {
         if (!read_page_from_file(start_pos, next_cache->content, sizeof(next_cache->content), &end_pos)) {
             ESP_LOGE(TAG, "Failed to load next page");
             if (fs_access_mutex) xSemaphoreGive(fs_access_mutex);
+            TRACE_END(FICTION_TURN);
+            energy_prof_cancel(EP_OP_PAGE_TURN);
             return false;
         }
         next_cache->file_position = end_pos;
@@ -1572,6 +1687,7 @@ bool turn_to_next_page(void) {
     EPD_Display_Partial(g_display_ctx.page_buffers[BUFFER_CURRENT].buffer, 0, 0, EPD_WIDTH, EPD_HEIGHT);
 
     if (fs_access_mutex) xSemaphoreGive(fs_access_mutex);
+    TRACE_END(FICTION_TURN);
 
     // Preload the next page in the background
     xTaskCreate(preload_next_page_task, "preload_next", 10*1024, NULL, 5, NULL);
@@ -1587,6 +1703,8 @@ bool turn_to_previous_page(void) {
         return false;
     }
     
+    TRACE_BEGIN_ARG(FICTION_TURN, -1);
+    energy_prof_begin(EP_OP_PAGE_TURN, false);
     page_cache_t* prev_cache = &g_display_ctx.page_buffers[BUFFER_PREVIOUS];
     
     if (!prev_cache->is_valid) {
@@ -1597,6 +1715,8 @@ bool turn_to_previous_page(void) {
         
         if (!read_page_from_file(start_pos, prev_cache->content, sizeof(prev_cache->content), &end_pos)) {
             ESP_LOGE(TAG, "Failed to load previous page");
+            TRACE_END(FICTION_TURN);
+            energy_prof_cancel(EP_OP_PAGE_TURN);
             return false;
         }
         
@@ -1630,6 +1750,7 @@ bool turn_to_previous_page(void) {
     
     // Display immediately
     EPD_Display_Partial(g_display_ctx.page_buffers[BUFFER_CURRENT].buffer, 0, 0, EPD_WIDTH, EPD_HEIGHT);
+    TRACE_END(FICTION_TURN);
     
     // The previous page was preloaded in the background
     xTaskCreate(preload_previous_page_task, "preload_prev", 10*1024, NULL, 5, NULL);
@@ -1677,13 +1798,19 @@ void render_current_page_ui(page_cache_t* cache) {
 // Background preload task
 void preload_next_page_task(void* pvParameters) {
     vTaskDelay(pdMS_TO_TICKS(100));
+    TRACE_BEGIN_ARG(FICTION_PRELOAD, 1);
     preload_next_page();
+    TRACE_END(FICTION_PRELOAD);
+    energy_prof_end(EP_OP_PAGE_TURN);
     vTaskDelete(NULL);
 }
 
 void preload_previous_page_task(void* pvParameters) {
     vTaskDelay(pdMS_TO_TICKS(100));
+    TRACE_BEGIN_ARG(FICTION_PRELOAD, -1);
     preload_previous_page();
+    TRACE_END(FICTION_PRELOAD);
+    energy_prof_end(EP_OP_PAGE_TURN);
     vTaskDelete(NULL);
 }
 
@@ -1737,7 +1864,7 @@ void init_bookmark_display_buffers(void) {
     
     // Allocate bookmark display cache
     if (!bookmark_display_buffer) {
-        bookmark_display_buffer = (uint8_t*)heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
+        bookmark_display_buffer = (uint8_t*)mem_alloc(buffer_size);
         if (!bookmark_display_buffer) {
             ESP_LOGE(TAG, "Failed to allocate bookmark display buffer");
             return;
@@ -1746,7 +1873,7 @@ void init_bookmark_display_buffers(void) {
 
     // Allocate the bookmark preview cache
     if (!bookmark_preview_buffer) {
-        bookmark_preview_buffer = (uint8_t*)heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
+        bookmark_preview_buffer = (uint8_t*)mem_alloc(buffer_size);
         if (!bookmark_preview_buffer) {
             ESP_LOGE(TAG, "Failed to allocate bookmark display buffer");
             return;
@@ -1758,12 +1885,12 @@ void init_bookmark_display_buffers(void) {
 // Release the bookmark display cache
 void free_bookmark_display_buffers(void) {
     if (bookmark_display_buffer) {
-        heap_caps_free(bookmark_display_buffer);
+        mem_free(bookmark_display_buffer);
         bookmark_display_buffer = NULL;
     }
 
     if (bookmark_preview_buffer) {
-        heap_caps_free(bookmark_preview_buffer);
+        mem_free(bookmark_preview_buffer);
         bookmark_preview_buffer = NULL;
     }
     ESP_LOGI(TAG, "Bookmark display buffers freed");
@@ -1933,6 +2060,13 @@ void display_bookmark_list_on_screen(fiction_context_t* ctx, int selected_index)
     ESP_LOGI(TAG, "Full-screen bookmark list displayed: %d bookmarks, selected: %d", ctx->bookmark_count, selected_index);
 }
 
+// First bookmark on screen while index is selected, as display_bookmark_list_on_screen() scrolls
+static int bookmark_scroll_offset(int selected_index)
+{
+    int visible_items = (SCREEN_HEIGHT - 100 - 80) / 100;
+    return selected_index >= visible_items ? selected_index - visible_items + 1 : 0;
+}
+
 // Select up and down from the bookmark list
 void display_bookmark_list_on_screen_Down(int selected_index, int Refresh_mode)
 {
@@ -1951,8 +2085,15 @@ void display_bookmark_list_on_screen_Down(int selected_index, int Refresh_mode)
         selection_old = g_fiction_ctx.bookmark_count - 1;
     }
 
-    int y_pos_old = list_start_y + selection_old * item_height;
-    int y_pos_new = list_start_y + selected_index * item_height;
+    // The list scrolled, draw it again
+    int offset = bookmark_scroll_offset(selected_index);
+    if (bookmark_scroll_offset(selection_old) != offset) {
+        display_bookmark_list_on_screen(&g_fiction_ctx, selected_index);
+        return;
+    }
+
+    int y_pos_old = list_start_y + (selection_old - offset) * item_height;
+    int y_pos_new = list_start_y + (selected_index - offset) * item_height;
 
     // Clear the old selected mark
     Paint_DrawRectangle(15, y_pos_old + 2, SCREEN_WIDTH - 15, y_pos_old + item_height + 2, WHITE, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
@@ -1987,8 +2128,15 @@ void display_bookmark_list_on_screen_Up(int selected_index, int Refresh_mode)
         selection_old = 0;
     }
 
-    int y_pos_old = list_start_y + selection_old * item_height;
-    int y_pos_new = list_start_y + selected_index * item_height;
+    // The list scrolled, draw it again
+    int offset = bookmark_scroll_offset(selected_index);
+    if (bookmark_scroll_offset(selection_old) != offset) {
+        display_bookmark_list_on_screen(&g_fiction_ctx, selected_index);
+        return;
+    }
+
+    int y_pos_old = list_start_y + (selection_old - offset) * item_height;
+    int y_pos_new = list_start_y + (selected_index - offset) * item_height;
 
     // Clear the old selected mark
     Paint_DrawRectangle(15, y_pos_old + 2, SCREEN_WIDTH - 15, y_pos_old + item_height + 2, WHITE, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
@@ -2517,7 +2665,7 @@ static const char* detect_txt_encoding(const char* filepath)
 // The file selection menu displayed in pagination
 int page_fiction_file(void)
 {
-    if((Image_Fiction = (UBYTE *)heap_caps_malloc(EPD_SIZE_MONO,MALLOC_CAP_SPIRAM)) == NULL) 
+    if((Image_Fiction = (UBYTE *)mem_alloc(EPD_SIZE_MONO)) == NULL) 
     {
         ESP_LOGE(TAG,"Failed to apply for black memory...");
         // return ESP_FAIL;
@@ -2558,9 +2706,7 @@ int page_fiction_file(void)
     
     int button;
     int time_count = 0;
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_minutes = -1;
     last_minutes = rtc_time.minutes;
     display_fiction_time(rtc_time);
@@ -2592,9 +2738,7 @@ int page_fiction_file(void)
                     time_count = 0;
                     break;
                 }
-                xSemaphoreTake(rtc_mutex, portMAX_DELAY);
                 rtc_time = PCF85063_GetTime();
-                xSemaphoreGive(rtc_mutex);
                 if(rtc_time.minutes != last_minutes) {
                     last_minutes = rtc_time.minutes;
                     ESP_LOGI("home", "EPD_Init");
@@ -2659,7 +2803,7 @@ int page_fiction_file(void)
             time_count = 0;
         } else if (button == 8 || button == 22) {
             heap_caps_free(entries);
-            heap_caps_free(Image_Fiction);
+            mem_free(Image_Fiction);
             return -1;
         } else if (button == 12) {
             ESP_LOGI("home", "EPD_Init");
@@ -2668,9 +2812,7 @@ int page_fiction_file(void)
             time_count = 0;
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             display_fiction_time(rtc_time);
@@ -2678,6 +2820,6 @@ int page_fiction_file(void)
         }
     }
     heap_caps_free(entries);
-    heap_caps_free(Image_Fiction);
+    mem_free(Image_Fiction);
 }
 
@@ -10,14 +10,13 @@
 #define LINES_PER_PAGE 20
 #define MAX_FILEPATH_LEN 512
 
-#define MAX_BOOKMARKS 6  // Save up to 6 bookmarks
-
 typedef struct {
     size_t position;
     int page;
     float progress;           // progress percentage
     char description[64];     // Bookmark description
     char content_preview[128]; // Content Preview (the first few characters)
+    uint32_t tag;             // Key of the bookmark in the progress log
 } bookmark_t;
 
 typedef struct {
@@ -27,8 +26,10 @@ typedef struct {
     int current_page;
     size_t file_size;
     bool is_open;
-    bookmark_t bookmarks[MAX_BOOKMARKS];  // Bookmark array
+    bookmark_t* bookmarks;                // Bookmark array in PSRAM, grown as they are added
     int bookmark_count;                   // The number of bookmarks
+    int bookmark_capacity;
+    uint64_t book_id;                     // kv_log_book_id() of the file
 } fiction_context_t;
 
 
@@ -13,6 +13,7 @@
 #include "freertos/event_groups.h"
 
 #include "pcf85063_bsp.h"
+#include "time_sync.h"
 #include "axp_prot.h"
 #include "epaper_port.h"
 #include "GUI_BMPfile.h"
@@ -35,7 +36,6 @@ static bool page_network_inited = false;
 
 // Define the data cache area of the electronic paper
 extern uint8_t *Image_Mono;
-extern SemaphoreHandle_t rtc_mutex;   // Protect RTC
 
 static void display_network_init();
 static void display_network_option(int option);
@@ -77,6 +77,17 @@ esp_err_t safe_wifi_deinit()
 
 
 
+// Hand the RTC to WifiStation so a cached DHCP lease can be reused after power-off.
+// Counted as if the RTC were UTC, only ever compared with itself.
+static void network_set_wall_clock(void)
+{
+    Time_data t = PCF85063_GetTime();
+    if (t.years < 24 || t.months < 1 || t.months > 12) {
+        return;     // Never set
+    }
+    WifiStation::GetInstance().SetWallClock(time_sync_rtc_seconds(&t));
+}
+
 // IP acquisition event callback
 static void on_got_ip(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
@@ -197,6 +208,7 @@ void page_network_config(void)
 void wifi_set_enable(bool enable)
 {
     save_wifi_enable_to_nvs(enable);
+    axp_set_load_hint(enable ? AXP_LOAD_WIFI_MA : AXP_LOAD_IDLE_MA);
     if (enable) {
         ESP_LOGI("network", "Turn on WiFi and enter the distribution network");
         // ESP_ERROR_CHECK(esp_wifi_start());
@@ -277,18 +289,15 @@ void page_network_init(void)
         return;
     }
 
-    int i=0;
-    wifi_ap_record_t ap_info;
     // Connect to the saved WiFi
+    network_set_wall_clock();
     WifiStation::GetInstance().Start();
     Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
     Paint_DrawString_CN(10, 59, "连接WiFi中", &Font18_UTF8, WHITE, BLACK);
     Refresh_page_network();
-    while (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
+    ESP_LOGI("network", "Wait for the successful WiFi connection");
+    if (!WifiStation::GetInstance().WaitForAssociated(30 * 1000))
     {
-        ESP_LOGI("network", "Wait for the successful WiFi connection");
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        if (i++ > 30)
         {
             ESP_LOGI("network", "Failed WiFi connection");
             Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
@@ -302,17 +311,16 @@ void page_network_init(void)
     }
 
     // Wait for the IP address to be obtained
-    esp_netif_ip_info_t ip_info;
-    i = 0;
+    esp_netif_ip_info_t ip_info = {};
     esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawString_CN(10, 59, "等待获取IP地址...", &Font18_UTF8, WHITE, BLACK);
-    Refresh_page_network();
-    while ((!netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) && i++ < 30) {
+    if (!WifiStation::GetInstance().IsConnected()) {
+        Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_CN(10, 59, "等待获取IP地址...", &Font18_UTF8, WHITE, BLACK);
+        Refresh_page_network();
         ESP_LOGI("network", "Waiting to obtain the IP address...");
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
-    if (!netif || ip_info.ip.addr == 0) {
+    if (!WifiStation::GetInstance().WaitForConnected(30 * 1000) ||
+        !netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) {
         ESP_LOGI("network", "Failed to obtain the IP address. Restart the device");
         Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
         Paint_DrawString_CN(10, 59, "获取IP地址失败，请手动清除WiFi并重新配置WiFi，或者重启本设备", &Font18_UTF8, WHITE, BLACK);
@@ -394,43 +402,37 @@ void page_network_init_main(void)
         return;
     }
 
-    int i=0;
-    wifi_ap_record_t ap_info;
     // Connect to the saved WiFi
+    network_set_wall_clock();
     WifiStation::GetInstance().Start();
     Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
     Paint_DrawString_CN(10, 59, "连接WiFi中", &Font18_UTF8, WHITE, BLACK);
     Refresh_page_network();
-    while (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
+    ESP_LOGI("network", "Wait for the successful WiFi connection");
+    if (!WifiStation::GetInstance().WaitForAssociated(30 * 1000))
     {
-        ESP_LOGI("network", "Wait for the successful WiFi connection");
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        if (i++ > 30)
-        {
-            ESP_LOGI("network", "Failed WiFi connection");
-            Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-            Paint_DrawString_CN(10, 59, "WiFi连接失败", &Font18_UTF8, WHITE, BLACK);
-            Paint_DrawString_CN(10, 90, "三秒后进入主页面", &Font18_UTF8, WHITE, BLACK);
-            Refresh_page_network();
-            vTaskDelay(pdMS_TO_TICKS(3000));
-            return;
-            // SsidManager::GetInstance().Clear();
-            // esp_restart();
-        }
+        ESP_LOGI("network", "Failed WiFi connection");
+        Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_CN(10, 59, "WiFi连接失败", &Font18_UTF8, WHITE, BLACK);
+        Paint_DrawString_CN(10, 90, "三秒后进入主页面", &Font18_UTF8, WHITE, BLACK);
+        Refresh_page_network();
+        vTaskDelay(pdMS_TO_TICKS(3000));
+        return;
+        // SsidManager::GetInstance().Clear();
+        // esp_restart();
     }
 
     // Wait for the IP address to be obtained
-    esp_netif_ip_info_t ip_info;
-    i = 0;
+    esp_netif_ip_info_t ip_info = {};
     esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
-    Paint_DrawString_CN(10, 59, "等待获取IP地址...", &Font18_UTF8, WHITE, BLACK);
-    Refresh_page_network();
-    while ((!netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) && i++ < 30) {
+    if (!WifiStation::GetInstance().IsConnected()) {
+        Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_CN(10, 59, "等待获取IP地址...", &Font18_UTF8, WHITE, BLACK);
+        Refresh_page_network();
         ESP_LOGI("network", "Waiting to obtain the IP address...");
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
-    if (!netif || ip_info.ip.addr == 0) {
+    if (!WifiStation::GetInstance().WaitForConnected(30 * 1000) ||
+        !netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) {
         ESP_LOGI("network", "Failed to obtain the IP address. Restart the device");
         Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
         Paint_DrawString_CN(10, 59, "获取IP地址失败", &Font18_UTF8, WHITE, BLACK);
@@ -490,32 +492,23 @@ int page_network_init_mode(void)
         return 0;
     }
 
-    int i=0;
-    wifi_ap_record_t ap_info;
-    // Connect to the saved WiFi
+    // Connect to the saved WiFi. The waits return as soon as the event arrives,
+    // on a cached channel and lease that is well under a second.
+    network_set_wall_clock();
     WifiStation::GetInstance().Start();
-    while (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
+    if (!WifiStation::GetInstance().WaitForAssociated(30 * 1000))
     {
-        ESP_LOGI("network", "Wait for the successful WiFi connection");
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        if (i++ > 30)
-        {
-            ESP_LOGI("network", "Failed WiFi connection");
-            return 0;
-            // SsidManager::GetInstance().Clear();
-            // esp_restart();
-        }
+        ESP_LOGI("network", "Failed WiFi connection");
+        return 0;
+        // SsidManager::GetInstance().Clear();
+        // esp_restart();
     }
 
     // Wait for the IP address to be obtained
-    esp_netif_ip_info_t ip_info;
-    i = 0;
+    esp_netif_ip_info_t ip_info = {};
     esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    while ((!netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) && i++ < 10) {
-        ESP_LOGI("network", "Waiting to obtain the IP address...");
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
-    if (!netif || ip_info.ip.addr == 0) {
+    if (!WifiStation::GetInstance().WaitForConnected(10 * 1000) ||
+        !netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) {
         ESP_LOGI("network", "Failed to obtain the IP address");
         return 0;
         // esp_restart();
@@ -537,9 +530,7 @@ void page_handle_network_key_event()
     Time_data rtc_time;
     int last_minutes = -1;
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     last_minutes = rtc_time.minutes;
 
     // Refresh the initial page
@@ -606,9 +597,7 @@ void page_handle_network_key_event()
             }
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if ((rtc_time.minutes != last_minutes)) {
             last_minutes = rtc_time.minutes;
             display_network_time_img(rtc_time);
@@ -628,9 +617,7 @@ static void display_network_init()
     int BAT_Power;
     char BAT_Power_str[16]={0};
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
 
     snprintf(Time_str, sizeof(Time_str), "%02d:%02d", rtc_time.hours, rtc_time.minutes);
     Paint_DrawString_EN(20, 11, Time_str, &Font16, WHITE, BLACK);
@@ -753,9 +740,7 @@ static int Sleep_wake_network(void)
             // Forced_refresh_network();
             break;
         } 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             ESP_LOGI("home", "EPD_Init");
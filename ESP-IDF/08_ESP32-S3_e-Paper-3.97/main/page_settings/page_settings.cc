@@ -18,7 +18,10 @@
 
 #include "pcf85063_bsp.h"
 #include "axp_prot.h"
+#include "energy_prof.h"
+#include "time_sync.h"
 #include "epaper_port.h"
+#include "mem_arena.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
 
@@ -37,7 +40,6 @@ extern SemaphoreHandle_t qmi8658_mutex;
 #define BMP_WIFI_PATH                       "/sdcard/GUI/WIFI.bmp"
 
 extern uint8_t *Image_Mono;
-extern SemaphoreHandle_t rtc_mutex;  
 
 static TaskHandle_t imu_task_handle = NULL;
 static const char *TAG = "qmi8658";
@@ -148,12 +150,73 @@ esp_err_t get_sdcard_info(uint64_t* total, uint64_t* free)
     return ESP_OK;
 }
 
+// Latest batch average delivered by the QMI8658 FIFO task
+static imu_status_t imu_latest;
+static bool imu_stream_on = false;
+
+// FIFO consumer: average one watermark batch and update the orientation state
+static void imu_fifo_consumer(const qmi8658_sample_t *samples, int count, void *arg)
+{
+    int32_t acc[3] = {0};
+    int32_t gyro[3] = {0};
+
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < 3; k++) {
+            acc[k] += samples[i].acc_mg[k];
+            gyro[k] += samples[i].gyro_mdps[k];
+        }
+    }
+
+    xSemaphoreTake(qmi8658_mutex, portMAX_DELAY);
+    for (int k = 0; k < 3; k++) {
+        imu_latest.acc[k] = (float)acc[k] / count;
+        imu_latest.gyro[k] = (float)gyro[k] / count / 1000.0f;
+    }
+    check_imu_status(imu_latest.acc, imu_latest.gyro);
+    xSemaphoreGive(qmi8658_mutex);
+}
+
+// The six-axis page only needs a few readings per second, so the sensor runs at
+// 62.5Hz and the FIFO hands over 32 samples per watermark interrupt
+static void imu_stream_start(void)
+{
+    if (imu_stream_on) return;
+    QMI8658_config_acc(QMI8658AccRange_8g, QMI8658AccOdr_62_5Hz, QMI8658Lpf_Enable, QMI8658St_Disable);
+    QMI8658_config_gyro(QMI8658GyrRange_512dps, QMI8658GyrOdr_62_5Hz, QMI8658Lpf_Enable, QMI8658St_Disable);
+    QMI8658_fifo_register_consumer(imu_fifo_consumer, NULL);
+    imu_stream_on = QMI8658_fifo_start(QMI8658FifoSize_64, 32, QMI8658_Int1);
+    if (!imu_stream_on) {
+        ESP_LOGW(TAG, "FIFO stream unavailable, falling back to polling");
+        QMI8658_fifo_unregister_consumer(imu_fifo_consumer);
+    }
+}
+
+static void imu_stream_stop(void)
+{
+    if (!imu_stream_on) return;
+    QMI8658_fifo_stop();
+    QMI8658_fifo_unregister_consumer(imu_fifo_consumer);
+    QMI8658_config_acc(QMI8658AccRange_8g, QMI8658AccOdr_1000Hz, QMI8658Lpf_Enable, QMI8658St_Disable);
+    QMI8658_config_gyro(QMI8658GyrRange_512dps, QMI8658GyrOdr_1000Hz, QMI8658Lpf_Enable, QMI8658St_Disable);
+    imu_stream_on = false;
+}
+
 // Six-axis monitoring mission
 void qmi8658_task(void) {
     imu_status_t status;
     int qmi8658_stat;
 
-    QMI8658_read_xyz(status.acc, status.gyro, NULL);
+    if (imu_stream_on) {
+        xSemaphoreTake(qmi8658_mutex, portMAX_DELAY);
+        status = imu_latest;
+        qmi8658_stat = qmi8658_status;
+        xSemaphoreGive(qmi8658_mutex);
+    } else {
+        QMI8658_read_xyz(status.acc, status.gyro, NULL);
+        xSemaphoreTake(qmi8658_mutex, portMAX_DELAY);
+        qmi8658_stat = check_imu_status(status.acc, status.gyro);
+        xSemaphoreGive(qmi8658_mutex);
+    }
     // Print the corresponding six-axis sensor data
     ESP_LOGI(TAG, "acc_x = %4.3fmg , acc_y  = %4.3fmg , acc_z  = %4.3fmg", status.acc[0], status.acc[1], status.acc[2]);
     ESP_LOGI(TAG, "gyro_x = %4.3fdps, gyro_y = %4.3fdps, gyro_z = %4.3fdps", status.gyro[0], status.gyro[1], status.gyro[2]);
@@ -182,19 +245,29 @@ void qmi8658_task(void) {
 
     Refresh_page_settings();
 
-    xSemaphoreTake(qmi8658_mutex, portMAX_DELAY);
-    qmi8658_stat = check_imu_status(status.acc, status.gyro);
-    xSemaphoreGive(qmi8658_mutex);
-
     ESP_LOGI(TAG,"status = %d\r\n", qmi8658_stat);
 }
 
+// Whole numbers, one decimal below 10, "--" when not measured yet
+static void format_estimate(char *buf, size_t len, float value)
+{
+    if (value < 0.0f) {
+        snprintf(buf, len, "--");
+    } else if (value < 10.0f) {
+        snprintf(buf, len, "%.1f", value);
+    } else {
+        snprintf(buf, len, "%.0f", value);
+    }
+}
+
 // Memory monitoring task
 void SRAM_task(void) {
      // Read memory parameters
     ESP_LOGI("settings", "On-chip SRAM is available: %d", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
     ESP_LOGI("settings", "PSRAM is available: %d", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     ESP_LOGI("settings", "Total SRAM is available: %d", heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    // Per-device I2C bus usage since boot
+    i2c_bsp_log_stats();
 
     Paint_DrawRectangle(0, 57, 480, 650, WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
     Paint_DrawString_CN(10, 59, " 内存信息: ", &Font24_UTF8, BLACK, WHITE);
@@ -221,6 +294,50 @@ void SRAM_task(void) {
     show_sdmmc_capacity();
     show_sdcard_all_info();
 
+    // Frame pools: in use/reserved and peak, then what went to the heap
+    mem_arena_log_stats();
+    mem_arena_stats_t arena;
+    mem_arena_get_stats(&arena);
+    const mem_pool_stats_t *pool = arena.pools;
+    uint32_t overflows = 0;
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        overflows += pool[i].overflows;
+    }
+    char arena_str[80];
+    Paint_DrawString_CN(10, 403, " 内存池: ", &Font24_UTF8, BLACK, WHITE);
+    snprintf(arena_str, sizeof(arena_str), " 帧缓冲 48K %u/%u 峰值%u 96K %u/%u",
+             pool[MEM_POOL_MONO].in_use, pool[MEM_POOL_MONO].blocks, pool[MEM_POOL_MONO].high_water,
+             pool[MEM_POOL_GRAY].in_use, pool[MEM_POOL_GRAY].blocks);
+    Paint_DrawString_CN(25, 449, arena_str, &Font18_UTF8, WHITE, BLACK);
+    snprintf(arena_str, sizeof(arena_str), " 字形 %u/%u 行 %u/%u 堆 %lu KB",
+             pool[MEM_POOL_GLYPH].in_use, pool[MEM_POOL_GLYPH].blocks,
+             pool[MEM_POOL_LINE].in_use, pool[MEM_POOL_LINE].blocks, (unsigned long)(arena.heap_bytes / 1024));
+    Paint_DrawString_CN(25, 485, arena_str, &Font18_UTF8, WHITE, BLACK);
+    snprintf(arena_str, sizeof(arena_str), " PSRAM碎片率 %u%% 最大块 %u KB 溢出 %lu",
+             arena.fragmentation, (unsigned)(arena.psram_largest / 1024), (unsigned long)overflows);
+    Paint_DrawString_CN(25, 521, arena_str, &Font18_UTF8, WHITE, BLACK);
+
+    // Battery life of each unattended mode from the measured charge per operation,
+    // the full table goes to the log
+    energy_prof_log_stats();
+    ep_stats_t ep[EP_OP_COUNT];
+    energy_prof_get_stats(ep);
+    int sync_days = time_sync_interval_days();
+    char days[EP_MODE_COUNT][12], uah[3][12];
+    for (int i = 0; i < EP_MODE_COUNT; i++) {
+        format_estimate(days[i], sizeof(days[i]), energy_prof_mode_days((ep_mode_t)i, sync_days));
+    }
+    const ep_op_t shown[3] = {EP_OP_CLOCK_WAKE, EP_OP_PAGE_TURN, EP_OP_AUDIO_MINUTE};
+    for (int i = 0; i < 3; i++) {
+        const ep_stats_t *st = &ep[shown[i]];
+        format_estimate(uah[i], sizeof(uah[i]), st->count ? st->charge_uc / 3600.0f : -1.0f);
+    }
+    snprintf(arena_str, sizeof(arena_str), " 续航 时钟%s天 日历%s天 天气%s天",
+             days[EP_MODE_CLOCK], days[EP_MODE_CALENDAR], days[EP_MODE_WEATHER]);
+    Paint_DrawString_CN(25, 557, arena_str, &Font18_UTF8, WHITE, BLACK);
+    snprintf(arena_str, sizeof(arena_str), " 单次uAh 时钟%s 翻页%s 音乐/分%s", uah[0], uah[1], uah[2]);
+    Paint_DrawString_CN(25, 593, arena_str, &Font18_UTF8, WHITE, BLACK);
+
     Refresh_page_settings();
 }
 
@@ -234,9 +351,7 @@ void page_settings_show(void)
     Time_data time;
     int last_minutes = -1;
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     last_minutes = time.minutes;
 
     display_settings_init();
@@ -254,9 +369,11 @@ void page_settings_show(void)
             time_count = 0;
             display_settings_option(idx);
             if(idx == 0){
+                imu_stream_stop();
                 SRAM_task();
                 mode = 0;
             } else if(idx == 1){
+                imu_stream_start();
                 mode = 1;
             } 
         } else if (button == 0) {
@@ -264,18 +381,22 @@ void page_settings_show(void)
             time_count = 0;
             display_settings_option(idx);
             if(idx == 0){
+                imu_stream_stop();
                 SRAM_task();
                 mode = 0;
             } else if(idx == 1){
+                imu_stream_start();
                 mode = 1;
             } 
         } else if (button == 7) {
                 if(idx == 2){
+                    imu_stream_stop();
                     EPD_Init();
                     Refresh_page_settings();
                     return;
                 }
         } else if (button == 8 || button == 22) {
+            imu_stream_stop();
             EPD_Init();
             Refresh_page_settings();
             return;
@@ -284,9 +405,7 @@ void page_settings_show(void)
             qmi8658_task();
         }
 
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if ((time.minutes != last_minutes)) {
             last_minutes = time.minutes;
             display_settings_time_img(time);
@@ -336,9 +455,7 @@ static int Sleep_wake_settings()
             Refresh_page_settings();
             break;
         }
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if(rtc_time.minutes != last_minutes) {
             last_minutes = rtc_time.minutes;
             ESP_LOGI("home", "EPD_Init");
@@ -375,9 +492,7 @@ static void display_settings_init()
     int BAT_Power;
     char BAT_Power_str[16]={0};
 
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
 
     snprintf(Time_str, sizeof(Time_str), "%02d:%02d", rtc_time.hours, rtc_time.minutes);
     Paint_DrawString_EN(20, 11, Time_str, &Font16, WHITE, BLACK);
@@ -4,6 +4,7 @@
 #include "nvs_flash.h"
 #include <stdio.h>
 #include <string.h>
+#include <string>
 #include "button_bsp.h"
 #include "esp_http_client.h"
 #include "cJSON.h"
@@ -13,14 +14,17 @@
 #include "esp_netif.h"
 
 #include "epaper_port.h"
+#include "mem_arena.h"
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
 #include "pcf85063_bsp.h"
 #include "axp_prot.h"
+#include "energy_prof.h"
 
 #include "sdcard_bsp.h"
 
 #include "page_network.h"
+#include "wifi_station.h"
 #include "page_clock.h"
 #include "page_alarm.h"
 #include "page_audio.h"
@@ -28,7 +32,6 @@
 #include "esp_spiffs.h"
 
 extern uint8_t *Image_Mono;
-extern SemaphoreHandle_t rtc_mutex; 
 extern Alarm alarms[MAX_ALARMS];
 
 
@@ -227,6 +230,69 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
+// Requests go to the last resolved address of the API host, kept in NVS across
+// power-off, so there is no DNS lookup right after waking up. The name goes in
+// the Host header. host is left empty when the URL is used as it is.
+static esp_http_client_handle_t weather_http_init(const esp_http_client_config_t *config, bool cached, std::string &host)
+{
+    esp_http_client_config_t cfg = *config;
+    char url[256];
+    const char *name = strstr(cfg.url, "://");
+    host.clear();
+    if (cached && name) {
+        name += 3;
+        size_t len = strcspn(name, "/:");
+        std::string ip = WifiStation::GetInstance().ResolveHost(std::string(name, len));
+        int n = snprintf(url, sizeof(url), "%.*s%s%s", (int)(name - cfg.url), cfg.url, ip.c_str(), name + len);
+        if (!ip.empty() && n > 0 && n < (int)sizeof(url)) {
+            host.assign(name, len);
+            cfg.url = url;
+        }
+    }
+    esp_http_client_handle_t client = esp_http_client_init(&cfg);
+    if (client && !host.empty()) {
+        esp_http_client_set_header(client, "Host", host.c_str());
+    }
+    return client;
+}
+
+// The cached address did not answer, forget it and go by name
+static void weather_http_forget(const std::string &host)
+{
+    ESP_LOGW("weather", "Cached address of %s failed, resolving again", host.c_str());
+    WifiStation::GetInstance().ForgetHost(host);
+}
+
+static esp_err_t weather_http_perform(const esp_http_client_config_t *config)
+{
+    std::string host;
+    esp_http_client_handle_t client = weather_http_init(config, true, host);
+    esp_err_t err = esp_http_client_perform(client);
+    esp_http_client_cleanup(client);
+    if (err != ESP_OK && !host.empty()) {
+        weather_http_forget(host);
+        client = weather_http_init(config, false, host);
+        err = esp_http_client_perform(client);
+        esp_http_client_cleanup(client);
+    }
+    return err;
+}
+
+static esp_err_t weather_http_open(const esp_http_client_config_t *config, esp_http_client_handle_t *out)
+{
+    std::string host;
+    esp_http_client_handle_t client = weather_http_init(config, true, host);
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK && !host.empty()) {
+        esp_http_client_cleanup(client);
+        weather_http_forget(host);
+        client = weather_http_init(config, false, host);
+        err = esp_http_client_open(client, 0);
+    }
+    *out = client;
+    return err;
+}
+
 
 // Obtain and analyze the weather
 void weather_fetch_and_show_cached(const char* city_code, bool force_refresh)
@@ -250,7 +316,7 @@ void weather_fetch_and_show_cached(const char* city_code, bool force_refresh)
     char url[128];
     snprintf(url, sizeof(url), WEATHER_URL_PREFIX "%s", city_code);
 
-    char *json_buf = (char *)heap_caps_malloc(WEATHER_JSON_MAX_SIZE, MALLOC_CAP_SPIRAM);
+    char *json_buf = (char *)mem_alloc(WEATHER_JSON_MAX_SIZE);
     if (!json_buf) {
         ESP_LOGE("weather", "PSRAM allocation failed");
         return;
@@ -262,14 +328,11 @@ void weather_fetch_and_show_cached(const char* city_code, bool force_refresh)
         .event_handler = http_event_handler,
         .user_data = json_buf,
     };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-
-    esp_err_t err = esp_http_client_perform(client);
-    esp_http_client_cleanup(client);
+    esp_err_t err = weather_http_perform(&config);
 
     if (err != ESP_OK) {
         ESP_LOGE("weather", "HTTP request failed: %s", esp_err_to_name(err));
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return;
     }
 
@@ -279,7 +342,7 @@ void weather_fetch_and_show_cached(const char* city_code, bool force_refresh)
     last_weather_time = now;
 
     cJSON *root = cJSON_Parse(json_buf);
-    heap_caps_free(json_buf);
+    mem_free(json_buf);
     if (!root) {
         ESP_LOGE("weather", "JSON parsing failed");
         return;
@@ -288,7 +351,7 @@ void weather_fetch_and_show_cached(const char* city_code, bool force_refresh)
     cJSON *cityInfo = cJSON_GetObjectItem(root, "cityInfo");
     cJSON *data = cJSON_GetObjectItem(root, "data");
     if (!cityInfo || !data) {
-        ESP_LOGE("weather", "The JSON field is missing, the original response: %s", json_buf);
+        ESP_LOGE("weather", "The JSON field is missing, the original response: %s", last_weather_json);
         cJSON_Delete(root);
         return;
     }
@@ -491,18 +554,17 @@ void trim_suffix(char *str) {
 // Automatically match the city's code
 int amap_ip_location_fetch_city_code_by_name(char *sojson_code, size_t code_len)
 {
-    char *json_buf = (char *)heap_caps_malloc(AMAP_JSON_MAX_SIZE, MALLOC_CAP_SPIRAM);
+    char *json_buf = (char *)mem_alloc(AMAP_JSON_MAX_SIZE);
     if (!json_buf) return 0;
     json_buf[0] = '\0';
 
     esp_http_client_config_t config = {0};
     config.url = AMAP_IP_URL;
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-
-    esp_err_t err = esp_http_client_open(client, 0);
+    esp_http_client_handle_t client;
+    esp_err_t err = weather_http_open(&config, &client);
     if (err != ESP_OK) {
         esp_http_client_cleanup(client);
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return 0;
     }
 
@@ -512,13 +574,13 @@ int amap_ip_location_fetch_city_code_by_name(char *sojson_code, size_t code_len)
     esp_http_client_cleanup(client);
 
     if (read_len <= 0) {
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return 0;
     }
     json_buf[read_len] = '\0';
 
     cJSON *root = cJSON_Parse(json_buf);
-    heap_caps_free(json_buf);
+    mem_free(json_buf);
     if (!root) return 0;
 
     cJSON *province = cJSON_GetObjectItem(root, "province");
@@ -540,7 +602,7 @@ int amap_ip_location_fetch_city_code_by_name(char *sojson_code, size_t code_len)
 // Automatically locate and obtain the city
 int amap_ip_location_fetch_city_code(char *city_code, size_t code_len)
 {
-    char *json_buf = (char *)heap_caps_malloc(AMAP_JSON_MAX_SIZE, MALLOC_CAP_SPIRAM);
+    char *json_buf = (char *)mem_alloc(AMAP_JSON_MAX_SIZE);
     if (!json_buf) {
         ESP_LOGE("amap", "PSRAM allocation failed");
         return 0;
@@ -549,13 +611,12 @@ int amap_ip_location_fetch_city_code(char *city_code, size_t code_len)
 
     esp_http_client_config_t config = {0};
     config.url = AMAP_IP_URL;
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-
-    esp_err_t err = esp_http_client_open(client, 0);
+    esp_http_client_handle_t client;
+    esp_err_t err = weather_http_open(&config, &client);
     if (err != ESP_OK) {
         ESP_LOGE("amap", "Failed to open HTTP: %s (%d)", esp_err_to_name(err), err);
         esp_http_client_cleanup(client);
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return 0;
     }
 
@@ -570,7 +631,7 @@ int amap_ip_location_fetch_city_code(char *city_code, size_t code_len)
         ESP_LOGE("amap", "Abnormal content length, read_len=%d", read_len);
         esp_http_client_close(client);
         esp_http_client_cleanup(client);
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return 0;
     }
 
@@ -578,7 +639,7 @@ int amap_ip_location_fetch_city_code(char *city_code, size_t code_len)
     esp_http_client_cleanup(client);
 
     cJSON *root = cJSON_Parse(json_buf);
-    heap_caps_free(json_buf);
+    mem_free(json_buf);
     if (!root) {
         ESP_LOGE("amap", "JSON parsing failed");
         return 0;
@@ -744,9 +805,7 @@ void page_weather_city_select(void)
 
     int button = -1;
     bool force_refresh = true;
-    xSemaphoreTake(rtc_mutex, portMAX_DELAY);
     Time_data rtc_time = PCF85063_GetTime();
-    xSemaphoreGive(rtc_mutex);
     int last_hours = rtc_time.hours;
     int last_minutes = rtc_time.minutes;
     int sleep_js = 0;
@@ -788,9 +847,7 @@ void page_weather_city_select(void)
         }
 
         button = wait_key_event_and_return_code(pdMS_TO_TICKS(1000));
-        xSemaphoreTake(rtc_mutex, portMAX_DELAY);
         rtc_time = PCF85063_GetTime();
-        xSemaphoreGive(rtc_mutex);
         if((rtc_time.hours != last_hours) && (rtc_time.hours == 4 || rtc_time.hours == 9 || rtc_time.hours == 14 || rtc_time.hours == 20))
         {
             last_hours = rtc_time.hours;
@@ -824,6 +881,7 @@ void weather_city_select_mode()
     Wake_up_time_setting_weather(rtc_time);
 
     if(!check_alarm(rtc_time.hours, rtc_time.minutes)){
+        energy_prof_begin(EP_OP_WEATHER_WAKE, true);
         if(page_network_init_mode())
         {   
             char adcode[16] = {0};
@@ -864,6 +922,8 @@ void weather_city_select_mode()
         EPD_Sleep();
         page_audio_play_memory();
     }
+    energy_prof_end(EP_OP_WEATHER_WAKE);
+    energy_prof_flush();
     vTaskDelay(pdMS_TO_TICKS(50));
     axp_pwr_off();
 }
@@ -873,7 +933,7 @@ void weather_city_select_mode()
 // Automatically determine the address of the current network
 void amap_ip_location_fetch(void)
 {
-    char *json_buf = (char *)heap_caps_malloc(AMAP_JSON_MAX_SIZE, MALLOC_CAP_SPIRAM);
+    char *json_buf = (char *)mem_alloc(AMAP_JSON_MAX_SIZE);
     if (!json_buf) {
         ESP_LOGE("amap", "PSRAM allocation failed");
         return;
@@ -883,12 +943,12 @@ void amap_ip_location_fetch(void)
     esp_http_client_config_t config = {0};
     config.url = AMAP_IP_URL;
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_open(client, 0);
+    esp_http_client_handle_t client;
+    esp_err_t err = weather_http_open(&config, &client);
     if (err != ESP_OK) {
         ESP_LOGE("amap", "Failed to open HTTP: %s", esp_err_to_name(err));
         esp_http_client_cleanup(client);
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return;
     }
 
@@ -903,14 +963,14 @@ void amap_ip_location_fetch(void)
         ESP_LOGE("amap", "Abnormal content length, read_len=%d", read_len);
         esp_http_client_close(client);
         esp_http_client_cleanup(client);
-        heap_caps_free(json_buf);
+        mem_free(json_buf);
         return;
     }
 
     esp_http_client_close(client);
     esp_http_client_cleanup(client);
     cJSON *root = cJSON_Parse(json_buf);
-    heap_caps_free(json_buf);
+    mem_free(json_buf);
     if (!root) {
         ESP_LOGE("amap", "JSON parsing failed");
         return;